@@ -73,6 +73,18 @@ void freertos_wrapper_task_notify_give(TaskHandle_t handle)
     check_pass(retval);
 }
 
+void freertos_wrapper_task_notify_give_from_isr(TaskHandle_t handle)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+uint32_t freertos_wrapper_task_get_stack_free_min(TaskHandle_t handle)
+{
+    return (uint32_t)uxTaskGetStackHighWaterMark(handle);
+}
+
 BaseType_t freertos_wrapper_task_notify_wait_ms(uint32_t   entry,
                                                 uint32_t   exit,
                                                 uint32_t * nv,
@@ -107,6 +119,44 @@ BaseType_t freertos_wrapper_task_notify_wait_ticks(uint32_t   entry,
     return retval;
 }
 
+/*===== Mutexes ==============================================================*/
+
+SemaphoreHandle_t freertos_wrapper_mutex_create_static(StaticSemaphore_t *buffer)
+{
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(buffer);
+
+    if (mutex == NULL)
+    {
+        freertos_wrapper_error_handler();
+    }
+
+    return mutex;
+}
+
+void freertos_wrapper_mutex_take(SemaphoreHandle_t mutex)
+{
+    BaseType_t retval = xSemaphoreTake(mutex, portMAX_DELAY);
+    check_pass(retval);
+}
+
+void freertos_wrapper_mutex_give(SemaphoreHandle_t mutex)
+{
+    BaseType_t retval = xSemaphoreGive(mutex);
+    check_pass(retval);
+}
+
+/*===== Memory ===============================================================*/
+
+size_t freertos_wrapper_get_heap_free(void)
+{
+    return xPortGetFreeHeapSize();
+}
+
+size_t freertos_wrapper_get_heap_free_min(void)
+{
+    return xPortGetMinimumEverFreeHeapSize();
+}
+
 /*============================================================================*/
 /*===== Weak Public Functions ================================================*/
 /*============================================================================*/
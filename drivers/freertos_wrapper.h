@@ -110,6 +110,23 @@ BaseType_t freertos_wrapper_task_notify(TaskHandle_t  handle,
  */
 void freertos_wrapper_task_notify_give(TaskHandle_t handle);
 
+/**
+ * @brief  Task notify (*without* a notification value/action) from an
+ *         interrupt service routine; a context switch is requested on exit
+ *         if the notified task has a higher priority than the interrupted.
+ * @param  handle: Task handle.
+ * @retval None.
+ */
+void freertos_wrapper_task_notify_give_from_isr(TaskHandle_t handle);
+
+/**
+ * @brief  Get a task's minimum free stack since it started (its stack high
+ *         water mark).
+ * @param  handle: Task handle (NULL: the calling task).
+ * @retval Minimum free stack in words (@note 1 word=4 bytes).
+ */
+uint32_t freertos_wrapper_task_get_stack_free_min(TaskHandle_t handle);
+
 /**
  * @brief  Task notify wait (in milliseconds).
  * @param  entry: Bits to clear on entry.
@@ -136,6 +153,45 @@ BaseType_t freertos_wrapper_task_notify_wait_ticks(uint32_t   entry,
                                                    uint32_t * nv,
                                                    TickType_t ticks);
 
+/*===== Mutexes ==============================================================*/
+
+/**
+ * @brief  Mutex create (statically allocated, i.e. not from the heap).
+ * @param  buffer: Pointer to the mutex's storage.
+ * @retval Mutex handle.
+ */
+SemaphoreHandle_t freertos_wrapper_mutex_create_static(StaticSemaphore_t *buffer);
+
+/**
+ * @brief  Mutex take, blocking until it is available (the holder inherits
+ *         the taker's priority meanwhile).
+ * @param  mutex: Mutex handle.
+ * @retval None.
+ */
+void freertos_wrapper_mutex_take(SemaphoreHandle_t mutex);
+
+/**
+ * @brief  Mutex give.
+ * @param  mutex: Mutex handle.
+ * @retval None.
+ */
+void freertos_wrapper_mutex_give(SemaphoreHandle_t mutex);
+
+/*===== Memory ===============================================================*/
+
+/**
+ * @brief  Get the heap's free size.
+ * @retval Free heap in bytes.
+ */
+size_t freertos_wrapper_get_heap_free(void);
+
+/**
+ * @brief  Get the heap's minimum free size since the scheduler started
+ *         (including the allocations before it).
+ * @retval Minimum free heap in bytes.
+ */
+size_t freertos_wrapper_get_heap_free_min(void);
+
 /*============================================================================*/
 /*===== Weak Public Functions ================================================*/
 /*============================================================================*/
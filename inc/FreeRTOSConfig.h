@@ -59,12 +59,18 @@
 #define configSUPPORT_DYNAMIC_ALLOCATION         1
 #define configUSE_IDLE_HOOK                      0
 #define configUSE_TICK_HOOK                      0
+#define configUSE_MALLOC_FAILED_HOOK             1
 #define configCPU_CLOCK_HZ                       ( SystemCoreClock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 7 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)32000)
-#define configMAX_TASK_NAME_LEN                  ( 255 )
+/* Heap (heap_4): only the tasks' stacks and TCBs are allocated, at start-up
+   (2176 stack words, i.e. 8.5 KB, see rtos.c, and about 0.9 KB of TCBs and
+   block headers); its minimum ever free size and the tasks' stack high water
+   marks are transmitted to the virtual COM port. */
+#define configTOTAL_HEAP_SIZE                    ((size_t)10240)
+/* Longest task name ("task_nucleo_com_port_if") and its terminator. */
+#define configMAX_TASK_NAME_LEN                  ( 24 )
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
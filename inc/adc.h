@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * @file   adc.h
+ * @brief  ADC header file.
+ *
+ *         Provides:
+ *             - ADC1 scan acquisition of a set of channels into a circular
+ *               DMA buffer; no CPU involvement per conversion. Scans are
+ *               either continuous or started by an external trigger (one
+ *               scan per trigger), for example, at a fixed offset within the
+ *               PWM frame (see timer_pwm_trigger_init).
+ *             - Hardware oversampling (ADC_OVERSAMPLING_RATIO, right shift
+ *               ADC_OVERSAMPLING_SHIFT) trading conversion rate for
+ *               resolution (ADC_RESULT_BITS).
+ *             - Half/full transfer double-buffering: whilst the DMA fills one
+ *               half of the buffer the other half (a block of
+ *               ADC_SCANS_PER_BLOCK scans) is handed to the user via
+ *               adc_block_ready_callback.
+ *
+ ******************************************************************************/
+
+#ifndef ADC_H
+#define ADC_H
+
+#include "main.h"
+
+/*===== Defines ==============================================================*/
+
+#define ADC_MAX_CHANNELS            8   /* Channels per scan (sequencer ranks). */
+#define ADC_SCANS_PER_BLOCK         1   /* Scans per half of the DMA buffer (i.e. a block per trigger). */
+
+/**
+ * Oversampling: 16 conversions summed (16-bit) and shifted right by 2 give a
+ * 14-bit result. Each oversampled conversion takes 16 * (92.5 + 12.5) ADC
+ * clock cycles at 20 MHz (HCLK / 4) = 84 us.
+ */
+#define ADC_OVERSAMPLING_RATIO      ADC_OVERSAMPLING_RATIO_16
+#define ADC_OVERSAMPLING_SHIFT      ADC_RIGHTBITSHIFT_2
+#define ADC_RESULT_BITS             14
+#define ADC_RESULT_MAX              ((1U << ADC_RESULT_BITS) - 1)
+#define ADC_SAMPLING_TIME           ADC_SAMPLETIME_92CYCLES_5
+
+#define ADC_DMA_IRQ_PRIORITY        (6) /* Below the control loop (see TIMER_TIM6_CTRL_IRQ_PRIORITY). */
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  ADC1 initialisation (including calibration) for a scan of the
+ *         specified channels.
+ * @note   The channels' GPIOs (analog mode) are configured by the caller.
+ * @param  channels:     ADC channels in scan order; ADC_CHANNEL_x.
+ * @param  num_channels: Number of channels (1..ADC_MAX_CHANNELS).
+ * @param  trigger:      ADC_SOFTWARE_START for continuous scans, or an
+ *                       external trigger (ADC_EXTERNALTRIG_x, rising edge)
+ *                       that starts each scan.
+ * @retval None.
+ */
+void adc_init(const uint32_t *channels, uint32_t num_channels, uint32_t trigger);
+
+/**
+ * @brief  Start/stop the acquisition (ADC conversions and circular DMA).
+ * @param  state: true|false = start|stop.
+ * @retval None.
+ */
+void adc_enable(bool state);
+
+/**
+ * @brief  ADC conversion complete call-back function (DMA full transfer).
+ * @param  hadc: ADC handle.
+ * @retval None.
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+/**
+ * @brief  ADC conversion half complete call-back function (DMA half
+ *         transfer).
+ * @param  hadc: ADC handle.
+ * @retval None.
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Block of samples ready call-back; invoked from the DMA interrupt
+ *         for each half of the DMA buffer. The block is not overwritten until
+ *         the DMA has filled the other half, i.e. for ADC_SCANS_PER_BLOCK
+ *         scans.
+ * @note   IMPORTANT: The user can over-write this function with their own
+ *         implementation.
+ * @param  samples:   Samples (ADC_RESULT_BITS), interleaved by scan, i.e.
+ *                    samples[(scan * num_channels) + channel].
+ * @param  num_scans: Number of scans in the block.
+ * @retval None.
+ */
+__weak void adc_block_ready_callback(const uint16_t *samples, uint32_t num_scans);
+
+/*============================================================================*/
+
+#endif /* ADC_H ==============================================================*/
\ No newline at end of file
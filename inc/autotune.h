@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * @file   autotune.h
+ * @brief  Relay feedback PID auto-tuning header file.
+ *
+ *         Provides:
+ *             - An Astrom-Hagglund relay experiment: the controller output is
+ *               replaced by a relay (+/- amplitude, with hysteresis) about a
+ *               centre position, which drives the closed loop into a limit
+ *               cycle at the plant's phase crossover (-180 degrees)
+ *               frequency.
+ *             - Measurement of the oscillation's period (Tu) and amplitude
+ *               from the feedback signal over a number of cycles, after a
+ *               number of settling cycles, and of the ultimate gain from the
+ *               describing function of a relay with hysteresis:
+ *                   Ku = 4 d / (pi x sqrt(a^2 - e^2)).
+ *             - PID gains from Ku/Tu by a selectable tuning rule (see
+ *               @ref AUTOTUNE_RULE_t), in the continuous-time form of
+ *               @ref pid.h.
+ *             - A bounded run time: the experiment fails if the measured
+ *               periods are not consistent within AUTOTUNE_PERIOD_TOLERANCE
+ *               by the maximum number of cycles, or the relay does not
+ *               switch within the timeout.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define AUTOTUNE_PERIOD_TOLERANCE   0.2f    /* Maximum (max - min) / mean of the measured periods. */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum AUTOTUNE_RULE_t {
+    AUTOTUNE_RULE__ZN_PI,       /* Ziegler-Nichols PI. */
+    AUTOTUNE_RULE__ZN_PID,      /* Ziegler-Nichols PID (quarter amplitude decay). */
+    AUTOTUNE_RULE__TL_PID,      /* Tyreus-Luyben PID (more robust, less overshoot). */
+} AUTOTUNE_RULE_t;
+
+typedef enum AUTOTUNE_STATE_t {
+    AUTOTUNE_STATE__IDLE,
+    AUTOTUNE_STATE__RUNNING,
+    AUTOTUNE_STATE__DONE,       /* Result valid. */
+    AUTOTUNE_STATE__FAILED,
+} AUTOTUNE_STATE_t;
+
+typedef struct AUTOTUNE_CONFIG_t {
+    float32_t period_s;         /* Update (call) period (s). */
+    float32_t amplitude;        /* Relay output amplitude (d). */
+    float32_t hysteresis;       /* Relay hysteresis (e), above the feedback noise. */
+    uint32_t settle_cycles;     /* Cycles discarded before measuring. */
+    uint32_t measure_cycles;    /* Cycles averaged (>= 1). */
+    uint32_t max_cycles;        /* Cycles after which the experiment fails. */
+    float32_t timeout_s;        /* Maximum time between relay switches (s). */
+    AUTOTUNE_RULE_t rule;
+} AUTOTUNE_CONFIG_t;
+
+typedef struct AUTOTUNE_RESULT_t {
+    float32_t ku;               /* Ultimate gain. */
+    float32_t tu_s;             /* Ultimate period (s). */
+    float32_t amplitude;        /* Mean oscillation amplitude (a). */
+    float32_t kp;               /* Proportional gain. */
+    float32_t ki;               /* Integral gain (1/s). */
+    float32_t kd;               /* Derivative gain (s). */
+} AUTOTUNE_RESULT_t;
+
+typedef struct AUTOTUNE_t {
+    AUTOTUNE_CONFIG_t config;
+    volatile AUTOTUNE_STATE_t state;
+    float32_t centre;           /* Relay switching centre (feedback). */
+    bool relay_high;
+    uint32_t tick;              /* Updates since the start. */
+    uint32_t switch_tick;       /* Tick of the last relay switch. */
+    uint32_t cycle_tick;        /* Tick of the last cycle start (switch high); valid once cycles > 0. */
+    uint32_t cycles;            /* Cycle starts since the start. */
+    float32_t peak_max;         /* Feedback extremes in the current cycle. */
+    float32_t peak_min;
+    uint32_t measured;          /* Cycles measured (accumulated). */
+    uint32_t period_sum;        /* Ticks. */
+    uint32_t period_min;
+    uint32_t period_max;
+    float32_t amplitude_sum;
+    AUTOTUNE_RESULT_t result;
+} AUTOTUNE_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Start a relay experiment.
+ * @param  tune:   Auto-tuner.
+ * @param  config: Configuration (copied into @param tune).
+ * @param  centre: Relay switching centre, i.e. the (held) setpoint.
+ * @retval None.
+ */
+void autotune_start(AUTOTUNE_t *tune, const AUTOTUNE_CONFIG_t *config, float32_t centre);
+
+/**
+ * @brief  Run one experiment update with a feedback value; call once per
+ *         update period whilst running.
+ * @param  tune:     Auto-tuner.
+ * @param  feedback: Feedback (plant output).
+ * @retval Relay output (+/- amplitude) to apply in place of the controller
+ *         output; zero once the experiment has finished.
+ */
+float32_t autotune_update(AUTOTUNE_t *tune, float32_t feedback);
+
+/**
+ * @brief  Abort a running experiment (failed).
+ * @param  tune: Auto-tuner.
+ * @retval None.
+ */
+void autotune_abort(AUTOTUNE_t *tune);
+
+/**
+ * @brief  Retrieve the experiment state.
+ * @param  tune: Auto-tuner.
+ * @retval State; see @ref AUTOTUNE_STATE_t.
+ */
+AUTOTUNE_STATE_t autotune_get_state(const AUTOTUNE_t *tune);
+
+/**
+ * @brief  Retrieve the experiment result.
+ * @param  tune:   Auto-tuner.
+ * @param  result: Result. Passed by reference.
+ * @retval Boolean indicating whether @param result is valid (state done).
+ */
+bool autotune_get_result(const AUTOTUNE_t *tune, AUTOTUNE_RESULT_t *result);
+
+/*============================================================================*/
+
+#endif /* AUTOTUNE_H =========================================================*/
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * @file   com_cmd.h
+ * @brief  Nucleo COM port commands and telemetry header file.
+ *
+ *         Provides:
+ *             - Execution of the command lines received via the Nucleo COM
+ *               port interface: parsing and range checking, and the servo
+ *               control API calls.
+ *             - Construction and transmission of the periodic status,
+ *               statistics and system identification messages.
+ *
+ ******************************************************************************/
+
+#ifndef COM_CMD_H
+#define COM_CMD_H
+
+#include "main.h"
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise the Nucleo COM port commands and telemetry: the lock
+ *         serialising the tasks' transmissions. Called before the scheduler
+ *         starts.
+ * @retval None.
+ */
+void com_cmd_init(void);
+
+/**
+ * @brief  Execute a command line received via the Nucleo COM port interface:
+ *             - "S <timestamp_us> <angle_mdeg_1> ... <angle_mdeg_N>":
+ *               setpoint stream waypoint; the time in the host's time base
+ *               (us) and the angles of all N = SERVO_NUM_SERVOS servos in
+ *               milli-degrees (see servo_ctrl_stream_push); with a
+ *               Cartesian stream enabled the first angles are the arm's
+ *               target in micro-units (x, y) and milli-degrees (phi) or
+ *               micro-units (z).
+ *             - "M <T|S> <angle_mdeg_1> ... <angle_mdeg_N>": coordinated
+ *               trapezoidal (T) or S-curve (S) move of all N =
+ *               SERVO_NUM_SERVOS servos to the angles in milli-degrees, at
+ *               the default move limits (see servo_ctrl_move_coordinated).
+ *             - "A <servo>": auto-tune a servo's PID controller; the servo
+ *               number 1..SERVO_NUM_SERVOS (see servo_ctrl_autotune_start).
+ *             - "I <servo> <C|P>": identify a servo's frequency response with
+ *               a chirp (C) or PRBS (P) excitation; the servo number
+ *               1..SERVO_NUM_SERVOS (see servo_ctrl_sysid_start).
+ *             - "G <B|X|P|C|E> ...": gain schedule table loading (see
+ *               rx_gain_sched in com_cmd.c).
+ *             - "L <P|C|M>": select the PID, cascaded or MPC controller
+ *               structure (see servo_ctrl_set_loop_type).
+ *             - "Z <servo> <N|V|D|E> [<freq_mhz> <zeta_x1000>]": select a
+ *               servo's input shaper, none, ZV, ZVD or EI (see
+ *               servo_ctrl_set_shaper).
+ *             - "R <servo> <moves>": start iterative learning control of a
+ *               servo's repeated motion cycle of the given number of moves,
+ *               or stop it (0 moves; see servo_ctrl_ilc_start).
+ *             - "F <servo> <E|D|I|P> [<coulomb_mdeg> <breakaway_mdeg>
+ *               <viscous_us>]": enable (E) or disable (D) a servo's friction
+ *               compensation, identify its friction (I; see
+ *               servo_ctrl_friction_id_start) or load its parameters (P;
+ *               viscous in us = milli-degrees per degree/s).
+ *             - "N <servo> <E|D|F|U|C>": enable (E) or disable (D) a servo's
+ *               adaptive feedforward, freeze (F) or unfreeze (U) its
+ *               adaptation, or clear its coefficients (C; see
+ *               servo_ctrl_lms_clear).
+ *             - "K <P|O|S> <len_um_1> <len_um_2> <len_um_3> <U|D>": enable a
+ *               Cartesian setpoint stream (inverse kinematics) of a planar
+ *               2-link (P), planar 3-link with orientation (O) or spatial
+ *               yaw and 2-link (S) arm, the link lengths in micro-units
+ *               (e.g. um for mm), elbow up (U) or down (D); "K D" disables
+ *               it (see servo_ctrl_ik_enable).
+ *         Each command is answered with a line "OK <c>" if accepted or
+ *         "ERR <c>" if rejected (c the command's letter): unknown,
+ *         malformed or out of range, or refused by the servo control API
+ *         (e.g. a waypoint on a full stream).
+ * @param  handle: HAL USART handle pointer.
+ * @param  line:   Command line ('\0' terminated, without the line
+ *                 terminator).
+ * @retval None.
+ */
+void com_cmd_execute(UART_HandleTypeDef *handle, char *line);
+
+/**
+ * @brief  Construct and transmit the status messages via the Nucleo COM port
+ *         interface:
+ *             - Message: operational mode.
+ *             - Message: servo motor shaft positions (angle in degrees).
+ *             - Message: estimated velocities and accelerations.
+ *             - Messages: control loop statistics (see tx_servo_ctrl_stats).
+ *             - Messages: the identified frequency response, once a system
+ *               identification's capture is complete (computed here).
+ * @param  handle: HAL USART handle pointer.
+ * @retval None.
+ */
+void com_cmd_tx_status(UART_HandleTypeDef *handle);
+
+/**
+ * @brief  Construct and transmit the RTOS memory messages via the Nucleo COM
+ *         port interface:
+ *             - Message: each task's minimum free stack (words), in the order
+ *               given.
+ *             - Message: free heap and its minimum since start-up (bytes).
+ * @param  handle:    HAL USART handle pointer.
+ * @param  tasks:     Task handles.
+ * @param  num_tasks: Number of task handles.
+ * @retval None.
+ */
+void com_cmd_tx_rtos_stats(UART_HandleTypeDef *handle, const TaskHandle_t *tasks, uint32_t num_tasks);
+
+/*============================================================================*/
+
+#endif /* COM_CMD_H ==========================================================*/
\ No newline at end of file
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * @file   coord.h
+ * @brief  Coordinated multi-axis motion header file.
+ *
+ *         Provides:
+ *             - Synchronised planning of an N-axis move, one move per axis'
+ *               motion profile generator (see @ref profile.h) to the axis'
+ *               target: the axes' moves are built to one timing (see
+ *               profile_plan_timed), i.e. their segments start and end at
+ *               the same ticks, such that all axes start and finish
+ *               together and the path is a straight line in axis space. The
+ *               timing is that of the normalised path (0..1) within the
+ *               tightest of the moving axes' limits over their distances,
+ *               i.e. the slowest axis sets the duration and the others are
+ *               slowed to it (no axis exceeds its limits). An axis not
+ *               moving holds for the duration.
+ *             - Lock-step queueing: the moves are queued by one commit of
+ *               all axes (see coord_commit), such that generators stepped in
+ *               one pass, e.g. the control loop writing all channels for the
+ *               same PWM frame, run them in lock-step. The caller keeps the
+ *               generators in lock-step (moves queued by coord_commit only,
+ *               or idle).
+ *
+ *         The planning is one move timing (floating-point) and the segment
+ *         coefficients per axis; the evaluation is the generators' own (see
+ *         profile_next), i.e. both are linear in the number of axes.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC.
+ *
+ ******************************************************************************/
+
+#ifndef COORD_H
+#define COORD_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+/*===== Motion Profiles =====*/
+#include "profile.h"
+
+/*===== Defines ==============================================================*/
+
+#define COORD_MAX_AXES              8
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Plan a coordinated move of all axes to absolute targets (from the
+ *         ends of their last queued moves) into the generators' next free
+ *         queue slots; the moves are not run until committed (see
+ *         coord_commit).
+ * @param  gens:     Generators, one per axis (same tick rate).
+ * @param  num_axes: Number of axes (1..COORD_MAX_AXES).
+ * @param  type:     Profile type; see @ref PROFILE_TYPE_t.
+ * @param  targets:  Target position per axis (Q16.16).
+ * @param  limits:   Velocity/acceleration/jerk limits per axis (> 0).
+ * @param  blend:    Whether to start whilst the previous moves decelerate.
+ * @param  ticks:    Duration (ticks; 0 if no axis moves). Passed by
+ *                   reference.
+ * @retval Boolean indicating whether the moves were planned: false if the
+ *         number of axes or a limit is invalid, a queue is full, or the
+ *         queues are not in lock-step (different numbers of moves).
+ */
+bool coord_plan(PROFILE_GEN_t *gens, uint32_t num_axes, PROFILE_TYPE_t type, const int32_t *targets,
+                const PROFILE_LIMITS_t *limits, bool blend, uint32_t *ticks);
+
+/**
+ * @brief  Queue the moves planned by coord_plan on all axes.
+ * @note   The caller provides the mutual exclusion with the generators'
+ *         stepping, such that all axes start at the same tick.
+ * @param  gens:     Generators, one per axis.
+ * @param  num_axes: Number of axes.
+ * @retval None.
+ */
+void coord_commit(PROFILE_GEN_t *gens, uint32_t num_axes);
+
+/*============================================================================*/
+
+#endif /* COORD_H ============================================================*/
\ No newline at end of file
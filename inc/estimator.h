@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * @file   estimator.h
+ * @brief  Position/velocity/acceleration state estimator header file.
+ *
+ *         Provides:
+ *             - Estimates of position, velocity and acceleration from
+ *               position measurements, using either:
+ *                 - An alpha-beta(-gamma) filter (fixed gains; gamma = 0 is
+ *                   the alpha-beta filter with zero acceleration).
+ *                 - A 3-state (constant acceleration, white jerk) Kalman
+ *                   filter built on the CMSIS-DSP arm_mat_*_f32 routines.
+ *             - Multi-rate operation: the state is predicted every call
+ *               period (e.g. the control loop period) and corrected whenever
+ *               a new measurement is available (e.g. once per PWM frame),
+ *               such that estimates are available at the call rate.
+ *             - The state is seeded by the first measurement after an
+ *               initialisation/reset; estimates are invalid until then.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC (e.g. against a simulated
+ *         plant model).
+ *
+ ******************************************************************************/
+
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define ESTIMATOR_NUM_STATES        3 /* Position, velocity, acceleration. */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum ESTIMATOR_TYPE_t {
+    ESTIMATOR_TYPE__ALPHA_BETA,
+    ESTIMATOR_TYPE__KALMAN,
+} ESTIMATOR_TYPE_t;
+
+typedef struct ESTIMATOR_CONFIG_t {
+    ESTIMATOR_TYPE_t type;
+    float32_t period_s;         /* Prediction (call) period (s). */
+    float32_t meas_period_s;    /* Measurement period (s); alpha-beta(-gamma) gain scaling. */
+    float32_t alpha;            /* Alpha-beta(-gamma): position gain. */
+    float32_t beta;             /* Alpha-beta(-gamma): velocity gain. */
+    float32_t gamma;            /* Alpha-beta(-gamma): acceleration gain (0 = alpha-beta). */
+    float32_t process_noise;    /* Kalman: jerk power spectral density (units^2/s^5). */
+    float32_t meas_noise;       /* Kalman: measurement variance (units^2). */
+    float32_t init_var_vel;     /* Kalman: initial velocity variance ((units/s)^2). */
+    float32_t init_var_acc;     /* Kalman: initial acceleration variance ((units/s^2)^2). */
+} ESTIMATOR_CONFIG_t;
+
+typedef struct ESTIMATOR_t {
+    ESTIMATOR_CONFIG_t config;
+    bool seeded;                                                /* State seeded by a measurement. */
+    float32_t x[ESTIMATOR_NUM_STATES];                          /* State: position, velocity, acceleration. */
+    /* Kalman filter matrices (row-major) and their CMSIS-DSP instances. */
+    float32_t x_pred[ESTIMATOR_NUM_STATES];                     /* Predicted state. */
+    float32_t p[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES];   /* State covariance. */
+    float32_t f[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES];   /* State transition. */
+    float32_t f_t[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES]; /* State transition, transposed. */
+    float32_t q[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES];   /* Process noise covariance. */
+    float32_t k[ESTIMATOR_NUM_STATES];                          /* Kalman gain. */
+    float32_t tmp_a[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES];
+    float32_t tmp_b[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES];
+    arm_matrix_instance_f32 mat_x;
+    arm_matrix_instance_f32 mat_x_pred;
+    arm_matrix_instance_f32 mat_p;
+    arm_matrix_instance_f32 mat_f;
+    arm_matrix_instance_f32 mat_f_t;
+    arm_matrix_instance_f32 mat_q;
+    arm_matrix_instance_f32 mat_k;
+    arm_matrix_instance_f32 mat_p_row0;
+    arm_matrix_instance_f32 mat_tmp_a;
+    arm_matrix_instance_f32 mat_tmp_b;
+} ESTIMATOR_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an estimator and reset its state (unseeded).
+ * @param  est:    Estimator.
+ * @param  config: Estimator configuration (copied into @param est).
+ * @retval None.
+ */
+void estimator_init(ESTIMATOR_t *est, const ESTIMATOR_CONFIG_t *config);
+
+/**
+ * @brief  Reset an estimator's state; estimates are invalid until the next
+ *         measurement (see estimator_correct).
+ * @param  est: Estimator.
+ * @retval None.
+ */
+void estimator_reset(ESTIMATOR_t *est);
+
+/**
+ * @brief  Predict the state one call period ahead; call once per period.
+ * @param  est: Estimator.
+ * @retval None.
+ */
+void estimator_predict(ESTIMATOR_t *est);
+
+/**
+ * @brief  Correct the (predicted) state with a new position measurement; the
+ *         first measurement after a reset seeds the state.
+ * @param  est:      Estimator.
+ * @param  position: Measured position.
+ * @retval None.
+ */
+void estimator_correct(ESTIMATOR_t *est, float32_t position);
+
+/**
+ * @brief  Retrieve whether an estimator's state is valid (seeded).
+ * @param  est: Estimator.
+ * @retval Boolean indicating validity.
+ */
+bool estimator_is_valid(const ESTIMATOR_t *est);
+
+/**
+ * @brief  Retrieve the position estimate.
+ * @param  est: Estimator.
+ * @retval Position.
+ */
+float32_t estimator_get_position(const ESTIMATOR_t *est);
+
+/**
+ * @brief  Retrieve the velocity estimate.
+ * @param  est: Estimator.
+ * @retval Velocity (units/s).
+ */
+float32_t estimator_get_velocity(const ESTIMATOR_t *est);
+
+/**
+ * @brief  Retrieve the acceleration estimate.
+ * @param  est: Estimator.
+ * @retval Acceleration (units/s^2).
+ */
+float32_t estimator_get_acceleration(const ESTIMATOR_t *est);
+
+/*============================================================================*/
+
+#endif /* ESTIMATOR_H ========================================================*/
\ No newline at end of file
@@ -0,0 +1,197 @@
+/*******************************************************************************
+ * @file   filter.h
+ * @brief  Digital filter (signal conditioning) header file.
+ *
+ *         Provides:
+ *             - A filter object wrapping one of the CMSIS-DSP kernels:
+ *                 - Biquad cascade, direct form II transposed, floating-point
+ *                   (arm_biquad_cascade_df2T_f32).
+ *                 - Biquad cascade, direct form I, Q1.31 fixed-point
+ *                   (arm_biquad_cascade_df1_q31).
+ *                 - FIR, Q1.15 fixed-point (arm_fir_q15).
+ *               or a pass-through (no filtering).
+ *             - Block processing of raw (unsigned, up to FILTER_INPUT_BITS)
+ *               samples, e.g. one channel of an interleaved ADC DMA block.
+ *               The servo feedback is one scan per PWM frame (see
+ *               ADC_SCANS_PER_BLOCK), i.e. a block of one sample, so the
+ *               kernel's per-call overhead is paid per sample; it is only
+ *               spread by larger blocks (test_filter measures both).
+ *             - Biquad coefficient design (RBJ audio EQ cookbook): 2nd order
+ *               low-pass and notch, in the CMSIS-DSP coefficient order.
+ *             - Settling: a filter reports settled once it has processed
+ *               enough samples since its last reset for its output to be
+ *               representative (see filter_is_settled).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC with injected sample blocks.
+ *
+ ******************************************************************************/
+
+#ifndef FILTER_H
+#define FILTER_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define FILTER_BIQUAD_NUM_COEFFS    5   /* Per stage: {b0, b1, b2, -a1, -a2} (normalised by a0). */
+#define FILTER_BIQUAD_MAX_STAGES    2
+#define FILTER_FIR_MAX_TAPS         16
+#define FILTER_MAX_BLOCK_SIZE       16  /* Samples per filter_process call. */
+
+#define FILTER_INPUT_BITS           15  /* Raw sample range (0..0x7FFF): Q1.15 without overflow. */
+#define FILTER_INPUT_MAX            ((1U << FILTER_INPUT_BITS) - 1)
+
+/**
+ * Q1.31 biquad coefficient scaling: coefficients are stored divided by
+ * 2^FILTER_BIQUAD_Q31_POST_SHIFT (|b1|, |a1| of a 2nd order section reach 2)
+ * and the kernel shifts the accumulator back.
+ */
+#define FILTER_BIQUAD_Q31_POST_SHIFT 1
+
+/* Samples after a reset until a biquad stage's output has settled. */
+#define FILTER_BIQUAD_SETTLE_SAMPLES_PER_STAGE 10
+
+/*===== Typedefs =============================================================*/
+
+typedef enum FILTER_TYPE_t {
+    FILTER_TYPE__NONE = 0,      /* Pass-through. */
+    FILTER_TYPE__BIQUAD_F32,
+    FILTER_TYPE__BIQUAD_Q31,
+    FILTER_TYPE__FIR_Q15,
+    FILTER_TYPE__NUM,
+} FILTER_TYPE_t;
+
+typedef struct FILTER_t {
+    FILTER_TYPE_t type;
+    uint32_t settle_samples;    /* Samples after a reset until settled. */
+    uint32_t sample_count;      /* Samples processed since the last reset (counted until settled). */
+    union {
+        struct {
+            arm_biquad_cascade_df2T_instance_f32 instance;
+            float32_t coeffs[FILTER_BIQUAD_NUM_COEFFS * FILTER_BIQUAD_MAX_STAGES];
+            float32_t state[2 * FILTER_BIQUAD_MAX_STAGES];
+        } biquad_f32;
+        struct {
+            arm_biquad_casd_df1_inst_q31 instance;
+            q31_t coeffs[FILTER_BIQUAD_NUM_COEFFS * FILTER_BIQUAD_MAX_STAGES];
+            q31_t state[4 * FILTER_BIQUAD_MAX_STAGES];
+        } biquad_q31;
+        struct {
+            arm_fir_instance_q15 instance;
+            q15_t coeffs[FILTER_FIR_MAX_TAPS];
+            q15_t state[FILTER_FIR_MAX_TAPS + FILTER_MAX_BLOCK_SIZE];
+        } fir_q15;
+    } kernel;
+} FILTER_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a pass-through filter (output = input).
+ * @param  filter: Filter.
+ * @retval None.
+ */
+void filter_init_none(FILTER_t *filter);
+
+/**
+ * @brief  Initialise a floating-point biquad cascade filter.
+ * @param  filter:     Filter.
+ * @param  coeffs:     Coefficients, FILTER_BIQUAD_NUM_COEFFS per stage (see
+ *                     filter_design_lowpass/filter_design_notch); copied into
+ *                     @param filter.
+ * @param  num_stages: Number of 2nd order stages (1..FILTER_BIQUAD_MAX_STAGES).
+ * @retval Boolean indicating whether @param num_stages was valid and @param
+ *         filter was initialised.
+ */
+bool filter_init_biquad_f32(FILTER_t *filter, const float32_t *coeffs, uint32_t num_stages);
+
+/**
+ * @brief  Initialise a fixed-point (Q1.31) biquad cascade filter.
+ * @param  filter:     Filter.
+ * @param  coeffs:     Floating-point coefficients as for
+ *                     filter_init_biquad_f32; converted to Q1.31 (scaled by
+ *                     FILTER_BIQUAD_Q31_POST_SHIFT) into @param filter.
+ * @param  num_stages: Number of 2nd order stages (1..FILTER_BIQUAD_MAX_STAGES).
+ * @retval Boolean indicating whether @param num_stages and @param coeffs were
+ *         valid and @param filter was initialised.
+ */
+bool filter_init_biquad_q31(FILTER_t *filter, const float32_t *coeffs, uint32_t num_stages);
+
+/**
+ * @brief  Initialise a fixed-point (Q1.15) FIR filter.
+ * @param  filter:   Filter.
+ * @param  coeffs:   Coefficients in time order, h[0]..h[num_taps - 1]; the
+ *                   sum sets the DC gain (0x8000 = unity). Copied into @param
+ *                   filter.
+ * @param  num_taps: Number of taps (even, 4..FILTER_FIR_MAX_TAPS).
+ * @retval Boolean indicating whether @param num_taps was valid and @param
+ *         filter was initialised.
+ */
+bool filter_init_fir_q15(FILTER_t *filter, const q15_t *coeffs, uint32_t num_taps);
+
+/**
+ * @brief  Reset a filter's state (history) and settling; the coefficients are
+ *         retained.
+ * @param  filter: Filter.
+ * @retval None.
+ */
+void filter_reset(FILTER_t *filter);
+
+/**
+ * @brief  Filter a block of raw samples.
+ * @note   The input and output may be the same buffer.
+ * @param  filter:     Filter.
+ * @param  in:         Raw samples (0..FILTER_INPUT_MAX; larger values are
+ *                     clamped), every @param stride elements, e.g. one
+ *                     channel of an interleaved ADC block.
+ * @param  out:        Filtered samples, same layout as @param in.
+ * @param  stride:     Distance between consecutive samples (>= 1).
+ * @param  block_size: Number of samples (1..FILTER_MAX_BLOCK_SIZE).
+ * @retval None.
+ */
+void filter_process(FILTER_t *filter, const uint16_t *in, uint16_t *out, uint32_t stride, uint32_t block_size);
+
+/**
+ * @brief  Retrieve whether a filter's output has settled since its last
+ *         reset (initialisation).
+ * @param  filter: Filter.
+ * @retval Boolean indicating whether the output has settled.
+ */
+bool filter_is_settled(const FILTER_t *filter);
+
+/**
+ * @brief  Design a 2nd order (one biquad stage) low-pass filter; unity DC
+ *         gain.
+ * @param  coeffs:      Coefficients (FILTER_BIQUAD_NUM_COEFFS). Passed by
+ *                      reference.
+ * @param  sample_rate: Sample rate (Hz).
+ * @param  cutoff:      -3 dB cut-off frequency (Hz); less than half the
+ *                      sample rate.
+ * @param  q:           Quality factor (0.7071 = Butterworth).
+ * @retval None.
+ */
+void filter_design_lowpass(float32_t *coeffs, float32_t sample_rate, float32_t cutoff, float32_t q);
+
+/**
+ * @brief  Design a 2nd order (one biquad stage) notch filter; unity gain
+ *         away from the notch.
+ * @param  coeffs:      Coefficients (FILTER_BIQUAD_NUM_COEFFS). Passed by
+ *                      reference.
+ * @param  sample_rate: Sample rate (Hz).
+ * @param  centre:      Notch centre frequency (Hz); less than half the
+ *                      sample rate.
+ * @param  q:           Quality factor (centre / -3 dB bandwidth).
+ * @retval None.
+ */
+void filter_design_notch(float32_t *coeffs, float32_t sample_rate, float32_t centre, float32_t q);
+
+/*============================================================================*/
+
+#endif /* FILTER_H ===========================================================*/
\ No newline at end of file
@@ -0,0 +1,236 @@
+/*******************************************************************************
+ * @file   friction.h
+ * @brief  Disturbance observer and friction/deadband compensation header file.
+ *
+ *         Provides:
+ *             - A disturbance observer (DOB) on the nominal servo model
+ *               (command to position, 2nd order with natural frequency wn
+ *               and damping zeta, discretised at the feedback period):
+ *               position, velocity and an input disturbance, predicted with
+ *               the applied command and corrected with each feedback sample
+ *               (fixed gains). The disturbance is what the command is short
+ *               of the model's, e.g. a load or the friction the model based
+ *               compensation does not cancel, and is compensated.
+ *             - Model based friction compensation, i.e. an offset to the
+ *               command: the Coulomb friction and the servo's deadband (an
+ *               offset in the direction of motion either way; they are not
+ *               distinguishable from the command) whilst moving, the
+ *               breakaway offset from standstill (the static friction), and
+ *               viscous friction beyond the model's damping. The direction
+ *               is that of the reference velocity and the tracking error,
+ *               and the offset is reached on a ramp (against chatter, and
+ *               the slip of a breakaway overshooting).
+ *             - A hold band: at standstill with the error within it, the
+ *               error is below what the servo resolves against its static
+ *               friction, and integrating it (the observer's disturbance
+ *               and the caller's integrator) winds up a breakaway that
+ *               overshoots, i.e. the hold position limit cycle (hunting).
+ *               The disturbance is then held and the holding reported.
+ *             - Identification of the friction parameters from a sweep in
+ *               open-loop: a triangle about the start position at
+ *               FRICTION_ID_SPEEDS speeds, stepped with each feedback
+ *               sample. The steady lag of the position behind the command
+ *               is fitted (least squares, accumulated; no log buffer) as
+ *               coulomb x sign(velocity) + slope x velocity, the viscous
+ *               friction being the slope beyond the model's 2 zeta / wn,
+ *               and the breakaway is the command's travel from the
+ *               standstill after each reversal (at the slowest speed) to
+ *               the servo moving off.
+ *
+ *         A compensation update costs a fixed, small number of
+ *         multiply-adds (no loops); an observer step a few more, once per
+ *         feedback sample.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef FRICTION_H
+#define FRICTION_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define FRICTION_ID_SPEEDS          4       /* Sweep speeds (geometric, speed_min..speed_max). */
+#define FRICTION_ID_MIN_SAMPLES     10      /* Steady samples per direction and speed to solve. */
+
+/*===== Typedefs =============================================================*/
+
+typedef struct FRICTION_PARAMS_t {
+    float32_t coulomb;          /* Offset sustaining motion (degrees): Coulomb friction and deadband. */
+    float32_t breakaway;        /* Offset from standstill (degrees; >= coulomb). */
+    float32_t viscous;          /* Viscous friction beyond the model (degrees per degree/s). */
+} FRICTION_PARAMS_t;
+
+typedef struct FRICTION_CONFIG_t {
+    float32_t period_s;         /* Observer step (feedback sample) period (s). */
+    float32_t wn;               /* Model natural frequency (rad/s). */
+    float32_t zeta;             /* Model damping ratio. */
+    float32_t l_pos;            /* Observer gains: position, velocity and disturbance */
+    float32_t l_vel;            /* corrections per unit position innovation. */
+    float32_t l_dist;
+    float32_t dist_max;         /* Disturbance estimate limit (+/-; degrees). */
+    float32_t slope;            /* Ramp of the offset with the direction (degrees per degree of error). */
+    float32_t lead_s;           /* Reference velocity's weight in the direction (s). */
+    float32_t still_speed;      /* Standstill below this speed (degrees/s). */
+    float32_t hold_band;        /* Hold band (+/-; degrees of error). */
+} FRICTION_CONFIG_t;
+
+typedef struct FRICTION_t {
+    FRICTION_CONFIG_t config;
+    FRICTION_PARAMS_t params;
+    float32_t a[4];             /* Model (discrete; row-major). */
+    float32_t b[2];
+    float32_t x[2];             /* Observed position and velocity. */
+    float32_t disturbance;      /* Observed input disturbance (degrees). */
+    bool valid;                 /* Observer initialised since the last reset. */
+    bool holding;               /* Within the hold band at standstill (last update). */
+} FRICTION_t;
+
+typedef enum FRICTION_ID_STATE_t {
+    FRICTION_ID_STATE__IDLE,
+    FRICTION_ID_STATE__RUNNING,
+    FRICTION_ID_STATE__DONE,    /* Parameters identified. */
+    FRICTION_ID_STATE__FAILED,  /* Too few steady samples, or an implausible fit. */
+} FRICTION_ID_STATE_t;
+
+typedef struct FRICTION_ID_CONFIG_t {
+    float32_t period_s;         /* Update (feedback sample) period (s). */
+    float32_t amplitude;        /* Triangle amplitude about the start position (degrees). */
+    float32_t speed_min;        /* Slowest and fastest sweep speeds (degrees/s). */
+    float32_t speed_max;
+    float32_t settle_s;         /* Samples after each reversal not fitted (s). */
+    float32_t still_speed;      /* Standstill below this speed (degrees/s). */
+    float32_t breakaway_travel; /* Moved off the standstill beyond this travel (degrees; above the noise). */
+    float32_t model_slope;      /* Model's lag per unit speed, 2 zeta / wn (s). */
+} FRICTION_ID_CONFIG_t;
+
+typedef struct FRICTION_ID_t {
+    FRICTION_ID_CONFIG_t config;
+    volatile FRICTION_ID_STATE_t state;
+    uint32_t speed;             /* Sweep speed index. */
+    uint32_t leg;               /* Leg of the speed's cycle: up, down, back to the start. */
+    float32_t excitation;       /* Command relative to the start position (degrees). */
+    float32_t since_reversal;   /* Time since the last reversal or speed change (s). */
+    uint32_t reversal;          /* Slowest speed's reversal: 0 none, 1 awaiting standstill, 2 awaiting breakaway, */
+                                /* 3 awaiting its confirmation. */
+    float32_t stuck_position;   /* Position at the standstill (degrees). */
+    float32_t moved_command;    /* Command when the position moved off the standstill (degrees). */
+    uint32_t n;                 /* Fit sums (s = sign(velocity)): samples, samples with s > 0, */
+    uint32_t n_pos;             /* sum(s v), sum(v^2), sum(s lag), sum(v lag). */
+    float32_t sum_sv;
+    float32_t sum_vv;
+    float32_t sum_s_lag;
+    float32_t sum_v_lag;
+    float32_t breakaway_sum;
+    uint32_t breakaways;
+    FRICTION_PARAMS_t result;
+} FRICTION_ID_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise friction compensation (no friction; observer reset):
+ *         discretise the model.
+ * @param  friction: Friction compensation.
+ * @param  config:   Configuration (copied into @param friction).
+ * @retval Boolean indicating whether the configuration is valid.
+ */
+bool friction_init(FRICTION_t *friction, const FRICTION_CONFIG_t *config);
+
+/**
+ * @brief  Load friction parameters, e.g. identified (see friction_id_get_state).
+ * @param  friction: Friction compensation.
+ * @param  params:   Parameters (copied into @param friction).
+ * @retval Boolean indicating whether the parameters are valid (non-negative,
+ *         breakaway not below the Coulomb offset).
+ */
+bool friction_set_params(FRICTION_t *friction, const FRICTION_PARAMS_t *params);
+
+/**
+ * @brief  Reset the observer; it restarts at the next observer step.
+ * @param  friction: Friction compensation.
+ * @retval None.
+ */
+void friction_reset(FRICTION_t *friction);
+
+/**
+ * @brief  Run one observer step; call with each feedback sample.
+ * @param  friction: Friction compensation.
+ * @param  command:  Command applied over the step (degrees).
+ * @param  position: Position feedback (degrees).
+ * @retval None.
+ */
+void friction_observe(FRICTION_t *friction, float32_t command, float32_t position);
+
+/**
+ * @brief  Run one compensation update; call once per control period.
+ * @param  friction:     Friction compensation.
+ * @param  error:        Tracking error (setpoint - position; degrees).
+ * @param  ref_velocity: Reference (setpoint) velocity (degrees/s).
+ * @param  velocity:     Velocity, e.g. from a state estimator (degrees/s).
+ * @retval Offset to add to the command (degrees).
+ */
+float32_t friction_update(FRICTION_t *friction, float32_t error, float32_t ref_velocity, float32_t velocity);
+
+/**
+ * @brief  Retrieve whether the last update was within the hold band at
+ *         standstill; the caller's integrator is to be held.
+ * @param  friction: Friction compensation.
+ * @retval Boolean indicating holding.
+ */
+bool friction_is_holding(const FRICTION_t *friction);
+
+/**
+ * @brief  Retrieve the observed input disturbance.
+ * @param  friction: Friction compensation.
+ * @retval Disturbance (degrees); 0 until the observer has started.
+ */
+float32_t friction_get_disturbance(const FRICTION_t *friction);
+
+/**
+ * @brief  Start a friction identification sweep from the next update.
+ * @param  id:     Identification.
+ * @param  config: Configuration (copied into @param id).
+ * @retval Boolean indicating whether the configuration is valid.
+ */
+bool friction_id_start(FRICTION_ID_t *id, const FRICTION_ID_CONFIG_t *config);
+
+/**
+ * @brief  Abort a running identification sweep (idle).
+ * @param  id: Identification.
+ * @retval None.
+ */
+void friction_id_abort(FRICTION_ID_t *id);
+
+/**
+ * @brief  Run one identification update; call with each feedback sample
+ *         whilst running. The sweep ends, and the fit is solved, after the
+ *         last speed's cycle.
+ * @param  id:       Identification.
+ * @param  command:  Command applied over the last period (degrees).
+ * @param  position: Position feedback (degrees).
+ * @param  velocity: Velocity, e.g. from a state estimator (degrees/s).
+ * @retval Command relative to the start position (degrees).
+ */
+float32_t friction_id_update(FRICTION_ID_t *id, float32_t command, float32_t position, float32_t velocity);
+
+/**
+ * @brief  Retrieve an identification's state and, when done, its result.
+ * @param  id:     Identification.
+ * @param  result: Identified parameters (if done). Passed by reference.
+ * @retval State; see @ref FRICTION_ID_STATE_t.
+ */
+FRICTION_ID_STATE_t friction_id_get_state(const FRICTION_ID_t *id, FRICTION_PARAMS_t *result);
+
+/*============================================================================*/
+
+#endif /* FRICTION_H =========================================================*/
\ No newline at end of file
@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * @file   gain_sched.h
+ * @brief  Gain scheduling table header file.
+ *
+ *         Provides:
+ *             - A compact table of controller parameter scale factors (see
+ *               @ref GAIN_SCHED_PARAM_t) over a grid of
+ *               GAIN_SCHED_LOAD_POINTS x GAIN_SCHED_POS_POINTS breakpoints,
+ *               uniformly spaced in position (pos_min..pos_max) and in an
+ *               estimated load term (0..load_max). The scale factors are
+ *               relative to the controller's base parameters, i.e. a table
+ *               of ones schedules nothing.
+ *             - O(1) lookup with bilinear interpolation (the breakpoint
+ *               indices are computed, not searched); outside the grid the
+ *               edge values are held.
+ *             - Double buffering for glitch-free loading at runtime: a
+ *               loader edits the staging table (initially a copy of the
+ *               active one) and commits it, which validates it and swaps it
+ *               in with a single index write. A lookup therefore never sees
+ *               a partly loaded table.
+ *
+ *         The loader (a task) and the lookup (an interrupt) may run
+ *         concurrently provided the lookup pre-empts the loader, not the
+ *         other way round, e.g. on a single core with the lookup in an
+ *         interrupt: a lookup started before a swap then completes before
+ *         the loader continues.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC.
+ *
+ ******************************************************************************/
+
+#ifndef GAIN_SCHED_H
+#define GAIN_SCHED_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define GAIN_SCHED_POS_POINTS       5       /* Position breakpoints (>= 2). */
+#define GAIN_SCHED_LOAD_POINTS      3       /* Load breakpoints (>= 2). */
+
+#if (GAIN_SCHED_POS_POINTS < 2) || (GAIN_SCHED_LOAD_POINTS < 2)
+#error "GAIN_SCHED_POS_POINTS and GAIN_SCHED_LOAD_POINTS must be at least 2."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef enum GAIN_SCHED_PARAM_t {
+    GAIN_SCHED_PARAM__KP,       /* Proportional gain scale. */
+    GAIN_SCHED_PARAM__KI,       /* Integral gain scale. */
+    GAIN_SCHED_PARAM__KD,       /* Derivative gain scale. */
+    GAIN_SCHED_PARAM__FF,       /* Feedforward scale. */
+    GAIN_SCHED_PARAM__NUM,
+} GAIN_SCHED_PARAM_t;
+
+typedef struct GAIN_SCHED_TABLE_t {
+    float32_t pos_min;          /* Position axis (first/last breakpoint). */
+    float32_t pos_max;
+    float32_t load_max;         /* Load axis (last breakpoint; the first is 0). */
+    float32_t pos_inv_step;     /* Derived on commit. */
+    float32_t load_inv_step;
+    float32_t scale[GAIN_SCHED_LOAD_POINTS][GAIN_SCHED_POS_POINTS][GAIN_SCHED_PARAM__NUM];
+} GAIN_SCHED_TABLE_t;
+
+typedef struct GAIN_SCHED_t {
+    GAIN_SCHED_TABLE_t tables[2];
+    volatile uint32_t active;   /* Index of the active table; the other is staging. */
+    uint32_t swap_count;        /* Tables committed. */
+} GAIN_SCHED_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a schedule with unity tables (no scheduling).
+ * @param  sched:    Schedule.
+ * @param  pos_min:  Position axis minimum.
+ * @param  pos_max:  Position axis maximum (> pos_min).
+ * @param  load_max: Load axis maximum (> 0).
+ * @retval None.
+ */
+void gain_sched_init(GAIN_SCHED_t *sched, float32_t pos_min, float32_t pos_max, float32_t load_max);
+
+/**
+ * @brief  Start editing: copy the active table to the staging table (loader).
+ * @param  sched: Schedule.
+ * @retval None.
+ */
+void gain_sched_begin(GAIN_SCHED_t *sched);
+
+/**
+ * @brief  Set the staging table's axes (loader).
+ * @param  sched:    Schedule.
+ * @param  pos_min:  Position axis minimum.
+ * @param  pos_max:  Position axis maximum (> pos_min).
+ * @param  load_max: Load axis maximum (> 0).
+ * @retval None.
+ */
+void gain_sched_set_axes(GAIN_SCHED_t *sched, float32_t pos_min, float32_t pos_max, float32_t load_max);
+
+/**
+ * @brief  Set the staging table's scale factors at a breakpoint (loader).
+ * @param  sched:    Schedule.
+ * @param  load_idx: Load breakpoint (0..GAIN_SCHED_LOAD_POINTS - 1).
+ * @param  pos_idx:  Position breakpoint (0..GAIN_SCHED_POS_POINTS - 1).
+ * @param  scale:    Scale factors (>= 0), GAIN_SCHED_PARAM__NUM.
+ * @retval Boolean indicating whether the breakpoint was set: false if an
+ *         index or scale factor is invalid.
+ */
+bool gain_sched_set_point(GAIN_SCHED_t *sched, uint32_t load_idx, uint32_t pos_idx, const float32_t *scale);
+
+/**
+ * @brief  Validate the staging table and make it the active table (loader).
+ * @param  sched: Schedule.
+ * @retval Boolean indicating whether the table was committed: false if its
+ *         axes are invalid.
+ */
+bool gain_sched_commit(GAIN_SCHED_t *sched);
+
+/**
+ * @brief  Look up the scale factors from the active table.
+ * @param  sched: Schedule.
+ * @param  pos:   Position.
+ * @param  load:  Load term (>= 0).
+ * @param  scale: Scale factors, GAIN_SCHED_PARAM__NUM. Passed by reference.
+ * @retval None.
+ */
+void gain_sched_lookup(const GAIN_SCHED_t *sched, float32_t pos, float32_t load, float32_t *scale);
+
+/*============================================================================*/
+
+#endif /* GAIN_SCHED_H =======================================================*/
\ No newline at end of file
@@ -55,6 +55,24 @@ typedef struct GPIO_CONFIG_t {
  */
 void gpio_init_output_pin(GPIO_CONFIG_t gpio_config);
 
+/**
+ * @brief  Initialise a GPIO as an alternate function (push-pull) pin, for
+ *         example, a timer PWM output.
+ * @param  port:      Port / GPIO peripheral; GPIOx where x can be (A..E,H).
+ * @param  pin:       Pin (port bit); GPIO_PIN_x where x can be (0..15).
+ * @param  alternate: Alternate function; GPIO_AFx_y (see stm32l4xx_hal_gpio_ex.h).
+ * @retval None.
+ */
+void gpio_init_af_pin(GPIO_TypeDef *port, uint16_t pin, uint32_t alternate);
+
+/**
+ * @brief  Initialise a GPIO as an analog pin, for example, an ADC input.
+ * @param  port: Port / GPIO peripheral; GPIOx where x can be (A..E,H).
+ * @param  pin:  Pin (port bit); GPIO_PIN_x where x can be (0..15).
+ * @retval None.
+ */
+void gpio_init_analog_pin(GPIO_TypeDef *port, uint16_t pin);
+
 /*============================================================================*/
 
 #endif /* GPIO_H =============================================================*/
\ No newline at end of file
@@ -39,8 +39,45 @@
 
 /*===== SERVO MOTOR CONTROL (TIMx_CHx PWM) ===================================*/
 
-#define GPIO_DEFS__PORT_SERVO_MOTOR_PWM         GPIOA
-#define GPIO_DEFS__PIN_SERVO_MOTOR_PWM          GPIO_PIN_0
+#define GPIO_DEFS__PORT_SERVO_MOTOR_1_PWM   GPIOA           /* TIM2_CH1. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_1_PWM    GPIO_PIN_0
+#define GPIO_DEFS__AF_SERVO_MOTOR_1_PWM     GPIO_AF1_TIM2
+#define GPIO_DEFS__PORT_SERVO_MOTOR_2_PWM   GPIOB           /* TIM2_CH2. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_2_PWM    GPIO_PIN_3
+#define GPIO_DEFS__AF_SERVO_MOTOR_2_PWM     GPIO_AF1_TIM2
+#define GPIO_DEFS__PORT_SERVO_MOTOR_3_PWM   GPIOB           /* TIM2_CH3. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_3_PWM    GPIO_PIN_10
+#define GPIO_DEFS__AF_SERVO_MOTOR_3_PWM     GPIO_AF1_TIM2
+#define GPIO_DEFS__PORT_SERVO_MOTOR_4_PWM   GPIOB           /* TIM2_CH4. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_4_PWM    GPIO_PIN_11
+#define GPIO_DEFS__AF_SERVO_MOTOR_4_PWM     GPIO_AF1_TIM2
+#define GPIO_DEFS__PORT_SERVO_MOTOR_5_PWM   GPIOB           /* TIM15_CH1. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_5_PWM    GPIO_PIN_14
+#define GPIO_DEFS__AF_SERVO_MOTOR_5_PWM     GPIO_AF14_TIM15
+#define GPIO_DEFS__PORT_SERVO_MOTOR_6_PWM   GPIOA           /* TIM16_CH1. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_6_PWM    GPIO_PIN_6
+#define GPIO_DEFS__AF_SERVO_MOTOR_6_PWM     GPIO_AF14_TIM16
+
+/*===== SERVO MOTOR POSITION FEEDBACK (POTENTIOMETER WIPER, ADC1_INx) =======*/
+
+#define GPIO_DEFS__PORT_SERVO_MOTOR_1_FB    GPIOA           /* ADC1_IN9. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_1_FB     GPIO_PIN_4
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_1_FB  ADC_CHANNEL_9
+#define GPIO_DEFS__PORT_SERVO_MOTOR_2_FB    GPIOA           /* ADC1_IN10. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_2_FB     GPIO_PIN_5
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_2_FB  ADC_CHANNEL_10
+#define GPIO_DEFS__PORT_SERVO_MOTOR_3_FB    GPIOA           /* ADC1_IN12. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_3_FB     GPIO_PIN_7
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_3_FB  ADC_CHANNEL_12
+#define GPIO_DEFS__PORT_SERVO_MOTOR_4_FB    GPIOC           /* ADC1_IN13. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_4_FB     GPIO_PIN_4
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_4_FB  ADC_CHANNEL_13
+#define GPIO_DEFS__PORT_SERVO_MOTOR_5_FB    GPIOC           /* ADC1_IN14. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_5_FB     GPIO_PIN_5
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_5_FB  ADC_CHANNEL_14
+#define GPIO_DEFS__PORT_SERVO_MOTOR_6_FB    GPIOB           /* ADC1_IN15. */
+#define GPIO_DEFS__PIN_SERVO_MOTOR_6_FB     GPIO_PIN_0
+#define GPIO_DEFS__ADC_CH_SERVO_MOTOR_6_FB  ADC_CHANNEL_15
 
 /*===== LCD ==================================================================*/
 
@@ -25,6 +25,26 @@
 #define LIMIT_VAR_MIN(min, var) ((var < min) ? min : var)
 #define LIMIT_VAR_RANGE(min, max, var) (LIMIT_VAR_MAX(max, LIMIT_VAR_MIN(min, var)))
 
+/**
+ * DWT cycle counter (CPU clock cycles); used to profile execution time and
+ * jitter of time-critical code such as the servo motor control loop.
+ */
+#define CYCLE_COUNTER_ENABLE() \
+    do { \
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; \
+        DWT->CYCCNT = 0; \
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; \
+    } while (0)
+#define CYCLE_COUNTER_GET() (DWT->CYCCNT)
+
+/**
+ * Place a variable in SRAM2 (see the .sram2 section of the linker script).
+ * The start-up code neither clears nor initialises it: its contents are
+ * undefined until its user initialises them explicitly (e.g. ilc_init clears
+ * the ILC tables, servo_ctrl_init the system identification buffers).
+ */
+#define SRAM2 __attribute__((section(".sram2")))
+
 /*===== Function Pointers ====================================================*/
 
 /**
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * @file   ik.h
+ * @brief  Fixed-point inverse kinematics header file.
+ *
+ *         Provides:
+ *             - Closed-form inverse kinematics of 2..3 joint arms from a
+ *               Cartesian target to joint angles (see IK_ARM_t): a planar
+ *               2-link arm (x, y), a planar 3-link arm with the end
+ *               effector's orientation (x, y, phi; the wrist point is
+ *               solved as the 2-link arm), and a spatial arm of a base yaw
+ *               joint and a 2-link arm in the vertical plane (x, y, z).
+ *               The elbow configuration (up/down) is selected by the
+ *               configuration. A target out of reach yields the nearest
+ *               posture (the arm stretched or folded towards it) and is
+ *               reported.
+ *             - Fixed-point throughout (Q16.16 inputs and outputs, as the
+ *               servo angles): the 2-link arm is solved normalised to its
+ *               reach (Q2.30; the link lengths' products precomputed), the
+ *               cosine and sine of the elbow angle scaled by l1 l2 such
+ *               that no division is taken, and the angles are binary
+ *               angles (Q31, +/-180 degrees, wrapping). The sine/cosine of
+ *               an orientation is CMSIS-DSP arm_sin_cos_q31; the arctangent
+ *               is a 9th order polynomial (Abramowitz and Stegun 4.4.47,
+ *               1e-5 rad) on the octant's ratio (a Newton reciprocal) and
+ *               the square root a Newton reciprocal square root, i.e. a
+ *               solve is a fixed number of multiplies (no loops over data
+ *               and no divisions), such that it runs at the control rate.
+ *
+ *         Joint angles: the first joint from the x axis (planar arms, and
+ *         the spatial arm's yaw about the z axis), the spatial arm's second
+ *         joint from the horizontal plane, and each further joint relative
+ *         to the previous link; counter-clockwise positive (about z for the
+ *         planar arms and the yaw, about the link's horizontal normal
+ *         towards z for the spatial arm's elevations).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a double-precision
+ *         reference.
+ *
+ ******************************************************************************/
+
+#ifndef IK_H
+#define IK_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define IK_MAX_JOINTS           3
+
+/*===== Typedefs =============================================================*/
+
+typedef enum IK_ARM_t {
+    IK_ARM__PLANAR_2,           /* Target (x, y); joints shoulder, elbow. */
+    IK_ARM__PLANAR_3,           /* Target (x, y, phi); joints shoulder, elbow, wrist. */
+    IK_ARM__SPATIAL_3,          /* Target (x, y, z); joints yaw, shoulder (elevation), elbow. */
+    IK_ARM__NUM
+} IK_ARM_t;
+
+typedef struct IK_CONFIG_t {
+    IK_ARM_t arm;
+    int32_t lengths[IK_MAX_JOINTS]; /* Link lengths from the base (Q16.16; units of the target; > 0); the third is the
+                                       planar 3-link arm's only. The shoulder and elbow links' sum < 32768 units. */
+    bool elbow_up;              /* Elbow angle negative (else positive). */
+} IK_CONFIG_t;
+
+typedef struct IK_t {
+    IK_CONFIG_t config;
+    int32_t reach;              /* Shoulder and elbow links' reach (Q16.16). */
+    uint32_t inv_reach;         /* 2^(30 + inv_shift) / reach. */
+    uint32_t inv_shift;
+    int64_t l1_sq;              /* Normalised to the reach (Q4.60): l1^2, l2^2. */
+    int64_t l2_sq;
+    int32_t l1_l2;              /* Normalised to the reach (Q2.30): l1 l2. */
+} IK_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an inverse kinematics solver: precompute the arm's
+ *         normalised link products.
+ * @param  ik:     Solver.
+ * @param  config: Configuration (copied into @param ik).
+ * @retval Boolean indicating whether the configuration is valid.
+ */
+bool ik_init(IK_t *ik, const IK_CONFIG_t *config);
+
+/**
+ * @brief  Retrieve the number of joints (and target coordinates) of a
+ *         solver's arm.
+ * @param  ik: Solver.
+ * @retval Number of joints (2..IK_MAX_JOINTS).
+ */
+uint32_t ik_get_num_joints(const IK_t *ik);
+
+/**
+ * @brief  Solve the joint angles of a Cartesian target.
+ * @param  ik:     Solver.
+ * @param  target: Target coordinates (Q16.16): x, y (units of the link
+ *                 lengths) and the planar 3-link arm's end effector
+ *                 orientation phi (degrees, from the x axis) or the spatial
+ *                 arm's z (units).
+ * @param  joints: Joint angles (degrees, Q16.16; -180..180). Passed by
+ *                 reference.
+ * @retval Boolean indicating whether the target is reachable; if not, the
+ *         joint angles are the nearest posture's.
+ */
+bool ik_solve(const IK_t *ik, const int32_t target[IK_MAX_JOINTS], int32_t joints[IK_MAX_JOINTS]);
+
+/*============================================================================*/
+
+#endif /* IK_H ===============================================================*/
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * @file   ilc.h
+ * @brief  Iterative learning control (ILC) header file.
+ *
+ *         Provides:
+ *             - A per-sample feedforward correction for a repeated motion
+ *               cycle: each cycle's tracking error trace is recorded, and the
+ *               correction table of the next iteration is learnt from it as
+ *               c(k) = Q(c(k) + gain x e(k + lead)), with the lead covering
+ *               the delay from the correction to the error it corrects and
+ *               Q a forgetting factor and a [1/4 1/2 1/4] smoothing (robust
+ *               against the cycle to cycle noise and the unmodelled high
+ *               frequency dynamics).
+ *             - Compact tables: the correction and the error trace are Q1.15
+ *               fixed-point over +/-range, one sample per decimation updates
+ *               (e.g. per feedback sample), the correction linearly
+ *               interpolated between them at the update rate. The tables are
+ *               caller provided (see @ref ILC_TABLES_t), e.g. in a dedicated
+ *               RAM bank.
+ *             - Lock-free split between interrupt and task context: the
+ *               updates (record, apply) and the cycle boundaries are called
+ *               from the control loop, the learning (see ilc_learn) from a
+ *               low priority task between cycles. The error trace and the
+ *               correction are double buffered: a learnt correction is
+ *               swapped in at the next cycle boundary, and the cycle that ran
+ *               whilst it was learnt is not learnt from (it ran with the
+ *               previous correction), i.e. an iteration takes two cycles.
+ *
+ *         A cycle's length is that of the first cycle after the start; a
+ *         cycle of a different length is not learnt from, and one longer
+ *         than ILC_MAX_SAMPLES stops the correction until the next cycle
+ *         boundary.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef ILC_H
+#define ILC_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define ILC_MAX_SAMPLES             256     /* Table samples per cycle. */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum ILC_STATE_t {
+    ILC_STATE__IDLE,
+    ILC_STATE__ARMED,           /* Waiting for a cycle boundary. */
+    ILC_STATE__RUNNING,         /* Recording, and applying the correction. */
+} ILC_STATE_t;
+
+typedef struct ILC_CONFIG_t {
+    uint32_t decimation;        /* Updates per table sample (>= 1). */
+    float32_t range;            /* Correction and error full scale (+/-; units of the setpoint). */
+    float32_t gain;             /* Learning gain (0..1]. */
+    uint32_t lead;              /* Table samples the error is advanced by. */
+    float32_t forget;           /* Forgetting factor (0..1]; 1 = none. */
+} ILC_CONFIG_t;
+
+typedef struct ILC_TABLES_t {
+    q15_t correction[2][ILC_MAX_SAMPLES];   /* Active and learnt. */
+    q15_t error[2][ILC_MAX_SAMPLES];        /* Recording and recorded. */
+} ILC_TABLES_t;
+
+typedef struct ILC_STATS_t {
+    uint32_t iterations;        /* Corrections learnt and applied. */
+    uint32_t skipped;           /* Cycles not learnt from: learning busy or length mismatch. */
+    uint32_t overruns;          /* Cycles longer than ILC_MAX_SAMPLES. */
+    uint32_t length;            /* Samples per cycle; 0 until a cycle completes. */
+    float32_t rms_error;        /* Of the last cycle learnt from. */
+} ILC_STATS_t;
+
+typedef struct ILC_t {
+    ILC_CONFIG_t config;
+    ILC_TABLES_t *tables;
+    volatile ILC_STATE_t state;
+    uint32_t tick;              /* Updates since the cycle boundary. */
+    uint32_t active;            /* Correction applied. */
+    uint32_t recording;         /* Error trace being recorded. */
+    volatile bool recorded;     /* Error trace recorded (the other buffer); awaiting ilc_learn. */
+    volatile bool learnt;       /* Correction learnt (the other buffer); awaiting the cycle boundary. */
+    ILC_STATS_t stats;
+} ILC_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an ILC (idle; zero correction).
+ * @param  ilc:    ILC.
+ * @param  config: Configuration (copied into @param ilc).
+ * @param  tables: Tables.
+ * @retval Boolean indicating whether the configuration is valid.
+ */
+bool ilc_init(ILC_t *ilc, const ILC_CONFIG_t *config, ILC_TABLES_t *tables);
+
+/**
+ * @brief  Start learning from the next cycle boundary, from zero correction.
+ * @note   The caller provides the mutual exclusion with the updates and
+ *         ilc_learn (e.g. by calling it from the task calling ilc_learn).
+ * @param  ilc: ILC.
+ * @retval None.
+ */
+void ilc_start(ILC_t *ilc);
+
+/**
+ * @brief  Stop learning; the correction is removed (stepped to zero). May be
+ *         called from the updates' context.
+ * @param  ilc: ILC.
+ * @retval None.
+ */
+void ilc_stop(ILC_t *ilc);
+
+/**
+ * @brief  Mark a cycle boundary (the start of a repetition): the finished
+ *         cycle's error trace is handed to ilc_learn, or a learnt correction
+ *         is swapped in.
+ * @param  ilc: ILC.
+ * @retval None.
+ */
+void ilc_cycle_start(ILC_t *ilc);
+
+/**
+ * @brief  Run one update; call once per update period whilst running.
+ * @param  ilc:   ILC.
+ * @param  error: Tracking error of this update (recorded once per table
+ *                sample).
+ * @retval Correction to add to the command.
+ */
+float32_t ilc_update(ILC_t *ilc, float32_t error);
+
+/**
+ * @brief  Learn the next correction from a recorded error trace.
+ * @note   Not for interrupt context; to be called periodically from one task
+ *         only (lock-free against the updates).
+ * @param  ilc: ILC.
+ * @retval Boolean indicating whether a correction was learnt by this call.
+ */
+bool ilc_learn(ILC_t *ilc);
+
+/**
+ * @brief  Retrieve an ILC's state.
+ * @param  ilc: ILC.
+ * @retval State; see @ref ILC_STATE_t.
+ */
+ILC_STATE_t ilc_get_state(const ILC_t *ilc);
+
+/*============================================================================*/
+
+#endif /* ILC_H ==============================================================*/
\ No newline at end of file
@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * @file   lms_ff.h
+ * @brief  Adaptive (normalised LMS) feedforward header file.
+ *
+ *         Provides:
+ *             - A feedforward FIR filter of the reference's increments (one
+ *               per update, e.g. per feedback sample) whose output is added
+ *               to the command, i.e. an inverse model of the servo from the
+ *               motion wanted to the command producing it, adapted online
+ *               (normalised LMS) such that it follows the servo's dynamics
+ *               as they drift (load, temperature). The adaptation error is
+ *               the tracking error the configured lead (updates) after the
+ *               feedforward it is paired with, i.e. when the command has
+ *               acted on the servo (delayed error LMS); the desired output
+ *               is that feedforward plus the error. A static offset (no
+ *               increments) is left to the controller's integrator.
+ *             - Block processing: the update pairs (input, error) are
+ *               recorded into one of two blocks of LMS_FF_BLOCK_SIZE pairs
+ *               whilst the other, full, is adapted from by a low priority
+ *               task (see lms_ff_adapt) with the CMSIS-DSP arm_lms_norm_f32
+ *               or arm_lms_norm_q31 kernel (see @ref LMS_FF_KERNEL_t), i.e.
+ *               the adaptation's cost is taken out of the updates. An update
+ *               costs LMS_FF_NUM_TAPS multiply-adds (the filter output,
+ *               arm_dot_prod_f32) with either kernel: the adapted
+ *               coefficients are applied in floating-point.
+ *             - The Q31 kernel adapts the same filter in fixed-point: the
+ *               errors are Q1.31 over +/-range (and the inputs, limited to
+ *               LMS_FF_Q31_INPUT_MAX of it), the coefficients
+ *               Q(1+LMS_FF_Q31_POST_SHIFT).(31-LMS_FF_Q31_POST_SHIFT), i.e.
+ *               within +/-2^LMS_FF_Q31_POST_SHIFT, and its adaptation step
+ *               is scaled down by 2^LMS_FF_Q31_POST_SHIFT (the kernel steps
+ *               the coefficients' raw values).
+ *             - Lock-free split between interrupt and task context, as for
+ *               the ILC (see @ref ilc.h): the adapted coefficients are
+ *               double buffered and swapped in by the task, and a block not
+ *               taken by the task before the next is full is dropped
+ *               (counted), the filter's history restarted.
+ *             - Freezing: the coefficients are held (adaptation step zero)
+ *               whilst the error is still monitored.
+ *
+ *         The adaptation step is scaled per pair by the input window's
+ *         energy relative to a configured minimum (a regularisation of the
+ *         normalisation), such that the near standstill windows, whose error
+ *         is dominated by the feedback noise, adapt little, and the
+ *         coefficients leak towards zero per block (the smooth reference's
+ *         increments are near collinear, and without it the coefficients
+ *         drift along the directions they do not excite).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef LMS_FF_H
+#define LMS_FF_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define LMS_FF_NUM_TAPS         4       /* Filter taps (updates of the reference's history). */
+#define LMS_FF_BLOCK_SIZE       8       /* Update pairs per adaptation block. */
+#define LMS_FF_MAX_LEAD         3       /* Longest lead (updates). */
+#define LMS_FF_Q31_POST_SHIFT   3       /* Q31 kernel: coefficients within +/-8. */
+#define LMS_FF_Q31_INPUT_MAX    0.49f   /* Q31 kernel: input limit (of the range); the window's energy within Q1.31. */
+#if (LMS_FF_NUM_TAPS > 4)
+#error "LMS_FF_Q31_INPUT_MAX must be reduced for more than 4 taps."
+#endif
+#if (LMS_FF_MAX_LEAD >= LMS_FF_NUM_TAPS)
+#error "LMS_FF_MAX_LEAD must be below LMS_FF_NUM_TAPS."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef enum LMS_FF_KERNEL_t {
+    LMS_FF_KERNEL__F32,         /* arm_lms_norm_f32. */
+    LMS_FF_KERNEL__Q31,         /* arm_lms_norm_q31. */
+    LMS_FF_KERNEL__NUM,
+} LMS_FF_KERNEL_t;
+
+typedef struct LMS_FF_CONFIG_t {
+    LMS_FF_KERNEL_t kernel;     /* Adaptation kernel. */
+    float32_t range;            /* Q31 kernel: input and error full scale (+/-; units of the reference). */
+    float32_t mu;               /* Normalised adaptation step (0..1]. */
+    float32_t energy_min;       /* Window input energy (units of the reference, squared) of half the step. */
+    float32_t leak;             /* Coefficient leakage per block [0..1). */
+    float32_t output_max;       /* Output limit (+/-; units of the reference). */
+    uint32_t lead;              /* Updates from a feedforward to the error it is adapted with. */
+} LMS_FF_CONFIG_t;
+
+typedef struct LMS_FF_STATS_t {
+    uint32_t blocks;            /* Blocks adapted from (or monitored whilst frozen). */
+    uint32_t dropped;           /* Blocks not taken by the task in time. */
+    float32_t rms_error;        /* Tracking error over the last block. */
+    float32_t rms_output;       /* Feedforward over the last block. */
+} LMS_FF_STATS_t;
+
+typedef struct LMS_FF_t {
+    LMS_FF_CONFIG_t config;
+    union {                                             /* Task context only. Kernel state: one pair per call. */
+        struct {
+            arm_lms_norm_instance_f32 instance;
+            float32_t coeffs[LMS_FF_NUM_TAPS];
+            float32_t state[LMS_FF_NUM_TAPS];
+        } f32;
+        struct {
+            arm_lms_norm_instance_q31 instance;
+            q31_t coeffs[LMS_FF_NUM_TAPS];
+            q31_t state[LMS_FF_NUM_TAPS];
+        } q31;
+    } kernel;
+    float32_t coeffs[2][LMS_FF_NUM_TAPS];               /* Applied and adapted; oldest input first (as arm_lms_norm_f32). */
+    volatile uint32_t active;                           /* Coefficients applied. */
+    float32_t history[LMS_FF_NUM_TAPS];                 /* Input history; oldest first. */
+    float32_t reference_prev;
+    bool valid;                                         /* History started since the last restart. */
+    float32_t input[2][LMS_FF_BLOCK_SIZE];              /* Recording and recorded blocks. */
+    float32_t error[2][LMS_FF_BLOCK_SIZE];
+    uint32_t fill;                                      /* Pairs in the recording block. */
+    uint32_t recording;
+    volatile bool recorded;                             /* Block recorded (the other); awaiting lms_ff_adapt. */
+    volatile bool restart[2];                           /* Block discontinuous with the previous; the task's to restart. */
+    volatile bool frozen;
+    LMS_FF_STATS_t stats;
+} LMS_FF_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an adaptive feedforward (zero coefficients; adapting).
+ * @param  ff:     Adaptive feedforward.
+ * @param  config: Configuration (copied into @param ff).
+ * @retval Boolean indicating whether the configuration is valid.
+ */
+bool lms_ff_init(LMS_FF_t *ff, const LMS_FF_CONFIG_t *config);
+
+/**
+ * @brief  Clear the coefficients (zero output) and restart.
+ * @note   The caller provides the mutual exclusion with the updates and
+ *         lms_ff_adapt (e.g. by calling it from the task calling
+ *         lms_ff_adapt).
+ * @param  ff: Adaptive feedforward.
+ * @retval None.
+ */
+void lms_ff_clear(LMS_FF_t *ff);
+
+/**
+ * @brief  Restart the reference's history, e.g. after the loop was opened
+ *         (the coefficients are kept). May be called from the updates'
+ *         context.
+ * @param  ff: Adaptive feedforward.
+ * @retval None.
+ */
+void lms_ff_restart(LMS_FF_t *ff);
+
+/**
+ * @brief  Freeze/unfreeze the adaptation.
+ * @param  ff:    Adaptive feedforward.
+ * @param  state: Freeze (true) or adapt (false).
+ * @retval None.
+ */
+void lms_ff_freeze(LMS_FF_t *ff, bool state);
+
+/**
+ * @brief  Run one update; call once per update period, followed by
+ *         lms_ff_record with the update's tracking error.
+ * @param  ff:        Adaptive feedforward.
+ * @param  reference: Reference (setpoint).
+ * @retval Feedforward to add to the command.
+ */
+float32_t lms_ff_update(LMS_FF_t *ff, float32_t reference);
+
+/**
+ * @brief  Record the update's tracking error, paired with the input and
+ *         output of the update the lead before; a full block is handed to
+ *         lms_ff_adapt.
+ * @param  ff:    Adaptive feedforward.
+ * @param  error: Tracking error (reference - position).
+ * @retval None.
+ */
+void lms_ff_record(LMS_FF_t *ff, float32_t error);
+
+/**
+ * @brief  Adapt from a recorded block and swap the adapted coefficients in.
+ * @note   Not for interrupt context; to be called periodically (at least
+ *         once per block) from one task only (lock-free against the
+ *         updates).
+ * @param  ff: Adaptive feedforward.
+ * @retval Boolean indicating whether a block was processed by this call.
+ */
+bool lms_ff_adapt(LMS_FF_t *ff);
+
+/*============================================================================*/
+
+#endif /* LMS_FF_H ===========================================================*/
\ No newline at end of file
@@ -59,6 +59,31 @@ void freertos_wrapper_error_handler(void);
  */
 void lcd_delay_ms(uint32_t ms);
 
+/**
+ * @brief  Overwrite weakly defined function in @ref timer.c.
+ *         Runs the servo motor control loop at the TIM6 update rate.
+ * @retval None.
+ */
+void timer_tim6_period_elapsed_callback(void);
+
+/**
+ * @brief  Overwrite weakly defined function in @ref timer.c.
+ *         Records the PWM frame update and keeps the servo motor control loop
+ *         phase-locked to the PWM frame.
+ * @retval None.
+ */
+void timer_tim2_period_elapsed_callback(void);
+
+/**
+ * @brief  Overwrite weakly defined function in @ref adc.c.
+ *         Converts each block of potentiometer samples into the servo motors'
+ *         *actual* positions.
+ * @param  samples:   Samples, interleaved by scan.
+ * @param  num_scans: Number of scans in the block.
+ * @retval None.
+ */
+void adc_block_ready_callback(const uint16_t *samples, uint32_t num_scans);
+
 /*============================================================================*/
 
 #endif /* MAIN_H =============================================================*/
\ No newline at end of file
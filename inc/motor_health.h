@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * @file   motor_health.h
+ * @brief  Servo motor health monitor header file.
+ *
+ *         Provides:
+ *             - Stall detection: the actual position is away from the command
+ *               applied to the motor by more than a threshold beyond the load
+ *               term (the part of the command holding the servo against its
+ *               load), the estimated speed below a threshold at the onset and
+ *               the position not travelling beyond a threshold from the
+ *               onset's since, i.e. the motor is driven but does not move.
+ *               The travel rather than the speed is held: a velocity estimate
+ *               from noisy feedback exceeds a low speed threshold now and then.
+ *             - Overload detection: the load term (the controller correction
+ *               holding the servo against its load) is above a threshold.
+ *             - Feedback loss detection: no new valid feedback sample; armed
+ *               by the first valid sample after a reset, such that feedback
+ *               settling at start-up is not a fault.
+ *             - Each condition must hold for a configured number of
+ *               consecutive updates (control periods) to be detected; the
+ *               update timestamp at the condition's onset is recorded so that
+ *               the detection latency can be measured. A detected fault is
+ *               latched until the monitor is reset.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef MOTOR_HEALTH_H
+#define MOTOR_HEALTH_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Typedefs =============================================================*/
+
+typedef enum MOTOR_FAULT_t {
+    MOTOR_FAULT__NONE,
+    MOTOR_FAULT__STALL,
+    MOTOR_FAULT__OVERLOAD,
+    MOTOR_FAULT__FEEDBACK_LOSS,
+    MOTOR_FAULT__NUM
+} MOTOR_FAULT_t;
+
+typedef struct MOTOR_HEALTH_CONFIG_t {
+    float32_t stall_error;      /* Minimum |command - position| - load of a stall. */
+    float32_t stall_speed;      /* Maximum |velocity| at a stall's onset. */
+    float32_t stall_travel;     /* Maximum |position - onset position| of a stall. */
+    uint32_t stall_periods;     /* Consecutive updates to detect a stall (>= 1). */
+    float32_t overload_load;    /* Minimum load term of an overload. */
+    uint32_t overload_periods;  /* Consecutive updates to detect an overload (>= 1). */
+    uint32_t fb_loss_periods;   /* Updates without a new valid feedback sample to detect its loss (>= 1). */
+} MOTOR_HEALTH_CONFIG_t;
+
+typedef struct MOTOR_HEALTH_INPUT_t {
+    uint32_t timestamp;         /* Update time (e.g. CPU cycles). */
+    bool feedback_valid;        /* Position (and velocity) valid. */
+    bool feedback_new;          /* New feedback sample since the last update. */
+    bool controlled;            /* Closed-loop control in effect: stall and overload checked. */
+    float32_t command;          /* Command applied to the motor. */
+    float32_t position;         /* Actual position. */
+    float32_t velocity;         /* Estimated velocity. */
+    float32_t load;             /* Load term. */
+} MOTOR_HEALTH_INPUT_t;
+
+typedef struct MOTOR_HEALTH_t {
+    MOTOR_HEALTH_CONFIG_t config;
+    bool armed;                 /* Valid feedback seen since the reset. */
+    uint32_t count[MOTOR_FAULT__NUM];  /* Consecutive updates each condition has held. */
+    uint32_t onset[MOTOR_FAULT__NUM];  /* Timestamp of each condition's onset; valid whilst counted. */
+    float32_t stall_position;   /* Position at the stall condition's onset; valid whilst counted. */
+    MOTOR_FAULT_t fault;        /* Latched. */
+    uint32_t fault_onset;       /* Timestamp of the latched fault's onset. */
+} MOTOR_HEALTH_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a health monitor (reset).
+ * @param  health: Health monitor.
+ * @param  config: Configuration (copied into @param health).
+ * @retval None.
+ */
+void motor_health_init(MOTOR_HEALTH_t *health, const MOTOR_HEALTH_CONFIG_t *config);
+
+/**
+ * @brief  Reset a health monitor: clears the latched fault, the condition
+ *         counts and the feedback loss arming.
+ * @param  health: Health monitor.
+ * @retval None.
+ */
+void motor_health_reset(MOTOR_HEALTH_t *health);
+
+/**
+ * @brief  Run one monitor update; call once per control period.
+ * @param  health: Health monitor.
+ * @param  input:  Motor state this period.
+ * @retval Fault detected by this update, else MOTOR_FAULT__NONE (including
+ *         whilst a fault is latched).
+ */
+MOTOR_FAULT_t motor_health_update(MOTOR_HEALTH_t *health, const MOTOR_HEALTH_INPUT_t *input);
+
+/**
+ * @brief  Retrieve the latched fault.
+ * @param  health: Health monitor.
+ * @param  onset:  Timestamp of the fault condition's onset. Passed by
+ *                 reference; may be NULL.
+ * @retval Latched fault, else MOTOR_FAULT__NONE.
+ */
+MOTOR_FAULT_t motor_health_get_fault(const MOTOR_HEALTH_t *health, uint32_t *onset);
+
+/*============================================================================*/
+
+#endif /* MOTOR_HEALTH_H =====================================================*/
\ No newline at end of file
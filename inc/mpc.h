@@ -0,0 +1,157 @@
+/*******************************************************************************
+ * @file   mpc.h
+ * @brief  Model predictive controller (MPC) header file.
+ *
+ *         Provides:
+ *             - A condensed linear MPC over a short horizon for a servo
+ *               modelled (command to position) as 2nd order with natural
+ *               frequency wn and damping zeta, discretised with a zero-order
+ *               hold at the step (input update) period. The state is the
+ *               position and velocity, e.g. from a state estimator.
+ *             - Cost: the position error to a reference over MPC_HORIZON
+ *               steps, the inputs relative to the reference, and the input
+ *               moves (including from the previous input), over
+ *               MPC_CONTROL_MOVES moves (the last held to the horizon).
+ *             - Per plant (@ref MPC_STATE_t), a model-based observer of the state and of an input
+ *               disturbance (e.g. a load's offset), predicted with the
+ *               applied input every step and corrected with the position
+ *               feedback (fixed gains). The state therefore does not lag
+ *               the input as a kinematic estimate does, and the steps
+ *               compensate the disturbance (offset-free tracking) without
+ *               an integrator on the tracking error to wind up.
+ *             - Input (command), input move (slew) and position
+ *               constraints over the horizon, as inequalities M U <= gamma
+ *               on the moves U. The move constraint also keeps the plant
+ *               within its linear range, e.g. below a servo's speed limit.
+ *             - Precomputation at initialisation (arm_mat_inverse_f32 and
+ *               arm_mat_mult_f32) of the unconstrained solution's gain and
+ *               the dual problem's matrices, such that a step costs a few
+ *               small matrix-vector products (arm_mat_mult_f32) when no
+ *               constraint is active, and at most MPC_MAX_ITERATIONS sweeps
+ *               of Hildreth's dual QP method (MPC_NUM_CONSTRAINTS^2
+ *               multiply-accumulates each) when one is, warm started from
+ *               the previous step's multipliers. The run time is
+ *               therefore bounded; should the iterations not converge
+ *               (e.g. a position constraint cannot be met) the input is the
+ *               best iterate, limited to the move and input constraints.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef MPC_H
+#define MPC_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define MPC_NUM_STATES              2       /* Position, velocity. */
+#define MPC_HORIZON                 10      /* Prediction steps (N). */
+#define MPC_CONTROL_MOVES           3       /* Control moves (Nc <= N). */
+#define MPC_NUM_CONSTRAINTS         (2 * ((2 * MPC_CONTROL_MOVES) + MPC_HORIZON))
+#define MPC_MAX_ITERATIONS          10      /* Hildreth's method sweeps per step (bounds the run time). */
+#define MPC_TOLERANCE               1.0e-6f /* Converged: sum of the squared multiplier changes in a sweep. */
+
+#if (MPC_CONTROL_MOVES < 1) || (MPC_CONTROL_MOVES > MPC_HORIZON)
+#error "MPC_CONTROL_MOVES must be in the range (1..MPC_HORIZON)."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef struct MPC_CONFIG_t {
+    float32_t period_s;         /* Step (input update) period (s). */
+    float32_t wn;               /* Model natural frequency (rad/s). */
+    float32_t zeta;             /* Model damping ratio. */
+    float32_t q;                /* Position error weight. */
+    float32_t r;                /* Input (relative to the reference) weight. */
+    float32_t s;                /* Input move weight. */
+    float32_t l_pos;            /* Observer gains: position, velocity and disturbance */
+    float32_t l_vel;            /* corrections per unit position innovation. */
+    float32_t l_dist;
+} MPC_CONFIG_t;
+
+typedef struct MPC_LIMITS_t {
+    float32_t u_min;            /* Input constraints. */
+    float32_t u_max;
+    float32_t du_max;           /* Input move constraint (magnitude per step). */
+    float32_t y_min;            /* Position constraints. */
+    float32_t y_max;
+} MPC_LIMITS_t;
+
+typedef struct MPC_STATE_t {
+    float32_t x[MPC_NUM_STATES];            /* Observed position and velocity. */
+    float32_t disturbance;                  /* Observed input disturbance (in input units). */
+    float32_t lambda[MPC_NUM_CONSTRAINTS];  /* Last step's multipliers (warm start). */
+} MPC_STATE_t;
+
+typedef struct MPC_t {
+    MPC_CONFIG_t config;
+    float32_t a[MPC_NUM_STATES * MPC_NUM_STATES];   /* Model (discrete). */
+    float32_t b[MPC_NUM_STATES];
+    float32_t phi[MPC_HORIZON * MPC_NUM_STATES];    /* Predicted positions: phi x + gamma U. */
+    float32_t gamma[MPC_HORIZON * MPC_CONTROL_MOVES];
+    float32_t k[MPC_CONTROL_MOVES * (MPC_NUM_STATES + 2)];          /* Unconstrained U = k [x; reference; previous input]. */
+    float32_t hinv_mt[MPC_CONTROL_MOVES * MPC_NUM_CONSTRAINTS];     /* H^-1 M^T. */
+    float32_t p[MPC_NUM_CONSTRAINTS * MPC_NUM_CONSTRAINTS];         /* M H^-1 M^T (dual Hessian). */
+    arm_matrix_instance_f32 mat_phi;
+    arm_matrix_instance_f32 mat_gamma;
+    arm_matrix_instance_f32 mat_k;
+} MPC_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an MPC: discretise the model and precompute the
+ *         prediction, unconstrained gain and dual problem matrices.
+ * @param  mpc:    MPC.
+ * @param  config: Configuration (copied into @param mpc).
+ * @retval Boolean indicating whether the MPC was initialised: false if the
+ *         cost's Hessian is singular (e.g. all weights zero).
+ */
+bool mpc_init(MPC_t *mpc, const MPC_CONFIG_t *config);
+
+/**
+ * @brief  Reset a plant's state: at rest at a position, without disturbance.
+ * @param  state:    State.
+ * @param  position: Position.
+ * @retval None.
+ */
+void mpc_state_reset(MPC_STATE_t *state, float32_t position);
+
+/**
+ * @brief  Observer update: predict the state over one step with the input
+ *         applied during it, then correct it with the position feedback.
+ * @param  mpc:      MPC.
+ * @param  state:    State.
+ * @param  u:        Input applied during the step.
+ * @param  position: Position feedback.
+ * @retval None.
+ */
+void mpc_observe(const MPC_t *mpc, MPC_STATE_t *state, float32_t u, float32_t position);
+
+/**
+ * @brief  Run one MPC step: the first optimal input, from the observed
+ *         state and compensating the observed disturbance.
+ * @param  mpc:        MPC.
+ * @param  state:      State; the multipliers are updated.
+ * @param  reference:  Position reference (constant over the horizon).
+ * @param  u_prev:     Previous (currently applied) input.
+ * @param  limits:     Input and position constraints.
+ * @param  iterations: Hildreth's method sweeps run; zero if no constraint
+ *                     was active. Passed by reference.
+ * @retval Input to apply for the next step period.
+ */
+float32_t mpc_step(const MPC_t *mpc, MPC_STATE_t *state, float32_t reference, float32_t u_prev,
+                   const MPC_LIMITS_t *limits, uint32_t *iterations);
+
+/*============================================================================*/
+
+#endif /* MPC_H ==============================================================*/
\ No newline at end of file
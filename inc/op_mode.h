@@ -8,6 +8,8 @@
  *     Unknown (during MCU start-up)              None
  *     Idle                                       Green
  *     Motor running                              Yellow
+ *     Auto-tuning (relay experiment)             Green & Yellow
+ *     System identification (excitation)         Green, Yellow & Red
  *     Error state: motor                         Red
  *     Error state: LCD                           Red
  *     Error state: peripherals (USART, etc.)     Red
@@ -24,6 +26,8 @@ typedef enum OP_MODE_t {
     OP_MODE__UNKNOWN,
     OP_MODE__IDLE,
     OP_MODE__MOTOR_RUNNING,
+    OP_MODE__AUTOTUNE,
+    OP_MODE__SYSID,
     OP_MODE__ERROR_MOTOR,
     OP_MODE__ERROR_LCD,
     OP_MODE__ERROR_PERIPHERALS,
@@ -56,6 +60,27 @@ bool op_mode_update(void);
  */
 void op_mode_set_leds(void);
 
+/**
+ * @brief  Set the task that illuminates the LEDs (see op_mode_set_leds) when
+ *         notified by op_mode_set_error_motor.
+ * @param  handle: Task handle.
+ * @retval None.
+ */
+void op_mode_set_led_task(TaskHandle_t handle);
+
+/**
+ * @brief  Force the operational mode to be "Error Motor" and notify the LEDs
+ *         task (see op_mode_set_led_task) to illuminate the LEDs based on
+ *         this mode, without waiting for the next update (see
+ *         op_mode_update); held by the updates whilst a motor fault is
+ *         latched (see servo_ctrl_is_faulted).
+ * @note   IMPORTANT: This function is intended to be used by the control
+ *         loop (interrupt context) when it detects a motor fault (see
+ *         servo_ctrl_loop_run).
+ * @retval None.
+ */
+void op_mode_set_error_motor(void);
+
 /**
  * @brief  Force the operational mode to be "Error Firmware Fault" and
  *         illuminate the LEDs based on this mode.
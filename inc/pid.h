@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * @file   pid.h
+ * @brief  PID controller header file.
+ *
+ *         Provides:
+ *             - Discrete PID controller built on the CMSIS-DSP
+ *               arm_pid_instance_f32/arm_pid_f32 implementation.
+ *             - Gains specified in continuous-time form (Kp, Ki [1/s],
+ *               Kd [s]) and converted to per-sample gains for a given
+ *               sample period.
+ *             - Derivative on the error (default), or on a measured/estimated
+ *               rate of the feedback (see pid_update_rate), which avoids the
+ *               derivative kick on setpoint steps and differencing a noisy
+ *               feedback.
+ *             - Output limiting, to the configured limits and to the
+ *               actuator's current range (see pid_set_actuator_limits), with
+ *               anti-windup: the integrator is held at the limited output
+ *               (back-calculation with an immediate tracking time), such
+ *               that it does not wind up whilst the actuator is saturated
+ *               (e.g. at an end stop or slew limited).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC (e.g. against a simulated
+ *         plant model).
+ *
+ ******************************************************************************/
+
+#ifndef PID_H
+#define PID_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Typedefs =============================================================*/
+
+typedef enum PID_DERIVATIVE_t {
+    PID_DERIVATIVE__ERROR = 0, /* Derivative of the error (arm_pid_f32). */
+    PID_DERIVATIVE__RATE,      /* -kd x feedback rate (see pid_update_rate). */
+} PID_DERIVATIVE_t;
+
+typedef struct PID_CONFIG_t {
+    float32_t kp;         /* Proportional gain. */
+    float32_t ki;         /* Integral gain (1/s). */
+    float32_t kd;         /* Derivative gain (s). */
+    float32_t period_s;   /* Sample period (s). */
+    float32_t output_min; /* Minimum controller output. */
+    float32_t output_max; /* Maximum controller output. */
+    PID_DERIVATIVE_t derivative; /* Derivative term source. */
+} PID_CONFIG_t;
+
+typedef struct PID_t {
+    arm_pid_instance_f32 instance; /* CMSIS-DSP PID instance (per-sample gains). */
+    PID_CONFIG_t config;           /* Configuration the instance was derived from. */
+    float32_t limit_min;           /* Output limits: the configured limits, narrowed to */
+    float32_t limit_max;           /* the actuator limits (see pid_set_actuator_limits). */
+    bool saturated;                /* Whether the last output was limited. */
+} PID_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a PID controller and reset its state.
+ * @param  pid:    PID controller.
+ * @param  config: PID configuration (copied into @param pid).
+ * @retval None.
+ */
+void pid_init(PID_t *pid, const PID_CONFIG_t *config);
+
+/**
+ * @brief  Load new gains into a running PID controller without resetting its
+ *         state (i.e. bumpless with respect to the previous output).
+ * @param  pid: PID controller.
+ * @param  kp:  Proportional gain.
+ * @param  ki:  Integral gain (1/s).
+ * @param  kd:  Derivative gain (s).
+ * @retval None.
+ */
+void pid_set_gains(PID_t *pid, float32_t kp, float32_t ki, float32_t kd);
+
+/**
+ * @brief  Reset the PID controller state (error history and output).
+ * @param  pid: PID controller.
+ * @retval None.
+ */
+void pid_reset(PID_t *pid);
+
+/**
+ * @brief  Limit the output to the actuator's current range, in addition to
+ *         the configured limits, from the next update; e.g. the headroom
+ *         between the setpoint and an actuator's stops for a controller
+ *         whose output is a correction to the setpoint.
+ * @param  pid:        PID controller.
+ * @param  output_min: Minimum output the actuator can apply.
+ * @param  output_max: Maximum output the actuator can apply.
+ * @retval None.
+ */
+void pid_set_actuator_limits(PID_t *pid, float32_t output_min, float32_t output_max);
+
+/**
+ * @brief  Retrieve whether the last output was limited (the integrator was
+ *         held).
+ * @param  pid: PID controller.
+ * @retval Boolean indicating whether the last output was limited.
+ */
+bool pid_is_saturated(const PID_t *pid);
+
+/**
+ * @brief  Run one PID controller update; call once per sample period.
+ * @param  pid:      PID controller.
+ * @param  setpoint: Desired value.
+ * @param  feedback: Measured value.
+ * @retval Controller output limited to (output_min..output_max) and the
+ *         actuator limits.
+ */
+float32_t pid_update(PID_t *pid, float32_t setpoint, float32_t feedback);
+
+/**
+ * @brief  Run one PID controller update with the derivative term taken from
+ *         the feedback rate (PID_DERIVATIVE__RATE), i.e. output = PI(error) -
+ *         kd x feedback_rate; call once per sample period.
+ * @note   With PID_DERIVATIVE__ERROR this is equivalent to pid_update.
+ * @param  pid:           PID controller.
+ * @param  setpoint:      Desired value.
+ * @param  feedback:      Measured value.
+ * @param  feedback_rate: Rate of change of the measured value (per second),
+ *                        e.g. from a state estimator.
+ * @retval Controller output limited to (output_min..output_max) and the
+ *         actuator limits.
+ */
+float32_t pid_update_rate(PID_t *pid, float32_t setpoint, float32_t feedback, float32_t feedback_rate);
+
+/*============================================================================*/
+
+#endif /* PID_H ==============================================================*/
\ No newline at end of file
@@ -0,0 +1,244 @@
+/*******************************************************************************
+ * @file   profile.h
+ * @brief  Motion profile (trajectory) generator header file.
+ *
+ *         Provides:
+ *             - Move planning: a rest-to-rest move of a given distance within
+ *               velocity, acceleration and (S-curve) jerk limits, as either a
+ *               trapezoidal (3 segment, acceleration limited) or a 7 segment
+ *               S-curve (jerk limited) velocity profile. Segment durations
+ *               are whole generator ticks, the limits are scaled down to suit
+ *               such that the move ends exactly at its distance.
+ *             - Time-parameterised evaluation: each segment is a cubic in
+ *               its tick count, evaluated in fixed-point (Q24.40, i.e. 64-bit
+ *               integer) by Horner's method: three multiplies and no
+ *               division or floating-point arithmetic per tick.
+ *             - The velocity and acceleration at each tick (derivatives of
+ *               the segment cubics), e.g. for controller feedforward.
+ *             - Timed planning: a move's segment durations (its timing) are
+ *               planned once and moves of any distance built to them (see
+ *               profile_plan_timing/profile_plan_timed), e.g. such that the
+ *               moves of several axes start and finish together.
+ *             - A queue of moves per generator; a move flagged to blend
+ *               starts whilst the previous move decelerates (superposition),
+ *               rather than after it has come to rest.
+ *
+ *         Planning (floating-point) is intended for task context; the
+ *         generator is stepped once per tick (e.g. the control loop period)
+ *         from interrupt context (see profile_next). The caller provides the
+ *         mutual exclusion around profile_commit/profile_reset.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC.
+ *
+ ******************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define PROFILE_FRAC_BITS           40  /* Fixed-point positions/coefficients: Q24.40 (units of the Q16.16 input/output). */
+#define PROFILE_MAX_SEGMENTS        7
+#define PROFILE_QUEUE_LEN           4   /* Moves per generator (including the running move(s)). */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum PROFILE_TYPE_t {
+    PROFILE_TYPE__TRAPEZOIDAL,  /* Acceleration limited (infinite jerk). */
+    PROFILE_TYPE__S_CURVE,      /* Jerk limited. */
+} PROFILE_TYPE_t;
+
+typedef struct PROFILE_LIMITS_t {
+    float32_t velocity;         /* Maximum velocity (units/s). */
+    float32_t acceleration;     /* Maximum acceleration (units/s^2). */
+    float32_t jerk;             /* Maximum jerk (units/s^3); S-curve only. */
+} PROFILE_LIMITS_t;
+
+typedef struct PROFILE_TIMING_t {
+    PROFILE_TYPE_t type;
+    uint32_t ramp;              /* Acceleration (trapezoidal) or jerk (S-curve) segment ticks; 0 = no move. */
+    uint32_t accel;             /* Constant acceleration segment ticks (S-curve only). */
+    uint32_t cruise;            /* Constant velocity segment ticks. */
+} PROFILE_TIMING_t;
+
+typedef struct PROFILE_SEGMENT_t {
+    uint32_t ticks;             /* Duration (ticks). */
+    int64_t p0;                 /* Displacement at the start of the segment (Q24.40). */
+    int64_t c1;                 /* Velocity at the start (Q24.40 per tick). */
+    int64_t c2;                 /* Acceleration at the start / 2 (Q24.40 per tick^2). */
+    int64_t c3;                 /* Jerk / 6 (Q24.40 per tick^3). */
+} PROFILE_SEGMENT_t;
+
+typedef struct PROFILE_MOVE_t {
+    int64_t distance;           /* Displacement (Q24.40). */
+    uint32_t num_segments;
+    uint32_t total_ticks;
+    uint32_t decel_tick;        /* Tick at which the deceleration starts (blend point). */
+    bool blend;                 /* Start whilst the previous move decelerates. */
+    PROFILE_SEGMENT_t segment[PROFILE_MAX_SEGMENTS];
+} PROFILE_MOVE_t;
+
+typedef struct PROFILE_RUN_t {
+    uint32_t segment;           /* Current segment. */
+    uint32_t tick;              /* Tick within the current segment. */
+    uint32_t elapsed;           /* Ticks since the start of the move. */
+} PROFILE_RUN_t;
+
+typedef struct PROFILE_GEN_t {
+    uint32_t rate_hz;                           /* Tick rate. */
+    int64_t position;                           /* Position at the start of the oldest running move (Q24.40). */
+    int64_t queued_end;                         /* Position at the end of the last queued move (Q24.40). */
+    PROFILE_MOVE_t queue[PROFILE_QUEUE_LEN];
+    uint32_t head;                              /* Next free slot. */
+    uint32_t tail;                              /* Oldest (running) move. */
+    volatile uint32_t count;                    /* Queued moves, including the running move(s). */
+    PROFILE_RUN_t run[2];                       /* Running moves: queue[tail] and (blending) queue[tail + 1]. */
+    uint32_t num_running;
+    uint32_t moves_started;                     /* Moves started (free-running count), e.g. to detect repetitions. */
+    float32_t velocity;                         /* At the last tick (units/s). */
+    float32_t acceleration;                     /* At the last tick (units/s^2). */
+    float32_t velocity_scale;                   /* Q24.40 per tick to units/s. */
+    float32_t acceleration_scale;               /* Q24.40 per tick^2 to units/s^2. */
+} PROFILE_GEN_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a generator at rest.
+ * @param  gen:      Generator.
+ * @param  rate_hz:  Tick rate (Hz), i.e. the rate profile_next is called at.
+ * @param  position: Position (Q16.16).
+ * @retval None.
+ */
+void profile_init(PROFILE_GEN_t *gen, uint32_t rate_hz, int32_t position);
+
+/**
+ * @brief  Discard all queued/running moves and hold a position.
+ * @param  gen:      Generator.
+ * @param  position: Position (Q16.16).
+ * @retval None.
+ */
+void profile_reset(PROFILE_GEN_t *gen, int32_t position);
+
+/**
+ * @brief  Plan a move to an absolute target (from the end of the last queued
+ *         move) into the next free queue slot; the move is not run until
+ *         committed (see profile_commit).
+ * @param  gen:    Generator.
+ * @param  type:   Profile type; see @ref PROFILE_TYPE_t.
+ * @param  target: Target position (Q16.16).
+ * @param  limits: Velocity/acceleration/jerk limits (> 0).
+ * @param  blend:  Whether to start whilst the previous move decelerates.
+ * @retval Boolean indicating whether the move was planned: false if the
+ *         queue is full or a limit is invalid.
+ */
+bool profile_plan(PROFILE_GEN_t *gen, PROFILE_TYPE_t type, int32_t target, const PROFILE_LIMITS_t *limits, bool blend);
+
+/**
+ * @brief  Plan the timing of a move of a distance within limits (see
+ *         profile_plan), for moves built to it by profile_plan_timed.
+ * @param  type:     Profile type; see @ref PROFILE_TYPE_t.
+ * @param  distance: Distance magnitude (units).
+ * @param  limits:   Velocity/acceleration/jerk limits (> 0).
+ * @param  rate_hz:  Tick rate (Hz) of the generators the timing is for.
+ * @param  timing:   Timing. Passed by reference.
+ * @retval Boolean indicating whether the timing was planned: false if a
+ *         limit or the distance is invalid.
+ */
+bool profile_plan_timing(PROFILE_TYPE_t type, float32_t distance, const PROFILE_LIMITS_t *limits, uint32_t rate_hz,
+                         PROFILE_TIMING_t *timing);
+
+/**
+ * @brief  Retrieve a timing's duration.
+ * @param  timing: Timing.
+ * @retval Duration (ticks).
+ */
+uint32_t profile_timing_get_ticks(const PROFILE_TIMING_t *timing);
+
+/**
+ * @brief  Plan a move to an absolute target (from the end of the last queued
+ *         move) to a timing (see profile_plan_timing) into the next free
+ *         queue slot, i.e. with the timing's segment durations whatever its
+ *         distance (a zero distance holds for the duration); the move is not
+ *         run until committed (see profile_commit).
+ * @note   The move is within the limits the timing was planned for if its
+ *         distance is not longer than the timing's.
+ * @param  gen:    Generator.
+ * @param  target: Target position (Q16.16).
+ * @param  timing: Timing.
+ * @param  blend:  Whether to start whilst the previous move decelerates.
+ * @retval Boolean indicating whether the move was planned: false if the
+ *         queue is full.
+ */
+bool profile_plan_timed(PROFILE_GEN_t *gen, int32_t target, const PROFILE_TIMING_t *timing, bool blend);
+
+/**
+ * @brief  Queue the move planned by profile_plan/profile_plan_timed.
+ * @param  gen: Generator.
+ * @retval None.
+ */
+void profile_commit(PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Step the generator by one tick and retrieve the position.
+ * @param  gen: Generator.
+ * @retval Position (Q16.16).
+ */
+int32_t profile_next(PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve the velocity at the last tick (see profile_next).
+ * @param  gen: Generator.
+ * @retval Velocity (units/s); zero when idle.
+ */
+float32_t profile_get_velocity(const PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve the acceleration at the last tick (see profile_next).
+ * @param  gen: Generator.
+ * @retval Acceleration (units/s^2); zero when idle.
+ */
+float32_t profile_get_acceleration(const PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve the position at the end of the last queued move (the
+ *         start of the next move planned).
+ * @param  gen: Generator.
+ * @retval Position (Q16.16).
+ */
+int32_t profile_get_end(const PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve the number of moves started (see profile_next); a
+ *         free-running count, not cleared by profile_reset.
+ * @param  gen: Generator.
+ * @retval Moves started.
+ */
+uint32_t profile_get_moves_started(const PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve whether the generator has queued/running moves.
+ * @param  gen: Generator.
+ * @retval Boolean indicating whether the generator is busy.
+ */
+bool profile_is_busy(const PROFILE_GEN_t *gen);
+
+/**
+ * @brief  Retrieve the number of free queue slots.
+ * @param  gen: Generator.
+ * @retval Free slots.
+ */
+uint32_t profile_get_queue_space(const PROFILE_GEN_t *gen);
+
+/*============================================================================*/
+
+#endif /* PROFILE_H ==========================================================*/
\ No newline at end of file
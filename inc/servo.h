@@ -1,18 +1,53 @@
 /*******************************************************************************
  * @file   servo.h
  * @brief  Servo motor control header file.
- * 
+ *
  *         Provides:
+ *             - Generic servo motor objects (see @ref SERVO_t); each servo is
+ *               driven by any PWM-capable timer channel (see @ref timer.h)
+ *               with its own position limits and calibration.
  *             - STM32 HAL timer/PWM initialisation.
- *             - Set servo motor shaft position (angle in degrees).
- *             - @todo
- *  
+ *             - Set servo motor shaft position (angle in degrees); the
+ *               position is applied to the PWM signal by the closed-loop
+ *               controller (see @ref servo_ctrl.h).
+ *             - Drive the PWM signal directly with a (fractional) angle
+ *               command, for one servo or all servos in the same PWM frame;
+ *               angles are converted to PWM pulse values via an integer
+ *               lookup table (see @ref servo_lut.h).
+ *             - Glitch-free synchronous PWM updates: pulse values are staged
+ *               in the timers' preload registers and latched together at the
+ *               next PWM frame boundary (update event); the frames of all
+ *               PWM timers are aligned such that TIM2's update event marks
+ *               the frame boundary for all servos.
+ *             - Optional DMA burst PWM updates (TIMER_PWM_DMA_BURST): pulse
+ *               values are written to a per-frame array and copied to all
+ *               channel registers of a timer by one DMA burst at the frame
+ *               boundary (see timer_pwm_dma_burst_start).
+ *             - PWM frame statistics (late/missed frame updates, CPU cycles
+ *               to write the pulses).
+ *             - Load a calibration (angle vs. pulse-width points).
+ *             - Position feedback: the *actual* shaft position, acquired from
+ *               the servo's potentiometer wiper via ADC1 + circular DMA with
+ *               hardware oversampling (see @ref adc.h) and converted to a
+ *               fixed-point angle block by block (see @ref servo_feedback.h);
+ *               readers never wait on a conversion. The acquisition is
+ *               triggered once per PWM frame at SERVO_FB_SAMPLE_OFFSET_US and
+ *               each sample is timestamped (CPU cycles).
+ *             - Position feedback filtering: each servo's raw samples are
+ *               conditioned block by block by a CMSIS-DSP filter (see @ref
+ *               filter.h) ahead of the conversion; the kernel is selectable
+ *               at run-time and its CPU cycles per block are measured.
+ *
  ******************************************************************************/
 
 #ifndef SERVO_H
 #define SERVO_H
 
 #include "main.h"
+#include "filter.h"
+#include "servo_feedback.h"
+#include "servo_lut.h"
+#include "timer.h"
 
 /*===== Defines ==============================================================*/
 
@@ -22,59 +57,337 @@
 #define SERVO_POSITION_MIN_DEG_UINT 0    /* == -90 degrees. */
 #define SERVO_POSITION_MAX_DEG_UINT 180  /* == +90 degrees. */
 
+/**
+ * Fixed-point position values (angle in degrees, Q16.16 format, i.e. a
+ * resolution of 1/65536 degrees); range (0..180) degrees as per the
+ * unsigned integer values above.
+ */
+#define SERVO_ANGLE_Q16_FRAC_BITS       16
+#define SERVO_ANGLE_Q16_ONE             (1L << SERVO_ANGLE_Q16_FRAC_BITS)
+#define SERVO_ANGLE_DEG_TO_Q16(deg)     ((SERVO_ANGLE_Q16_t)((deg) * SERVO_ANGLE_Q16_ONE))
+#define SERVO_ANGLE_Q16_TO_FLOAT(q)     ((float)(q) * (1.0f / SERVO_ANGLE_Q16_ONE))
+#define SERVO_POSITION_MIN_Q16          SERVO_ANGLE_DEG_TO_Q16(SERVO_POSITION_MIN_DEG_UINT)
+#define SERVO_POSITION_MAX_Q16          SERVO_ANGLE_DEG_TO_Q16(SERVO_POSITION_MAX_DEG_UINT)
+
+/* PWM frame rate (Hz), i.e. a 20 ms frame. */
+#define SERVO_PWM_FRAME_RATE_HZ         50
+
+/**
+ * Position feedback sample offset (us) from the PWM frame boundary: the ADC
+ * scan of all servos' potentiometer wipers is triggered at this fixed offset
+ * in every frame, e.g. after the longest (2.5 ms) pulse has fallen, such that
+ * every sample has a known phase relative to the actuation.
+ */
+#define SERVO_FB_SAMPLE_OFFSET_US       3000
+#if (SERVO_FB_SAMPLE_OFFSET_US < 1) || (SERVO_FB_SAMPLE_OFFSET_US >= (1000000 / SERVO_PWM_FRAME_RATE_HZ))
+#error "SERVO_FB_SAMPLE_OFFSET_US must be within the PWM frame."
+#endif
+
+/**
+ * Position feedback filter (see servo_set_feedback_filter): default kernel,
+ * 2nd order low-pass cut-off/quality factor, and an optional notch stage
+ * (e.g. at a mechanical resonance; centre 0 Hz = no notch stage). The sample
+ * rate is one sample per PWM frame.
+ */
+#define SERVO_FB_SAMPLE_RATE_HZ         SERVO_PWM_FRAME_RATE_HZ
+#define SERVO_FB_FILTER_DEFAULT         FILTER_TYPE__BIQUAD_F32
+#define SERVO_FB_LOWPASS_HZ             5.0f
+#define SERVO_FB_LOWPASS_Q              0.7071f
+#define SERVO_FB_NOTCH_HZ               0.0f
+#define SERVO_FB_NOTCH_Q                2.0f
+
+/* Number of servos in the system; must match SERVO_ID_t. */
+#define SERVO_NUM_SERVOS                6
+
+/*===== Typedefs =============================================================*/
+
+typedef int32_t SERVO_ANGLE_Q16_t; /* Angle in degrees, Q16.16 fixed-point. */
+
+/**
+ * @note: - Edit this enum to manage the publically available IDs for the
+ *          servos in the system.
+ *        - Concurrently add/remove relevant entries to/from _servos_config in
+ *          @ref servo.c as required (and update SERVO_NUM_SERVOS), ensuring
+ *          the ordering matches this enum.
+ */
+typedef enum SERVO_ID_t {
+    SERVO_ID__1, /* TIM2_CH1. */
+    SERVO_ID__2, /* TIM2_CH2. */
+    SERVO_ID__3, /* TIM2_CH3. */
+    SERVO_ID__4, /* TIM2_CH4. */
+    SERVO_ID__5, /* TIM15_CH1. */
+    SERVO_ID__6  /* TIM16_CH1. */
+} SERVO_ID_t;
+
+typedef struct SERVO_CONFIG_t {
+    TIMER_PWM_ID_t timer;   /* PWM timer; see @ref TIMER_PWM_ID_t. */
+    uint32_t channel;       /* Timer channel; TIM_CHANNEL_x. */
+    GPIO_TypeDef *port;     /* PWM output port; GPIOx. */
+    uint16_t pin;           /* PWM output pin; GPIO_PIN_x. */
+    uint32_t alternate;     /* PWM output alternate function; GPIO_AFx_y. */
+    uint8_t angle_min;      /* Minimum position limit in degrees (0..180). */
+    uint8_t angle_max;      /* Maximum position limit in degrees (0..180). */
+    GPIO_TypeDef *fb_port;  /* Position feedback (potentiometer wiper) input port; GPIOx. */
+    uint16_t fb_pin;        /* Position feedback input pin; GPIO_PIN_x. */
+    uint32_t fb_channel;    /* Position feedback ADC1 channel; ADC_CHANNEL_x. */
+} SERVO_CONFIG_t;
+
+typedef struct SERVO_t {
+    const SERVO_CONFIG_t *config;             /* Hardware configuration and limits. */
+    volatile uint32_t *ccr;                   /* PWM pulse destination: TIMx_CCRy register, or its entry in the timer's DMA burst frame. */
+    uint32_t frame_counts;                    /* PWM period in timer counts. */
+    SERVO_ANGLE_Q16_t angle_min;              /* Minimum position limit. */
+    SERVO_ANGLE_Q16_t angle_max;              /* Maximum position limit. */
+    const SERVO_LUT_t * volatile lut;         /* Angle to PWM pulse LUT in use. */
+    SERVO_LUT_t lut_calibrated;               /* LUT built from calibration points. */
+    volatile SERVO_ANGLE_Q16_t angle_expected;/* Expected position (setpoint). */
+} SERVO_t;
+
+typedef struct SERVO_FRAME_STATS_t {
+    uint32_t frame_count;       /* Number of PWM frames (update events). */
+    uint32_t late_count;        /* Staged pulses that straddled a frame boundary (latched one frame late). */
+    uint32_t missed_count;      /* PWM frames in which no new pulses were staged. */
+    uint32_t write_cycles_last; /* CPU cycles to write all servos' pulses (servo_set_pwm_angles_q16), last. */
+    uint32_t write_cycles_max;  /* CPU cycles to write all servos' pulses (servo_set_pwm_angles_q16), maximum. */
+} SERVO_FRAME_STATS_t;
+
+typedef struct SERVO_FB_STATS_t {
+    uint32_t block_count;        /* Number of position feedback blocks processed. */
+    uint32_t samples_per_block;  /* Samples (all servos) in the last block. */
+    uint32_t filter_cycles_last; /* CPU cycles to filter the last block (all servos). */
+    uint32_t filter_cycles_max;  /* Maximum CPU cycles to filter a block (all servos). */
+} SERVO_FB_STATS_t;
+
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
 /*============================================================================*/
 
 /**
- * @brief  Servo motor initialisation:
- *             - PWM initialisation.
- *             - @todo
+ * @brief  Servo motor initialisation (all servos):
+ *             - PWM timer, channel, and GPIO initialisation.
+ *             - Angle to PWM pulse LUT selection (nominal calibration).
  * @retval None.
  */
 void servo_init(void);
 
 /**
- * @brief  Set PWM signal to the servo motor (on/off).
+ * @brief  Set PWM signal to a servo motor (on/off).
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
  * @param  state: PWM signal state to set where true|false = on|off.
  * @retval None.
  */
-void servo_set_signal(bool state);
+void servo_set_signal(SERVO_ID_t id, bool state);
+
+/**
+ * @brief  Set PWM signal to all servo motors (on/off).
+ * @note   When turned on, the frames of all PWM timers are restarted together
+ *         (see timer_pwm_sync) and the PWM frame interrupt is enabled (see
+ *         servo_frame_update).
+ * @param  state: PWM signal state to set where true|false = on|off.
+ * @retval None.
+ */
+void servo_set_signal_all(bool state);
 
 /**
  * @brief  Set servo motor shaft position (angle in degrees).
- * @param  angle: Angle in degrees (0..180).
+ * @note   The position is recorded as the control loop setpoint; the control
+ *         loop (see @ref servo_ctrl.h) writes the resulting PWM pulse.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  angle: Angle in degrees (0..180), limited to the servo's limits.
  * @retval None.
  */
-void servo_set_position(uint8_t angle);
+void servo_set_position(SERVO_ID_t id, uint8_t angle);
 
 /**
- * @brief  Retrieve the *expected* servo motor shaft position (angle in degrees).
- * @param  angle: Angle in degrees (0..180).
+ * @brief  Set servo motor shaft position (angle in degrees, fixed-point) for
+ *         sub-degree position commands.
+ * @note   The position is recorded as the control loop setpoint; the control
+ *         loop (see @ref servo_ctrl.h) writes the resulting PWM pulse.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  angle: Angle in degrees (0..180), Q16.16 fixed-point, limited to the
+ *                servo's limits.
+ * @retval None.
+ */
+void servo_set_position_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t angle);
+
+/**
+ * @brief  Drive the PWM signal with an angle command (i.e. the controller
+ *         output), bypassing the setpoint.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  angle: Angle in degrees (0..180), fractions of a degree permitted.
+ * @retval None.
+ */
+void servo_set_pwm_angle(SERVO_ID_t id, float angle);
+
+/**
+ * @brief  Drive the PWM signal with an angle command (fixed-point).
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  angle: Angle in degrees (0..180), Q16.16 fixed-point.
+ * @retval None.
+ */
+void servo_set_pwm_angle_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t angle);
+
+/**
+ * @brief  Drive the PWM signals of all servos with angle commands for the
+ *         same PWM frame: all pulse values are computed first, then all
+ *         TIMx_CCRy (preload) registers are written back-to-back with
+ *         interrupts disabled and the timers' update events held, such that
+ *         all pulses are latched at the same (next) frame boundary. In DMA
+ *         burst mode (TIMER_PWM_DMA_BURST) the per-frame arrays are written
+ *         instead and the DMA bursts at the frame boundary latch them.
+ * @note   Should the frame boundary pass whilst the update events are held,
+ *         that boundary's update event (and frame interrupt) is lost: the
+ *         pulses are latched at the following boundary, the write is counted
+ *         as late and the boundary as a missed frame. The frames are not
+ *         restarted, i.e. the PWM phase and the feedback sample instant are
+ *         kept.
+ * @param  angles: Angles in degrees (0..180), Q16.16 fixed-point, indexed by
+ *                 SERVO_ID_t.
+ * @retval Boolean indicating whether the pulses were written within the frame
+ *         (latched at the next boundary); false if a boundary passed without
+ *         its frame interrupt.
+ */
+bool servo_set_pwm_angles_q16(const SERVO_ANGLE_Q16_t angles[SERVO_NUM_SERVOS]);
+
+/**
+ * @brief  PWM frame update; records the frame statistics.
+ * @note   IMPORTANT: Intended to be called from the PWM frame interrupt only
+ *         (see timer_tim2_period_elapsed_callback).
+ * @retval None.
+ */
+void servo_frame_update(void);
+
+/**
+ * @brief  Retrieve a snapshot of the PWM frame statistics.
+ * @param  stats: Statistics. Passed by reference.
+ * @retval None.
+ */
+void servo_get_frame_stats(SERVO_FRAME_STATS_t *stats);
+
+/**
+ * @brief  Reset the PWM frame statistics.
+ * @retval None.
+ */
+void servo_reset_frame_stats(void);
+
+/**
+ * @brief  Load a calibration (angle vs. pulse-width) in place of the nominal
+ *         0.5/1.5/2.5 ms pulse-widths; the angle to PWM pulse LUT is rebuilt
+ *         from the calibration points (see @ref servo_lut.h).
+ * @param  id:         Servo ID; see @ref SERVO_ID_t.
+ * @param  points:     Calibration points sorted by ascending angle, or NULL to
+ *                     revert to the nominal (compile-time) LUT.
+ * @param  num_points: Number of calibration points (>= 2).
+ * @retval Boolean indicating whether the calibration was loaded; the nominal
+ *         LUT remains in use if not.
+ */
+bool servo_set_calibration(SERVO_ID_t id, const SERVO_CAL_POINT_t *points, uint32_t num_points);
+
+/**
+ * @brief  Load a position feedback calibration in place of the nominal
+ *         calibration (SERVO_FB_RAW_AT_0_DEG/SERVO_FB_RAW_AT_180_DEG).
+ * @param  id:         Servo ID; see @ref SERVO_ID_t.
+ * @param  raw_at_0:   Raw ADC value (0..ADC_RESULT_MAX) at 0 degrees.
+ * @param  raw_at_180: Raw ADC value (0..ADC_RESULT_MAX) at 180 degrees.
+ * @retval Boolean indicating whether the calibration was loaded.
+ */
+bool servo_set_feedback_calibration(SERVO_ID_t id, uint16_t raw_at_0, uint16_t raw_at_180);
+
+/**
+ * @brief  Process a block of position feedback samples (all servos).
+ * @note   IMPORTANT: Intended to be called from the ADC DMA interrupt only
+ *         (see adc_block_ready_callback).
+ * @param  samples:   Raw ADC samples, interleaved by scan in SERVO_ID_t order.
+ * @param  num_scans: Number of scans in the block.
  * @retval None.
  */
-uint8_t servo_get_angle_expected(void);
-
-/**
- * @brief  Test function: oscillate servo motor shaft position (angle in 
- *         degrees) between two specified angles.
- * 
- *         Each single call of this function moves the position one (1) degree;
- *         as such, the user project should call this function periodically,
- *         for example, in an RTOS task with a task delay after each call.
- * 
- *         The position will start at 0 degrees, then oscillate between 
- *         the specified angles.
- * 
- *         If running the test with new parameters or after stopping: call this
- *         function once with @param reset set to true, then run the new test.
- * 
- * @param  angle_start: Starting angle in degrees (0..180).
- * @param  angle_end:   Starting angle in degrees (0..180).
- * @param  reset:       Boolean to reset the test, see @brief. Default: false.
+void servo_process_feedback(const uint16_t *samples, uint32_t num_scans);
+
+/**
+ * @brief  Select the position feedback filter kernel (all servos); the
+ *         filters are reset and their coefficients derived from
+ *         SERVO_FB_LOWPASS_HZ/SERVO_FB_NOTCH_HZ (biquads) or a fixed
+ *         low-pass (FIR). Feedback is not updated until the filters have
+ *         settled.
+ * @param  type: Filter kernel; see @ref FILTER_TYPE_t.
+ * @retval Boolean indicating whether the filter was selected.
+ */
+bool servo_set_feedback_filter(FILTER_TYPE_t type);
+
+/**
+ * @brief  Retrieve the position feedback filter kernel in use.
+ * @retval Filter kernel; see @ref FILTER_TYPE_t.
+ */
+FILTER_TYPE_t servo_get_feedback_filter(void);
+
+/**
+ * @brief  Retrieve a snapshot of the position feedback statistics.
+ * @param  stats: Statistics. Passed by reference.
+ * @retval None.
+ */
+void servo_get_feedback_stats(SERVO_FB_STATS_t *stats);
+
+/**
+ * @brief  Reset the position feedback statistics.
  * @retval None.
  */
-void servo_test_oscillate(uint8_t angle_start, uint8_t angle_end, bool reset);
+void servo_reset_feedback_stats(void);
+
+/**
+ * @brief  Retrieve the timestamp of the last position feedback sample, i.e.
+ *         the time at which its ADC scan was triggered.
+ * @retval CPU cycle count (see CYCLE_COUNTER_GET).
+ */
+uint32_t servo_get_feedback_timestamp(void);
+
+/**
+ * @brief  Retrieve the position limits of a servo.
+ * @param  id:        Servo ID; see @ref SERVO_ID_t.
+ * @param  angle_min: Minimum angle, Q16.16 fixed-point. Passed by reference.
+ * @param  angle_max: Maximum angle, Q16.16 fixed-point. Passed by reference.
+ * @retval None.
+ */
+void servo_get_limits_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t *angle_min, SERVO_ANGLE_Q16_t *angle_max);
+
+/**
+ * @brief  Retrieve the *expected* servo motor shaft position (angle in degrees).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Angle in degrees (0..180), rounded to the nearest degree.
+ */
+uint8_t servo_get_angle_expected(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve the *expected* servo motor shaft position (angle in
+ *         degrees, fixed-point).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Angle in degrees (0..180), Q16.16 fixed-point.
+ */
+SERVO_ANGLE_Q16_t servo_get_angle_expected_q16(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve the *actual* servo motor shaft position (angle in degrees)
+ *         from the position feedback.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Angle in degrees (0..180), rounded to the nearest degree.
+ */
+uint8_t servo_get_angle_actual(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve the *actual* servo motor shaft position (angle in
+ *         degrees, fixed-point) from the position feedback.
+ * @note   The last valid value is returned; see servo_get_feedback_valid.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Angle in degrees (0..180), Q16.16 fixed-point.
+ */
+SERVO_ANGLE_Q16_t servo_get_angle_actual_q16(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve whether the position feedback of a servo is valid (i.e.
+ *         the last block of samples was within the calibrated range).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Boolean indicating validity.
+ */
+bool servo_get_feedback_valid(SERVO_ID_t id);
 
 /*============================================================================*/
 
@@ -0,0 +1,1017 @@
+/*******************************************************************************
+ * @file   servo_ctrl.h
+ * @brief  Servo motor closed-loop control header file.
+ *
+ *         Provides:
+ *             - A PID position controller (see @ref pid.h) per servo executed
+ *               from the TIM6 update interrupt at a fixed rate
+ *               (SERVO_CTRL_LOOP_RATE_HZ), or a cascaded controller (see
+ *               servo_ctrl_set_loop_type): an outer position loop at
+ *               SERVO_CTRL_POS_LOOP_RATE_HZ feeding an inner velocity loop
+ *               at SERVO_CTRL_LOOP_RATE_HZ, with velocity and acceleration
+ *               feedforward from the motion profile generator.
+ *             - A model predictive controller option (see @ref mpc.h): the
+ *               command of each servo is optimised once per PWM frame over
+ *               a short horizon of its model, subject to the command range,
+ *               command slew and the servo's position limits (see
+ *               servo_ctrl_set_loop_type). The servos are solved in turn,
+ *               one per loop iteration in the last SERVO_NUM_SERVOS
+ *               iterations of a frame, such that the worst case solve of one
+ *               servo (not all) adds to an iteration's execution time.
+ *             - The controller outputs (angle commands) of all servos are
+ *               written to the PWM signals for the same frame via
+ *               servo_set_pwm_angles_q16, limited to each servo's limits
+ *               (see servo_get_limits_q16) and slew limited
+ *               (SERVO_CTRL_SLEW_DEG_S). The controllers are limited to the
+ *               remaining headroom, such that their integrators do not wind
+ *               up at the stops (see pid_set_actuator_limits).
+ *             - The control loop is phase-locked to the 20 ms PWM frame: it
+ *               is started at a PWM frame boundary (see servo_ctrl_frame_sync)
+ *               with its iterations offset to finish SERVO_CTRL_FRAME_LEAD_US
+ *               before each frame boundary; as TIM6 and the PWM timers share
+ *               the 80 MHz clock, the phase is then held.
+ *             - A motion profile generator per servo (see @ref profile.h):
+ *               queued trapezoidal/S-curve moves are evaluated every loop
+ *               iteration and written to the setpoint (see servo_ctrl_move).
+ *             - Coordinated moves of all servos (see @ref coord.h): one move
+ *               per servo's motion profile generator to one timing, such
+ *               that all servos start and finish together on a straight
+ *               line in joint space, the slowest servo setting the duration
+ *               (see servo_ctrl_move_coordinated). The generators are
+ *               stepped in one pass of the loop, i.e. in lock-step.
+ *             - Relay feedback auto-tuning of a servo's PID controller (see
+ *               @ref autotune.h): the controller output is replaced by a
+ *               relay about the held setpoint until the ultimate gain and
+ *               period are measured, then the tuned gains are loaded into
+ *               the running controller (see servo_ctrl_autotune_start).
+ *             - System identification of a servo (see @ref sysid.h): a chirp
+ *               or PRBS excitation is added to the held setpoint in place of
+ *               the controller output, once per feedback sample, and the
+ *               captured frequency response is computed on request from a
+ *               task (see servo_ctrl_sysid_start).
+ *             - Gain scheduling (see @ref gain_sched.h): the active
+ *               controller's gains and feedforward are scaled every loop
+ *               iteration by a table indexed by each servo's position and
+ *               estimated load (the low-pass filtered controller correction),
+ *               loadable at runtime (see servo_ctrl_gain_sched_commit).
+ *             - Input shaping (see @ref shaper.h): each servo's setpoint
+ *               (from the motion profiles or stream) is convolved with a
+ *               ZV, ZVD or EI shaper every loop iteration ahead of the
+ *               controller, such that a vibration mode of its linkage is not
+ *               excited (see servo_ctrl_set_shaper).
+ *             - Iterative learning control (see @ref ilc.h) of repeated
+ *               motion cycles: a repetition starts every N moves of a
+ *               servo's motion profile, and a feedforward correction per PWM
+ *               frame of the cycle, learnt from the previous repetitions'
+ *               tracking error, is added to the PID or cascaded controller's
+ *               command. The control loop only records the error and applies
+ *               the correction; the correction is learnt by a low priority
+ *               task between cycles (see servo_ctrl_ilc_process). The tables
+ *               are in SRAM2.
+ *             - Friction compensation (see @ref friction.h) of a servo's
+ *               gearbox under the PID or cascaded controller: a model based
+ *               Coulomb, breakaway and viscous friction offset and a
+ *               disturbance observer's estimate are added to the command,
+ *               and within a hold band at standstill the controller's error
+ *               is zeroed (its integrator held), such that the servo does
+ *               not hunt about a held position. The parameters are
+ *               identified by an open-loop triangle sweep (see
+ *               servo_ctrl_friction_id_start) or loaded (see
+ *               servo_ctrl_friction_set_params).
+ *             - Adaptive feedforward (see @ref lms_ff.h) of a servo under
+ *               the PID or cascaded controller: an inverse model of the
+ *               servo, a FIR filter of the setpoint's increments per PWM
+ *               frame, is added to the command and adapted online
+ *               (normalised LMS) from the tracking error, such that it
+ *               follows the servo's dynamics as its load and temperature
+ *               change. The control loop only records the blocks of frames
+ *               and applies the filter; the adaptation runs in a low
+ *               priority task (see servo_ctrl_lms_process), and can be
+ *               frozen (see servo_ctrl_lms_freeze).
+ *             - A setpoint stream (see @ref stream.h): timestamped waypoints of
+ *               all servos from a host planner, interpolated every loop
+ *               iteration and written to the setpoints; takes precedence over
+ *               the motion profiles whilst active (see
+ *               servo_ctrl_stream_push).
+ *             - Inverse kinematics (see @ref ik.h) of the setpoint stream:
+ *               with a Cartesian stream enabled, the first channels of the
+ *               waypoints are an arm's Cartesian target, interpolated (in
+ *               Cartesian space, i.e. straight between waypoints) and solved
+ *               to the arm's joint angles every loop iteration, the joints
+ *               driving the first servos (see servo_ctrl_ik_enable). The
+ *               host streams the target, not the joint angles.
+ *             - A state estimator per servo (see @ref estimator.h): position,
+ *               velocity and acceleration estimates every loop iteration,
+ *               corrected by each new feedback sample. The velocity estimate
+ *               is the PID derivative source (derivative on measurement) and
+ *               drives motion detection (see servo_ctrl_is_moving).
+ *             - A motor health monitor per servo (see @ref motor_health.h):
+ *               stall, overload and feedback loss are detected within a
+ *               configured number of control periods, and a detected fault
+ *               cuts the servo's PWM signal (see servo_set_signal) and sets
+ *               the motor error operational mode from the control loop
+ *               itself, not the operational mode task. The latency from the
+ *               fault condition's onset to the PWM signal cut is measured
+ *               (see servo_ctrl_get_fault).
+ *             - Loop statistics: rate/jitter (period min/max), execution time,
+ *               tracking error, phase slips (iterations per frame), and the
+ *               feedback sample to actuation latency (from the sample's ADC
+ *               trigger to the frame boundary at which the output computed
+ *               from it is latched), estimator, motion profile, coordinated
+ *               move planning, setpoint stream, inverse kinematics, MPC, friction compensation and adaptive
+ *               feedforward execution times,
+ *               and per servo the loops saturated at its limits or by the
+ *               slew limit.
+ *
+ *         The setpoint is the *expected* angle (see servo_set_position and
+ *         servo_set_position_q16); the feedback is the *actual* angle (see
+ *         servo_ctrl_get_feedback). When no valid position feedback is
+ *         available the loop runs open-loop and writes the setpoint
+ *         directly.
+ *
+ ******************************************************************************/
+
+#ifndef SERVO_CTRL_H
+#define SERVO_CTRL_H
+
+#include "main.h"
+#include "autotune.h"
+#include "coord.h"
+#include "estimator.h"
+#include "friction.h"
+#include "gain_sched.h"
+#include "ik.h"
+#include "ilc.h"
+#include "lms_ff.h"
+#include "motor_health.h"
+#include "mpc.h"
+#include "profile.h"
+#include "shaper.h"
+#include "servo.h"
+#include "stream.h"
+#include "sysid.h"
+
+/*===== Defines ==============================================================*/
+
+/* Control loop rate (Hz); configurable in the range (1..5) kHz. */
+#define SERVO_CTRL_LOOP_RATE_HZ     1000
+#if (SERVO_CTRL_LOOP_RATE_HZ < 1000) || (SERVO_CTRL_LOOP_RATE_HZ > 5000)
+#error "SERVO_CTRL_LOOP_RATE_HZ must be in the range (1000..5000) Hz."
+#endif
+#if (SERVO_CTRL_LOOP_RATE_HZ % SERVO_PWM_FRAME_RATE_HZ) != 0
+#error "SERVO_CTRL_LOOP_RATE_HZ must be a multiple of SERVO_PWM_FRAME_RATE_HZ."
+#endif
+#define SERVO_CTRL_LOOP_PERIOD_S    (1.0f / SERVO_CTRL_LOOP_RATE_HZ)
+#define SERVO_CTRL_LOOPS_PER_FRAME  (SERVO_CTRL_LOOP_RATE_HZ / SERVO_PWM_FRAME_RATE_HZ)
+
+/**
+ * Time (us) between a control loop iteration and the following PWM frame
+ * boundary; must exceed the loop execution time such that the last iteration
+ * of a frame is latched at the frame boundary, and be less than the loop
+ * period.
+ */
+#define SERVO_CTRL_FRAME_LEAD_US    100
+#if (SERVO_CTRL_FRAME_LEAD_US >= (1000000 / SERVO_CTRL_LOOP_RATE_HZ))
+#error "SERVO_CTRL_FRAME_LEAD_US must be less than the control loop period."
+#endif
+
+/* PID gains and output (correction) limits in degrees. */
+#define SERVO_CTRL_PID_KP           0.5f
+#define SERVO_CTRL_PID_KI           5.0f
+#define SERVO_CTRL_PID_KD           0.0f
+#define SERVO_CTRL_PID_OUTPUT_MIN   (-30.0f)
+#define SERVO_CTRL_PID_OUTPUT_MAX   30.0f
+
+/**
+ * Cascaded controller. Outer position loop: rate (Hz; a divisor of
+ * SERVO_CTRL_LOOP_RATE_HZ), gains and velocity reference limits (degrees/s).
+ * Inner velocity loop (at SERVO_CTRL_LOOP_RATE_HZ): gains and output
+ * (correction) limits in degrees.
+ */
+#define SERVO_CTRL_POS_LOOP_RATE_HZ     250
+#if (SERVO_CTRL_POS_LOOP_RATE_HZ < SERVO_PWM_FRAME_RATE_HZ) || (SERVO_CTRL_POS_LOOP_RATE_HZ > SERVO_CTRL_LOOP_RATE_HZ)
+#error "SERVO_CTRL_POS_LOOP_RATE_HZ must be in the range (SERVO_PWM_FRAME_RATE_HZ..SERVO_CTRL_LOOP_RATE_HZ) Hz."
+#endif
+#if (SERVO_CTRL_LOOP_RATE_HZ % SERVO_CTRL_POS_LOOP_RATE_HZ) != 0
+#error "SERVO_CTRL_POS_LOOP_RATE_HZ must be a divisor of SERVO_CTRL_LOOP_RATE_HZ."
+#endif
+#define SERVO_CTRL_LOOPS_PER_POS_UPDATE (SERVO_CTRL_LOOP_RATE_HZ / SERVO_CTRL_POS_LOOP_RATE_HZ)
+#define SERVO_CTRL_POS_KP               15.0f
+#define SERVO_CTRL_POS_KI               0.0f
+#define SERVO_CTRL_POS_VEL_MIN          (-500.0f)
+#define SERVO_CTRL_POS_VEL_MAX          500.0f
+#define SERVO_CTRL_VEL_KP               0.005f
+#define SERVO_CTRL_VEL_KI               0.25f
+#define SERVO_CTRL_VEL_OUTPUT_MIN       (-30.0f)
+#define SERVO_CTRL_VEL_OUTPUT_MAX       30.0f
+
+/**
+ * Cascaded controller feedforward gains: command += FF_VEL_S x profile
+ * velocity + FF_ACC_S2 x profile acceleration. For a servo (internal loop)
+ * modelled as 2nd order with natural frequency wn and damping zeta, 2 zeta /
+ * wn and 1 / wn^2 (here wn = 2 pi 6 Hz, zeta = 0.8), the velocity term
+ * extended to cover part of the PWM frame hold.
+ */
+#define SERVO_CTRL_FF_VEL_S             0.045f
+#define SERVO_CTRL_FF_ACC_S2            0.0007f
+
+/**
+ * Command (PWM output) slew limit (degrees/s): the latched command changes by
+ * at most SERVO_CTRL_SLEW_DEG_S / SERVO_PWM_FRAME_RATE_HZ per PWM frame. The
+ * controllers are limited to the headroom left by it and the servo's limits
+ * (anti-windup; see pid_set_actuator_limits).
+ */
+#define SERVO_CTRL_SLEW_DEG_S           600.0f
+
+/**
+ * Model predictive controller: servo model (as the feedforward's; natural
+ * frequency in Hz), cost weights (position error, command relative to the
+ * setpoint, command moves), observer gains (position, velocity and
+ * disturbance corrections per degree of innovation) and command slew limit
+ * (degrees/s; the servo's speed, such that it is driven within the model's
+ * linear range). The step is the PWM frame period.
+ */
+#define SERVO_CTRL_MPC_WN_HZ            6.0f
+#define SERVO_CTRL_MPC_ZETA             0.8f
+#define SERVO_CTRL_MPC_Q                1.0f
+#define SERVO_CTRL_MPC_R                0.01f
+#define SERVO_CTRL_MPC_S                1.0f
+#define SERVO_CTRL_MPC_L_POS            0.3f
+#define SERVO_CTRL_MPC_L_VEL            0.0f
+#define SERVO_CTRL_MPC_L_DIST           0.1f
+#define SERVO_CTRL_MPC_SLEW_DEG_S       450.0f
+#if (SERVO_CTRL_LOOPS_PER_FRAME < SERVO_NUM_SERVOS)
+#error "SERVO_CTRL_LOOPS_PER_FRAME must be at least SERVO_NUM_SERVOS (one MPC solve per loop iteration)."
+#endif
+
+/* Controller structure at start-up; see @ref SERVO_CTRL_LOOP_TYPE_t. */
+#define SERVO_CTRL_LOOP_TYPE_DEFAULT    SERVO_CTRL_LOOP_TYPE__PID
+
+/**
+ * State estimator (degrees): predicted every loop iteration, corrected once
+ * per feedback sample (one per PWM frame). Alpha-beta-gamma gains, or Kalman
+ * jerk noise density (deg^2/s^5), measurement variance (deg^2) and initial
+ * velocity/acceleration variances.
+ */
+#define SERVO_CTRL_EST_TYPE             ESTIMATOR_TYPE__KALMAN
+#define SERVO_CTRL_EST_ALPHA            0.5f
+#define SERVO_CTRL_EST_BETA             0.17f
+#define SERVO_CTRL_EST_GAMMA            0.03f
+#define SERVO_CTRL_EST_PROCESS_NOISE    1.0e5f
+#define SERVO_CTRL_EST_MEAS_NOISE       0.25f
+#define SERVO_CTRL_EST_INIT_VAR_VEL     1.0e4f
+#define SERVO_CTRL_EST_INIT_VAR_ACC     1.0e6f
+
+/* Default motion profile limits (degrees). */
+#define SERVO_CTRL_MOVE_VELOCITY_DEG_S  180.0f
+#define SERVO_CTRL_MOVE_ACCEL_DEG_S2    1000.0f
+#define SERVO_CTRL_MOVE_JERK_DEG_S3     20000.0f
+#if (SERVO_NUM_SERVOS > COORD_MAX_AXES)
+#error "SERVO_NUM_SERVOS must not exceed COORD_MAX_AXES (coordinated moves)."
+#endif
+
+/**
+ * Relay feedback auto-tuning: relay amplitude and hysteresis (degrees; the
+ * hysteresis above the feedback noise), settling/measured/maximum cycles,
+ * timeout between relay switches (s) and tuning rule.
+ */
+#define SERVO_CTRL_AUTOTUNE_AMPLITUDE_DEG   5.0f
+#define SERVO_CTRL_AUTOTUNE_HYSTERESIS_DEG  0.5f
+#define SERVO_CTRL_AUTOTUNE_SETTLE_CYCLES   2
+#define SERVO_CTRL_AUTOTUNE_MEASURE_CYCLES  3
+#define SERVO_CTRL_AUTOTUNE_MAX_CYCLES      12
+#define SERVO_CTRL_AUTOTUNE_TIMEOUT_S       2.0f
+#define SERVO_CTRL_AUTOTUNE_RULE            AUTOTUNE_RULE__ZN_PI
+
+/**
+ * System identification: excitation amplitude (degrees), chirp frequency
+ * range (Hz; below half the feedback sample rate), PRBS bit hold (samples),
+ * and settling/averaged periods of SYSID_LEN feedback samples, i.e. a run
+ * takes (settle + averaged) x SYSID_LEN / SERVO_FB_SAMPLE_RATE_HZ seconds.
+ */
+#define SERVO_CTRL_SYSID_AMPLITUDE_DEG      5.0f
+#define SERVO_CTRL_SYSID_F_MIN_HZ           0.2f
+#define SERVO_CTRL_SYSID_F_MAX_HZ           12.0f
+#define SERVO_CTRL_SYSID_PRBS_HOLD          1
+#define SERVO_CTRL_SYSID_SETTLE_PERIODS     1
+#define SERVO_CTRL_SYSID_PERIODS            4
+
+/**
+ * Gain scheduling: the load term's low-pass filter time constant (s), the
+ * scale factors' smoothing time constant (s; such that a table swap or a
+ * step across the table ramps the gains), and the default load axis maximum
+ * (degrees of controller correction). The default position axis is the
+ * servo position range.
+ */
+#define SERVO_CTRL_LOAD_TAU_S               0.1f
+#define SERVO_CTRL_GAIN_SCHED_TAU_S         0.05f
+#define SERVO_CTRL_GAIN_SCHED_LOAD_MAX_DEG  10.0f
+
+/**
+ * Input shaping: the shaper applied at initialisation, its mode frequency (Hz)
+ * and damping ratio (see servo_ctrl_set_shaper), and the longest shaper (ms),
+ * which sizes each servo's delay line (one float per loop iteration).
+ */
+#define SERVO_CTRL_SHAPER_TYPE_DEFAULT  SHAPER_TYPE__NONE
+#define SERVO_CTRL_SHAPER_FREQ_HZ       5.0f
+#define SERVO_CTRL_SHAPER_ZETA          0.05f
+#define SERVO_CTRL_SHAPER_MAX_MS        400
+#define SERVO_CTRL_SHAPER_MAX_DELAY     ((SERVO_CTRL_SHAPER_MAX_MS * SERVO_CTRL_LOOP_RATE_HZ) / 1000)
+#if (SERVO_CTRL_SHAPER_MAX_DELAY > UINT16_MAX)
+#error "SERVO_CTRL_SHAPER_MAX_DELAY must not exceed UINT16_MAX loop iterations."
+#endif
+
+/**
+ * Iterative learning control: one table sample per PWM frame (the feedback
+ * rate), i.e. a cycle of up to ILC_MAX_SAMPLES frames; the learning gain, the
+ * lead (frames; the command latch and the servo's lag), the forgetting factor
+ * and the correction's full scale (degrees).
+ */
+#define SERVO_CTRL_ILC_GAIN             0.5f
+#define SERVO_CTRL_ILC_LEAD             2
+#define SERVO_CTRL_ILC_FORGET           0.98f
+#define SERVO_CTRL_ILC_RANGE_DEG        32.0f
+
+/**
+ * Friction compensation: disturbance observer gains (per degree of innovation;
+ * stepped per feedback sample on the MPC's servo model) and estimate limit
+ * (degrees), the offset's ramp (degrees per degree of error) and the
+ * reference velocity's lead (s) in its direction, the standstill speed
+ * (degrees/s) and the hold band (degrees; above the feedback noise and the
+ * slip of a breakaway).
+ */
+#define SERVO_CTRL_FRICTION_L_POS           0.3f
+#define SERVO_CTRL_FRICTION_L_VEL           0.0f
+#define SERVO_CTRL_FRICTION_L_DIST          0.05f
+#define SERVO_CTRL_FRICTION_DIST_MAX_DEG    10.0f
+#define SERVO_CTRL_FRICTION_SLOPE           3.0f
+#define SERVO_CTRL_FRICTION_LEAD_S          0.02f
+#define SERVO_CTRL_FRICTION_STILL_DEG_S     2.0f
+#define SERVO_CTRL_FRICTION_HOLD_BAND_DEG   0.3f
+
+/**
+ * Friction identification: triangle amplitude about the held setpoint
+ * (degrees), slowest and fastest of the FRICTION_ID_SPEEDS sweep speeds
+ * (degrees/s), settling after each reversal (s), and the travel (degrees)
+ * beyond which the servo has moved off after a reversal. A run takes
+ * 4 x amplitude / speed per speed, i.e. about 14 s.
+ */
+#define SERVO_CTRL_FRICTION_ID_AMPLITUDE_DEG    10.0f
+#define SERVO_CTRL_FRICTION_ID_SPEED_MIN_DEG_S  5.0f
+#define SERVO_CTRL_FRICTION_ID_SPEED_MAX_DEG_S  60.0f
+#define SERVO_CTRL_FRICTION_ID_SETTLE_S         0.3f
+#define SERVO_CTRL_FRICTION_ID_TRAVEL_DEG       0.1f
+
+/**
+ * Adaptive feedforward: one update per PWM frame (the feedback rate); the
+ * adaptation kernel and the Q31 kernel's full scale (degrees; the reference's
+ * increments within half of it, 7.8 degrees per frame), the normalised
+ * adaptation step, the input window energy of half the step (degrees
+ * squared; about 0.3 degrees per frame, i.e. 16 degrees/s), the coefficient
+ * leakage per block, the output limit (degrees) and the lead (frames; the
+ * command latch and the servo's lag).
+ *
+ * A pair is recorded per frame, i.e. per ADC DMA half/full transfer (one
+ * trigger per frame, of ADC_SCANS_PER_BLOCK scans), and adapted from per
+ * LMS_FF_BLOCK_SIZE (whole DMA blocks): adapting per DMA block, a single
+ * pair, would take the task a kernel call per frame with nothing amortised
+ * and wake it at the frame rate; a block of 160 ms is taken in time by
+ * servo_ctrl_lms_process at its 20 ms period.
+ */
+#define SERVO_CTRL_LMS_KERNEL           LMS_FF_KERNEL__F32
+#define SERVO_CTRL_LMS_RANGE_DEG        16.0f
+#define SERVO_CTRL_LMS_MU               0.05f
+#define SERVO_CTRL_LMS_ENERGY_MIN       0.1f
+#define SERVO_CTRL_LMS_LEAK             0.005f
+#define SERVO_CTRL_LMS_OUTPUT_MAX_DEG   20.0f
+#define SERVO_CTRL_LMS_LEAD             2
+
+/* Setpoint stream interpolation; see @ref STREAM_INTERP_t. */
+#define SERVO_CTRL_STREAM_INTERP        STREAM_INTERP__CUBIC
+#if (SERVO_NUM_SERVOS > STREAM_MAX_AXES)
+#error "SERVO_NUM_SERVOS must not exceed STREAM_MAX_AXES."
+#endif
+
+/**
+ * Inverse kinematics of the setpoint stream: default arm, link lengths
+ * (units of the streamed target, e.g. mm), elbow configuration, and the
+ * servo angle at each joint's zero angle (degrees; joint i drives servo i,
+ * the angle increasing with the joint's).
+ */
+#define SERVO_CTRL_IK_ARM               IK_ARM__PLANAR_2
+#define SERVO_CTRL_IK_LENGTH_1          100.0f
+#define SERVO_CTRL_IK_LENGTH_2          100.0f
+#define SERVO_CTRL_IK_LENGTH_3          30.0f
+#define SERVO_CTRL_IK_ELBOW_UP          false
+#define SERVO_CTRL_IK_JOINT_ZERO_DEG    90
+#if (SERVO_NUM_SERVOS < IK_MAX_JOINTS)
+#error "SERVO_NUM_SERVOS must not be less than IK_MAX_JOINTS."
+#endif
+
+/**
+ * Motion detection: a servo is moving whilst its estimated speed exceeds the
+ * threshold (or, without feedback, its setpoint changes), and for the hold
+ * time after.
+ */
+#define SERVO_CTRL_MOTION_THRESHOLD_DEG_S 5.0f
+#define SERVO_CTRL_MOTION_HOLD_MS         250
+#define SERVO_CTRL_MOTION_HOLD_LOOPS      ((SERVO_CTRL_MOTION_HOLD_MS * SERVO_CTRL_LOOP_RATE_HZ) / 1000)
+
+/**
+ * Motor health monitoring (control loop periods to detect each fault): stall
+ * whilst the feedback is further than the error beyond the load term from the
+ * latched command, the estimated speed below the threshold at the onset and
+ * the feedback within the travel (several times the feedback noise) of the
+ * onset's since, overload whilst the load term is above the threshold, and
+ * feedback loss without a new valid sample (more than a feedback sample
+ * period).
+ */
+#define SERVO_CTRL_HEALTH_STALL_ERROR_DEG   10.0f
+#define SERVO_CTRL_HEALTH_STALL_SPEED_DEG_S SERVO_CTRL_MOTION_THRESHOLD_DEG_S
+#define SERVO_CTRL_HEALTH_STALL_TRAVEL_DEG  3.0f
+#define SERVO_CTRL_HEALTH_STALL_PERIODS     (SERVO_CTRL_LOOP_RATE_HZ / 4)    /* 250 ms. */
+#define SERVO_CTRL_HEALTH_OVERLOAD_DEG      20.0f
+#define SERVO_CTRL_HEALTH_OVERLOAD_PERIODS  (SERVO_CTRL_LOOP_RATE_HZ / 2)    /* 500 ms. */
+#define SERVO_CTRL_HEALTH_FB_LOSS_PERIODS   (3 * SERVO_CTRL_LOOPS_PER_FRAME) /* 3 feedback samples. */
+#if (SERVO_CTRL_HEALTH_FB_LOSS_PERIODS <= (SERVO_CTRL_LOOP_RATE_HZ / SERVO_FB_SAMPLE_RATE_HZ))
+#error "SERVO_CTRL_HEALTH_FB_LOSS_PERIODS must exceed the feedback sample period."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef enum SERVO_CTRL_LOOP_TYPE_t {
+    SERVO_CTRL_LOOP_TYPE__PID,      /* Position PID. */
+    SERVO_CTRL_LOOP_TYPE__CASCADE,  /* Position P(I) -> velocity PI, with feedforward. */
+    SERVO_CTRL_LOOP_TYPE__MPC,      /* Model predictive, constrained (PWM frame rate). */
+} SERVO_CTRL_LOOP_TYPE_t;
+
+typedef struct SERVO_CTRL_STATS_t {
+    uint32_t loop_count;         /* Number of control loop executions. */
+    uint32_t period_cycles_min;  /* Minimum period between executions (CPU cycles). */
+    uint32_t period_cycles_max;  /* Maximum period between executions (CPU cycles). */
+    uint32_t exec_cycles_last;   /* Execution time of the last loop (CPU cycles). */
+    uint32_t exec_cycles_max;    /* Maximum execution time (CPU cycles). */
+    float tracking_error_deg;    /* Last tracking error (setpoint - feedback) in degrees (largest of all servos). */
+    float tracking_error_max_deg;/* Maximum absolute tracking error in degrees. */
+    bool feedback_valid;         /* Whether the last loop was closed with feedback (any servo). */
+    uint32_t frame_slip_count;   /* PWM frames without SERVO_CTRL_LOOPS_PER_FRAME loop executions. */
+    uint32_t fb_latency_cycles_last; /* Feedback sample (trigger) to actuation (frame boundary) latency (CPU cycles). */
+    uint32_t fb_latency_cycles_max;  /* Maximum feedback sample to actuation latency (CPU cycles). */
+    uint32_t fb_missed_frames;   /* PWM frames without a new feedback sample (ADC trigger lost). */
+    uint32_t est_cycles_last;    /* State estimator execution time of the last loop, all servos (CPU cycles). */
+    uint32_t est_cycles_max;     /* Maximum state estimator execution time, all servos (CPU cycles). */
+    uint32_t profile_cycles_last;/* Motion profile execution time of the last loop, all servos (CPU cycles). */
+    uint32_t profile_cycles_max; /* Maximum motion profile execution time, all servos (CPU cycles). */
+    uint32_t coord_moves;        /* Coordinated moves queued. */
+    uint32_t coord_ticks_last;   /* Duration of the last coordinated move (loop iterations). */
+    uint32_t coord_plan_cycles_last; /* Planning time of the last coordinated move, all servos (CPU cycles; task). */
+    uint32_t coord_plan_cycles_max;  /* Maximum coordinated move planning time, all servos (CPU cycles; task). */
+    uint32_t stream_cycles_last; /* Setpoint stream execution time of the last loop (CPU cycles). */
+    uint32_t stream_cycles_max;  /* Maximum setpoint stream execution time (CPU cycles). */
+    uint32_t ik_cycles_last;     /* Inverse kinematics execution time of the last loop (CPU cycles). */
+    uint32_t ik_cycles_max;      /* Maximum inverse kinematics execution time (CPU cycles). */
+    uint32_t ik_unreachable;     /* Loops with the streamed target out of the arm's reach. */
+    uint32_t sched_cycles_last;  /* Gain scheduling execution time of the last loop, all servos (CPU cycles). */
+    uint32_t sched_cycles_max;   /* Maximum gain scheduling execution time, all servos (CPU cycles). */
+    uint32_t mpc_cycles_last;    /* MPC execution time of the last solve, one servo (CPU cycles). */
+    uint32_t mpc_cycles_max;     /* Maximum MPC execution time, one servo (CPU cycles). */
+    uint32_t mpc_iterations_max; /* Maximum QP iterations of a solve. */
+    uint32_t mpc_constrained_count; /* Solves with an active constraint. */
+    uint32_t shaper_cycles_last; /* Input shaping execution time of the last loop, all servos (CPU cycles). */
+    uint32_t shaper_cycles_max;  /* Maximum input shaping execution time, all servos (CPU cycles). */
+    uint32_t friction_cycles_last; /* Friction compensation execution time of the last loop, all servos (CPU cycles). */
+    uint32_t friction_cycles_max;  /* Maximum friction compensation execution time, all servos (CPU cycles). */
+    uint32_t lms_cycles_last;    /* Adaptive feedforward execution time of the last loop, all servos (CPU cycles). */
+    uint32_t lms_cycles_max;     /* Maximum adaptive feedforward execution time, all servos (CPU cycles). */
+    uint32_t sat_loops[SERVO_NUM_SERVOS];  /* Loops with the command saturated at the servo's limits, per servo. */
+    uint32_t slew_loops[SERVO_NUM_SERVOS]; /* Loops with the command saturated by the slew limit, per servo. */
+} SERVO_CTRL_STATS_t;
+
+typedef struct SERVO_CTRL_FAULT_t {
+    MOTOR_FAULT_t fault;         /* Latched fault; see @ref MOTOR_FAULT_t. */
+    uint32_t latency_cycles;     /* Fault condition onset to PWM signal cut (CPU cycles). */
+    uint32_t cut_cycles;         /* Start of the detecting loop to PWM signal cut (CPU cycles). */
+} SERVO_CTRL_FAULT_t;
+
+typedef struct SERVO_CTRL_STATE_t {
+    float position_deg;          /* Estimated position (degrees). */
+    float velocity_deg_s;        /* Estimated velocity (degrees/s). */
+    float acceleration_deg_s2;   /* Estimated acceleration (degrees/s^2). */
+    float load_deg;              /* Load term: low-pass filtered controller correction magnitude (degrees). */
+} SERVO_CTRL_STATE_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Servo motor control initialisation:
+ *             - PID (and cascaded) controller initialisation.
+ *             - Control loop time base (TIM6) initialisation.
+ *             - CPU cycle counter enable (loop statistics).
+ * @retval None.
+ */
+void servo_ctrl_init(void);
+
+/**
+ * @brief  Start/stop the control loop; starting clears the motor faults.
+ * @note   The control loop starts at the next PWM frame boundary, i.e. the
+ *         PWM signals must be on (see servo_set_signal_all), including
+ *         those cut by a motor fault.
+ * @param  state: true|false = start|stop.
+ * @retval None.
+ */
+void servo_ctrl_enable(bool state);
+
+/**
+ * @brief  Run one control loop iteration.
+ * @note   IMPORTANT: Intended to be called from the control loop time base
+ *         interrupt only (see timer_tim6_period_elapsed_callback).
+ * @retval None.
+ */
+void servo_ctrl_loop_run(void);
+
+/**
+ * @brief  PWM frame boundary: starts the control loop time base (TIM6) in
+ *         phase with the PWM frame when pending (see servo_ctrl_enable),
+ *         records phase slips, and records the commands latched (the slew
+ *         limit's reference).
+ * @note   IMPORTANT: Intended to be called from the PWM frame interrupt only
+ *         (see timer_tim2_period_elapsed_callback).
+ * @retval None.
+ */
+void servo_ctrl_frame_sync(void);
+
+/**
+ * @brief  Select the controller structure; the controllers are reset (i.e.
+ *         the new structure starts from zero correction).
+ * @param  type: Controller structure; see @ref SERVO_CTRL_LOOP_TYPE_t.
+ * @retval None.
+ */
+void servo_ctrl_set_loop_type(SERVO_CTRL_LOOP_TYPE_t type);
+
+/**
+ * @brief  Retrieve the controller structure.
+ * @retval Controller structure; see @ref SERVO_CTRL_LOOP_TYPE_t.
+ */
+SERVO_CTRL_LOOP_TYPE_t servo_ctrl_get_loop_type(void);
+
+/**
+ * @brief  Select a servo's input shaper (see shaper_design); applied only
+ *         whilst its setpoint is held (see shaper_is_settled) such that the
+ *         change is bumpless.
+ * @param  id:      Servo ID; see @ref SERVO_ID_t.
+ * @param  type:    Shaper type; see @ref SHAPER_TYPE_t.
+ * @param  freq_hz: Vibration mode natural frequency (Hz).
+ * @param  zeta:    Vibration mode damping ratio (0..1).
+ * @retval Boolean indicating whether the shaper was applied: false if the
+ *         design is invalid, longer than SERVO_CTRL_SHAPER_MAX_MS, or the
+ *         servo's setpoint is not held.
+ */
+bool servo_ctrl_set_shaper(SERVO_ID_t id, SHAPER_TYPE_t type, float freq_hz, float zeta);
+
+/**
+ * @brief  Retrieve a servo's input shaper type.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Shaper type; see @ref SHAPER_TYPE_t.
+ */
+SHAPER_TYPE_t servo_ctrl_get_shaper(SERVO_ID_t id);
+
+/**
+ * @brief  Queue a move to a target position; the move starts after the
+ *         previously queued moves (or whilst the previous move decelerates
+ *         if @param blend), else from the current setpoint.
+ * @note   Whilst moves are running the setpoint is written by the control
+ *         loop, i.e. over-writes servo_set_position/servo_set_position_q16.
+ * @param  id:     Servo ID; see @ref SERVO_ID_t.
+ * @param  target: Target angle in degrees, Q16.16 fixed-point; limited to
+ *                 the servo's position limits.
+ * @param  type:   Profile type; see @ref PROFILE_TYPE_t.
+ * @param  limits: Velocity (degrees/s), acceleration (degrees/s^2) and jerk
+ *                 (degrees/s^3, S-curve only) limits.
+ * @param  blend:  Whether to blend with the previous move.
+ * @retval Boolean indicating whether the move was queued: false if the queue
+ *         is full (see servo_ctrl_get_moves_queued), a limit is invalid, a
+ *         setpoint stream is active or the servo is being auto-tuned or
+ *         identified.
+ */
+bool servo_ctrl_move(SERVO_ID_t id, SERVO_ANGLE_Q16_t target, PROFILE_TYPE_t type, const PROFILE_LIMITS_t *limits, bool blend);
+
+/**
+ * @brief  Queue a coordinated move of all servos to target positions: the
+ *         servos' moves share one timing, i.e. start and finish together
+ *         and follow a straight line in joint space, within each servo's
+ *         limits (the slowest servo sets the duration). The moves start
+ *         after the previously queued coordinated moves (or whilst they
+ *         decelerate if @param blend), else from the current setpoints.
+ * @note   The servos' queues are kept in lock-step: a coordinated move is
+ *         only queued after coordinated moves, or with all servos idle
+ *         (e.g. not after servo_ctrl_move until its moves have finished).
+ * @param  targets: Target angle per servo in degrees, Q16.16 fixed-point;
+ *                  limited to each servo's position limits.
+ * @param  type:    Profile type; see @ref PROFILE_TYPE_t.
+ * @param  limits:  Velocity (degrees/s), acceleration (degrees/s^2) and
+ *                  jerk (degrees/s^3, S-curve only) limits of each servo.
+ * @param  blend:   Whether to blend with the previous moves.
+ * @retval Boolean indicating whether the moves were queued: false if the
+ *         queues are full or not in lock-step, a limit is invalid, a
+ *         setpoint stream is active or a servo is being auto-tuned or
+ *         identified, or has a fault.
+ */
+bool servo_ctrl_move_coordinated(const SERVO_ANGLE_Q16_t targets[SERVO_NUM_SERVOS], PROFILE_TYPE_t type,
+                                 const PROFILE_LIMITS_t *limits, bool blend);
+
+/**
+ * @brief  Abort all queued/running moves; the setpoint is held where it is.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval None.
+ */
+void servo_ctrl_move_abort(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve the number of queued moves, including the running move(s).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Number of moves (0..PROFILE_QUEUE_LEN).
+ */
+uint32_t servo_ctrl_get_moves_queued(SERVO_ID_t id);
+
+/**
+ * @brief  Start auto-tuning a servo's PID controller: the servo's moves are
+ *         aborted and its setpoint held whilst a relay experiment runs (see
+ *         SERVO_CTRL_AUTOTUNE_*); on success the tuned gains are loaded into
+ *         the servo's PID controller (SERVO_CTRL_LOOP_TYPE__PID). Opening
+ *         the loop or a setpoint stream starting aborts the experiment.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Boolean indicating whether auto-tuning was started: false if the
+ *         servo has no valid feedback, is already being auto-tuned or
+ *         identified, or a setpoint stream is active.
+ */
+bool servo_ctrl_autotune_start(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve a servo's auto-tuning state and result.
+ * @param  id:     Servo ID; see @ref SERVO_ID_t.
+ * @param  result: Result; valid when the state is AUTOTUNE_STATE__DONE.
+ *                 Passed by reference.
+ * @retval State; see @ref AUTOTUNE_STATE_t.
+ */
+AUTOTUNE_STATE_t servo_ctrl_get_autotune(SERVO_ID_t id, AUTOTUNE_RESULT_t *result);
+
+/**
+ * @brief  Start identifying a servo's frequency response (one servo at a
+ *         time): the servo's moves are aborted, its setpoint held and the
+ *         excitation added to it open-loop (see SERVO_CTRL_SYSID_*). Opening
+ *         the loop or a setpoint stream starting aborts the identification.
+ * @param  id:     Servo ID; see @ref SERVO_ID_t.
+ * @param  signal: Excitation signal; see @ref SYSID_SIGNAL_t.
+ * @retval Boolean indicating whether identification was started: false if
+ *         the servo has no valid feedback, is being auto-tuned, the
+ *         excitation would exceed its position limits, a setpoint stream is
+ *         active, or an identification is running or awaiting computation.
+ */
+bool servo_ctrl_sysid_start(SERVO_ID_t id, SYSID_SIGNAL_t signal);
+
+/**
+ * @brief  Compute the frequency response once the identification's capture
+ *         is complete.
+ * @note   Not for interrupt context (see sysid_compute); to be called
+ *         periodically from one task only.
+ * @retval Boolean indicating whether the result was computed by this call,
+ *         i.e. is new.
+ */
+bool servo_ctrl_sysid_process(void);
+
+/**
+ * @brief  Retrieve the identification state and servo.
+ * @param  id: Servo ID identified (or last identified). Passed by reference.
+ * @retval State; see @ref SYSID_STATE_t.
+ */
+SYSID_STATE_t servo_ctrl_get_sysid(SERVO_ID_t *id);
+
+/**
+ * @brief  Retrieve the identified frequency response at a bin.
+ * @param  bin:    Bin (1..SYSID_NUM_BINS - 1).
+ * @param  result: Frequency response. Passed by reference.
+ * @retval Boolean indicating whether @param result is valid: false if no
+ *         result is computed or the bin was not excited.
+ */
+bool servo_ctrl_get_sysid_bin(uint32_t bin, SYSID_BIN_t *result);
+
+/**
+ * @brief  Start/stop iterative learning control of a servo's repeated moves;
+ *         applied by servo_ctrl_ilc_process, learning from zero correction
+ *         from the next move started. Stopped (the correction removed) when
+ *         the controller structure changes or the control loop restarts,
+ *         and whilst the servo is open-loop, auto-tuned, identified, faulted
+ *         or a setpoint stream is active.
+ * @param  id:              Servo ID; see @ref SERVO_ID_t.
+ * @param  moves_per_cycle: Moves per repetition; 0 stops.
+ * @retval Boolean indicating whether the request was accepted: false if the
+ *         MPC controller structure is selected (no feedforward), a setpoint
+ *         stream is active or the servo is faulted.
+ */
+bool servo_ctrl_ilc_start(SERVO_ID_t id, uint32_t moves_per_cycle);
+
+/**
+ * @brief  Apply the iterative learning control start/stop requests and learn
+ *         the next corrections from the recorded cycles (see ilc_learn).
+ * @note   Not for interrupt context; to be called periodically (at least
+ *         once per cycle) from one low priority task only.
+ * @retval Number of corrections learnt by this call.
+ */
+uint32_t servo_ctrl_ilc_process(void);
+
+/**
+ * @brief  Retrieve a servo's iterative learning control state and statistics.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  stats: Statistics. Passed by reference.
+ * @retval State; see @ref ILC_STATE_t.
+ */
+ILC_STATE_t servo_ctrl_get_ilc(SERVO_ID_t id, ILC_STATS_t *stats);
+
+/**
+ * @brief  Enable/disable a servo's friction compensation; applies under the
+ *         PID or cascaded controller structure whilst closed-loop. The
+ *         disturbance observer restarts on enabling.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  state: Enable (true) or disable (false).
+ * @retval None.
+ */
+void servo_ctrl_friction_enable(SERVO_ID_t id, bool state);
+
+/**
+ * @brief  Load a servo's friction parameters (see friction_set_params).
+ * @param  id:     Servo ID; see @ref SERVO_ID_t.
+ * @param  params: Parameters.
+ * @retval Boolean indicating whether the parameters were loaded.
+ */
+bool servo_ctrl_friction_set_params(SERVO_ID_t id, const FRICTION_PARAMS_t *params);
+
+/**
+ * @brief  Retrieve a servo's friction compensation parameters and state.
+ * @param  id:          Servo ID; see @ref SERVO_ID_t.
+ * @param  params:      Parameters. Passed by reference.
+ * @param  disturbance: Observed disturbance (degrees). Passed by reference.
+ * @param  holding:     Within the hold band at standstill. Passed by
+ *                      reference.
+ * @retval Boolean indicating whether compensation is enabled.
+ */
+bool servo_ctrl_get_friction(SERVO_ID_t id, FRICTION_PARAMS_t *params, float *disturbance, bool *holding);
+
+/**
+ * @brief  Start identifying a servo's friction (one servo at a time): the
+ *         servo's moves are aborted, its setpoint held and a triangle sweep
+ *         added to it open-loop (see SERVO_CTRL_FRICTION_ID_*); on success
+ *         the identified parameters are loaded (see
+ *         servo_ctrl_friction_set_params). Opening the loop or a setpoint
+ *         stream starting aborts the identification.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Boolean indicating whether identification was started: false if
+ *         the servo has no valid feedback, is faulted, being auto-tuned or
+ *         identified, the sweep would exceed its position limits, a
+ *         setpoint stream is active, or a friction identification is
+ *         running.
+ */
+bool servo_ctrl_friction_id_start(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve the friction identification state, servo and result.
+ * @param  id:     Servo ID identified (or last identified). Passed by
+ *                 reference.
+ * @param  result: Identified parameters; valid when the state is
+ *                 FRICTION_ID_STATE__DONE. Passed by reference.
+ * @retval State; see @ref FRICTION_ID_STATE_t.
+ */
+FRICTION_ID_STATE_t servo_ctrl_get_friction_id(SERVO_ID_t *id, FRICTION_PARAMS_t *result);
+
+/**
+ * @brief  Enable/disable a servo's adaptive feedforward; applies under the
+ *         PID or cascaded controller structure whilst closed-loop. The
+ *         coefficients are kept whilst disabled (see servo_ctrl_lms_clear).
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  state: Enable (true) or disable (false).
+ * @retval None.
+ */
+void servo_ctrl_lms_enable(SERVO_ID_t id, bool state);
+
+/**
+ * @brief  Freeze/unfreeze a servo's adaptive feedforward adaptation; whilst
+ *         frozen the coefficients are held and the tracking error is still
+ *         monitored (see servo_ctrl_get_lms).
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  state: Freeze (true) or adapt (false).
+ * @retval None.
+ */
+void servo_ctrl_lms_freeze(SERVO_ID_t id, bool state);
+
+/**
+ * @brief  Clear a servo's adaptive feedforward coefficients (zero output);
+ *         applied by servo_ctrl_lms_process. Also cleared when the
+ *         controller structure changes (adapted against the previous one).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval None.
+ */
+void servo_ctrl_lms_clear(SERVO_ID_t id);
+
+/**
+ * @brief  Apply the adaptive feedforward clear requests and adapt from the
+ *         recorded blocks (see lms_ff_adapt).
+ * @note   Not for interrupt context; to be called periodically (at least
+ *         once per LMS_FF_BLOCK_SIZE frames) from one low priority task only.
+ * @retval Number of blocks processed by this call.
+ */
+uint32_t servo_ctrl_lms_process(void);
+
+/**
+ * @brief  Retrieve a servo's adaptive feedforward state and statistics.
+ * @param  id:     Servo ID; see @ref SERVO_ID_t.
+ * @param  stats:  Statistics. Passed by reference.
+ * @param  frozen: Adaptation frozen. Passed by reference.
+ * @retval Boolean indicating whether the adaptive feedforward is enabled.
+ */
+bool servo_ctrl_get_lms(SERVO_ID_t id, LMS_FF_STATS_t *stats, bool *frozen);
+
+/**
+ * @brief  Enable/disable gain scheduling; when disabled the base gains (see
+ *         SERVO_CTRL_PID_*, SERVO_CTRL_VEL_*, SERVO_CTRL_FF_* and
+ *         servo_ctrl_autotune_start) apply.
+ * @param  state: Enable (true) or disable (false).
+ * @retval None.
+ */
+void servo_ctrl_gain_sched_enable(bool state);
+
+/**
+ * @brief  Retrieve whether gain scheduling is enabled.
+ * @retval Boolean indicating whether gain scheduling is enabled.
+ */
+bool servo_ctrl_gain_sched_is_enabled(void);
+
+/**
+ * @brief  Start loading a gain schedule table: the staging table is a copy
+ *         of the active table until edited (see
+ *         servo_ctrl_gain_sched_set_axes/servo_ctrl_gain_sched_set_point).
+ * @note   IMPORTANT: Single loader, i.e. the loading functions are to be
+ *         called from one task only.
+ * @retval None.
+ */
+void servo_ctrl_gain_sched_begin(void);
+
+/**
+ * @brief  Set the staging table's axes.
+ * @param  pos_min_deg:  Position axis minimum (degrees).
+ * @param  pos_max_deg:  Position axis maximum (degrees).
+ * @param  load_max_deg: Load axis maximum (degrees of controller correction).
+ * @retval None.
+ */
+void servo_ctrl_gain_sched_set_axes(float pos_min_deg, float pos_max_deg, float load_max_deg);
+
+/**
+ * @brief  Set the staging table's scale factors at a breakpoint.
+ * @param  load_idx: Load breakpoint (0..GAIN_SCHED_LOAD_POINTS - 1).
+ * @param  pos_idx:  Position breakpoint (0..GAIN_SCHED_POS_POINTS - 1).
+ * @param  scale:    Scale factors (>= 0); see @ref GAIN_SCHED_PARAM_t. The
+ *                   gain scales apply to the PID controller's and the
+ *                   cascaded inner velocity loop's gains, the feedforward
+ *                   scale to the cascaded controller's feedforward.
+ * @retval Boolean indicating whether the breakpoint was set.
+ */
+bool servo_ctrl_gain_sched_set_point(uint32_t load_idx, uint32_t pos_idx, const float scale[GAIN_SCHED_PARAM__NUM]);
+
+/**
+ * @brief  Swap the staging table in (glitch-free; see @ref gain_sched.h) and
+ *         enable gain scheduling.
+ * @retval Boolean indicating whether the table was committed: false if its
+ *         axes are invalid.
+ */
+bool servo_ctrl_gain_sched_commit(void);
+
+/**
+ * @brief  Retrieve the number of gain schedule tables committed.
+ * @retval Number of tables committed.
+ */
+uint32_t servo_ctrl_gain_sched_get_swaps(void);
+
+/**
+ * @brief  Push a setpoint stream waypoint (all servos); playback starts once
+ *         STREAM_PREFILL waypoints are buffered and aborts the running moves.
+ * @note   IMPORTANT: Single producer, i.e. to be called from one task only.
+ * @param  timestamp_us: Waypoint time in the host's time base (us).
+ * @param  positions:    Angles in degrees, Q16.16 fixed-point; limited to the
+ *                       servos' position limits. With a Cartesian stream
+ *                       enabled (see servo_ctrl_ik_enable), the first
+ *                       ik_get_num_joints channels are the arm's target
+ *                       (see ik_solve; not limited).
+ * @retval Boolean indicating whether the waypoint was queued: false if the
+ *         stream buffer is full (overrun).
+ */
+bool servo_ctrl_stream_push(uint32_t timestamp_us, const SERVO_ANGLE_Q16_t positions[SERVO_NUM_SERVOS]);
+
+/**
+ * @brief  Retrieve whether a setpoint stream is active (playing or holding
+ *         after an underrun).
+ * @retval Boolean indicating whether a stream is active.
+ */
+bool servo_ctrl_stream_is_active(void);
+
+/**
+ * @brief  Retrieve a snapshot of the setpoint stream statistics; the minimum
+ *         fill level is reset with the control loop statistics (see
+ *         servo_ctrl_reset_stats).
+ * @param  stats: Statistics. Passed by reference.
+ * @retval None.
+ */
+void servo_ctrl_get_stream_stats(STREAM_STATS_t *stats);
+
+/**
+ * @brief  Configure the inverse kinematics of a Cartesian setpoint stream.
+ * @param  config: Arm configuration; see @ref IK_CONFIG_t.
+ * @retval Boolean indicating whether the configuration was applied: false if
+ *         it is invalid or a setpoint stream is active.
+ */
+bool servo_ctrl_ik_set(const IK_CONFIG_t *config);
+
+/**
+ * @brief  Enable/disable a Cartesian setpoint stream: the streamed target
+ *         is solved to the joint angles every loop iteration (see
+ *         servo_ctrl_stream_push), and out of reach targets are counted
+ *         (the nearest posture is driven).
+ * @note   An orientation (planar 3-link arm) is streamed unwrapped, such
+ *         that it is interpolated the short way.
+ * @param  state: Enable (true) or disable (false).
+ * @retval Boolean indicating whether the state was applied: false whilst a
+ *         setpoint stream is active.
+ */
+bool servo_ctrl_ik_enable(bool state);
+
+/**
+ * @brief  Retrieve the inverse kinematics configuration and whether a
+ *         Cartesian setpoint stream is enabled.
+ * @param  config: Arm configuration. Passed by reference.
+ * @retval Boolean indicating whether a Cartesian stream is enabled.
+ */
+bool servo_ctrl_ik_get(IK_CONFIG_t *config);
+
+/**
+ * @brief  Retrieve a snapshot of a servo's estimated state.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  state: Estimated state. Passed by reference.
+ * @retval Boolean indicating whether @param state is valid (the estimator
+ *         has been seeded by valid feedback).
+ */
+bool servo_ctrl_get_state(SERVO_ID_t id, SERVO_CTRL_STATE_t *state);
+
+/**
+ * @brief  Retrieve whether a servo is moving; evaluated every control loop
+ *         iteration (see SERVO_CTRL_MOTION_THRESHOLD_DEG_S).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Boolean indicating motion.
+ */
+bool servo_ctrl_is_moving(SERVO_ID_t id);
+
+/**
+ * @brief  Retrieve a servo's motor fault, latched by the control loop when
+ *         detected (its PWM signal is then off) until the control loop is
+ *         restarted (see servo_ctrl_enable).
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  fault: Fault and its detection latency. Passed by reference.
+ * @retval Boolean indicating whether a fault is latched.
+ */
+bool servo_ctrl_get_fault(SERVO_ID_t id, SERVO_CTRL_FAULT_t *fault);
+
+/**
+ * @brief  Retrieve whether a motor fault is latched for any servo.
+ * @retval Boolean indicating a fault.
+ */
+bool servo_ctrl_is_faulted(void);
+
+/**
+ * @brief  Retrieve a snapshot of the control loop statistics.
+ * @param  stats: Statistics. Passed by reference.
+ * @retval None.
+ */
+void servo_ctrl_get_stats(SERVO_CTRL_STATS_t *stats);
+
+/**
+ * @brief  Reset the control loop statistics (min/max values and counters).
+ * @retval None.
+ */
+void servo_ctrl_reset_stats(void);
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Retrieve the *actual* servo motor shaft position (position feedback).
+ * @note   IMPORTANT: The user can over-write this function with their own
+ *         implementation. The default implementation returns the servo's
+ *         potentiometer feedback (see servo_get_angle_actual_q16) when valid.
+ * @param  id:    Servo ID; see @ref SERVO_ID_t.
+ * @param  angle: Angle in degrees (0..180). Passed by reference.
+ * @retval Boolean indicating whether @param angle holds valid feedback.
+ */
+__weak bool servo_ctrl_get_feedback(SERVO_ID_t id, float *angle);
+
+/*============================================================================*/
+
+#endif /* SERVO_CTRL_H =======================================================*/
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * @file   servo_feedback.h
+ * @brief  Servo motor position feedback (potentiometer) conversion header
+ *         file.
+ *
+ *         Provides:
+ *             - Conversion of blocks of raw ADC samples of the servo motor
+ *               potentiometer wipers (one block per DMA half/full transfer)
+ *               into shaft positions (angle in degrees, Q16.16 fixed-point).
+ *             - Per-channel two-point calibration (raw ADC value at 0 and
+ *               180 degrees); the division is done once when the calibration
+ *               is set such that a conversion is one integer multiply.
+ *             - Validity check: block averages outside the calibrated range
+ *               (plus a margin), e.g. a disconnected wiper, are not
+ *               published and mark the channel's feedback as invalid.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC with injected sample blocks.
+ *
+ ******************************************************************************/
+
+#ifndef SERVO_FEEDBACK_H
+#define SERVO_FEEDBACK_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*===== Defines ==============================================================*/
+
+#define SERVO_FEEDBACK_MAX_CHANNELS         8
+#define SERVO_FEEDBACK_ANGLE_RANGE_DEG      180
+/* Valid range margin: 1/16 of the calibrated range (1/8 reaches the 0 V rail at servo.c's calibration). */
+#define SERVO_FEEDBACK_VALID_MARGIN_DIV     16
+
+/*===== Typedefs =============================================================*/
+
+typedef struct SERVO_FEEDBACK_CHANNEL_t {
+    int32_t raw_0;                  /* Raw ADC value at 0 degrees. */
+    int64_t scale_q32;              /* Degrees per raw ADC count, Q32.32 fixed-point. */
+    int32_t raw_valid_min;          /* Minimum valid raw ADC value (block average). */
+    int32_t raw_valid_max;          /* Maximum valid raw ADC value (block average). */
+    volatile int32_t angle_q16;     /* Last valid angle in degrees (0..180), Q16.16 fixed-point. */
+    volatile bool valid;            /* Whether the last block was valid. */
+} SERVO_FEEDBACK_CHANNEL_t;
+
+typedef struct SERVO_FEEDBACK_t {
+    uint32_t num_channels;                                      /* Channels per scan. */
+    SERVO_FEEDBACK_CHANNEL_t channel[SERVO_FEEDBACK_MAX_CHANNELS];
+    volatile uint32_t block_count;                              /* Number of blocks processed. */
+} SERVO_FEEDBACK_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Feedback initialisation; all channels invalid until calibrated and
+ *         a valid block is processed.
+ * @param  fb:           Feedback object.
+ * @param  num_channels: Channels per scan (1..SERVO_FEEDBACK_MAX_CHANNELS).
+ * @retval Boolean indicating whether @param num_channels was valid and @param
+ *         fb was initialised.
+ */
+bool servo_feedback_init(SERVO_FEEDBACK_t *fb, uint32_t num_channels);
+
+/**
+ * @brief  Set a channel's calibration: the raw ADC values (block average) at
+ *         0 and 180 degrees; either may be the larger (i.e. either wiper
+ *         direction).
+ * @param  fb:         Feedback object.
+ * @param  channel:    Channel (0..[num_channels - 1]).
+ * @param  raw_at_0:   Raw ADC value at 0 degrees.
+ * @param  raw_at_180: Raw ADC value at 180 degrees.
+ * @retval Boolean indicating whether the calibration was valid and set.
+ */
+bool servo_feedback_set_calibration(SERVO_FEEDBACK_t *fb, uint32_t channel, uint16_t raw_at_0, uint16_t raw_at_180);
+
+/**
+ * @brief  Process a block of samples: each channel's samples are averaged,
+ *         checked against the valid range and converted to an angle, which is
+ *         published with a single store (read by servo_feedback_get_angle_q16
+ *         without locking).
+ * @param  fb:        Feedback object.
+ * @param  samples:   Raw ADC samples, interleaved by scan, i.e.
+ *                    samples[(scan * num_channels) + channel].
+ * @param  num_scans: Number of scans in the block (>= 1).
+ * @retval None.
+ */
+void servo_feedback_process(SERVO_FEEDBACK_t *fb, const uint16_t *samples, uint32_t num_scans);
+
+/**
+ * @brief  Retrieve a channel's last valid angle.
+ * @param  fb:      Feedback object.
+ * @param  channel: Channel (0..[num_channels - 1]).
+ * @retval Angle in degrees (0..180), Q16.16 fixed-point.
+ */
+int32_t servo_feedback_get_angle_q16(const SERVO_FEEDBACK_t *fb, uint32_t channel);
+
+/**
+ * @brief  Retrieve whether a channel's last block was valid.
+ * @param  fb:      Feedback object.
+ * @param  channel: Channel (0..[num_channels - 1]).
+ * @retval Boolean indicating validity.
+ */
+bool servo_feedback_is_valid(const SERVO_FEEDBACK_t *fb, uint32_t channel);
+
+/*============================================================================*/
+
+#endif /* SERVO_FEEDBACK_H ===================================================*/
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * @file   servo_lut.h
+ * @brief  Servo motor angle to PWM pulse lookup table header file.
+ *
+ *         Provides:
+ *             - A lookup table (LUT) of PWM pulse values (timer counts) at
+ *               uniformly spaced angles; the spacing is a power of two in
+ *               Q16.16 degrees such that a lookup is a shift, a mask, and one
+ *               integer multiply (linear interpolation), i.e. no division or
+ *               floating-point arithmetic.
+ *             - A LUT may be declared const (flash) using the compile-time
+ *               generator macros below or built at run-time from a set of
+ *               calibration points (e.g. produced by a calibration routine).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC.
+ *
+ ******************************************************************************/
+
+#ifndef SERVO_LUT_H
+#define SERVO_LUT_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*===== Defines & Macros =====================================================*/
+
+/* LUT grid: points every 2^SERVO_LUT_STEP_SHIFT Q16.16 degrees (8 degrees). */
+#define SERVO_LUT_STEP_SHIFT        19
+#define SERVO_LUT_STEP_DEG          (1L << (SERVO_LUT_STEP_SHIFT - 16))
+#define SERVO_LUT_ANGLE_MAX_DEG     180
+#define SERVO_LUT_NUM_POINTS        ((SERVO_LUT_ANGLE_MAX_DEG / SERVO_LUT_STEP_DEG) + 2) /* 24 points: 0..184 degrees. */
+
+/**
+ * Compile-time LUT generation from three calibration pulse-widths (in ns) at
+ * 0, 90 and 180 degrees (i.e. -90, 0 and +90 degrees), piecewise linear,
+ * converted to timer counts for a PWM frame of frame_ns nanoseconds and
+ * frame_counts timer counts. Note the -1 as the timer counts from 0.
+ */
+#define SERVO_LUT_NS_AT_DEG(deg, ns_0, ns_90, ns_180) \
+    (((deg) <= 90) ? \
+    ((ns_0) + ((((int64_t)(ns_90) - (ns_0)) * (deg)) / 90)) : \
+    ((ns_90) + ((((int64_t)(ns_180) - (ns_90)) * ((deg) - 90)) / 90)))
+#define SERVO_LUT_NS_TO_COUNTS(ns, frame_ns, frame_counts) \
+    ((uint32_t)((((int64_t)(ns) * (frame_counts)) / (frame_ns)) - 1))
+#define SERVO_LUT_POINT(i, ns_0, ns_90, ns_180, frame_ns, frame_counts) \
+    SERVO_LUT_NS_TO_COUNTS(SERVO_LUT_NS_AT_DEG((i) * SERVO_LUT_STEP_DEG, ns_0, ns_90, ns_180), \
+    frame_ns, frame_counts)
+#define SERVO_LUT_INITIALISER(ns_0, ns_90, ns_180, frame_ns, frame_counts) { .pulse = { \
+    SERVO_LUT_POINT(0,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(1,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(2,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(3,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(4,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(5,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(6,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(7,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(8,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(9,  ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(10, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(11, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(12, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(13, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(14, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(15, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(16, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(17, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(18, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(19, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(20, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(21, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(22, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    SERVO_LUT_POINT(23, ns_0, ns_90, ns_180, frame_ns, frame_counts), \
+    } }
+_Static_assert(SERVO_LUT_NUM_POINTS == 24, "SERVO_LUT_INITIALISER lists 24 points: update it with SERVO_LUT_STEP_DEG");
+
+/*===== Typedefs =============================================================*/
+
+typedef struct SERVO_LUT_t {
+    uint32_t pulse[SERVO_LUT_NUM_POINTS]; /* Pulse values (timer counts) at (i * SERVO_LUT_STEP_DEG) degrees. */
+} SERVO_LUT_t;
+
+typedef struct SERVO_CAL_POINT_t {
+    int32_t angle_q16; /* Angle in degrees (0..180), Q16.16 fixed-point. */
+    uint32_t pulse_ns; /* Measured pulse-width (ns) that achieves the angle. */
+} SERVO_CAL_POINT_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Build a LUT from calibration points.
+ *
+ *         The calibration curve is piecewise linear through the points (and
+ *         linearly extrapolated beyond the first/last points); it is sampled
+ *         at each LUT grid angle and converted to timer counts.
+ *
+ * @param  lut:          LUT to build.
+ * @param  points:       Calibration points, sorted by ascending angle.
+ * @param  num_points:   Number of calibration points (>= 2).
+ * @param  frame_ns:     PWM frame period in ns (e.g. 20,000,000).
+ * @param  frame_counts: PWM frame period in timer counts (TIMx_ARR + 1).
+ * @retval Boolean indicating whether the points were valid and @param lut
+ *         was built.
+ */
+bool servo_lut_build(SERVO_LUT_t *lut,
+                     const SERVO_CAL_POINT_t *points,
+                     uint32_t num_points,
+                     uint32_t frame_ns,
+                     uint32_t frame_counts);
+
+/**
+ * @brief  Convert an angle into a PWM pulse value (timer counts) by linear
+ *         interpolation between LUT points.
+ * @param  lut:       LUT.
+ * @param  angle_q16: Angle in degrees (0..180), Q16.16 fixed-point; limited
+ *                    to this range.
+ * @retval Pulse value (timer counts).
+ */
+uint32_t servo_lut_angle_to_pulse(const SERVO_LUT_t *lut, int32_t angle_q16);
+
+/*============================================================================*/
+
+#endif /* SERVO_LUT_H ========================================================*/
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * @file   shaper.h
+ * @brief  Input shaper header file.
+ *
+ *         Provides:
+ *             - Zero vibration (ZV), zero vibration and derivative (ZVD) and
+ *               extra-insensitive (EI) input shapers designed for a
+ *               vibration mode's natural frequency and damping ratio: a
+ *               sequence of 2..3 impulses (unity sum) at multiples of half
+ *               the damped period, whose convolution with a setpoint
+ *               cancels (ZV/ZVD) or bounds to SHAPER_EI_VIBRATION (EI) the
+ *               mode's residual vibration. ZVD and EI are longer (one damped
+ *               period, not a half) but less sensitive to an error in the
+ *               modelled frequency. The EI shaper is the undamped design with
+ *               the impulses scaled by the damping as for ZVD.
+ *             - Shaping as a sparse FIR filter of the setpoint (CMSIS-DSP
+ *               arm_fir_sparse_f32), i.e. one multiply-accumulate per
+ *               impulse per sample, with the delay line in a caller
+ *               provided buffer.
+ *             - Bumpless design changes: a design is only applied whilst
+ *               the shaper is settled (the input held over the current
+ *               design's duration), and the delay line is refilled with the
+ *               held input.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef SHAPER_H
+#define SHAPER_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define SHAPER_MAX_IMPULSES     3
+#define SHAPER_EI_VIBRATION     0.05f   /* EI shaper's residual vibration at the design frequency (fraction). */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum SHAPER_TYPE_t {
+    SHAPER_TYPE__NONE,          /* Pass-through. */
+    SHAPER_TYPE__ZV,
+    SHAPER_TYPE__ZVD,
+    SHAPER_TYPE__EI,
+    SHAPER_TYPE__NUM
+} SHAPER_TYPE_t;
+
+typedef struct SHAPER_CONFIG_t {
+    SHAPER_TYPE_t type;
+    float32_t period_s;         /* Update (sample) period (s). */
+    float32_t freq_hz;          /* Mode natural frequency (Hz). */
+    float32_t zeta;             /* Mode damping ratio (0..1). */
+} SHAPER_CONFIG_t;
+
+typedef struct SHAPER_DESIGN_t {
+    SHAPER_TYPE_t type;
+    uint16_t num_impulses;
+    float32_t amplitudes[SHAPER_MAX_IMPULSES];  /* Unity sum. */
+    int32_t delays[SHAPER_MAX_IMPULSES];        /* Samples; ascending from 0. */
+} SHAPER_DESIGN_t;
+
+typedef struct SHAPER_t {
+    arm_fir_sparse_instance_f32 instance;
+    SHAPER_DESIGN_t design;
+    float32_t *state;           /* Delay line: max_delay + 1 samples. */
+    uint16_t max_delay;         /* Longest design (samples). */
+    float32_t input_prev;
+    uint32_t held;              /* Updates with the input unchanged. */
+} SHAPER_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Design a shaper.
+ * @param  config: Configuration.
+ * @param  design: Design. Passed by reference.
+ * @retval Boolean indicating whether the configuration is valid (frequency
+ *         above zero, damping ratio 0..1).
+ */
+bool shaper_design(const SHAPER_CONFIG_t *config, SHAPER_DESIGN_t *design);
+
+/**
+ * @brief  Initialise a shaper as a pass-through (SHAPER_TYPE__NONE).
+ * @param  shaper:    Shaper.
+ * @param  state:     Delay line buffer of (@param max_delay + 1) samples.
+ * @param  max_delay: Longest design to be applied (samples).
+ * @param  value:     Initial (held) input.
+ * @retval None.
+ */
+void shaper_init(SHAPER_t *shaper, float32_t *state, uint16_t max_delay, float32_t value);
+
+/**
+ * @brief  Apply a design whilst the shaper is settled.
+ * @param  shaper: Shaper.
+ * @param  design: Design (see shaper_design).
+ * @retval Boolean indicating whether the design was applied: false if it is
+ *         longer than the shaper's maximum delay or the shaper is not
+ *         settled (see shaper_is_settled).
+ */
+bool shaper_set_design(SHAPER_t *shaper, const SHAPER_DESIGN_t *design);
+
+/**
+ * @brief  Reset a shaper's delay line to a held input (the output steps to
+ *         it).
+ * @param  shaper: Shaper.
+ * @param  value:  Held input.
+ * @retval None.
+ */
+void shaper_reset(SHAPER_t *shaper, float32_t value);
+
+/**
+ * @brief  Shape one input sample; call once per update period.
+ * @param  shaper: Shaper.
+ * @param  input:  Input (setpoint).
+ * @retval Shaped output.
+ */
+float32_t shaper_update(SHAPER_t *shaper, float32_t input);
+
+/**
+ * @brief  Retrieve whether a shaper is settled, i.e. its input has been held
+ *         over its design's duration (the output equals the input).
+ * @param  shaper: Shaper.
+ * @retval Boolean indicating settled.
+ */
+bool shaper_is_settled(const SHAPER_t *shaper);
+
+/*============================================================================*/
+
+#endif /* SHAPER_H ===========================================================*/
\ No newline at end of file
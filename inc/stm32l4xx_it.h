@@ -54,10 +54,28 @@ void DebugMon_Handler(void);
 void SysTick_Handler(void);
 
 /**
- * @brief  TIM1 update interrupt and TIM16 global interrupt handler.
+ * @brief  TIM7 global interrupt handler (STM32 HAL time base).
  * @retval None.
  */
-void TIM1_UP_TIM16_IRQHandler(void);
+void TIM7_IRQHandler(void);
+
+/**
+ * @brief  TIM6 global interrupt (and DAC underrun) handler.
+ * @retval None.
+ */
+void TIM6_DAC_IRQHandler(void);
+
+/**
+ * @brief  TIM2 global interrupt handler (servo motor PWM frame).
+ * @retval None.
+ */
+void TIM2_IRQHandler(void);
+
+/**
+ * @brief  DMA1 channel 1 interrupt handler (ADC1 potentiometer feedback).
+ * @retval None.
+ */
+void DMA1_Channel1_IRQHandler(void);
 
 /*============================================================================*/
 
@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * @file   stream.h
+ * @brief  Setpoint stream (timestamped waypoint interpolation) header file.
+ *
+ *         Provides:
+ *             - A lock-free single-producer single-consumer (SPSC) ring of
+ *               timestamped waypoints (one position per axis), e.g. pushed by
+ *               a task receiving a host planner's waypoints at (50..100) Hz
+ *               and consumed by the control loop interrupt. The producer only
+ *               writes the head index and the consumer only the tail index,
+ *               such that neither side blocks or masks the other.
+ *             - Interpolation at the consumer's tick rate (e.g. the control
+ *               loop rate) between consecutive waypoints, either linear or
+ *               cubic (Hermite with Catmull-Rom tangents from the neighbouring
+ *               waypoints; continuous velocity). Playback starts once
+ *               STREAM_PREFILL waypoints are buffered, i.e. with a latency of
+ *               about (STREAM_PREFILL - 1) waypoint periods.
+ *             - Underrun handling: when playback reaches the last buffered
+ *               waypoint it is held (and playback time paused) until the next
+ *               waypoint arrives, or for STREAM_TIMEOUT_US after which the
+ *               stream has ended. A timestamp step larger than
+ *               STREAM_MAX_GAP_US starts a new stream; a waypoint not later
+ *               than its predecessor is discarded.
+ *             - Statistics: fill level (current and minimum whilst playing),
+ *               underruns, overruns (pushes to a full ring) and discarded
+ *               waypoints.
+ *
+ *         The timestamps are in the producer's (host's) time base; the
+ *         consumer does not track the host's clock, so a rate mismatch
+ *         shows as a drifting fill level.
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC.
+ *
+ ******************************************************************************/
+
+#ifndef STREAM_H
+#define STREAM_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define STREAM_QUEUE_LEN            16      /* Waypoints; a power of 2. */
+#define STREAM_MAX_AXES             6
+#define STREAM_PREFILL              3       /* Waypoints buffered before playback starts (>= 3: cubic look-ahead). */
+#define STREAM_MAX_GAP_US           250000  /* Larger timestamp step between waypoints: new stream. */
+#define STREAM_TIMEOUT_US           500000  /* Held (starved) for longer: stream ended. */
+
+#if (STREAM_QUEUE_LEN & (STREAM_QUEUE_LEN - 1)) != 0
+#error "STREAM_QUEUE_LEN must be a power of 2."
+#endif
+#if (STREAM_PREFILL < 3) || (STREAM_PREFILL > STREAM_QUEUE_LEN)
+#error "STREAM_PREFILL must be in the range (3..STREAM_QUEUE_LEN)."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef enum STREAM_INTERP_t {
+    STREAM_INTERP__LINEAR,
+    STREAM_INTERP__CUBIC,       /* Catmull-Rom (continuous velocity). */
+} STREAM_INTERP_t;
+
+typedef enum STREAM_STATE_t {
+    STREAM_STATE__IDLE,         /* Buffering (no output). */
+    STREAM_STATE__ACTIVE,       /* Playing. */
+    STREAM_STATE__STARVED,      /* Underrun: holding the last waypoint. */
+} STREAM_STATE_t;
+
+typedef struct STREAM_WAYPOINT_t {
+    uint32_t timestamp_us;              /* Producer time base (us); may wrap. */
+    int32_t position[STREAM_MAX_AXES];  /* Q16.16. */
+} STREAM_WAYPOINT_t;
+
+typedef struct STREAM_STATS_t {
+    STREAM_STATE_t state;
+    uint32_t fill;              /* Buffered waypoints, including the current segment's. */
+    uint32_t fill_min;          /* Minimum fill whilst playing (since the last reset). */
+    uint32_t underrun_count;
+    uint32_t overrun_count;
+    uint32_t discard_count;     /* Waypoints discarded (timestamp not later than the previous). */
+} STREAM_STATS_t;
+
+typedef struct STREAM_t {
+    STREAM_INTERP_t interp;
+    uint32_t num_axes;
+    uint32_t tick_us;                           /* Playback time per stream_next call. */
+    STREAM_WAYPOINT_t queue[STREAM_QUEUE_LEN];
+    volatile uint32_t head;                     /* Producer: next free slot (free-running). */
+    volatile uint32_t tail;                     /* Consumer: current segment start (free-running). */
+    volatile STREAM_STATE_t state;
+    uint32_t time_us;                           /* Playback time (producer time base). */
+    uint32_t starved_us;                        /* Time held whilst starved. */
+    bool have_prev;                             /* Waypoint preceding the current segment valid (cubic tangent). */
+    STREAM_WAYPOINT_t prev;
+    /* Current segment: p(u) = p0 + c1 u + c2 u^2 + c3 u^3, u = (time - t0) / (t1 - t0). */
+    uint32_t seg_t0;
+    uint32_t seg_t1;
+    float32_t seg_inv_dt;
+    float32_t c1[STREAM_MAX_AXES];
+    float32_t c2[STREAM_MAX_AXES];
+    float32_t c3[STREAM_MAX_AXES];
+    /* Statistics. */
+    uint32_t fill_min;                          /* Consumer. */
+    uint32_t underrun_count;                    /* Consumer. */
+    uint32_t discard_count;                     /* Consumer. */
+    volatile uint32_t overrun_count;            /* Producer. */
+} STREAM_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an (empty, idle) stream.
+ * @param  stream:   Stream.
+ * @param  rate_hz:  Tick rate (Hz), i.e. the rate stream_next is called at;
+ *                   a divisor of 1 MHz.
+ * @param  num_axes: Positions per waypoint (1..STREAM_MAX_AXES).
+ * @param  interp:   Interpolation; see @ref STREAM_INTERP_t.
+ * @retval None.
+ */
+void stream_init(STREAM_t *stream, uint32_t rate_hz, uint32_t num_axes, STREAM_INTERP_t interp);
+
+/**
+ * @brief  Push a waypoint (producer).
+ * @param  stream:   Stream.
+ * @param  waypoint: Waypoint (copied); timestamps are expected to increase.
+ * @retval Boolean indicating whether the waypoint was queued: false if the
+ *         ring is full (overrun).
+ */
+bool stream_push(STREAM_t *stream, const STREAM_WAYPOINT_t *waypoint);
+
+/**
+ * @brief  Step playback by one tick and retrieve the interpolated positions
+ *         (consumer).
+ * @param  stream:   Stream.
+ * @param  position: Positions (Q16.16), num_axes. Passed by reference.
+ * @retval Boolean indicating whether the stream is playing (or holding) and
+ *         @param position was written; false whilst idle.
+ */
+bool stream_next(STREAM_t *stream, int32_t *position);
+
+/**
+ * @brief  Retrieve whether the stream is playing (or holding after an
+ *         underrun).
+ * @param  stream: Stream.
+ * @retval Boolean indicating whether the stream is active.
+ */
+bool stream_is_active(const STREAM_t *stream);
+
+/**
+ * @brief  Retrieve a snapshot of the statistics.
+ * @note   The caller provides the mutual exclusion with the consumer.
+ * @param  stream: Stream.
+ * @param  stats:  Statistics. Passed by reference.
+ * @retval None.
+ */
+void stream_get_stats(const STREAM_t *stream, STREAM_STATS_t *stats);
+
+/**
+ * @brief  Reset the minimum fill level; the counters are cumulative.
+ * @note   The caller provides the mutual exclusion with the consumer.
+ * @param  stream: Stream.
+ * @retval None.
+ */
+void stream_reset_fill_min(STREAM_t *stream);
+
+/*============================================================================*/
+
+#endif /* STREAM_H ===========================================================*/
\ No newline at end of file
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ * @file   sysid.h
+ * @brief  System identification (frequency response) header file.
+ *
+ *         Provides:
+ *             - A periodic excitation signal about a centre position, one
+ *               sample per update, repeated every SYSID_LEN samples: either a
+ *               linear chirp (swept sine, f_min_hz to f_max_hz over each
+ *               period) or a pseudo-random binary sequence (PRBS; a 9-bit
+ *               maximal length LFSR, each bit held for prbs_hold samples,
+ *               restarted every period).
+ *             - Capture of the excitation (input) and the feedback relative
+ *               to the centre (output) into RAM, synchronously averaged over
+ *               a number of periods after a number of settling periods. The
+ *               excitation being exactly periodic, the captured period of
+ *               the (settled) response is too, such that the spectra have no
+ *               leakage without windowing; averaging reduces the feedback
+ *               noise.
+ *             - Computation of the frequency response function (FRF)
+ *               H(k) = Y(k) / U(k) with the CMSIS-DSP real FFT
+ *               (arm_rfft_fast_f32), as a compact result of magnitude (dB)
+ *               and (unwrapped) phase (degrees) per excited frequency bin.
+ *               The computation takes a few milliseconds, so it is run
+ *               separately from the updates (e.g. by a task).
+ *
+ *         The run time is fixed: (settle_periods + periods) x SYSID_LEN
+ *         updates. The phase includes the latency from the excitation
+ *         output to the feedback sample (at least one update period).
+ *
+ * @note   This module has no STM32 HAL/FreeRTOS dependencies such that it can
+ *         be compiled and exercised on a host PC against a plant model.
+ *
+ ******************************************************************************/
+
+#ifndef SYSID_H
+#define SYSID_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+/*===== CMSIS-DSP =====*/
+#include "arm_math.h"
+
+/*===== Defines ==============================================================*/
+
+#define SYSID_LEN                   256     /* Samples per excitation period (FFT length); 256, 512 or 1024. */
+#define SYSID_NUM_BINS              (SYSID_LEN / 2)
+#define SYSID_MIN_INPUT_RATIO       0.01f   /* Bin input power below this fraction of the largest: not excited. */
+
+#if (SYSID_LEN != 256) && (SYSID_LEN != 512) && (SYSID_LEN != 1024)
+#error "SYSID_LEN must be 256, 512 or 1024."
+#endif
+
+/*===== Typedefs =============================================================*/
+
+typedef enum SYSID_SIGNAL_t {
+    SYSID_SIGNAL__CHIRP,
+    SYSID_SIGNAL__PRBS,
+} SYSID_SIGNAL_t;
+
+typedef enum SYSID_STATE_t {
+    SYSID_STATE__IDLE,
+    SYSID_STATE__RUNNING,       /* Exciting and capturing. */
+    SYSID_STATE__CAPTURED,      /* Capture complete; awaiting sysid_compute. */
+    SYSID_STATE__DONE,          /* Result valid. */
+    SYSID_STATE__FAILED,        /* Aborted. */
+} SYSID_STATE_t;
+
+typedef struct SYSID_CONFIG_t {
+    SYSID_SIGNAL_t signal;
+    float32_t period_s;         /* Update (sample) period (s). */
+    float32_t amplitude;        /* Excitation amplitude. */
+    float32_t f_min_hz;         /* Chirp start frequency (Hz). */
+    float32_t f_max_hz;         /* Chirp end frequency (Hz); below the Nyquist frequency. */
+    uint32_t prbs_hold;         /* Samples each PRBS bit is held (>= 1); bandwidth about 0.44 / (prbs_hold x period_s). */
+    uint32_t settle_periods;    /* Periods discarded before capturing. */
+    uint32_t periods;           /* Periods averaged (>= 1). */
+} SYSID_CONFIG_t;
+
+typedef struct SYSID_BIN_t {
+    float32_t freq_hz;
+    float32_t mag_db;           /* 20 log10 |H|. */
+    float32_t phase_deg;        /* Unwrapped over the excited bins. */
+} SYSID_BIN_t;
+
+typedef struct SYSID_t {
+    SYSID_CONFIG_t config;
+    volatile SYSID_STATE_t state;
+    float32_t centre;
+    uint32_t index;             /* Sample in the current period. */
+    uint32_t period;            /* Periods since the start. */
+    uint16_t lfsr;              /* PRBS shift register. */
+    float32_t excitation;       /* Output at the current index. */
+    /**
+     * Accumulated input/output per sample; after computing, the magnitude
+     * (dB; output) and phase (degrees; input) per bin. The FFT work buffer
+     * holds the input spectrum.
+     */
+    float32_t input[SYSID_LEN];
+    float32_t output[SYSID_LEN];
+    float32_t work[SYSID_LEN];
+    bool excited[SYSID_NUM_BINS];
+} SYSID_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Start an identification run.
+ * @param  sysid:  Identifier.
+ * @param  config: Configuration (copied into @param sysid).
+ * @param  centre: Excitation centre, i.e. the (held) setpoint.
+ * @retval None.
+ */
+void sysid_start(SYSID_t *sysid, const SYSID_CONFIG_t *config, float32_t centre);
+
+/**
+ * @brief  Run one update with a feedback sample: captures it with the
+ *         excitation output since the previous update, and steps the
+ *         excitation; call once per sample period whilst running.
+ * @param  sysid:    Identifier.
+ * @param  feedback: Feedback (plant output).
+ * @retval Excitation to add to the centre until the next update; zero once
+ *         the capture is complete.
+ */
+float32_t sysid_update(SYSID_t *sysid, float32_t feedback);
+
+/**
+ * @brief  Abort a running identification (failed).
+ * @param  sysid: Identifier.
+ * @retval None.
+ */
+void sysid_abort(SYSID_t *sysid);
+
+/**
+ * @brief  Compute the frequency response from a complete capture (state
+ *         captured; else no effect).
+ * @note   Not for interrupt context: two SYSID_LEN point FFTs and a log10 and
+ *         an atan2 per bin.
+ * @param  sysid: Identifier.
+ * @retval Boolean indicating whether the result was computed.
+ */
+bool sysid_compute(SYSID_t *sysid);
+
+/**
+ * @brief  Retrieve the identification state.
+ * @param  sysid: Identifier.
+ * @retval State; see @ref SYSID_STATE_t.
+ */
+SYSID_STATE_t sysid_get_state(const SYSID_t *sysid);
+
+/**
+ * @brief  Retrieve the frequency response at a bin.
+ * @param  sysid: Identifier.
+ * @param  bin:   Bin (1..SYSID_NUM_BINS - 1); frequency bin / (SYSID_LEN x
+ *                period_s).
+ * @param  result: Frequency response. Passed by reference.
+ * @retval Boolean indicating whether @param result is valid: false if the
+ *         result is not computed or the bin was not excited.
+ */
+bool sysid_get_bin(const SYSID_t *sysid, uint32_t bin, SYSID_BIN_t *result);
+
+/*============================================================================*/
+
+#endif /* SYSID_H ============================================================*/
\ No newline at end of file
@@ -10,11 +10,57 @@
 
 /*===== Defines ==============================================================*/
 
-#define TIMER_TIM2_PWM_PRESCALER            (800)  /* TIM2_PSC prescaler register value. */
+/**
+ * TIM2 PWM resolution mode:
+ *     - 1: High-resolution; TIM2's 32-bit counter runs at the full 80 MHz
+ *          (12.5 ns per count, 160,000 counts across the 0.5..2.5 ms pulse 
+ *          range).
+ *     - 0: Low-resolution; counter prescaled to 100 kHz (10 us per count, 
+ *          200 counts across the 0.5..2.5 ms pulse range).
+ */
+#define TIMER_TIM2_PWM_HIGH_RES             1
+
+#if (TIMER_TIM2_PWM_HIGH_RES == 1)
+#define TIMER_TIM2_PWM_PRESCALER            (1)       /* TIM2_PSC prescaler register value. */
+#define TIMER_TIM2_PWM_COUNTER              (1600000) /* TIM2_ARR auto-reload register value. */
+#else
+#define TIMER_TIM2_PWM_PRESCALER            (800)     /* TIM2_PSC prescaler register value. */
+#define TIMER_TIM2_PWM_COUNTER              (2000)    /* TIM2_ARR auto-reload register value. */
+#endif
 #define TIMER_TIM2_PWM_PRESCALER_0INDEXED   (TIMER_TIM2_PWM_PRESCALER - 1)
-#define TIMER_TIM2_PWM_COUNTER              (2000) /* TIM2_ARR auto-reload register value. */
 #define TIMER_TIM2_PWM_COUNTER_0INDEXED     (TIMER_TIM2_PWM_COUNTER - 1)
-#define TIMER_TIM2_PWM_PULSE                (0)    /* TIM2_CCR1 capture/compare register 1 initial value. */
+
+/**
+ * TIM15/TIM16 have 16-bit counters; the 80 MHz clock is prescaled to 3.2 MHz
+ * (312.5 ns per count) such that a 20 ms period fits within the counter.
+ */
+#define TIMER_TIM15_16_PWM_PRESCALER        (25)      /* TIMx_PSC prescaler register value. */
+#define TIMER_TIM15_16_PWM_COUNTER          (64000)   /* TIMx_ARR auto-reload register value. */
+
+#define TIMER_PWM_PULSE                     (0)       /* TIMx_CCRx capture/compare register initial value. */
+
+/**
+ * PWM update mode:
+ *     - 1: DMA burst; the TIMx_CCRy registers of a timer are written from a
+ *          per-frame array in RAM by one DMA burst (TIMx_DMAR/TIMx_DCR)
+ *          triggered by the update event (see timer_pwm_dma_burst_start).
+ *     - 0: The CPU writes the TIMx_CCRy registers.
+ */
+#define TIMER_PWM_DMA_BURST                 1
+#define TIMER_PWM_DMA_BURST_MAX_CHANNELS    (4)       /* TIMx_CCR1..TIMx_CCR4. */
+
+#define TIMER_TIM6_CTRL_COUNTER_CLK_HZ      (1000000) /* TIM6 counter clock (after prescaling). */
+#define TIMER_TIM6_CTRL_IRQ_PRIORITY        (5)       /* TIM6 update interrupt priority. */
+
+#define TIMER_TIM2_FRAME_IRQ_PRIORITY       (5)       /* TIM2 update (PWM frame) interrupt priority. */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum TIMER_PWM_ID_t {
+    TIMER_PWM_ID__TIM2,  /* 32-bit, channels 1..4. */
+    TIMER_PWM_ID__TIM15, /* 16-bit, channels 1..2. */
+    TIMER_PWM_ID__TIM16, /* 16-bit, channel 1. */
+} TIMER_PWM_ID_t;
 
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
@@ -23,7 +69,7 @@
 /*===== STM32 HAL Time Base ==================================================*/
 
 /**
- * @brief  This function configures the TIM16 as a time base source.
+ * @brief  This function configures the TIM7 as a time base source.
  *         The time source is configured to have 1ms time base with a dedicated
  *         Tick interrupt priority.
  * @note   This function is called automatically at the beginning of the program 
@@ -36,14 +82,14 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
 
 /**
  * @brief  Suspend tick increment.
- * @note   Disable the tick increment by disabling the TIM16 update interrupt.
+ * @note   Disable the tick increment by disabling the TIM7 update interrupt.
  * @retval None.
  */
 void HAL_SuspendTick(void);
 
 /**
  * @brief  Resume tick increment.
- * @note   Enable the tick increment by enabling the TIM16 update interrupt.
+ * @note   Enable the tick increment by enabling the TIM7 update interrupt.
  * @retval None.
  */
 void HAL_ResumeTick(void);
@@ -55,55 +101,277 @@ void HAL_ResumeTick(void);
  */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
 
-/*===== TIM2 (Servo Motor PWM) ===============================================*/
+/*===== PWM Timers (Servo Motors) ============================================*/
 
 /**
- * @brief  TIM2CH1 PWM initialisation
+ * @brief  PWM timer (time base) initialisation; call once per timer before
+ *         initialising its channels with timer_pwm_channel_init.
  * 
  *         PWM period and pulse-width (i.e. duty-cycle) setup:
  *             - PWM period:
  *                 - Timer period (seconds) = [1 / [[CLK(Hz)/prescaler]/counter]]
- *                 - TIM2 uses APB1 clock of 80 MHz.
- *                 - Prescaler of 800 reduces the 80 MHz clock for the timer
- *                   to 100 kHz (80 MHz / 800 = 100 kHz); prescaler is loaded
- *                   into the TIM2_PSC register.
- *                 - A counter value of 2000 in the auto-reload register
- *                   sets the timer frequency to 50 Hz (100 kHz / 2000 = 50 Hz);
- *                   the counter is loaded into the TIM2_ARR register.
+ *                 - The timers use the APB1 (TIM2) or APB2 (TIM15/16) clock
+ *                   of 80 MHz.
+ *                 - TIM2 high-resolution mode (TIMER_TIM2_PWM_HIGH_RES == 1):
+ *                     - Prescaler of 1 keeps the timer clock at 80 MHz.
+ *                     - A counter value of 1,600,000 in the (32-bit) 
+ *                       auto-reload register sets the timer frequency to 
+ *                       50 Hz (80 MHz / 1,600,000 = 50 Hz).
+ *                 - TIM2 low-resolution mode (TIMER_TIM2_PWM_HIGH_RES == 0):
+ *                     - Prescaler of 800 reduces the 80 MHz clock for the 
+ *                       timer to 100 kHz (80 MHz / 800 = 100 kHz).
+ *                     - A counter value of 2000 in the auto-reload register
+ *                       sets the timer frequency to 50 Hz (100 kHz / 2000 = 
+ *                       50 Hz).
+ *                 - TIM15/TIM16:
+ *                     - Prescaler of 25 reduces the 80 MHz clock for the 
+ *                       timer to 3.2 MHz (80 MHz / 25 = 3.2 MHz).
+ *                     - A counter value of 64000 in the (16-bit) auto-reload
+ *                       register sets the timer frequency to 50 Hz 
+ *                       (3.2 MHz / 64000 = 50 Hz).
+ *                 - The prescaler is loaded into the TIMx_PSC register and
+ *                   the counter into the TIMx_ARR register.
  *                 - A timer frequency of 50 Hz gives a period of 20 ms.
  *             - Pulse-width (duty cycle):
- *                 - The value in the TIM2_CCR1 register determines the pulse
+ *                 - The value in the TIMx_CCRy register determines the pulse
  *                   width, where the value is (0..counter) where counter
- *                   is the value in the TIM2_ARR register. For example, 
+ *                   is the value in the TIMx_ARR register. For example, 
  *                   value = counter/4 would give a pulse-width of 5 ms (duty 
  *                   cycle of 25%).
  * 
+ *             - Preload (double-buffering):
+ *                 - TIMx_ARR and TIMx_CCRy are preloaded (ARPE and OCyPE
+ *                   set); a write lands in the preload register and is
+ *                   transferred to the active (shadow) register at the next
+ *                   update event (counter overflow), i.e. at the start of
+ *                   the next 20 ms frame. A write can therefore never
+ *                   truncate or double the pulse of the current frame.
+ *                 - Writes to several channels are latched at the same
+ *                   update event if made within a timer_pwm_update_hold
+ *                   (true/false) pair.
+ *                 - In DMA burst mode the TIMx_CCRy registers are instead
+ *                   written at the update event; see
+ *                   timer_pwm_dma_burst_start.
+ * 
  *          Key registers:
- *              - Prescaler:   TIM2_PSC   prescaler register
- *              - Counter:     TIM2_ARR   auto-reload register 
- *              - Pulse-width: TIM2_CCR1  capture/compare register 1
+ *              - Prescaler:   TIMx_PSC   prescaler register
+ *              - Counter:     TIMx_ARR   auto-reload register 
+ *              - Pulse-width: TIMx_CCRy  capture/compare register y
  * 
+ * @param  id: PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @retval None.
+ */
+void timer_pwm_init(TIMER_PWM_ID_t id);
+
+/**
+ * @brief  PWM timer channel initialisation (PWM mode 1, active high).
+ * @note   The channel's GPIO (alternate function) is configured by the caller.
+ * @param  id:      PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  channel: Timer channel; TIM_CHANNEL_x where x can be (1..4).
+ * @retval None.
+ */
+void timer_pwm_channel_init(TIMER_PWM_ID_t id, uint32_t channel);
+
+/**
+ * @brief  Start/stop a PWM timer channel.
+ * @note   Stopping gates the channel's output only: the timer's counter (its
+ *         frame, and any trigger; see timer_pwm_trigger_init) keeps running.
+ *         The first start also starts the counter.
+ * @param  id:      PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  channel: Timer channel; TIM_CHANNEL_x where x can be (1..4).
+ * @param  state:   true|false = start|stop PWM.
+ * @retval None.
+ */
+void timer_pwm_enable(TIMER_PWM_ID_t id, uint32_t channel, bool state);
+
+/**
+ * @brief  Retrieve the PWM period of a timer in counts (i.e. TIMx_ARR + 1).
+ * @param  id: PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @retval PWM period in timer counts.
+ */
+uint32_t timer_pwm_get_counter(TIMER_PWM_ID_t id);
+
+/**
+ * @brief  Retrieve a pointer to a PWM timer channel's capture/compare register
+ *         (TIMx_CCRy); used to set the PWM pulse value (pulse-width / 
+ *         duty-cycle) with a single store, where the pulse is 
+ *         (0..[TIMx_ARR value]). For example, pulse = counter/4 would give a
+ *         pulse-width of 5 ms (duty cycle of 25%).
+ * @param  id:      PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  channel: Timer channel; TIM_CHANNEL_x where x can be (1..4).
+ * @retval Pointer to the TIMx_CCRy register.
+ */
+volatile uint32_t *timer_pwm_get_ccr(TIMER_PWM_ID_t id, uint32_t channel);
+
+/**
+ * @brief  Set a PWM timer channel's pulse value (used to set PWM pulse-width /
+ *         duty-cycle).
+ * @param  id:      PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  channel: Timer channel; TIM_CHANNEL_x where x can be (1..4).
+ * @param  pulse:   Set pulse-width where pulse is (0..[TIMx_ARR value]).
+ * @retval None.
+ */
+void timer_pwm_set_pulse(TIMER_PWM_ID_t id, uint32_t channel, uint32_t pulse);
+
+/**
+ * @brief  Hold/release the update event of a PWM timer (TIMx_CR1 UDIS bit).
+ *
+ *         Whilst held, the preload registers are not transferred to the
+ *         active registers; the counter still overflows but the update event
+ *         (and its interrupt) of that overflow is suppressed. Used to write
+ *         several TIMx_CCRy registers such that they all take effect at the
+ *         same update event.
+ *
+ * @note   Hold for as short a time as possible (i.e. register writes only);
+ *         an update event suppressed by the hold is lost, the preload
+ *         registers are then transferred at the next one. Regenerating it
+ *         (timer_pwm_sync) would restart the frame, i.e. shift its phase.
+ * @param  id:   PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  hold: true|false = hold|release.
+ * @retval None.
+ */
+void timer_pwm_update_hold(TIMER_PWM_ID_t id, bool hold);
+
+/**
+ * @brief  Retrieve a PWM timer's counter value (TIMx_CNT), i.e. the time
+ *         elapsed in the current frame in timer counts.
+ * @param  id: PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @retval Counter value (0..[TIMx_ARR value]).
+ */
+uint32_t timer_pwm_get_count(TIMER_PWM_ID_t id);
+
+/**
+ * @brief  Restart the frames of all (initialised) PWM timers together by
+ *         generating an update event (TIMx_EGR UG bit) on each timer
+ *         back-to-back: the counters are reset and the preload registers
+ *         are transferred to the active registers.
+ *
+ *         All PWM timers are clocked at 80 MHz and have a 20 ms period, so
+ *         once restarted together their frames remain aligned; as such,
+ *         TIM2's update event marks the frame boundary of all PWM timers.
+ *
+ * @retval None.
+ */
+void timer_pwm_sync(void);
+
+/**
+ * @brief  Configure a PWM timer channel (without an output pin) as a trigger
+ *         source at a fixed offset within each frame: the channel runs in
+ *         PWM mode 2 such that its reference signal (OCyREF) rises when the
+ *         counter reaches @param offset, and OCyREF is routed to the timer's
+ *         trigger output (TRGO), for example, to trigger ADC conversions.
+ * @note   The PWM frames are aligned (see timer_pwm_sync), i.e. the offset
+ *         is relative to the frame boundary of all PWM timers.
+ * @note   The channel's output is enabled (no pin is routed to it). The
+ *         timer's counter is started by timer_pwm_enable.
+ * @param  id:      PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  channel: Timer channel; TIM_CHANNEL_x where x can be (1..2).
+ * @param  offset:  Trigger offset from the frame boundary in timer counts
+ *                  (1..[TIMx_ARR value]).
+ * @retval None.
+ */
+void timer_pwm_trigger_init(TIMER_PWM_ID_t id, uint32_t channel, uint32_t offset);
+
+/**
+ * @brief  Start DMA burst writes of a PWM timer's TIMx_CCR1..TIMx_CCRn
+ *         registers from a per-frame array of pulse values.
+ *
+ *             - Each update event (frame boundary) requests one burst of
+ *               @param num_channels transfers (circular DMA, no interrupts),
+ *               i.e. the CPU cost per frame is independent of the number of
+ *               channels and all channels are written back-to-back.
+ *             - The compare preload (OCyPE) of the burst channels is
+ *               disabled: the burst itself is the latch, writing the active
+ *               registers at the start of the frame (well before the earliest
+ *               compare match at 0.5 ms), such that the values in the array
+ *               at the update event apply to the frame that it starts.
+ *             - The array is written by the caller; hold the update event
+ *               (see timer_pwm_update_hold) whilst writing several values
+ *               such that a burst cannot occur in between.
+ *
+ * @param  id:           PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @param  frame:        Pulse values for channels 1..@param num_channels;
+ *                       must remain valid whilst the burst writes run.
+ * @param  num_channels: Number of channels (1..TIMER_PWM_DMA_BURST_MAX_CHANNELS).
+ * @retval None.
+ */
+void timer_pwm_dma_burst_start(TIMER_PWM_ID_t id, uint32_t *frame, uint32_t num_channels);
+
+/**
+ * @brief  Stop DMA burst writes of a PWM timer (see timer_pwm_dma_burst_start).
+ * @param  id: PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @retval None.
+ */
+void timer_pwm_dma_burst_stop(TIMER_PWM_ID_t id);
+
+/**
+ * @brief  Enable/disable the TIM2 update interrupt, i.e. an interrupt at the
+ *         start of each PWM frame (see timer_tim2_period_elapsed_callback).
+ * @note   The update interrupt priority (TIMER_TIM2_FRAME_IRQ_PRIORITY) is
+ *         numerically >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ * @param  state: true|false = enable|disable.
+ * @retval None.
+ */
+void timer_tim2_frame_it_enable(bool state);
+
+/*===== TIM6 (Servo Motor Control Loop Time Base) ============================*/
+
+/**
+ * @brief  TIM6 initialisation as a fixed-rate time base for the servo motor
+ *         control loop.
+ *
+ *             - TIM6 uses the APB1 clock of 80 MHz, prescaled to a 1 MHz
+ *               counter clock (TIMER_TIM6_CTRL_COUNTER_CLK_HZ).
+ *             - The auto-reload register is set to generate an update
+ *               interrupt at @param rate_hz.
+ *             - The update interrupt priority (TIMER_TIM6_CTRL_IRQ_PRIORITY)
+ *               is numerically >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+ *               such that the "FromISR" FreeRTOS API may be used within
+ *               timer_tim6_period_elapsed_callback.
+ *
+ * @param  rate_hz: Update interrupt rate in Hz.
  * @retval None.
  */
-void timer_tim2_pwm_init(void);
+void timer_tim6_ctrl_init(uint32_t rate_hz);
+
+/**
+ * @brief  Start/stop TIM6 (and its update interrupt).
+ * @param  state: true|false = start|stop.
+ * @retval None.
+ */
+void timer_tim6_ctrl_enable(bool state);
+
+/**
+ * @brief  Set the TIM6 counter value (TIMx_CNT); used to set the phase of
+ *         the time base, for example, relative to the PWM frame.
+ * @param  count: Counter value in TIMER_TIM6_CTRL_COUNTER_CLK_HZ counts
+ *                (0..[TIMx_ARR value]).
+ * @retval None.
+ */
+void timer_tim6_ctrl_set_count(uint32_t count);
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
 
 /**
- * @brief  Start/stop TIM2CH1 PWM.
- * @param  state: true|false = start|stop PWM.
+ * @brief  TIM6 update (period elapsed) call-back; invoked from the TIM6
+ *         interrupt at the rate set by timer_tim6_ctrl_init.
+ * @note   IMPORTANT: The user can over-write this function with their own 
+ *         implementation.
  * @retval None.
  */
-void timer_tim2_pwm_enable(bool state);
+__weak void timer_tim6_period_elapsed_callback(void);
 
 /**
- * @brief  Set TIM2CH1 PWM pulse value (used to set PWM pulse-width / duty-cycle).
- * @param  pulse: Set pulse-width where pulse is (0..[TIMx_ARR value]). Note that
- *                the TIMx_ARR value is the auto-reload register counter value
- *                set during timer initialisation (".Period" field). For example, 
- *                pulse = counter/4 would give a pulse-width of 5 ms (duty cycle 
- *                of 25%).
+ * @brief  TIM2 update (period elapsed) call-back; invoked from the TIM2
+ *         interrupt at the start of each 20 ms PWM frame, once enabled by
+ *         timer_tim2_frame_it_enable.
+ * @note   IMPORTANT: The user can over-write this function with their own 
+ *         implementation.
  * @retval None.
  */
-void timer_tim2_pwm_set_pulse(uint32_t pulse);
+__weak void timer_tim2_period_elapsed_callback(void);
 
 /*============================================================================*/
 
@@ -8,6 +8,14 @@
 
 #include "main.h"
 
+/*===== Defines ==============================================================*/
+
+/**
+ * Circular DMA receive buffer size (bytes); must hold the data received
+ * between two usart_rx calls (115200 baud: ~11.5 bytes per ms).
+ */
+#define USART_RX_BUFF_SIZE          256
+
 /*===== Typedefs =============================================================*/
 
 typedef enum USART_ID_t {
@@ -22,7 +30,8 @@ typedef enum USART_ID_t {
 /**
  * @brief  Initialise UART/USART.
  * 
- *             (+) USART2: NUCLEO-L433RC-P virtual COM port.
+ *             (+) USART2: NUCLEO-L433RC-P virtual COM port; reception by
+ *                 circular DMA (see usart_rx).
  * 
  * @retval None.
  */
@@ -66,6 +75,18 @@ bool usart_get_instance(USART_ID_t id, USART_TypeDef **return_var);
  */
 void usart_tx(UART_HandleTypeDef *handle, uint8_t *data, uint32_t data_len, uint32_t timeout);
 
+/**
+ * @brief  USART receive (non-blocking): retrieve the data received by the
+ *         circular DMA (started by usart_init) since the previous call.
+ * @note   Data older than USART_RX_BUFF_SIZE bytes is overwritten if not
+ *         retrieved in time.
+ * @param  handle:   HAL USART handle pointer.
+ * @param  data:     Pointer to data array to receive into.
+ * @param  data_len: Length of the data array (i.e. sizeof(data)).
+ * @retval Number of bytes received into @param data (0..@param data_len).
+ */
+uint32_t usart_rx(UART_HandleTypeDef *handle, uint8_t *data, uint32_t data_len);
+
 /*============================================================================*/
 
 #endif /* USART_H ============================================================*/
\ No newline at end of file
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * @file   adc.c
+ * @brief  ADC source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "adc.h"
+
+/*===== Handles ==============================================================*/
+ADC_HandleTypeDef hadc1;
+
+/*===== Buffers ==============================================================*/
+
+/* Circular DMA buffer: two blocks (halves) of ADC_SCANS_PER_BLOCK scans. */
+static uint16_t _samples[2 * ADC_SCANS_PER_BLOCK * ADC_MAX_CHANNELS];
+static uint32_t _num_channels;
+
+/* Regular sequencer ranks (not consecutive values). */
+static const uint32_t _ranks[ADC_MAX_CHANNELS] = {
+    ADC_REGULAR_RANK_1, ADC_REGULAR_RANK_2, ADC_REGULAR_RANK_3, ADC_REGULAR_RANK_4,
+    ADC_REGULAR_RANK_5, ADC_REGULAR_RANK_6, ADC_REGULAR_RANK_7, ADC_REGULAR_RANK_8,
+};
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void adc_init(const uint32_t *channels, uint32_t num_channels, uint32_t trigger)
+{
+    ADC_ChannelConfTypeDef config_channel = {0};
+
+    assert((num_channels >= 1) && (num_channels <= ADC_MAX_CHANNELS));
+    _num_channels = num_channels;
+
+    hadc1.Instance = ADC1;
+    hadc1.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+    hadc1.Init.Resolution = ADC_RESOLUTION_12B;
+    hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc1.Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+    hadc1.Init.LowPowerAutoWait = DISABLE;
+    hadc1.Init.NbrOfConversion = num_channels;
+    hadc1.Init.DiscontinuousConvMode = DISABLE;
+    hadc1.Init.ExternalTrigConv = trigger;
+    if (trigger == ADC_SOFTWARE_START)
+    {
+        hadc1.Init.ContinuousConvMode = ENABLE;
+        hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    }
+    else
+    {
+        hadc1.Init.ContinuousConvMode = DISABLE;
+        hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+    }
+    hadc1.Init.DMAContinuousRequests = ENABLE;
+    hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
+    hadc1.Init.OversamplingMode = ENABLE;
+    hadc1.Init.Oversampling.Ratio = ADC_OVERSAMPLING_RATIO;
+    hadc1.Init.Oversampling.RightBitShift = ADC_OVERSAMPLING_SHIFT;
+    hadc1.Init.Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+    hadc1.Init.Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+    if (HAL_ADC_Init(&hadc1) != HAL_OK)
+    {
+        error_handler();
+    }
+
+    config_channel.SamplingTime = ADC_SAMPLING_TIME;
+    config_channel.SingleDiff = ADC_SINGLE_ENDED;
+    config_channel.OffsetNumber = ADC_OFFSET_NONE;
+    config_channel.Offset = 0;
+    for (uint32_t i = 0; i < num_channels; i++)
+    {
+        config_channel.Channel = channels[i];
+        config_channel.Rank = _ranks[i];
+        if (HAL_ADC_ConfigChannel(&hadc1, &config_channel) != HAL_OK)
+        {
+            error_handler();
+        }
+    }
+
+    if (HAL_ADCEx_Calibration_Start(&hadc1, ADC_SINGLE_ENDED) != HAL_OK)
+    {
+        error_handler();
+    }
+}
+
+void adc_enable(bool state)
+{
+    if (state)
+    {
+        if (HAL_ADC_Start_DMA(&hadc1, (uint32_t *)_samples, 2 * ADC_SCANS_PER_BLOCK * _num_channels) != HAL_OK)
+        {
+            error_handler();
+        }
+    }
+    else
+    {
+        HAL_ADC_Stop_DMA(&hadc1);
+    }
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+    {
+        adc_block_ready_callback(&_samples[0], ADC_SCANS_PER_BLOCK);
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+    {
+        adc_block_ready_callback(&_samples[ADC_SCANS_PER_BLOCK * _num_channels], ADC_SCANS_PER_BLOCK);
+    }
+}
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
+
+__weak void adc_block_ready_callback(const uint16_t *samples, uint32_t num_scans)
+{
+    /* Over-written by the user project. */
+    UNUSED(samples);
+    UNUSED(num_scans);
+}
+
+/*============================================================================*/
\ No newline at end of file
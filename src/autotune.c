@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * @file   autotune.c
+ * @brief  Relay feedback PID auto-tuning source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "autotune.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Private Function Prototypes ==========================================*/
+static void cycle_start(AUTOTUNE_t *tune);
+static void finish(AUTOTUNE_t *tune);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void autotune_start(AUTOTUNE_t *tune, const AUTOTUNE_CONFIG_t *config, float32_t centre)
+{
+    memset(tune, 0, sizeof(*tune));
+    tune->config = *config;
+    if (tune->config.measure_cycles < 1)
+    {
+        tune->config.measure_cycles = 1;
+    }
+    tune->centre = centre;
+    tune->relay_high = true;
+    tune->peak_max = centre;
+    tune->peak_min = centre;
+    tune->state = AUTOTUNE_STATE__RUNNING;
+}
+
+float32_t autotune_update(AUTOTUNE_t *tune, float32_t feedback)
+{
+    if (tune->state != AUTOTUNE_STATE__RUNNING)
+    {
+        return 0.0f;
+    }
+
+    tune->tick++;
+    tune->peak_max = (feedback > tune->peak_max) ? feedback : tune->peak_max;
+    tune->peak_min = (feedback < tune->peak_min) ? feedback : tune->peak_min;
+
+    /* Relay with hysteresis: output high below the centre, low above it. */
+    float32_t error = tune->centre - feedback;
+    if (tune->relay_high && (error < -tune->config.hysteresis))
+    {
+        tune->relay_high = false;
+        tune->switch_tick = tune->tick;
+    }
+    else if ((tune->relay_high == false) && (error > tune->config.hysteresis))
+    {
+        tune->relay_high = true;
+        tune->switch_tick = tune->tick;
+        cycle_start(tune);
+    }
+
+    if ((tune->state == AUTOTUNE_STATE__RUNNING) &&
+        (((float32_t)(tune->tick - tune->switch_tick) * tune->config.period_s) > tune->config.timeout_s))
+    {
+        tune->state = AUTOTUNE_STATE__FAILED;
+    }
+
+    if (tune->state != AUTOTUNE_STATE__RUNNING)
+    {
+        return 0.0f;
+    }
+    return tune->relay_high ? tune->config.amplitude : -tune->config.amplitude;
+}
+
+void autotune_abort(AUTOTUNE_t *tune)
+{
+    if (tune->state == AUTOTUNE_STATE__RUNNING)
+    {
+        tune->state = AUTOTUNE_STATE__FAILED;
+    }
+}
+
+AUTOTUNE_STATE_t autotune_get_state(const AUTOTUNE_t *tune)
+{
+    return tune->state;
+}
+
+bool autotune_get_result(const AUTOTUNE_t *tune, AUTOTUNE_RESULT_t *result)
+{
+    if (tune->state != AUTOTUNE_STATE__DONE)
+    {
+        return false;
+    }
+    *result = tune->result;
+    return true;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Relay switched high: the previous cycle (if any) is complete.
+ *         Measures it once the settling cycles have passed, and finishes
+ *         once measure_cycles consistent cycles are measured; inconsistent
+ *         measurements restart the measurement (bounded by max_cycles).
+ * @param  tune: Auto-tuner.
+ * @retval None.
+ */
+static void cycle_start(AUTOTUNE_t *tune)
+{
+    if ((tune->cycles > 0) && (tune->cycles > tune->config.settle_cycles))
+    {
+        uint32_t period = tune->tick - tune->cycle_tick;
+        float32_t amplitude = 0.5f * (tune->peak_max - tune->peak_min);
+
+        if (tune->measured == 0)
+        {
+            tune->period_min = period;
+            tune->period_max = period;
+        }
+        tune->period_min = (period < tune->period_min) ? period : tune->period_min;
+        tune->period_max = (period > tune->period_max) ? period : tune->period_max;
+        tune->period_sum += period;
+        tune->amplitude_sum += amplitude;
+        tune->measured++;
+
+        if (tune->measured >= tune->config.measure_cycles)
+        {
+            float32_t mean = (float32_t)tune->period_sum / (float32_t)tune->measured;
+            if ((float32_t)(tune->period_max - tune->period_min) <= (AUTOTUNE_PERIOD_TOLERANCE * mean))
+            {
+                finish(tune);
+                return;
+            }
+            /* Not yet a steady limit cycle: measure again. */
+            tune->measured = 0;
+            tune->period_sum = 0;
+            tune->amplitude_sum = 0.0f;
+        }
+    }
+
+    tune->cycles++;
+    if (tune->cycles > tune->config.max_cycles)
+    {
+        tune->state = AUTOTUNE_STATE__FAILED;
+        return;
+    }
+    tune->cycle_tick = tune->tick;
+    tune->peak_max = tune->centre;
+    tune->peak_min = tune->centre;
+}
+
+/**
+ * @brief  Compute the ultimate gain/period and the PID gains, and finish.
+ *         Ki = Kp / Ti, Kd = Kp x Td with (Kp, Ti, Td):
+ *             - Ziegler-Nichols PI:  (0.45 Ku, Tu / 1.2, 0).
+ *             - Ziegler-Nichols PID: (0.6 Ku, Tu / 2, Tu / 8).
+ *             - Tyreus-Luyben PID:   (Ku / 2.2, 2.2 Tu, Tu / 6.3).
+ * @param  tune: Auto-tuner.
+ * @retval None.
+ */
+static void finish(AUTOTUNE_t *tune)
+{
+    AUTOTUNE_RESULT_t *result = &tune->result;
+    float32_t a = tune->amplitude_sum / (float32_t)tune->measured;
+    float32_t e = tune->config.hysteresis;
+    float32_t ti;
+    float32_t td;
+
+    if (a <= e)
+    {
+        tune->state = AUTOTUNE_STATE__FAILED;
+        return;
+    }
+
+    float32_t root;
+    arm_sqrt_f32((a * a) - (e * e), &root);
+    result->amplitude = a;
+    result->ku = (4.0f * tune->config.amplitude) / (PI * root);
+    result->tu_s = ((float32_t)tune->period_sum / (float32_t)tune->measured) * tune->config.period_s;
+
+    switch (tune->config.rule)
+    {
+        case AUTOTUNE_RULE__ZN_PI:
+            result->kp = 0.45f * result->ku;
+            ti = result->tu_s / 1.2f;
+            td = 0.0f;
+            break;
+        case AUTOTUNE_RULE__ZN_PID:
+            result->kp = 0.6f * result->ku;
+            ti = 0.5f * result->tu_s;
+            td = 0.125f * result->tu_s;
+            break;
+        case AUTOTUNE_RULE__TL_PID:
+        default:
+            result->kp = result->ku / 2.2f;
+            ti = 2.2f * result->tu_s;
+            td = result->tu_s / 6.3f;
+            break;
+    }
+    result->ki = result->kp / ti;
+    result->kd = result->kp * td;
+
+    tune->state = AUTOTUNE_STATE__DONE;
+}
+
+/*============================================================================*/
\ No newline at end of file
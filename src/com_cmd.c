@@ -0,0 +1,1069 @@
+/*******************************************************************************
+ * @file   com_cmd.c
+ * @brief  Nucleo COM port commands and telemetry source file.
+ ******************************************************************************/
+
+#include "com_cmd.h"
+#include "op_mode.h"
+#include "servo.h"
+#include "servo_ctrl.h"
+#include "usart.h"
+
+/*===== Defines ==============================================================*/
+
+#define TX_BUFF_MAX             100     /* Transmitted message length (including the terminator). */
+
+/*===== Locks ================================================================*/
+
+static StaticSemaphore_t tx_lock_buffer;
+static SemaphoreHandle_t tx_lock = NULL; /* Serialises the transmissions of the COM port tasks. */
+
+/*===== Private Function Prototypes ==========================================*/
+static void tx(UART_HandleTypeDef *handle, char *data, uint32_t len);
+static void tx_servo_ctrl_stats(UART_HandleTypeDef *handle);
+static void tx_sysid(UART_HandleTypeDef *handle);
+static bool rx_stream_waypoint(char *args);
+static bool rx_coord_move(char *args);
+static bool rx_autotune_start(char *args);
+static bool rx_sysid_start(char *args);
+static bool rx_gain_sched(char *args);
+static bool rx_loop_type(char *args);
+static bool rx_shaper(char *args);
+static bool rx_ilc_start(char *args);
+static bool rx_friction(char *args);
+static bool rx_lms(char *args);
+static bool rx_ik(char *args);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void com_cmd_init(void)
+{
+    tx_lock = freertos_wrapper_mutex_create_static(&tx_lock_buffer);
+}
+
+void com_cmd_execute(UART_HandleTypeDef *handle, char *line)
+{
+    bool accepted = false; /* Unknown commands are rejected. */
+
+    if ((line[0] == 'S') && (line[1] == ' '))
+    {
+        accepted = rx_stream_waypoint(&line[2]);
+    }
+    else if ((line[0] == 'M') && (line[1] == ' '))
+    {
+        accepted = rx_coord_move(&line[2]);
+    }
+    else if ((line[0] == 'A') && (line[1] == ' '))
+    {
+        accepted = rx_autotune_start(&line[2]);
+    }
+    else if ((line[0] == 'I') && (line[1] == ' '))
+    {
+        accepted = rx_sysid_start(&line[2]);
+    }
+    else if ((line[0] == 'G') && (line[1] == ' '))
+    {
+        accepted = rx_gain_sched(&line[2]);
+    }
+    else if ((line[0] == 'L') && (line[1] == ' '))
+    {
+        accepted = rx_loop_type(&line[2]);
+    }
+    else if ((line[0] == 'Z') && (line[1] == ' '))
+    {
+        accepted = rx_shaper(&line[2]);
+    }
+    else if ((line[0] == 'R') && (line[1] == ' '))
+    {
+        accepted = rx_ilc_start(&line[2]);
+    }
+    else if ((line[0] == 'F') && (line[1] == ' '))
+    {
+        accepted = rx_friction(&line[2]);
+    }
+    else if ((line[0] == 'N') && (line[1] == ' '))
+    {
+        accepted = rx_lms(&line[2]);
+    }
+    else if ((line[0] == 'K') && (line[1] == ' '))
+    {
+        accepted = rx_ik(&line[2]);
+    }
+
+    /* Respond: the command accepted ("OK <c>") or rejected ("ERR <c>"), e.g. for the host to pace a stream. */
+    char data[TX_BUFF_MAX] = {0};
+    int len = sprintf(data, "%s %c\r\n", accepted ? "OK" : "ERR", line[0]);
+    tx(handle, data, (uint32_t)len);
+}
+
+void com_cmd_tx_status(UART_HandleTypeDef *handle)
+{
+    char data[TX_BUFF_MAX] = {0};
+    int pos = 0; /* Tx buffer position; for use with sprintf(). */
+
+    /* Construct message. */
+    pos += sprintf(&data[pos], "Operational mode: ");
+    switch (op_mode_get())
+    {
+        case OP_MODE__UNKNOWN:
+            pos += sprintf(&data[pos], "UNKNOWN");
+            break;
+        case OP_MODE__IDLE:
+            pos += sprintf(&data[pos], "IDLE");
+            break;
+        case OP_MODE__MOTOR_RUNNING:
+            pos += sprintf(&data[pos], "MOTOR RUNNING");
+            break;
+        case OP_MODE__AUTOTUNE:
+            pos += sprintf(&data[pos], "AUTO-TUNING");
+            break;
+        case OP_MODE__SYSID:
+            pos += sprintf(&data[pos], "IDENTIFYING");
+            break;
+        case OP_MODE__ERROR_MOTOR:
+            pos += sprintf(&data[pos], "ERROR (MOTOR)");
+            break;
+        case OP_MODE__ERROR_LCD:
+            pos += sprintf(&data[pos], "ERROR (LCD)");
+            break;
+        case OP_MODE__ERROR_PERIPHERALS:
+            pos += sprintf(&data[pos], "ERROR (PERIPHERALS)");
+            break;
+        case OP_MODE__ERROR_FW_FAULT:
+            pos += sprintf(&data[pos], "ERROR (FIRMWARE FAULT)");
+            break;
+        default:
+            break;
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+
+    /* Transmit operational mode. */
+    tx(handle, data, sizeof(data));
+
+    /* Transmit angle (expected). */
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Position (degrees):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pos += sprintf(&data[pos], " %d", servo_get_angle_expected(i));
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    /* Transmit angle (actual); '-' where the position feedback is invalid. */
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Position actual (degrees):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (servo_get_feedback_valid(i))
+        {
+            pos += sprintf(&data[pos], " %d", servo_get_angle_actual(i));
+        }
+        else
+        {
+            pos += sprintf(&data[pos], " -");
+        }
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    /* Transmit estimated velocity and acceleration; '-' where the estimate is invalid. */
+    SERVO_CTRL_STATE_t states[SERVO_NUM_SERVOS];
+    bool states_valid[SERVO_NUM_SERVOS];
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        states_valid[i] = servo_ctrl_get_state(i, &states[i]);
+    }
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Velocity (degrees/s):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (states_valid[i])
+        {
+            pos += sprintf(&data[pos], " %ld", (long)states[i].velocity_deg_s);
+        }
+        else
+        {
+            pos += sprintf(&data[pos], " -");
+        }
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Acceleration (degrees/s^2):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (states_valid[i])
+        {
+            pos += sprintf(&data[pos], " %ld", (long)states[i].acceleration_deg_s2);
+        }
+        else
+        {
+            pos += sprintf(&data[pos], " -");
+        }
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    /* Transmit control loop statistics. */
+    tx_servo_ctrl_stats(handle);
+
+    /* Compute and transmit the frequency response once an identification's capture is complete. */
+    if (servo_ctrl_sysid_process())
+    {
+        tx_sysid(handle);
+    }
+}
+
+void com_cmd_tx_rtos_stats(UART_HandleTypeDef *handle, const TaskHandle_t *tasks, uint32_t num_tasks)
+{
+    char data[TX_BUFF_MAX] = {0};
+    int pos = 0;
+
+    pos = sprintf(data, "Stack free min (words):");
+    for (uint32_t i = 0; i < num_tasks; i++)
+    {
+        pos += sprintf(&data[pos], " %lu", (unsigned long)freertos_wrapper_task_get_stack_free_min(tasks[i]));
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Heap free (bytes): %lu, min %lu of %lu\r\n", (unsigned long)freertos_wrapper_get_heap_free(),
+            (unsigned long)freertos_wrapper_get_heap_free_min(), (unsigned long)configTOTAL_HEAP_SIZE);
+    tx(handle, data, sizeof(data));
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Transmit a message via the Nucleo COM port interface, serialised
+ *         with the other tasks' messages (the blocking HAL transmit rejects
+ *         a transmission whilst another is in progress).
+ * @param  handle: HAL USART handle pointer.
+ * @param  data:   Message.
+ * @param  len:    Message length (bytes).
+ * @retval None.
+ */
+static void tx(UART_HandleTypeDef *handle, char *data, uint32_t len)
+{
+    freertos_wrapper_mutex_take(tx_lock);
+    usart_tx(handle, (uint8_t *)data, len, 1000);
+    freertos_wrapper_mutex_give(tx_lock);
+}
+
+/**
+ * @brief  Construct and transmit a message via the Nucleo COM port interface:
+ *             - Message: control loop rate, jitter and execution time.
+ *             - Message: tracking error (milli-degrees) and controller
+ *               structure.
+ *             - Message: PWM frame updates (late/missed) and control loop
+ *               phase slips.
+ *             - Message: CPU cycles to write the PWM pulses.
+ *             - Message: feedback sample to actuation latency.
+ *             - Message: PWM frames without a feedback sample.
+ *             - Message: feedback filter kernel and CPU cycles per block.
+ *             - Message: state estimator execution time.
+ *             - Message: motion profile execution time (all servos and per
+ *               servo).
+ *             - Message: coordinated moves, last duration and planning time.
+ *             - Message: input shaper per servo and execution time.
+ *             - Message: setpoint stream state, fill level, underruns/overruns
+ *               and execution time.
+ *             - Message: inverse kinematics arm (Cartesian stream), out of
+ *               reach loops and execution time.
+ *             - Message: auto-tuning state and result per servo (if any).
+ *             - Message: MPC execution time per solve, iterations and
+ *               constrained solves.
+ *             - Message: time (ms) each servo's command was saturated at its
+ *               limits, and held by the slew limit.
+ *             - Message: each servo's latched motor fault, with its detection
+ *               latency (fault condition onset to PWM signal cut) and the
+ *               time from the detecting loop's start to the cut.
+ *             - Message: system identification state (if any).
+ *             - Message: gain scheduling state, tables committed and
+ *               execution time.
+ *             - Message: load terms (milli-degrees).
+ *             - Message: iterative learning control state and statistics per
+ *               servo (if any).
+ *             - Message: friction compensation per servo and execution time.
+ *             - Message: friction compensation parameters, observed
+ *               disturbance and holding per enabled servo (if any).
+ *             - Message: friction identification state (if any).
+ *             - Message: adaptive feedforward per servo and execution time.
+ *             - Message: adaptive feedforward blocks adapted and dropped,
+ *               adapting or frozen, and the last block's RMS tracking error
+ *               and feedforward per enabled servo (if any).
+ * @param  handle: HAL USART handle pointer.
+ * @retval None.
+ */
+static void tx_servo_ctrl_stats(UART_HandleTypeDef *handle)
+{
+    char data[TX_BUFF_MAX] = {0};
+    SERVO_CTRL_STATS_t stats;
+    SERVO_FRAME_STATS_t frame_stats;
+    SERVO_FB_STATS_t fb_stats;
+    STREAM_STATS_t stream_stats;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    static const char *filter_names[FILTER_TYPE__NUM] = {"none", "biquad df2T f32", "biquad df1 q31", "FIR q15"};
+    static const char *stream_state_names[] = {"IDLE", "ACTIVE", "STARVED"};
+    static const char *loop_type_names[] = {"PID", "cascade", "MPC"};
+    static const char *shaper_names[SHAPER_TYPE__NUM] = {"none", "ZV", "ZVD", "EI"};
+    static const char *fault_names[MOTOR_FAULT__NUM] = {"none", "stall", "overload", "feedback loss"};
+    static const char *ik_arm_names[IK_ARM__NUM] = {"planar 2-link", "planar 3-link", "spatial 3-DOF"};
+    IK_CONFIG_t ik_config;
+    int pos;
+
+    servo_ctrl_get_stats(&stats);
+    servo_ctrl_get_stream_stats(&stream_stats);
+    servo_ctrl_reset_stats();
+    servo_get_frame_stats(&frame_stats);
+    servo_reset_frame_stats();
+    servo_get_feedback_stats(&fb_stats);
+    servo_reset_feedback_stats();
+
+    uint32_t jitter_us = 0;
+    if (stats.loop_count > 1)
+    {
+        jitter_us = (stats.period_cycles_max - stats.period_cycles_min) / cycles_per_us;
+    }
+    sprintf(data, "Ctrl loop: %lu runs, jitter %lu us, exec %lu/%lu cyc (last/max)\r\n",
+            (unsigned long)stats.loop_count, (unsigned long)jitter_us,
+            (unsigned long)stats.exec_cycles_last, (unsigned long)stats.exec_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Ctrl error (mdeg): %ld (max %ld), feedback %s, %s\r\n",
+            (long)(stats.tracking_error_deg * 1000.0f), (long)(stats.tracking_error_max_deg * 1000.0f),
+            stats.feedback_valid ? "OK" : "NONE", loop_type_names[servo_ctrl_get_loop_type()]);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "PWM frames: %lu, late %lu, missed %lu, phase slips %lu\r\n",
+            (unsigned long)frame_stats.frame_count, (unsigned long)frame_stats.late_count,
+            (unsigned long)frame_stats.missed_count, (unsigned long)stats.frame_slip_count);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "PWM write: %lu/%lu cyc (last/max), DMA burst %s\r\n",
+            (unsigned long)frame_stats.write_cycles_last, (unsigned long)frame_stats.write_cycles_max,
+            (TIMER_PWM_DMA_BURST == 1) ? "ON" : "OFF");
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Feedback latency: %lu us (max %lu us), sample offset %u us\r\n",
+            (unsigned long)(stats.fb_latency_cycles_last / cycles_per_us),
+            (unsigned long)(stats.fb_latency_cycles_max / cycles_per_us),
+            (unsigned int)SERVO_FB_SAMPLE_OFFSET_US);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Feedback missed: %lu frames\r\n", (unsigned long)stats.fb_missed_frames);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Feedback filter: %s, %lu/%lu cyc per %lu samples (last/max)\r\n",
+            filter_names[servo_get_feedback_filter()],
+            (unsigned long)fb_stats.filter_cycles_last, (unsigned long)fb_stats.filter_cycles_max,
+            (unsigned long)fb_stats.samples_per_block);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Estimator: %s, %lu/%lu cyc per loop (last/max)\r\n",
+            (SERVO_CTRL_EST_TYPE == ESTIMATOR_TYPE__KALMAN) ? "Kalman" : "alpha-beta",
+            (unsigned long)stats.est_cycles_last, (unsigned long)stats.est_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Motion profiles: %lu/%lu cyc per loop (last/max), %lu per axis\r\n",
+            (unsigned long)stats.profile_cycles_last, (unsigned long)stats.profile_cycles_max,
+            (unsigned long)(stats.profile_cycles_max / SERVO_NUM_SERVOS));
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Coordinated moves: %lu, last %lu ms, plan %lu/%lu cyc (last/max)\r\n",
+            (unsigned long)stats.coord_moves,
+            (unsigned long)((stats.coord_ticks_last * 1000U) / SERVO_CTRL_LOOP_RATE_HZ),
+            (unsigned long)stats.coord_plan_cycles_last, (unsigned long)stats.coord_plan_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Input shapers:");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pos += sprintf(&data[pos], " %s", shaper_names[servo_ctrl_get_shaper(i)]);
+    }
+    sprintf(&data[pos], ", %lu/%lu cyc per loop (last/max)\r\n",
+            (unsigned long)stats.shaper_cycles_last, (unsigned long)stats.shaper_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Setpoint stream: %s, fill %lu/%u (min %lu), underruns %lu, overruns %lu\r\n",
+            stream_state_names[stream_stats.state],
+            (unsigned long)stream_stats.fill, (unsigned int)STREAM_QUEUE_LEN, (unsigned long)stream_stats.fill_min,
+            (unsigned long)stream_stats.underrun_count, (unsigned long)stream_stats.overrun_count);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Setpoint stream: %lu/%lu cyc per loop (last/max), discarded %lu\r\n",
+            (unsigned long)stats.stream_cycles_last, (unsigned long)stats.stream_cycles_max,
+            (unsigned long)stream_stats.discard_count);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    bool ik_enabled = servo_ctrl_ik_get(&ik_config);
+    sprintf(data, "Inverse kinematics: %s, unreachable %lu, %lu/%lu cyc per loop (last/max)\r\n",
+            ik_enabled ? ik_arm_names[ik_config.arm] : "off", (unsigned long)stats.ik_unreachable,
+            (unsigned long)stats.ik_cycles_last, (unsigned long)stats.ik_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        AUTOTUNE_RESULT_t result;
+        AUTOTUNE_STATE_t state = servo_ctrl_get_autotune(i, &result);
+        if (state == AUTOTUNE_STATE__IDLE)
+        {
+            continue;
+        }
+        memset(data, 0, TX_BUFF_MAX);
+        if (state == AUTOTUNE_STATE__DONE)
+        {
+            /* Gains x1000. */
+            sprintf(data, "Autotune servo %lu: DONE, Ku %ld, Tu %lu ms, kp %ld ki %ld kd %ld (x1000)\r\n",
+                    (unsigned long)(i + 1), (long)(result.ku * 1000.0f), (unsigned long)(result.tu_s * 1000.0f),
+                    (long)(result.kp * 1000.0f), (long)(result.ki * 1000.0f), (long)(result.kd * 1000.0f));
+        }
+        else
+        {
+            sprintf(data, "Autotune servo %lu: %s\r\n", (unsigned long)(i + 1),
+                    (state == AUTOTUNE_STATE__RUNNING) ? "RUNNING" : "FAILED");
+        }
+        tx(handle, data, sizeof(data));
+    }
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "MPC: %lu/%lu cyc (last/max), iter max %lu, constrained %lu\r\n",
+            (unsigned long)stats.mpc_cycles_last, (unsigned long)stats.mpc_cycles_max,
+            (unsigned long)stats.mpc_iterations_max, (unsigned long)stats.mpc_constrained_count);
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Saturated (ms):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pos += sprintf(&data[pos], " %lu", (unsigned long)((stats.sat_loops[i] * 1000) / SERVO_CTRL_LOOP_RATE_HZ));
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Slew limited (ms):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pos += sprintf(&data[pos], " %lu", (unsigned long)((stats.slew_loops[i] * 1000) / SERVO_CTRL_LOOP_RATE_HZ));
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    /* One line per faulted servo (the buffer does not fit all servos). */
+    bool faulted = false;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_CTRL_FAULT_t fault;
+        if (servo_ctrl_get_fault(i, &fault))
+        {
+            memset(data, 0, TX_BUFF_MAX);
+            sprintf(data, "Motor fault servo %lu: %s, %lu us latency, %lu cyc to cut\r\n",
+                    (unsigned long)(i + 1), fault_names[fault.fault],
+                    (unsigned long)(fault.latency_cycles / cycles_per_us), (unsigned long)fault.cut_cycles);
+            tx(handle, data, sizeof(data));
+            faulted = true;
+        }
+    }
+    if (faulted == false)
+    {
+        memset(data, 0, TX_BUFF_MAX);
+        sprintf(data, "Motor faults: none\r\n");
+        tx(handle, data, sizeof(data));
+    }
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "Gain schedule: %s, tables %lu, %lu/%lu cyc per loop (last/max)\r\n",
+            servo_ctrl_gain_sched_is_enabled() ? "ON" : "OFF", (unsigned long)servo_ctrl_gain_sched_get_swaps(),
+            (unsigned long)stats.sched_cycles_last, (unsigned long)stats.sched_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    /* '-' where the load term is invalid. */
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Load (mdeg):");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_CTRL_STATE_t state;
+        if (servo_ctrl_get_state(i, &state))
+        {
+            pos += sprintf(&data[pos], " %ld", (long)(state.load_deg * 1000.0f));
+        }
+        else
+        {
+            pos += sprintf(&data[pos], " -");
+        }
+    }
+    sprintf(&data[pos], "\r\n"); /* CRLF. */
+    tx(handle, data, sizeof(data));
+
+    /* One line per learning servo (the buffer does not fit all servos). */
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        static const char *ilc_state_names[] = {"IDLE", "ARMED", "RUNNING"};
+        ILC_STATS_t ilc_stats;
+        ILC_STATE_t ilc_state = servo_ctrl_get_ilc(i, &ilc_stats);
+        if (ilc_state != ILC_STATE__IDLE)
+        {
+            memset(data, 0, TX_BUFF_MAX);
+            sprintf(data, "ILC servo %lu: %s, it %lu, skip %lu, over %lu, rms %ld mdeg\r\n",
+                    (unsigned long)(i + 1), ilc_state_names[ilc_state], (unsigned long)ilc_stats.iterations,
+                    (unsigned long)ilc_stats.skipped, (unsigned long)ilc_stats.overruns,
+                    (long)(ilc_stats.rms_error * 1000.0f));
+            tx(handle, data, sizeof(data));
+        }
+    }
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "Friction:");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        FRICTION_PARAMS_t params;
+        float disturbance;
+        bool holding;
+        pos += sprintf(&data[pos], " %s", servo_ctrl_get_friction(i, &params, &disturbance, &holding) ? "on" : "off");
+    }
+    sprintf(&data[pos], ", %lu/%lu cyc per loop (last/max)\r\n",
+            (unsigned long)stats.friction_cycles_last, (unsigned long)stats.friction_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    /* One line per compensated servo (the buffer does not fit all servos). */
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        FRICTION_PARAMS_t params;
+        float disturbance;
+        bool holding;
+        if (servo_ctrl_get_friction(i, &params, &disturbance, &holding))
+        {
+            memset(data, 0, TX_BUFF_MAX);
+            sprintf(data, "Friction servo %lu: c %ld, b %ld mdeg, v %ld us, dist %ld mdeg%s\r\n",
+                    (unsigned long)(i + 1), (long)(params.coulomb * 1000.0f), (long)(params.breakaway * 1000.0f),
+                    (long)(params.viscous * 1000000.0f), (long)(disturbance * 1000.0f), holding ? ", hold" : "");
+            tx(handle, data, sizeof(data));
+        }
+    }
+
+    SERVO_ID_t friction_id;
+    FRICTION_PARAMS_t friction_result;
+    FRICTION_ID_STATE_t friction_id_state = servo_ctrl_get_friction_id(&friction_id, &friction_result);
+    if (friction_id_state != FRICTION_ID_STATE__IDLE)
+    {
+        static const char *friction_id_state_names[] = {"IDLE", "RUNNING", "DONE", "FAILED"};
+        memset(data, 0, TX_BUFF_MAX);
+        sprintf(data, "Friction ID servo %lu: %s\r\n", (unsigned long)(friction_id + 1),
+                friction_id_state_names[friction_id_state]);
+        tx(handle, data, sizeof(data));
+    }
+
+    memset(data, 0, TX_BUFF_MAX);
+    pos = sprintf(data, "LMS FF:");
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        LMS_FF_STATS_t lms_stats;
+        bool frozen;
+        pos += sprintf(&data[pos], " %s", servo_ctrl_get_lms(i, &lms_stats, &frozen) ? "on" : "off");
+    }
+    sprintf(&data[pos], ", %lu/%lu cyc per loop (last/max)\r\n",
+            (unsigned long)stats.lms_cycles_last, (unsigned long)stats.lms_cycles_max);
+    tx(handle, data, sizeof(data));
+
+    /* One line per adapting servo (the buffer does not fit all servos). */
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        LMS_FF_STATS_t lms_stats;
+        bool frozen;
+        if (servo_ctrl_get_lms(i, &lms_stats, &frozen))
+        {
+            memset(data, 0, TX_BUFF_MAX);
+            sprintf(data, "LMS FF servo %lu: %s, blk %lu, drop %lu, rms err %ld, ff %ld mdeg\r\n",
+                    (unsigned long)(i + 1), frozen ? "frozen" : "adapting", (unsigned long)lms_stats.blocks,
+                    (unsigned long)lms_stats.dropped, (long)(lms_stats.rms_error * 1000.0f),
+                    (long)(lms_stats.rms_output * 1000.0f));
+            tx(handle, data, sizeof(data));
+        }
+    }
+
+    SERVO_ID_t sysid_id;
+    SYSID_STATE_t sysid_state = servo_ctrl_get_sysid(&sysid_id);
+    if (sysid_state != SYSID_STATE__IDLE)
+    {
+        static const char *sysid_state_names[] = {"IDLE", "RUNNING", "CAPTURED", "DONE", "FAILED"};
+        memset(data, 0, TX_BUFF_MAX);
+        sprintf(data, "System ID servo %lu: %s\r\n", (unsigned long)(sysid_id + 1), sysid_state_names[sysid_state]);
+        tx(handle, data, sizeof(data));
+    }
+}
+
+/**
+ * @brief  Construct and transmit a message via the Nucleo COM port interface:
+ *             - Message: the identified frequency response, one line per
+ *               excited bin: "F <frequency_mHz> <magnitude_mdB>
+ *               <phase_mdeg>", between header and end lines.
+ * @param  handle: HAL USART handle pointer.
+ * @retval None.
+ */
+static void tx_sysid(UART_HandleTypeDef *handle)
+{
+    char data[TX_BUFF_MAX] = {0};
+    SERVO_ID_t id;
+    SYSID_BIN_t bin;
+
+    servo_ctrl_get_sysid(&id);
+    sprintf(data, "FRF servo %lu: %u bins of %lu mHz\r\n", (unsigned long)(id + 1), (unsigned int)SYSID_NUM_BINS,
+            (unsigned long)((1000.0f * SERVO_FB_SAMPLE_RATE_HZ) / SYSID_LEN));
+    tx(handle, data, sizeof(data));
+
+    for (uint32_t k = 1; k < SYSID_NUM_BINS; k++)
+    {
+        if (servo_ctrl_get_sysid_bin(k, &bin) == false)
+        {
+            continue;
+        }
+        memset(data, 0, TX_BUFF_MAX);
+        sprintf(data, "F %lu %ld %ld\r\n", (unsigned long)(bin.freq_hz * 1000.0f),
+                (long)(bin.mag_db * 1000.0f), (long)(bin.phase_deg * 1000.0f));
+        tx(handle, data, sizeof(data));
+    }
+
+    memset(data, 0, TX_BUFF_MAX);
+    sprintf(data, "FRF end\r\n");
+    tx(handle, data, sizeof(data));
+}
+
+/**
+ * @brief  Parse and push a setpoint stream waypoint.
+ * @param  args: "<timestamp_us> <angle_mdeg_1> ... <angle_mdeg_N>".
+ * @retval Boolean indicating whether the waypoint was well-formed and queued.
+ */
+static bool rx_stream_waypoint(char *args)
+{
+    SERVO_ANGLE_Q16_t positions[SERVO_NUM_SERVOS];
+    char *end;
+
+    uint32_t timestamp_us = (uint32_t)strtoul(args, &end, 10);
+    if (end == args)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        args = end;
+        long angle_mdeg = strtol(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        positions[i] = (SERVO_ANGLE_Q16_t)(((int64_t)angle_mdeg * SERVO_ANGLE_Q16_ONE) / 1000);
+    }
+
+    return servo_ctrl_stream_push(timestamp_us, positions);
+}
+
+/**
+ * @brief  Parse and queue a coordinated move of all servos.
+ * @param  args: "<T|S> <angle_mdeg_1> ... <angle_mdeg_N>".
+ * @retval Boolean indicating whether the move was well-formed and queued.
+ */
+static bool rx_coord_move(char *args)
+{
+    const PROFILE_LIMITS_t limits = {
+        .velocity = SERVO_CTRL_MOVE_VELOCITY_DEG_S,
+        .acceleration = SERVO_CTRL_MOVE_ACCEL_DEG_S2,
+        .jerk = SERVO_CTRL_MOVE_JERK_DEG_S3,
+    };
+    SERVO_ANGLE_Q16_t targets[SERVO_NUM_SERVOS];
+    PROFILE_TYPE_t type;
+    char *end;
+
+    switch (args[0])
+    {
+        case 'T': type = PROFILE_TYPE__TRAPEZOIDAL; break;
+        case 'S': type = PROFILE_TYPE__S_CURVE;     break;
+        default:  return false;
+    }
+    end = &args[1];
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        args = end;
+        long angle_mdeg = strtol(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        targets[i] = (SERVO_ANGLE_Q16_t)(((int64_t)angle_mdeg * SERVO_ANGLE_Q16_ONE) / 1000);
+    }
+
+    return servo_ctrl_move_coordinated(targets, type, &limits, false);
+}
+
+/**
+ * @brief  Parse a servo number and start auto-tuning it.
+ * @param  args: "<servo>" (1..SERVO_NUM_SERVOS).
+ * @retval Boolean indicating whether the command was well-formed and
+ *         auto-tuning started.
+ */
+static bool rx_autotune_start(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS))
+    {
+        return false;
+    }
+
+    return servo_ctrl_autotune_start((SERVO_ID_t)(servo - 1));
+}
+
+/**
+ * @brief  Parse a servo number and excitation signal and start identifying
+ *         the servo.
+ * @param  args: "<servo> <C|P>" (servo 1..SERVO_NUM_SERVOS; chirp or PRBS).
+ * @retval Boolean indicating whether the command was well-formed and
+ *         identification started.
+ */
+static bool rx_sysid_start(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS) || (*end != ' '))
+    {
+        return false;
+    }
+
+    SYSID_SIGNAL_t signal;
+    switch (end[1])
+    {
+        case 'C': signal = SYSID_SIGNAL__CHIRP; break;
+        case 'P': signal = SYSID_SIGNAL__PRBS;  break;
+        default:  return false;
+    }
+
+    return servo_ctrl_sysid_start((SERVO_ID_t)(servo - 1), signal);
+}
+
+/**
+ * @brief  Execute a gain schedule command (see servo_ctrl_gain_sched_*):
+ *             - "B": begin loading (staging table = active table).
+ *             - "X <pos_min_mdeg> <pos_max_mdeg> <load_max_mdeg>": axes.
+ *             - "P <load_idx> <pos_idx> <kp> <ki> <kd> <ff>": breakpoint
+ *               scale factors in thousandths (1000 == unity).
+ *             - "C": commit (swap in and enable).
+ *             - "E <0|1>": disable/enable.
+ * @param  args: Command and its arguments.
+ * @retval Boolean indicating whether the command was well-formed and
+ *         executed.
+ */
+static bool rx_gain_sched(char *args)
+{
+    char command = args[0];
+    char *end;
+    long values[GAIN_SCHED_PARAM__NUM + 2];
+    uint32_t count = 0;
+
+    /* Integer arguments. */
+    args = (command != '\0') ? &args[1] : args;
+    while (count < (sizeof(values) / sizeof(values[0])))
+    {
+        long value = strtol(args, &end, 10);
+        if (end == args)
+        {
+            break;
+        }
+        values[count++] = value;
+        args = end;
+    }
+
+    switch (command)
+    {
+        case 'B':
+            servo_ctrl_gain_sched_begin();
+            return true;
+        case 'X':
+            if (count != 3)
+            {
+                return false;
+            }
+            servo_ctrl_gain_sched_set_axes(values[0] / 1000.0f, values[1] / 1000.0f, values[2] / 1000.0f);
+            return true;
+        case 'P':
+        {
+            float scale[GAIN_SCHED_PARAM__NUM];
+            if ((count != (GAIN_SCHED_PARAM__NUM + 2)) || (values[0] < 0) || (values[1] < 0))
+            {
+                return false;
+            }
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                scale[p] = values[p + 2] / 1000.0f;
+            }
+            return servo_ctrl_gain_sched_set_point((uint32_t)values[0], (uint32_t)values[1], scale);
+        }
+        case 'C':
+            return servo_ctrl_gain_sched_commit();
+        case 'E':
+            if (count != 1)
+            {
+                return false;
+            }
+            servo_ctrl_gain_sched_enable(values[0] != 0);
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+/**
+ * @brief  Parse and select a controller structure.
+ * @param  args: "<P|C|M>" (PID, cascaded or MPC).
+ * @retval Boolean indicating whether the command was well-formed and the
+ *         structure selected.
+ */
+static bool rx_loop_type(char *args)
+{
+    SERVO_CTRL_LOOP_TYPE_t type;
+
+    switch (args[0])
+    {
+        case 'P': type = SERVO_CTRL_LOOP_TYPE__PID;     break;
+        case 'C': type = SERVO_CTRL_LOOP_TYPE__CASCADE; break;
+        case 'M': type = SERVO_CTRL_LOOP_TYPE__MPC;     break;
+        default:  return false;
+    }
+    servo_ctrl_set_loop_type(type);
+
+    return true;
+}
+
+/**
+ * @brief  Parse and select a servo's input shaper.
+ * @param  args: "<servo> <N|V|D|E> [<freq_mhz> <zeta_x1000>]" (servo
+ *               1..SERVO_NUM_SERVOS; none, ZV, ZVD or EI; the vibration
+ *               mode's frequency in mHz and damping ratio in thousandths,
+ *               required unless none).
+ * @retval Boolean indicating whether the command was well-formed and the
+ *         shaper applied.
+ */
+static bool rx_shaper(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS) || (*end != ' '))
+    {
+        return false;
+    }
+
+    SHAPER_TYPE_t type;
+    switch (end[1])
+    {
+        case 'N': type = SHAPER_TYPE__NONE; break;
+        case 'V': type = SHAPER_TYPE__ZV;   break;
+        case 'D': type = SHAPER_TYPE__ZVD;  break;
+        case 'E': type = SHAPER_TYPE__EI;   break;
+        default:  return false;
+    }
+
+    float freq_hz = 0.0f;
+    float zeta = 0.0f;
+    if (type != SHAPER_TYPE__NONE)
+    {
+        args = &end[2];
+        unsigned long freq_mhz = strtoul(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        args = end;
+        unsigned long zeta_x1000 = strtoul(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        freq_hz = freq_mhz / 1000.0f;
+        zeta = zeta_x1000 / 1000.0f;
+    }
+
+    return servo_ctrl_set_shaper((SERVO_ID_t)(servo - 1), type, freq_hz, zeta);
+}
+
+/**
+ * @brief  Parse and start/stop a servo's iterative learning control.
+ * @param  args: "<servo> <moves>" (servo 1..SERVO_NUM_SERVOS; moves per
+ *               repetition, 0 to stop).
+ * @retval Boolean indicating whether the command was well-formed and the
+ *         request accepted.
+ */
+static bool rx_ilc_start(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS) || (*end != ' '))
+    {
+        return false;
+    }
+    args = end;
+    unsigned long moves = strtoul(args, &end, 10);
+    if (end == args)
+    {
+        return false;
+    }
+
+    return servo_ctrl_ilc_start((SERVO_ID_t)(servo - 1), (uint32_t)moves);
+}
+
+/**
+ * @brief  Parse and apply a servo's friction compensation command.
+ * @param  args: "<servo> <E|D|I|P> [<coulomb_mdeg> <breakaway_mdeg>
+ *               <viscous_us>]" (servo 1..SERVO_NUM_SERVOS; the parameters
+ *               with P only).
+ * @retval Boolean indicating whether the command was well-formed and
+ *         applied.
+ */
+static bool rx_friction(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS) || (*end != ' '))
+    {
+        return false;
+    }
+    SERVO_ID_t id = (SERVO_ID_t)(servo - 1);
+
+    switch (end[1])
+    {
+        case 'E':
+            servo_ctrl_friction_enable(id, true);
+            return true;
+        case 'D':
+            servo_ctrl_friction_enable(id, false);
+            return true;
+        case 'I':
+            return servo_ctrl_friction_id_start(id);
+        case 'P':
+            break;
+        default:
+            return false;
+    }
+
+    long values[3];
+    args = &end[2];
+    for (uint32_t k = 0; k < 3; k++)
+    {
+        values[k] = strtol(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        args = end;
+    }
+    const FRICTION_PARAMS_t params = {
+        .coulomb = values[0] / 1000.0f,
+        .breakaway = values[1] / 1000.0f,
+        .viscous = values[2] / 1000000.0f,
+    };
+
+    return servo_ctrl_friction_set_params(id, &params);
+}
+
+/**
+ * @brief  Parse and apply a servo's adaptive feedforward command.
+ * @param  args: "<servo> <E|D|F|U|C>" (servo 1..SERVO_NUM_SERVOS).
+ * @retval Boolean indicating whether the command was well-formed and
+ *         applied.
+ */
+static bool rx_lms(char *args)
+{
+    char *end;
+
+    unsigned long servo = strtoul(args, &end, 10);
+    if ((end == args) || (servo < 1) || (servo > SERVO_NUM_SERVOS) || (*end != ' '))
+    {
+        return false;
+    }
+    SERVO_ID_t id = (SERVO_ID_t)(servo - 1);
+
+    switch (end[1])
+    {
+        case 'E':
+            servo_ctrl_lms_enable(id, true);
+            return true;
+        case 'D':
+            servo_ctrl_lms_enable(id, false);
+            return true;
+        case 'F':
+            servo_ctrl_lms_freeze(id, true);
+            return true;
+        case 'U':
+            servo_ctrl_lms_freeze(id, false);
+            return true;
+        case 'C':
+            servo_ctrl_lms_clear(id);
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief  Parse and apply an inverse kinematics (Cartesian stream) command.
+ * @param  args: "<P|O|S> <len_um_1> <len_um_2> <len_um_3> <U|D>" or "D".
+ * @retval Boolean indicating whether the command was well-formed and applied.
+ */
+static bool rx_ik(char *args)
+{
+    IK_CONFIG_t config = {0};
+    char *end;
+
+    switch (args[0])
+    {
+        case 'D': return servo_ctrl_ik_enable(false);
+        case 'P': config.arm = IK_ARM__PLANAR_2;  break;
+        case 'O': config.arm = IK_ARM__PLANAR_3;  break;
+        case 'S': config.arm = IK_ARM__SPATIAL_3; break;
+        default:  return false;
+    }
+    end = &args[1];
+    for (uint32_t i = 0; i < IK_MAX_JOINTS; i++)
+    {
+        args = end;
+        long length_um = strtol(args, &end, 10);
+        if (end == args)
+        {
+            return false;
+        }
+        config.lengths[i] = (int32_t)(((int64_t)length_um * SERVO_ANGLE_Q16_ONE) / 1000);
+    }
+    if ((end[0] != ' ') || ((end[1] != 'U') && (end[1] != 'D')))
+    {
+        return false;
+    }
+    config.elbow_up = (end[1] == 'U');
+
+    return servo_ctrl_ik_set(&config) && servo_ctrl_ik_enable(true);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * @file   coord.c
+ * @brief  Coordinated multi-axis motion source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "coord.h"
+
+/*===== Defines ==============================================================*/
+
+#define COORD_Q16_ONE               65536.0f
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool coord_plan(PROFILE_GEN_t *gens, uint32_t num_axes, PROFILE_TYPE_t type, const int32_t *targets,
+                const PROFILE_LIMITS_t *limits, bool blend, uint32_t *ticks)
+{
+    if ((num_axes == 0) || (num_axes > COORD_MAX_AXES))
+    {
+        return false;
+    }
+
+    /* The path's limits (per unit of the path): the tightest of the moving axes' over their distances. */
+    PROFILE_LIMITS_t path = {0};
+    bool moving = false;
+    for (uint32_t i = 0; i < num_axes; i++)
+    {
+        uint32_t space = profile_get_queue_space(&gens[i]);
+        if ((space == 0) || (space != profile_get_queue_space(&gens[0])))
+        {
+            return false;
+        }
+
+        float32_t d = fabsf((float32_t)(targets[i] - profile_get_end(&gens[i])) / COORD_Q16_ONE);
+        if (d == 0.0f)
+        {
+            continue;
+        }
+        float32_t v = limits[i].velocity / d;
+        float32_t a = limits[i].acceleration / d;
+        float32_t j = limits[i].jerk / d;
+        path.velocity = ((moving == false) || (v < path.velocity)) ? v : path.velocity;
+        path.acceleration = ((moving == false) || (a < path.acceleration)) ? a : path.acceleration;
+        path.jerk = ((moving == false) || (j < path.jerk)) ? j : path.jerk;
+        moving = true;
+    }
+
+    PROFILE_TIMING_t timing = {.type = type};
+    if (moving && (profile_plan_timing(type, 1.0f, &path, gens[0].rate_hz, &timing) == false))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < num_axes; i++)
+    {
+        profile_plan_timed(&gens[i], targets[i], &timing, blend);
+    }
+    *ticks = profile_timing_get_ticks(&timing);
+    return true;
+}
+
+void coord_commit(PROFILE_GEN_t *gens, uint32_t num_axes)
+{
+    for (uint32_t i = 0; i < num_axes; i++)
+    {
+        profile_commit(&gens[i]);
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * @file   estimator.c
+ * @brief  Position/velocity/acceleration state estimator source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "estimator.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Private Function Prototypes ==========================================*/
+static void kalman_init(ESTIMATOR_t *est);
+static void kalman_predict(ESTIMATOR_t *est);
+static void kalman_correct(ESTIMATOR_t *est, float32_t position);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void estimator_init(ESTIMATOR_t *est, const ESTIMATOR_CONFIG_t *config)
+{
+    est->config = *config;
+    if (est->config.type == ESTIMATOR_TYPE__KALMAN)
+    {
+        kalman_init(est);
+    }
+    estimator_reset(est);
+}
+
+void estimator_reset(ESTIMATOR_t *est)
+{
+    est->seeded = false;
+    memset(est->x, 0, sizeof(est->x));
+}
+
+void estimator_predict(ESTIMATOR_t *est)
+{
+    if (est->seeded == false)
+    {
+        return;
+    }
+
+    if (est->config.type == ESTIMATOR_TYPE__KALMAN)
+    {
+        kalman_predict(est);
+    }
+    else
+    {
+        float32_t dt = est->config.period_s;
+        est->x[0] += (est->x[1] * dt) + (0.5f * est->x[2] * dt * dt);
+        est->x[1] += est->x[2] * dt;
+    }
+}
+
+void estimator_correct(ESTIMATOR_t *est, float32_t position)
+{
+    if (est->seeded == false)
+    {
+        /* Seed: position measured, velocity and acceleration unknown (zero). */
+        est->x[0] = position;
+        est->x[1] = 0.0f;
+        est->x[2] = 0.0f;
+        if (est->config.type == ESTIMATOR_TYPE__KALMAN)
+        {
+            memset(est->p, 0, sizeof(est->p));
+            est->p[0] = est->config.meas_noise;
+            est->p[(1 * ESTIMATOR_NUM_STATES) + 1] = est->config.init_var_vel;
+            est->p[(2 * ESTIMATOR_NUM_STATES) + 2] = est->config.init_var_acc;
+        }
+        est->seeded = true;
+        return;
+    }
+
+    if (est->config.type == ESTIMATOR_TYPE__KALMAN)
+    {
+        kalman_correct(est, position);
+    }
+    else
+    {
+        float32_t t = est->config.meas_period_s;
+        float32_t residual = position - est->x[0];
+        est->x[0] += est->config.alpha * residual;
+        est->x[1] += (est->config.beta / t) * residual;
+        est->x[2] += ((2.0f * est->config.gamma) / (t * t)) * residual;
+    }
+}
+
+bool estimator_is_valid(const ESTIMATOR_t *est)
+{
+    return est->seeded;
+}
+
+float32_t estimator_get_position(const ESTIMATOR_t *est)
+{
+    return est->x[0];
+}
+
+float32_t estimator_get_velocity(const ESTIMATOR_t *est)
+{
+    return est->x[1];
+}
+
+float32_t estimator_get_acceleration(const ESTIMATOR_t *est)
+{
+    return est->x[2];
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Kalman filter initialisation: matrix instances, and the state
+ *         transition (F) and process noise (Q) matrices for the constant
+ *         acceleration model with white jerk of power spectral density q:
+ *             F = | 1  dt  dt^2/2 |      Q = q | dt^5/20  dt^4/8  dt^3/6 |
+ *                 | 0  1   dt     |            | dt^4/8   dt^3/3  dt^2/2 |
+ *                 | 0  0   1      |            | dt^3/6   dt^2/2  dt     |
+ * @param  est: Estimator.
+ * @retval None.
+ */
+static void kalman_init(ESTIMATOR_t *est)
+{
+    float32_t dt = est->config.period_s;
+    float32_t dt2 = dt * dt;
+    float32_t dt3 = dt2 * dt;
+    float32_t q = est->config.process_noise;
+
+    arm_mat_init_f32(&est->mat_x, ESTIMATOR_NUM_STATES, 1, est->x);
+    arm_mat_init_f32(&est->mat_x_pred, ESTIMATOR_NUM_STATES, 1, est->x_pred);
+    arm_mat_init_f32(&est->mat_p, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->p);
+    arm_mat_init_f32(&est->mat_f, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->f);
+    arm_mat_init_f32(&est->mat_f_t, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->f_t);
+    arm_mat_init_f32(&est->mat_q, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->q);
+    arm_mat_init_f32(&est->mat_k, ESTIMATOR_NUM_STATES, 1, est->k);
+    arm_mat_init_f32(&est->mat_p_row0, 1, ESTIMATOR_NUM_STATES, est->p); /* First row of P, i.e. H x P with H = [1 0 0]. */
+    arm_mat_init_f32(&est->mat_tmp_a, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->tmp_a);
+    arm_mat_init_f32(&est->mat_tmp_b, ESTIMATOR_NUM_STATES, ESTIMATOR_NUM_STATES, est->tmp_b);
+
+    const float32_t f[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES] = {
+        1.0f, dt,   0.5f * dt2,
+        0.0f, 1.0f, dt,
+        0.0f, 0.0f, 1.0f,
+    };
+    memcpy(est->f, f, sizeof(f));
+    arm_mat_trans_f32(&est->mat_f, &est->mat_f_t);
+
+    const float32_t qm[ESTIMATOR_NUM_STATES * ESTIMATOR_NUM_STATES] = {
+        q * dt3 * dt2 / 20.0f, q * dt2 * dt2 / 8.0f, q * dt3 / 6.0f,
+        q * dt2 * dt2 / 8.0f,  q * dt3 / 3.0f,       q * dt2 / 2.0f,
+        q * dt3 / 6.0f,        q * dt2 / 2.0f,       q * dt,
+    };
+    memcpy(est->q, qm, sizeof(qm));
+}
+
+/**
+ * @brief  Kalman filter prediction: x = F x, P = F P F' + Q.
+ * @param  est: Estimator.
+ * @retval None.
+ */
+static void kalman_predict(ESTIMATOR_t *est)
+{
+    arm_mat_mult_f32(&est->mat_f, &est->mat_x, &est->mat_x_pred);
+    memcpy(est->x, est->x_pred, sizeof(est->x));
+
+    arm_mat_mult_f32(&est->mat_f, &est->mat_p, &est->mat_tmp_a);
+    arm_mat_mult_f32(&est->mat_tmp_a, &est->mat_f_t, &est->mat_tmp_b);
+    arm_mat_add_f32(&est->mat_tmp_b, &est->mat_q, &est->mat_p);
+}
+
+/**
+ * @brief  Kalman filter correction with a position measurement (H = [1 0 0],
+ *         scalar innovation, i.e. no matrix inverse):
+ *             S = P[0][0] + R, K = P H' / S,
+ *             x = x + K (z - x[0]), P = P - K (H P).
+ * @param  est:      Estimator.
+ * @param  position: Measured position (z).
+ * @retval None.
+ */
+static void kalman_correct(ESTIMATOR_t *est, float32_t position)
+{
+    float32_t s = est->p[0] + est->config.meas_noise;
+    float32_t residual = position - est->x[0];
+
+    for (uint32_t i = 0; i < ESTIMATOR_NUM_STATES; i++)
+    {
+        est->k[i] = est->p[i * ESTIMATOR_NUM_STATES] / s;
+        est->x[i] += est->k[i] * residual;
+    }
+
+    arm_mat_mult_f32(&est->mat_k, &est->mat_p_row0, &est->mat_tmp_a);
+    arm_mat_sub_f32(&est->mat_p, &est->mat_tmp_a, &est->mat_p);
+}
+
+/*============================================================================*/
\ No newline at end of file
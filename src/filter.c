@@ -0,0 +1,261 @@
+/*******************************************************************************
+ * @file   filter.c
+ * @brief  Digital filter (signal conditioning) source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "filter.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Defines & Macros =====================================================*/
+
+#define FILTER_Q31_INPUT_SHIFT      16 /* Raw sample to Q1.31: 0x7FFF << 16 < 2^31. */
+
+/*===== Private Function Prototypes ==========================================*/
+static uint16_t clamp_input(uint16_t value);
+static uint16_t clamp_output(int32_t value);
+static void design_biquad(float32_t *coeffs, float32_t b0, float32_t b1, float32_t b2, float32_t a0, float32_t a1, float32_t a2);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void filter_init_none(FILTER_t *filter)
+{
+    filter->type = FILTER_TYPE__NONE;
+    filter->settle_samples = 0;
+    filter->sample_count = 0;
+}
+
+bool filter_init_biquad_f32(FILTER_t *filter, const float32_t *coeffs, uint32_t num_stages)
+{
+    if ((num_stages == 0) || (num_stages > FILTER_BIQUAD_MAX_STAGES))
+    {
+        return false;
+    }
+
+    memcpy(filter->kernel.biquad_f32.coeffs, coeffs, num_stages * FILTER_BIQUAD_NUM_COEFFS * sizeof(float32_t));
+    arm_biquad_cascade_df2T_init_f32(&filter->kernel.biquad_f32.instance,
+                                     (uint8_t)num_stages,
+                                     filter->kernel.biquad_f32.coeffs,
+                                     filter->kernel.biquad_f32.state);
+    filter->type = FILTER_TYPE__BIQUAD_F32;
+    filter->settle_samples = num_stages * FILTER_BIQUAD_SETTLE_SAMPLES_PER_STAGE;
+    filter->sample_count = 0;
+
+    return true;
+}
+
+bool filter_init_biquad_q31(FILTER_t *filter, const float32_t *coeffs, uint32_t num_stages)
+{
+    const float32_t scale = 2147483648.0f / (1 << FILTER_BIQUAD_Q31_POST_SHIFT);
+
+    if ((num_stages == 0) || (num_stages > FILTER_BIQUAD_MAX_STAGES))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < (num_stages * FILTER_BIQUAD_NUM_COEFFS); i++)
+    {
+        float32_t value = coeffs[i] * scale;
+        if ((value >= 2147483648.0f) || (value < -2147483648.0f))
+        {
+            return false;
+        }
+        filter->kernel.biquad_q31.coeffs[i] = (q31_t)value;
+    }
+    arm_biquad_cascade_df1_init_q31(&filter->kernel.biquad_q31.instance,
+                                    (uint8_t)num_stages,
+                                    filter->kernel.biquad_q31.coeffs,
+                                    filter->kernel.biquad_q31.state,
+                                    FILTER_BIQUAD_Q31_POST_SHIFT);
+    filter->type = FILTER_TYPE__BIQUAD_Q31;
+    filter->settle_samples = num_stages * FILTER_BIQUAD_SETTLE_SAMPLES_PER_STAGE;
+    filter->sample_count = 0;
+
+    return true;
+}
+
+bool filter_init_fir_q15(FILTER_t *filter, const q15_t *coeffs, uint32_t num_taps)
+{
+    /* arm_fir_q15 requires an even number of taps (>= 4). */
+    if ((num_taps < 4) || (num_taps > FILTER_FIR_MAX_TAPS) || ((num_taps % 2) != 0))
+    {
+        return false;
+    }
+
+    /* CMSIS-DSP FIR coefficients are stored time-reversed. */
+    for (uint32_t i = 0; i < num_taps; i++)
+    {
+        filter->kernel.fir_q15.coeffs[i] = coeffs[num_taps - 1 - i];
+    }
+    arm_fir_init_q15(&filter->kernel.fir_q15.instance,
+                     (uint16_t)num_taps,
+                     filter->kernel.fir_q15.coeffs,
+                     filter->kernel.fir_q15.state,
+                     FILTER_MAX_BLOCK_SIZE);
+    filter->type = FILTER_TYPE__FIR_Q15;
+    filter->settle_samples = num_taps;
+    filter->sample_count = 0;
+
+    return true;
+}
+
+void filter_reset(FILTER_t *filter)
+{
+    switch (filter->type)
+    {
+        case FILTER_TYPE__BIQUAD_F32:
+            memset(filter->kernel.biquad_f32.state, 0, sizeof(filter->kernel.biquad_f32.state));
+            break;
+        case FILTER_TYPE__BIQUAD_Q31:
+            memset(filter->kernel.biquad_q31.state, 0, sizeof(filter->kernel.biquad_q31.state));
+            break;
+        case FILTER_TYPE__FIR_Q15:
+            memset(filter->kernel.fir_q15.state, 0, sizeof(filter->kernel.fir_q15.state));
+            break;
+        default:
+            break;
+    }
+    filter->sample_count = 0;
+}
+
+void filter_process(FILTER_t *filter, const uint16_t *in, uint16_t *out, uint32_t stride, uint32_t block_size)
+{
+    /* Zeroed: the gather loops fill the block, but the compiler cannot prove it for every block size. */
+    union {
+        float32_t f32[FILTER_MAX_BLOCK_SIZE];
+        q31_t q31[FILTER_MAX_BLOCK_SIZE];
+        q15_t q15[FILTER_MAX_BLOCK_SIZE];
+    } src = {0}, dst = {0};
+
+    if (block_size > FILTER_MAX_BLOCK_SIZE)
+    {
+        block_size = FILTER_MAX_BLOCK_SIZE;
+    }
+
+    /* Gather (de-interleave) and convert into the kernel's format, filter the block, convert and scatter back. */
+    switch (filter->type)
+    {
+        case FILTER_TYPE__BIQUAD_F32:
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                src.f32[i] = (float32_t)clamp_input(in[i * stride]);
+            }
+            arm_biquad_cascade_df2T_f32(&filter->kernel.biquad_f32.instance, src.f32, dst.f32, block_size);
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                out[i * stride] = clamp_output((int32_t)(dst.f32[i] + 0.5f));
+            }
+            break;
+        case FILTER_TYPE__BIQUAD_Q31:
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                src.q31[i] = (q31_t)clamp_input(in[i * stride]) << FILTER_Q31_INPUT_SHIFT;
+            }
+            arm_biquad_cascade_df1_q31(&filter->kernel.biquad_q31.instance, src.q31, dst.q31, block_size);
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                out[i * stride] = clamp_output((dst.q31[i] + (1 << (FILTER_Q31_INPUT_SHIFT - 1))) >> FILTER_Q31_INPUT_SHIFT);
+            }
+            break;
+        case FILTER_TYPE__FIR_Q15:
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                src.q15[i] = (q15_t)clamp_input(in[i * stride]);
+            }
+            arm_fir_q15(&filter->kernel.fir_q15.instance, src.q15, dst.q15, block_size);
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                out[i * stride] = clamp_output(dst.q15[i]);
+            }
+            break;
+        default:
+            for (uint32_t i = 0; i < block_size; i++)
+            {
+                out[i * stride] = in[i * stride];
+            }
+            break;
+    }
+
+    if (filter->sample_count < filter->settle_samples)
+    {
+        filter->sample_count += block_size;
+    }
+}
+
+bool filter_is_settled(const FILTER_t *filter)
+{
+    return (filter->sample_count >= filter->settle_samples);
+}
+
+void filter_design_lowpass(float32_t *coeffs, float32_t sample_rate, float32_t cutoff, float32_t q)
+{
+    float32_t w0 = 2.0f * PI * cutoff / sample_rate;
+    float32_t cos_w0 = cosf(w0);
+    float32_t alpha = sinf(w0) / (2.0f * q);
+
+    design_biquad(coeffs,
+                  (1.0f - cos_w0) / 2.0f, 1.0f - cos_w0, (1.0f - cos_w0) / 2.0f,
+                  1.0f + alpha, -2.0f * cos_w0, 1.0f - alpha);
+}
+
+void filter_design_notch(float32_t *coeffs, float32_t sample_rate, float32_t centre, float32_t q)
+{
+    float32_t w0 = 2.0f * PI * centre / sample_rate;
+    float32_t cos_w0 = cosf(w0);
+    float32_t alpha = sinf(w0) / (2.0f * q);
+
+    design_biquad(coeffs,
+                  1.0f, -2.0f * cos_w0, 1.0f,
+                  1.0f + alpha, -2.0f * cos_w0, 1.0f - alpha);
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Clamp a raw sample to the filter input range.
+ * @param  value: Raw sample.
+ * @retval Raw sample (0..FILTER_INPUT_MAX).
+ */
+static uint16_t clamp_input(uint16_t value)
+{
+    return (value > FILTER_INPUT_MAX) ? FILTER_INPUT_MAX : value;
+}
+
+/**
+ * @brief  Clamp a filter output to the raw sample range (the filters can
+ *         over/undershoot on steps).
+ * @param  value: Filter output.
+ * @retval Raw sample (0..FILTER_INPUT_MAX).
+ */
+static uint16_t clamp_output(int32_t value)
+{
+    if (value < 0)
+    {
+        return 0;
+    }
+    return (value > (int32_t)FILTER_INPUT_MAX) ? FILTER_INPUT_MAX : (uint16_t)value;
+}
+
+/**
+ * @brief  Store a biquad's transfer function coefficients in the CMSIS-DSP
+ *         order, {b0, b1, b2, -a1, -a2}, normalised by a0.
+ * @param  coeffs: Coefficients (FILTER_BIQUAD_NUM_COEFFS). Passed by reference.
+ * @param  b0..a2: Transfer function coefficients (numerator b, denominator a).
+ * @retval None.
+ */
+static void design_biquad(float32_t *coeffs, float32_t b0, float32_t b1, float32_t b2, float32_t a0, float32_t a1, float32_t a2)
+{
+    coeffs[0] = b0 / a0;
+    coeffs[1] = b1 / a0;
+    coeffs[2] = b2 / a0;
+    coeffs[3] = -a1 / a0;
+    coeffs[4] = -a2 / a0;
+}
+
+/*============================================================================*/
\ No newline at end of file
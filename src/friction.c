@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * @file   friction.c
+ * @brief  Disturbance observer and friction/deadband compensation source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "friction.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+#define FRICTION_DISCRETISE_STEPS   100     /* RK4 sub-steps per observer step (model discretisation). */
+
+/*===== Private Function Prototypes ==========================================*/
+static void discretise(FRICTION_t *friction);
+static void model_rk4(const FRICTION_CONFIG_t *config, float32_t *x, float32_t u, float32_t h);
+static void id_solve(FRICTION_ID_t *id);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool friction_init(FRICTION_t *friction, const FRICTION_CONFIG_t *config)
+{
+    if ((config->period_s <= 0.0f) || (config->wn <= 0.0f) || (config->zeta < 0.0f) || (config->slope <= 0.0f) ||
+        (config->dist_max < 0.0f) || (config->hold_band < 0.0f))
+    {
+        return false;
+    }
+    memset(friction, 0, sizeof(*friction));
+    friction->config = *config;
+    discretise(friction);
+    return true;
+}
+
+bool friction_set_params(FRICTION_t *friction, const FRICTION_PARAMS_t *params)
+{
+    if ((params->coulomb < 0.0f) || (params->breakaway < params->coulomb) || (params->viscous < 0.0f))
+    {
+        return false;
+    }
+    friction->params = *params;
+    return true;
+}
+
+void friction_reset(FRICTION_t *friction)
+{
+    friction->valid = false;
+    friction->holding = false;
+    friction->disturbance = 0.0f;
+}
+
+void friction_observe(FRICTION_t *friction, float32_t command, float32_t position)
+{
+    if (friction->valid == false)
+    {
+        friction->x[0] = position;
+        friction->x[1] = 0.0f;
+        friction->disturbance = 0.0f;
+        friction->valid = true;
+    }
+
+    /* Correct the state at the start of the step (the feedback's), then predict its end. */
+    float32_t innovation = position - friction->x[0];
+    float32_t p = friction->x[0] + (friction->config.l_pos * innovation);
+    float32_t v = friction->x[1] + (friction->config.l_vel * innovation);
+    if (friction->holding == false)
+    {
+        /* Held in the hold band: the static friction is not a disturbance to cancel. */
+        float32_t d = friction->disturbance + (friction->config.l_dist * innovation);
+        float32_t d_max = friction->config.dist_max;
+        friction->disturbance = (d > d_max) ? d_max : ((d < -d_max) ? -d_max : d);
+    }
+
+    float32_t input = command + friction->disturbance;
+    friction->x[0] = (friction->a[0] * p) + (friction->a[1] * v) + (friction->b[0] * input);
+    friction->x[1] = (friction->a[2] * p) + (friction->a[3] * v) + (friction->b[1] * input);
+}
+
+float32_t friction_update(FRICTION_t *friction, float32_t error, float32_t ref_velocity, float32_t velocity)
+{
+    const FRICTION_CONFIG_t *config = &friction->config;
+    bool still = (fabsf(velocity) < config->still_speed);
+
+    friction->holding = still && (fabsf(ref_velocity) < config->still_speed) && (fabsf(error) < config->hold_band);
+
+    /* In the direction of the motion wanted: a ramp limited to the offset. */
+    float32_t offset = still ? friction->params.breakaway : friction->params.coulomb;
+    float32_t ramp = config->slope * (error + (config->lead_s * ref_velocity));
+    ramp = (ramp > offset) ? offset : ((ramp < -offset) ? -offset : ramp);
+
+    return ramp + (friction->params.viscous * ref_velocity) - friction->disturbance;
+}
+
+bool friction_is_holding(const FRICTION_t *friction)
+{
+    return friction->holding;
+}
+
+float32_t friction_get_disturbance(const FRICTION_t *friction)
+{
+    return friction->disturbance;
+}
+
+bool friction_id_start(FRICTION_ID_t *id, const FRICTION_ID_CONFIG_t *config)
+{
+    if ((config->period_s <= 0.0f) || (config->amplitude <= 0.0f) || (config->speed_min <= config->still_speed) ||
+        (config->speed_max < config->speed_min) || (config->settle_s < 0.0f) || (config->breakaway_travel < 0.0f))
+    {
+        return false;
+    }
+    memset(id, 0, sizeof(*id));
+    id->config = *config;
+    id->state = FRICTION_ID_STATE__RUNNING;
+    return true;
+}
+
+void friction_id_abort(FRICTION_ID_t *id)
+{
+    if (id->state == FRICTION_ID_STATE__RUNNING)
+    {
+        id->state = FRICTION_ID_STATE__IDLE;
+    }
+}
+
+float32_t friction_id_update(FRICTION_ID_t *id, float32_t command, float32_t position, float32_t velocity)
+{
+    if (id->state != FRICTION_ID_STATE__RUNNING)
+    {
+        return 0.0f;
+    }
+
+    const FRICTION_ID_CONFIG_t *config = &id->config;
+    float32_t dir = (id->leg == 1) ? -1.0f : 1.0f;
+    float32_t speed = config->speed_min;
+    if (FRICTION_ID_SPEEDS > 1)
+    {
+        speed *= powf(config->speed_max / config->speed_min, (float32_t)id->speed / (FRICTION_ID_SPEEDS - 1));
+    }
+
+    /* Steady motion (after the settling, and moving with the command): fitted. */
+    float32_t lag = command - position;
+    float32_t v = dir * speed;
+    if ((id->since_reversal >= config->settle_s) && ((dir * velocity) > config->still_speed))
+    {
+        id->n++;
+        id->n_pos += (dir > 0.0f) ? 1U : 0U;
+        id->sum_sv += dir * v;
+        id->sum_vv += v * v;
+        id->sum_s_lag += dir * lag;
+        id->sum_v_lag += v * lag;
+    }
+
+    /* Breakaway: the command's travel from the standstill after a reversal to the servo moving off, i.e. when the
+     * position first moved beyond the travel; counted once confirmed by the velocity (a noisy feedback sample may
+     * exceed the travel). */
+    float32_t travel = dir * (position - id->stuck_position);
+    if ((id->reversal == 1) && (fabsf(velocity) < config->still_speed))
+    {
+        id->stuck_position = position;
+        id->reversal = 2;
+    }
+    else if ((id->reversal == 2) && (travel > config->breakaway_travel))
+    {
+        id->moved_command = command;
+        id->reversal = 3;
+    }
+    else if ((id->reversal == 3) && (travel <= config->breakaway_travel))
+    {
+        id->reversal = 2;
+    }
+    else if ((id->reversal == 3) && ((dir * velocity) > config->still_speed))
+    {
+        id->breakaway_sum += fabsf(id->moved_command - id->stuck_position);
+        id->breakaways++;
+        id->reversal = 0;
+    }
+
+    /* Triangle: up to +amplitude, down to -amplitude, back up to the start; then the next speed. */
+    id->since_reversal += config->period_s;
+    id->excitation += v * config->period_s;
+    float32_t target = (id->leg == 0) ? config->amplitude : ((id->leg == 1) ? -config->amplitude : 0.0f);
+    if ((dir * (id->excitation - target)) >= 0.0f)
+    {
+        id->excitation = target;
+        id->since_reversal = 0.0f;
+        id->leg++;
+        id->reversal = ((id->speed == 0) && (id->leg < 3)) ? 1U : 0U;
+        if (id->leg == 3)
+        {
+            id->leg = 0;
+            id->speed++;
+            if (id->speed == FRICTION_ID_SPEEDS)
+            {
+                id_solve(id);
+            }
+        }
+    }
+    return (id->state == FRICTION_ID_STATE__RUNNING) ? id->excitation : 0.0f;
+}
+
+FRICTION_ID_STATE_t friction_id_get_state(const FRICTION_ID_t *id, FRICTION_PARAMS_t *result)
+{
+    if ((id->state == FRICTION_ID_STATE__DONE) && (result != NULL))
+    {
+        *result = id->result;
+    }
+    return id->state;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Discretise the model (zero-order hold at the observer step
+ *         period): the columns of A are the responses to the unit states,
+ *         and B the response to a unit input, integrated with RK4 sub-steps.
+ * @param  friction: Friction compensation.
+ * @retval None.
+ */
+static void discretise(FRICTION_t *friction)
+{
+    float32_t h = friction->config.period_s / FRICTION_DISCRETISE_STEPS;
+
+    for (uint32_t col = 0; col <= 2; col++)
+    {
+        float32_t x[2] = {0.0f, 0.0f};
+        float32_t u = (col == 2) ? 1.0f : 0.0f;
+
+        if (col < 2)
+        {
+            x[col] = 1.0f;
+        }
+        for (uint32_t i = 0; i < FRICTION_DISCRETISE_STEPS; i++)
+        {
+            model_rk4(&friction->config, x, u, h);
+        }
+        for (uint32_t row = 0; row < 2; row++)
+        {
+            if (col < 2)
+            {
+                friction->a[(row * 2) + col] = x[row];
+            }
+            else
+            {
+                friction->b[row] = x[row];
+            }
+        }
+    }
+}
+
+/**
+ * @brief  One RK4 step of the continuous-time model:
+ *         position' = velocity,
+ *         velocity' = wn^2 (u - position) - 2 zeta wn velocity.
+ * @param  config: Configuration (model).
+ * @param  x:      State; updated. Passed by reference.
+ * @param  u:      Input.
+ * @param  h:      Step (s).
+ * @retval None.
+ */
+static void model_rk4(const FRICTION_CONFIG_t *config, float32_t *x, float32_t u, float32_t h)
+{
+    float32_t wn2 = config->wn * config->wn;
+    float32_t c = 2.0f * config->zeta * config->wn;
+    float32_t k1p = x[1];
+    float32_t k1v = (wn2 * (u - x[0])) - (c * x[1]);
+    float32_t k2p = x[1] + (0.5f * h * k1v);
+    float32_t k2v = (wn2 * (u - (x[0] + (0.5f * h * k1p)))) - (c * k2p);
+    float32_t k3p = x[1] + (0.5f * h * k2v);
+    float32_t k3v = (wn2 * (u - (x[0] + (0.5f * h * k2p)))) - (c * k3p);
+    float32_t k4p = x[1] + (h * k3v);
+    float32_t k4v = (wn2 * (u - (x[0] + (h * k3p)))) - (c * k4p);
+
+    x[0] += (h / 6.0f) * (k1p + (2.0f * k2p) + (2.0f * k3p) + k4p);
+    x[1] += (h / 6.0f) * (k1v + (2.0f * k2v) + (2.0f * k3v) + k4v);
+}
+
+/**
+ * @brief  Solve the sweep's fit (2x2 normal equations) for the Coulomb
+ *         offset and the lag's slope, and average the breakaways.
+ * @param  id: Identification; done or failed.
+ * @retval None.
+ */
+static void id_solve(FRICTION_ID_t *id)
+{
+    const uint32_t min_samples = FRICTION_ID_MIN_SAMPLES * FRICTION_ID_SPEEDS;
+    float32_t n = (float32_t)id->n;
+    float32_t det = (n * id->sum_vv) - (id->sum_sv * id->sum_sv);
+
+    if ((id->n_pos < min_samples) || ((id->n - id->n_pos) < min_samples) || (det <= 0.0f))
+    {
+        id->state = FRICTION_ID_STATE__FAILED;
+        return;
+    }
+
+    float32_t coulomb = ((id->sum_vv * id->sum_s_lag) - (id->sum_sv * id->sum_v_lag)) / det;
+    float32_t slope = ((n * id->sum_v_lag) - (id->sum_sv * id->sum_s_lag)) / det;
+    float32_t viscous = slope - id->config.model_slope;
+    id->result.coulomb = (coulomb > 0.0f) ? coulomb : 0.0f;
+    id->result.viscous = (viscous > 0.0f) ? viscous : 0.0f;
+    id->result.breakaway = id->result.coulomb;
+    if (id->breakaways > 0)
+    {
+        float32_t breakaway = id->breakaway_sum / (float32_t)id->breakaways;
+        id->result.breakaway = (breakaway > id->result.coulomb) ? breakaway : id->result.coulomb;
+    }
+    id->state = FRICTION_ID_STATE__DONE;
+}
+
+/*============================================================================*/
\ No newline at end of file
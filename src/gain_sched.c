@@ -0,0 +1,163 @@
+/*******************************************************************************
+ * @file   gain_sched.c
+ * @brief  Gain scheduling table source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "gain_sched.h"
+
+/*===== Defines ==============================================================*/
+
+/**
+ * Memory barrier between the staging table's writes and the index write
+ * publishing it.
+ */
+#define GAIN_SCHED_BARRIER()        __sync_synchronize()
+
+/*===== Private Function Prototypes ==========================================*/
+static void grid_index(float32_t x, float32_t x_min, float32_t inv_step, uint32_t points, uint32_t *index, float32_t *frac);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void gain_sched_init(GAIN_SCHED_t *sched, float32_t pos_min, float32_t pos_max, float32_t load_max)
+{
+    GAIN_SCHED_TABLE_t *table = &sched->tables[0];
+
+    table->pos_min = pos_min;
+    table->pos_max = pos_max;
+    table->load_max = load_max;
+    table->pos_inv_step = (float32_t)(GAIN_SCHED_POS_POINTS - 1) / (pos_max - pos_min);
+    table->load_inv_step = (float32_t)(GAIN_SCHED_LOAD_POINTS - 1) / load_max;
+    for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+    {
+        for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+        {
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                table->scale[j][i][p] = 1.0f;
+            }
+        }
+    }
+    sched->tables[1] = *table;
+    sched->active = 0;
+    sched->swap_count = 0;
+}
+
+void gain_sched_begin(GAIN_SCHED_t *sched)
+{
+    sched->tables[sched->active ^ 1] = sched->tables[sched->active];
+}
+
+void gain_sched_set_axes(GAIN_SCHED_t *sched, float32_t pos_min, float32_t pos_max, float32_t load_max)
+{
+    GAIN_SCHED_TABLE_t *table = &sched->tables[sched->active ^ 1];
+
+    table->pos_min = pos_min;
+    table->pos_max = pos_max;
+    table->load_max = load_max;
+}
+
+bool gain_sched_set_point(GAIN_SCHED_t *sched, uint32_t load_idx, uint32_t pos_idx, const float32_t *scale)
+{
+    GAIN_SCHED_TABLE_t *table = &sched->tables[sched->active ^ 1];
+
+    if ((load_idx >= GAIN_SCHED_LOAD_POINTS) || (pos_idx >= GAIN_SCHED_POS_POINTS))
+    {
+        return false;
+    }
+    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+    {
+        if (!(scale[p] >= 0.0f)) /* Also rejects NaN. */
+        {
+            return false;
+        }
+    }
+
+    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+    {
+        table->scale[load_idx][pos_idx][p] = scale[p];
+    }
+
+    return true;
+}
+
+bool gain_sched_commit(GAIN_SCHED_t *sched)
+{
+    uint32_t staging = sched->active ^ 1;
+    GAIN_SCHED_TABLE_t *table = &sched->tables[staging];
+
+    if (!(table->pos_max > table->pos_min) || !(table->load_max > 0.0f))
+    {
+        return false;
+    }
+    table->pos_inv_step = (float32_t)(GAIN_SCHED_POS_POINTS - 1) / (table->pos_max - table->pos_min);
+    table->load_inv_step = (float32_t)(GAIN_SCHED_LOAD_POINTS - 1) / table->load_max;
+
+    GAIN_SCHED_BARRIER();
+    sched->active = staging;
+    sched->swap_count++;
+
+    return true;
+}
+
+void gain_sched_lookup(const GAIN_SCHED_t *sched, float32_t pos, float32_t load, float32_t *scale)
+{
+    const GAIN_SCHED_TABLE_t *table = &sched->tables[sched->active];
+    uint32_t i;
+    uint32_t j;
+    float32_t fx;
+    float32_t fy;
+
+    grid_index(pos, table->pos_min, table->pos_inv_step, GAIN_SCHED_POS_POINTS, &i, &fx);
+    grid_index(load, 0.0f, table->load_inv_step, GAIN_SCHED_LOAD_POINTS, &j, &fy);
+
+    const float32_t *s00 = table->scale[j][i];
+    const float32_t *s01 = table->scale[j][i + 1];
+    const float32_t *s10 = table->scale[j + 1][i];
+    const float32_t *s11 = table->scale[j + 1][i + 1];
+    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+    {
+        float32_t low = s00[p] + (fx * (s01[p] - s00[p]));
+        float32_t high = s10[p] + (fx * (s11[p] - s10[p]));
+        scale[p] = low + (fy * (high - low));
+    }
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Locate a value on a uniformly spaced axis: the cell's lower
+ *         breakpoint and the fraction across the cell, held at the ends.
+ * @param  x:        Value.
+ * @param  x_min:    First breakpoint.
+ * @param  inv_step: Inverse breakpoint spacing.
+ * @param  points:   Breakpoints (>= 2).
+ * @param  index:    Lower breakpoint (0..points - 2). Passed by reference.
+ * @param  frac:     Fraction (0..1). Passed by reference.
+ * @retval None.
+ */
+static void grid_index(float32_t x, float32_t x_min, float32_t inv_step, uint32_t points, uint32_t *index, float32_t *frac)
+{
+    float32_t u = (x - x_min) * inv_step;
+
+    if (!(u > 0.0f)) /* Also catches NaN. */
+    {
+        *index = 0;
+        *frac = 0.0f;
+        return;
+    }
+    if (u >= (float32_t)(points - 1))
+    {
+        *index = points - 2;
+        *frac = 1.0f;
+        return;
+    }
+    *index = (uint32_t)u;
+    *frac = u - (float32_t)*index;
+}
+
+/*============================================================================*/
\ No newline at end of file
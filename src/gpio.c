@@ -5,6 +5,9 @@
 
 #include "gpio.h"
 
+/*===== Private Function Prototypes ==========================================*/
+static void port_clk_enable(GPIO_TypeDef *port);
+
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
 /*============================================================================*/
@@ -21,13 +24,7 @@ void gpio_init_output_pin(GPIO_CONFIG_t gpio_config)
     GPIO_InitTypeDef GPIO_InitStruct = {0};
 
     /* GPIO port clock enable. */
-    if      (gpio_config.port == GPIOA) __HAL_RCC_GPIOA_CLK_ENABLE();
-    else if (gpio_config.port == GPIOB) __HAL_RCC_GPIOB_CLK_ENABLE();
-    else if (gpio_config.port == GPIOC) __HAL_RCC_GPIOC_CLK_ENABLE();
-    else if (gpio_config.port == GPIOD) __HAL_RCC_GPIOD_CLK_ENABLE();
-    else if (gpio_config.port == GPIOE) __HAL_RCC_GPIOE_CLK_ENABLE();
-    else if (gpio_config.port == GPIOH) __HAL_RCC_GPIOH_CLK_ENABLE();
-    else                     error_handler();
+    port_clk_enable(gpio_config.port);
 
     /* Configure initial GPIO output level. */
     HAL_GPIO_WritePin(gpio_config.port, gpio_config.pin, gpio_config.starting_state);
@@ -40,4 +37,61 @@ void gpio_init_output_pin(GPIO_CONFIG_t gpio_config)
     HAL_GPIO_Init(gpio_config.port, &GPIO_InitStruct);
 }
 
+void gpio_init_af_pin(GPIO_TypeDef *port, uint16_t pin, uint32_t alternate)
+{
+    assert(IS_GPIO_ALL_INSTANCE(port));
+    assert(IS_GPIO_PIN(pin));
+    assert(IS_GPIO_AF(alternate));
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* GPIO port clock enable. */
+    port_clk_enable(port);
+
+    /* Configure GPIO pin. */
+    GPIO_InitStruct.Pin = pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct.Alternate = alternate;
+    HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+void gpio_init_analog_pin(GPIO_TypeDef *port, uint16_t pin)
+{
+    assert(IS_GPIO_ALL_INSTANCE(port));
+    assert(IS_GPIO_PIN(pin));
+
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    /* GPIO port clock enable. */
+    port_clk_enable(port);
+
+    /* Configure GPIO pin. */
+    GPIO_InitStruct.Pin = pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Enable a GPIO port's clock.
+ * @param  port: Port / GPIO peripheral; GPIOx where x can be (A..E,H).
+ * @retval None.
+ */
+static void port_clk_enable(GPIO_TypeDef *port)
+{
+    if      (port == GPIOA) __HAL_RCC_GPIOA_CLK_ENABLE();
+    else if (port == GPIOB) __HAL_RCC_GPIOB_CLK_ENABLE();
+    else if (port == GPIOC) __HAL_RCC_GPIOC_CLK_ENABLE();
+    else if (port == GPIOD) __HAL_RCC_GPIOD_CLK_ENABLE();
+    else if (port == GPIOE) __HAL_RCC_GPIOE_CLK_ENABLE();
+    else if (port == GPIOH) __HAL_RCC_GPIOH_CLK_ENABLE();
+    else                    error_handler();
+}
+
 /*============================================================================*/
\ No newline at end of file
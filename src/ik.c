@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * @file   ik.c
+ * @brief  Fixed-point inverse kinematics source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "ik.h"
+
+/*===== Defines ==============================================================*/
+
+#define IK_Q30_ONE              ((int32_t)1 << 30)
+#define IK_ANGLE_90             ((int32_t)1 << 30)  /* Binary angle (Q31; 180 degrees = 2^31). */
+#define IK_ANGLE_180            0x80000000U
+#define IK_DEG_TO_ANGLE         3054198966ULL       /* 2^15 / 180 (Q24): degrees (Q16.16) to binary angle. */
+
+/* Newton iterations (quadratic convergence from the seeds' 6% and 9%). */
+#define IK_NEWTON_ITERATIONS    3
+
+/* Reciprocal seed on [0.5, 1): 48/17 - 32/17 x (Q30). */
+#define IK_RECIP_SEED_A         3031741621U
+#define IK_RECIP_SEED_B         2021161080U
+
+/* Reciprocal square root seed on [0.25, 1): 2.13 - 1.215 x (Q30). */
+#define IK_RSQRT_SEED_A         2287070085U
+#define IK_RSQRT_SEED_B         1304596316U
+
+/* Arctangent on [0, 1] (Abramowitz and Stegun 4.4.47), the coefficients over pi (Q30): binary angle output. */
+#define IK_ATAN_C1              341736839
+#define IK_ATAN_C3              -112890634
+#define IK_ATAN_C5              61569066
+#define IK_ATAN_C7              -29096981
+#define IK_ATAN_C9              7121075
+
+/*===== Private Function Prototypes ==========================================*/
+static bool solve_2link(const IK_t *ik, int32_t x, int32_t y, int32_t *shoulder, int32_t *elbow);
+static int32_t atan2_q31(int32_t y, int32_t x);
+static uint32_t sqrt_u64(uint64_t value);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool ik_init(IK_t *ik, const IK_CONFIG_t *config)
+{
+    if ((config->arm >= IK_ARM__NUM) || (config->lengths[0] <= 0) || (config->lengths[1] <= 0) ||
+        (config->lengths[0] > (INT32_MAX - config->lengths[1])) ||
+        ((config->arm == IK_ARM__PLANAR_3) && (config->lengths[2] <= 0)))
+    {
+        return false;
+    }
+    ik->config = *config;
+    ik->reach = config->lengths[0] + config->lengths[1];
+
+    /* The reach's reciprocal normalised to (2^30, 2^31]. */
+    ik->inv_shift = 32U - __CLZ((uint32_t)ik->reach);
+    ik->inv_reach = (uint32_t)(((uint64_t)1 << (30U + ik->inv_shift)) / (uint32_t)ik->reach);
+
+    int32_t l1 = (int32_t)(((int64_t)config->lengths[0] * ik->inv_reach) >> ik->inv_shift);
+    int32_t l2 = (int32_t)(((int64_t)config->lengths[1] * ik->inv_reach) >> ik->inv_shift);
+    ik->l1_sq = (int64_t)l1 * l1;
+    ik->l2_sq = (int64_t)l2 * l2;
+    ik->l1_l2 = (int32_t)(((int64_t)l1 * l2) >> 30);
+    return true;
+}
+
+uint32_t ik_get_num_joints(const IK_t *ik)
+{
+    return (ik->config.arm == IK_ARM__PLANAR_2) ? 2 : 3;
+}
+
+bool ik_solve(const IK_t *ik, const int32_t target[IK_MAX_JOINTS], int32_t joints[IK_MAX_JOINTS])
+{
+    int32_t angles[IK_MAX_JOINTS] = {0};
+    bool reachable;
+
+    switch (ik->config.arm)
+    {
+        case IK_ARM__PLANAR_2:
+            reachable = solve_2link(ik, target[0], target[1], &angles[0], &angles[1]);
+            break;
+
+        case IK_ARM__PLANAR_3:
+        {
+            /**
+             * The wrist point: the target less the end effector link along
+             * phi; the wrist closes phi. The kernel's cosine is inaccurate
+             * within a degree of -90 degrees (to 4e-3), hence evaluated at
+             * |phi| (cosine even, sine odd).
+             */
+            int32_t phi = (int32_t)(uint32_t)(((int64_t)target[2] * (int64_t)IK_DEG_TO_ANGLE) >> 24);
+            q31_t sin_phi;
+            q31_t cos_phi;
+            arm_sin_cos_q31((phi < 0) ? (int32_t)(0U - (uint32_t)phi) : phi, &sin_phi, &cos_phi);
+            sin_phi = (phi < 0) ? -sin_phi : sin_phi;
+            int32_t x = clip_q63_to_q31((int64_t)target[0] - (((int64_t)ik->config.lengths[2] * cos_phi) >> 31));
+            int32_t y = clip_q63_to_q31((int64_t)target[1] - (((int64_t)ik->config.lengths[2] * sin_phi) >> 31));
+            reachable = solve_2link(ik, x, y, &angles[0], &angles[1]);
+            angles[2] = (int32_t)((uint32_t)phi - (uint32_t)angles[0] - (uint32_t)angles[1]);
+            break;
+        }
+
+        default:
+        {
+            /* Yaw towards the target, then the 2-link arm in its vertical plane (horizontal radius, z). */
+            angles[0] = atan2_q31(target[1], target[0]);
+            uint32_t radius = sqrt_u64((uint64_t)((int64_t)target[0] * target[0]) +
+                                       (uint64_t)((int64_t)target[1] * target[1]));
+            reachable = solve_2link(ik, (radius > INT32_MAX) ? INT32_MAX : (int32_t)radius, target[2], &angles[1],
+                                    &angles[2]);
+            break;
+        }
+    }
+
+    /* Binary angles (Q31) to degrees (Q16.16): x 180 / 2^15, rounded. */
+    for (uint32_t i = 0; i < ik_get_num_joints(ik); i++)
+    {
+        joints[i] = (int32_t)((((int64_t)angles[i] * 180) + (1 << 14)) >> 15);
+    }
+    return reachable;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Solve a 2-link arm (the shoulder and elbow links): normalised to
+ *         the reach, the elbow's cosine and sine scaled by l1 l2 are
+ *         k = (r^2 - l1^2 - l2^2) / 2 and s = sqrt((l1 l2)^2 - k^2), and the
+ *         shoulder is the target's direction less the forearm's from the
+ *         upper arm, atan2(s, l1^2 + k) (scaled by l1).
+ * @param  ik:       Solver.
+ * @param  x:        Target x, or horizontal radius (Q16.16).
+ * @param  y:        Target y, or z (Q16.16).
+ * @param  shoulder: Shoulder angle (binary angle, Q31). Passed by reference.
+ * @param  elbow:    Elbow angle (binary angle, Q31). Passed by reference.
+ * @retval Boolean indicating whether the target is reachable; if not, the
+ *         arm is stretched (beyond the reach) or folded (within the links'
+ *         difference) towards it.
+ */
+static bool solve_2link(const IK_t *ik, int32_t x, int32_t y, int32_t *shoulder, int32_t *elbow)
+{
+    int32_t reach = ik->reach;
+    if ((x > reach) || (x < -reach) || (y > reach) || (y < -reach))
+    {
+        *shoulder = atan2_q31(y, x);
+        *elbow = 0;
+        return false;
+    }
+
+    /* Normalised (Q2.30; within +/-1, i.e. r^2 within 2). */
+    int32_t u = (int32_t)(((int64_t)x * ik->inv_reach) >> ik->inv_shift);
+    int32_t v = (int32_t)(((int64_t)y * ik->inv_reach) >> ik->inv_shift);
+
+    int64_t k_q60 = (((int64_t)u * u) + ((int64_t)v * v) - ik->l1_sq - ik->l2_sq) >> 1;
+    int32_t k = (int32_t)(k_q60 >> 30);
+    int64_t d = ((int64_t)ik->l1_l2 * ik->l1_l2) - ((int64_t)k * k);
+    bool reachable = (d >= 0);
+    int32_t s = reachable ? (int32_t)sqrt_u64((uint64_t)d) : 0;
+    s = ik->config.elbow_up ? -s : s;
+    *elbow = atan2_q31(s, k);
+
+    /* Q3.29: l1^2 + k is within 2. */
+    int32_t c = (int32_t)((ik->l1_sq + k_q60) >> 31);
+    *shoulder = (int32_t)((uint32_t)atan2_q31(v, u) - (uint32_t)atan2_q31(s / 2, c));
+    return reachable;
+}
+
+/**
+ * @brief  Four-quadrant arctangent: the ratio of the smaller to the larger
+ *         magnitude (0..1) by a Newton reciprocal of the larger normalised
+ *         to [0.5, 1), its arctangent by a polynomial, and the octant
+ *         restored.
+ * @param  y: Ordinate (any fixed-point format; the same as @param x).
+ * @param  x: Abscissa.
+ * @retval Angle (binary angle, Q31; 180 degrees = 2^31); 0 at the origin.
+ */
+static int32_t atan2_q31(int32_t y, int32_t x)
+{
+    uint32_t ax = (x < 0) ? (0U - (uint32_t)x) : (uint32_t)x;
+    uint32_t ay = (y < 0) ? (0U - (uint32_t)y) : (uint32_t)y;
+    bool swap = (ay > ax);
+    uint32_t num = swap ? ax : ay;
+    uint32_t den = swap ? ay : ax;
+    if (den == 0)
+    {
+        return 0;
+    }
+
+    uint32_t shift = __CLZ(den);
+    uint32_t d = den << shift;
+    uint32_t r = IK_RECIP_SEED_A - (uint32_t)(((uint64_t)IK_RECIP_SEED_B * d) >> 32);
+    for (uint32_t i = 0; i < IK_NEWTON_ITERATIONS; i++)
+    {
+        int32_t e = IK_Q30_ONE - (int32_t)(((uint64_t)d * r) >> 32);
+        r += (uint32_t)(int32_t)(((int64_t)r * e) >> 30);
+    }
+    int32_t t = (int32_t)(((uint64_t)(num << shift) * r) >> 32);
+    t = (t > IK_Q30_ONE) ? IK_Q30_ONE : t;
+
+    int32_t t2 = (int32_t)(((int64_t)t * t) >> 30);
+    int32_t p = IK_ATAN_C9;
+    p = IK_ATAN_C7 + (int32_t)(((int64_t)p * t2) >> 30);
+    p = IK_ATAN_C5 + (int32_t)(((int64_t)p * t2) >> 30);
+    p = IK_ATAN_C3 + (int32_t)(((int64_t)p * t2) >> 30);
+    p = IK_ATAN_C1 + (int32_t)(((int64_t)p * t2) >> 30);
+    uint32_t angle = (uint32_t)(((int64_t)p * t) >> 29);
+
+    angle = swap ? ((uint32_t)IK_ANGLE_90 - angle) : angle;
+    angle = (x < 0) ? (IK_ANGLE_180 - angle) : angle;
+    angle = (y < 0) ? (0U - angle) : angle;
+    return (int32_t)angle;
+}
+
+/**
+ * @brief  Square root: the value normalised to [0.25, 1) by an even shift,
+ *         a Newton reciprocal square root, and its product with the value.
+ * @param  value: Value (integer, or fixed-point with an even number of
+ *                fractional bits).
+ * @retval Square root (integer, or half the fractional bits).
+ */
+static uint32_t sqrt_u64(uint64_t value)
+{
+    if (value == 0)
+    {
+        return 0;
+    }
+
+    uint32_t high = (uint32_t)(value >> 32);
+    uint32_t shift = ((high != 0) ? __CLZ(high) : (32U + __CLZ((uint32_t)value))) & ~1U;
+    uint32_t m = (uint32_t)((value << shift) >> 32);
+    uint32_t y = IK_RSQRT_SEED_A - (uint32_t)(((uint64_t)IK_RSQRT_SEED_B * m) >> 32);
+    for (uint32_t i = 0; i < IK_NEWTON_ITERATIONS; i++)
+    {
+        uint64_t y2 = ((uint64_t)y * y) >> 30;
+        uint32_t m_y2 = (uint32_t)(((uint64_t)m * y2) >> 32);
+        y = (uint32_t)(((uint64_t)y * ((3U << 30) - m_y2)) >> 31);
+    }
+    uint64_t root = (((uint64_t)m * y) >> 30) >> (shift / 2);
+    return (root > UINT32_MAX) ? UINT32_MAX : (uint32_t)root;
+}
+
+/*============================================================================*/
\ No newline at end of file
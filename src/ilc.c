@@ -0,0 +1,193 @@
+/*******************************************************************************
+ * @file   ilc.c
+ * @brief  Iterative learning control (ILC) source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "ilc.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Private Function Prototypes ==========================================*/
+static q15_t to_q15(float32_t value, float32_t range);
+static float32_t learn_raw(const ILC_t *ilc, const q15_t *correction, const q15_t *error, uint32_t k);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool ilc_init(ILC_t *ilc, const ILC_CONFIG_t *config, ILC_TABLES_t *tables)
+{
+    if ((config->decimation < 1) || (config->range <= 0.0f) || (config->gain <= 0.0f) || (config->gain > 1.0f) ||
+        (config->lead >= ILC_MAX_SAMPLES) || (config->forget <= 0.0f) || (config->forget > 1.0f))
+    {
+        return false;
+    }
+    ilc->config = *config;
+    ilc->tables = tables;
+    ilc_start(ilc);
+    ilc_stop(ilc);
+    return true;
+}
+
+void ilc_start(ILC_t *ilc)
+{
+    memset(ilc->tables, 0, sizeof(*ilc->tables));
+    memset(&ilc->stats, 0, sizeof(ilc->stats));
+    ilc->tick = 0;
+    ilc->active = 0;
+    ilc->recording = 0;
+    ilc->recorded = false;
+    ilc->learnt = false;
+    ilc->state = ILC_STATE__ARMED;
+}
+
+void ilc_stop(ILC_t *ilc)
+{
+    ilc->state = ILC_STATE__IDLE;
+}
+
+void ilc_cycle_start(ILC_t *ilc)
+{
+    if (ilc->state == ILC_STATE__IDLE)
+    {
+        return;
+    }
+
+    if (ilc->state == ILC_STATE__RUNNING)
+    {
+        uint32_t length = (ilc->tick + ilc->config.decimation - 1) / ilc->config.decimation;
+        if (ilc->learnt)
+        {
+            /* This cycle ran with the correction the new one was learnt from: not learnt from. */
+            ilc->active ^= 1U;
+            ilc->learnt = false;
+            ilc->stats.iterations++;
+        }
+        else if (ilc->recorded || ((ilc->stats.length != 0) && (length != ilc->stats.length)))
+        {
+            ilc->stats.skipped++;
+        }
+        else
+        {
+            ilc->stats.length = length;
+            ilc->recording ^= 1U;
+            ilc->recorded = true;
+        }
+    }
+
+    ilc->tick = 0;
+    ilc->state = ILC_STATE__RUNNING;
+}
+
+float32_t ilc_update(ILC_t *ilc, float32_t error)
+{
+    if (ilc->state != ILC_STATE__RUNNING)
+    {
+        return 0.0f;
+    }
+
+    uint32_t k = ilc->tick / ilc->config.decimation;
+    uint32_t phase = ilc->tick - (k * ilc->config.decimation);
+    if (k >= ILC_MAX_SAMPLES)
+    {
+        /* Not a repetition: no correction until the next cycle boundary. */
+        ilc->state = ILC_STATE__ARMED;
+        ilc->stats.overruns++;
+        return 0.0f;
+    }
+    if (phase == 0)
+    {
+        ilc->tables->error[ilc->recording][k] = to_q15(error, ilc->config.range);
+    }
+    ilc->tick++;
+
+    /* Interpolated towards the next sample; cyclic, the next cycle follows on. Held beyond the cycle's length. */
+    uint32_t n = ilc->stats.length;
+    if (n == 0)
+    {
+        return 0.0f;
+    }
+    const q15_t *correction = ilc->tables->correction[ilc->active];
+    if (k >= n)
+    {
+        return (float32_t)correction[n - 1] * (ilc->config.range / 32768.0f);
+    }
+    float32_t c0 = (float32_t)correction[k];
+    float32_t c1 = (float32_t)correction[(k + 1) % n];
+    float32_t c = c0 + ((c1 - c0) * (float32_t)phase / (float32_t)ilc->config.decimation);
+    return c * (ilc->config.range / 32768.0f);
+}
+
+bool ilc_learn(ILC_t *ilc)
+{
+    if ((ilc->recorded == false) || ilc->learnt)
+    {
+        return false;
+    }
+
+    /* The updates only read the active correction and write the recording error trace. */
+    const q15_t *correction = ilc->tables->correction[ilc->active];
+    const q15_t *error = ilc->tables->error[ilc->recording ^ 1U];
+    q15_t *next = ilc->tables->correction[ilc->active ^ 1U];
+    uint32_t n = ilc->stats.length;
+    float32_t sum_sq = 0.0f;
+
+    for (uint32_t k = 0; k < n; k++)
+    {
+        float32_t raw = learn_raw(ilc, correction, error, k);
+        float32_t smoothed = (0.25f * learn_raw(ilc, correction, error, (k + n - 1) % n)) + (0.5f * raw) +
+                             (0.25f * learn_raw(ilc, correction, error, (k + 1) % n));
+        next[k] = to_q15(ilc->config.forget * smoothed, 32768.0f);
+        sum_sq += (float32_t)error[k] * (float32_t)error[k];
+    }
+    arm_sqrt_f32(sum_sq / (float32_t)n, &ilc->stats.rms_error);
+    ilc->stats.rms_error *= ilc->config.range / 32768.0f;
+
+    /* Learnt before the trace is released, such that the next cycle boundary swaps rather than records. */
+    ilc->learnt = true;
+    ilc->recorded = false;
+    return true;
+}
+
+ILC_STATE_t ilc_get_state(const ILC_t *ilc)
+{
+    return ilc->state;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Convert a value to Q1.15 fixed-point (rounded, saturated).
+ * @param  value: Value.
+ * @param  range: Full scale of @param value.
+ * @retval Q1.15 value.
+ */
+static q15_t to_q15(float32_t value, float32_t range)
+{
+    float32_t ratio = value / range;
+
+    ratio = (ratio > 1.0f) ? 1.0f : ((ratio < -1.0f) ? -1.0f : ratio);
+    return (q15_t)clip_q31_to_q15((q31_t)((ratio * 32768.0f) + ((ratio < 0.0f) ? -0.5f : 0.5f)));
+}
+
+/**
+ * @brief  Unfiltered learning update of a table sample: the correction plus
+ *         the gain times the error the configured lead on (cyclic).
+ * @param  ilc:        ILC.
+ * @param  correction: Correction the error trace was recorded with.
+ * @param  error:      Error trace.
+ * @param  k:          Sample.
+ * @retval Update (Q1.15 units, unsaturated).
+ */
+static float32_t learn_raw(const ILC_t *ilc, const q15_t *correction, const q15_t *error, uint32_t k)
+{
+    uint32_t n = ilc->stats.length;
+
+    return (float32_t)correction[k] + (ilc->config.gain * (float32_t)error[(k + ilc->config.lead) % n]);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,302 @@
+/*******************************************************************************
+ * @file   lms_ff.c
+ * @brief  Adaptive (normalised LMS) feedforward source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "lms_ff.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+#define Q31_SCALE   2147483648.0f   /* 2^31. */
+
+/*===== Private Function Prototypes ==========================================*/
+static float32_t adapt_f32(LMS_FF_t *ff, float32_t input, float32_t error, float32_t *lms_error);
+static float32_t adapt_q31(LMS_FF_t *ff, float32_t input, float32_t error, float32_t *lms_error);
+static float32_t step_size(const LMS_FF_t *ff, float32_t energy);
+static q31_t to_q31(float32_t value, float32_t limit, float32_t range);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool lms_ff_init(LMS_FF_t *ff, const LMS_FF_CONFIG_t *config)
+{
+    if ((config->kernel >= LMS_FF_KERNEL__NUM) || ((config->kernel == LMS_FF_KERNEL__Q31) && (config->range <= 0.0f)) ||
+        (config->mu <= 0.0f) || (config->mu > 1.0f) || (config->energy_min < 0.0f) ||
+        (config->leak < 0.0f) || (config->leak >= 1.0f) || (config->output_max <= 0.0f) ||
+        (config->lead > LMS_FF_MAX_LEAD))
+    {
+        return false;
+    }
+    memset(ff, 0, sizeof(*ff));
+    ff->config = *config;
+    lms_ff_clear(ff);
+    return true;
+}
+
+void lms_ff_clear(LMS_FF_t *ff)
+{
+    memset(&ff->kernel, 0, sizeof(ff->kernel));
+    memset(ff->coeffs, 0, sizeof(ff->coeffs));
+    memset(&ff->stats, 0, sizeof(ff->stats));
+    switch (ff->config.kernel)
+    {
+        case LMS_FF_KERNEL__Q31:
+            arm_lms_norm_init_q31(&ff->kernel.q31.instance, LMS_FF_NUM_TAPS, ff->kernel.q31.coeffs,
+                                  ff->kernel.q31.state, 0, 1, LMS_FF_Q31_POST_SHIFT);
+            break;
+        case LMS_FF_KERNEL__F32:
+        default:
+            arm_lms_norm_init_f32(&ff->kernel.f32.instance, LMS_FF_NUM_TAPS, ff->kernel.f32.coeffs,
+                                  ff->kernel.f32.state, ff->config.mu, 1);
+            break;
+    }
+    ff->active = 0;
+    ff->recorded = false;
+    ff->restart[0] = false;
+    ff->restart[1] = false;
+    lms_ff_restart(ff);
+}
+
+void lms_ff_restart(LMS_FF_t *ff)
+{
+    ff->valid = false;
+}
+
+void lms_ff_freeze(LMS_FF_t *ff, bool state)
+{
+    ff->frozen = state;
+}
+
+float32_t lms_ff_update(LMS_FF_t *ff, float32_t reference)
+{
+    if (ff->valid == false)
+    {
+        /* The block being recorded is discontinuous with the last adapted from. */
+        memset(ff->history, 0, sizeof(ff->history));
+        ff->reference_prev = reference;
+        ff->fill = 0;
+        ff->restart[ff->recording] = true;
+        ff->valid = true;
+    }
+
+    memmove(&ff->history[0], &ff->history[1], (LMS_FF_NUM_TAPS - 1) * sizeof(ff->history[0]));
+    ff->history[LMS_FF_NUM_TAPS - 1] = reference - ff->reference_prev;
+    ff->reference_prev = reference;
+
+    float32_t output;
+    arm_dot_prod_f32(ff->history, ff->coeffs[ff->active], LMS_FF_NUM_TAPS, &output);
+    float32_t output_max = ff->config.output_max;
+    return (output > output_max) ? output_max : ((output < -output_max) ? -output_max : output);
+}
+
+void lms_ff_record(LMS_FF_t *ff, float32_t error)
+{
+    if (ff->valid == false)
+    {
+        return;
+    }
+
+    /* Paired with the input the lead before (see lms_ff_adapt). */
+    ff->input[ff->recording][ff->fill] = ff->history[LMS_FF_NUM_TAPS - 1 - ff->config.lead];
+    ff->error[ff->recording][ff->fill] = error;
+    ff->fill++;
+    if (ff->fill < LMS_FF_BLOCK_SIZE)
+    {
+        return;
+    }
+
+    ff->fill = 0;
+    if (ff->recorded)
+    {
+        /* Not taken in time: re-recorded, and the history restarted before it is adapted from. */
+        ff->stats.dropped++;
+        ff->restart[ff->recording] = true;
+    }
+    else
+    {
+        ff->recording ^= 1U;
+        ff->restart[ff->recording] = false;
+        ff->recorded = true;
+    }
+}
+
+bool lms_ff_adapt(LMS_FF_t *ff)
+{
+    if (ff->recorded == false)
+    {
+        return false;
+    }
+
+    /* The updates only write the recording block and read the applied coefficients. */
+    uint32_t block = ff->recording ^ 1U;
+    const float32_t *input = ff->input[block];
+    const float32_t *error = ff->error[block];
+    const bool q31 = (ff->config.kernel == LMS_FF_KERNEL__Q31);
+    if (ff->restart[block])
+    {
+        if (q31)
+        {
+            memset(ff->kernel.q31.state, 0, sizeof(ff->kernel.q31.state));
+        }
+        else
+        {
+            memset(ff->kernel.f32.state, 0, sizeof(ff->kernel.f32.state));
+        }
+    }
+
+    /**
+     * The kernel's error is the tracking error: the desired output is the
+     * filter's own plus the error (the coefficients applied lag by the
+     * block; their output in its place is unstable). Its normalisation is
+     * the window's energy (exact; no running sum drift), and the step is
+     * regularised by the minimum energy.
+     */
+    float32_t sum_sq_error = 0.0f;
+    float32_t sum_sq_output = 0.0f;
+    for (uint32_t k = 0; k < LMS_FF_BLOCK_SIZE; k++)
+    {
+        float32_t lms_error;
+        float32_t output = q31 ? adapt_q31(ff, input[k], error[k], &lms_error)
+                               : adapt_f32(ff, input[k], error[k], &lms_error);
+        sum_sq_error += lms_error * lms_error;
+        sum_sq_output += output * output;
+    }
+    if ((ff->frozen == false) && q31)
+    {
+        q31_t keep = to_q31(1.0f - ff->config.leak, 1.0f, 1.0f);
+        for (uint32_t i = 0; i < LMS_FF_NUM_TAPS; i++)
+        {
+            ff->kernel.q31.coeffs[i] = (q31_t)(((q63_t)ff->kernel.q31.coeffs[i] * keep) >> 31);
+        }
+    }
+    else if (ff->frozen == false)
+    {
+        arm_scale_f32(ff->kernel.f32.coeffs, 1.0f - ff->config.leak, ff->kernel.f32.coeffs, LMS_FF_NUM_TAPS);
+    }
+    arm_sqrt_f32(sum_sq_error / LMS_FF_BLOCK_SIZE, &ff->stats.rms_error);
+    arm_sqrt_f32(sum_sq_output / LMS_FF_BLOCK_SIZE, &ff->stats.rms_output);
+    ff->stats.blocks++;
+
+    /* Swapped in before the block is released, such that it is in use from the next update. */
+    if (ff->frozen == false)
+    {
+        float32_t *next = ff->coeffs[ff->active ^ 1U];
+        for (uint32_t i = 0; i < LMS_FF_NUM_TAPS; i++)
+        {
+            next[i] = q31 ? ((float32_t)ff->kernel.q31.coeffs[i] * ((float32_t)(1UL << LMS_FF_Q31_POST_SHIFT) / Q31_SCALE))
+                          : ff->kernel.f32.coeffs[i];
+        }
+        ff->active ^= 1U;
+    }
+    ff->recorded = false;
+    return true;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Adapt from one pair with the floating-point kernel.
+ * @param  ff:        Adaptive feedforward.
+ * @param  input:     Input (the reference's increment).
+ * @param  error:     Tracking error paired with it.
+ * @param  lms_error: Kernel's error. Passed by reference.
+ * @retval Kernel's output.
+ */
+static float32_t adapt_f32(LMS_FF_t *ff, float32_t input, float32_t error, float32_t *lms_error)
+{
+    arm_lms_norm_instance_f32 *instance = &ff->kernel.f32.instance;
+    float32_t *state = ff->kernel.f32.state;
+    float32_t energy;
+    float32_t desired;
+    float32_t output;
+
+    /* The window: the last LMS_FF_NUM_TAPS - 1 inputs (the kernel's state) and this one. */
+    state[LMS_FF_NUM_TAPS - 1] = input;
+    arm_dot_prod_f32(state, state, LMS_FF_NUM_TAPS, &energy);
+    arm_dot_prod_f32(state, ff->kernel.f32.coeffs, LMS_FF_NUM_TAPS, &desired);
+
+    desired += error;
+    instance->energy = energy - (input * input);
+    instance->x0 = 0.0f;
+    instance->mu = step_size(ff, energy);
+    arm_lms_norm_f32(instance, &input, &desired, &output, lms_error, 1);
+    return output;
+}
+
+/**
+ * @brief  Adapt from one pair with the fixed-point kernel: as adapt_f32, in
+ *         Q1.31 of the range. The input is limited to LMS_FF_Q31_INPUT_MAX
+ *         (the window's energy within Q1.31), and the filter's own output is
+ *         the kernel's (its accumulator shifted by 31 - LMS_FF_Q31_POST_SHIFT).
+ * @param  ff:        Adaptive feedforward.
+ * @param  input:     Input (the reference's increment).
+ * @param  error:     Tracking error paired with it.
+ * @param  lms_error: Kernel's error. Passed by reference.
+ * @retval Kernel's output.
+ */
+static float32_t adapt_q31(LMS_FF_t *ff, float32_t input, float32_t error, float32_t *lms_error)
+{
+    arm_lms_norm_instance_q31 *instance = &ff->kernel.q31.instance;
+    q31_t *state = ff->kernel.q31.state;
+    const float32_t scale = ff->config.range / Q31_SCALE;
+    q31_t in = to_q31(input, LMS_FF_Q31_INPUT_MAX, ff->config.range);
+    q63_t acc = 0;
+    q63_t energy = 0;
+    q31_t output;
+    q31_t kernel_error;
+
+    /* The window: the last LMS_FF_NUM_TAPS - 1 inputs (the kernel's state) and this one. */
+    state[LMS_FF_NUM_TAPS - 1] = in;
+    for (uint32_t i = 0; i < LMS_FF_NUM_TAPS; i++)
+    {
+        acc += (q63_t)state[i] * ff->kernel.q31.coeffs[i];
+        energy += ((q63_t)state[i] * state[i]) >> 31;
+    }
+    q31_t desired = clip_q63_to_q31((acc >> (31 - LMS_FF_Q31_POST_SHIFT)) + to_q31(error, 1.0f, ff->config.range));
+
+    /* The step scaled down as the coefficients' format. */
+    instance->energy = (q31_t)(energy - (((q63_t)in * in) >> 31));
+    instance->x0 = 0;
+    float32_t mu = step_size(ff, (float32_t)energy * ff->config.range * scale);
+    instance->mu = to_q31(mu / (float32_t)(1UL << LMS_FF_Q31_POST_SHIFT), 1.0f, 1.0f);
+    arm_lms_norm_q31(instance, &in, &desired, &output, &kernel_error, 1);
+
+    *lms_error = (float32_t)kernel_error * scale;
+    return (float32_t)output * scale;
+}
+
+/**
+ * @brief  Step of a pair: normalised, and regularised by the minimum energy
+ *         (zero whilst frozen).
+ * @param  ff:     Adaptive feedforward.
+ * @param  energy: Window's energy.
+ * @retval Step.
+ */
+static float32_t step_size(const LMS_FF_t *ff, float32_t energy)
+{
+    return ff->frozen ? 0.0f : (ff->config.mu * energy / (energy + ff->config.energy_min));
+}
+
+/**
+ * @brief  Convert to Q1.31 (rounded and limited).
+ * @param  value: Value.
+ * @param  limit: Limit (fraction of the range).
+ * @param  range: Full scale.
+ * @retval Q1.31 value.
+ */
+static q31_t to_q31(float32_t value, float32_t limit, float32_t range)
+{
+    float32_t ratio = value / range;
+
+    ratio = (ratio > limit) ? limit : ((ratio < -limit) ? -limit : ratio);
+    return clip_q63_to_q31((q63_t)((ratio * Q31_SCALE) + ((ratio < 0.0f) ? -0.5f : 0.5f)));
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -4,6 +4,7 @@
  ******************************************************************************/
 
 #include "main.h"
+#include "adc.h"
 #include "clock.h"
 #include "gpio.h"
 #include "helper.h"
@@ -12,6 +13,7 @@
 #include "op_mode.h"
 #include "rtos.h"
 #include "servo.h"
+#include "servo_ctrl.h"
 #include "timer.h"
 #include "usart.h"
 
@@ -26,6 +28,7 @@ int main(void)
     lcd_init();
     leds_init();
     servo_init();
+    servo_ctrl_init();
     usart_init();
 
     /* Initialise and start the RTOS. */
@@ -60,6 +63,12 @@ void freertos_wrapper_error_handler(void)
     error_handler();
 }
 
+void vApplicationMallocFailedHook(void)
+{
+    /* The heap only holds the tasks (allocated at start-up): configTOTAL_HEAP_SIZE is too small. */
+    error_handler();
+}
+
 void lcd_delay_ms(uint32_t ms)
 {
     if (freertos_wrapper_is_scheduler_running())
@@ -72,4 +81,20 @@ void lcd_delay_ms(uint32_t ms)
     }
 }
 
+void timer_tim6_period_elapsed_callback(void)
+{
+    servo_ctrl_loop_run();
+}
+
+void timer_tim2_period_elapsed_callback(void)
+{
+    servo_frame_update();
+    servo_ctrl_frame_sync();
+}
+
+void adc_block_ready_callback(const uint16_t *samples, uint32_t num_scans)
+{
+    servo_process_feedback(samples, num_scans);
+}
+
 /*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * @file   motor_health.c
+ * @brief  Servo motor health monitor source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "motor_health.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Private Function Prototypes ==========================================*/
+static bool condition_held(MOTOR_HEALTH_t *health, MOTOR_FAULT_t fault, bool condition, uint32_t periods,
+                           uint32_t timestamp);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void motor_health_init(MOTOR_HEALTH_t *health, const MOTOR_HEALTH_CONFIG_t *config)
+{
+    health->config = *config;
+    health->config.stall_periods = (health->config.stall_periods < 1) ? 1 : health->config.stall_periods;
+    health->config.overload_periods = (health->config.overload_periods < 1) ? 1 : health->config.overload_periods;
+    health->config.fb_loss_periods = (health->config.fb_loss_periods < 1) ? 1 : health->config.fb_loss_periods;
+    motor_health_reset(health);
+}
+
+void motor_health_reset(MOTOR_HEALTH_t *health)
+{
+    health->armed = false;
+    memset(health->count, 0, sizeof(health->count));
+    memset(health->onset, 0, sizeof(health->onset));
+    health->stall_position = 0.0f;
+    health->fault = MOTOR_FAULT__NONE;
+    health->fault_onset = 0;
+}
+
+MOTOR_FAULT_t motor_health_update(MOTOR_HEALTH_t *health, const MOTOR_HEALTH_INPUT_t *input)
+{
+    if (health->fault != MOTOR_FAULT__NONE)
+    {
+        return MOTOR_FAULT__NONE;
+    }
+
+    /* Feedback loss: counted from the last new valid sample once armed. */
+    bool fb_fresh = input->feedback_valid && input->feedback_new;
+    health->armed |= fb_fresh;
+    bool fb_stale = health->armed && (fb_fresh == false);
+    bool checked = input->controlled && input->feedback_valid;
+    bool stalling = (health->count[MOTOR_FAULT__STALL] > 0);
+    bool still = stalling ? (fabsf(input->position - health->stall_position) < health->config.stall_travel)
+                          : (fabsf(input->velocity) < health->config.stall_speed);
+    bool stall = checked && still &&
+                 ((fabsf(input->command - input->position) - input->load) > health->config.stall_error);
+    if (stall && (stalling == false))
+    {
+        health->stall_position = input->position;
+    }
+    bool overload = checked && (input->load > health->config.overload_load);
+
+    /* Feedback loss first: stall and overload are not reliable without it. */
+    MOTOR_FAULT_t fault = MOTOR_FAULT__NONE;
+    if (condition_held(health, MOTOR_FAULT__FEEDBACK_LOSS, fb_stale, health->config.fb_loss_periods, input->timestamp))
+    {
+        fault = MOTOR_FAULT__FEEDBACK_LOSS;
+    }
+    else if (condition_held(health, MOTOR_FAULT__STALL, stall, health->config.stall_periods, input->timestamp))
+    {
+        fault = MOTOR_FAULT__STALL;
+    }
+    else if (condition_held(health, MOTOR_FAULT__OVERLOAD, overload, health->config.overload_periods, input->timestamp))
+    {
+        fault = MOTOR_FAULT__OVERLOAD;
+    }
+
+    if (fault != MOTOR_FAULT__NONE)
+    {
+        health->fault = fault;
+        health->fault_onset = health->onset[fault];
+    }
+    return fault;
+}
+
+MOTOR_FAULT_t motor_health_get_fault(const MOTOR_HEALTH_t *health, uint32_t *onset)
+{
+    if (onset != NULL)
+    {
+        *onset = health->fault_onset;
+    }
+    return health->fault;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Count the consecutive updates a fault condition has held.
+ * @param  health:    Health monitor.
+ * @param  fault:     Fault of the condition.
+ * @param  condition: Whether the condition holds this update.
+ * @param  periods:   Consecutive updates to detect the fault.
+ * @param  timestamp: Update time; recorded at the condition's onset.
+ * @retval Boolean indicating if the condition has held for @param periods.
+ */
+static bool condition_held(MOTOR_HEALTH_t *health, MOTOR_FAULT_t fault, bool condition, uint32_t periods,
+                           uint32_t timestamp)
+{
+    if (condition == false)
+    {
+        health->count[fault] = 0;
+        return false;
+    }
+    if (health->count[fault] == 0)
+    {
+        health->onset[fault] = timestamp;
+    }
+    health->count[fault]++;
+    return (health->count[fault] >= periods);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,395 @@
+/*******************************************************************************
+ * @file   mpc.c
+ * @brief  Model predictive controller (MPC) source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "mpc.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+#define MPC_DISCRETISE_STEPS        100     /* RK4 sub-steps per step period (model discretisation). */
+
+#define NC                          MPC_CONTROL_MOVES
+#define NH                          MPC_HORIZON
+#define NM                          MPC_NUM_CONSTRAINTS
+
+/* Constraint rows (each block's upper bounds, then its lower bounds): inputs, input moves, positions. */
+#define ROW_U                       0
+#define ROW_DU                      (2 * NC)
+#define ROW_Y                       (4 * NC)
+
+/*===== Private Function Prototypes ==========================================*/
+static void discretise(MPC_t *mpc);
+static void model_rk4(const MPC_CONFIG_t *config, float32_t *x, float32_t u, float32_t h);
+static void predict_matrices(MPC_t *mpc);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool mpc_init(MPC_t *mpc, const MPC_CONFIG_t *config)
+{
+    float32_t h[NC * NC];
+    float32_t h_copy[NC * NC];
+    float32_t hinv[NC * NC];
+    float32_t gamma_t[NC * NH];
+    float32_t g[NC * NH];           /* H^-1 gamma^T. */
+    float32_t g_phi[NC * MPC_NUM_STATES];
+    float32_t m[NM * NC];
+    float32_t m_t[NC * NM];
+    arm_matrix_instance_f32 mat_h;
+    arm_matrix_instance_f32 mat_h_copy;
+    arm_matrix_instance_f32 mat_hinv;
+    arm_matrix_instance_f32 mat_gamma_t;
+    arm_matrix_instance_f32 mat_g;
+    arm_matrix_instance_f32 mat_g_phi;
+    arm_matrix_instance_f32 mat_m;
+    arm_matrix_instance_f32 mat_m_t;
+    arm_matrix_instance_f32 mat_hinv_mt;
+    arm_matrix_instance_f32 mat_p;
+
+    memset(mpc, 0, sizeof(*mpc));
+    mpc->config = *config;
+    arm_mat_init_f32(&mpc->mat_phi, NH, MPC_NUM_STATES, mpc->phi);
+    arm_mat_init_f32(&mpc->mat_gamma, NH, NC, mpc->gamma);
+    arm_mat_init_f32(&mpc->mat_k, NC, MPC_NUM_STATES + 2, mpc->k);
+
+    discretise(mpc);
+    predict_matrices(mpc);
+
+    /* Hessian: H = q gamma^T gamma + r I + s D^T D (D: the moves, the first from the previous input). */
+    arm_mat_init_f32(&mat_gamma_t, NC, NH, gamma_t);
+    arm_mat_init_f32(&mat_h, NC, NC, h);
+    arm_mat_trans_f32(&mpc->mat_gamma, &mat_gamma_t);
+    arm_mat_mult_f32(&mat_gamma_t, &mpc->mat_gamma, &mat_h);
+    for (uint32_t i = 0; i < (NC * NC); i++)
+    {
+        h[i] *= config->q;
+    }
+    for (uint32_t i = 0; i < NC; i++)
+    {
+        h[(i * NC) + i] += config->r + ((i < (NC - 1)) ? (2.0f * config->s) : config->s);
+        if (i > 0)
+        {
+            h[(i * NC) + i - 1] -= config->s;
+            h[((i - 1) * NC) + i] -= config->s;
+        }
+    }
+
+    /* The inversion destroys its source. */
+    memcpy(h_copy, h, sizeof(h));
+    arm_mat_init_f32(&mat_h_copy, NC, NC, h_copy);
+    arm_mat_init_f32(&mat_hinv, NC, NC, hinv);
+    if (arm_mat_inverse_f32(&mat_h_copy, &mat_hinv) != ARM_MATH_SUCCESS)
+    {
+        return false;
+    }
+
+    /**
+     * Unconstrained solution U = -H^-1 f with
+     * f = q gamma^T (phi x - 1 reference) - r 1 reference - s e0 u_prev, i.e.
+     * k = [-q H^-1 gamma^T phi | q H^-1 gamma^T 1 + r H^-1 1 | s H^-1 e0].
+     */
+    arm_mat_init_f32(&mat_g, NC, NH, g);
+    arm_mat_init_f32(&mat_g_phi, NC, MPC_NUM_STATES, g_phi);
+    arm_mat_mult_f32(&mat_hinv, &mat_gamma_t, &mat_g);
+    arm_mat_mult_f32(&mat_g, &mpc->mat_phi, &mat_g_phi);
+    for (uint32_t i = 0; i < NC; i++)
+    {
+        float32_t *row = &mpc->k[i * (MPC_NUM_STATES + 2)];
+        float32_t g_sum = 0.0f;
+        float32_t hinv_sum = 0.0f;
+
+        for (uint32_t j = 0; j < NH; j++)
+        {
+            g_sum += g[(i * NH) + j];
+        }
+        for (uint32_t j = 0; j < NC; j++)
+        {
+            hinv_sum += hinv[(i * NC) + j];
+        }
+        for (uint32_t j = 0; j < MPC_NUM_STATES; j++)
+        {
+            row[j] = -config->q * g_phi[(i * MPC_NUM_STATES) + j];
+        }
+        row[MPC_NUM_STATES] = (config->q * g_sum) + (config->r * hinv_sum);
+        row[MPC_NUM_STATES + 1] = config->s * hinv[i * NC];
+    }
+
+    /* Constraints M U <= gamma with M = [I; -I; D; -D; gamma; -gamma]. */
+    memset(m, 0, sizeof(m));
+    for (uint32_t i = 0; i < NC; i++)
+    {
+        m[((ROW_U + i) * NC) + i] = 1.0f;
+        m[((ROW_U + NC + i) * NC) + i] = -1.0f;
+        m[((ROW_DU + i) * NC) + i] = 1.0f;
+        m[((ROW_DU + NC + i) * NC) + i] = -1.0f;
+        if (i > 0)
+        {
+            m[((ROW_DU + i) * NC) + i - 1] = -1.0f;
+            m[((ROW_DU + NC + i) * NC) + i - 1] = 1.0f;
+        }
+    }
+    for (uint32_t i = 0; i < (NH * NC); i++)
+    {
+        m[(ROW_Y * NC) + i] = mpc->gamma[i];
+        m[((ROW_Y + NH) * NC) + i] = -mpc->gamma[i];
+    }
+    arm_mat_init_f32(&mat_m, NM, NC, m);
+    arm_mat_init_f32(&mat_m_t, NC, NM, m_t);
+    arm_mat_init_f32(&mat_hinv_mt, NC, NM, mpc->hinv_mt);
+    arm_mat_init_f32(&mat_p, NM, NM, mpc->p);
+    arm_mat_trans_f32(&mat_m, &mat_m_t);
+    arm_mat_mult_f32(&mat_hinv, &mat_m_t, &mat_hinv_mt);
+    arm_mat_mult_f32(&mat_m, &mat_hinv_mt, &mat_p);
+
+    return true;
+}
+
+void mpc_state_reset(MPC_STATE_t *state, float32_t position)
+{
+    memset(state, 0, sizeof(*state));
+    state->x[0] = position;
+}
+
+void mpc_observe(const MPC_t *mpc, MPC_STATE_t *state, float32_t u, float32_t position)
+{
+    /* Correct the state at the start of the step (the feedback's), then predict its end. */
+    float32_t innovation = position - state->x[0];
+    float32_t p = state->x[0] + (mpc->config.l_pos * innovation);
+    float32_t v = state->x[1] + (mpc->config.l_vel * innovation);
+    state->disturbance += mpc->config.l_dist * innovation;
+
+    float32_t input = u + state->disturbance;
+    state->x[0] = (mpc->a[0] * p) + (mpc->a[1] * v) + (mpc->b[0] * input);
+    state->x[1] = (mpc->a[2] * p) + (mpc->a[3] * v) + (mpc->b[1] * input);
+}
+
+float32_t mpc_step(const MPC_t *mpc, MPC_STATE_t *state, float32_t reference, float32_t u_prev,
+                   const MPC_LIMITS_t *limits, uint32_t *iterations)
+{
+    /* Optimised over the plant's input, i.e. the input plus the disturbance. */
+    float32_t d = state->disturbance;
+    float32_t z[MPC_NUM_STATES + 2] = {state->x[0], state->x[1], reference, u_prev + d};
+    float32_t u[NC];
+    float32_t y_free[NH];           /* Free response: phi x. */
+    float32_t y_forced[NH];         /* Forced response: gamma U. */
+    float32_t kd[NM];               /* gamma - M U (negative: violated). */
+    arm_matrix_instance_f32 mat_z;
+    arm_matrix_instance_f32 mat_x;
+    arm_matrix_instance_f32 mat_u;
+    arm_matrix_instance_f32 mat_y_free;
+    arm_matrix_instance_f32 mat_y_forced;
+
+    arm_mat_init_f32(&mat_z, MPC_NUM_STATES + 2, 1, z);
+    arm_mat_init_f32(&mat_x, MPC_NUM_STATES, 1, z);
+    arm_mat_init_f32(&mat_u, NC, 1, u);
+    arm_mat_init_f32(&mat_y_free, NH, 1, y_free);
+    arm_mat_init_f32(&mat_y_forced, NH, 1, y_forced);
+
+    /* Unconstrained solution and its predicted positions. */
+    arm_mat_mult_f32(&mpc->mat_k, &mat_z, &mat_u);
+    arm_mat_mult_f32(&mpc->mat_phi, &mat_x, &mat_y_free);
+    arm_mat_mult_f32(&mpc->mat_gamma, &mat_u, &mat_y_forced);
+
+    bool active = false;
+    for (uint32_t i = 0; i < NC; i++)
+    {
+        float32_t du = u[i] - ((i > 0) ? u[i - 1] : z[MPC_NUM_STATES + 1]);
+        kd[ROW_U + i] = (limits->u_max + d) - u[i];
+        kd[ROW_U + NC + i] = u[i] - (limits->u_min + d);
+        kd[ROW_DU + i] = limits->du_max - du;
+        kd[ROW_DU + NC + i] = limits->du_max + du;
+    }
+    for (uint32_t i = 0; i < NH; i++)
+    {
+        float32_t y = y_free[i] + y_forced[i];
+        kd[ROW_Y + i] = limits->y_max - y;
+        kd[ROW_Y + NH + i] = y - limits->y_min;
+    }
+    for (uint32_t i = 0; i < NM; i++)
+    {
+        active |= (kd[i] < 0.0f);
+    }
+
+    *iterations = 0;
+    float32_t out = u[0] - d;
+    float32_t *lambda = state->lambda;
+    if (active == false)
+    {
+        memset(lambda, 0, sizeof(state->lambda));
+    }
+    else
+    {
+        /**
+         * Hildreth's method (Gauss-Seidel on the dual): minimise
+         * 1/2 lambda^T P lambda + lambda^T kd subject to lambda >= 0, then
+         * U = U0 - H^-1 M^T lambda. Warm started from the last step's
+         * multipliers.
+         */
+        while (*iterations < MPC_MAX_ITERATIONS)
+        {
+            float32_t change = 0.0f;
+
+            (*iterations)++;
+            for (uint32_t i = 0; i < NM; i++)
+            {
+                const float32_t *row = &mpc->p[i * NM];
+                float32_t dot;
+
+                arm_dot_prod_f32(row, lambda, NM, &dot);
+                float32_t w = -(kd[i] + dot - (row[i] * lambda[i])) / row[i];
+                w = (w > 0.0f) ? w : 0.0f;
+                change += (w - lambda[i]) * (w - lambda[i]);
+                lambda[i] = w;
+            }
+            if (change < MPC_TOLERANCE)
+            {
+                break;
+            }
+        }
+
+        float32_t correction;
+        arm_dot_prod_f32(mpc->hinv_mt, lambda, NM, &correction);
+        out -= correction;
+    }
+
+    /* The iterations are bounded: hold the first move to its constraint, then the input to its range. */
+    if (out > (u_prev + limits->du_max))
+    {
+        out = u_prev + limits->du_max;
+    }
+    if (out < (u_prev - limits->du_max))
+    {
+        out = u_prev - limits->du_max;
+    }
+    if (out > limits->u_max)
+    {
+        return limits->u_max;
+    }
+    if (out < limits->u_min)
+    {
+        return limits->u_min;
+    }
+    return out;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Discretise the model (zero-order hold at the step period): the
+ *         columns of A are the responses to the unit states, and B the
+ *         response to a unit input, integrated with RK4 sub-steps.
+ * @param  mpc: MPC.
+ * @retval None.
+ */
+static void discretise(MPC_t *mpc)
+{
+    float32_t h = mpc->config.period_s / MPC_DISCRETISE_STEPS;
+
+    for (uint32_t col = 0; col <= MPC_NUM_STATES; col++)
+    {
+        float32_t x[MPC_NUM_STATES] = {0.0f, 0.0f};
+        float32_t u = (col == MPC_NUM_STATES) ? 1.0f : 0.0f;
+
+        if (col < MPC_NUM_STATES)
+        {
+            x[col] = 1.0f;
+        }
+        for (uint32_t i = 0; i < MPC_DISCRETISE_STEPS; i++)
+        {
+            model_rk4(&mpc->config, x, u, h);
+        }
+        for (uint32_t row = 0; row < MPC_NUM_STATES; row++)
+        {
+            if (col < MPC_NUM_STATES)
+            {
+                mpc->a[(row * MPC_NUM_STATES) + col] = x[row];
+            }
+            else
+            {
+                mpc->b[row] = x[row];
+            }
+        }
+    }
+}
+
+/**
+ * @brief  One RK4 step of the continuous-time model:
+ *         position' = velocity,
+ *         velocity' = wn^2 (u - position) - 2 zeta wn velocity.
+ * @param  config: Configuration (model).
+ * @param  x:      State; updated. Passed by reference.
+ * @param  u:      Input.
+ * @param  h:      Step (s).
+ * @retval None.
+ */
+static void model_rk4(const MPC_CONFIG_t *config, float32_t *x, float32_t u, float32_t h)
+{
+    float32_t wn2 = config->wn * config->wn;
+    float32_t c = 2.0f * config->zeta * config->wn;
+    float32_t k1p = x[1];
+    float32_t k1v = (wn2 * (u - x[0])) - (c * x[1]);
+    float32_t k2p = x[1] + (0.5f * h * k1v);
+    float32_t k2v = (wn2 * (u - (x[0] + (0.5f * h * k1p)))) - (c * k2p);
+    float32_t k3p = x[1] + (0.5f * h * k2v);
+    float32_t k3v = (wn2 * (u - (x[0] + (0.5f * h * k2p)))) - (c * k3p);
+    float32_t k4p = x[1] + (h * k3v);
+    float32_t k4v = (wn2 * (u - (x[0] + (h * k3p)))) - (c * k4p);
+
+    x[0] += (h / 6.0f) * (k1p + (2.0f * k2p) + (2.0f * k3p) + k4p);
+    x[1] += (h / 6.0f) * (k1v + (2.0f * k2v) + (2.0f * k3v) + k4v);
+}
+
+/**
+ * @brief  Prediction matrices of the positions over the horizon,
+ *         y(k) = C A^k x + sum(i < k) C A^(k - 1 - i) B u(i) with C = [1 0]
+ *         and u(i) the move min(i, Nc - 1):
+ *             - phi:   rows C A^k (k = 1..N).
+ *             - gamma: sums of the Markov parameters C A^m B per move.
+ * @param  mpc: MPC.
+ * @retval None.
+ */
+static void predict_matrices(MPC_t *mpc)
+{
+    float32_t power[MPC_NUM_STATES * MPC_NUM_STATES] = {1.0f, 0.0f, 0.0f, 1.0f}; /* A^0. */
+    float32_t markov[NH];
+
+    for (uint32_t k = 0; k < NH; k++)
+    {
+        /* Markov parameter C A^k B (before advancing), then A^(k + 1). */
+        markov[k] = (power[0] * mpc->b[0]) + (power[1] * mpc->b[1]);
+
+        float32_t next[MPC_NUM_STATES * MPC_NUM_STATES];
+        for (uint32_t r = 0; r < MPC_NUM_STATES; r++)
+        {
+            for (uint32_t c = 0; c < MPC_NUM_STATES; c++)
+            {
+                next[(r * MPC_NUM_STATES) + c] = (power[r * MPC_NUM_STATES] * mpc->a[c]) +
+                                                 (power[(r * MPC_NUM_STATES) + 1] * mpc->a[MPC_NUM_STATES + c]);
+            }
+        }
+        memcpy(power, next, sizeof(power));
+        mpc->phi[k * MPC_NUM_STATES] = power[0];
+        mpc->phi[(k * MPC_NUM_STATES) + 1] = power[1];
+    }
+
+    memset(mpc->gamma, 0, sizeof(mpc->gamma));
+    for (uint32_t k = 0; k < NH; k++)
+    {
+        /* y(k + 1): inputs i = 0..k. */
+        for (uint32_t i = 0; i <= k; i++)
+        {
+            uint32_t move = (i < NC) ? i : (NC - 1);
+            mpc->gamma[(k * NC) + move] += markov[k - i];
+        }
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -5,9 +5,10 @@
 
 #include "op_mode.h"
 #include "leds.h"
-#include "servo.h"
+#include "servo_ctrl.h"
 
-static OP_MODE_t _op_mode = OP_MODE__UNKNOWN;
+static volatile OP_MODE_t _op_mode = OP_MODE__UNKNOWN; /* Also set from the control loop (see op_mode_set_error_motor). */
+static TaskHandle_t _led_task = NULL;                  /* Notified to illuminate the LEDs (see op_mode_set_error_motor). */
 
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
@@ -29,19 +30,47 @@ bool op_mode_update(void)
     // -> consider implementing as a state-machine
     //
 
-    static uint8_t angle_prev = 0;
-    uint8_t angle_new = servo_get_angle_expected();
-    if (angle_new != angle_prev)
+    /* Motion is detected by the control loop (see servo_ctrl_is_moving). */
+    bool running = false;
+    bool autotune = false;
+    AUTOTUNE_RESULT_t result;
+    SERVO_ID_t sysid_id;
+    OP_MODE_t mode;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        running |= servo_ctrl_is_moving(i);
+        autotune |= (servo_ctrl_get_autotune(i, &result) == AUTOTUNE_STATE__RUNNING);
+    }
+    if (servo_ctrl_get_sysid(&sysid_id) == SYSID_STATE__RUNNING)
+    {
+        /* System identification (the excitation moves the servo). */
+        mode = OP_MODE__SYSID;
+    }
+    else if (autotune)
+    {
+        /* Auto-tuning (the relay experiment moves the servo). */
+        mode = OP_MODE__AUTOTUNE;
+    }
+    else if (running)
     {
         /* Motor running. */
-        _op_mode = OP_MODE__MOTOR_RUNNING;
+        mode = OP_MODE__MOTOR_RUNNING;
     }
     else
     {
         /* System idle. */
-        _op_mode = OP_MODE__IDLE;
+        mode = OP_MODE__IDLE;
     }
-    angle_prev = angle_new;
+
+    /**
+     * Motor faults are latched by the control loop, which sets the mode
+     * itself (see op_mode_set_error_motor): checked in the same critical
+     * section as the write such that a fault detected in between is not
+     * overwritten.
+     */
+    taskENTER_CRITICAL();
+    _op_mode = servo_ctrl_is_faulted() ? OP_MODE__ERROR_MOTOR : mode;
+    taskEXIT_CRITICAL();
 
     /* Determine if the mode has changed. */
     static OP_MODE_t previous = OP_MODE__UNKNOWN;
@@ -66,6 +95,14 @@ void op_mode_set_leds(void)
             leds_set_all(LED_STATE__OFF);
             leds_set_one(LED_ID__YELLOW_1, LED_STATE__ON);
             break;
+        case OP_MODE__AUTOTUNE:
+            leds_set_all(LED_STATE__OFF);
+            leds_set_one(LED_ID__GREEN_1, LED_STATE__ON);
+            leds_set_one(LED_ID__YELLOW_1, LED_STATE__ON);
+            break;
+        case OP_MODE__SYSID:
+            leds_set_all(LED_STATE__ON);
+            break;
         case OP_MODE__ERROR_MOTOR:
         case OP_MODE__ERROR_LCD:
         case OP_MODE__ERROR_PERIPHERALS:
@@ -81,6 +118,20 @@ void op_mode_set_leds(void)
     }
 }
 
+void op_mode_set_led_task(TaskHandle_t handle)
+{
+    _led_task = handle;
+}
+
+void op_mode_set_error_motor(void)
+{
+    _op_mode = OP_MODE__ERROR_MOTOR;
+    if (_led_task != NULL)
+    {
+        freertos_wrapper_task_notify_give_from_isr(_led_task);
+    }
+}
+
 void op_mode_set_error_fw_fault(void)
 {
     _op_mode = OP_MODE__ERROR_FW_FAULT;
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * @file   pid.c
+ * @brief  PID controller source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "pid.h"
+
+/*===== Private Function Prototypes ==========================================*/
+static void load_gains(PID_t *pid);
+static float32_t limit_output(PID_t *pid, float32_t out);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void pid_init(PID_t *pid, const PID_CONFIG_t *config)
+{
+    pid->config = *config;
+    pid->limit_min = config->output_min;
+    pid->limit_max = config->output_max;
+    pid->saturated = false;
+    load_gains(pid);
+    arm_pid_init_f32(&pid->instance, 1);
+}
+
+void pid_set_gains(PID_t *pid, float32_t kp, float32_t ki, float32_t kd)
+{
+    pid->config.kp = kp;
+    pid->config.ki = ki;
+    pid->config.kd = kd;
+    load_gains(pid);
+    arm_pid_init_f32(&pid->instance, 0);
+}
+
+void pid_reset(PID_t *pid)
+{
+    arm_pid_reset_f32(&pid->instance);
+    pid->saturated = false;
+}
+
+void pid_set_actuator_limits(PID_t *pid, float32_t output_min, float32_t output_max)
+{
+    /* Within the configured limits, i.e. never wider, and ordered. */
+    float32_t low = pid->config.output_min;
+    float32_t high = pid->config.output_max;
+
+    pid->limit_min = (output_min > high) ? high : ((output_min < low) ? low : output_min);
+    pid->limit_max = (output_max > high) ? high : ((output_max < pid->limit_min) ? pid->limit_min : output_max);
+}
+
+bool pid_is_saturated(const PID_t *pid)
+{
+    return pid->saturated;
+}
+
+float32_t pid_update(PID_t *pid, float32_t setpoint, float32_t feedback)
+{
+    float32_t out = limit_output(pid, arm_pid_f32(&pid->instance, setpoint - feedback));
+
+    /**
+     * arm_pid_f32 is the incremental form where the previous output (state[2])
+     * acts as the integrator; store the limited value so the integrator cannot
+     * run away whilst the output is clamped.
+     */
+    pid->instance.state[2] = out;
+
+    return out;
+}
+
+float32_t pid_update_rate(PID_t *pid, float32_t setpoint, float32_t feedback, float32_t feedback_rate)
+{
+    if (pid->config.derivative != PID_DERIVATIVE__RATE)
+    {
+        return pid_update(pid, setpoint, feedback);
+    }
+
+    /* The instance's Kd is zero (see load_gains): PI output, integrator stored as for pid_update. */
+    float32_t out = pid_update(pid, setpoint, feedback);
+    bool pi_saturated = pid->saturated;
+
+    out = limit_output(pid, out - (pid->config.kd * feedback_rate));
+    pid->saturated |= pi_saturated;
+
+    return out;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Convert the continuous-time gains in the PID configuration into
+ *         the per-sample gains used by the CMSIS-DSP instance:
+ *             - Kp = kp, Ki = ki * T, Kd = kd / T.
+ *         With PID_DERIVATIVE__RATE the instance's Kd is zero; the derivative
+ *         term is applied by pid_update_rate.
+ * @param  pid: PID controller.
+ * @retval None.
+ */
+static void load_gains(PID_t *pid)
+{
+    pid->instance.Kp = pid->config.kp;
+    pid->instance.Ki = pid->config.ki * pid->config.period_s;
+    pid->instance.Kd = (pid->config.derivative == PID_DERIVATIVE__RATE) ? 0.0f : (pid->config.kd / pid->config.period_s);
+}
+
+/**
+ * @brief  Limit a controller output to (limit_min..limit_max), i.e. the
+ *         configured and actuator limits, and record whether it was limited.
+ * @param  pid: PID controller.
+ * @param  out: Controller output.
+ * @retval Limited controller output.
+ */
+static float32_t limit_output(PID_t *pid, float32_t out)
+{
+    pid->saturated = true;
+    if (out > pid->limit_max)
+    {
+        return pid->limit_max;
+    }
+    if (out < pid->limit_min)
+    {
+        return pid->limit_min;
+    }
+    pid->saturated = false;
+    return out;
+}
+
+/*============================================================================*/
\ No newline at end of file
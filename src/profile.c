@@ -0,0 +1,499 @@
+/*******************************************************************************
+ * @file   profile.c
+ * @brief  Motion profile (trajectory) generator source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "profile.h"
+
+/*===== Defines & Macros =====================================================*/
+
+#define PROFILE_Q16_SHIFT           (PROFILE_FRAC_BITS - 16) /* Q16.16 <-> Q24.40. */
+#define PROFILE_ONE                 ((float32_t)(1ULL << PROFILE_FRAC_BITS))
+#define PROFILE_BISECT_ITERATIONS   24
+#define PROFILE_TICKS_EPSILON       1.0e-3f /* Tolerance before rounding a duration up to the next tick. */
+
+/*===== Typedefs =============================================================*/
+
+typedef struct PROFILE_STATE_t {
+    int64_t p; /* Displacement (Q24.40). */
+    int64_t v; /* Velocity (Q24.40 per tick). */
+    int64_t a; /* Acceleration (Q24.40 per tick^2). */
+} PROFILE_STATE_t;
+
+/*===== Private Function Prototypes ==========================================*/
+static void timing_trapezoidal(float32_t d, float32_t v, float32_t a, PROFILE_TIMING_t *timing);
+static void timing_s_curve(float32_t d, float32_t v, float32_t a, float32_t j, PROFILE_TIMING_t *timing);
+static void build_move(PROFILE_MOVE_t *move, float32_t d, float32_t sign, const PROFILE_TIMING_t *timing);
+static void s_curve_times(float32_t v, float32_t a, float32_t j, float32_t *tj, float32_t *ta);
+static void append_segment(PROFILE_MOVE_t *move, PROFILE_STATE_t *state, uint32_t ticks, int64_t acceleration, int64_t jerk);
+static uint32_t ceil_ticks(float32_t t);
+static int64_t to_fixed(float32_t value);
+static int64_t run_displacement(const PROFILE_MOVE_t *move, const PROFILE_RUN_t *run);
+static void run_derivatives(const PROFILE_MOVE_t *move, const PROFILE_RUN_t *run, int64_t *velocity, int64_t *acceleration);
+static bool run_advance(const PROFILE_MOVE_t *move, PROFILE_RUN_t *run);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void profile_init(PROFILE_GEN_t *gen, uint32_t rate_hz, int32_t position)
+{
+    gen->rate_hz = rate_hz;
+    gen->velocity_scale = (float32_t)rate_hz / PROFILE_ONE;
+    gen->acceleration_scale = ((float32_t)rate_hz * (float32_t)rate_hz) / PROFILE_ONE;
+    gen->moves_started = 0;
+    profile_reset(gen, position);
+}
+
+void profile_reset(PROFILE_GEN_t *gen, int32_t position)
+{
+    gen->position = (int64_t)position << PROFILE_Q16_SHIFT;
+    gen->queued_end = gen->position;
+    gen->head = 0;
+    gen->tail = 0;
+    gen->count = 0;
+    gen->num_running = 0;
+    gen->velocity = 0.0f;
+    gen->acceleration = 0.0f;
+}
+
+bool profile_plan(PROFILE_GEN_t *gen, PROFILE_TYPE_t type, int32_t target, const PROFILE_LIMITS_t *limits, bool blend)
+{
+    PROFILE_TIMING_t timing;
+    int64_t distance = ((int64_t)target << PROFILE_Q16_SHIFT) - gen->queued_end;
+    float32_t d = (float32_t)((distance < 0) ? -distance : distance) / PROFILE_ONE;
+
+    if ((gen->count >= PROFILE_QUEUE_LEN) || (profile_plan_timing(type, d, limits, gen->rate_hz, &timing) == false))
+    {
+        return false;
+    }
+    return profile_plan_timed(gen, target, &timing, blend);
+}
+
+bool profile_plan_timing(PROFILE_TYPE_t type, float32_t distance, const PROFILE_LIMITS_t *limits, uint32_t rate_hz,
+                         PROFILE_TIMING_t *timing)
+{
+    if ((distance < 0.0f) || (limits->velocity <= 0.0f) || (limits->acceleration <= 0.0f) ||
+        ((type == PROFILE_TYPE__S_CURVE) && (limits->jerk <= 0.0f)))
+    {
+        return false;
+    }
+
+    *timing = (PROFILE_TIMING_t){.type = type};
+    if (distance == 0.0f)
+    {
+        return true;
+    }
+
+    /* In units and ticks. */
+    float32_t rate = (float32_t)rate_hz;
+    float32_t v = limits->velocity / rate;
+    float32_t a = limits->acceleration / (rate * rate);
+    if (type == PROFILE_TYPE__S_CURVE)
+    {
+        timing_s_curve(distance, v, a, limits->jerk / (rate * rate * rate), timing);
+    }
+    else
+    {
+        timing_trapezoidal(distance, v, a, timing);
+    }
+
+    return true;
+}
+
+uint32_t profile_timing_get_ticks(const PROFILE_TIMING_t *timing)
+{
+    if (timing->type == PROFILE_TYPE__S_CURVE)
+    {
+        return (4 * timing->ramp) + (2 * timing->accel) + timing->cruise;
+    }
+    return (2 * timing->ramp) + timing->cruise;
+}
+
+bool profile_plan_timed(PROFILE_GEN_t *gen, int32_t target, const PROFILE_TIMING_t *timing, bool blend)
+{
+    if (gen->count >= PROFILE_QUEUE_LEN)
+    {
+        return false;
+    }
+
+    PROFILE_MOVE_t *move = &gen->queue[gen->head];
+    int64_t distance = ((int64_t)target << PROFILE_Q16_SHIFT) - gen->queued_end;
+
+    move->distance = distance;
+    move->blend = blend;
+    move->num_segments = 0;
+    move->total_ticks = 0;
+    move->decel_tick = 0;
+
+    /* The magnitude in units; the sign is applied to the segment coefficients. */
+    float32_t d = (float32_t)((distance < 0) ? -distance : distance) / PROFILE_ONE;
+    build_move(move, d, (distance < 0) ? -1.0f : 1.0f, timing);
+
+    return true;
+}
+
+void profile_commit(PROFILE_GEN_t *gen)
+{
+    gen->queued_end += gen->queue[gen->head].distance;
+    gen->head = (gen->head + 1) % PROFILE_QUEUE_LEN;
+    gen->count++;
+}
+
+int32_t profile_next(PROFILE_GEN_t *gen)
+{
+    /* Start the oldest move, or blend in the next one once the running move decelerates. */
+    if ((gen->num_running == 0) && (gen->count > 0))
+    {
+        gen->run[0] = (PROFILE_RUN_t){0};
+        gen->num_running = 1;
+        gen->moves_started++;
+    }
+    else if ((gen->num_running == 1) && (gen->count > 1))
+    {
+        const PROFILE_MOVE_t *next = &gen->queue[(gen->tail + 1) % PROFILE_QUEUE_LEN];
+        if (next->blend && (gen->run[0].elapsed >= gen->queue[gen->tail].decel_tick))
+        {
+            gen->run[1] = (PROFILE_RUN_t){0};
+            gen->num_running = 2;
+            gen->moves_started++;
+        }
+    }
+
+    /* Advance, then superpose the running moves' displacements (i.e. a move's last tick is at its distance). */
+    const PROFILE_MOVE_t *move_0 = &gen->queue[gen->tail];
+    const PROFILE_MOVE_t *move_1 = &gen->queue[(gen->tail + 1) % PROFILE_QUEUE_LEN];
+    int64_t position = gen->position;
+    int64_t velocity = 0;
+    int64_t acceleration = 0;
+    bool done_0 = false;
+    bool done_1 = false;
+    if (gen->num_running > 0)
+    {
+        done_0 = run_advance(move_0, &gen->run[0]);
+        position += run_displacement(move_0, &gen->run[0]);
+        run_derivatives(move_0, &gen->run[0], &velocity, &acceleration);
+    }
+    if (gen->num_running > 1)
+    {
+        done_1 = run_advance(move_1, &gen->run[1]);
+        position += run_displacement(move_1, &gen->run[1]);
+        run_derivatives(move_1, &gen->run[1], &velocity, &acceleration);
+    }
+    gen->velocity = (float32_t)velocity * gen->velocity_scale;
+    gen->acceleration = (float32_t)acceleration * gen->acceleration_scale;
+
+    /* Retire finished moves in order. */
+    if (done_0)
+    {
+        gen->position += move_0->distance;
+        gen->tail = (gen->tail + 1) % PROFILE_QUEUE_LEN;
+        gen->count--;
+        gen->run[0] = gen->run[1];
+        gen->num_running--;
+        if ((gen->num_running > 0) && done_1)
+        {
+            gen->position += move_1->distance;
+            gen->tail = (gen->tail + 1) % PROFILE_QUEUE_LEN;
+            gen->count--;
+            gen->num_running--;
+        }
+    }
+
+    return (int32_t)((position + (1LL << (PROFILE_Q16_SHIFT - 1))) >> PROFILE_Q16_SHIFT);
+}
+
+float32_t profile_get_velocity(const PROFILE_GEN_t *gen)
+{
+    return gen->velocity;
+}
+
+float32_t profile_get_acceleration(const PROFILE_GEN_t *gen)
+{
+    return gen->acceleration;
+}
+
+int32_t profile_get_end(const PROFILE_GEN_t *gen)
+{
+    return (int32_t)(gen->queued_end >> PROFILE_Q16_SHIFT);
+}
+
+uint32_t profile_get_moves_started(const PROFILE_GEN_t *gen)
+{
+    return gen->moves_started;
+}
+
+bool profile_is_busy(const PROFILE_GEN_t *gen)
+{
+    return (gen->count > 0);
+}
+
+uint32_t profile_get_queue_space(const PROFILE_GEN_t *gen)
+{
+    return PROFILE_QUEUE_LEN - gen->count;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Time a trapezoidal move: accelerate (Ta), cruise (Tc), decelerate
+ *         (Ta), in whole ticks.
+ * @param  d:      Distance magnitude (units; > 0).
+ * @param  v:      Maximum velocity (units/tick).
+ * @param  a:      Maximum acceleration (units/tick^2).
+ * @param  timing: Timing. Passed by reference.
+ * @retval None.
+ */
+static void timing_trapezoidal(float32_t d, float32_t v, float32_t a, PROFILE_TIMING_t *timing)
+{
+    /* Triangular if the maximum velocity cannot be reached. */
+    if ((v * v) > (d * a))
+    {
+        v = sqrtf(d * a);
+    }
+    uint32_t ta = ceil_ticks(v / a);
+    timing->ramp = (ta == 0) ? 1 : ta;
+    timing->accel = 0;
+    timing->cruise = ceil_ticks((d / v) - (v / a));
+}
+
+/**
+ * @brief  Time a 7 segment S-curve move: jerk (Tj), constant acceleration
+ *         (Ta), jerk (Tj), cruise (Tv), and the mirror image to decelerate,
+ *         in whole ticks.
+ * @param  d:      Distance magnitude (units; > 0).
+ * @param  v:      Maximum velocity (units/tick).
+ * @param  a:      Maximum acceleration (units/tick^2).
+ * @param  j:      Maximum jerk (units/tick^3).
+ * @param  timing: Timing. Passed by reference.
+ * @retval None.
+ */
+static void timing_s_curve(float32_t d, float32_t v, float32_t a, float32_t j, PROFILE_TIMING_t *timing)
+{
+    float32_t tj;
+    float32_t ta;
+
+    /* Reduce the peak velocity (bisection) if the move is too short to reach it: d = v x (2tj + ta) at the peak. */
+    s_curve_times(v, a, j, &tj, &ta);
+    if ((v * ((2.0f * tj) + ta)) > d)
+    {
+        float32_t lo = 0.0f;
+        float32_t hi = v;
+        for (uint32_t i = 0; i < PROFILE_BISECT_ITERATIONS; i++)
+        {
+            v = 0.5f * (lo + hi);
+            s_curve_times(v, a, j, &tj, &ta);
+            if ((v * ((2.0f * tj) + ta)) > d)
+            {
+                hi = v;
+            }
+            else
+            {
+                lo = v;
+            }
+        }
+        v = lo;
+        s_curve_times(v, a, j, &tj, &ta);
+    }
+    float32_t tv = (d / v) - ((2.0f * tj) + ta);
+
+    uint32_t n_j = ceil_ticks(tj);
+    timing->ramp = (n_j == 0) ? 1 : n_j;
+    timing->accel = ceil_ticks(ta);
+    timing->cruise = ceil_ticks(tv);
+}
+
+/**
+ * @brief  Build a move's segments to a timing. With whole-tick durations the
+ *         acceleration (trapezoidal) is reduced to d / (Ta x (Ta + Tc)), and
+ *         the jerk (S-curve) to d / (Tj x (Tj + Ta) x (2Tj + Ta + Tv)), such
+ *         that the move ends exactly at @param d; a zero distance holds for
+ *         the timing's duration.
+ * @param  move:   Move.
+ * @param  d:      Distance magnitude (units).
+ * @param  sign:   Direction (+/-1).
+ * @param  timing: Timing.
+ * @retval None.
+ */
+static void build_move(PROFILE_MOVE_t *move, float32_t d, float32_t sign, const PROFILE_TIMING_t *timing)
+{
+    PROFILE_STATE_t state = {0};
+    uint32_t n_j = timing->ramp;
+    uint32_t n_a = timing->accel;
+    uint32_t n_v = timing->cruise;
+
+    if (n_j == 0)
+    {
+        return;
+    }
+
+    if (timing->type == PROFILE_TYPE__S_CURVE)
+    {
+        int64_t jerk =
+            to_fixed(sign * d / ((float32_t)n_j * (float32_t)(n_j + n_a) * (float32_t)((2 * n_j) + n_a + n_v)));
+        append_segment(move, &state, n_j, state.a, jerk);
+        append_segment(move, &state, n_a, state.a, 0);
+        append_segment(move, &state, n_j, state.a, -jerk);
+        append_segment(move, &state, n_v, 0, 0);
+        move->decel_tick = move->total_ticks;
+        append_segment(move, &state, n_j, 0, -jerk);
+        append_segment(move, &state, n_a, state.a, 0);
+        append_segment(move, &state, n_j, state.a, jerk);
+    }
+    else
+    {
+        int64_t acceleration = to_fixed(sign * d / ((float32_t)n_j * (float32_t)(n_j + n_v)));
+        append_segment(move, &state, n_j, acceleration, 0);
+        append_segment(move, &state, n_v, 0, 0);
+        move->decel_tick = move->total_ticks;
+        append_segment(move, &state, n_j, -acceleration, 0);
+    }
+}
+
+/**
+ * @brief  S-curve jerk and constant acceleration times to reach a velocity
+ *         from rest: tj = a / j (ta = v / a - tj), or tj = sqrt(v / j)
+ *         (ta = 0) if the maximum acceleration is not reached.
+ * @param  v:  Velocity (units/tick).
+ * @param  a:  Maximum acceleration (units/tick^2).
+ * @param  j:  Maximum jerk (units/tick^3).
+ * @param  tj: Jerk time (ticks). Passed by reference.
+ * @param  ta: Constant acceleration time (ticks). Passed by reference.
+ * @retval None.
+ */
+static void s_curve_times(float32_t v, float32_t a, float32_t j, float32_t *tj, float32_t *ta)
+{
+    if ((v * j) < (a * a))
+    {
+        *tj = sqrtf(v / j);
+        *ta = 0.0f;
+    }
+    else
+    {
+        *tj = a / j;
+        *ta = (v / a) - *tj;
+    }
+}
+
+/**
+ * @brief  Append a segment to a move, with the coefficients of its cubic in
+ *         the tick count k (p0 + k(c1 + k(c2 + k c3))), and advance the state
+ *         to its end by evaluating the same cubic (i.e. continuous in
+ *         fixed-point). Zero length segments are skipped.
+ * @param  move:         Move.
+ * @param  state:        State at the start of the segment. Passed by reference.
+ * @param  ticks:        Duration (ticks).
+ * @param  acceleration: Acceleration at the start of the segment (Q24.40 per tick^2).
+ * @param  jerk:         Jerk (Q24.40 per tick^3).
+ * @retval None.
+ */
+static void append_segment(PROFILE_MOVE_t *move, PROFILE_STATE_t *state, uint32_t ticks, int64_t acceleration, int64_t jerk)
+{
+    if (ticks == 0)
+    {
+        state->a = acceleration;
+        return;
+    }
+
+    PROFILE_SEGMENT_t *seg = &move->segment[move->num_segments++];
+    int64_t k = ticks;
+
+    seg->ticks = ticks;
+    seg->p0 = state->p;
+    seg->c1 = state->v;
+    seg->c2 = acceleration / 2;
+    seg->c3 = jerk / 6;
+
+    state->p = seg->p0 + (k * (seg->c1 + (k * (seg->c2 + (k * seg->c3)))));
+    state->v += (acceleration * k) + ((jerk * k * k) / 2);
+    state->a = acceleration + (jerk * k);
+    move->total_ticks += ticks;
+}
+
+/**
+ * @brief  Round a duration up to whole ticks, tolerating rounding errors of
+ *         durations which are (almost) whole.
+ * @param  t: Duration (ticks).
+ * @retval Ticks.
+ */
+static uint32_t ceil_ticks(float32_t t)
+{
+    return (t > PROFILE_TICKS_EPSILON) ? (uint32_t)ceilf(t - PROFILE_TICKS_EPSILON) : 0;
+}
+
+/**
+ * @brief  Convert to fixed-point (Q24.40), rounding to nearest.
+ * @param  value: Value (units).
+ * @retval Fixed-point value.
+ */
+static int64_t to_fixed(float32_t value)
+{
+    return (int64_t)((value * PROFILE_ONE) + ((value < 0.0f) ? -0.5f : 0.5f));
+}
+
+/**
+ * @brief  Evaluate a running move's displacement at its current tick.
+ * @param  move: Move.
+ * @param  run:  Run state.
+ * @retval Displacement (Q24.40).
+ */
+static int64_t run_displacement(const PROFILE_MOVE_t *move, const PROFILE_RUN_t *run)
+{
+    if (run->segment >= move->num_segments)
+    {
+        return move->distance;
+    }
+
+    const PROFILE_SEGMENT_t *seg = &move->segment[run->segment];
+    int64_t k = run->tick;
+    return seg->p0 + (k * (seg->c1 + (k * (seg->c2 + (k * seg->c3)))));
+}
+
+/**
+ * @brief  Accumulate a running move's velocity and acceleration at its
+ *         current tick (derivatives of the segment's cubic).
+ * @param  move:         Move.
+ * @param  run:          Run state.
+ * @param  velocity:     Velocity (Q24.40 per tick); accumulated. Passed by
+ *                       reference.
+ * @param  acceleration: Acceleration (Q24.40 per tick^2); accumulated.
+ *                       Passed by reference.
+ * @retval None.
+ */
+static void run_derivatives(const PROFILE_MOVE_t *move, const PROFILE_RUN_t *run, int64_t *velocity, int64_t *acceleration)
+{
+    if (run->segment >= move->num_segments)
+    {
+        return;
+    }
+
+    const PROFILE_SEGMENT_t *seg = &move->segment[run->segment];
+    int64_t k = run->tick;
+    *velocity += seg->c1 + (k * ((2 * seg->c2) + (3 * k * seg->c3)));
+    *acceleration += (2 * seg->c2) + (6 * k * seg->c3);
+}
+
+/**
+ * @brief  Advance a running move by one tick.
+ * @param  move: Move.
+ * @param  run:  Run state. Passed by reference.
+ * @retval Boolean indicating whether the move has finished.
+ */
+static bool run_advance(const PROFILE_MOVE_t *move, PROFILE_RUN_t *run)
+{
+    if (run->segment < move->num_segments)
+    {
+        run->elapsed++;
+        if (++run->tick >= move->segment[run->segment].ticks)
+        {
+            run->tick = 0;
+            run->segment++;
+        }
+    }
+    return (run->segment >= move->num_segments);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -4,43 +4,62 @@
  ******************************************************************************/
 
 #include "rtos.h"
+#include "com_cmd.h"
 #include "lcd.h"
 #include "op_mode.h"
 #include "servo.h"
+#include "servo_ctrl.h"
 #include "usart.h"
 
 /*===== Defines & Typedefs ===================================================*/
 /*===== Task Delays =====*/
 #define TASK_DELAY_MS__TASK_NUCLEO_COM_PORT_IF          1000
+#define TASK_DELAY_MS__TASK_NUCLEO_COM_PORT_RX          5
 #define TASK_DELAY_MS__TASK_OP_MODE_MGMT                50
 #define TASK_DELAY_MS__TASK_LED_CTRL                    50
 #define TASK_DELAY_MS__TASK_SERVO_MOTOR_CTRL            100
 #define TASK_DELAY_MS__TASK_LCD_CTRL                    50
+#define TASK_DELAY_MS__TASK_ILC                         20
 /*===== Task Priorities =====*/
 #define TASK_PRIORITY__TASK_DEFAULT                     1
 #define TASK_PRIORITY__TASK_NUCLEO_COM_PORT_IF          4
+#define TASK_PRIORITY__TASK_NUCLEO_COM_PORT_RX          6
 #define TASK_PRIORITY__TASK_OP_MODE_MGMT                3
 #define TASK_PRIORITY__TASK_LED_CTRL                    2
 #define TASK_PRIORITY__TASK_SERVO_MOTOR_CTRL            6
 #define TASK_PRIORITY__TASK_LCD_CTRL                    5
+#define TASK_PRIORITY__TASK_ILC                         1
 /*===== Task Stack Sizes =====*/
-#define TASK_STACK_SIZE__TASK_NUCLEO_COM_PORT_IF        (configMINIMAL_STACK_SIZE*2)
+#define TASK_STACK_SIZE__TASK_NUCLEO_COM_PORT_IF        (configMINIMAL_STACK_SIZE*4) /* com_cmd_tx_status (~0.8 KB) and sprintf. */
+#define TASK_STACK_SIZE__TASK_NUCLEO_COM_PORT_RX        (configMINIMAL_STACK_SIZE*3) /* Line buffer, com_cmd_execute and sprintf. */
+#define TASK_STACK_SIZE__TASK_SERVO_MOTOR_CTRL          (configMINIMAL_STACK_SIZE*3) /* servo_ctrl_move_coordinated -> coord_plan -> profile_plan_timed. */
 #define TASK_STACK_SIZE__TASK_LCD_CTRL                  (configMINIMAL_STACK_SIZE*2)
+#define TASK_STACK_SIZE__TASK_ILC                       (configMINIMAL_STACK_SIZE*2)
+/*===== Nucleo COM Port Reception =====*/
+#define RX_LINE_MAX                                     100 /* Maximum command line length (excluding the terminator). */
+#define RX_CHUNK_SIZE                                   32  /* Bytes retrieved per usart_rx call. */
 /*===== Task Handles =====*/
+static TaskHandle_t task_handle_default = NULL;
+static TaskHandle_t task_handle_nucleo_com_port_if = NULL;
+static TaskHandle_t task_handle_nucleo_com_port_rx = NULL;
 static TaskHandle_t task_handle_op_mode_mgmt = NULL;
 static TaskHandle_t task_handle_led_ctrl = NULL;
+static TaskHandle_t task_handle_servo_motor_ctrl = NULL;
+static TaskHandle_t task_handle_lcd_ctrl = NULL;
+static TaskHandle_t task_handle_ilc = NULL;
 
 /*===== Private Function Prototypes ==========================================*/
 /*===== FreeRTOS Tasks =====*/
 static void task_default(void *params __attribute__((unused)));
 static void task_nucleo_com_port_if(void *params __attribute__((unused)));
+static void task_nucleo_com_port_rx(void *params __attribute__((unused)));
 static void task_op_mode_mgmt(void *params __attribute__((unused)));
 static void task_led_ctrl(void *params __attribute__((unused)));
 static void task_servo_motor_ctrl(void *params __attribute__((unused)));
 static void task_lcd_ctrl(void *params __attribute__((unused)));
+static void task_ilc(void *params __attribute__((unused)));
 /*===== Other Private Functions =====*/
 static void tasks_init(void);
-static void tx_op_mode_to_com_port(void);
 
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
@@ -49,6 +68,7 @@ static void tx_op_mode_to_com_port(void);
 void rtos_init(void)
 {
     /* Initialisation (tasks/queues/locks/etc.). */
+    com_cmd_init();
     tasks_init();
 
     /* Start scheduler. */
@@ -85,17 +105,95 @@ static void task_default(void *params __attribute__((unused)))
  */
 static void task_nucleo_com_port_if(void *params __attribute__((unused)))
 {
+    const TaskHandle_t tasks[] = {
+        task_handle_default,
+        task_handle_nucleo_com_port_if,
+        task_handle_nucleo_com_port_rx,
+        task_handle_op_mode_mgmt,
+        task_handle_led_ctrl,
+        task_handle_servo_motor_ctrl,
+        task_handle_lcd_ctrl,
+        task_handle_ilc,
+    };
+
+    /* Retrieve relevant USART handle. */
+    UART_HandleTypeDef *handle = NULL;
+    if (usart_get_handle(USART_ID__NUCLEO_COM_PORT, &handle) == false)
+    {
+        error_handler();
+    }
+
     /* Task. */
     while (1)
     {
-        /* Transmit operational mode. */
-        tx_op_mode_to_com_port();
+        /* Transmit operational mode, positions and statistics. */
+        com_cmd_tx_status(handle);
+
+        /* Transmit the tasks' stack and the heap usage (in order of creation, see tasks_init). */
+        com_cmd_tx_rtos_stats(handle, tasks, NUM_ARRAY_ELS(tasks));
 
         /* Block (delay). */
         freertos_wrapper_task_delay_ms(TASK_DELAY_MS__TASK_NUCLEO_COM_PORT_IF);
     }
 }
 
+/**
+ * @brief  RTOS task ---
+ *         Nucleo COM port reception: assembles the received data into command
+ *         lines (terminated by CR and/or LF), executes them and answers each
+ *         (see com_cmd_execute).
+ * @param  params: Unused.
+ * @retval None.
+ */
+static void task_nucleo_com_port_rx(void *params __attribute__((unused)))
+{
+    uint8_t chunk[RX_CHUNK_SIZE];
+    char line[RX_LINE_MAX + 1] = {0}; /* +1 for '\0'. */
+    uint32_t len = 0;
+    bool discard = false; /* Discarding an over-long line up to its terminator. */
+
+    /* Retrieve relevant USART handle. */
+    UART_HandleTypeDef *handle = NULL;
+    if (usart_get_handle(USART_ID__NUCLEO_COM_PORT, &handle) == false)
+    {
+        error_handler();
+    }
+
+    /* Task. */
+    while (1)
+    {
+        uint32_t count;
+        while ((count = usart_rx(handle, chunk, sizeof(chunk))) > 0)
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                char c = (char)chunk[i];
+                if ((c == '\r') || (c == '\n'))
+                {
+                    if ((discard == false) && (len > 0))
+                    {
+                        line[len] = '\0';
+                        com_cmd_execute(handle, line);
+                    }
+                    len = 0;
+                    discard = false;
+                }
+                else if (len < RX_LINE_MAX)
+                {
+                    line[len++] = c;
+                }
+                else
+                {
+                    discard = true;
+                }
+            }
+        }
+
+        /* Block (delay). */
+        freertos_wrapper_task_delay_ms(TASK_DELAY_MS__TASK_NUCLEO_COM_PORT_RX);
+    }
+}
+
 /**
  * @brief  RTOS task ---
  *         Operational mode management.
@@ -159,7 +257,15 @@ static void task_led_ctrl(void *params __attribute__((unused)))
  */
 static void task_servo_motor_ctrl(void *params __attribute__((unused)))
 {
-    servo_set_signal(true);
+    const PROFILE_LIMITS_t limits = {
+        .velocity = SERVO_CTRL_MOVE_VELOCITY_DEG_S,
+        .acceleration = SERVO_CTRL_MOVE_ACCEL_DEG_S2,
+        .jerk = SERVO_CTRL_MOVE_JERK_DEG_S3,
+    };
+    bool toward_max = true;
+
+    servo_set_signal_all(true);
+    servo_ctrl_enable(true);
 
     /* Idle for 5 seconds before starting. */
     freertos_wrapper_task_delay_ms(5000);
@@ -167,10 +273,26 @@ static void task_servo_motor_ctrl(void *params __attribute__((unused)))
     /* Task. */
     while (1)
     {
-        // @todo: close the loop / implement controller / implement state-machine
-
-        /* Test feature. */
-        servo_test_oscillate(SERVO_POSITION_MIN_DEG_UINT, SERVO_POSITION_MAX_DEG_UINT, false);
+        /**
+         * Test feature: coordinated S-curve moves of all servos between the
+         * position limits; the control loop (TIM6 interrupt) evaluates the
+         * moves and drives the PWM signals. The next move is queued whilst
+         * the current one runs (the queues are in lock-step). Paused whilst
+         * a host setpoint stream is active, or a servo is being auto-tuned
+         * or identified.
+         */
+        if ((servo_ctrl_stream_is_active() == false) && (servo_ctrl_get_moves_queued(SERVO_ID__1) < 2))
+        {
+            SERVO_ANGLE_Q16_t targets[SERVO_NUM_SERVOS];
+            for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+            {
+                targets[i] = toward_max ? SERVO_POSITION_MAX_Q16 : SERVO_POSITION_MIN_Q16;
+            }
+            if (servo_ctrl_move_coordinated(targets, PROFILE_TYPE__S_CURVE, &limits, false))
+            {
+                toward_max = !toward_max;
+            }
+        }
 
         /* Block (delay). */
         freertos_wrapper_task_delay_ms(TASK_DELAY_MS__TASK_SERVO_MOTOR_CTRL);
@@ -192,7 +314,7 @@ static void task_lcd_ctrl(void *params __attribute__((unused)))
     {
         /* Page 1, Line 1. */
         memset(data, 0, LCD_MAX_DIGITS);
-        sprintf(data, "POS (DEG): %d", servo_get_angle_expected());
+        sprintf(data, "POS (DEG): %d", servo_get_angle_expected(SERVO_ID__1));
         lcd_write_line(LCD_LINE_NUM_1, (uint8_t*)data, strlen(data));
 
         /* Page 1, Line 2. */
@@ -202,6 +324,8 @@ static void task_lcd_ctrl(void *params __attribute__((unused)))
             case OP_MODE__UNKNOWN:           sprintf(data, "UNKNOWN");       break;
             case OP_MODE__IDLE:              sprintf(data, "IDLE");          break;
             case OP_MODE__MOTOR_RUNNING:     sprintf(data, "MOTOR RUNNING"); break;
+            case OP_MODE__AUTOTUNE:          sprintf(data, "AUTO-TUNING");   break;
+            case OP_MODE__SYSID:             sprintf(data, "IDENTIFYING");   break;
             case OP_MODE__ERROR_MOTOR:       sprintf(data, "ERROR (MOTOR)"); break;
             case OP_MODE__ERROR_LCD:         sprintf(data, "ERROR (LCD)");   break;
             case OP_MODE__ERROR_PERIPHERALS: sprintf(data, "ERROR (OTHER)"); break;
@@ -215,6 +339,30 @@ static void task_lcd_ctrl(void *params __attribute__((unused)))
     }
 }
 
+/**
+ * @brief  RTOS task ---
+ *         Iterative learning control: learns the servos' next feedforward
+ *         corrections between their motion cycles (see
+ *         servo_ctrl_ilc_process), and adapts their adaptive feedforward
+ *         from the recorded blocks (see servo_ctrl_lms_process), at the
+ *         lowest priority such that the learning never delays the control
+ *         loop or the other tasks.
+ * @param  params: Unused.
+ * @retval None.
+ */
+static void task_ilc(void *params __attribute__((unused)))
+{
+    /* Task. */
+    while (1)
+    {
+        servo_ctrl_ilc_process();
+        servo_ctrl_lms_process();
+
+        /* Block (delay). */
+        freertos_wrapper_task_delay_ms(TASK_DELAY_MS__TASK_ILC);
+    }
+}
+
 /*===== Other Private Functions ==============================================*/
 
 /**
@@ -228,13 +376,19 @@ static void tasks_init(void)
                                  configMINIMAL_STACK_SIZE,
                                  (void *)0,
                                  TASK_PRIORITY__TASK_DEFAULT,
-                                 0);
+                                 &task_handle_default);
     freertos_wrapper_task_create(task_nucleo_com_port_if,
                                  "task_nucleo_com_port_if",
                                  TASK_STACK_SIZE__TASK_NUCLEO_COM_PORT_IF,
                                  (void *)0,
                                  TASK_PRIORITY__TASK_NUCLEO_COM_PORT_IF,
-                                 0);
+                                 &task_handle_nucleo_com_port_if);
+    freertos_wrapper_task_create(task_nucleo_com_port_rx,
+                                 "task_nucleo_com_port_rx",
+                                 TASK_STACK_SIZE__TASK_NUCLEO_COM_PORT_RX,
+                                 (void *)0,
+                                 TASK_PRIORITY__TASK_NUCLEO_COM_PORT_RX,
+                                 &task_handle_nucleo_com_port_rx);
     freertos_wrapper_task_create(task_op_mode_mgmt,
                                  "task_op_mode_mgmt",
                                  configMINIMAL_STACK_SIZE,
@@ -247,76 +401,25 @@ static void tasks_init(void)
                                  (void *)0,
                                  TASK_PRIORITY__TASK_LED_CTRL,
                                  &task_handle_led_ctrl);
+    op_mode_set_led_task(task_handle_led_ctrl);
     freertos_wrapper_task_create(task_servo_motor_ctrl,
                                  "task_servo_motor_ctrl",
-                                 configMINIMAL_STACK_SIZE,
+                                 TASK_STACK_SIZE__TASK_SERVO_MOTOR_CTRL,
                                  (void *)0,
                                  TASK_PRIORITY__TASK_SERVO_MOTOR_CTRL,
-                                 0);
+                                 &task_handle_servo_motor_ctrl);
     freertos_wrapper_task_create(task_lcd_ctrl,
                                  "task_lcd_ctrl",
                                  TASK_STACK_SIZE__TASK_LCD_CTRL,
                                  (void *)0,
                                  TASK_PRIORITY__TASK_LCD_CTRL,
-                                 0);
-}
-
-/**
- * @brief  Construct and transmit a message via the Nucleo COM port interface:
- *             - Message: operational mode.
- *             - Message: servo motor shaft position (angle in degrees).
- * @retval None.
- */
-static void tx_op_mode_to_com_port(void)
-{
-    #define TX_BUFF_MAX 100
-    char data[TX_BUFF_MAX] = {0};
-    int pos = 0; /* Tx buffer position; for use with sprintf(). */
-
-    /* Construct message. */
-    pos += sprintf(&data[pos], "Operational mode: ");
-    switch (op_mode_get())
-    {
-        case OP_MODE__UNKNOWN:
-            pos += sprintf(&data[pos], "UNKNOWN");
-            break;
-        case OP_MODE__IDLE:
-            pos += sprintf(&data[pos], "IDLE");
-            break;
-        case OP_MODE__MOTOR_RUNNING:
-            pos += sprintf(&data[pos], "MOTOR RUNNING");
-            break;
-        case OP_MODE__ERROR_MOTOR:
-            pos += sprintf(&data[pos], "ERROR (MOTOR)");
-            break;
-        case OP_MODE__ERROR_LCD:
-            pos += sprintf(&data[pos], "ERROR (LCD)");
-            break;
-        case OP_MODE__ERROR_PERIPHERALS:
-            pos += sprintf(&data[pos], "ERROR (PERIPHERALS)");
-            break;
-        case OP_MODE__ERROR_FW_FAULT:
-            pos += sprintf(&data[pos], "ERROR (FIRMWARE FAULT)");
-            break;
-        default:
-            break;
-    }
-    sprintf(&data[pos], "\r\n"); /* CRLF. */
-
-    /* Retrieve relevant USART handle. */
-    UART_HandleTypeDef *handle = NULL;
-    if (usart_get_handle(USART_ID__NUCLEO_COM_PORT, &handle) == false)
-    {
-        error_handler();
-    }
-
-    /* Transmit operational mode. */
-    usart_tx(handle, (uint8_t *)data, sizeof(data), 1000);
-
-    /* Transmit angle (expected). */
-    memset(data, 0, TX_BUFF_MAX);
-    sprintf(data, "Position (degrees): %d\r\n", servo_get_angle_expected());
-    usart_tx(handle, (uint8_t *)data, sizeof(data), 1000);
+                                 &task_handle_lcd_ctrl);
+    freertos_wrapper_task_create(task_ilc,
+                                 "task_ilc",
+                                 TASK_STACK_SIZE__TASK_ILC,
+                                 (void *)0,
+                                 TASK_PRIORITY__TASK_ILC,
+                                 &task_handle_ilc);
 }
 
 /*============================================================================*/
\ No newline at end of file
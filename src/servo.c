@@ -5,40 +5,181 @@
  ******************************************************************************/
 
 #include "servo.h"
-#include "timer.h"
-
-static uint8_t _angle_expected; 
-// @todo: add when implementing controller: static uint8_t _angle_actual;
+#include "adc.h"
+#include "gpio.h"
 
 /*===== Defines & Macros =====================================================*/
 
 /* PWM pulse-widths to achieve certain positions given a 20 ms period signal. */
-#define SERVO_PWM_PERIOD_IN_MS                     20  /* 20 ms PWM period. */
-#define SERVO_PWM_PULSE_WIDTH_FOR_NEG_90_DEG_IN_MS 0.5 /* 0.5 ms pulse-width = -90 Deg. */
-#define SERVO_PWM_PULSE_WIDTH_FOR_0_DEG_IN_MS      1.5 /* 1.5 ms pulse-width =   0 Deg. */
-#define SERVO_PWM_PULSE_WIDTH_FOR_POS_90_DEG_IN_MS 2.5 /* 2.5 ms pulse-width = +90 Deg. */
+#define SERVO_PWM_PERIOD_IN_NS                     20000000 /* 20 ms PWM period. */
+#define SERVO_PWM_PULSE_WIDTH_FOR_NEG_90_DEG_IN_NS 500000   /* 0.5 ms pulse-width = -90 Deg. */
+#define SERVO_PWM_PULSE_WIDTH_FOR_0_DEG_IN_NS      1500000  /* 1.5 ms pulse-width =   0 Deg. */
+#define SERVO_PWM_PULSE_WIDTH_FOR_POS_90_DEG_IN_NS 2500000  /* 2.5 ms pulse-width = +90 Deg. */
+
+/* Nominal position feedback calibration: raw ADC values at 0/180 degrees. */
+#define SERVO_FB_RAW_AT_0_DEG                      ((ADC_RESULT_MAX * 1) / 10)
+#define SERVO_FB_RAW_AT_180_DEG                    ((ADC_RESULT_MAX * 9) / 10)
+
+/**
+ * Position feedback ADC trigger: TIM15 CH2 (no output pin), frame-aligned
+ * with TIM2 (see timer_pwm_sync); all TIM2 channels drive servos.
+ */
+#define SERVO_FB_TRIGGER_TIMER                     TIMER_PWM_ID__TIM15
+#define SERVO_FB_TRIGGER_CHANNEL                   TIM_CHANNEL_2
+#define SERVO_FB_ADC_TRIGGER                       ADC_EXTERNALTRIG_T15_TRGO
+
+/*===== Servo Configuration ==================================================*/
+
+/**
+ * @note: - Edit this array to manage the number/type/config of the servos in
+ *          the system.
+ *        - Concurrently add/remove relevant IDs to/from SERVO_ID_t in @ref
+ *          servo.h to have them be publically available, ensuring the ordering
+ *          matches this array.
+ */
+static const SERVO_CONFIG_t _servos_config[] = {
+    /* SERVO #1. */
+    {
+        TIMER_PWM_ID__TIM2,
+        TIM_CHANNEL_1,
+        GPIO_DEFS__PORT_SERVO_MOTOR_1_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_1_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_1_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_1_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_1_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_1_FB
+    },
+    /* SERVO #2. */
+    {
+        TIMER_PWM_ID__TIM2,
+        TIM_CHANNEL_2,
+        GPIO_DEFS__PORT_SERVO_MOTOR_2_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_2_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_2_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_2_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_2_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_2_FB
+    },
+    /* SERVO #3. */
+    {
+        TIMER_PWM_ID__TIM2,
+        TIM_CHANNEL_3,
+        GPIO_DEFS__PORT_SERVO_MOTOR_3_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_3_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_3_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_3_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_3_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_3_FB
+    },
+    /* SERVO #4. */
+    {
+        TIMER_PWM_ID__TIM2,
+        TIM_CHANNEL_4,
+        GPIO_DEFS__PORT_SERVO_MOTOR_4_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_4_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_4_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_4_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_4_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_4_FB
+    },
+    /* SERVO #5. */
+    {
+        TIMER_PWM_ID__TIM15,
+        TIM_CHANNEL_1,
+        GPIO_DEFS__PORT_SERVO_MOTOR_5_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_5_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_5_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_5_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_5_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_5_FB
+    },
+    /* SERVO #6. */
+    {
+        TIMER_PWM_ID__TIM16,
+        TIM_CHANNEL_1,
+        GPIO_DEFS__PORT_SERVO_MOTOR_6_PWM,
+        GPIO_DEFS__PIN_SERVO_MOTOR_6_PWM,
+        GPIO_DEFS__AF_SERVO_MOTOR_6_PWM,
+        SERVO_POSITION_MIN_DEG_UINT,
+        SERVO_POSITION_MAX_DEG_UINT,
+        GPIO_DEFS__PORT_SERVO_MOTOR_6_FB,
+        GPIO_DEFS__PIN_SERVO_MOTOR_6_FB,
+        GPIO_DEFS__ADC_CH_SERVO_MOTOR_6_FB
+    },
+};
+_Static_assert(NUM_ARRAY_ELS(_servos_config) == SERVO_NUM_SERVOS, "_servos_config does not match SERVO_NUM_SERVOS");
+
+static SERVO_t _servos[SERVO_NUM_SERVOS];
+
+/*===== Position Feedback ====================================================*/
+
+_Static_assert(SERVO_NUM_SERVOS <= ADC_MAX_CHANNELS, "SERVO_NUM_SERVOS exceeds ADC_MAX_CHANNELS");
+_Static_assert(SERVO_NUM_SERVOS <= SERVO_FEEDBACK_MAX_CHANNELS, "SERVO_NUM_SERVOS exceeds SERVO_FEEDBACK_MAX_CHANNELS");
+
+static SERVO_FEEDBACK_t _feedback; /* Channels in SERVO_ID_t order. */
+static volatile uint32_t _fb_timestamp;    /* CPU cycle count at the last sample trigger. */
+static uint32_t _fb_offset_counts;         /* Sample offset in TIM2 counts. */
+static uint32_t _tim2_frame_counts;        /* PWM frame in TIM2 counts. */
+static uint32_t _tim2_cycles_per_count;    /* CPU cycles per TIM2 count. */
+
+/*===== Position Feedback Filter =============================================*/
+
+_Static_assert(ADC_SCANS_PER_BLOCK <= FILTER_MAX_BLOCK_SIZE, "ADC_SCANS_PER_BLOCK exceeds FILTER_MAX_BLOCK_SIZE");
+_Static_assert(ADC_RESULT_MAX <= FILTER_INPUT_MAX, "ADC_RESULT_MAX exceeds FILTER_INPUT_MAX");
 
 /**
- * PWM pulse values for TIMx_CCRx register to set pulse-width / duty-cycle.
- * Note that the values have -1 as the timer counts from 0 to (TIMER_TIM2_PWM_COUNTER - 1).
+ * FIR low-pass (Q1.15, unity DC gain): 8 tap Hamming windowed-sinc, cut-off
+ * 0.1 x the sample rate (i.e. 5 Hz at one sample per PWM frame).
  */
-#define SERVO_PWM_PULSE_VALUE_MIN \
-    (((SERVO_PWM_PULSE_WIDTH_FOR_NEG_90_DEG_IN_MS / SERVO_PWM_PERIOD_IN_MS) * \
-    TIMER_TIM2_PWM_COUNTER) - 1)
-#define SERVO_PWM_PULSE_VALUE_MAX \
-    (((SERVO_PWM_PULSE_WIDTH_FOR_POS_90_DEG_IN_MS / SERVO_PWM_PERIOD_IN_MS) * \
-    TIMER_TIM2_PWM_COUNTER) - 1)
+static const q15_t _fb_fir_lowpass[] = {287, 1571, 5375, 9151, 9151, 5375, 1571, 287};
+
+static FILTER_t _fb_filters[SERVO_NUM_SERVOS];
+static FILTER_TYPE_t _fb_filter_type;
+static SERVO_FB_STATS_t _fb_stats;
+
+/*===== PWM Frame Updates ====================================================*/
+
+static volatile bool _frame_staged; /* New pulses staged since the last frame boundary. */
+static SERVO_FRAME_STATS_t _frame_stats;
+
+#if (TIMER_PWM_DMA_BURST == 1)
+/* Per-frame pulse values (TIMx_CCR1..TIMx_CCR4) written by DMA burst at each frame boundary. */
+static uint32_t _frame_pulses[TIMER_PWM_ID__TIM16 + 1][TIMER_PWM_DMA_BURST_MAX_CHANNELS];
+#endif
+
+/*===== Angle to PWM Pulse Lookup Tables =====================================*/
 
 /**
- * Linear equation to convert an angle (0 to 180 deg) into a PWM pulse value:
- *     Val = (((pulse_max - pulse_min)/(angle_max - angle_min)) * angle) + pulse_min
+ * Default angle to PWM pulse value LUTs (TIMx_CCRx register values), generated
+ * at compile-time from the nominal pulse-widths above and stored in flash;
+ * one per PWM timer resolution.
  */
-#define SERVO_ANGLE_TO_PULSE_VALUE(a) \
-    ((((SERVO_PWM_PULSE_VALUE_MAX - SERVO_PWM_PULSE_VALUE_MIN)/(SERVO_POSITION_MAX_DEG_UINT - \
-    SERVO_POSITION_MIN_DEG_UINT)) * (float)a) + SERVO_PWM_PULSE_VALUE_MIN)
+static const SERVO_LUT_t _lut_default_tim2 = SERVO_LUT_INITIALISER(SERVO_PWM_PULSE_WIDTH_FOR_NEG_90_DEG_IN_NS,
+                                                                   SERVO_PWM_PULSE_WIDTH_FOR_0_DEG_IN_NS,
+                                                                   SERVO_PWM_PULSE_WIDTH_FOR_POS_90_DEG_IN_NS,
+                                                                   SERVO_PWM_PERIOD_IN_NS,
+                                                                   TIMER_TIM2_PWM_COUNTER);
+static const SERVO_LUT_t _lut_default_tim15_16 = SERVO_LUT_INITIALISER(SERVO_PWM_PULSE_WIDTH_FOR_NEG_90_DEG_IN_NS,
+                                                                       SERVO_PWM_PULSE_WIDTH_FOR_0_DEG_IN_NS,
+                                                                       SERVO_PWM_PULSE_WIDTH_FOR_POS_90_DEG_IN_NS,
+                                                                       SERVO_PWM_PERIOD_IN_NS,
+                                                                       TIMER_TIM15_16_PWM_COUNTER);
 
 /*===== Private Function Prototypes ==========================================*/
-static void record_angle_expected(uint8_t angle);
+static const SERVO_LUT_t *get_lut_default(const SERVO_t *servo);
+static void record_angle_expected(SERVO_t *servo, SERVO_ANGLE_Q16_t angle);
+static void update_hold_all(bool hold);
+static bool feedback_filter_init(FILTER_TYPE_t type);
 
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
@@ -46,57 +187,313 @@ static void record_angle_expected(uint8_t angle);
 
 void servo_init(void)
 {
-    timer_tim2_pwm_init();
+    bool timer_initialised[TIMER_PWM_ID__TIM16 + 1] = {false};
+    uint32_t fb_channels[SERVO_NUM_SERVOS];
+#if (TIMER_PWM_DMA_BURST == 1)
+    uint32_t burst_channels[TIMER_PWM_ID__TIM16 + 1] = {0};
+#endif
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_t *servo = &_servos[i];
+        const SERVO_CONFIG_t *config = &_servos_config[i];
+
+        /* PWM timer (once per timer), channel, and GPIO. */
+        if (timer_initialised[config->timer] == false)
+        {
+            timer_pwm_init(config->timer);
+            timer_initialised[config->timer] = true;
+        }
+        timer_pwm_channel_init(config->timer, config->channel);
+        gpio_init_af_pin(config->port, config->pin, config->alternate);
+        gpio_init_analog_pin(config->fb_port, config->fb_pin);
+        fb_channels[i] = config->fb_channel;
+
+        /* Servo object. */
+        servo->config = config;
+#if (TIMER_PWM_DMA_BURST == 1)
+        uint32_t channel_index = config->channel / (TIM_CHANNEL_2 - TIM_CHANNEL_1);
+        servo->ccr = &_frame_pulses[config->timer][channel_index];
+        burst_channels[config->timer] = LIMIT_VAR_MIN(channel_index + 1, burst_channels[config->timer]);
+#else
+        servo->ccr = timer_pwm_get_ccr(config->timer, config->channel);
+#endif
+        servo->frame_counts = timer_pwm_get_counter(config->timer);
+        servo->angle_min = SERVO_ANGLE_DEG_TO_Q16(config->angle_min);
+        servo->angle_max = SERVO_ANGLE_DEG_TO_Q16(config->angle_max);
+        servo->lut = get_lut_default(servo);
+        record_angle_expected(servo, servo->angle_min);
+    }
+
+#if (TIMER_PWM_DMA_BURST == 1)
+    /* One DMA burst per timer covering its channels (CCR1..CCRn). */
+    for (TIMER_PWM_ID_t id = TIMER_PWM_ID__TIM2; id <= TIMER_PWM_ID__TIM16; id++)
+    {
+        if (burst_channels[id] > 0)
+        {
+            timer_pwm_dma_burst_start(id, _frame_pulses[id], burst_channels[id]);
+        }
+    }
+#endif
+
+    /* Position feedback (nominal calibration) and acquisition. */
+    servo_feedback_init(&_feedback, SERVO_NUM_SERVOS);
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        servo_feedback_set_calibration(&_feedback, i, SERVO_FB_RAW_AT_0_DEG, SERVO_FB_RAW_AT_180_DEG);
+    }
+    feedback_filter_init(SERVO_FB_FILTER_DEFAULT);
+    _tim2_frame_counts = timer_pwm_get_counter(TIMER_PWM_ID__TIM2);
+    _tim2_cycles_per_count = SystemCoreClock / (SERVO_PWM_FRAME_RATE_HZ * _tim2_frame_counts);
+    _fb_offset_counts = (uint32_t)(((uint64_t)SERVO_FB_SAMPLE_OFFSET_US * _tim2_frame_counts * SERVO_PWM_FRAME_RATE_HZ) / 1000000);
+    timer_pwm_trigger_init(SERVO_FB_TRIGGER_TIMER,
+                           SERVO_FB_TRIGGER_CHANNEL,
+                           (uint32_t)(((uint64_t)SERVO_FB_SAMPLE_OFFSET_US * timer_pwm_get_counter(SERVO_FB_TRIGGER_TIMER) * SERVO_PWM_FRAME_RATE_HZ) / 1000000));
+    adc_init(fb_channels, SERVO_NUM_SERVOS, SERVO_FB_ADC_TRIGGER);
+    adc_enable(true);
+}
+
+void servo_set_signal(SERVO_ID_t id, bool state)
+{
+    timer_pwm_enable(_servos[id].config->timer, _servos[id].config->channel, state);
 }
 
-void servo_set_signal(bool state)
+void servo_set_signal_all(bool state)
 {
-    timer_tim2_pwm_enable(state);
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        servo_set_signal(i, state);
+    }
+
+    /* Align the frames of all PWM timers; TIM2 then marks the frame boundary. */
+    if (state)
+    {
+        timer_pwm_sync();
+    }
+    timer_tim2_frame_it_enable(state);
 }
 
-void servo_set_position(uint8_t angle)
+void servo_set_position(SERVO_ID_t id, uint8_t angle)
 {
     angle = LIMIT_VAR_MAX(SERVO_POSITION_MAX_DEG_UINT, angle);
-    record_angle_expected(angle);
-    uint32_t pulse = SERVO_ANGLE_TO_PULSE_VALUE(angle);
-    timer_tim2_pwm_set_pulse(pulse);
+    servo_set_position_q16(id, SERVO_ANGLE_DEG_TO_Q16(angle));
+}
+
+void servo_set_position_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t angle)
+{
+    SERVO_t *servo = &_servos[id];
+    angle = LIMIT_VAR_RANGE(servo->angle_min, servo->angle_max, angle);
+    record_angle_expected(servo, angle);
 }
 
-uint8_t servo_get_angle_expected(void)
+void servo_set_pwm_angle(SERVO_ID_t id, float angle)
 {
-    return _angle_expected;
+    angle = LIMIT_VAR_RANGE((float)SERVO_POSITION_MIN_DEG_UINT, (float)SERVO_POSITION_MAX_DEG_UINT, angle);
+    servo_set_pwm_angle_q16(id, SERVO_ANGLE_DEG_TO_Q16(angle));
 }
 
-void servo_test_oscillate(uint8_t angle_start, uint8_t angle_end, bool reset)
+void servo_set_pwm_angle_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t angle)
 {
-    angle_end = LIMIT_VAR_MAX(SERVO_POSITION_MAX_DEG_UINT, angle_end);
+    SERVO_t *servo = &_servos[id];
+    *servo->ccr = servo_lut_angle_to_pulse(servo->lut, angle);
+    _frame_staged = true;
+}
 
-    static uint8_t i = 0;
-    static bool clockwise = true;
+bool servo_set_pwm_angles_q16(const SERVO_ANGLE_Q16_t angles[SERVO_NUM_SERVOS])
+{
+    uint32_t pulses[SERVO_NUM_SERVOS];
 
-    if (reset)
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
     {
-        i = 0;
-        clockwise = true;
-        return;
+        pulses[i] = servo_lut_angle_to_pulse(_servos[i].lut, angles[i]);
     }
 
-    servo_set_position(i);
+    /**
+     * Write all channels back-to-back (preload registers, or the DMA burst
+     * frames) with the update events held such that they are latched at the
+     * same frame boundary.
+     */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t cycles_start = CYCLE_COUNTER_GET();
+    update_hold_all(true);
+    uint32_t count_start = timer_pwm_get_count(TIMER_PWM_ID__TIM2);
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        *_servos[i].ccr = pulses[i];
+    }
+    uint32_t count_end = timer_pwm_get_count(TIMER_PWM_ID__TIM2);
+    update_hold_all(false);
 
-    if (clockwise)
+    /**
+     * The frame boundary passed during the hold: its update event (latch and
+     * frame interrupt) was suppressed, the frame itself ran on. The pulses
+     * stay staged for the next boundary rather than restarting the frames
+     * (an update generation would shift the PWM phase and the feedback
+     * sample instant); the boundary is counted here as a frame without new
+     * pulses.
+     */
+    bool on_time = (count_end >= count_start);
+    if (on_time == false)
     {
-        if (++i >= angle_end)
-        {
-            clockwise = false;
-        }
+        _frame_stats.late_count++;
+        _frame_stats.missed_count++;
+        _frame_stats.frame_count++;
+    }
+    _frame_staged = true;
+    _frame_stats.write_cycles_last = CYCLE_COUNTER_GET() - cycles_start;
+    _frame_stats.write_cycles_max = LIMIT_VAR_MIN(_frame_stats.write_cycles_last, _frame_stats.write_cycles_max);
+    __set_PRIMASK(primask);
+
+    return on_time;
+}
+
+void servo_frame_update(void)
+{
+    if (_frame_staged == false)
+    {
+        _frame_stats.missed_count++;
+    }
+    _frame_staged = false;
+    _frame_stats.frame_count++;
+}
+
+void servo_get_frame_stats(SERVO_FRAME_STATS_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _frame_stats;
+    taskEXIT_CRITICAL();
+}
+
+void servo_reset_frame_stats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&_frame_stats, 0, sizeof(_frame_stats));
+    taskEXIT_CRITICAL();
+}
+
+bool servo_set_calibration(SERVO_ID_t id, const SERVO_CAL_POINT_t *points, uint32_t num_points)
+{
+    SERVO_t *servo = &_servos[id];
+
+    /* Revert to the default LUT (also whilst the calibrated LUT is rebuilt). */
+    servo->lut = get_lut_default(servo);
+    if (points == NULL)
+    {
+        return true;
     }
-    else
+
+    if (servo_lut_build(&servo->lut_calibrated, points, num_points, SERVO_PWM_PERIOD_IN_NS, servo->frame_counts) == false)
     {
-        if (--i <= angle_start)
-        {
-            clockwise = true;
-        }
+        return false;
     }
+    servo->lut = &servo->lut_calibrated;
+    return true;
+}
+
+bool servo_set_feedback_calibration(SERVO_ID_t id, uint16_t raw_at_0, uint16_t raw_at_180)
+{
+    return servo_feedback_set_calibration(&_feedback, id, raw_at_0, raw_at_180);
+}
+
+void servo_process_feedback(const uint16_t *samples, uint32_t num_scans)
+{
+    /* Timestamp the trigger: back from now by the time elapsed since the offset. */
+    uint32_t cycles = CYCLE_COUNTER_GET();
+    uint32_t count = timer_pwm_get_count(TIMER_PWM_ID__TIM2);
+    uint32_t elapsed = (count + _tim2_frame_counts - _fb_offset_counts) % _tim2_frame_counts;
+    uint16_t filtered[ADC_SCANS_PER_BLOCK * SERVO_NUM_SERVOS];
+    bool settled = true;
+
+    num_scans = LIMIT_VAR_MAX(ADC_SCANS_PER_BLOCK, num_scans);
+
+    /* Filter each servo's samples (one channel of the interleaved block) as one block. */
+    uint32_t filter_cycles_start = CYCLE_COUNTER_GET();
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        filter_process(&_fb_filters[i], &samples[i], &filtered[i], SERVO_NUM_SERVOS, num_scans);
+        settled &= filter_is_settled(&_fb_filters[i]);
+    }
+    _fb_stats.filter_cycles_last = CYCLE_COUNTER_GET() - filter_cycles_start;
+    _fb_stats.filter_cycles_max = LIMIT_VAR_MIN(_fb_stats.filter_cycles_last, _fb_stats.filter_cycles_max);
+    _fb_stats.samples_per_block = num_scans * SERVO_NUM_SERVOS;
+    _fb_stats.block_count++;
+
+    if (settled)
+    {
+        servo_feedback_process(&_feedback, filtered, num_scans);
+        _fb_timestamp = cycles - (elapsed * _tim2_cycles_per_count);
+    }
+}
+
+bool servo_set_feedback_filter(FILTER_TYPE_t type)
+{
+    bool result;
+
+    /* Masks the ADC DMA interrupt (see ADC_DMA_IRQ_PRIORITY) whilst the filters are re-initialised. */
+    taskENTER_CRITICAL();
+    result = feedback_filter_init(type);
+    memset(&_fb_stats, 0, sizeof(_fb_stats));
+    taskEXIT_CRITICAL();
+
+    return result;
+}
+
+FILTER_TYPE_t servo_get_feedback_filter(void)
+{
+    return _fb_filter_type;
+}
+
+void servo_get_feedback_stats(SERVO_FB_STATS_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _fb_stats;
+    taskEXIT_CRITICAL();
+}
+
+void servo_reset_feedback_stats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&_fb_stats, 0, sizeof(_fb_stats));
+    taskEXIT_CRITICAL();
+}
+
+uint32_t servo_get_feedback_timestamp(void)
+{
+    return _fb_timestamp;
+}
+
+void servo_get_limits_q16(SERVO_ID_t id, SERVO_ANGLE_Q16_t *angle_min, SERVO_ANGLE_Q16_t *angle_max)
+{
+    *angle_min = _servos[id].angle_min;
+    *angle_max = _servos[id].angle_max;
+}
+
+uint8_t servo_get_angle_expected(SERVO_ID_t id)
+{
+    /* Round to the nearest degree. */
+    return (uint8_t)((_servos[id].angle_expected + (SERVO_ANGLE_Q16_ONE / 2)) >> SERVO_ANGLE_Q16_FRAC_BITS);
+}
+
+SERVO_ANGLE_Q16_t servo_get_angle_expected_q16(SERVO_ID_t id)
+{
+    return _servos[id].angle_expected;
+}
+
+uint8_t servo_get_angle_actual(SERVO_ID_t id)
+{
+    /* Round to the nearest degree. */
+    return (uint8_t)((servo_get_angle_actual_q16(id) + (SERVO_ANGLE_Q16_ONE / 2)) >> SERVO_ANGLE_Q16_FRAC_BITS);
+}
+
+SERVO_ANGLE_Q16_t servo_get_angle_actual_q16(SERVO_ID_t id)
+{
+    return servo_feedback_get_angle_q16(&_feedback, id);
+}
+
+bool servo_get_feedback_valid(SERVO_ID_t id)
+{
+    return servo_feedback_is_valid(&_feedback, id);
 }
 
 /*============================================================================*/
@@ -104,15 +501,98 @@ void servo_test_oscillate(uint8_t angle_start, uint8_t angle_end, bool reset)
 /*============================================================================*/
 
 /**
- * @brief  Record the *expected* servo motor shaft position (angle in degrees) 
+ * @brief  Retrieve the default (nominal calibration) LUT for a servo's PWM
+ *         timer resolution.
+ * @param  servo: Servo object.
+ * @retval LUT pointer.
+ */
+static const SERVO_LUT_t *get_lut_default(const SERVO_t *servo)
+{
+    return (servo->config->timer == TIMER_PWM_ID__TIM2) ? &_lut_default_tim2 : &_lut_default_tim15_16;
+}
+
+/**
+ * @brief  Record the *expected* servo motor shaft position (angle in degrees)
  *         such that external sources can retrieve this value by calling
  *         servo_get_angle_expected.
- * @param  angle: Angle in degrees (0..180).
+ * @param  servo: Servo object.
+ * @param  angle: Angle in degrees (0..180), Q16.16 fixed-point.
+ * @retval None.
+ */
+static void record_angle_expected(SERVO_t *servo, SERVO_ANGLE_Q16_t angle)
+{
+    servo->angle_expected = angle;
+}
+
+/**
+ * @brief  Hold/release the update events of all PWM timers (see
+ *         timer_pwm_update_hold).
+ * @param  hold: true|false = hold|release.
  * @retval None.
  */
-static void record_angle_expected(uint8_t angle)
+static void update_hold_all(bool hold)
 {
-    _angle_expected = angle;
+    for (TIMER_PWM_ID_t id = TIMER_PWM_ID__TIM2; id <= TIMER_PWM_ID__TIM16; id++)
+    {
+        timer_pwm_update_hold(id, hold);
+    }
+}
+
+/**
+ * @brief  Initialise all servos' position feedback filters for a kernel:
+ *             - Biquads: a SERVO_FB_LOWPASS_HZ low-pass stage and, when
+ *               SERVO_FB_NOTCH_HZ is non-zero, a notch stage.
+ *             - FIR: the fixed low-pass (_fb_fir_lowpass).
+ * @param  type: Filter kernel; see @ref FILTER_TYPE_t.
+ * @retval Boolean indicating whether the filters were initialised; the
+ *         filters are pass-through if not.
+ */
+static bool feedback_filter_init(FILTER_TYPE_t type)
+{
+    float32_t coeffs[FILTER_BIQUAD_NUM_COEFFS * FILTER_BIQUAD_MAX_STAGES];
+    uint32_t num_stages = 1;
+    bool result = true;
+
+    filter_design_lowpass(&coeffs[0], SERVO_FB_SAMPLE_RATE_HZ, SERVO_FB_LOWPASS_HZ, SERVO_FB_LOWPASS_Q);
+    if (SERVO_FB_NOTCH_HZ > 0.0f)
+    {
+        filter_design_notch(&coeffs[FILTER_BIQUAD_NUM_COEFFS], SERVO_FB_SAMPLE_RATE_HZ, SERVO_FB_NOTCH_HZ, SERVO_FB_NOTCH_Q);
+        num_stages++;
+    }
+
+    for (uint32_t i = 0; (i < SERVO_NUM_SERVOS) && result; i++)
+    {
+        switch (type)
+        {
+            case FILTER_TYPE__NONE:
+                filter_init_none(&_fb_filters[i]);
+                break;
+            case FILTER_TYPE__BIQUAD_F32:
+                result = filter_init_biquad_f32(&_fb_filters[i], coeffs, num_stages);
+                break;
+            case FILTER_TYPE__BIQUAD_Q31:
+                result = filter_init_biquad_q31(&_fb_filters[i], coeffs, num_stages);
+                break;
+            case FILTER_TYPE__FIR_Q15:
+                result = filter_init_fir_q15(&_fb_filters[i], _fb_fir_lowpass, NUM_ARRAY_ELS(_fb_fir_lowpass));
+                break;
+            default:
+                result = false;
+                break;
+        }
+    }
+
+    if (result == false)
+    {
+        type = FILTER_TYPE__NONE;
+        for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+        {
+            filter_init_none(&_fb_filters[i]);
+        }
+    }
+    _fb_filter_type = type;
+
+    return result;
 }
 
 /*============================================================================*/
\ No newline at end of file
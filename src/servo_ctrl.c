@@ -0,0 +1,1762 @@
+/*******************************************************************************
+ * @file   servo_ctrl.c
+ * @brief  Servo motor closed-loop control source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "servo_ctrl.h"
+#include "adc.h"
+#include "op_mode.h"
+#include "pid.h"
+#include "timer.h"
+
+/* The adaptive feedforward's blocks span whole ADC DMA blocks (see SERVO_CTRL_LMS_MU). */
+#if ((LMS_FF_BLOCK_SIZE % ADC_SCANS_PER_BLOCK) != 0)
+#error "LMS_FF_BLOCK_SIZE must be a multiple of ADC_SCANS_PER_BLOCK."
+#endif
+
+static PID_t _pid[SERVO_NUM_SERVOS];
+static SERVO_CTRL_STATS_t _stats;
+static uint32_t _loop_start_prev; /* Cycle count at the start of the previous loop. */
+static float _command_last[SERVO_NUM_SERVOS];      /* Command of the last loop (degrees). */
+static bool _command_last_valid[SERVO_NUM_SERVOS];
+static float _command_latched[SERVO_NUM_SERVOS];   /* Command latched at the last frame boundary (degrees; slew limit). */
+static bool _command_latched_valid[SERVO_NUM_SERVOS];
+
+/*===== Cascaded Control =====================================================*/
+
+static volatile SERVO_CTRL_LOOP_TYPE_t _loop_type = SERVO_CTRL_LOOP_TYPE_DEFAULT;
+static PID_t _pid_pos[SERVO_NUM_SERVOS];        /* Outer position loop. */
+static PID_t _pid_vel[SERVO_NUM_SERVOS];        /* Inner velocity loop. */
+static float _vel_correction[SERVO_NUM_SERVOS]; /* Outer loop output, held between its updates (degrees/s). */
+static uint32_t _pos_loop_count;                /* Loop iterations until the next outer loop update. */
+
+/*===== Model Predictive Control =============================================*/
+
+static MPC_t _mpc;                               /* Shared: all servos have the same model. */
+static bool _mpc_ready;                          /* Initialised; else the PID runs in its place. */
+static MPC_STATE_t _mpc_state[SERVO_NUM_SERVOS];
+static float _mpc_command[SERVO_NUM_SERVOS];     /* Held between solves (degrees). */
+static bool _mpc_valid[SERVO_NUM_SERVOS];        /* State and command initialised since the last reset. */
+
+/*===== Gain Scheduling ======================================================*/
+
+static GAIN_SCHED_t _gain_sched;
+static volatile bool _gain_sched_enabled;
+static bool _gain_sched_applied;                                  /* Scheduled gains applied by the last loop. */
+static float _sched_scale[SERVO_NUM_SERVOS][GAIN_SCHED_PARAM__NUM]; /* Smoothed scale factors. */
+static float _pid_base[SERVO_NUM_SERVOS][3];                      /* Base PID gains (kp, ki, kd): configured or auto-tuned. */
+static float _load[SERVO_NUM_SERVOS];                             /* Load term (degrees). */
+
+/*===== Auto-Tuning ==========================================================*/
+
+static AUTOTUNE_t _autotune[SERVO_NUM_SERVOS];
+
+/*===== System Identification ================================================*/
+
+static SYSID_t _sysid SRAM2;          /* One servo at a time (capture buffers); cleared at initialisation. */
+static volatile SERVO_ID_t _sysid_id;
+static float _sysid_excitation;       /* Held between feedback samples (degrees). */
+
+/*===== Iterative Learning Control ===========================================*/
+
+static ILC_t _ilc[SERVO_NUM_SERVOS];
+static ILC_TABLES_t _ilc_tables[SERVO_NUM_SERVOS] SRAM2;      /* Cleared by ilc_init/ilc_start. */
+static bool _ilc_ready;
+static volatile uint32_t _ilc_moves_per_cycle[SERVO_NUM_SERVOS]; /* Running; 0 = stopped. */
+static uint32_t _ilc_moves_ref[SERVO_NUM_SERVOS];              /* Moves started at the last cycle boundary. */
+static volatile uint32_t _ilc_request[SERVO_NUM_SERVOS];       /* Moves per cycle requested (see servo_ctrl_ilc_process). */
+static volatile bool _ilc_request_pending[SERVO_NUM_SERVOS];
+
+/*===== Friction Compensation ================================================*/
+
+static FRICTION_t _friction[SERVO_NUM_SERVOS];
+static volatile bool _friction_enabled[SERVO_NUM_SERVOS];
+static FRICTION_ID_t _friction_id;            /* One servo at a time. */
+static volatile SERVO_ID_t _friction_id_servo;
+static float _friction_excitation;            /* Held between feedback samples (degrees). */
+
+/*===== Adaptive Feedforward =================================================*/
+
+static LMS_FF_t _lms[SERVO_NUM_SERVOS];
+static bool _lms_ready;
+static volatile bool _lms_enabled[SERVO_NUM_SERVOS];
+static volatile bool _lms_clear_pending[SERVO_NUM_SERVOS]; /* Applied by servo_ctrl_lms_process. */
+static float _lms_output[SERVO_NUM_SERVOS];                /* Held between updates (degrees). */
+
+/*===== Motion Profiles ======================================================*/
+
+static PROFILE_GEN_t _profile[SERVO_NUM_SERVOS];
+static volatile bool _coord_lockstep; /* Queued moves, if any, all coordinated (see servo_ctrl_move_coordinated). */
+
+/*===== Input Shaping ========================================================*/
+
+static SHAPER_t _shaper[SERVO_NUM_SERVOS];
+static float _shaper_state[SERVO_NUM_SERVOS][SERVO_CTRL_SHAPER_MAX_DELAY + 1]; /* Delay lines. */
+static float _shaped_prev[SERVO_NUM_SERVOS];   /* Shaped setpoint of the last loop (degrees). */
+static float _shaped_vel_prev[SERVO_NUM_SERVOS]; /* Its rate (degrees/s). */
+
+/*===== Setpoint Stream ======================================================*/
+
+static STREAM_t _stream;
+static bool _streaming; /* Stream output written to the setpoints by the last loop. */
+
+/*===== Inverse Kinematics ===================================================*/
+
+static IK_t _ik;
+static volatile bool _ik_enabled; /* Cartesian setpoint stream. */
+
+/*===== State Estimation =====================================================*/
+
+static ESTIMATOR_t _est[SERVO_NUM_SERVOS];
+static SERVO_CTRL_STATE_t _state[SERVO_NUM_SERVOS]; /* Published estimates. */
+static volatile bool _state_valid[SERVO_NUM_SERVOS];
+static uint32_t _est_fb_timestamp;                  /* Timestamp of the last feedback sample corrected with. */
+static SERVO_ANGLE_Q16_t _setpoint_prev[SERVO_NUM_SERVOS];
+static volatile uint32_t _motion_hold[SERVO_NUM_SERVOS]; /* Loops until a servo is no longer moving. */
+
+/*===== PWM Frame Phase-Lock =================================================*/
+
+static volatile bool _start_pending; /* Start the time base at the next frame boundary. */
+static volatile bool _running;
+static uint32_t _loops_in_frame;     /* Loop executions since the last frame boundary. */
+static uint32_t _fb_timestamp;       /* Timestamp of the feedback used by the last loop (CPU cycles). */
+static bool _fb_used;                /* Feedback used since the last frame boundary. */
+static bool _fb_sampled;             /* New feedback sample since the last frame boundary. */
+
+/*===== Motor Health =========================================================*/
+
+static MOTOR_HEALTH_t _health[SERVO_NUM_SERVOS];
+static SERVO_CTRL_FAULT_t _fault[SERVO_NUM_SERVOS]; /* Latched until the control loop is restarted. */
+static volatile bool _faulted;                      /* A fault is latched (any servo). */
+
+/*===== Private Function Prototypes ==========================================*/
+static void clear_stats(void);
+static void record_stats(uint32_t start, uint32_t end, float error, bool feedback_valid);
+static void update_motion(SERVO_ID_t id, SERVO_ANGLE_Q16_t setpoint);
+static void reset_controllers(void);
+static void apply_gains(SERVO_ID_t id);
+static float cascade_update(SERVO_ID_t id, float setpoint, float feedback, float ff_vel, float ff_acc, bool pos_update,
+                            float command_min, float command_max);
+static float mpc_update(SERVO_ID_t id, float setpoint, float feedback, bool solve, float command_min, float command_max);
+static void fault_stop(SERVO_ID_t id, MOTOR_FAULT_t fault, uint32_t loop_start);
+static float ilc_step(SERVO_ID_t id, float setpoint);
+static void ilc_abort(SERVO_ID_t id);
+static float friction_step(SERVO_ID_t id, float setpoint, float feedback, float ref_velocity, bool fb_new,
+                           bool *holding);
+static float lms_step(SERVO_ID_t id, float setpoint, bool frame_end);
+static void lms_restart(SERVO_ID_t id);
+static bool move_allowed(SERVO_ID_t id);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void servo_ctrl_init(void)
+{
+    const PID_CONFIG_t config = {
+        .kp = SERVO_CTRL_PID_KP,
+        .ki = SERVO_CTRL_PID_KI,
+        .kd = SERVO_CTRL_PID_KD,
+        .period_s = SERVO_CTRL_LOOP_PERIOD_S,
+        .output_min = SERVO_CTRL_PID_OUTPUT_MIN,
+        .output_max = SERVO_CTRL_PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__RATE,
+    };
+    const PID_CONFIG_t config_pos = {
+        .kp = SERVO_CTRL_POS_KP,
+        .ki = SERVO_CTRL_POS_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / SERVO_CTRL_POS_LOOP_RATE_HZ,
+        .output_min = SERVO_CTRL_POS_VEL_MIN,
+        .output_max = SERVO_CTRL_POS_VEL_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const PID_CONFIG_t config_vel = {
+        .kp = SERVO_CTRL_VEL_KP,
+        .ki = SERVO_CTRL_VEL_KI,
+        .kd = 0.0f,
+        .period_s = SERVO_CTRL_LOOP_PERIOD_S,
+        .output_min = SERVO_CTRL_VEL_OUTPUT_MIN,
+        .output_max = SERVO_CTRL_VEL_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const MPC_CONFIG_t mpc_config = {
+        .period_s = 1.0f / SERVO_PWM_FRAME_RATE_HZ,
+        .wn = 2.0f * PI * SERVO_CTRL_MPC_WN_HZ,
+        .zeta = SERVO_CTRL_MPC_ZETA,
+        .q = SERVO_CTRL_MPC_Q,
+        .r = SERVO_CTRL_MPC_R,
+        .s = SERVO_CTRL_MPC_S,
+        .l_pos = SERVO_CTRL_MPC_L_POS,
+        .l_vel = SERVO_CTRL_MPC_L_VEL,
+        .l_dist = SERVO_CTRL_MPC_L_DIST,
+    };
+    const MOTOR_HEALTH_CONFIG_t health_config = {
+        .stall_error = SERVO_CTRL_HEALTH_STALL_ERROR_DEG,
+        .stall_speed = SERVO_CTRL_HEALTH_STALL_SPEED_DEG_S,
+        .stall_travel = SERVO_CTRL_HEALTH_STALL_TRAVEL_DEG,
+        .stall_periods = SERVO_CTRL_HEALTH_STALL_PERIODS,
+        .overload_load = SERVO_CTRL_HEALTH_OVERLOAD_DEG,
+        .overload_periods = SERVO_CTRL_HEALTH_OVERLOAD_PERIODS,
+        .fb_loss_periods = SERVO_CTRL_HEALTH_FB_LOSS_PERIODS,
+    };
+    const ILC_CONFIG_t ilc_config = {
+        .decimation = SERVO_CTRL_LOOPS_PER_FRAME,
+        .range = SERVO_CTRL_ILC_RANGE_DEG,
+        .gain = SERVO_CTRL_ILC_GAIN,
+        .lead = SERVO_CTRL_ILC_LEAD,
+        .forget = SERVO_CTRL_ILC_FORGET,
+    };
+    const FRICTION_CONFIG_t friction_config = {
+        .period_s = 1.0f / SERVO_FB_SAMPLE_RATE_HZ,
+        .wn = 2.0f * PI * SERVO_CTRL_MPC_WN_HZ,
+        .zeta = SERVO_CTRL_MPC_ZETA,
+        .l_pos = SERVO_CTRL_FRICTION_L_POS,
+        .l_vel = SERVO_CTRL_FRICTION_L_VEL,
+        .l_dist = SERVO_CTRL_FRICTION_L_DIST,
+        .dist_max = SERVO_CTRL_FRICTION_DIST_MAX_DEG,
+        .slope = SERVO_CTRL_FRICTION_SLOPE,
+        .lead_s = SERVO_CTRL_FRICTION_LEAD_S,
+        .still_speed = SERVO_CTRL_FRICTION_STILL_DEG_S,
+        .hold_band = SERVO_CTRL_FRICTION_HOLD_BAND_DEG,
+    };
+    const LMS_FF_CONFIG_t lms_config = {
+        .kernel = SERVO_CTRL_LMS_KERNEL,
+        .range = SERVO_CTRL_LMS_RANGE_DEG,
+        .mu = SERVO_CTRL_LMS_MU,
+        .energy_min = SERVO_CTRL_LMS_ENERGY_MIN,
+        .leak = SERVO_CTRL_LMS_LEAK,
+        .output_max = SERVO_CTRL_LMS_OUTPUT_MAX_DEG,
+        .lead = SERVO_CTRL_LMS_LEAD,
+    };
+    const IK_CONFIG_t ik_config = {
+        .arm = SERVO_CTRL_IK_ARM,
+        .lengths = {
+            (int32_t)(SERVO_CTRL_IK_LENGTH_1 * SERVO_ANGLE_Q16_ONE),
+            (int32_t)(SERVO_CTRL_IK_LENGTH_2 * SERVO_ANGLE_Q16_ONE),
+            (int32_t)(SERVO_CTRL_IK_LENGTH_3 * SERVO_ANGLE_Q16_ONE),
+        },
+        .elbow_up = SERVO_CTRL_IK_ELBOW_UP,
+    };
+    const ESTIMATOR_CONFIG_t est_config = {
+        .type = SERVO_CTRL_EST_TYPE,
+        .period_s = SERVO_CTRL_LOOP_PERIOD_S,
+        .meas_period_s = 1.0f / SERVO_FB_SAMPLE_RATE_HZ,
+        .alpha = SERVO_CTRL_EST_ALPHA,
+        .beta = SERVO_CTRL_EST_BETA,
+        .gamma = SERVO_CTRL_EST_GAMMA,
+        .process_noise = SERVO_CTRL_EST_PROCESS_NOISE,
+        .meas_noise = SERVO_CTRL_EST_MEAS_NOISE,
+        .init_var_vel = SERVO_CTRL_EST_INIT_VAR_VEL,
+        .init_var_acc = SERVO_CTRL_EST_INIT_VAR_ACC,
+    };
+    /* SRAM2 is not cleared by the start-up code. */
+    memset(&_sysid, 0, sizeof(_sysid));
+    _ilc_ready = true;
+    _lms_ready = true;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pid_init(&_pid[i], &config);
+        pid_init(&_pid_pos[i], &config_pos);
+        pid_init(&_pid_vel[i], &config_vel);
+        estimator_init(&_est[i], &est_config);
+        motor_health_init(&_health[i], &health_config);
+        _pid_base[i][GAIN_SCHED_PARAM__KP] = SERVO_CTRL_PID_KP;
+        _pid_base[i][GAIN_SCHED_PARAM__KI] = SERVO_CTRL_PID_KI;
+        _pid_base[i][GAIN_SCHED_PARAM__KD] = SERVO_CTRL_PID_KD;
+        for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+        {
+            _sched_scale[i][p] = 1.0f;
+        }
+        profile_init(&_profile[i], SERVO_CTRL_LOOP_RATE_HZ, servo_get_angle_expected_q16(i));
+        shaper_init(&_shaper[i], _shaper_state[i], SERVO_CTRL_SHAPER_MAX_DELAY,
+                    SERVO_ANGLE_Q16_TO_FLOAT(servo_get_angle_expected_q16(i)));
+        servo_ctrl_set_shaper(i, SERVO_CTRL_SHAPER_TYPE_DEFAULT, SERVO_CTRL_SHAPER_FREQ_HZ, SERVO_CTRL_SHAPER_ZETA);
+        _ilc_ready &= ilc_init(&_ilc[i], &ilc_config, &_ilc_tables[i]);
+        friction_init(&_friction[i], &friction_config);
+        _lms_ready &= lms_ff_init(&_lms[i], &lms_config);
+    }
+    _mpc_ready = mpc_init(&_mpc, &mpc_config);
+    stream_init(&_stream, SERVO_CTRL_LOOP_RATE_HZ, SERVO_NUM_SERVOS, SERVO_CTRL_STREAM_INTERP);
+    ik_init(&_ik, &ik_config);
+    gain_sched_init(&_gain_sched, (float)SERVO_POSITION_MIN_DEG_UINT, (float)SERVO_POSITION_MAX_DEG_UINT,
+                    SERVO_CTRL_GAIN_SCHED_LOAD_MAX_DEG);
+
+    CYCLE_COUNTER_ENABLE();
+    clear_stats();
+
+    timer_tim6_ctrl_init(SERVO_CTRL_LOOP_RATE_HZ);
+}
+
+void servo_ctrl_enable(bool state)
+{
+    if (state)
+    {
+        taskENTER_CRITICAL();
+        reset_controllers();
+        for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+        {
+            /* Unknown whilst stopped: not slew limited from it. */
+            _command_last_valid[i] = false;
+            _command_latched_valid[i] = false;
+
+            /* The shaped setpoints start from the setpoints (the designs are kept). */
+            float setpoint = SERVO_ANGLE_Q16_TO_FLOAT(servo_get_angle_expected_q16(i));
+            shaper_reset(&_shaper[i], setpoint);
+            _shaped_prev[i] = setpoint;
+            _shaped_vel_prev[i] = 0.0f;
+
+            /* Faults cleared: the PWM signals are on again (see servo_set_signal_all). */
+            motor_health_reset(&_health[i]);
+            memset(&_fault[i], 0, sizeof(_fault[i]));
+        }
+        _faulted = false;
+        taskEXIT_CRITICAL();
+        servo_ctrl_reset_stats();
+        _start_pending = true;
+    }
+    else
+    {
+        _start_pending = false;
+        _running = false;
+        timer_tim6_ctrl_enable(false);
+    }
+}
+
+void servo_ctrl_loop_run(void)
+{
+    uint32_t start = CYCLE_COUNTER_GET();
+    SERVO_ANGLE_Q16_t commands[SERVO_NUM_SERVOS];
+    float error_max = 0.0f; /* Largest magnitude tracking error (signed). */
+    bool feedback_valid = false;
+    uint32_t fb_timestamp = servo_get_feedback_timestamp();
+    float feedback[SERVO_NUM_SERVOS] = {0.0f};
+    bool feedback_ok[SERVO_NUM_SERVOS];
+    float ff_vel[SERVO_NUM_SERVOS] = {0.0f}; /* Profile velocity/acceleration (cascaded controller feedforward). */
+    float ff_acc[SERVO_NUM_SERVOS] = {0.0f};
+
+    /* Setpoint stream: interpolated waypoints, in precedence over the motion profiles. */
+    uint32_t stream_start = CYCLE_COUNTER_GET();
+    SERVO_ANGLE_Q16_t streamed[SERVO_NUM_SERVOS];
+    bool streaming = stream_next(&_stream, streamed);
+
+    /* Inverse kinematics: the streamed Cartesian target to the joints' servo angles. */
+    uint32_t ik_start = CYCLE_COUNTER_GET();
+    if (streaming && _ik_enabled)
+    {
+        int32_t joints[IK_MAX_JOINTS];
+        if (ik_solve(&_ik, streamed, joints) == false)
+        {
+            _stats.ik_unreachable++;
+        }
+        for (uint32_t j = 0; j < ik_get_num_joints(&_ik); j++)
+        {
+            streamed[j] = SERVO_ANGLE_DEG_TO_Q16(SERVO_CTRL_IK_JOINT_ZERO_DEG) + joints[j];
+        }
+    }
+    _stats.ik_cycles_last = CYCLE_COUNTER_GET() - ik_start;
+    _stats.ik_cycles_max = LIMIT_VAR_MIN(_stats.ik_cycles_last, _stats.ik_cycles_max);
+
+    if (streaming)
+    {
+        for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+        {
+            if (_streaming == false)
+            {
+                /* Abort the running moves (and experiments) such that the profiles resume from the stream's end. */
+                profile_reset(&_profile[i], streamed[i]);
+                autotune_abort(&_autotune[i]);
+                sysid_abort(&_sysid);
+                friction_id_abort(&_friction_id);
+                ilc_abort(i);
+            }
+            servo_set_position_q16(i, streamed[i]);
+        }
+    }
+    _streaming = streaming;
+    _stats.stream_cycles_last = CYCLE_COUNTER_GET() - stream_start - _stats.ik_cycles_last;
+    _stats.stream_cycles_max = LIMIT_VAR_MIN(_stats.stream_cycles_last, _stats.stream_cycles_max);
+
+    /* Motion profiles: next setpoint of the running moves. */
+    uint32_t profile_start = CYCLE_COUNTER_GET();
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if ((streaming == false) && profile_is_busy(&_profile[i]))
+        {
+            servo_set_position_q16(i, profile_next(&_profile[i]));
+            ff_vel[i] = profile_get_velocity(&_profile[i]);
+            ff_acc[i] = profile_get_acceleration(&_profile[i]);
+        }
+    }
+    _stats.profile_cycles_last = CYCLE_COUNTER_GET() - profile_start;
+    _stats.profile_cycles_max = LIMIT_VAR_MIN(_stats.profile_cycles_last, _stats.profile_cycles_max);
+
+    /**
+     * Input shaping: between the setpoint sources and the controllers. The
+     * feedforward is then that of the shaped setpoint (its differences).
+     */
+    uint32_t shaper_start = CYCLE_COUNTER_GET();
+    float setpoints[SERVO_NUM_SERVOS];
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        setpoints[i] = shaper_update(&_shaper[i], SERVO_ANGLE_Q16_TO_FLOAT(servo_get_angle_expected_q16(i)));
+        if (_shaper[i].design.type != SHAPER_TYPE__NONE)
+        {
+            ff_vel[i] = (setpoints[i] - _shaped_prev[i]) * SERVO_CTRL_LOOP_RATE_HZ;
+            ff_acc[i] = (ff_vel[i] - _shaped_vel_prev[i]) * SERVO_CTRL_LOOP_RATE_HZ;
+        }
+        _shaped_prev[i] = setpoints[i];
+        _shaped_vel_prev[i] = ff_vel[i];
+    }
+    _stats.shaper_cycles_last = CYCLE_COUNTER_GET() - shaper_start;
+    _stats.shaper_cycles_max = LIMIT_VAR_MIN(_stats.shaper_cycles_last, _stats.shaper_cycles_max);
+
+    /* State estimation: predict every loop, correct with each new feedback sample. */
+    uint32_t est_start = CYCLE_COUNTER_GET();
+    bool fb_new = (fb_timestamp != _est_fb_timestamp);
+    _est_fb_timestamp = fb_timestamp;
+    _fb_sampled |= fb_new;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        feedback_ok[i] = servo_ctrl_get_feedback(i, &feedback[i]);
+        if (feedback_ok[i])
+        {
+            estimator_predict(&_est[i]);
+            if (fb_new || (estimator_is_valid(&_est[i]) == false))
+            {
+                estimator_correct(&_est[i], feedback[i]);
+            }
+            _state[i].position_deg = estimator_get_position(&_est[i]);
+            _state[i].velocity_deg_s = estimator_get_velocity(&_est[i]);
+            _state[i].acceleration_deg_s2 = estimator_get_acceleration(&_est[i]);
+        }
+        else
+        {
+            estimator_reset(&_est[i]);
+        }
+        _state_valid[i] = feedback_ok[i];
+    }
+    _stats.est_cycles_last = CYCLE_COUNTER_GET() - est_start;
+    _stats.est_cycles_max = LIMIT_VAR_MIN(_stats.est_cycles_last, _stats.est_cycles_max);
+
+    /* Gain scheduling: scale the active controller's gains by the table at each servo's position and load. */
+    uint32_t sched_start = CYCLE_COUNTER_GET();
+    bool sched = _gain_sched_enabled;
+    const float sched_alpha = SERVO_CTRL_LOOP_PERIOD_S / (SERVO_CTRL_GAIN_SCHED_TAU_S + SERVO_CTRL_LOOP_PERIOD_S);
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (sched && feedback_ok[i])
+        {
+            float target[GAIN_SCHED_PARAM__NUM];
+            gain_sched_lookup(&_gain_sched, _state[i].position_deg, _load[i], target);
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                _sched_scale[i][p] += sched_alpha * (target[p] - _sched_scale[i][p]);
+            }
+            apply_gains(i);
+        }
+        else if (_gain_sched_applied)
+        {
+            /* Disabled: back to the base gains (the controllers' incremental form is bumpless). */
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                _sched_scale[i][p] = 1.0f;
+            }
+            apply_gains(i);
+        }
+    }
+    _gain_sched_applied = sched;
+    _stats.sched_cycles_last = CYCLE_COUNTER_GET() - sched_start;
+    _stats.sched_cycles_max = LIMIT_VAR_MIN(_stats.sched_cycles_last, _stats.sched_cycles_max);
+
+    uint32_t friction_cycles = 0;
+    uint32_t lms_cycles = 0;
+    bool frame_end = (_loops_in_frame == (SERVO_CTRL_LOOPS_PER_FRAME - 1));
+    bool pos_update = (_pos_loop_count == 0);
+    _pos_loop_count = pos_update ? (SERVO_CTRL_LOOPS_PER_POS_UPDATE - 1) : (_pos_loop_count - 1);
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_ANGLE_Q16_t setpoint_q16 = servo_get_angle_expected_q16(i);
+        float setpoint = setpoints[i];
+        float command = setpoint;
+        bool saturated = false;
+        bool healthy = (_fault[i].fault == MOTOR_FAULT__NONE);
+        bool controlled = false; /* Closed by the controller (not an experiment). */
+
+        /* Command range: the servo's limits, narrowed by the slew limit about the latched command. */
+        SERVO_ANGLE_Q16_t limit_min_q16;
+        SERVO_ANGLE_Q16_t limit_max_q16;
+        servo_get_limits_q16(i, &limit_min_q16, &limit_max_q16);
+        float limit_min = SERVO_ANGLE_Q16_TO_FLOAT(limit_min_q16);
+        float limit_max = SERVO_ANGLE_Q16_TO_FLOAT(limit_max_q16);
+        float command_min = limit_min;
+        float command_max = limit_max;
+        if (_command_latched_valid[i])
+        {
+            const float slew_step = SERVO_CTRL_SLEW_DEG_S / SERVO_PWM_FRAME_RATE_HZ;
+            command_min = LIMIT_VAR_RANGE(limit_min, limit_max, _command_latched[i] - slew_step);
+            command_max = LIMIT_VAR_RANGE(limit_min, limit_max, _command_latched[i] + slew_step);
+        }
+
+        if (healthy && feedback_ok[i] && (i == _sysid_id) && (sysid_get_state(&_sysid) == SYSID_STATE__RUNNING))
+        {
+            /* Open-loop excitation in place of the controller, stepped with each feedback sample. */
+            _mpc_valid[i] = false;
+            ilc_abort(i);
+            friction_reset(&_friction[i]);
+            lms_restart(i);
+            if (fb_new)
+            {
+                _sysid_excitation = sysid_update(&_sysid, feedback[i]);
+                if (sysid_get_state(&_sysid) != SYSID_STATE__RUNNING)
+                {
+                    pid_reset(&_pid[i]);
+                    pid_reset(&_pid_pos[i]);
+                    pid_reset(&_pid_vel[i]);
+                    _vel_correction[i] = 0.0f;
+                }
+            }
+            command += _sysid_excitation;
+        }
+        else if (healthy && feedback_ok[i] && (i == _friction_id_servo) &&
+                 (friction_id_get_state(&_friction_id, NULL) == FRICTION_ID_STATE__RUNNING))
+        {
+            /* Open-loop friction sweep in place of the controller, stepped with each feedback sample. */
+            _mpc_valid[i] = false;
+            ilc_abort(i);
+            friction_reset(&_friction[i]);
+            lms_restart(i);
+            if (fb_new)
+            {
+                FRICTION_PARAMS_t params;
+                _friction_excitation = friction_id_update(&_friction_id, _command_latched[i], feedback[i],
+                                                          _state[i].velocity_deg_s);
+                FRICTION_ID_STATE_t state = friction_id_get_state(&_friction_id, &params);
+                if (state == FRICTION_ID_STATE__DONE)
+                {
+                    friction_set_params(&_friction[i], &params);
+                }
+                if (state != FRICTION_ID_STATE__RUNNING)
+                {
+                    pid_reset(&_pid[i]);
+                    pid_reset(&_pid_pos[i]);
+                    pid_reset(&_pid_vel[i]);
+                    _vel_correction[i] = 0.0f;
+                }
+            }
+            command += _friction_excitation;
+        }
+        else if (healthy && feedback_ok[i] && (autotune_get_state(&_autotune[i]) == AUTOTUNE_STATE__RUNNING))
+        {
+            /* Relay experiment in place of the controller; the tuned gains are loaded when done. */
+            _mpc_valid[i] = false;
+            ilc_abort(i);
+            friction_reset(&_friction[i]);
+            lms_restart(i);
+            command += autotune_update(&_autotune[i], feedback[i]);
+            if (autotune_get_state(&_autotune[i]) == AUTOTUNE_STATE__DONE)
+            {
+                _pid_base[i][GAIN_SCHED_PARAM__KP] = _autotune[i].result.kp;
+                _pid_base[i][GAIN_SCHED_PARAM__KI] = _autotune[i].result.ki;
+                _pid_base[i][GAIN_SCHED_PARAM__KD] = _autotune[i].result.kd;
+                pid_set_gains(&_pid[i], _pid_base[i][GAIN_SCHED_PARAM__KP] * _sched_scale[i][GAIN_SCHED_PARAM__KP],
+                              _pid_base[i][GAIN_SCHED_PARAM__KI] * _sched_scale[i][GAIN_SCHED_PARAM__KI],
+                              _pid_base[i][GAIN_SCHED_PARAM__KD] * _sched_scale[i][GAIN_SCHED_PARAM__KD]);
+                pid_reset(&_pid[i]);
+            }
+        }
+        else if (healthy && feedback_ok[i])
+        {
+            float error = setpoint - feedback[i];
+            if (fabsf(error) > fabsf(error_max))
+            {
+                error_max = error;
+            }
+
+            /* Iterative learning control: the learnt feedforward, with the controller correcting the remainder. */
+            float learnt = ilc_step(i, setpoint);
+
+            /* Friction compensation: within the hold band the controller is given no error to integrate. */
+            uint32_t friction_start = CYCLE_COUNTER_GET();
+            bool holding;
+            float friction = friction_step(i, setpoint, feedback[i], ff_vel[i], fb_new, &holding);
+            float target = holding ? feedback[i] : setpoint;
+            friction_cycles += CYCLE_COUNTER_GET() - friction_start;
+
+            /* Adaptive feedforward: updated with the command latched at the frame's end, and held. */
+            uint32_t lms_start = CYCLE_COUNTER_GET();
+            float adapted = lms_step(i, setpoint, frame_end);
+            lms_cycles += CYCLE_COUNTER_GET() - lms_start;
+
+            float offset = learnt + friction + adapted;
+            command += offset;
+            if (_loop_type == SERVO_CTRL_LOOP_TYPE__CASCADE)
+            {
+                command += cascade_update(i, target, feedback[i], ff_vel[i], ff_acc[i], pos_update,
+                                          command_min - offset, command_max - offset);
+                saturated = pid_is_saturated(&_pid_vel[i]);
+            }
+            else if ((_loop_type == SERVO_CTRL_LOOP_TYPE__MPC) && _mpc_ready)
+            {
+                /* One servo per loop iteration, in the last SERVO_NUM_SERVOS iterations of the frame. */
+                bool solve = (_loops_in_frame == (SERVO_CTRL_LOOPS_PER_FRAME - SERVO_NUM_SERVOS + i));
+                command += mpc_update(i, setpoint, feedback[i], solve, limit_min, limit_max);
+            }
+            else
+            {
+                pid_set_actuator_limits(&_pid[i], command_min - command, command_max - command);
+                command += pid_update_rate(&_pid[i], target, feedback[i], _state[i].velocity_deg_s);
+                saturated = pid_is_saturated(&_pid[i]);
+            }
+            feedback_valid = true;
+            controlled = true;
+
+            /* Load term: the correction holding the servo against its load (and accelerating it). */
+            _load[i] += (SERVO_CTRL_LOOP_PERIOD_S / (SERVO_CTRL_LOAD_TAU_S + SERVO_CTRL_LOOP_PERIOD_S)) *
+                        (fabsf(command - setpoint - learnt - adapted) - _load[i]);
+            _state[i].load_deg = _load[i];
+        }
+        else
+        {
+            /* Open-loop (or faulted): hold the controllers in reset so they start bumpless. */
+            autotune_abort(&_autotune[i]);
+            ilc_abort(i);
+            if (i == _sysid_id)
+            {
+                sysid_abort(&_sysid);
+            }
+            if (i == _friction_id_servo)
+            {
+                friction_id_abort(&_friction_id);
+            }
+            friction_reset(&_friction[i]);
+            lms_restart(i);
+            pid_reset(&_pid[i]);
+            pid_reset(&_pid_pos[i]);
+            pid_reset(&_pid_vel[i]);
+            _vel_correction[i] = 0.0f;
+            _mpc_valid[i] = false;
+            _load[i] = 0.0f;
+        }
+        update_motion(i, setpoint_q16);
+
+        float requested = command;
+        command = LIMIT_VAR_RANGE(command_min, command_max, command);
+        saturated |= (command != requested);
+        if (saturated)
+        {
+            /* At a stop, else held by the slew limit. */
+            if ((command <= limit_min) || (command >= limit_max))
+            {
+                _stats.sat_loops[i]++;
+            }
+            else
+            {
+                _stats.slew_loops[i]++;
+            }
+        }
+        _command_last[i] = command;
+        _command_last_valid[i] = true;
+        commands[i] = SERVO_ANGLE_DEG_TO_Q16(command);
+
+        /* Motor health: the latched command is the one the motor is following. */
+        if (healthy)
+        {
+            const MOTOR_HEALTH_INPUT_t health_input = {
+                .timestamp = start,
+                .feedback_valid = feedback_ok[i],
+                .feedback_new = fb_new,
+                .controlled = controlled && _command_latched_valid[i],
+                .command = _command_latched[i],
+                .position = feedback[i],
+                .velocity = _state[i].velocity_deg_s,
+                .load = _load[i],
+            };
+            MOTOR_FAULT_t fault = motor_health_update(&_health[i], &health_input);
+            if (fault != MOTOR_FAULT__NONE)
+            {
+                fault_stop(i, fault, start);
+            }
+        }
+    }
+
+    _stats.friction_cycles_last = friction_cycles;
+    _stats.friction_cycles_max = LIMIT_VAR_MIN(_stats.friction_cycles_last, _stats.friction_cycles_max);
+    _stats.lms_cycles_last = lms_cycles;
+    _stats.lms_cycles_max = LIMIT_VAR_MIN(_stats.lms_cycles_last, _stats.lms_cycles_max);
+
+    /**
+     * Write all servos' PWM pulses for the same frame. Written late, a frame
+     * boundary passed without its interrupt: the commands latched there are
+     * unchanged (the pulses latch at the next), and the next loop is the
+     * frame's first.
+     */
+    bool on_time = servo_set_pwm_angles_q16(commands);
+
+    record_stats(start, CYCLE_COUNTER_GET(), error_max, feedback_valid);
+    _loops_in_frame = on_time ? (_loops_in_frame + 1) : 0;
+    if (feedback_valid)
+    {
+        _fb_timestamp = fb_timestamp;
+        _fb_used = true;
+    }
+}
+
+void servo_ctrl_frame_sync(void)
+{
+    if (_start_pending)
+    {
+        /**
+         * Start at the frame boundary with the counter advanced by the lead
+         * time, i.e. the first (and every following) period elapses
+         * SERVO_CTRL_FRAME_LEAD_US before a frame boundary.
+         */
+        _start_pending = false;
+        timer_tim6_ctrl_set_count(SERVO_CTRL_FRAME_LEAD_US * (TIMER_TIM6_CTRL_COUNTER_CLK_HZ / 1000000));
+        timer_tim6_ctrl_enable(true);
+        _running = true;
+    }
+    else if (_running)
+    {
+        if (_loops_in_frame != SERVO_CTRL_LOOPS_PER_FRAME)
+        {
+            _stats.frame_slip_count++;
+        }
+
+        /* Each frame triggers one sample, whichever servos are stopped (e.g. servo 6 on TIM15 faulted). */
+        if (_fb_sampled == false)
+        {
+            _stats.fb_missed_frames++;
+        }
+    }
+    _loops_in_frame = 0;
+    _fb_sampled = false;
+
+    /* The last loop's commands are latched at this frame boundary. */
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        _command_latched[i] = _command_last[i];
+        _command_latched_valid[i] = _command_last_valid[i];
+    }
+
+    /* The outputs latched at this frame boundary were computed from _fb_timestamp's sample. */
+    if (_fb_used)
+    {
+        _stats.fb_latency_cycles_last = CYCLE_COUNTER_GET() - _fb_timestamp;
+        _stats.fb_latency_cycles_max = LIMIT_VAR_MIN(_stats.fb_latency_cycles_last, _stats.fb_latency_cycles_max);
+        _fb_used = false;
+    }
+}
+
+void servo_ctrl_set_loop_type(SERVO_CTRL_LOOP_TYPE_t type)
+{
+    taskENTER_CRITICAL();
+    _loop_type = type;
+    reset_controllers();
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        _lms_clear_pending[i] = true; /* Adapted against the previous controllers. */
+    }
+    taskEXIT_CRITICAL();
+}
+
+SERVO_CTRL_LOOP_TYPE_t servo_ctrl_get_loop_type(void)
+{
+    return _loop_type;
+}
+
+bool servo_ctrl_set_shaper(SERVO_ID_t id, SHAPER_TYPE_t type, float freq_hz, float zeta)
+{
+    const SHAPER_CONFIG_t config = {
+        .type = type,
+        .period_s = SERVO_CTRL_LOOP_PERIOD_S,
+        .freq_hz = freq_hz,
+        .zeta = zeta,
+    };
+    SHAPER_DESIGN_t design;
+    bool applied;
+
+    /* Design (floating-point) outside of the critical section. */
+    if (shaper_design(&config, &design) == false)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    applied = shaper_set_design(&_shaper[id], &design);
+    taskEXIT_CRITICAL();
+
+    return applied;
+}
+
+SHAPER_TYPE_t servo_ctrl_get_shaper(SERVO_ID_t id)
+{
+    return _shaper[id].design.type;
+}
+
+bool servo_ctrl_move(SERVO_ID_t id, SERVO_ANGLE_Q16_t target, PROFILE_TYPE_t type, const PROFILE_LIMITS_t *limits, bool blend)
+{
+    PROFILE_GEN_t *gen = &_profile[id];
+    SERVO_ANGLE_Q16_t angle_min;
+    SERVO_ANGLE_Q16_t angle_max;
+
+    servo_get_limits_q16(id, &angle_min, &angle_max);
+    target = LIMIT_VAR_RANGE(angle_min, angle_max, target);
+
+    /* When idle, start from the current setpoint (it may have been set directly). */
+    taskENTER_CRITICAL();
+    if (profile_is_busy(gen) == false)
+    {
+        profile_reset(gen, servo_get_angle_expected_q16(id));
+    }
+    taskEXIT_CRITICAL();
+
+    /* Plan (floating-point) into a free queue slot, not yet visible to the control loop. */
+    if (profile_plan(gen, type, target, limits, blend) == false)
+    {
+        return false;
+    }
+
+    bool queued = false;
+    taskENTER_CRITICAL();
+    if (move_allowed(id))
+    {
+        profile_commit(gen);
+        _coord_lockstep = false;
+        queued = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return queued;
+}
+
+bool servo_ctrl_move_coordinated(const SERVO_ANGLE_Q16_t targets[SERVO_NUM_SERVOS], PROFILE_TYPE_t type,
+                                 const PROFILE_LIMITS_t *limits, bool blend)
+{
+    SERVO_ANGLE_Q16_t limited[SERVO_NUM_SERVOS];
+    PROFILE_LIMITS_t axis_limits[SERVO_NUM_SERVOS];
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_ANGLE_Q16_t angle_min;
+        SERVO_ANGLE_Q16_t angle_max;
+        servo_get_limits_q16(i, &angle_min, &angle_max);
+        limited[i] = LIMIT_VAR_RANGE(angle_min, angle_max, targets[i]);
+        axis_limits[i] = *limits;
+    }
+
+    /* When all are idle, start from the current setpoints; else only after coordinated moves (lock-step). */
+    taskENTER_CRITICAL();
+    bool idle = true;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        idle &= (profile_is_busy(&_profile[i]) == false);
+    }
+    if (idle)
+    {
+        for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+        {
+            profile_reset(&_profile[i], servo_get_angle_expected_q16(i));
+        }
+        _coord_lockstep = true;
+    }
+    bool lockstep = _coord_lockstep;
+    taskEXIT_CRITICAL();
+    if (lockstep == false)
+    {
+        return false;
+    }
+
+    /* Plan (floating-point) into the free queue slots, not yet visible to the control loop. */
+    uint32_t ticks;
+    uint32_t plan_start = CYCLE_COUNTER_GET();
+    if (coord_plan(_profile, SERVO_NUM_SERVOS, type, limited, axis_limits, blend, &ticks) == false)
+    {
+        return false;
+    }
+    uint32_t plan_cycles = CYCLE_COUNTER_GET() - plan_start;
+
+    /* Not committed if lock-step was lost (a move queued or aborted) whilst planning. */
+    taskENTER_CRITICAL();
+    bool queued = _coord_lockstep;
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        queued &= move_allowed(i);
+    }
+    if (queued)
+    {
+        coord_commit(_profile, SERVO_NUM_SERVOS);
+        _stats.coord_moves++;
+        _stats.coord_ticks_last = ticks;
+        _stats.coord_plan_cycles_last = plan_cycles;
+        _stats.coord_plan_cycles_max = LIMIT_VAR_MIN(plan_cycles, _stats.coord_plan_cycles_max);
+    }
+    taskEXIT_CRITICAL();
+
+    return queued;
+}
+
+void servo_ctrl_move_abort(SERVO_ID_t id)
+{
+    taskENTER_CRITICAL();
+    profile_reset(&_profile[id], servo_get_angle_expected_q16(id));
+    _coord_lockstep = false;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t servo_ctrl_get_moves_queued(SERVO_ID_t id)
+{
+    return PROFILE_QUEUE_LEN - profile_get_queue_space(&_profile[id]);
+}
+
+bool servo_ctrl_autotune_start(SERVO_ID_t id)
+{
+    const AUTOTUNE_CONFIG_t config = {
+        .period_s = SERVO_CTRL_LOOP_PERIOD_S,
+        .amplitude = SERVO_CTRL_AUTOTUNE_AMPLITUDE_DEG,
+        .hysteresis = SERVO_CTRL_AUTOTUNE_HYSTERESIS_DEG,
+        .settle_cycles = SERVO_CTRL_AUTOTUNE_SETTLE_CYCLES,
+        .measure_cycles = SERVO_CTRL_AUTOTUNE_MEASURE_CYCLES,
+        .max_cycles = SERVO_CTRL_AUTOTUNE_MAX_CYCLES,
+        .timeout_s = SERVO_CTRL_AUTOTUNE_TIMEOUT_S,
+        .rule = SERVO_CTRL_AUTOTUNE_RULE,
+    };
+    bool started = false;
+
+    taskENTER_CRITICAL();
+    if (_state_valid[id] && (stream_is_active(&_stream) == false) && (_fault[id].fault == MOTOR_FAULT__NONE) &&
+        (autotune_get_state(&_autotune[id]) != AUTOTUNE_STATE__RUNNING) &&
+        ((id != _sysid_id) || (sysid_get_state(&_sysid) != SYSID_STATE__RUNNING)) &&
+        ((id != _friction_id_servo) || (friction_id_get_state(&_friction_id, NULL) != FRICTION_ID_STATE__RUNNING)))
+    {
+        /* Hold the setpoint: the relay switches about it. */
+        SERVO_ANGLE_Q16_t setpoint = servo_get_angle_expected_q16(id);
+        profile_reset(&_profile[id], setpoint);
+        _coord_lockstep = false;
+        autotune_start(&_autotune[id], &config, SERVO_ANGLE_Q16_TO_FLOAT(setpoint));
+        started = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return started;
+}
+
+AUTOTUNE_STATE_t servo_ctrl_get_autotune(SERVO_ID_t id, AUTOTUNE_RESULT_t *result)
+{
+    AUTOTUNE_STATE_t state;
+
+    taskENTER_CRITICAL();
+    state = autotune_get_state(&_autotune[id]);
+    autotune_get_result(&_autotune[id], result);
+    taskEXIT_CRITICAL();
+
+    return state;
+}
+
+bool servo_ctrl_sysid_start(SERVO_ID_t id, SYSID_SIGNAL_t signal)
+{
+    const SYSID_CONFIG_t config = {
+        .signal = signal,
+        .period_s = 1.0f / SERVO_FB_SAMPLE_RATE_HZ,
+        .amplitude = SERVO_CTRL_SYSID_AMPLITUDE_DEG,
+        .f_min_hz = SERVO_CTRL_SYSID_F_MIN_HZ,
+        .f_max_hz = SERVO_CTRL_SYSID_F_MAX_HZ,
+        .prbs_hold = SERVO_CTRL_SYSID_PRBS_HOLD,
+        .settle_periods = SERVO_CTRL_SYSID_SETTLE_PERIODS,
+        .periods = SERVO_CTRL_SYSID_PERIODS,
+    };
+    const SERVO_ANGLE_Q16_t amplitude = SERVO_ANGLE_DEG_TO_Q16(SERVO_CTRL_SYSID_AMPLITUDE_DEG);
+    SERVO_ANGLE_Q16_t angle_min;
+    SERVO_ANGLE_Q16_t angle_max;
+    bool started = false;
+
+    servo_get_limits_q16(id, &angle_min, &angle_max);
+
+    taskENTER_CRITICAL();
+    SYSID_STATE_t state = sysid_get_state(&_sysid);
+    SERVO_ANGLE_Q16_t setpoint = servo_get_angle_expected_q16(id);
+    if (_state_valid[id] && (stream_is_active(&_stream) == false) && (_fault[id].fault == MOTOR_FAULT__NONE) &&
+        (autotune_get_state(&_autotune[id]) != AUTOTUNE_STATE__RUNNING) &&
+        (state != SYSID_STATE__RUNNING) && (state != SYSID_STATE__CAPTURED) &&
+        ((id != _friction_id_servo) || (friction_id_get_state(&_friction_id, NULL) != FRICTION_ID_STATE__RUNNING)) &&
+        ((setpoint - amplitude) >= angle_min) && ((setpoint + amplitude) <= angle_max))
+    {
+        /* Hold the setpoint: the excitation is about it. */
+        profile_reset(&_profile[id], setpoint);
+        _coord_lockstep = false;
+        sysid_start(&_sysid, &config, SERVO_ANGLE_Q16_TO_FLOAT(setpoint));
+        _sysid_id = id;
+        _sysid_excitation = 0.0f;
+        started = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return started;
+}
+
+bool servo_ctrl_sysid_process(void)
+{
+    /* The control loop no longer accesses the identifier once captured. */
+    return sysid_compute(&_sysid);
+}
+
+SYSID_STATE_t servo_ctrl_get_sysid(SERVO_ID_t *id)
+{
+    *id = _sysid_id;
+    return sysid_get_state(&_sysid);
+}
+
+bool servo_ctrl_get_sysid_bin(uint32_t bin, SYSID_BIN_t *result)
+{
+    return sysid_get_bin(&_sysid, bin, result);
+}
+
+bool servo_ctrl_ilc_start(SERVO_ID_t id, uint32_t moves_per_cycle)
+{
+    if ((moves_per_cycle > 0) && ((_ilc_ready == false) || (_loop_type == SERVO_CTRL_LOOP_TYPE__MPC) ||
+                                  stream_is_active(&_stream) || (_fault[id].fault != MOTOR_FAULT__NONE)))
+    {
+        return false;
+    }
+
+    /* Applied by the learning task, such that the tables are not cleared under ilc_learn. */
+    _ilc_request[id] = moves_per_cycle;
+    _ilc_request_pending[id] = true;
+    return true;
+}
+
+uint32_t servo_ctrl_ilc_process(void)
+{
+    uint32_t learnt = 0;
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (_ilc_request_pending[i])
+        {
+            _ilc_request_pending[i] = false;
+            uint32_t moves_per_cycle = _ilc_request[i];
+            taskENTER_CRITICAL();
+            ilc_abort(i);
+            if (moves_per_cycle > 0)
+            {
+                /* The first cycle starts with the next move. */
+                ilc_start(&_ilc[i]);
+                _ilc_moves_ref[i] = profile_get_moves_started(&_profile[i]) - moves_per_cycle + 1;
+                _ilc_moves_per_cycle[i] = moves_per_cycle;
+            }
+            taskEXIT_CRITICAL();
+        }
+
+        /* The control loop no longer accesses a recorded error trace or a learnt correction's buffer. */
+        if (ilc_learn(&_ilc[i]))
+        {
+            learnt++;
+        }
+    }
+
+    return learnt;
+}
+
+ILC_STATE_t servo_ctrl_get_ilc(SERVO_ID_t id, ILC_STATS_t *stats)
+{
+    ILC_STATE_t state;
+
+    taskENTER_CRITICAL();
+    state = ilc_get_state(&_ilc[id]);
+    *stats = _ilc[id].stats;
+    taskEXIT_CRITICAL();
+
+    return state;
+}
+
+void servo_ctrl_friction_enable(SERVO_ID_t id, bool state)
+{
+    taskENTER_CRITICAL();
+    if (state && (_friction_enabled[id] == false))
+    {
+        friction_reset(&_friction[id]);
+    }
+    _friction_enabled[id] = state;
+    taskEXIT_CRITICAL();
+}
+
+bool servo_ctrl_friction_set_params(SERVO_ID_t id, const FRICTION_PARAMS_t *params)
+{
+    bool loaded;
+
+    taskENTER_CRITICAL();
+    loaded = friction_set_params(&_friction[id], params);
+    taskEXIT_CRITICAL();
+
+    return loaded;
+}
+
+bool servo_ctrl_get_friction(SERVO_ID_t id, FRICTION_PARAMS_t *params, float *disturbance, bool *holding)
+{
+    taskENTER_CRITICAL();
+    *params = _friction[id].params;
+    *disturbance = friction_get_disturbance(&_friction[id]);
+    *holding = friction_is_holding(&_friction[id]);
+    taskEXIT_CRITICAL();
+
+    return _friction_enabled[id];
+}
+
+bool servo_ctrl_friction_id_start(SERVO_ID_t id)
+{
+    const FRICTION_ID_CONFIG_t config = {
+        .period_s = 1.0f / SERVO_FB_SAMPLE_RATE_HZ,
+        .amplitude = SERVO_CTRL_FRICTION_ID_AMPLITUDE_DEG,
+        .speed_min = SERVO_CTRL_FRICTION_ID_SPEED_MIN_DEG_S,
+        .speed_max = SERVO_CTRL_FRICTION_ID_SPEED_MAX_DEG_S,
+        .settle_s = SERVO_CTRL_FRICTION_ID_SETTLE_S,
+        .still_speed = SERVO_CTRL_FRICTION_STILL_DEG_S,
+        .breakaway_travel = SERVO_CTRL_FRICTION_ID_TRAVEL_DEG,
+        .model_slope = (2.0f * SERVO_CTRL_MPC_ZETA) / (2.0f * PI * SERVO_CTRL_MPC_WN_HZ),
+    };
+    const SERVO_ANGLE_Q16_t amplitude = SERVO_ANGLE_DEG_TO_Q16(SERVO_CTRL_FRICTION_ID_AMPLITUDE_DEG);
+    SERVO_ANGLE_Q16_t angle_min;
+    SERVO_ANGLE_Q16_t angle_max;
+    bool started = false;
+
+    servo_get_limits_q16(id, &angle_min, &angle_max);
+
+    taskENTER_CRITICAL();
+    SERVO_ANGLE_Q16_t setpoint = servo_get_angle_expected_q16(id);
+    if (_state_valid[id] && (stream_is_active(&_stream) == false) && (_fault[id].fault == MOTOR_FAULT__NONE) &&
+        (autotune_get_state(&_autotune[id]) != AUTOTUNE_STATE__RUNNING) &&
+        ((id != _sysid_id) || (sysid_get_state(&_sysid) != SYSID_STATE__RUNNING)) &&
+        (friction_id_get_state(&_friction_id, NULL) != FRICTION_ID_STATE__RUNNING) &&
+        ((setpoint - amplitude) >= angle_min) && ((setpoint + amplitude) <= angle_max))
+    {
+        /* Hold the setpoint: the sweep is about it. */
+        profile_reset(&_profile[id], setpoint);
+        _coord_lockstep = false;
+        started = friction_id_start(&_friction_id, &config);
+        _friction_id_servo = id;
+        _friction_excitation = 0.0f;
+    }
+    taskEXIT_CRITICAL();
+
+    return started;
+}
+
+FRICTION_ID_STATE_t servo_ctrl_get_friction_id(SERVO_ID_t *id, FRICTION_PARAMS_t *result)
+{
+    FRICTION_ID_STATE_t state;
+
+    taskENTER_CRITICAL();
+    *id = _friction_id_servo;
+    state = friction_id_get_state(&_friction_id, result);
+    taskEXIT_CRITICAL();
+
+    return state;
+}
+
+void servo_ctrl_lms_enable(SERVO_ID_t id, bool state)
+{
+    _lms_enabled[id] = state;
+}
+
+void servo_ctrl_lms_freeze(SERVO_ID_t id, bool state)
+{
+    lms_ff_freeze(&_lms[id], state);
+}
+
+void servo_ctrl_lms_clear(SERVO_ID_t id)
+{
+    _lms_clear_pending[id] = true;
+}
+
+uint32_t servo_ctrl_lms_process(void)
+{
+    uint32_t processed = 0;
+
+    if (_lms_ready == false)
+    {
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        if (_lms_clear_pending[i])
+        {
+            /* Not under lms_ff_adapt (this task's), nor a control loop update. */
+            _lms_clear_pending[i] = false;
+            taskENTER_CRITICAL();
+            lms_ff_clear(&_lms[i]);
+            taskEXIT_CRITICAL();
+        }
+
+        /* The control loop no longer accesses a recorded block or the coefficients not applied. */
+        if (lms_ff_adapt(&_lms[i]))
+        {
+            processed++;
+        }
+    }
+
+    return processed;
+}
+
+bool servo_ctrl_get_lms(SERVO_ID_t id, LMS_FF_STATS_t *stats, bool *frozen)
+{
+    taskENTER_CRITICAL();
+    *stats = _lms[id].stats;
+    *frozen = _lms[id].frozen;
+    taskEXIT_CRITICAL();
+
+    return _lms_enabled[id];
+}
+
+void servo_ctrl_gain_sched_enable(bool state)
+{
+    _gain_sched_enabled = state;
+}
+
+bool servo_ctrl_gain_sched_is_enabled(void)
+{
+    return _gain_sched_enabled;
+}
+
+void servo_ctrl_gain_sched_begin(void)
+{
+    /* Lock-free: the control loop only reads the active table. */
+    gain_sched_begin(&_gain_sched);
+}
+
+void servo_ctrl_gain_sched_set_axes(float pos_min_deg, float pos_max_deg, float load_max_deg)
+{
+    gain_sched_set_axes(&_gain_sched, pos_min_deg, pos_max_deg, load_max_deg);
+}
+
+bool servo_ctrl_gain_sched_set_point(uint32_t load_idx, uint32_t pos_idx, const float scale[GAIN_SCHED_PARAM__NUM])
+{
+    return gain_sched_set_point(&_gain_sched, load_idx, pos_idx, scale);
+}
+
+bool servo_ctrl_gain_sched_commit(void)
+{
+    if (gain_sched_commit(&_gain_sched) == false)
+    {
+        return false;
+    }
+    _gain_sched_enabled = true;
+
+    return true;
+}
+
+uint32_t servo_ctrl_gain_sched_get_swaps(void)
+{
+    return _gain_sched.swap_count;
+}
+
+bool servo_ctrl_stream_push(uint32_t timestamp_us, const SERVO_ANGLE_Q16_t positions[SERVO_NUM_SERVOS])
+{
+    STREAM_WAYPOINT_t waypoint = {.timestamp_us = timestamp_us};
+    uint32_t num_targets = _ik_enabled ? ik_get_num_joints(&_ik) : 0; /* Cartesian target channels. */
+
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        SERVO_ANGLE_Q16_t angle_min;
+        SERVO_ANGLE_Q16_t angle_max;
+        servo_get_limits_q16(i, &angle_min, &angle_max);
+        waypoint.position[i] = (i < num_targets) ? positions[i] : LIMIT_VAR_RANGE(angle_min, angle_max, positions[i]);
+    }
+
+    /* Lock-free: the control loop is the only consumer. */
+    return stream_push(&_stream, &waypoint);
+}
+
+bool servo_ctrl_stream_is_active(void)
+{
+    return stream_is_active(&_stream);
+}
+
+void servo_ctrl_get_stream_stats(STREAM_STATS_t *stats)
+{
+    taskENTER_CRITICAL();
+    stream_get_stats(&_stream, stats);
+    taskEXIT_CRITICAL();
+}
+
+bool servo_ctrl_ik_set(const IK_CONFIG_t *config)
+{
+    IK_t ik;
+
+    if (stream_is_active(&_stream) || (ik_init(&ik, config) == false))
+    {
+        return false;
+    }
+    taskENTER_CRITICAL();
+    _ik = ik;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+bool servo_ctrl_ik_enable(bool state)
+{
+    /* The channels' meaning is not changed mid-stream. */
+    if (stream_is_active(&_stream))
+    {
+        return false;
+    }
+    _ik_enabled = state;
+    return true;
+}
+
+bool servo_ctrl_ik_get(IK_CONFIG_t *config)
+{
+    taskENTER_CRITICAL();
+    *config = _ik.config;
+    taskEXIT_CRITICAL();
+    return _ik_enabled;
+}
+
+bool servo_ctrl_get_state(SERVO_ID_t id, SERVO_CTRL_STATE_t *state)
+{
+    bool valid;
+
+    taskENTER_CRITICAL();
+    *state = _state[id];
+    valid = _state_valid[id];
+    taskEXIT_CRITICAL();
+
+    return valid;
+}
+
+bool servo_ctrl_is_moving(SERVO_ID_t id)
+{
+    return (_motion_hold[id] > 0);
+}
+
+bool servo_ctrl_get_fault(SERVO_ID_t id, SERVO_CTRL_FAULT_t *fault)
+{
+    taskENTER_CRITICAL();
+    *fault = _fault[id];
+    taskEXIT_CRITICAL();
+
+    return (fault->fault != MOTOR_FAULT__NONE);
+}
+
+bool servo_ctrl_is_faulted(void)
+{
+    return _faulted;
+}
+
+void servo_ctrl_get_stats(SERVO_CTRL_STATS_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _stats;
+    taskEXIT_CRITICAL();
+}
+
+void servo_ctrl_reset_stats(void)
+{
+    taskENTER_CRITICAL();
+    clear_stats();
+    stream_reset_fill_min(&_stream);
+    taskEXIT_CRITICAL();
+}
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
+
+__weak bool servo_ctrl_get_feedback(SERVO_ID_t id, float *angle)
+{
+    if (servo_get_feedback_valid(id) == false)
+    {
+        return false;
+    }
+    *angle = SERVO_ANGLE_Q16_TO_FLOAT(servo_get_angle_actual_q16(id));
+    return true;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Clear control loop statistics.
+ * @retval None.
+ */
+static void clear_stats(void)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.period_cycles_min = UINT32_MAX;
+}
+
+/**
+ * @brief  Record control loop statistics.
+ * @param  start:          Cycle count at the start of this loop.
+ * @param  end:            Cycle count at the end of this loop.
+ * @param  error:          Largest magnitude tracking error in degrees.
+ * @param  feedback_valid: Whether the loop was closed with feedback (for at
+ *                         least one servo).
+ * @retval None.
+ */
+static void record_stats(uint32_t start, uint32_t end, float error, bool feedback_valid)
+{
+    if (_stats.loop_count > 0)
+    {
+        uint32_t period = start - _loop_start_prev;
+        _stats.period_cycles_min = LIMIT_VAR_MAX(period, _stats.period_cycles_min);
+        _stats.period_cycles_max = LIMIT_VAR_MIN(period, _stats.period_cycles_max);
+    }
+    _loop_start_prev = start;
+
+    _stats.exec_cycles_last = end - start;
+    _stats.exec_cycles_max = LIMIT_VAR_MIN(_stats.exec_cycles_last, _stats.exec_cycles_max);
+
+    float error_abs = (error < 0.0f) ? -error : error;
+    _stats.tracking_error_deg = error;
+    _stats.tracking_error_max_deg = LIMIT_VAR_MIN(error_abs, _stats.tracking_error_max_deg);
+    _stats.feedback_valid = feedback_valid;
+    _stats.loop_count++;
+}
+
+/**
+ * @brief  Reset all servos' controllers (PID, cascaded and MPC), stop their
+ *         iterative learning control and restart their adaptive feedforward.
+ * @note   The caller provides the mutual exclusion with the control loop.
+ * @retval None.
+ */
+static void reset_controllers(void)
+{
+    for (uint32_t i = 0; i < SERVO_NUM_SERVOS; i++)
+    {
+        pid_reset(&_pid[i]);
+        pid_reset(&_pid_pos[i]);
+        pid_reset(&_pid_vel[i]);
+        _vel_correction[i] = 0.0f;
+        _mpc_valid[i] = false;
+        ilc_abort(i); /* Learnt against the previous controllers. */
+        friction_reset(&_friction[i]);
+        lms_restart(i);
+    }
+    _pos_loop_count = 0;
+}
+
+/**
+ * @brief  Load a servo's scheduled gains into its controllers (PID, and the
+ *         cascaded inner velocity loop; both, such that a loop type change
+ *         finds them current): the base gains times the smoothed scale
+ *         factors.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval None.
+ */
+static void apply_gains(SERVO_ID_t id)
+{
+    const float *scale = _sched_scale[id];
+
+    pid_set_gains(&_pid[id], _pid_base[id][GAIN_SCHED_PARAM__KP] * scale[GAIN_SCHED_PARAM__KP],
+                  _pid_base[id][GAIN_SCHED_PARAM__KI] * scale[GAIN_SCHED_PARAM__KI],
+                  _pid_base[id][GAIN_SCHED_PARAM__KD] * scale[GAIN_SCHED_PARAM__KD]);
+    pid_set_gains(&_pid_vel[id], SERVO_CTRL_VEL_KP * scale[GAIN_SCHED_PARAM__KP],
+                  SERVO_CTRL_VEL_KI * scale[GAIN_SCHED_PARAM__KI], 0.0f);
+}
+
+/**
+ * @brief  Cascaded controller update:
+ *             - Outer position loop (when @param pos_update, i.e. at
+ *               SERVO_CTRL_POS_LOOP_RATE_HZ): velocity correction from the
+ *               position error, held until its next update.
+ *             - Inner velocity loop: velocity reference (feedforward +
+ *               correction) tracked against the estimated velocity.
+ *             - Feedforward of the profile velocity and acceleration.
+ * @param  id:         Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint:   Setpoint (degrees).
+ * @param  feedback:   Position feedback (degrees); used until the estimate
+ *                     is valid.
+ * @param  ff_vel:     Feedforward velocity (degrees/s).
+ * @param  ff_acc:     Feedforward acceleration (degrees/s^2).
+ * @param  pos_update: Whether to update the outer loop.
+ * @param  command_min: Minimum command (degrees); the inner loop is limited
+ *                      to the headroom left by the setpoint and feedforward.
+ * @param  command_max: Maximum command (degrees); as @param command_min.
+ * @retval Correction to add to the setpoint (degrees).
+ */
+static float cascade_update(SERVO_ID_t id, float setpoint, float feedback, float ff_vel, float ff_acc, bool pos_update,
+                            float command_min, float command_max)
+{
+    float position = _state_valid[id] ? _state[id].position_deg : feedback;
+    float velocity = _state_valid[id] ? _state[id].velocity_deg_s : 0.0f;
+
+    if (pos_update)
+    {
+        _vel_correction[id] = pid_update(&_pid_pos[id], setpoint, position);
+    }
+
+    float vel_ref = ff_vel + _vel_correction[id];
+    float ff = _sched_scale[id][GAIN_SCHED_PARAM__FF] * ((SERVO_CTRL_FF_VEL_S * ff_vel) + (SERVO_CTRL_FF_ACC_S2 * ff_acc));
+    pid_set_actuator_limits(&_pid_vel[id], command_min - setpoint - ff, command_max - setpoint - ff);
+    return ff + pid_update(&_pid_vel[id], vel_ref, velocity);
+}
+
+/**
+ * @brief  MPC update: the command held from the servo's last solve, and when
+ *         @param solve a new solve: the observer is stepped with the held
+ *         command and the feedback, then the command for the next PWM frame
+ *         optimised, constrained to the servo's limits (command and
+ *         position) and the MPC slew limit. The state and command are
+ *         initialised (bumpless) at the first update after a reset.
+ * @param  id:        Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint:  Setpoint (degrees); the reference.
+ * @param  feedback:  Position feedback (degrees).
+ * @param  solve:     Whether to solve.
+ * @param  limit_min: Servo's minimum limit (degrees).
+ * @param  limit_max: Servo's maximum limit (degrees).
+ * @retval Correction to add to the setpoint (degrees).
+ */
+static float mpc_update(SERVO_ID_t id, float setpoint, float feedback, bool solve, float limit_min, float limit_max)
+{
+    if (_mpc_valid[id] == false)
+    {
+        mpc_state_reset(&_mpc_state[id], feedback);
+        _mpc_command[id] = setpoint;
+        _mpc_valid[id] = true;
+    }
+
+    if (solve)
+    {
+        uint32_t start = CYCLE_COUNTER_GET();
+        uint32_t iterations;
+        const MPC_LIMITS_t limits = {
+            .u_min = limit_min,
+            .u_max = limit_max,
+            .du_max = SERVO_CTRL_MPC_SLEW_DEG_S / SERVO_PWM_FRAME_RATE_HZ,
+            .y_min = limit_min,
+            .y_max = limit_max,
+        };
+        mpc_observe(&_mpc, &_mpc_state[id], _mpc_command[id], feedback);
+        _mpc_command[id] = mpc_step(&_mpc, &_mpc_state[id], setpoint, _mpc_command[id], &limits, &iterations);
+
+        _stats.mpc_cycles_last = CYCLE_COUNTER_GET() - start;
+        _stats.mpc_cycles_max = LIMIT_VAR_MIN(_stats.mpc_cycles_last, _stats.mpc_cycles_max);
+        _stats.mpc_iterations_max = LIMIT_VAR_MIN(iterations, _stats.mpc_iterations_max);
+        if (iterations > 0)
+        {
+            _stats.mpc_constrained_count++;
+        }
+    }
+
+    return _mpc_command[id] - setpoint;
+}
+
+/**
+ * @brief  Stop a servo on a motor fault, from the control loop: its PWM
+ *         signal is cut (the channel's output gated; the PWM timer keeps
+ *         running, such that the frame interrupt and the feedback samples
+ *         continue for the other servos, see fb_missed_frames), its moves,
+ *         experiments and learning are aborted,
+ *         the fault is latched with its detection latency, and the
+ *         operational mode is set to the motor error without waiting for the
+ *         operational mode task.
+ * @param  id:         Servo ID; see @ref SERVO_ID_t.
+ * @param  fault:      Fault detected.
+ * @param  loop_start: Start of this loop (CPU cycles).
+ * @retval None.
+ */
+static void fault_stop(SERVO_ID_t id, MOTOR_FAULT_t fault, uint32_t loop_start)
+{
+    uint32_t onset;
+
+    servo_set_signal(id, false);
+    uint32_t cut = CYCLE_COUNTER_GET();
+
+    motor_health_get_fault(&_health[id], &onset);
+    _fault[id].fault = fault;
+    _fault[id].latency_cycles = cut - onset;
+    _fault[id].cut_cycles = cut - loop_start;
+    _faulted = true;
+
+    profile_reset(&_profile[id], servo_get_angle_expected_q16(id));
+    _coord_lockstep = false;
+    autotune_abort(&_autotune[id]);
+    if (id == _sysid_id)
+    {
+        sysid_abort(&_sysid);
+    }
+    if (id == _friction_id_servo)
+    {
+        friction_id_abort(&_friction_id);
+    }
+    ilc_abort(id);
+    friction_reset(&_friction[id]);
+    lms_restart(id);
+    op_mode_set_error_motor();
+}
+
+/**
+ * @brief  Iterative learning control update of a servo (whilst closed-loop
+ *         under the PID or cascaded controller): a cycle boundary every
+ *         moves per cycle profile moves started, the tracking error (of the
+ *         estimated position) recorded and the learnt correction retrieved.
+ *         Stopped whilst a setpoint stream is active or the MPC controller
+ *         structure is selected.
+ * @param  id:       Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint: Setpoint of this loop (degrees).
+ * @retval Correction to add to the command (degrees).
+ */
+static float ilc_step(SERVO_ID_t id, float setpoint)
+{
+    uint32_t moves_per_cycle = _ilc_moves_per_cycle[id];
+
+    if (moves_per_cycle == 0)
+    {
+        return 0.0f;
+    }
+    if (_streaming || (_loop_type == SERVO_CTRL_LOOP_TYPE__MPC))
+    {
+        ilc_abort(id);
+        return 0.0f;
+    }
+
+    if ((profile_get_moves_started(&_profile[id]) - _ilc_moves_ref[id]) >= moves_per_cycle)
+    {
+        _ilc_moves_ref[id] += moves_per_cycle;
+        ilc_cycle_start(&_ilc[id]);
+    }
+    return ilc_update(&_ilc[id], setpoint - _state[id].position_deg);
+}
+
+/**
+ * @brief  Stop a servo's iterative learning control (the correction is
+ *         removed).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval None.
+ */
+static void ilc_abort(SERVO_ID_t id)
+{
+    _ilc_moves_per_cycle[id] = 0;
+    ilc_stop(&_ilc[id]);
+}
+
+/**
+ * @brief  Friction compensation update of a servo (whilst closed-loop under
+ *         the PID or cascaded controller): the disturbance observer stepped
+ *         with each feedback sample and the latched command, and the
+ *         compensation offset. Reset whilst disabled or the MPC controller
+ *         structure (with its own disturbance observer) is selected.
+ * @param  id:           Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint:     Setpoint of this loop (degrees).
+ * @param  feedback:     Position feedback (degrees).
+ * @param  ref_velocity: Setpoint velocity (degrees/s).
+ * @param  fb_new:       Whether the feedback is a new sample.
+ * @param  holding:      Within the hold band at standstill, i.e. the
+ *                       controller's error is to be zeroed. Passed by
+ *                       reference.
+ * @retval Offset to add to the command (degrees).
+ */
+static float friction_step(SERVO_ID_t id, float setpoint, float feedback, float ref_velocity, bool fb_new,
+                           bool *holding)
+{
+    FRICTION_t *friction = &_friction[id];
+
+    if ((_friction_enabled[id] == false) || (_loop_type == SERVO_CTRL_LOOP_TYPE__MPC))
+    {
+        friction_reset(friction);
+        *holding = false;
+        return 0.0f;
+    }
+
+    if (fb_new && _command_latched_valid[id])
+    {
+        friction_observe(friction, _command_latched[id], feedback);
+    }
+    float offset = friction_update(friction, setpoint - feedback, ref_velocity, _state[id].velocity_deg_s);
+    *holding = friction_is_holding(friction);
+    return offset;
+}
+
+/**
+ * @brief  Adaptive feedforward update of a servo (whilst closed-loop under
+ *         the PID or cascaded controller): once per PWM frame, in the loop
+ *         whose command is latched at the frame's end, the filter updated
+ *         with the setpoint and the tracking error (of the estimated
+ *         position) recorded; its output is held over the frame. Restarted
+ *         whilst disabled or the MPC controller structure is selected.
+ * @param  id:        Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint:  Setpoint of this loop (degrees).
+ * @param  frame_end: Whether this is the frame's last loop.
+ * @retval Feedforward to add to the command (degrees).
+ */
+static float lms_step(SERVO_ID_t id, float setpoint, bool frame_end)
+{
+    if ((_lms_ready == false) || (_lms_enabled[id] == false) || (_loop_type == SERVO_CTRL_LOOP_TYPE__MPC))
+    {
+        lms_restart(id);
+        return 0.0f;
+    }
+
+    if (frame_end)
+    {
+        _lms_output[id] = lms_ff_update(&_lms[id], setpoint);
+        lms_ff_record(&_lms[id], setpoint - _state[id].position_deg);
+    }
+    return _lms_output[id];
+}
+
+/**
+ * @brief  Restart a servo's adaptive feedforward (the coefficients are kept;
+ *         zero output until its next update).
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval None.
+ */
+static void lms_restart(SERVO_ID_t id)
+{
+    lms_ff_restart(&_lms[id]);
+    _lms_output[id] = 0.0f;
+}
+
+/**
+ * @brief  Retrieve whether a servo's motion profile may be given moves: no
+ *         setpoint stream is active, the servo is not being auto-tuned or
+ *         identified and has no fault.
+ * @note   To be called within a critical section, with the commit.
+ * @param  id: Servo ID; see @ref SERVO_ID_t.
+ * @retval Boolean indicating whether moves are allowed.
+ */
+static bool move_allowed(SERVO_ID_t id)
+{
+    return (stream_is_active(&_stream) == false) && (autotune_get_state(&_autotune[id]) != AUTOTUNE_STATE__RUNNING) &&
+           ((id != _sysid_id) || (sysid_get_state(&_sysid) != SYSID_STATE__RUNNING)) &&
+           ((id != _friction_id_servo) || (friction_id_get_state(&_friction_id, NULL) != FRICTION_ID_STATE__RUNNING)) &&
+           (_fault[id].fault == MOTOR_FAULT__NONE);
+}
+
+/**
+ * @brief  Update a servo's motion detection: moving whilst the estimated
+ *         speed exceeds SERVO_CTRL_MOTION_THRESHOLD_DEG_S or, without a valid
+ *         estimate (open-loop), whilst the setpoint changes; held for
+ *         SERVO_CTRL_MOTION_HOLD_LOOPS after.
+ * @param  id:       Servo ID; see @ref SERVO_ID_t.
+ * @param  setpoint: Setpoint of this loop.
+ * @retval None.
+ */
+static void update_motion(SERVO_ID_t id, SERVO_ANGLE_Q16_t setpoint)
+{
+    bool moving;
+
+    if (_state_valid[id])
+    {
+        moving = (fabsf(_state[id].velocity_deg_s) > SERVO_CTRL_MOTION_THRESHOLD_DEG_S);
+    }
+    else
+    {
+        moving = (setpoint != _setpoint_prev[id]);
+    }
+    _setpoint_prev[id] = setpoint;
+
+    if (moving)
+    {
+        _motion_hold[id] = SERVO_CTRL_MOTION_HOLD_LOOPS;
+    }
+    else if (_motion_hold[id] > 0)
+    {
+        _motion_hold[id]--;
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
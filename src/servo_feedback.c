@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * @file   servo_feedback.c
+ * @brief  Servo motor position feedback (potentiometer) conversion source
+ *         file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "servo_feedback.h"
+
+/*===== Defines & Macros =====================================================*/
+
+#define SERVO_FEEDBACK_ANGLE_MAX_Q16 ((int32_t)SERVO_FEEDBACK_ANGLE_RANGE_DEG << 16)
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool servo_feedback_init(SERVO_FEEDBACK_t *fb, uint32_t num_channels)
+{
+    if ((num_channels == 0) || (num_channels > SERVO_FEEDBACK_MAX_CHANNELS))
+    {
+        return false;
+    }
+
+    fb->num_channels = num_channels;
+    fb->block_count = 0;
+    for (uint32_t i = 0; i < SERVO_FEEDBACK_MAX_CHANNELS; i++)
+    {
+        SERVO_FEEDBACK_CHANNEL_t *ch = &fb->channel[i];
+        ch->raw_0 = 0;
+        ch->scale_q32 = 0;
+        ch->raw_valid_min = 1; /* Empty range: invalid until calibrated. */
+        ch->raw_valid_max = 0;
+        ch->angle_q16 = 0;
+        ch->valid = false;
+    }
+
+    return true;
+}
+
+bool servo_feedback_set_calibration(SERVO_FEEDBACK_t *fb, uint32_t channel, uint16_t raw_at_0, uint16_t raw_at_180)
+{
+    if ((channel >= fb->num_channels) || (raw_at_0 == raw_at_180))
+    {
+        return false;
+    }
+
+    SERVO_FEEDBACK_CHANNEL_t *ch = &fb->channel[channel];
+    int32_t span = (int32_t)raw_at_180 - raw_at_0;
+    int32_t lo = (span > 0) ? raw_at_0 : raw_at_180;
+    int32_t hi = (span > 0) ? raw_at_180 : raw_at_0;
+    int32_t margin = (hi - lo) / SERVO_FEEDBACK_VALID_MARGIN_DIV;
+
+    /* Invalidate whilst the calibration is updated. */
+    ch->valid = false;
+    ch->raw_valid_min = 1;
+    ch->raw_valid_max = 0;
+
+    ch->raw_0 = raw_at_0;
+    ch->scale_q32 = ((int64_t)SERVO_FEEDBACK_ANGLE_RANGE_DEG << 32) / span;
+    ch->raw_valid_min = lo - margin;
+    ch->raw_valid_max = hi + margin;
+
+    return true;
+}
+
+void servo_feedback_process(SERVO_FEEDBACK_t *fb, const uint16_t *samples, uint32_t num_scans)
+{
+    uint32_t sums[SERVO_FEEDBACK_MAX_CHANNELS] = {0};
+    uint32_t n = fb->num_channels;
+
+    if (num_scans == 0)
+    {
+        return;
+    }
+
+    for (uint32_t scan = 0; scan < num_scans; scan++)
+    {
+        for (uint32_t i = 0; i < n; i++)
+        {
+            sums[i] += *samples++;
+        }
+    }
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        SERVO_FEEDBACK_CHANNEL_t *ch = &fb->channel[i];
+        int32_t raw = (int32_t)(sums[i] / num_scans);
+
+        if ((raw < ch->raw_valid_min) || (raw > ch->raw_valid_max))
+        {
+            ch->valid = false;
+            continue;
+        }
+
+        int32_t angle = (int32_t)(((int64_t)(raw - ch->raw_0) * ch->scale_q32) >> 16);
+        if (angle < 0)
+        {
+            angle = 0;
+        }
+        else if (angle > SERVO_FEEDBACK_ANGLE_MAX_Q16)
+        {
+            angle = SERVO_FEEDBACK_ANGLE_MAX_Q16;
+        }
+        ch->angle_q16 = angle;
+        ch->valid = true;
+    }
+
+    fb->block_count++;
+}
+
+int32_t servo_feedback_get_angle_q16(const SERVO_FEEDBACK_t *fb, uint32_t channel)
+{
+    return fb->channel[channel].angle_q16;
+}
+
+bool servo_feedback_is_valid(const SERVO_FEEDBACK_t *fb, uint32_t channel)
+{
+    return fb->channel[channel].valid;
+}
+
+/*============================================================================*/
\ No newline at end of file
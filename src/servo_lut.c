@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * @file   servo_lut.c
+ * @brief  Servo motor angle to PWM pulse lookup table source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "servo_lut.h"
+
+/*===== Defines & Macros =====================================================*/
+
+#define SERVO_LUT_STEP_MASK     ((1L << SERVO_LUT_STEP_SHIFT) - 1)
+#define SERVO_LUT_ANGLE_MAX_Q16 ((int32_t)SERVO_LUT_ANGLE_MAX_DEG << 16)
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool servo_lut_build(SERVO_LUT_t *lut,
+                     const SERVO_CAL_POINT_t *points,
+                     uint32_t num_points,
+                     uint32_t frame_ns,
+                     uint32_t frame_counts)
+{
+    if ((num_points < 2) || (frame_ns == 0))
+    {
+        return false;
+    }
+    for (uint32_t k = 1; k < num_points; k++)
+    {
+        if (points[k].angle_q16 <= points[k-1].angle_q16)
+        {
+            return false;
+        }
+    }
+
+    uint32_t k = 0; /* Calibration segment (points[k]..points[k+1]). */
+    for (uint32_t i = 0; i < SERVO_LUT_NUM_POINTS; i++)
+    {
+        int32_t angle = (int32_t)(i << SERVO_LUT_STEP_SHIFT);
+
+        /* Advance to the segment containing the angle (or the last segment). */
+        while (((k + 2) < num_points) && (angle >= points[k+1].angle_q16))
+        {
+            k++;
+        }
+
+        const SERVO_CAL_POINT_t *p0 = &points[k];
+        const SERVO_CAL_POINT_t *p1 = &points[k+1];
+        int64_t ns = (int64_t)p0->pulse_ns +
+                     ((((int64_t)p1->pulse_ns - p0->pulse_ns) * (angle - p0->angle_q16)) /
+                     (p1->angle_q16 - p0->angle_q16));
+        int64_t counts = ((ns * frame_counts) / frame_ns) - 1;
+
+        lut->pulse[i] = (counts < 0) ? 0 : (uint32_t)counts;
+    }
+
+    return true;
+}
+
+uint32_t servo_lut_angle_to_pulse(const SERVO_LUT_t *lut, int32_t angle_q16)
+{
+    if (angle_q16 < 0)
+    {
+        angle_q16 = 0;
+    }
+    else if (angle_q16 > SERVO_LUT_ANGLE_MAX_Q16)
+    {
+        angle_q16 = SERVO_LUT_ANGLE_MAX_Q16;
+    }
+
+    uint32_t i = (uint32_t)angle_q16 >> SERVO_LUT_STEP_SHIFT;
+    int32_t frac = angle_q16 & SERVO_LUT_STEP_MASK;
+    int32_t p0 = (int32_t)lut->pulse[i];
+    int32_t p1 = (int32_t)lut->pulse[i+1];
+
+    return (uint32_t)(p0 + (int32_t)(((int64_t)(p1 - p0) * frac) >> SERVO_LUT_STEP_SHIFT));
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * @file   shaper.c
+ * @brief  Input shaper source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "shaper.h"
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool shaper_design(const SHAPER_CONFIG_t *config, SHAPER_DESIGN_t *design)
+{
+    design->type = config->type;
+    design->num_impulses = 1;
+    design->amplitudes[0] = 1.0f;
+    design->delays[0] = 0;
+    if (config->type == SHAPER_TYPE__NONE)
+    {
+        return true;
+    }
+    if ((config->freq_hz <= 0.0f) || (config->period_s <= 0.0f) || (config->zeta < 0.0f) || (config->zeta >= 1.0f))
+    {
+        return false;
+    }
+
+    /* Damped period and the decay of the mode over half of it. */
+    float32_t root;
+    arm_sqrt_f32(1.0f - (config->zeta * config->zeta), &root);
+    float32_t k = expf(-(config->zeta * PI) / root);
+    float32_t half_period = 0.5f / (config->freq_hz * root);
+    float32_t a[SHAPER_MAX_IMPULSES];
+    uint16_t n;
+
+    switch (config->type)
+    {
+        case SHAPER_TYPE__ZV:
+            a[0] = 1.0f;
+            a[1] = k;
+            n = 2;
+            break;
+        case SHAPER_TYPE__ZVD:
+            a[0] = 1.0f;
+            a[1] = 2.0f * k;
+            a[2] = k * k;
+            n = 3;
+            break;
+        case SHAPER_TYPE__EI:
+        default:
+            a[0] = 0.25f * (1.0f + SHAPER_EI_VIBRATION);
+            a[1] = 0.5f * (1.0f - SHAPER_EI_VIBRATION) * k;
+            a[2] = a[0] * k * k;
+            n = 3;
+            break;
+    }
+
+    float32_t sum = 0.0f;
+    for (uint16_t i = 0; i < n; i++)
+    {
+        sum += a[i];
+    }
+    for (uint16_t i = 0; i < n; i++)
+    {
+        design->amplitudes[i] = a[i] / sum;
+        design->delays[i] = (int32_t)(((float32_t)i * half_period / config->period_s) + 0.5f);
+    }
+    design->num_impulses = n;
+    return true;
+}
+
+void shaper_init(SHAPER_t *shaper, float32_t *state, uint16_t max_delay, float32_t value)
+{
+    shaper->state = state;
+    shaper->max_delay = max_delay;
+    shaper->design.type = SHAPER_TYPE__NONE;
+    shaper->design.num_impulses = 1;
+    shaper->design.amplitudes[0] = 1.0f;
+    shaper->design.delays[0] = 0;
+    arm_fir_sparse_init_f32(&shaper->instance, shaper->design.num_impulses, shaper->design.amplitudes,
+                            shaper->state, shaper->design.delays, shaper->max_delay, 1);
+    shaper_reset(shaper, value);
+}
+
+bool shaper_set_design(SHAPER_t *shaper, const SHAPER_DESIGN_t *design)
+{
+    if ((design->delays[design->num_impulses - 1] > (int32_t)shaper->max_delay) || (shaper_is_settled(shaper) == false))
+    {
+        return false;
+    }
+
+    /**
+     * The sparse FIR filter's coefficients are in time order: its output is
+     * the sum of amplitudes[i] x input[n - delays[i]].
+     */
+    shaper->design = *design;
+    arm_fir_sparse_init_f32(&shaper->instance, shaper->design.num_impulses, shaper->design.amplitudes,
+                            shaper->state, shaper->design.delays, shaper->max_delay, 1);
+    shaper_reset(shaper, shaper->input_prev);
+    return true;
+}
+
+void shaper_reset(SHAPER_t *shaper, float32_t value)
+{
+    for (uint32_t i = 0; i < ((uint32_t)shaper->max_delay + 1); i++)
+    {
+        shaper->state[i] = value;
+    }
+    shaper->input_prev = value;
+    shaper->held = shaper->max_delay;
+}
+
+float32_t shaper_update(SHAPER_t *shaper, float32_t input)
+{
+    float32_t output;
+    float32_t scratch;
+
+    if (input != shaper->input_prev)
+    {
+        shaper->held = 0;
+    }
+    else if (shaper->held < shaper->max_delay)
+    {
+        shaper->held++;
+    }
+    shaper->input_prev = input;
+    if (shaper->design.type == SHAPER_TYPE__NONE)
+    {
+        return input;
+    }
+    arm_fir_sparse_f32(&shaper->instance, &input, &output, &scratch, 1);
+    return output;
+}
+
+bool shaper_is_settled(const SHAPER_t *shaper)
+{
+    return (shaper->held >= (uint32_t)shaper->design.delays[shaper->design.num_impulses - 1]);
+}
+
+/*============================================================================*/
\ No newline at end of file
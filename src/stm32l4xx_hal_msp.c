@@ -4,8 +4,29 @@
  ******************************************************************************/
 
 #include "main.h"
+#include "adc.h"
+#include "timer.h"
 #include "usart.h"
 
+/* ADC1 DMA (circular, potentiometer feedback acquisition). */
+static DMA_HandleTypeDef _hdma_adc1;
+
+/* USART2 Rx DMA (circular, virtual COM port reception). */
+static DMA_HandleTypeDef _hdma_usart2_rx;
+
+#if (TIMER_PWM_DMA_BURST == 1)
+/* PWM timer update event DMA (burst writes of the TIMx_CCRy registers). */
+static DMA_HandleTypeDef _hdma_tim2_up;
+static DMA_HandleTypeDef _hdma_tim15_up;
+static DMA_HandleTypeDef _hdma_tim16_up;
+
+/*===== Private Function Prototypes ==========================================*/
+static void tim_pwm_dma_init(TIM_HandleTypeDef *tim_pwmHandle,
+                             DMA_HandleTypeDef *hdma,
+                             DMA_Channel_TypeDef *channel,
+                             uint32_t request);
+#endif
+
 /**
  * @brief  Global MSP initialisation.
  * @retval None.
@@ -22,8 +43,92 @@ void HAL_MspInit(void)
     HAL_NVIC_SetPriority(SysTick_IRQn, 15, 0);
 }
 
+/**
+ * @brief  ADC MSP initialisation.
+ * @note   The ADC channel GPIOs are configured by the servo motor driver.
+ * @param  adcHandle: ADC handle.
+ * @retval None.
+ */
+void HAL_ADC_MspInit(ADC_HandleTypeDef *adcHandle)
+{
+    if (adcHandle->Instance == ADC1)
+    {
+        __HAL_RCC_ADC_CLK_ENABLE();
+        __HAL_RCC_DMA1_CLK_ENABLE();
+
+        /* ADC1 DMA init: DMA1 channel 1, request 0. */
+        _hdma_adc1.Instance = DMA1_Channel1;
+        _hdma_adc1.Init.Request = DMA_REQUEST_0;
+        _hdma_adc1.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        _hdma_adc1.Init.PeriphInc = DMA_PINC_DISABLE;
+        _hdma_adc1.Init.MemInc = DMA_MINC_ENABLE;
+        _hdma_adc1.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        _hdma_adc1.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+        _hdma_adc1.Init.Mode = DMA_CIRCULAR;
+        _hdma_adc1.Init.Priority = DMA_PRIORITY_MEDIUM;
+        if (HAL_DMA_Init(&_hdma_adc1) != HAL_OK)
+        {
+            error_handler();
+        }
+        __HAL_LINKDMA(adcHandle, DMA_Handle, _hdma_adc1);
+
+        /* DMA interrupt init (half/full transfer). */
+        HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, ADC_DMA_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    }
+}
+
+/**
+ * @brief  ADC MSP deinitialisation.
+ * @param  adcHandle: ADC handle.
+ * @retval None.
+ */
+void HAL_ADC_MspDeInit(ADC_HandleTypeDef *adcHandle)
+{
+    if (adcHandle->Instance == ADC1)
+    {
+        /* Peripheral clock and interrupt disable. */
+        __HAL_RCC_ADC_CLK_DISABLE();
+        HAL_DMA_DeInit(adcHandle->DMA_Handle);
+        HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    }
+}
+
+/**
+ * @brief  TIM base MSP initialisation.
+ * @param  tim_baseHandle: TIM base handle.
+ * @retval None.
+ */
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *tim_baseHandle)
+{
+    if (tim_baseHandle->Instance == TIM6)
+    {
+        __HAL_RCC_TIM6_CLK_ENABLE();
+
+        /* TIM6 interrupt init (servo motor control loop time base). */
+        HAL_NVIC_SetPriority(TIM6_DAC_IRQn, TIMER_TIM6_CTRL_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
+    }
+}
+
+/**
+ * @brief  TIM base MSP deinitialisation.
+ * @param  tim_baseHandle: TIM base handle.
+ * @retval None.
+ */
+void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef *tim_baseHandle)
+{
+    if (tim_baseHandle->Instance == TIM6)
+    {
+        /* Peripheral clock and interrupt disable. */
+        __HAL_RCC_TIM6_CLK_DISABLE();
+        HAL_NVIC_DisableIRQ(TIM6_DAC_IRQn);
+    }
+}
+
 /**
  * @brief  TIM PWM MSP initialisation.
+ * @note   The PWM channel GPIOs are configured by the servo motor driver.
  * @param  tim_pwmHandle: TIM PWM handle.
  * @retval None.
  */
@@ -32,6 +137,33 @@ void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *tim_pwmHandle)
     if (tim_pwmHandle->Instance == TIM2)
     {
         __HAL_RCC_TIM2_CLK_ENABLE();
+
+        /* TIM2 interrupt init (PWM frame update event). */
+        HAL_NVIC_SetPriority(TIM2_IRQn, TIMER_TIM2_FRAME_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+#if (TIMER_PWM_DMA_BURST == 1)
+        /* TIM2_UP DMA init: DMA1 channel 2, request 4. */
+        tim_pwm_dma_init(tim_pwmHandle, &_hdma_tim2_up, DMA1_Channel2, DMA_REQUEST_4);
+#endif
+    }
+    else if (tim_pwmHandle->Instance == TIM15)
+    {
+        __HAL_RCC_TIM15_CLK_ENABLE();
+
+#if (TIMER_PWM_DMA_BURST == 1)
+        /* TIM15_UP DMA init: DMA1 channel 5, request 7. */
+        tim_pwm_dma_init(tim_pwmHandle, &_hdma_tim15_up, DMA1_Channel5, DMA_REQUEST_7);
+#endif
+    }
+    else if (tim_pwmHandle->Instance == TIM16)
+    {
+        __HAL_RCC_TIM16_CLK_ENABLE();
+
+#if (TIMER_PWM_DMA_BURST == 1)
+        /* TIM16_UP DMA init: DMA1 channel 3, request 4. */
+        tim_pwm_dma_init(tim_pwmHandle, &_hdma_tim16_up, DMA1_Channel3, DMA_REQUEST_4);
+#endif
     }
 }
 
@@ -42,37 +174,24 @@ void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *tim_pwmHandle)
  */
 void HAL_TIM_PWM_MspDeInit(TIM_HandleTypeDef *tim_pwmHandle)
 {
+    /* Peripheral clock disable */
     if (tim_pwmHandle->Instance == TIM2)
     {
-        /* Peripheral clock disable */
         __HAL_RCC_TIM2_CLK_DISABLE();
+        HAL_NVIC_DisableIRQ(TIM2_IRQn);
     }
-}
-
-/**
- * @brief  TIM MSP post initialisation.
- * @param  timHandle: TIM handle.
- * @retval None.
- */
-void HAL_TIM_MspPostInit(TIM_HandleTypeDef *timHandle)
-{
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-
-    if (timHandle->Instance == TIM2)
+    else if (tim_pwmHandle->Instance == TIM15)
     {
-        __HAL_RCC_GPIOA_CLK_ENABLE();
-
-        /**
-         * TIM2 GPIO Configuration
-         *     - PA0: TIM2_CH1
-         */
-        GPIO_InitStruct.Pin = GPIO_DEFS__PIN_SERVO_MOTOR_PWM;
-        GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
-        GPIO_InitStruct.Pull = GPIO_NOPULL;
-        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
-        GPIO_InitStruct.Alternate = GPIO_AF1_TIM2;
-        HAL_GPIO_Init(GPIO_DEFS__PORT_SERVO_MOTOR_PWM, &GPIO_InitStruct);
+        __HAL_RCC_TIM15_CLK_DISABLE();
+    }
+    else if (tim_pwmHandle->Instance == TIM16)
+    {
+        __HAL_RCC_TIM16_CLK_DISABLE();
     }
+
+#if (TIMER_PWM_DMA_BURST == 1)
+    HAL_DMA_DeInit(tim_pwmHandle->hdma[TIM_DMA_ID_UPDATE]);
+#endif
 }
 
 /**
@@ -121,6 +240,27 @@ void HAL_UART_MspInit(UART_HandleTypeDef *uartHandle)
         GPIO_DEFS__CLK_EN_USART2_RX();
         GPIO_InitStruct.Pin = GPIO_DEFS__PIN_USART2_RX;
         HAL_GPIO_Init(GPIO_DEFS__PORT_USART2_RX, &GPIO_InitStruct);
+
+        /**
+         * USART2 Rx DMA init: DMA1 channel 6, request 2; circular (see
+         * usart_rx). The DMA channel interrupt is not enabled in the NVIC;
+         * the received data is polled.
+         */
+        __HAL_RCC_DMA1_CLK_ENABLE();
+        _hdma_usart2_rx.Instance = DMA1_Channel6;
+        _hdma_usart2_rx.Init.Request = DMA_REQUEST_2;
+        _hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        _hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+        _hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+        _hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        _hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        _hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+        _hdma_usart2_rx.Init.Priority = DMA_PRIORITY_LOW;
+        if (HAL_DMA_Init(&_hdma_usart2_rx) != HAL_OK)
+        {
+            error_handler();
+        }
+        __HAL_LINKDMA(uartHandle, hdmarx, _hdma_usart2_rx);
     }
 }
 
@@ -149,7 +289,50 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef *uartHandle)
          */
         HAL_GPIO_DeInit(GPIO_DEFS__PORT_USART2_TX, GPIO_DEFS__PIN_USART2_TX);
         HAL_GPIO_DeInit(GPIO_DEFS__PORT_USART2_RX, GPIO_DEFS__PIN_USART2_RX);
+
+        /* Rx DMA deinit. */
+        HAL_DMA_DeInit(uartHandle->hdmarx);
+    }
+}
+
+#if (TIMER_PWM_DMA_BURST == 1)
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  PWM timer update event DMA initialisation: circular, memory to
+ *         TIMx_DMAR (see timer_pwm_dma_burst_start).
+ * @note   The DMA channel interrupt is not enabled in the NVIC; the transfers
+ *         run without CPU involvement.
+ * @param  tim_pwmHandle: TIM PWM handle.
+ * @param  hdma:          DMA handle.
+ * @param  channel:       DMA channel; DMA1_Channelx.
+ * @param  request:       DMA request; DMA_REQUEST_x.
+ * @retval None.
+ */
+static void tim_pwm_dma_init(TIM_HandleTypeDef *tim_pwmHandle,
+                             DMA_HandleTypeDef *hdma,
+                             DMA_Channel_TypeDef *channel,
+                             uint32_t request)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    hdma->Instance = channel;
+    hdma->Init.Request = request;
+    hdma->Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    hdma->Init.Mode = DMA_CIRCULAR;
+    hdma->Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(hdma) != HAL_OK)
+    {
+        error_handler();
     }
+    __HAL_LINKDMA(tim_pwmHandle, hdma[TIM_DMA_ID_UPDATE], *hdma);
 }
+#endif
 
 /*============================================================================*/
\ No newline at end of file
@@ -70,10 +70,28 @@ void SysTick_Handler(void)
 /* interrupt handler names.                                                   */
 /*============================================================================*/
 
-void TIM1_UP_TIM16_IRQHandler(void)
+void TIM7_IRQHandler(void)
 {
-    extern TIM_HandleTypeDef htim16;
-    HAL_TIM_IRQHandler(&htim16);
+    extern TIM_HandleTypeDef htim7;
+    HAL_TIM_IRQHandler(&htim7);
+}
+
+void TIM6_DAC_IRQHandler(void)
+{
+    extern TIM_HandleTypeDef htim6;
+    HAL_TIM_IRQHandler(&htim6);
+}
+
+void TIM2_IRQHandler(void)
+{
+    extern TIM_HandleTypeDef htim2;
+    HAL_TIM_IRQHandler(&htim2);
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+    extern ADC_HandleTypeDef hadc1;
+    HAL_DMA_IRQHandler(hadc1.DMA_Handle);
 }
 
 /*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,299 @@
+/*******************************************************************************
+ * @file   stream.c
+ * @brief  Setpoint stream (timestamped waypoint interpolation) source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "stream.h"
+
+/*===== C Standard Library =====*/
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+/**
+ * Memory barrier between a waypoint slot access and the index publishing it
+ * (producer) or covering it (consumer).
+ */
+#define STREAM_BARRIER()            __sync_synchronize()
+
+#define SLOT(stream, index)         (&(stream)->queue[(index) & (STREAM_QUEUE_LEN - 1)])
+
+/*===== Private Function Prototypes ==========================================*/
+static bool start_segment(STREAM_t *stream, uint32_t *fill);
+static float32_t tangent(const STREAM_WAYPOINT_t *a, const STREAM_WAYPOINT_t *b, uint32_t axis);
+static void hold(const STREAM_t *stream, int32_t *position);
+static void pop(STREAM_t *stream, uint32_t *fill);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void stream_init(STREAM_t *stream, uint32_t rate_hz, uint32_t num_axes, STREAM_INTERP_t interp)
+{
+    memset(stream, 0, sizeof(*stream));
+    stream->interp = interp;
+    stream->num_axes = (num_axes > STREAM_MAX_AXES) ? STREAM_MAX_AXES : num_axes;
+    stream->tick_us = 1000000 / rate_hz;
+    stream->state = STREAM_STATE__IDLE;
+    stream->fill_min = STREAM_QUEUE_LEN;
+}
+
+bool stream_push(STREAM_t *stream, const STREAM_WAYPOINT_t *waypoint)
+{
+    uint32_t head = stream->head;
+
+    if ((head - stream->tail) >= STREAM_QUEUE_LEN)
+    {
+        stream->overrun_count++;
+        return false;
+    }
+
+    *SLOT(stream, head) = *waypoint;
+    STREAM_BARRIER();
+    stream->head = head + 1;
+
+    return true;
+}
+
+bool stream_next(STREAM_t *stream, int32_t *position)
+{
+    uint32_t fill = stream->head - stream->tail;
+    STREAM_BARRIER();
+
+    switch (stream->state)
+    {
+        case STREAM_STATE__IDLE:
+            if (fill < STREAM_PREFILL)
+            {
+                return false;
+            }
+            stream->have_prev = false; /* Start from rest. */
+            if (start_segment(stream, &fill) == false)
+            {
+                return false;
+            }
+            stream->time_us = stream->seg_t0;
+            stream->state = STREAM_STATE__ACTIVE;
+            break;
+
+        case STREAM_STATE__STARVED:
+            if (fill < 2)
+            {
+                stream->starved_us += stream->tick_us;
+                if (stream->starved_us >= STREAM_TIMEOUT_US)
+                {
+                    /* Stream ended: the last waypoint remains the caller's setpoint. */
+                    pop(stream, &fill);
+                    stream->state = STREAM_STATE__IDLE;
+                    return false;
+                }
+                hold(stream, position);
+                return true;
+            }
+            /* Resume from rest at the held waypoint (playback time was paused there). */
+            stream->have_prev = false;
+            if (start_segment(stream, &fill) == false)
+            {
+                if (stream->state == STREAM_STATE__IDLE)
+                {
+                    return false;
+                }
+                hold(stream, position);
+                return true;
+            }
+            stream->state = STREAM_STATE__ACTIVE;
+            break;
+
+        case STREAM_STATE__ACTIVE:
+        default:
+            stream->time_us += stream->tick_us;
+            while ((int32_t)(stream->time_us - stream->seg_t1) >= 0)
+            {
+                stream->prev = *SLOT(stream, stream->tail);
+                stream->have_prev = true;
+                pop(stream, &fill);
+                if (start_segment(stream, &fill) == false)
+                {
+                    if (stream->state == STREAM_STATE__IDLE)
+                    {
+                        return false;
+                    }
+                    /* Underrun: hold the reached waypoint, pause playback time. */
+                    stream->state = STREAM_STATE__STARVED;
+                    stream->starved_us = 0;
+                    stream->time_us = SLOT(stream, stream->tail)->timestamp_us;
+                    stream->underrun_count++;
+                    hold(stream, position);
+                    return true;
+                }
+            }
+            break;
+    }
+
+    /* Evaluate the current segment (Horner's method). */
+    const STREAM_WAYPOINT_t *p0 = SLOT(stream, stream->tail);
+    float32_t u = (float32_t)(int32_t)(stream->time_us - stream->seg_t0) * stream->seg_inv_dt;
+    for (uint32_t i = 0; i < stream->num_axes; i++)
+    {
+        float32_t delta = ((stream->c3[i] * u + stream->c2[i]) * u + stream->c1[i]) * u;
+        position[i] = p0->position[i] + (int32_t)delta;
+    }
+
+    if (fill < stream->fill_min)
+    {
+        stream->fill_min = fill;
+    }
+
+    return true;
+}
+
+bool stream_is_active(const STREAM_t *stream)
+{
+    return (stream->state != STREAM_STATE__IDLE);
+}
+
+void stream_get_stats(const STREAM_t *stream, STREAM_STATS_t *stats)
+{
+    stats->state = stream->state;
+    stats->fill = stream->head - stream->tail;
+    stats->fill_min = stream->fill_min;
+    stats->underrun_count = stream->underrun_count;
+    stats->overrun_count = stream->overrun_count;
+    stats->discard_count = stream->discard_count;
+}
+
+void stream_reset_fill_min(STREAM_t *stream)
+{
+    stream->fill_min = STREAM_QUEUE_LEN;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Start the segment from the waypoint at the tail to the next one:
+ *         discards following waypoints not later than the tail's, and drops
+ *         the tail's (new stream, idle) if the next is more than
+ *         STREAM_MAX_GAP_US later. The cubic tangents are from the preceding
+ *         waypoint (if any, else zero) and the following waypoint (if
+ *         buffered, else zero, i.e. come to rest).
+ * @param  stream: Stream.
+ * @param  fill:   Buffered waypoints; updated. Passed by reference.
+ * @retval Boolean indicating whether a segment was started: false if fewer
+ *         than two waypoints are buffered or a new stream starts.
+ */
+static bool start_segment(STREAM_t *stream, uint32_t *fill)
+{
+    STREAM_WAYPOINT_t *p0;
+    STREAM_WAYPOINT_t *p1;
+    int32_t dt;
+
+    while (1)
+    {
+        if (*fill < 2)
+        {
+            return false;
+        }
+        p0 = SLOT(stream, stream->tail);
+        p1 = SLOT(stream, stream->tail + 1);
+        dt = (int32_t)(p1->timestamp_us - p0->timestamp_us);
+        if (dt > 0)
+        {
+            break;
+        }
+        /* Discard p1: the consumer owns the occupied slots, so shift p0 up over it. */
+        *p1 = *p0;
+        pop(stream, fill);
+        stream->discard_count++;
+    }
+
+    if (dt > STREAM_MAX_GAP_US)
+    {
+        pop(stream, fill);
+        stream->state = STREAM_STATE__IDLE;
+        return false;
+    }
+
+    stream->seg_t0 = p0->timestamp_us;
+    stream->seg_t1 = p1->timestamp_us;
+    stream->seg_inv_dt = 1.0f / (float32_t)dt;
+
+    const STREAM_WAYPOINT_t *p2 = NULL;
+    if (*fill >= 3)
+    {
+        p2 = SLOT(stream, stream->tail + 2);
+        int32_t dt2 = (int32_t)(p2->timestamp_us - p1->timestamp_us);
+        if ((dt2 <= 0) || (dt2 > STREAM_MAX_GAP_US))
+        {
+            p2 = NULL;
+        }
+    }
+
+    for (uint32_t i = 0; i < stream->num_axes; i++)
+    {
+        float32_t d = (float32_t)(p1->position[i] - p0->position[i]);
+
+        if (stream->interp == STREAM_INTERP__LINEAR)
+        {
+            stream->c1[i] = d;
+            stream->c2[i] = 0.0f;
+            stream->c3[i] = 0.0f;
+        }
+        else
+        {
+            /* Hermite basis with the tangents scaled to the segment duration. */
+            float32_t m0 = stream->have_prev ? tangent(&stream->prev, p1, i) * (float32_t)dt : 0.0f;
+            float32_t m1 = (p2 != NULL) ? tangent(p0, p2, i) * (float32_t)dt : 0.0f;
+            stream->c1[i] = m0;
+            stream->c2[i] = (3.0f * d) - (2.0f * m0) - m1;
+            stream->c3[i] = (-2.0f * d) + m0 + m1;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief  Catmull-Rom tangent: slope between the waypoints either side.
+ * @param  a:    Preceding waypoint.
+ * @param  b:    Following waypoint (later than @param a).
+ * @param  axis: Axis.
+ * @retval Slope (Q16.16 per us).
+ */
+static float32_t tangent(const STREAM_WAYPOINT_t *a, const STREAM_WAYPOINT_t *b, uint32_t axis)
+{
+    return (float32_t)(b->position[axis] - a->position[axis]) / (float32_t)(int32_t)(b->timestamp_us - a->timestamp_us);
+}
+
+/**
+ * @brief  Output the waypoint at the tail.
+ * @param  stream:   Stream.
+ * @param  position: Positions. Passed by reference.
+ * @retval None.
+ */
+static void hold(const STREAM_t *stream, int32_t *position)
+{
+    const STREAM_WAYPOINT_t *p0 = SLOT(stream, stream->tail);
+
+    for (uint32_t i = 0; i < stream->num_axes; i++)
+    {
+        position[i] = p0->position[i];
+    }
+}
+
+/**
+ * @brief  Release the waypoint at the tail to the producer.
+ * @param  stream: Stream.
+ * @param  fill:   Buffered waypoints; updated. Passed by reference.
+ * @retval None.
+ */
+static void pop(STREAM_t *stream, uint32_t *fill)
+{
+    STREAM_BARRIER();
+    stream->tail = stream->tail + 1;
+    (*fill)--;
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * @file   sysid.c
+ * @brief  System identification (frequency response) source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "sysid.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+#define SYSID_PRBS_SEED             0x1FFu  /* 9-bit LFSR; any non-zero state. */
+
+/**
+ * Length specific real FFT initialisation, such that only the tables for
+ * SYSID_LEN are linked (arm_rfft_fast_init_f32 references all lengths').
+ */
+#if SYSID_LEN == 256
+#define SYSID_RFFT_INIT             arm_rfft_256_fast_init_f32
+#elif SYSID_LEN == 512
+#define SYSID_RFFT_INIT             arm_rfft_512_fast_init_f32
+#else
+#define SYSID_RFFT_INIT             arm_rfft_1024_fast_init_f32
+#endif
+
+/*===== Private Function Prototypes ==========================================*/
+static float32_t excitation(SYSID_t *sysid);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void sysid_start(SYSID_t *sysid, const SYSID_CONFIG_t *config, float32_t centre)
+{
+    memset(sysid, 0, sizeof(*sysid));
+    sysid->config = *config;
+    if (sysid->config.prbs_hold < 1)
+    {
+        sysid->config.prbs_hold = 1;
+    }
+    if (sysid->config.periods < 1)
+    {
+        sysid->config.periods = 1;
+    }
+    sysid->centre = centre;
+    sysid->excitation = excitation(sysid);
+    sysid->state = SYSID_STATE__RUNNING;
+}
+
+float32_t sysid_update(SYSID_t *sysid, float32_t feedback)
+{
+    if (sysid->state != SYSID_STATE__RUNNING)
+    {
+        return 0.0f;
+    }
+
+    /* The feedback is the response to the excitation output since the previous update. */
+    if (sysid->period >= sysid->config.settle_periods)
+    {
+        sysid->input[sysid->index] += sysid->excitation;
+        sysid->output[sysid->index] += feedback - sysid->centre;
+    }
+
+    sysid->index++;
+    if (sysid->index == SYSID_LEN)
+    {
+        sysid->index = 0;
+        sysid->period++;
+        if (sysid->period == (sysid->config.settle_periods + sysid->config.periods))
+        {
+            sysid->excitation = 0.0f;
+            sysid->state = SYSID_STATE__CAPTURED;
+            return 0.0f;
+        }
+    }
+    sysid->excitation = excitation(sysid);
+
+    return sysid->excitation;
+}
+
+void sysid_abort(SYSID_t *sysid)
+{
+    if (sysid->state == SYSID_STATE__RUNNING)
+    {
+        sysid->excitation = 0.0f;
+        sysid->state = SYSID_STATE__FAILED;
+    }
+}
+
+bool sysid_compute(SYSID_t *sysid)
+{
+    arm_rfft_fast_instance_f32 fft;
+
+    if (sysid->state != SYSID_STATE__CAPTURED)
+    {
+        return false;
+    }
+
+    /**
+     * Spectra: U into the work buffer, then Y into the input buffer (the FFT
+     * modifies its source buffer). Packed as [DC, Nyquist, re(1), im(1), ...].
+     */
+    SYSID_RFFT_INIT(&fft);
+    arm_rfft_fast_f32(&fft, sysid->input, sysid->work, 0);
+    arm_rfft_fast_f32(&fft, sysid->output, sysid->input, 0);
+
+    float32_t power_max = 0.0f;
+    for (uint32_t k = 1; k < SYSID_NUM_BINS; k++)
+    {
+        float32_t power = (sysid->work[2 * k] * sysid->work[2 * k]) + (sysid->work[(2 * k) + 1] * sysid->work[(2 * k) + 1]);
+        power_max = (power > power_max) ? power : power_max;
+    }
+
+    /**
+     * H = Y conj(U) / |U|^2. The results are written to index k whilst the
+     * spectra are read from indices 2k and 2k + 1, i.e. in place in
+     * ascending order.
+     */
+    float32_t phase_prev = 0.0f;
+    float32_t phase_offset = 0.0f;
+    sysid->excited[0] = false;
+    for (uint32_t k = 1; k < SYSID_NUM_BINS; k++)
+    {
+        float32_t ur = sysid->work[2 * k];
+        float32_t ui = sysid->work[(2 * k) + 1];
+        float32_t yr = sysid->input[2 * k];
+        float32_t yi = sysid->input[(2 * k) + 1];
+        float32_t power = (ur * ur) + (ui * ui);
+
+        sysid->excited[k] = (power > 0.0f) && (power >= (SYSID_MIN_INPUT_RATIO * power_max));
+        if (sysid->excited[k] == false)
+        {
+            continue;
+        }
+
+        float32_t hr = ((yr * ur) + (yi * ui)) / power;
+        float32_t hi = ((yi * ur) - (yr * ui)) / power;
+        float32_t phase = atan2f(hi, hr) * (180.0f / PI);
+
+        /* Unwrap: the step from the previous excited bin within +/-180 degrees. */
+        phase += phase_offset;
+        while ((phase - phase_prev) > 180.0f)
+        {
+            phase -= 360.0f;
+            phase_offset -= 360.0f;
+        }
+        while ((phase - phase_prev) < -180.0f)
+        {
+            phase += 360.0f;
+            phase_offset += 360.0f;
+        }
+        phase_prev = phase;
+
+        sysid->output[k] = 10.0f * log10f((hr * hr) + (hi * hi));
+        sysid->input[k] = phase;
+    }
+
+    sysid->state = SYSID_STATE__DONE;
+
+    return true;
+}
+
+SYSID_STATE_t sysid_get_state(const SYSID_t *sysid)
+{
+    return sysid->state;
+}
+
+bool sysid_get_bin(const SYSID_t *sysid, uint32_t bin, SYSID_BIN_t *result)
+{
+    if ((sysid->state != SYSID_STATE__DONE) || (bin >= SYSID_NUM_BINS) || (sysid->excited[bin] == false))
+    {
+        return false;
+    }
+
+    result->freq_hz = (float32_t)bin / ((float32_t)SYSID_LEN * sysid->config.period_s);
+    result->mag_db = sysid->output[bin];
+    result->phase_deg = sysid->input[bin];
+
+    return true;
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Excitation at the current index: the chirp from its phase
+ *         (cycles) f_min t + (f_max - f_min) t^2 / (2 T); the PRBS from the
+ *         LFSR (x^9 + x^5 + 1), which is restarted at index 0 and shifted
+ *         every prbs_hold samples.
+ * @param  sysid: Identifier.
+ * @retval Excitation.
+ */
+static float32_t excitation(SYSID_t *sysid)
+{
+    const SYSID_CONFIG_t *config = &sysid->config;
+
+    if (config->signal == SYSID_SIGNAL__PRBS)
+    {
+        if (sysid->index == 0)
+        {
+            sysid->lfsr = SYSID_PRBS_SEED;
+        }
+        else if ((sysid->index % config->prbs_hold) == 0)
+        {
+            uint16_t bit = ((sysid->lfsr >> 8) ^ (sysid->lfsr >> 4)) & 1u;
+            sysid->lfsr = (uint16_t)(((sysid->lfsr << 1) | bit) & 0x1FFu);
+        }
+        return (sysid->lfsr & 1u) ? config->amplitude : -config->amplitude;
+    }
+
+    float32_t t = (float32_t)sysid->index * config->period_s;
+    float32_t duration = (float32_t)SYSID_LEN * config->period_s;
+    float32_t cycles = (config->f_min_hz * t) + (((config->f_max_hz - config->f_min_hz) * t * t) / (2.0f * duration));
+    cycles -= (float32_t)(uint32_t)cycles;
+
+    return config->amplitude * arm_sin_f32(2.0f * PI * cycles);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -6,8 +6,14 @@
 #include "timer.h"
 
 TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim6;
+TIM_HandleTypeDef htim7;
+TIM_HandleTypeDef htim15;
 TIM_HandleTypeDef htim16;
 
+/*===== Private Function Prototypes ==========================================*/
+static TIM_HandleTypeDef *get_pwm_handle(TIMER_PWM_ID_t id);
+
 /*============================================================================*/
 /*===== Public Functions =====================================================*/
 /*============================================================================*/
@@ -22,48 +28,48 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
     uint32_t pFLatency;
     HAL_StatusTypeDef status = HAL_OK;
 
-    /* Enable TIM16 clock. */
-    __HAL_RCC_TIM16_CLK_ENABLE();
+    /* Enable TIM7 clock. */
+    __HAL_RCC_TIM7_CLK_ENABLE();
 
     /* Get clock configuration. */
     HAL_RCC_GetClockConfig(&clkconfig, &pFLatency);
 
-    /* Compute TIM16 clock. */
-    uwTimclock = HAL_RCC_GetPCLK2Freq();
+    /* Compute TIM7 clock. */
+    uwTimclock = HAL_RCC_GetPCLK1Freq();
 
-    /* Compute the prescaler value to have TIM16 counter clock equal to 1 MHz. */
+    /* Compute the prescaler value to have TIM7 counter clock equal to 1 MHz. */
     uwPrescalerValue = (uint32_t)((uwTimclock / 1000000U) - 1U);
 
-    /* Initialize TIM16. */
-    htim16.Instance = TIM16;
+    /* Initialize TIM7. */
+    htim7.Instance = TIM7;
 
     /**
-     * Initialise TIM16 peripheral:
-     *     - Period = [(TIM16CLK/1000) - 1] to have a (1/1000) s time base.
+     * Initialise TIM7 peripheral:
+     *     - Period = [(TIM7CLK/1000) - 1] to have a (1/1000) s time base.
      *     - Prescaler = (uwTimclock/1000000 - 1) to have a 1 MHz counter clock.
      *     - ClockDivision = 0.
      *     - Counter direction = Up.
      */
-    htim16.Init.Period = (1000000U / 1000U) - 1U;
-    htim16.Init.Prescaler = uwPrescalerValue;
-    htim16.Init.ClockDivision = 0;
-    htim16.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim16.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    htim7.Init.Period = (1000000U / 1000U) - 1U;
+    htim7.Init.Prescaler = uwPrescalerValue;
+    htim7.Init.ClockDivision = 0;
+    htim7.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim7.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
 
-    status = HAL_TIM_Base_Init(&htim16);
+    status = HAL_TIM_Base_Init(&htim7);
     if (status == HAL_OK)
     {
         /* Start the TIM time base generation in interrupt mode. */
-        status = HAL_TIM_Base_Start_IT(&htim16);
+        status = HAL_TIM_Base_Start_IT(&htim7);
         if (status == HAL_OK)
         {
-            /* Enable the TIM16 global interrupt. */
-            HAL_NVIC_EnableIRQ(TIM1_UP_TIM16_IRQn);
+            /* Enable the TIM7 global interrupt. */
+            HAL_NVIC_EnableIRQ(TIM7_IRQn);
             /* Configure the SysTick IRQ priority. */
             if (TickPriority < (1UL << __NVIC_PRIO_BITS))
             {
-                /* Configure the TIM16 IRQ priority. */
-                HAL_NVIC_SetPriority(TIM1_UP_TIM16_IRQn, TickPriority, 0U);
+                /* Configure the TIM7 IRQ priority. */
+                HAL_NVIC_SetPriority(TIM7_IRQn, TickPriority, 0U);
                 uwTickPrio = TickPriority;
             }
             else
@@ -79,89 +85,348 @@ HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 
 void HAL_SuspendTick(void)
 {
-    /* Disable the TIM16 update interrupt. */
-    __HAL_TIM_DISABLE_IT(&htim16, TIM_IT_UPDATE);
+    /* Disable the TIM7 update interrupt. */
+    __HAL_TIM_DISABLE_IT(&htim7, TIM_IT_UPDATE);
 }
 
 void HAL_ResumeTick(void)
 {
-    /* Enable the TIM16 update interrupt. */
-    __HAL_TIM_ENABLE_IT(&htim16, TIM_IT_UPDATE);
+    /* Enable the TIM7 update interrupt. */
+    __HAL_TIM_ENABLE_IT(&htim7, TIM_IT_UPDATE);
 }
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
     /**
-     * TIM16 used as the STM32 HAL SYS time base source. Call HAL_IncTick()  
+     * TIM7 used as the STM32 HAL SYS time base source. Call HAL_IncTick()  
      * to increment uwTick which is used as the HAL time base.
      */ 
-    if (htim->Instance == TIM16)
+    if (htim->Instance == TIM7)
     {
         HAL_IncTick();
     }
+    else if (htim->Instance == TIM6)
+    {
+        timer_tim6_period_elapsed_callback();
+    }
+    else if (htim->Instance == TIM2)
+    {
+        timer_tim2_period_elapsed_callback();
+    }
 }
 
-/*===== TIM2 (Servo Motor PWM) ===============================================*/
+/*===== PWM Timers (Servo Motors) ============================================*/
 
-void timer_tim2_pwm_init(void)
+void timer_pwm_init(TIMER_PWM_ID_t id)
 {
     TIM_MasterConfigTypeDef config_master = {0};
-    TIM_OC_InitTypeDef config_oc = {0};
+    TIM_HandleTypeDef *htim = get_pwm_handle(id);
 
-    htim2.Instance = TIM2;
-    htim2.Init.Prescaler = TIMER_TIM2_PWM_PRESCALER_0INDEXED;
-    htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-    htim2.Init.Period = TIMER_TIM2_PWM_COUNTER_0INDEXED;
-    htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-    htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
-    if (HAL_TIM_PWM_Init(&htim2) != HAL_OK)
+    switch (id)
     {
-        error_handler();
+        case TIMER_PWM_ID__TIM2:
+            htim->Instance = TIM2;
+            htim->Init.Prescaler = TIMER_TIM2_PWM_PRESCALER_0INDEXED;
+            htim->Init.Period = TIMER_TIM2_PWM_COUNTER_0INDEXED;
+            break;
+        case TIMER_PWM_ID__TIM15:
+            htim->Instance = TIM15;
+            htim->Init.Prescaler = TIMER_TIM15_16_PWM_PRESCALER - 1;
+            htim->Init.Period = TIMER_TIM15_16_PWM_COUNTER - 1;
+            break;
+        case TIMER_PWM_ID__TIM16:
+            htim->Instance = TIM16;
+            htim->Init.Prescaler = TIMER_TIM15_16_PWM_PRESCALER - 1;
+            htim->Init.Period = TIMER_TIM15_16_PWM_COUNTER - 1;
+            break;
+        default:
+            error_handler();
+            break;
     }
-    config_master.MasterOutputTrigger = TIM_TRGO_RESET;
-    config_master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
-    if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &config_master) != HAL_OK)
+    htim->Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim->Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    htim->Init.RepetitionCounter = 0;
+    /* TIMx_CCRy preload (OCyPE) is set by HAL_TIM_PWM_ConfigChannel. */
+    htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_PWM_Init(htim) != HAL_OK)
     {
         error_handler();
     }
+    if (IS_TIM_BREAK_INSTANCE(htim->Instance))
+    {
+        /* Off-state (OSSR): a gated channel output drives its inactive level (low) rather than floating. */
+        SET_BIT(htim->Instance->BDTR, TIM_BDTR_OSSR);
+    }
+    if (IS_TIM_MASTER_INSTANCE(htim->Instance))
+    {
+        config_master.MasterOutputTrigger = TIM_TRGO_RESET;
+        config_master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+        if (HAL_TIMEx_MasterConfigSynchronization(htim, &config_master) != HAL_OK)
+        {
+            error_handler();
+        }
+    }
+}
+
+void timer_pwm_channel_init(TIMER_PWM_ID_t id, uint32_t channel)
+{
+    TIM_OC_InitTypeDef config_oc = {0};
+
     config_oc.OCMode = TIM_OCMODE_PWM1;
-    config_oc.Pulse = TIMER_TIM2_PWM_PULSE;
+    config_oc.Pulse = TIMER_PWM_PULSE;
     config_oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+    config_oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
     config_oc.OCFastMode = TIM_OCFAST_DISABLE;
-    if (HAL_TIM_PWM_ConfigChannel(&htim2, &config_oc, TIM_CHANNEL_1) != HAL_OK)
+    config_oc.OCIdleState = TIM_OCIDLESTATE_RESET;
+    config_oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    if (HAL_TIM_PWM_ConfigChannel(get_pwm_handle(id), &config_oc, channel) != HAL_OK)
     {
         error_handler();
     }
+}
+
+void timer_pwm_enable(TIMER_PWM_ID_t id, uint32_t channel, bool state)
+{
+    TIM_HandleTypeDef *htim = get_pwm_handle(id);
 
-    extern void HAL_TIM_MspPostInit(TIM_HandleTypeDef *timHandle);
-    HAL_TIM_MspPostInit(&htim2);
+    /**
+     * Started once (channel output, main output, and counter); from then on
+     * only the channel's output is gated (TIMx_CCER CCyE). HAL_TIM_PWM_Stop
+     * would also stop the counter with the timer's last channel, i.e. the
+     * frame interrupt (TIM2) and the ADC trigger (TIM15) would depend on
+     * which servos are stopped.
+     */
+    if (state && (TIM_CHANNEL_STATE_GET(htim, channel) == HAL_TIM_CHANNEL_STATE_READY))
+    {
+        if (HAL_TIM_PWM_Start(htim, channel) != HAL_OK)
+        {
+            error_handler();
+        }
+    }
+    else
+    {
+        TIM_CCxChannelCmd(htim->Instance, channel, state ? TIM_CCx_ENABLE : TIM_CCx_DISABLE);
+    }
 }
 
-void timer_tim2_pwm_enable(bool state)
+uint32_t timer_pwm_get_counter(TIMER_PWM_ID_t id)
 {
-    if (state)
+    return get_pwm_handle(id)->Init.Period + 1;
+}
+
+volatile uint32_t *timer_pwm_get_ccr(TIMER_PWM_ID_t id, uint32_t channel)
+{
+    TIM_TypeDef *instance = get_pwm_handle(id)->Instance;
+
+    /**
+     * The value in the TIMx_CCRy register determines the duty cycle, where
+     * the value is (0..counter) where counter is the value in the TIMx_ARR
+     * register. For example, counter/2 would give a duty cycle of 50%.
+     */
+    switch (channel)
+    {
+        case TIM_CHANNEL_1: return &instance->CCR1;
+        case TIM_CHANNEL_2: return &instance->CCR2;
+        case TIM_CHANNEL_3: return &instance->CCR3;
+        case TIM_CHANNEL_4: return &instance->CCR4;
+        default:            error_handler(); return NULL;
+    }
+}
+
+void timer_pwm_set_pulse(TIMER_PWM_ID_t id, uint32_t channel, uint32_t pulse)
+{
+    pulse = LIMIT_VAR_MAX(get_pwm_handle(id)->Init.Period, pulse);
+    *timer_pwm_get_ccr(id, channel) = pulse;
+}
+
+void timer_pwm_update_hold(TIMER_PWM_ID_t id, bool hold)
+{
+    TIM_TypeDef *instance = get_pwm_handle(id)->Instance;
+
+    if (hold)
     {
-        HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_1);  
+        SET_BIT(instance->CR1, TIM_CR1_UDIS);
     }
     else
     {
-        HAL_TIM_PWM_Stop(&htim2, TIM_CHANNEL_1);  
+        CLEAR_BIT(instance->CR1, TIM_CR1_UDIS);
     }
 }
 
-void timer_tim2_pwm_set_pulse(uint32_t pulse)
+uint32_t timer_pwm_get_count(TIMER_PWM_ID_t id)
 {
-    pulse = LIMIT_VAR_MAX(TIMER_TIM2_PWM_COUNTER_0INDEXED, pulse);
+    return get_pwm_handle(id)->Instance->CNT;
+}
+
+void timer_pwm_sync(void)
+{
+    TIM_HandleTypeDef *handles[] = {&htim2, &htim15, &htim16};
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < NUM_ARRAY_ELS(handles); i++)
+    {
+        if (handles[i]->Instance != NULL)
+        {
+            handles[i]->Instance->EGR = TIM_EGR_UG;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+void timer_pwm_trigger_init(TIMER_PWM_ID_t id, uint32_t channel, uint32_t offset)
+{
+    TIM_OC_InitTypeDef config_oc = {0};
+    TIM_MasterConfigTypeDef config_master = {0};
+    TIM_HandleTypeDef *htim = get_pwm_handle(id);
+
+    assert(IS_TIM_MASTER_INSTANCE(htim->Instance));
+    assert((offset > 0) && (offset <= htim->Init.Period));
+
+    config_oc.OCMode = TIM_OCMODE_PWM2;
+    config_oc.Pulse = offset;
+    config_oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+    config_oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    config_oc.OCFastMode = TIM_OCFAST_DISABLE;
+    config_oc.OCIdleState = TIM_OCIDLESTATE_RESET;
+    config_oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    if (HAL_TIM_PWM_ConfigChannel(htim, &config_oc, channel) != HAL_OK)
+    {
+        error_handler();
+    }
 
     /**
-     * Set duty cycle by setting TIM2_CCR1 (capture/compare register 1).
-     * 
-     * The value in the TIM2_CCR1 register determines the duty
-     * cycle, where the value is (0..counter) where counter
-     * is the value in the TIM2_ARR register. For example, 
-     * counter/2 would give a duty cycle of 50%.
+     * The channel's output is enabled (TIMx_CCER CCyE) although no pin is
+     * routed to it, such that the timer always has an enabled output
+     * whichever servo channels are stopped (see timer_pwm_enable).
      */
-    TIM2->CCR1 = pulse;
+    TIM_CCxChannelCmd(htim->Instance, channel, TIM_CCx_ENABLE);
+
+    config_master.MasterOutputTrigger = (channel == TIM_CHANNEL_1) ? TIM_TRGO_OC1REF : TIM_TRGO_OC2REF;
+    config_master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(htim, &config_master) != HAL_OK)
+    {
+        error_handler();
+    }
+}
+
+void timer_pwm_dma_burst_start(TIMER_PWM_ID_t id, uint32_t *frame, uint32_t num_channels)
+{
+    TIM_HandleTypeDef *htim = get_pwm_handle(id);
+
+    assert((num_channels >= 1) && (num_channels <= TIMER_PWM_DMA_BURST_MAX_CHANNELS));
+
+    /* Compare preload off; the burst at the update event is the latch. */
+    CLEAR_BIT(htim->Instance->CCMR1, TIM_CCMR1_OC1PE | TIM_CCMR1_OC2PE);
+    if (num_channels > 2)
+    {
+        CLEAR_BIT(htim->Instance->CCMR2, TIM_CCMR2_OC3PE | TIM_CCMR2_OC4PE);
+    }
+
+    if (HAL_TIM_DMABurst_MultiWriteStart(htim,
+                                         TIM_DMABASE_CCR1,
+                                         TIM_DMA_UPDATE,
+                                         frame,
+                                         (num_channels - 1) << TIM_DCR_DBL_Pos,
+                                         num_channels) != HAL_OK)
+    {
+        error_handler();
+    }
+}
+
+void timer_pwm_dma_burst_stop(TIMER_PWM_ID_t id)
+{
+    HAL_TIM_DMABurst_WriteStop(get_pwm_handle(id), TIM_DMA_UPDATE);
+}
+
+void timer_tim2_frame_it_enable(bool state)
+{
+    if (state)
+    {
+        __HAL_TIM_CLEAR_IT(&htim2, TIM_IT_UPDATE);
+        __HAL_TIM_ENABLE_IT(&htim2, TIM_IT_UPDATE);
+    }
+    else
+    {
+        __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_UPDATE);
+    }
+}
+
+/*===== TIM6 (Servo Motor Control Loop Time Base) ============================*/
+
+void timer_tim6_ctrl_init(uint32_t rate_hz)
+{
+    TIM_MasterConfigTypeDef config_master = {0};
+
+    assert(rate_hz > 0);
+    assert(rate_hz <= TIMER_TIM6_CTRL_COUNTER_CLK_HZ);
+
+    htim6.Instance = TIM6;
+    htim6.Init.Prescaler = (HAL_RCC_GetPCLK1Freq() / TIMER_TIM6_CTRL_COUNTER_CLK_HZ) - 1;
+    htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim6.Init.Period = (TIMER_TIM6_CTRL_COUNTER_CLK_HZ / rate_hz) - 1;
+    htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+    {
+        error_handler();
+    }
+    config_master.MasterOutputTrigger = TIM_TRGO_RESET;
+    config_master.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &config_master) != HAL_OK)
+    {
+        error_handler();
+    }
+}
+
+void timer_tim6_ctrl_enable(bool state)
+{
+    if (state)
+    {
+        HAL_TIM_Base_Start_IT(&htim6);
+    }
+    else
+    {
+        HAL_TIM_Base_Stop_IT(&htim6);
+    }
+}
+
+void timer_tim6_ctrl_set_count(uint32_t count)
+{
+    __HAL_TIM_SET_COUNTER(&htim6, count);
+}
+
+/*============================================================================*/
+/*===== Weak Public Functions ================================================*/
+/*============================================================================*/
+
+__weak void timer_tim6_period_elapsed_callback(void)
+{
+    /* Over-written by the user project. */
+}
+
+__weak void timer_tim2_period_elapsed_callback(void)
+{
+    /* Over-written by the user project. */
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Retrieve the HAL TIM handle for a PWM timer ID.
+ * @param  id: PWM timer ID; see @ref TIMER_PWM_ID_t for options.
+ * @retval HAL TIM handle pointer.
+ */
+static TIM_HandleTypeDef *get_pwm_handle(TIMER_PWM_ID_t id)
+{
+    switch (id)
+    {
+        case TIMER_PWM_ID__TIM2:  return &htim2;
+        case TIMER_PWM_ID__TIM15: return &htim15;
+        case TIMER_PWM_ID__TIM16: return &htim16;
+        default:                  error_handler(); return NULL;
+    }
 }
 
 /*============================================================================*/
\ No newline at end of file
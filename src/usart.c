@@ -8,6 +8,10 @@
 /*===== Handles ==============================================================*/
 static UART_HandleTypeDef huart2;
 
+/*===== Buffers ==============================================================*/
+static uint8_t _rx_buff[USART_RX_BUFF_SIZE]; /* USART2 circular DMA receive buffer. */
+static uint32_t _rx_read;                    /* Read position in _rx_buff. */
+
 /*===== Private Function Prototypes ==========================================*/
 static void hal_uart_init(UART_HandleTypeDef *huart, USART_TypeDef *instance);
 
@@ -27,6 +31,10 @@ void usart_init(void)
         error_handler();
     }
     hal_uart_init(handle, instance);
+    if (HAL_UART_Receive_DMA(handle, _rx_buff, USART_RX_BUFF_SIZE) != HAL_OK)
+    {
+        error_handler();
+    }
 }
 
 bool usart_get_handle(USART_ID_t id, UART_HandleTypeDef **return_var)
@@ -71,6 +79,24 @@ void usart_tx(UART_HandleTypeDef *handle, uint8_t *data, uint32_t data_len, uint
     HAL_UART_Transmit(handle, data, data_len, timeout);
 }
 
+uint32_t usart_rx(UART_HandleTypeDef *handle, uint8_t *data, uint32_t data_len)
+{
+    assert(data);
+    assert(handle == &huart2); /* @note: Only USART2 receives (see usart_init). */
+
+    /* DMA write position: the counter counts down the remaining transfers. */
+    uint32_t write = (USART_RX_BUFF_SIZE - __HAL_DMA_GET_COUNTER(handle->hdmarx)) % USART_RX_BUFF_SIZE;
+    uint32_t count = 0;
+
+    while ((_rx_read != write) && (count < data_len))
+    {
+        data[count++] = _rx_buff[_rx_read];
+        _rx_read = (_rx_read + 1) % USART_RX_BUFF_SIZE;
+    }
+
+    return count;
+}
+
 /*============================================================================*/
 /*===== Private Functions ====================================================*/
 /*============================================================================*/
@@ -89,7 +115,9 @@ static void hal_uart_init(UART_HandleTypeDef *huart, USART_TypeDef *instance)
     huart->Init.HwFlowCtl = UART_HWCONTROL_NONE;
     huart->Init.OverSampling = UART_OVERSAMPLING_16;
     huart->Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
-    huart->AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+    /* Reception is polled from the circular DMA buffer: overwrite on overrun rather than stall. */
+    huart->AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT;
+    huart->AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
 
     if (HAL_UART_Init(huart) != HAL_OK)
     {
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * @file   plant.c
+ * @brief  Host servo plant model source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "plant.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Private Function Prototypes ==========================================*/
+static void integrate(PLANT_t *plant, float h);
+static float sign(float value);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+void plant_init(PLANT_t *plant, const PLANT_CONFIG_t *config, float position)
+{
+    plant->config = *config;
+    plant->position = position;
+    plant->velocity = 0.0f;
+    plant->acceleration = 0.0f;
+    plant->command = position + config->load_deg;
+    plant->feedback = position;
+    plant->feedback_new = true;
+    plant->loop = config->sample_loop;
+}
+
+void plant_step(PLANT_t *plant, float command)
+{
+    const float h = 1.0f / (plant->config.loop_rate_hz * PLANT_SUBSTEPS);
+
+    for (uint32_t i = 0; i < PLANT_SUBSTEPS; i++)
+    {
+        integrate(plant, h);
+    }
+
+    /* The pulse written by the frame's last loop is the next frame's. */
+    if (plant->loop == (plant->config.loops_per_frame - 1))
+    {
+        plant->command = command;
+    }
+    plant->loop = (plant->loop + 1) % plant->config.loops_per_frame;
+
+    plant->feedback_new = (plant->loop == plant->config.sample_loop);
+    if (plant->feedback_new)
+    {
+        plant->feedback = plant->position + (plant->config.noise_deg * test_rand_gauss());
+    }
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Integrate the dynamics over one sub-step (semi-implicit Euler): the
+ *         servo's drive is its command error beyond the deadband; friction
+ *         holds it at rest until the drive exceeds the breakaway level and
+ *         opposes its motion, stopping it when the velocity would reverse.
+ * @param  plant: Plant.
+ * @param  h:     Sub-step (s).
+ * @retval None.
+ */
+static void integrate(PLANT_t *plant, float h)
+{
+    const PLANT_CONFIG_t *c = &plant->config;
+    const float wn = 6.2831853f * c->wn_hz;
+    const float wn2 = wn * wn;
+    bool friction = (c->stiction_deg > 0.0f) || (c->coulomb_deg > 0.0f);
+
+    float error = plant->command - c->load_deg - plant->position;
+    float drive = (fabsf(error) <= c->deadband_deg) ? 0.0f : (error - (c->deadband_deg * sign(error)));
+    float force;
+
+    if (friction && (plant->velocity == 0.0f))
+    {
+        if (fabsf(drive) <= c->stiction_deg)
+        {
+            plant->acceleration = 0.0f;
+            return;
+        }
+        force = wn2 * (drive - (c->coulomb_deg * sign(drive)));
+    }
+    else
+    {
+        force = (wn2 * (drive - (c->coulomb_deg * sign(plant->velocity)))) - (2.0f * c->zeta * wn * plant->velocity);
+    }
+
+    float velocity = plant->velocity + (force * h);
+    if (friction && (plant->velocity != 0.0f) && (sign(velocity) != sign(plant->velocity)))
+    {
+        velocity = 0.0f;
+    }
+    velocity = fmaxf(-c->speed_max_deg_s, fminf(c->speed_max_deg_s, velocity));
+
+    plant->acceleration = (velocity - plant->velocity) / h;
+    plant->velocity = velocity;
+    plant->position += velocity * h;
+}
+
+static float sign(float value)
+{
+    return (float)((value > 0.0f) - (value < 0.0f));
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * @file   plant.h
+ * @brief  Host servo plant model header file.
+ *
+ *         Provides:
+ *             - A hobby servo as seen by the control loop: the servo's own
+ *               position loop following the commanded angle as a 2nd order
+ *               system (natural frequency, damping) with a speed limit, and
+ *               optionally a constant load (the servo settling short of its
+ *               command), an internal deadband, stiction and Coulomb
+ *               friction.
+ *             - The PWM frame timing: the command is latched at the end of
+ *               each frame (the pulse in the preload register) and the
+ *               feedback sampled once per frame at a fixed loop, with
+ *               Gaussian noise.
+ *             - One plant_step per control loop period; the dynamics are
+ *               integrated in sub-steps.
+ *
+ * @note   Host only (see test.h).
+ *
+ ******************************************************************************/
+
+#ifndef PLANT_H
+#define PLANT_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/*===== Defines ==============================================================*/
+
+#define PLANT_SUBSTEPS          10
+
+/* The firmware's defaults: 1 kHz loop, 50 Hz frame, feedback 3 ms into the frame; a 6 Hz, zeta 0.8 servo. */
+#define PLANT_CONFIG_DEFAULT                                                                                          \
+    {                                                                                                                 \
+        .loop_rate_hz = 1000.0f, .loops_per_frame = 20, .sample_loop = 3, .wn_hz = 6.0f, .zeta = 0.8f,                \
+        .speed_max_deg_s = 450.0f, .load_deg = 0.0f, .deadband_deg = 0.0f, .stiction_deg = 0.0f,                      \
+        .coulomb_deg = 0.0f, .noise_deg = 0.0f                                                                        \
+    }
+
+/*===== Typedefs =============================================================*/
+
+typedef struct PLANT_CONFIG_t {
+    float loop_rate_hz;         /* Control loop rate (plant_step calls per second). */
+    uint32_t loops_per_frame;   /* PWM frame: the command is latched at its last loop. */
+    uint32_t sample_loop;       /* Loop within the frame at which the feedback is sampled. */
+    float wn_hz;                /* Servo's own position loop: natural frequency (Hz) and damping. */
+    float zeta;
+    float speed_max_deg_s;      /* Speed limit (degrees/s). */
+    float load_deg;             /* Constant load: the servo settles this far short of its command (degrees). */
+    float deadband_deg;         /* Internal deadband (degrees of command error). */
+    float stiction_deg;         /* Breakaway friction (degrees of command error); >= coulomb_deg. */
+    float coulomb_deg;          /* Kinetic friction (degrees of command error). */
+    float noise_deg;            /* Feedback noise, standard deviation (degrees). */
+} PLANT_CONFIG_t;
+
+typedef struct PLANT_t {
+    PLANT_CONFIG_t config;
+    float position;             /* Degrees. */
+    float velocity;             /* Degrees/s. */
+    float acceleration;         /* Degrees/s^2 (of the last sub-step). */
+    float command;              /* Latched command (degrees). */
+    float feedback;             /* Last feedback sample (degrees). */
+    bool feedback_new;          /* Sampled by the last plant_step. */
+    uint32_t loop;              /* Loop within the frame. */
+} PLANT_t;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a plant at rest; the command is latched at the position
+ *         and the feedback sampled.
+ * @param  plant:    Plant.
+ * @param  config:   Configuration (copied into @param plant).
+ * @param  position: Initial position (degrees).
+ * @retval None.
+ */
+void plant_init(PLANT_t *plant, const PLANT_CONFIG_t *config, float position);
+
+/**
+ * @brief  Advance the plant one control loop period with the loop's command
+ *         written; the command is latched if the period ends the frame.
+ * @param  plant:   Plant.
+ * @param  command: Command written by the loop (degrees).
+ * @retval None.
+ */
+void plant_step(PLANT_t *plant, float command);
+
+/*============================================================================*/
+
+#endif /* PLANT_H ============================================================*/
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ * @file   test.c
+ * @brief  Host test support source file.
+ *         Refer to .h file top-level comment for information.
+ ******************************************************************************/
+
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <stdarg.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static uint32_t _checks;
+static uint32_t _failures;
+static uint32_t _rand_state = 1;
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+bool test_check(bool condition, const char *file, int line, const char *format, ...)
+{
+    _checks++;
+    if (condition == false)
+    {
+        va_list args;
+        va_start(args, format);
+        printf("%s:%d: FAIL: ", file, line);
+        vprintf(format, args);
+        printf("\n");
+        va_end(args);
+        _failures++;
+    }
+    return condition;
+}
+
+int test_result(const char *name)
+{
+    printf("%s: %lu checks, %lu failed\n", name, (unsigned long)_checks, (unsigned long)_failures);
+    return (_failures == 0) ? 0 : 1;
+}
+
+uint64_t test_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void test_rand_seed(uint32_t seed)
+{
+    _rand_state = (seed != 0) ? seed : 1;
+}
+
+float test_rand_uniform(void)
+{
+    /* xorshift32: the top 24 bits as the fraction. */
+    _rand_state ^= _rand_state << 13;
+    _rand_state ^= _rand_state >> 17;
+    _rand_state ^= _rand_state << 5;
+    return (float)(_rand_state >> 8) / 16777216.0f;
+}
+
+float test_rand_gauss(void)
+{
+    /* Box-Muller; the first uniform kept off zero. */
+    float u1 = test_rand_uniform() + (1.0f / 16777216.0f);
+    float u2 = test_rand_uniform();
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+/*============================================================================*/
\ No newline at end of file
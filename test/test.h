@@ -0,0 +1,85 @@
+/*******************************************************************************
+ * @file   test.h
+ * @brief  Host test support header file.
+ *
+ *         Provides:
+ *             - Checks: a failed check reports its location and message and
+ *               fails the test (test_result, the test's exit status).
+ *             - A cycle counter for host benchmarks: the time-stamp counter
+ *               on x86 hosts, else nanoseconds.
+ *             - A reproducible pseudo-random number generator (uniform and
+ *               Gaussian), independent of the C library's rand().
+ *
+ * @note   Host only: each test/test_*.c is built into an executable with the
+ *         HAL/RTOS-free modules by "make test".
+ *
+ ******************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+/*===== C Standard Library =====*/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*===== Defines ==============================================================*/
+
+/* Check a condition; the message (printf format and arguments) is reported on failure. */
+#define TEST_CHECK(condition, ...) test_check((condition), __FILE__, __LINE__, __VA_ARGS__)
+
+/* Number of elements of an array (helper.h's NUM_ARRAY_ELS, without the HAL). */
+#define TEST_NUM_ELS(array) (sizeof(array) / sizeof((array)[0]))
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Record a check's result; a failure is reported with its location.
+ * @note   Use TEST_CHECK.
+ * @param  condition: Check passed.
+ * @param  file:      Source file of the check.
+ * @param  line:      Source line of the check.
+ * @param  format:    Message (printf format) followed by its arguments.
+ * @retval Boolean @param condition.
+ */
+bool test_check(bool condition, const char *file, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * @brief  Report the number of checks run and failed.
+ * @param  name: Test name.
+ * @retval Exit status: 0 if all checks passed, else 1.
+ */
+int test_result(const char *name);
+
+/**
+ * @brief  Retrieve the host's cycle counter (time-stamp counter on x86, else
+ *         nanoseconds); for relative benchmarks only.
+ * @retval Cycle count.
+ */
+uint64_t test_cycles(void);
+
+/**
+ * @brief  Seed the pseudo-random number generator.
+ * @param  seed: Seed (non-zero).
+ * @retval None.
+ */
+void test_rand_seed(uint32_t seed);
+
+/**
+ * @brief  Retrieve a uniformly distributed pseudo-random number.
+ * @retval Number in [0, 1).
+ */
+float test_rand_uniform(void);
+
+/**
+ * @brief  Retrieve a normally distributed pseudo-random number.
+ * @retval Number of zero mean and unit standard deviation.
+ */
+float test_rand_gauss(void);
+
+/*============================================================================*/
+
+#endif /* TEST_H =============================================================*/
\ No newline at end of file
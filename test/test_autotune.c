@@ -0,0 +1,270 @@
+/*******************************************************************************
+ * @file   test_autotune.c
+ * @brief  Relay feedback PID auto-tuning host test: the firmware's relay
+ *         experiment (see servo_ctrl_loop_run, servo_ctrl_autotune_start)
+ *         on the plant model at 1 kHz, i.e. through the PWM frame latch and
+ *         the once per frame feedback.
+ *             - Convergence: the experiment completes within its cycles and
+ *               the ultimate gain matches the servo's gain at the measured
+ *               frequency (the describing function's estimate). With the
+ *               feedback sampled once per frame the limit cycle locks to a
+ *               whole number of frames, which may differ with the feedback
+ *               noise: the ultimate period is repeatable within two frames.
+ *             - The tuned PI controller (for each noise seed): a step
+ *               settles without sustained oscillation, and a load is
+ *               rejected.
+ *             - Failure: a servo held by stiction does not oscillate and the
+ *               experiment times out.
+ ******************************************************************************/
+
+#include "autotune.h"
+#include "pid.h"
+#include "plant.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <complex.h>
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000.0f
+#define FRAME_RATE_HZ           50.0f
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define PID_OUTPUT_MAX          30.0f
+#define CENTRE_DEG              90.0f
+
+#define NUM_SEEDS               5
+#define TU_SPREAD_MAX_S         (2.0f / FRAME_RATE_HZ)
+#define MAX_LOOPS               (uint32_t)(30.0f * LOOP_RATE_HZ)
+
+/*===== Private Function Prototypes ==========================================*/
+static AUTOTUNE_STATE_t run_experiment(const PLANT_CONFIG_t *plant_config, uint32_t seed, AUTOTUNE_RESULT_t *result,
+                                       float *seconds);
+static float servo_gain(const PLANT_CONFIG_t *plant_config, float tu_s);
+static void test_convergence(void);
+static void test_tuned(void);
+static void test_timeout(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_convergence();
+    test_tuned();
+    test_timeout();
+    return test_result("test_autotune");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Run a relay experiment as the firmware: the relay output added to
+ *         the held setpoint, limited to the servo's range and the slew limit
+ *         about the latched command, updated every loop with the last
+ *         feedback sample.
+ * @param  plant_config: Plant configuration.
+ * @param  seed:         Feedback noise seed.
+ * @param  result:       Result (if done). Passed by reference.
+ * @param  seconds:      Experiment duration (s). Passed by reference.
+ * @retval Final experiment state.
+ */
+static AUTOTUNE_STATE_t run_experiment(const PLANT_CONFIG_t *plant_config, uint32_t seed, AUTOTUNE_RESULT_t *result,
+                                       float *seconds)
+{
+    const AUTOTUNE_CONFIG_t config = {
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .amplitude = 5.0f,
+        .hysteresis = 0.5f,
+        .settle_cycles = 2,
+        .measure_cycles = 3,
+        .max_cycles = 12,
+        .timeout_s = 2.0f,
+        .rule = AUTOTUNE_RULE__ZN_PI,
+    };
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    AUTOTUNE_t tune;
+    PLANT_t plant;
+    float latched = CENTRE_DEG;
+    uint32_t k = 0;
+
+    test_rand_seed(seed);
+    plant_init(&plant, plant_config, CENTRE_DEG);
+    latched = plant.command;
+    autotune_start(&tune, &config, CENTRE_DEG);
+    for (k = 0; (k < MAX_LOOPS) && (autotune_get_state(&tune) == AUTOTUNE_STATE__RUNNING); k++)
+    {
+        float command = CENTRE_DEG + autotune_update(&tune, plant.feedback);
+        command = fmaxf(fmaxf(0.0f, latched - slew_step), fminf(fminf(ANGLE_MAX, latched + slew_step), command));
+        if (plant.loop == (plant.config.loops_per_frame - 1))
+        {
+            latched = command;
+        }
+        plant_step(&plant, command);
+    }
+    *seconds = (float)k / LOOP_RATE_HZ;
+    autotune_get_result(&tune, result);
+    return autotune_get_state(&tune);
+}
+
+/**
+ * @brief  The servo's gain (its 2nd order loop with the frame's zero-order
+ *         hold) at the ultimate frequency: the relay's limit cycle is at the
+ *         phase crossover, where the ultimate gain is its reciprocal.
+ * @param  plant_config: Plant configuration.
+ * @param  tu_s:         Ultimate period (s).
+ * @retval Gain.
+ */
+static float servo_gain(const PLANT_CONFIG_t *plant_config, float tu_s)
+{
+    double w = 6.283185307179586 / (double)tu_s;
+    double wn = 6.283185307179586 * (double)plant_config->wn_hz;
+    double complex s = I * w;
+    double complex servo = (wn * wn) / ((s * s) + (2.0 * (double)plant_config->zeta * wn * s) + (wn * wn));
+    double hold = w / (2.0 * (double)FRAME_RATE_HZ);
+
+    return (float)(cabs(servo) * (sin(hold) / hold));
+}
+
+/**
+ * @brief  The experiment on the nominal servo with feedback noise (several
+ *         seeds): done within its cycles, the ultimate period repeatable
+ *         within two frames and the ultimate gain the reciprocal of the
+ *         servo's gain.
+ * @retval None.
+ */
+static void test_convergence(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.noise_deg = 0.1f;
+    float tu_min = 1e9f;
+    float tu_max = 0.0f;
+    float ku_error_max = 0.0f;
+    float seconds_max = 0.0f;
+    uint32_t done = 0;
+
+    for (uint32_t seed = 1; seed <= NUM_SEEDS; seed++)
+    {
+        AUTOTUNE_RESULT_t result;
+        float seconds;
+
+        if (run_experiment(&config, seed, &result, &seconds) != AUTOTUNE_STATE__DONE)
+        {
+            continue;
+        }
+        done++;
+        float ku_expected = 1.0f / servo_gain(&config, result.tu_s);
+        tu_min = fminf(tu_min, result.tu_s);
+        tu_max = fmaxf(tu_max, result.tu_s);
+        ku_error_max = fmaxf(ku_error_max, fabsf(result.ku - ku_expected) / ku_expected);
+        seconds_max = fmaxf(seconds_max, seconds);
+        if (seed == 1)
+        {
+            printf("relay: Tu %.3f s, Ku %.3f (servo gain at Tu: 1/%.3f), amplitude %.2f deg; kp %.3f, ki %.3f\n",
+                   (double)result.tu_s, (double)result.ku, (double)ku_expected, (double)result.amplitude,
+                   (double)result.kp, (double)result.ki);
+        }
+    }
+    printf("relay: %lu/%u done in up to %.2f s, Tu %.3f..%.3f s, Ku within %.1f%% of the servo's gain\n",
+           (unsigned long)done, NUM_SEEDS, (double)seconds_max, (double)tu_min, (double)tu_max,
+           (double)(100.0f * ku_error_max));
+    TEST_CHECK(done == NUM_SEEDS, "%lu of %u experiments done", (unsigned long)done, NUM_SEEDS);
+    TEST_CHECK((tu_max - tu_min) <= (TU_SPREAD_MAX_S + 1e-4f), "Tu %.3f..%.3f s", (double)tu_min, (double)tu_max);
+    TEST_CHECK(ku_error_max < 0.2f, "Ku %.1f%% from the servo's gain", (double)(100.0f * ku_error_max));
+}
+
+/**
+ * @brief  The PI controller tuned on the servo with feedback noise (each
+ *         seed), in the firmware's loop (see test_pid.c) on the servo with a
+ *         3 degree load: a 90 -> 120 degree step settles without sustained
+ *         oscillation and the load is rejected.
+ * @retval None.
+ */
+static void test_tuned(void)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    float peak_max = 0.0f;
+    float late_error_max = 0.0f;
+
+    for (uint32_t seed = 1; seed <= NUM_SEEDS; seed++)
+    {
+        PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+        AUTOTUNE_RESULT_t result;
+        float seconds;
+
+        config.noise_deg = 0.1f;
+        if (run_experiment(&config, seed, &result, &seconds) != AUTOTUNE_STATE__DONE)
+        {
+            TEST_CHECK(false, "seed %lu experiment not done", (unsigned long)seed);
+            continue;
+        }
+
+        const PID_CONFIG_t pid_config = {
+            .kp = result.kp,
+            .ki = result.ki,
+            .kd = result.kd,
+            .period_s = 1.0f / LOOP_RATE_HZ,
+            .output_min = -PID_OUTPUT_MAX,
+            .output_max = PID_OUTPUT_MAX,
+            .derivative = PID_DERIVATIVE__ERROR,
+        };
+        PID_t pid;
+        PLANT_t plant;
+
+        config.noise_deg = 0.0f;
+        config.load_deg = 3.0f;
+        pid_init(&pid, &pid_config);
+        plant_init(&plant, &config, 90.0f);
+        float latched = plant.command;
+        for (uint32_t k = 0; k < (uint32_t)(4.0f * LOOP_RATE_HZ); k++)
+        {
+            float command_min = fmaxf(0.0f, latched - slew_step);
+            float command_max = fminf(ANGLE_MAX, latched + slew_step);
+            pid_set_actuator_limits(&pid, command_min - 120.0f, command_max - 120.0f);
+            float command = 120.0f + pid_update(&pid, 120.0f, plant.feedback);
+            command = fmaxf(command_min, fminf(command_max, command));
+            if (plant.loop == (plant.config.loops_per_frame - 1))
+            {
+                latched = command;
+            }
+            plant_step(&plant, command);
+            peak_max = fmaxf(peak_max, plant.position);
+            if (k >= (uint32_t)(3.0f * LOOP_RATE_HZ))
+            {
+                late_error_max = fmaxf(late_error_max, fabsf(120.0f - plant.position));
+            }
+        }
+    }
+    printf("tuned PI, 3 deg load: step 90 -> 120 peak %.2f deg, error %.3f deg after 3 s (worst seed)\n",
+           (double)peak_max, (double)late_error_max);
+    TEST_CHECK(peak_max < 130.0f, "tuned step overshoot to %.2f deg", (double)peak_max);
+    TEST_CHECK(late_error_max < 0.2f, "tuned loop error %.3f deg after 3 s", (double)late_error_max);
+}
+
+/**
+ * @brief  A servo held by stiction beyond the relay amplitude: the relay
+ *         never switches and the experiment fails at its timeout.
+ * @retval None.
+ */
+static void test_timeout(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.stiction_deg = 8.0f;
+    config.coulomb_deg = 8.0f;
+    AUTOTUNE_RESULT_t result;
+    float seconds;
+
+    AUTOTUNE_STATE_t state = run_experiment(&config, 1, &result, &seconds);
+    printf("stuck servo: experiment %s after %.2f s\n", (state == AUTOTUNE_STATE__FAILED) ? "failed" : "not failed",
+           (double)seconds);
+    TEST_CHECK(state == AUTOTUNE_STATE__FAILED, "stuck servo's experiment state %d", (int)state);
+    TEST_CHECK(seconds < 2.5f, "stuck servo's experiment ran %.2f s", (double)seconds);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,367 @@
+/*******************************************************************************
+ * @file   test_cascade.c
+ * @brief  Cascaded position/velocity controller host test: the firmware's
+ *         control loop (see servo_ctrl_loop_run, cascade_update) closed around
+ *         the plant model at 1 kHz, with the Kalman state estimator and the
+ *         S-curve motion profiles as the setpoints.
+ *             - Tracking error of a sequence of moves: the cascade with the
+ *               profile velocity/acceleration feedforward against the cascade
+ *               without it and against the PID controller.
+ *             - Settling at the end of the moves under a load.
+ *             - Cycles per update, cascade against PID (benchmark).
+ ******************************************************************************/
+
+#include "estimator.h"
+#include "pid.h"
+#include "plant.h"
+#include "profile.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define LOOP_PERIOD_S           (1.0f / LOOP_RATE_HZ)
+#define FRAME_RATE_HZ           50.0f
+#define LOOPS_PER_POS_UPDATE    4
+#define PID_KP                  0.5f
+#define PID_KI                  5.0f
+#define PID_OUTPUT_MAX          30.0f
+#define POS_KP                  15.0f
+#define POS_VEL_MAX             500.0f
+#define VEL_KP                  0.005f
+#define VEL_KI                  0.25f
+#define VEL_OUTPUT_MAX          30.0f
+#define FF_VEL_S                0.045f
+#define FF_ACC_S2               0.0007f
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define MOVE_VELOCITY_DEG_S     180.0f
+#define MOVE_ACCEL_DEG_S2       1000.0f
+#define MOVE_JERK_DEG_S3        20000.0f
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define BENCH_LOOPS             200000
+
+/*===== Typedefs =============================================================*/
+
+typedef enum CTRL_t {
+    CTRL__PID,
+    CTRL__CASCADE_NO_FF,
+    CTRL__CASCADE,
+} CTRL_t;
+
+typedef struct LOOP_t {
+    CTRL_t ctrl;
+    PID_t pid;
+    PID_t pid_pos;
+    PID_t pid_vel;
+    float vel_correction;       /* Outer loop output, held between its updates. */
+    uint32_t pos_loop_count;
+    ESTIMATOR_t est;
+    PROFILE_GEN_t profile;
+    PLANT_t plant;
+    float latched;              /* Command latched at the last frame boundary (slew limit). */
+} LOOP_t;
+
+static const char *_ctrl_names[] = {"PID", "cascade (no feedforward)", "cascade"};
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, CTRL_t ctrl, const PLANT_CONFIG_t *plant_config, float position);
+static float control(LOOP_t *loop, float setpoint, float ff_vel, float ff_acc, float command_min, float command_max);
+static float loop_step(LOOP_t *loop);
+static bool queue_move(LOOP_t *loop, float target);
+static void test_tracking(void);
+static void test_settling(void);
+static void bench_loop(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_tracking();
+    test_settling();
+    bench_loop();
+    return test_result("test_cascade");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a loop at rest, configured as the firmware.
+ * @param  loop:         Loop.
+ * @param  ctrl:         Controller.
+ * @param  plant_config: Plant configuration.
+ * @param  position:     Initial position (degrees).
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, CTRL_t ctrl, const PLANT_CONFIG_t *plant_config, float position)
+{
+    const PID_CONFIG_t config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = LOOP_PERIOD_S,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__RATE,
+    };
+    const PID_CONFIG_t config_pos = {
+        .kp = POS_KP,
+        .ki = 0.0f,
+        .kd = 0.0f,
+        .period_s = LOOP_PERIOD_S * LOOPS_PER_POS_UPDATE,
+        .output_min = -POS_VEL_MAX,
+        .output_max = POS_VEL_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const PID_CONFIG_t config_vel = {
+        .kp = VEL_KP,
+        .ki = VEL_KI,
+        .kd = 0.0f,
+        .period_s = LOOP_PERIOD_S,
+        .output_min = -VEL_OUTPUT_MAX,
+        .output_max = VEL_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const ESTIMATOR_CONFIG_t est_config = {
+        .type = ESTIMATOR_TYPE__KALMAN,
+        .period_s = LOOP_PERIOD_S,
+        .meas_period_s = 1.0f / FRAME_RATE_HZ,
+        .alpha = 0.5f,
+        .beta = 0.17f,
+        .gamma = 0.03f,
+        .process_noise = 1.0e5f,
+        .meas_noise = 0.25f,
+        .init_var_vel = 1.0e4f,
+        .init_var_acc = 1.0e6f,
+    };
+
+    loop->ctrl = ctrl;
+    pid_init(&loop->pid, &config);
+    pid_init(&loop->pid_pos, &config_pos);
+    pid_init(&loop->pid_vel, &config_vel);
+    loop->vel_correction = 0.0f;
+    loop->pos_loop_count = 0;
+    estimator_init(&loop->est, &est_config);
+    profile_init(&loop->profile, LOOP_RATE_HZ, Q16(position));
+    plant_init(&loop->plant, plant_config, position);
+    loop->latched = loop->plant.command;
+}
+
+/**
+ * @brief  Run the estimator and controller as the firmware: the estimator
+ *         predicted every loop and corrected with each feedback sample, and
+ *         the setpoint plus the controller's correction limited to the
+ *         command range.
+ * @param  loop:        Loop.
+ * @param  setpoint:    Setpoint (degrees).
+ * @param  ff_vel:      Profile velocity (degrees/s).
+ * @param  ff_acc:      Profile acceleration (degrees/s^2).
+ * @param  command_min: Minimum command (degrees).
+ * @param  command_max: Maximum command (degrees).
+ * @retval Command (degrees).
+ */
+static float control(LOOP_t *loop, float setpoint, float ff_vel, float ff_acc, float command_min, float command_max)
+{
+    float feedback = loop->plant.feedback;
+
+    estimator_predict(&loop->est);
+    if (loop->plant.feedback_new || (estimator_is_valid(&loop->est) == false))
+    {
+        estimator_correct(&loop->est, feedback);
+    }
+    float position = estimator_get_position(&loop->est);
+    float velocity = estimator_get_velocity(&loop->est);
+
+    float command = setpoint;
+    if (loop->ctrl == CTRL__PID)
+    {
+        pid_set_actuator_limits(&loop->pid, command_min - command, command_max - command);
+        command += pid_update_rate(&loop->pid, setpoint, feedback, velocity);
+    }
+    else
+    {
+        if (loop->ctrl == CTRL__CASCADE_NO_FF)
+        {
+            ff_vel = 0.0f;
+            ff_acc = 0.0f;
+        }
+        if (loop->pos_loop_count == 0)
+        {
+            loop->vel_correction = pid_update(&loop->pid_pos, setpoint, position);
+        }
+        loop->pos_loop_count = (loop->pos_loop_count + 1) % LOOPS_PER_POS_UPDATE;
+
+        float ff = (FF_VEL_S * ff_vel) + (FF_ACC_S2 * ff_acc);
+        pid_set_actuator_limits(&loop->pid_vel, command_min - setpoint - ff, command_max - setpoint - ff);
+        command += ff + pid_update(&loop->pid_vel, ff_vel + loop->vel_correction, velocity);
+    }
+    return fmaxf(command_min, fminf(command_max, command));
+}
+
+/**
+ * @brief  Run one loop iteration as the firmware: the profile's setpoint and
+ *         the controller's command, limited to the servo's range and the slew
+ *         limit about the latched command.
+ * @param  loop: Loop.
+ * @retval Setpoint (degrees).
+ */
+static float loop_step(LOOP_t *loop)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    float setpoint = (float)profile_next(&loop->profile) / 65536.0f;
+    float command_min = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched - slew_step));
+    float command_max = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched + slew_step));
+    float command = control(loop, setpoint, profile_get_velocity(&loop->profile),
+                            profile_get_acceleration(&loop->profile), command_min, command_max);
+
+    if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+    {
+        loop->latched = command;
+    }
+    plant_step(&loop->plant, command);
+    return setpoint;
+}
+
+/**
+ * @brief  Queue an S-curve move within the firmware's move limits.
+ * @param  loop:   Loop.
+ * @param  target: Target (degrees).
+ * @retval Boolean indicating whether the move was queued.
+ */
+static bool queue_move(LOOP_t *loop, float target)
+{
+    const PROFILE_LIMITS_t limits = {
+        .velocity = MOVE_VELOCITY_DEG_S,
+        .acceleration = MOVE_ACCEL_DEG_S2,
+        .jerk = MOVE_JERK_DEG_S3,
+    };
+
+    if (profile_plan(&loop->profile, PROFILE_TYPE__S_CURVE, Q16(target), &limits, false) == false)
+    {
+        return false;
+    }
+    profile_commit(&loop->profile);
+    return true;
+}
+
+/**
+ * @brief  Moves 30 -> 150 -> 60 -> 120 degrees with feedback noise: the
+ *         feedforward removes most of the cascade's tracking error, and the
+ *         cascade tracks better than the PID controller.
+ * @retval None.
+ */
+static void test_tracking(void)
+{
+    const float targets[] = {150.0f, 60.0f, 120.0f};
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.noise_deg = 0.2f;
+    float rms[3];
+    float error_max[3];
+
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        LOOP_t loop;
+        double sum_sq = 0.0;
+        uint32_t samples = 0;
+
+        test_rand_seed(11);
+        loop_init(&loop, (CTRL_t)c, &config, 30.0f);
+        for (uint32_t k = 0; k < (uint32_t)(0.5f * LOOP_RATE_HZ); k++)
+        {
+            loop_step(&loop);
+        }
+        for (uint32_t m = 0; m < TEST_NUM_ELS(targets); m++)
+        {
+            TEST_CHECK(queue_move(&loop, targets[m]), "move to %.0f deg not queued", (double)targets[m]);
+        }
+        error_max[c] = 0.0f;
+        while (profile_is_busy(&loop.profile))
+        {
+            float setpoint = loop_step(&loop);
+            float error = setpoint - loop.plant.position;
+            sum_sq += (double)(error * error);
+            error_max[c] = fmaxf(error_max[c], fabsf(error));
+            samples++;
+        }
+        rms[c] = (float)sqrt(sum_sq / samples);
+        printf("%s: tracking error rms %.2f deg, max %.2f deg\n", _ctrl_names[c], (double)rms[c],
+               (double)error_max[c]);
+    }
+
+    TEST_CHECK(rms[CTRL__CASCADE] < (0.5f * rms[CTRL__CASCADE_NO_FF]), "feedforward: rms %.2f deg, without %.2f deg",
+               (double)rms[CTRL__CASCADE], (double)rms[CTRL__CASCADE_NO_FF]);
+    TEST_CHECK(rms[CTRL__CASCADE] < rms[CTRL__PID], "cascade rms %.2f deg, PID %.2f deg", (double)rms[CTRL__CASCADE],
+               (double)rms[CTRL__PID]);
+    TEST_CHECK(error_max[CTRL__CASCADE] < error_max[CTRL__PID], "cascade max %.2f deg, PID %.2f deg",
+               (double)error_max[CTRL__CASCADE], (double)error_max[CTRL__PID]);
+}
+
+/**
+ * @brief  A move 40 -> 140 degrees against a 3 degree load: the cascade
+ *         settles within 0.5 degrees of the target 0.5 s after the move.
+ * @retval None.
+ */
+static void test_settling(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.load_deg = 3.0f;
+    LOOP_t loop;
+    float error_max = 0.0f;
+
+    loop_init(&loop, CTRL__CASCADE, &config, 40.0f);
+    TEST_CHECK(queue_move(&loop, 140.0f), "move not queued");
+    while (profile_is_busy(&loop.profile))
+    {
+        loop_step(&loop);
+    }
+    for (uint32_t k = 0; k < (uint32_t)(1.0f * LOOP_RATE_HZ); k++)
+    {
+        loop_step(&loop);
+        if (k >= (uint32_t)(0.5f * LOOP_RATE_HZ))
+        {
+            error_max = fmaxf(error_max, fabsf(140.0f - loop.plant.position));
+        }
+    }
+    printf("cascade, 3 deg load: error %.3f deg 0.5..1 s after the move\n", (double)error_max);
+    TEST_CHECK(error_max < 0.5f, "cascade settled error %.3f deg", (double)error_max);
+}
+
+/**
+ * @brief  Benchmark: host cycles per estimator and controller update,
+ *         cascade against PID.
+ * @retval None.
+ */
+static void bench_loop(void)
+{
+    const PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    uint64_t cycles[2];
+    volatile float sink = 0.0f;
+
+    for (uint32_t c = 0; c < 2; c++)
+    {
+        LOOP_t loop;
+        loop_init(&loop, (c == 0) ? CTRL__PID : CTRL__CASCADE, &config, 90.0f);
+
+        uint64_t start = test_cycles();
+        for (uint32_t k = 0; k < BENCH_LOOPS; k++)
+        {
+            loop.plant.feedback_new = ((k % 20) == 0);
+            sink = control(&loop, 90.0f + (float)(k & 7), 10.0f, 0.0f, 0.0f, ANGLE_MAX);
+        }
+        cycles[c] = test_cycles() - start;
+    }
+    (void)sink;
+    printf("bench: PID %.1f host cycles per loop, cascade %.1f (both with the Kalman estimator)\n",
+           (double)cycles[0] / BENCH_LOOPS, (double)cycles[1] / BENCH_LOOPS);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,314 @@
+/*******************************************************************************
+ * @file   test_coord.c
+ * @brief  Coordinated multi-axis motion host test: moves of all six servos
+ *         at the 1 kHz control loop rate (see servo_ctrl_move_coordinated).
+ *             - Synchronisation, trapezoidal and S-curve: all moving axes
+ *               busy on the same ticks and finishing on the planned tick at
+ *               their targets, the duration that of the slowest axis alone,
+ *               and no axis beyond its own limits; an axis not moving holds.
+ *             - Path: each axis' displacement proportional to its distance
+ *               on every tick (a straight line in axis space).
+ *             - Lock-step queueing: consecutive coordinated moves stay
+ *               synchronised; planning is refused on queues out of
+ *               lock-step or an invalid number of axes.
+ *             - Cycles per control loop tick (all axes' generators) and per
+ *               plan for 1..6 axes (benchmark).
+ ******************************************************************************/
+
+#include "coord.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <stdlib.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define RATE_HZ                 1000
+#define NUM_AXES                6       /* Servos. */
+#define VELOCITY_MAX            180.0f
+#define ACCELERATION_MAX        1000.0f
+#define JERK_MAX                20000.0f
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define MAX_TICKS               20000
+#define SLOW_AXIS               3       /* Half the velocity/acceleration, a quarter of the jerk. */
+#define BENCH_MOVES             1000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct SYNC_RESULT_t {
+    uint32_t ticks;             /* Ticks until all axes idle. */
+    uint32_t busy_mismatches;   /* Ticks on which the moving axes' busy states differed. */
+    uint32_t end_mismatches;    /* Axes not at their targets. */
+    int32_t path_error_max;     /* Displacement against the path's, proportional to the distance (Q16.16). */
+    float velocity_ratio_max;   /* Velocity against the axis' limit. */
+    float acceleration_ratio_max;
+} SYNC_RESULT_t;
+
+/*===== Private Function Prototypes ==========================================*/
+static void limits_init(PROFILE_LIMITS_t *limits);
+static SYNC_RESULT_t run(PROFILE_GEN_t *gens, const int32_t *starts, const int32_t *targets,
+                         const PROFILE_LIMITS_t *limits);
+static void test_sync(PROFILE_TYPE_t type, const char *name);
+static void test_lock_step(void);
+static void bench_axes(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_sync(PROFILE_TYPE__TRAPEZOIDAL, "trapezoidal");
+    test_sync(PROFILE_TYPE__S_CURVE, "S-curve");
+    test_lock_step();
+    bench_axes();
+    return test_result("test_coord");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  The axes' limits: the firmware's defaults, SLOW_AXIS slower.
+ * @param  limits: Limits per axis. Passed by reference.
+ * @retval None.
+ */
+static void limits_init(PROFILE_LIMITS_t *limits)
+{
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        limits[i].velocity = VELOCITY_MAX;
+        limits[i].acceleration = ACCELERATION_MAX;
+        limits[i].jerk = JERK_MAX;
+    }
+    limits[SLOW_AXIS].velocity = VELOCITY_MAX / 2.0f;
+    limits[SLOW_AXIS].acceleration = ACCELERATION_MAX / 2.0f;
+    limits[SLOW_AXIS].jerk = JERK_MAX / 4.0f;
+}
+
+/**
+ * @brief  Run the committed moves of all axes to completion, stepping the
+ *         generators together as the control loop does.
+ * @param  gens:    Generators.
+ * @param  starts:  Positions before the moves (Q16.16).
+ * @param  targets: Targets (Q16.16).
+ * @param  limits:  Limits per axis.
+ * @retval Result.
+ */
+static SYNC_RESULT_t run(PROFILE_GEN_t *gens, const int32_t *starts, const int32_t *targets,
+                         const PROFILE_LIMITS_t *limits)
+{
+    SYNC_RESULT_t result = {0};
+    int32_t position[NUM_AXES];
+    uint32_t ref = 0; /* The longest move: the path's parameter. */
+
+    for (uint32_t i = 1; i < NUM_AXES; i++)
+    {
+        if (abs(targets[i] - starts[i]) > abs(targets[ref] - starts[ref]))
+        {
+            ref = i;
+        }
+    }
+
+    bool busy = true;
+    while (busy && (result.ticks < MAX_TICKS))
+    {
+        bool busy_ref = profile_is_busy(&gens[ref]);
+        busy = false;
+        for (uint32_t i = 0; i < NUM_AXES; i++)
+        {
+            bool moving = (targets[i] != starts[i]);
+            result.busy_mismatches += (moving && (profile_is_busy(&gens[i]) != busy_ref));
+            busy |= profile_is_busy(&gens[i]);
+            position[i] = profile_next(&gens[i]);
+            float velocity_ratio = fabsf(profile_get_velocity(&gens[i])) / limits[i].velocity;
+            float acceleration_ratio = fabsf(profile_get_acceleration(&gens[i])) / limits[i].acceleration;
+            result.velocity_ratio_max = fmaxf(result.velocity_ratio_max, velocity_ratio);
+            result.acceleration_ratio_max = fmaxf(result.acceleration_ratio_max, acceleration_ratio);
+        }
+
+        /* Each axis' displacement: the path's (the longest move's, normalised) times its distance. */
+        double s = (double)(position[ref] - starts[ref]) / (double)(targets[ref] - starts[ref]);
+        for (uint32_t i = 0; i < NUM_AXES; i++)
+        {
+            double expected = s * (double)(targets[i] - starts[i]);
+            int32_t error = (int32_t)ceil(fabs((double)(position[i] - starts[i]) - expected));
+            result.path_error_max = (error > result.path_error_max) ? error : result.path_error_max;
+        }
+        result.ticks += busy;
+    }
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        result.end_mismatches += (position[i] != targets[i]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief  Coordinated moves of all axes (distances of both signs, one axis
+ *         not moving, SLOW_AXIS with a shorter distance): the duration that
+ *         of the slowest axis' move alone (within a tick of the rounding),
+ *         all axes synchronised on the path and within their limits.
+ * @param  type: Profile type.
+ * @param  name: Profile type name.
+ * @retval None.
+ */
+static void test_sync(PROFILE_TYPE_t type, const char *name)
+{
+    const float starts_deg[NUM_AXES] = {10.0f, 170.0f, 90.0f, 20.0f, 45.0f, 90.0f};
+    const float targets_deg[NUM_AXES] = {170.0f, 20.0f, 90.0f, 120.0f, 44.0f, 123.45f};
+    PROFILE_GEN_t gens[NUM_AXES];
+    PROFILE_LIMITS_t limits[NUM_AXES];
+    int32_t starts[NUM_AXES];
+    int32_t targets[NUM_AXES];
+    uint32_t ticks = 0;
+    uint32_t slowest_ticks = 0;
+
+    limits_init(limits);
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        PROFILE_TIMING_t timing;
+        starts[i] = Q16(starts_deg[i]);
+        targets[i] = Q16(targets_deg[i]);
+        profile_init(&gens[i], RATE_HZ, starts[i]);
+        if ((targets[i] != starts[i]) &&
+            profile_plan_timing(type, fabsf(targets_deg[i] - starts_deg[i]), &limits[i], RATE_HZ, &timing))
+        {
+            uint32_t axis_ticks = profile_timing_get_ticks(&timing);
+            slowest_ticks = (axis_ticks > slowest_ticks) ? axis_ticks : slowest_ticks;
+        }
+    }
+
+    TEST_CHECK(coord_plan(gens, NUM_AXES, type, targets, limits, false, &ticks), "%s: move not planned", name);
+    coord_commit(gens, NUM_AXES);
+    SYNC_RESULT_t result = run(gens, starts, targets, limits);
+
+    printf("%s: %lu ticks (slowest axis alone %lu), path error max %ld Q16.16 LSBs, velocity/acceleration max "
+           "%.3f/%.3f of the limits\n",
+           name, (unsigned long)result.ticks, (unsigned long)slowest_ticks, (long)result.path_error_max,
+           (double)result.velocity_ratio_max, (double)result.acceleration_ratio_max);
+    TEST_CHECK(result.ticks == ticks, "%s: finished after %lu ticks, planned %lu", name, (unsigned long)result.ticks,
+               (unsigned long)ticks);
+    TEST_CHECK(abs((int32_t)ticks - (int32_t)slowest_ticks) <= 1, "%s: %lu ticks, the slowest axis alone %lu",
+               name, (unsigned long)ticks, (unsigned long)slowest_ticks);
+    TEST_CHECK(result.busy_mismatches == 0, "%s: axes busy on different ticks %lu times", name,
+               (unsigned long)result.busy_mismatches);
+    TEST_CHECK(result.end_mismatches == 0, "%s: %lu axes off their targets", name,
+               (unsigned long)result.end_mismatches);
+    TEST_CHECK(result.path_error_max <= 2, "%s: path error %ld LSBs", name, (long)result.path_error_max);
+    TEST_CHECK((result.velocity_ratio_max <= 1.001f) && (result.acceleration_ratio_max <= 1.001f),
+               "%s: velocity/acceleration %.4f/%.4f of the limits", name, (double)result.velocity_ratio_max,
+               (double)result.acceleration_ratio_max);
+}
+
+/**
+ * @brief  Two consecutive coordinated moves queued in lock-step run
+ *         synchronised to the second's targets; planning on queues out of
+ *         lock-step, or with an invalid number of axes, is refused.
+ * @retval None.
+ */
+static void test_lock_step(void)
+{
+    PROFILE_GEN_t gens[NUM_AXES];
+    PROFILE_LIMITS_t limits[NUM_AXES];
+    int32_t starts[NUM_AXES];
+    int32_t targets[NUM_AXES];
+    uint32_t ticks[2];
+
+    limits_init(limits);
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        starts[i] = Q16(90.0f);
+        targets[i] = Q16(90.0f + (10.0f * (float)(i + 1)));
+        profile_init(&gens[i], RATE_HZ, starts[i]);
+    }
+    TEST_CHECK(coord_plan(gens, NUM_AXES, PROFILE_TYPE__S_CURVE, targets, limits, false, &ticks[0]),
+               "first move not planned");
+    coord_commit(gens, NUM_AXES);
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        targets[i] = Q16(90.0f - (5.0f * (float)(i + 1)));
+    }
+    TEST_CHECK(coord_plan(gens, NUM_AXES, PROFILE_TYPE__S_CURVE, targets, limits, false, &ticks[1]),
+               "second move not planned");
+    coord_commit(gens, NUM_AXES);
+
+    /* The path is only a line within each move: check the synchronisation and the ends. */
+    SYNC_RESULT_t result = run(gens, starts, targets, limits);
+    TEST_CHECK(result.ticks == (ticks[0] + ticks[1]), "two moves: %lu ticks, planned %lu + %lu",
+               (unsigned long)result.ticks, (unsigned long)ticks[0], (unsigned long)ticks[1]);
+    TEST_CHECK((result.busy_mismatches == 0) && (result.end_mismatches == 0),
+               "two moves: busy on different ticks %lu times, %lu axes off their targets",
+               (unsigned long)result.busy_mismatches, (unsigned long)result.end_mismatches);
+
+    /* One axis with an extra move: out of lock-step. */
+    profile_plan(&gens[2], PROFILE_TYPE__S_CURVE, Q16(100.0f), &limits[2], false);
+    profile_commit(&gens[2]);
+    TEST_CHECK(coord_plan(gens, NUM_AXES, PROFILE_TYPE__S_CURVE, starts, limits, false, &ticks[0]) == false,
+               "queues out of lock-step accepted");
+    TEST_CHECK(coord_plan(gens, 0, PROFILE_TYPE__S_CURVE, starts, limits, false, &ticks[0]) == false,
+               "no axes accepted");
+    TEST_CHECK(coord_plan(gens, COORD_MAX_AXES + 1, PROFILE_TYPE__S_CURVE, starts, limits, false, &ticks[0]) == false,
+               "too many axes accepted");
+}
+
+/**
+ * @brief  Benchmark: host cycles per control loop tick stepping all axes'
+ *         generators, and per coord_plan/coord_commit, for 1..6 axes over
+ *         S-curve moves between the limits.
+ * @retval None.
+ */
+static void bench_axes(void)
+{
+    PROFILE_GEN_t gens[NUM_AXES];
+    PROFILE_LIMITS_t limits[NUM_AXES];
+    int32_t targets[NUM_AXES];
+    volatile int32_t sink = 0;
+
+    limits_init(limits);
+    for (uint32_t num_axes = 1; num_axes <= NUM_AXES; num_axes++)
+    {
+        uint64_t tick_cycles = 0;
+        uint64_t plan_cycles = 0;
+        uint64_t ticks = 0;
+        uint32_t duration;
+
+        for (uint32_t i = 0; i < num_axes; i++)
+        {
+            profile_init(&gens[i], RATE_HZ, Q16(10.0f));
+        }
+        for (uint32_t k = 0; k < BENCH_MOVES; k++)
+        {
+            for (uint32_t i = 0; i < num_axes; i++)
+            {
+                targets[i] = ((k % 2) == 0) ? Q16(170.0f - (10.0f * (float)i)) : Q16(10.0f);
+            }
+            uint64_t start = test_cycles();
+            coord_plan(gens, num_axes, PROFILE_TYPE__S_CURVE, targets, limits, false, &duration);
+            coord_commit(gens, num_axes);
+            plan_cycles += test_cycles() - start;
+
+            start = test_cycles();
+            while (profile_is_busy(&gens[0]))
+            {
+                for (uint32_t i = 0; i < num_axes; i++)
+                {
+                    sink = profile_next(&gens[i]);
+                }
+                ticks++;
+            }
+            tick_cycles += test_cycles() - start;
+        }
+        (void)sink;
+        printf("bench: %lu axes, %.1f host cycles per tick (%.1f per axis), %.0f per plan\n", (unsigned long)num_axes,
+               (double)tick_cycles / (double)ticks, (double)tick_cycles / (double)(ticks * num_axes),
+               (double)plan_cycles / BENCH_MOVES);
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
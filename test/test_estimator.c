@@ -0,0 +1,363 @@
+/*******************************************************************************
+ * @file   test_estimator.c
+ * @brief  State estimator host test: both estimators with the firmware's
+ *         configurations (see servo_ctrl.h), predicted every 1 kHz control
+ *         loop period and corrected once per 50 Hz feedback sample.
+ *             - Seeding: invalid until the first sample, predictions before
+ *               it ignored, invalid again after a reset; the first sample
+ *               seeds the position.
+ *             - Convergence on a constant-acceleration trajectory from the
+ *               seed's unknown velocity and acceleration: noise-free, the
+ *               position, velocity and acceleration converge exactly.
+ *             - Tracking of a sine with noisy samples: position, velocity
+ *               and acceleration errors bounded.
+ *             - Delayed samples (taken DELAY_TICKS loops before the
+ *               correction): the state converges on the trajectory as it
+ *               was when sampled, i.e. delayed but otherwise undistorted.
+ *             - Predict-only steps between samples: the estimates follow the
+ *               trajectory between samples as at them, unlike a sample held.
+ *             - Cycles per predict and per correct (benchmark).
+ ******************************************************************************/
+
+#include "estimator.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define SAMPLE_RATE_HZ          50
+#define EST_ALPHA               0.5f
+#define EST_BETA                0.17f
+#define EST_GAMMA               0.03f
+#define EST_PROCESS_NOISE       1.0e5f
+#define EST_MEAS_NOISE          0.25f   /* Feedback noise: 0.5 degrees standard deviation. */
+#define EST_INIT_VAR_VEL        1.0e4f
+#define EST_INIT_VAR_ACC        1.0e6f
+
+#define LOOPS_PER_SAMPLE        (LOOP_RATE_HZ / SAMPLE_RATE_HZ)
+#define NOISE_DEG               0.5f
+#define DELAY_TICKS             2
+#define RUN_TICKS               (12 * LOOP_RATE_HZ)
+#define SETTLE_TICKS            (2 * LOOP_RATE_HZ) /* Errors measured after. */
+#define BENCH_STEPS             1000000
+
+/*===== Typedefs =============================================================*/
+
+typedef enum TRAJ_t {
+    TRAJ__PARABOLA,             /* Constant acceleration. */
+    TRAJ__SINE,
+} TRAJ_t;
+
+enum {
+    STATE__POS,
+    STATE__VEL,
+    STATE__ACC,
+    STATE__NUM
+};
+
+typedef struct RESULT_t {
+    double rms_sampled[STATE__NUM];     /* At the ticks corrected by a sample. */
+    double rms_between[STATE__NUM];     /* At the predict-only ticks between samples. */
+    double max[STATE__NUM];
+    double hold_rms;                    /* Position error of the last sample held. */
+} RESULT_t;
+
+/*===== Private Constants ====================================================*/
+
+static const char *_type_names[] = {"alpha-beta-gamma", "Kalman"};
+static const char *_state_names[] = {"position", "velocity", "acceleration"};
+
+/*===== Private Function Prototypes ==========================================*/
+static void est_init(ESTIMATOR_t *est, ESTIMATOR_TYPE_t type);
+static void trajectory(TRAJ_t traj, uint32_t tick, double *state);
+static RESULT_t run(ESTIMATOR_TYPE_t type, TRAJ_t traj, float noise_deg, uint32_t delay);
+static void test_seed(ESTIMATOR_TYPE_t type);
+static void test_converge(ESTIMATOR_TYPE_t type);
+static void test_sine(ESTIMATOR_TYPE_t type);
+static void bench_steps(ESTIMATOR_TYPE_t type);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_rand_seed(1);
+    for (uint32_t t = 0; t < TEST_NUM_ELS(_type_names); t++)
+    {
+        ESTIMATOR_TYPE_t type = (t == 0) ? ESTIMATOR_TYPE__ALPHA_BETA : ESTIMATOR_TYPE__KALMAN;
+        test_seed(type);
+        test_converge(type);
+        test_sine(type);
+        bench_steps(type);
+    }
+    return test_result("test_estimator");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise an estimator with the firmware's configuration.
+ * @param  est:  Estimator.
+ * @param  type: Estimator type.
+ * @retval None.
+ */
+static void est_init(ESTIMATOR_t *est, ESTIMATOR_TYPE_t type)
+{
+    const ESTIMATOR_CONFIG_t config = {
+        .type = type,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .meas_period_s = 1.0f / SAMPLE_RATE_HZ,
+        .alpha = EST_ALPHA,
+        .beta = EST_BETA,
+        .gamma = EST_GAMMA,
+        .process_noise = EST_PROCESS_NOISE,
+        .meas_noise = EST_MEAS_NOISE,
+        .init_var_vel = EST_INIT_VAR_VEL,
+        .init_var_acc = EST_INIT_VAR_ACC,
+    };
+
+    estimator_init(est, &config);
+}
+
+/**
+ * @brief  The known trajectory at a tick.
+ *             - Parabola: from 10 degrees at 30 degrees/s, accelerating at
+ *               40 degrees/s^2.
+ *             - Sine: 30 degrees about 90 at 0.5 Hz (94 degrees/s,
+ *               296 degrees/s^2 peak; within the firmware's move limits).
+ * @param  traj:  Trajectory.
+ * @param  tick:  Control loop tick.
+ * @param  state: Position, velocity and acceleration, STATE__NUM. Passed by
+ *                reference.
+ * @retval None.
+ */
+static void trajectory(TRAJ_t traj, uint32_t tick, double *state)
+{
+    double t = (double)tick / LOOP_RATE_HZ;
+
+    if (traj == TRAJ__PARABOLA)
+    {
+        state[STATE__POS] = 10.0 + (30.0 * t) + (20.0 * t * t);
+        state[STATE__VEL] = 30.0 + (40.0 * t);
+        state[STATE__ACC] = 40.0;
+    }
+    else
+    {
+        const double w = M_PI;
+        state[STATE__POS] = 90.0 + (30.0 * sin(w * t));
+        state[STATE__VEL] = 30.0 * w * cos(w * t);
+        state[STATE__ACC] = -30.0 * w * w * sin(w * t);
+    }
+}
+
+/**
+ * @brief  Run an estimator over a trajectory as the control loop does:
+ *         predicted every tick, corrected at every LOOPS_PER_SAMPLE-th tick
+ *         with the position sampled @param delay ticks earlier (plus noise).
+ *         The estimates are compared with the trajectory @param delay ticks
+ *         earlier, after SETTLE_TICKS.
+ * @param  type:      Estimator type.
+ * @param  traj:      Trajectory.
+ * @param  noise_deg: Sample noise, standard deviation (degrees).
+ * @param  delay:     Sample delay (ticks).
+ * @retval Result.
+ */
+static RESULT_t run(ESTIMATOR_TYPE_t type, TRAJ_t traj, float noise_deg, uint32_t delay)
+{
+    RESULT_t result = {0};
+    ESTIMATOR_t est;
+    double sum_sampled[STATE__NUM] = {0};
+    double sum_between[STATE__NUM] = {0};
+    double sum_hold = 0.0;
+    uint32_t n_sampled = 0;
+    uint32_t n_between = 0;
+    float held = 0.0f;
+
+    est_init(&est, type);
+    for (uint32_t k = delay; k < (RUN_TICKS + delay); k++)
+    {
+        double truth[STATE__NUM];
+        bool sampled = ((k % LOOPS_PER_SAMPLE) == 0);
+
+        estimator_predict(&est);
+        if (sampled)
+        {
+            trajectory(traj, k - delay, truth);
+            held = (float)truth[STATE__POS] + (noise_deg * test_rand_gauss());
+            estimator_correct(&est, held);
+        }
+        if ((k - delay) < SETTLE_TICKS)
+        {
+            continue;
+        }
+
+        trajectory(traj, k - delay, truth);
+        const double estimate[STATE__NUM] = {estimator_get_position(&est), estimator_get_velocity(&est),
+                                             estimator_get_acceleration(&est)};
+        for (uint32_t s = 0; s < STATE__NUM; s++)
+        {
+            double error = estimate[s] - truth[s];
+            result.max[s] = fmax(result.max[s], fabs(error));
+            if (sampled)
+            {
+                sum_sampled[s] += error * error;
+            }
+            else
+            {
+                sum_between[s] += error * error;
+            }
+        }
+        n_sampled += sampled;
+        n_between += !sampled;
+        sum_hold += ((double)held - truth[STATE__POS]) * ((double)held - truth[STATE__POS]);
+    }
+
+    for (uint32_t s = 0; s < STATE__NUM; s++)
+    {
+        result.rms_sampled[s] = sqrt(sum_sampled[s] / n_sampled);
+        result.rms_between[s] = sqrt(sum_between[s] / n_between);
+    }
+    result.hold_rms = sqrt(sum_hold / (n_sampled + n_between));
+    return result;
+}
+
+/**
+ * @brief  Invalid until the first sample, which seeds the position
+ *         (velocity and acceleration zero); predictions before it ignored;
+ *         invalid again after a reset.
+ * @param  type: Estimator type.
+ * @retval None.
+ */
+static void test_seed(ESTIMATOR_TYPE_t type)
+{
+    ESTIMATOR_t est;
+    uint32_t failures = 0;
+
+    est_init(&est, type);
+    failures += estimator_is_valid(&est);
+    for (uint32_t k = 0; k < LOOPS_PER_SAMPLE; k++)
+    {
+        estimator_predict(&est);
+    }
+    failures += estimator_is_valid(&est) || (estimator_get_position(&est) != 0.0f);
+
+    estimator_correct(&est, 42.0f);
+    failures += !estimator_is_valid(&est) || (estimator_get_position(&est) != 42.0f) ||
+                (estimator_get_velocity(&est) != 0.0f) || (estimator_get_acceleration(&est) != 0.0f);
+    estimator_predict(&est);
+    failures += (estimator_get_position(&est) != 42.0f);
+
+    estimator_reset(&est);
+    failures += estimator_is_valid(&est);
+    estimator_correct(&est, -7.0f);
+    failures += !estimator_is_valid(&est) || (estimator_get_position(&est) != -7.0f);
+
+    TEST_CHECK(failures == 0, "%s: seeding, %u failures", _type_names[type], (unsigned)failures);
+}
+
+/**
+ * @brief  Noise-free constant acceleration, the seed's velocity and
+ *         acceleration unknown: converged exactly on the trajectory, at and
+ *         between the samples, without and with the sample delay.
+ * @param  type: Estimator type.
+ * @retval None.
+ */
+static void test_converge(ESTIMATOR_TYPE_t type)
+{
+    static const double tolerance[STATE__NUM] = {0.01, 0.1, 1.0};
+
+    for (uint32_t d = 0; d <= DELAY_TICKS; d += DELAY_TICKS)
+    {
+        RESULT_t result = run(type, TRAJ__PARABOLA, 0.0f, d);
+        uint32_t failed = 0;
+
+        printf("%s, parabola, %u ticks delay: error max %.2e deg, %.2e deg/s, %.2e deg/s^2\n", _type_names[type],
+               (unsigned)d, result.max[STATE__POS], result.max[STATE__VEL], result.max[STATE__ACC]);
+        for (uint32_t s = 0; s < STATE__NUM; s++)
+        {
+            failed += (result.max[s] > tolerance[s]);
+        }
+        TEST_CHECK(failed == 0, "%s, parabola, %u ticks delay: not converged", _type_names[type], (unsigned)d);
+    }
+}
+
+/**
+ * @brief  A sine, without and with the sample delay:
+ *             - Noisy samples: position filtered below the noise, velocity
+ *               and acceleration bounded, and the predict-only ticks between
+ *               samples not much worse than the corrected ones.
+ *             - Noise-free samples: the position between samples far closer
+ *               than the last sample held (the motion since it).
+ * @param  type: Estimator type.
+ * @retval None.
+ */
+static void test_sine(ESTIMATOR_TYPE_t type)
+{
+    /* RMS bounds: the noise, a fraction of the peak velocity and of the peak acceleration. */
+    static const double bound[STATE__NUM] = {NOISE_DEG, 0.15 * 94.2, 0.75 * 296.1};
+
+    for (uint32_t d = 0; d <= DELAY_TICKS; d += DELAY_TICKS)
+    {
+        RESULT_t result = run(type, TRAJ__SINE, NOISE_DEG, d);
+        uint32_t failed = 0;
+
+        for (uint32_t s = 0; s < STATE__NUM; s++)
+        {
+            printf("%s, sine, %u ticks delay: %s error rms %.3f at samples (bound %.3f), %.3f between, max %.3f\n",
+                   _type_names[type], (unsigned)d, _state_names[s], result.rms_sampled[s], bound[s],
+                   result.rms_between[s], result.max[s]);
+            failed += (result.rms_sampled[s] > bound[s]);
+            failed += (result.rms_between[s] > (1.5 * result.rms_sampled[s]));
+        }
+        TEST_CHECK(failed == 0, "%s, sine, %u ticks delay: error beyond the bounds", _type_names[type], (unsigned)d);
+
+        result = run(type, TRAJ__SINE, 0.0f, d);
+        printf("%s, sine, %u ticks delay, noise-free: position error rms between samples %.4f deg, sample held "
+               "%.4f deg\n",
+               _type_names[type], (unsigned)d, result.rms_between[STATE__POS], result.hold_rms);
+        TEST_CHECK(result.rms_between[STATE__POS] < (0.25 * result.hold_rms),
+                   "%s, sine, %u ticks delay: between samples rms %.4f deg, sample held %.4f deg", _type_names[type],
+                   (unsigned)d, result.rms_between[STATE__POS], result.hold_rms);
+    }
+}
+
+/**
+ * @brief  Cycles per predict and per correct.
+ * @param  type: Estimator type.
+ * @retval None.
+ */
+static void bench_steps(ESTIMATOR_TYPE_t type)
+{
+    ESTIMATOR_t est;
+    volatile float sink = 0.0f;
+
+    est_init(&est, type);
+    estimator_correct(&est, 0.0f);
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_STEPS; k++)
+    {
+        estimator_predict(&est);
+        sink += estimator_get_position(&est);
+    }
+    uint64_t predict_cycles = test_cycles() - start;
+
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_STEPS; k++)
+    {
+        estimator_correct(&est, (float)(k & 0xFU));
+        sink += estimator_get_position(&est);
+    }
+    uint64_t correct_cycles = test_cycles() - start;
+    (void)sink;
+    printf("bench: %s %.1f host cycles per predict, %.1f per correct\n", _type_names[type],
+           (double)predict_cycles / BENCH_STEPS, (double)correct_cycles / BENCH_STEPS);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,336 @@
+/*******************************************************************************
+ * @file   test_feedback.c
+ * @brief  Position feedback conversion host test: blocks of raw ADC samples
+ *         as the DMA transfer delivers them (see adc.c) converted to the
+ *         angles that servo_get_angle_actual publishes (see servo.c).
+ *             - Half and full transfers: each half of the DMA buffer
+ *               (interleaved scans of all servos) converted against a
+ *               double-precision reference, one scan per block (the
+ *               firmware's) and several (averaged).
+ *             - Linearity: every raw value over the calibrated range within
+ *               two Q16.16 LSBs of the reference, monotonic, and rounded to
+ *               the nearest degree.
+ *             - Range: the rails (0 and the oversampled full scale) are
+ *               invalid and hold the last angle; beyond the calibration
+ *               within the margin is limited to 0..180 degrees; a reversed
+ *               wiper; invalid calibrations.
+ ******************************************************************************/
+
+#include "servo_feedback.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see adc.h, servo.c, servo.h). */
+#define ADC_RESULT_BITS         14      /* 16x oversampling, right shift 2. */
+#define ADC_RESULT_MAX          ((1 << ADC_RESULT_BITS) - 1)
+#define RAW_AT_0_DEG            ((ADC_RESULT_MAX * 1) / 10)
+#define RAW_AT_180_DEG          ((ADC_RESULT_MAX * 9) / 10)
+#define NUM_CHANNELS            6       /* Servos: interleaved ADC scan. */
+#define SCANS_PER_BLOCK         1       /* ADC_SCANS_PER_BLOCK. */
+
+#define SCANS_AVERAGED          8
+#define DITHER                  5       /* Raw counts about a block's mean. */
+#define ERROR_MAX_Q16           2.0
+
+/*===== Private Function Prototypes ==========================================*/
+static void feedback_init(SERVO_FEEDBACK_t *fb);
+static double expected_q16(int32_t raw, int32_t raw_at_0, int32_t raw_at_180);
+static int32_t angle_to_raw(double angle_deg);
+static uint8_t angle_actual(const SERVO_FEEDBACK_t *fb, uint32_t channel);
+static void test_dma_halves(uint32_t num_scans);
+static void test_linearity(void);
+static void test_range(void);
+static void test_reversed(void);
+static void test_calibration(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_dma_halves(SCANS_PER_BLOCK);
+    test_dma_halves(SCANS_AVERAGED);
+    test_linearity();
+    test_range();
+    test_reversed();
+    test_calibration();
+    return test_result("test_feedback");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise the feedback as the firmware does: all servos at the
+ *         default calibration.
+ * @param  fb: Feedback object.
+ * @retval None.
+ */
+static void feedback_init(SERVO_FEEDBACK_t *fb)
+{
+    TEST_CHECK(servo_feedback_init(fb, NUM_CHANNELS), "initialisation rejected");
+    for (uint32_t i = 0; i < NUM_CHANNELS; i++)
+    {
+        TEST_CHECK(servo_feedback_set_calibration(fb, i, RAW_AT_0_DEG, RAW_AT_180_DEG),
+                   "servo %lu calibration rejected", (unsigned long)i);
+    }
+}
+
+/**
+ * @brief  The reference conversion (double precision).
+ * @param  raw:        Raw ADC value (block average).
+ * @param  raw_at_0:   Calibration: raw ADC value at 0 degrees.
+ * @param  raw_at_180: Calibration: raw ADC value at 180 degrees.
+ * @retval Angle in degrees, Q16.16 (unlimited).
+ */
+static double expected_q16(int32_t raw, int32_t raw_at_0, int32_t raw_at_180)
+{
+    return ((double)(raw - raw_at_0) * 180.0 * 65536.0) / (double)(raw_at_180 - raw_at_0);
+}
+
+/**
+ * @brief  The raw ADC value of an angle at the default calibration.
+ * @param  angle_deg: Angle in degrees.
+ * @retval Raw ADC value (nearest).
+ */
+static int32_t angle_to_raw(double angle_deg)
+{
+    return RAW_AT_0_DEG + (int32_t)lround((angle_deg * (RAW_AT_180_DEG - RAW_AT_0_DEG)) / 180.0);
+}
+
+/**
+ * @brief  A channel's angle in whole degrees, rounded as
+ *         servo_get_angle_actual does (see servo.c).
+ * @param  fb:      Feedback object.
+ * @param  channel: Channel.
+ * @retval Angle in degrees.
+ */
+static uint8_t angle_actual(const SERVO_FEEDBACK_t *fb, uint32_t channel)
+{
+    return (uint8_t)((servo_feedback_get_angle_q16(fb, channel) + (1 << 15)) >> 16);
+}
+
+/**
+ * @brief  A DMA buffer of two halves (as adc.c's circular transfer): the
+ *         half transfer's block then the full transfer's, each with its own
+ *         angles for all servos, are converted within ERROR_MAX_Q16 of the
+ *         reference at the blocks' (integer) mean raw values.
+ * @param  num_scans: Scans per block.
+ * @retval None.
+ */
+static void test_dma_halves(uint32_t num_scans)
+{
+    static const double angles[2][NUM_CHANNELS] = {
+        {0.0, 30.0, 45.25, 90.0, 135.6, 180.0},
+        {180.0, 150.0, 90.0, 60.75, 1.0, 179.0},
+    };
+    uint16_t dma[2 * SCANS_AVERAGED * NUM_CHANNELS];
+    SERVO_FEEDBACK_t fb;
+    double error_max = 0.0;
+    uint32_t degree_mismatches = 0;
+
+    feedback_init(&fb);
+    test_rand_seed(7);
+    for (uint32_t half = 0; half < 2; half++)
+    {
+        uint16_t *block = &dma[half * num_scans * NUM_CHANNELS];
+
+        /* The scans of a block dither about the angle (one scan: the angle's raw value). */
+        for (uint32_t scan = 0; scan < num_scans; scan++)
+        {
+            for (uint32_t i = 0; i < NUM_CHANNELS; i++)
+            {
+                int32_t dither = (num_scans > 1) ? (int32_t)(test_rand_uniform() * ((2 * DITHER) + 1)) - DITHER : 0;
+                int32_t raw = angle_to_raw(angles[half][i]) + dither;
+                block[(scan * NUM_CHANNELS) + i] = (uint16_t)raw;
+            }
+        }
+    }
+
+    for (uint32_t half = 0; half < 2; half++)
+    {
+        const uint16_t *block = &dma[half * num_scans * NUM_CHANNELS];
+        uint32_t blocks = fb.block_count;
+
+        servo_feedback_process(&fb, block, num_scans);
+        TEST_CHECK(fb.block_count == (blocks + 1), "%s transfer not counted", half ? "full" : "half");
+        for (uint32_t i = 0; i < NUM_CHANNELS; i++)
+        {
+            int32_t sum = 0;
+            for (uint32_t scan = 0; scan < num_scans; scan++)
+            {
+                sum += block[(scan * NUM_CHANNELS) + i];
+            }
+            double expected = expected_q16(sum / (int32_t)num_scans, RAW_AT_0_DEG, RAW_AT_180_DEG);
+            expected = fmin(fmax(expected, 0.0), 180.0 * 65536.0);
+            error_max = fmax(error_max, fabs((double)servo_feedback_get_angle_q16(&fb, i) - expected));
+            degree_mismatches += (angle_actual(&fb, i) != (uint8_t)lround(expected / 65536.0));
+            TEST_CHECK(servo_feedback_is_valid(&fb, i), "%s transfer: servo %lu invalid", half ? "full" : "half",
+                       (unsigned long)i);
+        }
+    }
+    printf("%lu scan(s) per block: half/full transfer error max %.2f Q16.16 LSBs\n", (unsigned long)num_scans,
+           error_max);
+    TEST_CHECK(error_max <= ERROR_MAX_Q16, "%lu scan(s) per block: error %.2f LSBs", (unsigned long)num_scans,
+               error_max);
+    TEST_CHECK(degree_mismatches == 0, "%lu scan(s) per block: %lu angles not rounded to the nearest degree",
+               (unsigned long)num_scans, (unsigned long)degree_mismatches);
+}
+
+/**
+ * @brief  Every raw value over the calibrated range (one scan blocks): within
+ *         ERROR_MAX_Q16 of the reference, monotonic, and rounded to the
+ *         nearest degree (away from the half degree ties).
+ * @retval None.
+ */
+static void test_linearity(void)
+{
+    SERVO_FEEDBACK_t fb;
+    uint16_t scan[NUM_CHANNELS] = {0};
+    double error_max = 0.0;
+    int32_t prev = -1;
+    bool monotonic = true;
+    uint32_t degree_mismatches = 0;
+
+    feedback_init(&fb);
+    for (int32_t raw = RAW_AT_0_DEG; raw <= RAW_AT_180_DEG; raw++)
+    {
+        scan[0] = (uint16_t)raw;
+        servo_feedback_process(&fb, scan, 1);
+        int32_t angle = servo_feedback_get_angle_q16(&fb, 0);
+        double expected = expected_q16(raw, RAW_AT_0_DEG, RAW_AT_180_DEG);
+        double frac = fmod(expected / 65536.0, 1.0);
+
+        error_max = fmax(error_max, fabs((double)angle - expected));
+        monotonic &= (angle >= prev);
+        prev = angle;
+        if (fabs(frac - 0.5) > (ERROR_MAX_Q16 / 65536.0))
+        {
+            degree_mismatches += (angle_actual(&fb, 0) != (uint8_t)lround(expected / 65536.0));
+        }
+    }
+    printf("Linearity over %d raw values: error max %.2f Q16.16 LSBs\n", RAW_AT_180_DEG - RAW_AT_0_DEG + 1,
+           error_max);
+    TEST_CHECK(error_max <= ERROR_MAX_Q16, "linearity error %.2f LSBs", error_max);
+    TEST_CHECK(monotonic, "conversion not monotonic");
+    TEST_CHECK(degree_mismatches == 0, "%lu angles not rounded to the nearest degree",
+               (unsigned long)degree_mismatches);
+    TEST_CHECK(angle_actual(&fb, 0) == 180, "180 degrees reported as %u", angle_actual(&fb, 0));
+}
+
+/**
+ * @brief  The rails (a disconnected or shorted wiper) and the oversampled
+ *         full scale, also averaged over several scans, are invalid and hold
+ *         the last valid angle; values beyond the calibration within the
+ *         margin are valid and limited; a valid block recovers.
+ * @retval None.
+ */
+static void test_range(void)
+{
+    const int32_t margin = (RAW_AT_180_DEG - RAW_AT_0_DEG) / SERVO_FEEDBACK_VALID_MARGIN_DIV;
+    uint16_t scans[SCANS_AVERAGED * NUM_CHANNELS];
+    SERVO_FEEDBACK_t fb;
+
+    feedback_init(&fb);
+    for (uint32_t k = 0; k < TEST_NUM_ELS(scans); k++)
+    {
+        scans[k] = (uint16_t)angle_to_raw(90.0);
+    }
+    servo_feedback_process(&fb, scans, SCANS_AVERAGED);
+    int32_t held = servo_feedback_get_angle_q16(&fb, 0);
+
+    /* Rails: channel 0 at 0, channel 1 at the full scale; the others unaffected. */
+    for (uint32_t scan = 0; scan < SCANS_AVERAGED; scan++)
+    {
+        scans[(scan * NUM_CHANNELS) + 0] = 0;
+        scans[(scan * NUM_CHANNELS) + 1] = ADC_RESULT_MAX;
+    }
+    servo_feedback_process(&fb, scans, SCANS_AVERAGED);
+    TEST_CHECK(servo_feedback_is_valid(&fb, 0) == false, "0 V rail valid");
+    TEST_CHECK(servo_feedback_is_valid(&fb, 1) == false, "full scale (%d) valid", ADC_RESULT_MAX);
+    TEST_CHECK(servo_feedback_is_valid(&fb, 2), "servo 3 invalidated by the others' rails");
+    TEST_CHECK((servo_feedback_get_angle_q16(&fb, 0) == held) && (servo_feedback_get_angle_q16(&fb, 1) == held),
+               "invalid blocks published an angle");
+    TEST_CHECK(fb.block_count == 2, "invalid block not counted");
+
+    /* Beyond the calibration, just within the margin: limited to 0..180 degrees. */
+    scans[0] = (uint16_t)(RAW_AT_0_DEG - margin);
+    scans[1] = (uint16_t)(RAW_AT_180_DEG + margin);
+    scans[2] = (uint16_t)(RAW_AT_180_DEG + margin + 1);
+    servo_feedback_process(&fb, scans, 1);
+    TEST_CHECK(servo_feedback_is_valid(&fb, 0) && (servo_feedback_get_angle_q16(&fb, 0) == 0),
+               "below 0 degrees within the margin: valid %d, angle %ld", servo_feedback_is_valid(&fb, 0),
+               (long)servo_feedback_get_angle_q16(&fb, 0));
+    TEST_CHECK(servo_feedback_is_valid(&fb, 1) && (servo_feedback_get_angle_q16(&fb, 1) == (180 << 16)),
+               "above 180 degrees within the margin: valid %d, angle %ld", servo_feedback_is_valid(&fb, 1),
+               (long)servo_feedback_get_angle_q16(&fb, 1));
+    TEST_CHECK(servo_feedback_is_valid(&fb, 2) == false, "beyond the margin valid");
+    TEST_CHECK(angle_actual(&fb, 1) == 180, "180 degrees reported as %u", angle_actual(&fb, 1));
+
+    /* No scans: nothing published or counted. */
+    uint32_t blocks = fb.block_count;
+    servo_feedback_process(&fb, scans, 0);
+    TEST_CHECK((fb.block_count == blocks) && servo_feedback_is_valid(&fb, 0), "empty block processed");
+}
+
+/**
+ * @brief  A reversed wiper (raw value falling with the angle): the
+ *         conversion against the reference.
+ * @retval None.
+ */
+static void test_reversed(void)
+{
+    SERVO_FEEDBACK_t fb;
+    uint16_t scan[NUM_CHANNELS] = {0};
+    double error_max = 0.0;
+
+    feedback_init(&fb);
+    TEST_CHECK(servo_feedback_set_calibration(&fb, 0, RAW_AT_180_DEG, RAW_AT_0_DEG), "reversed calibration rejected");
+    for (int32_t raw = RAW_AT_0_DEG; raw <= RAW_AT_180_DEG; raw += 7)
+    {
+        scan[0] = (uint16_t)raw;
+        servo_feedback_process(&fb, scan, 1);
+        double expected = expected_q16(raw, RAW_AT_180_DEG, RAW_AT_0_DEG);
+        error_max = fmax(error_max, fabs((double)servo_feedback_get_angle_q16(&fb, 0) - expected));
+    }
+    scan[0] = RAW_AT_180_DEG;
+    servo_feedback_process(&fb, scan, 1);
+    printf("Reversed wiper: error max %.2f Q16.16 LSBs\n", error_max);
+    TEST_CHECK(error_max <= ERROR_MAX_Q16, "reversed wiper error %.2f LSBs", error_max);
+    TEST_CHECK(servo_feedback_get_angle_q16(&fb, 0) == 0, "reversed wiper at the 0 degree end: %ld",
+               (long)servo_feedback_get_angle_q16(&fb, 0));
+}
+
+/**
+ * @brief  Invalid channel counts and calibrations are rejected; a channel is
+ *         invalid until calibrated.
+ * @retval None.
+ */
+static void test_calibration(void)
+{
+    SERVO_FEEDBACK_t fb;
+    uint16_t scan[NUM_CHANNELS];
+
+    TEST_CHECK(servo_feedback_init(&fb, 0) == false, "no channels accepted");
+    TEST_CHECK(servo_feedback_init(&fb, SERVO_FEEDBACK_MAX_CHANNELS + 1) == false, "too many channels accepted");
+    TEST_CHECK(servo_feedback_init(&fb, NUM_CHANNELS), "initialisation rejected");
+    TEST_CHECK(servo_feedback_set_calibration(&fb, NUM_CHANNELS, RAW_AT_0_DEG, RAW_AT_180_DEG) == false,
+               "calibration of a channel beyond the scan accepted");
+    TEST_CHECK(servo_feedback_set_calibration(&fb, 0, RAW_AT_0_DEG, RAW_AT_0_DEG) == false,
+               "zero span calibration accepted");
+
+    for (uint32_t i = 0; i < NUM_CHANNELS; i++)
+    {
+        scan[i] = (uint16_t)angle_to_raw(90.0);
+    }
+    servo_feedback_process(&fb, scan, 1);
+    TEST_CHECK(servo_feedback_is_valid(&fb, 0) == false, "uncalibrated channel valid");
+}
+
+/*============================================================================*/
\ No newline at end of file
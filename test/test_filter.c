@@ -0,0 +1,321 @@
+/*******************************************************************************
+ * @file   test_filter.c
+ * @brief  Digital filter host test: each kernel as the servo feedback uses it
+ *         (see servo.c), at the 50 Hz feedback sample rate.
+ *             - Low-pass: DC gain, -3 dB at the cut-off, attenuation above
+ *               it; the fixed-point biquad against the floating-point one.
+ *             - Notch: rejection at the centre, unity gain away from it.
+ *             - Blocks: one block of N samples equals N blocks of one, and
+ *               a strided (interleaved) channel equals a contiguous one.
+ *             - Settling.
+ *             - Cycles per block and per sample for block sizes
+ *               1..FILTER_MAX_BLOCK_SIZE (benchmark): the feedback's block
+ *               is one sample (ADC_SCANS_PER_BLOCK).
+ ******************************************************************************/
+
+#include "filter.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <stdlib.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo.h, servo.c). */
+#define SAMPLE_RATE_HZ          50.0f
+#define LOWPASS_HZ              5.0f
+#define LOWPASS_Q               0.7071f
+#define NOTCH_HZ                12.0f
+#define NOTCH_Q                 2.0f
+#define NUM_CHANNELS            6       /* Servos: interleaved ADC scan. */
+
+#define DC_LEVEL                10000
+#define SINE_AMPLITUDE          4000.0f
+#define SINE_SAMPLES            400     /* Amplitude measured over the last half. */
+#define BENCH_SAMPLES           (1 << 16)
+
+/* The feedback FIR low-pass (see servo.c). */
+static const q15_t _fir_lowpass[] = {287, 1571, 5375, 9151, 9151, 5375, 1571, 287};
+
+/*===== Private Function Prototypes ==========================================*/
+static bool init_filter(FILTER_t *filter, FILTER_TYPE_t type, bool notch);
+static float sine_gain(FILTER_TYPE_t type, bool notch, float freq);
+static void test_lowpass(void);
+static void test_notch(void);
+static void test_blocks(void);
+static void test_settling(void);
+static void bench_blocks(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_lowpass();
+    test_notch();
+    test_blocks();
+    test_settling();
+    bench_blocks();
+    return test_result("test_filter");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a filter as the servo feedback: the biquads a low-pass
+ *         stage and, optionally, a notch stage; the FIR the fixed low-pass.
+ * @param  filter: Filter.
+ * @param  type:   Filter kernel.
+ * @param  notch:  Biquads: notch stage only (no low-pass).
+ * @retval Boolean indicating whether the filter was initialised.
+ */
+static bool init_filter(FILTER_t *filter, FILTER_TYPE_t type, bool notch)
+{
+    float32_t coeffs[FILTER_BIQUAD_NUM_COEFFS];
+
+    if (notch)
+    {
+        filter_design_notch(coeffs, SAMPLE_RATE_HZ, NOTCH_HZ, NOTCH_Q);
+    }
+    else
+    {
+        filter_design_lowpass(coeffs, SAMPLE_RATE_HZ, LOWPASS_HZ, LOWPASS_Q);
+    }
+
+    switch (type)
+    {
+        case FILTER_TYPE__BIQUAD_F32: return filter_init_biquad_f32(filter, coeffs, 1);
+        case FILTER_TYPE__BIQUAD_Q31: return filter_init_biquad_q31(filter, coeffs, 1);
+        case FILTER_TYPE__FIR_Q15:    return filter_init_fir_q15(filter, _fir_lowpass, 8);
+        default:                      filter_init_none(filter); return true;
+    }
+}
+
+/**
+ * @brief  Steady-state gain of a filter to a sine about DC_LEVEL.
+ * @param  type:  Filter kernel.
+ * @param  notch: Biquads: notch stage only.
+ * @param  freq:  Sine frequency (Hz).
+ * @retval Gain (output peak-to-peak / input peak-to-peak).
+ */
+static float sine_gain(FILTER_TYPE_t type, bool notch, float freq)
+{
+    FILTER_t filter;
+    float low = 1e9f;
+    float high = -1e9f;
+
+    init_filter(&filter, type, notch);
+    for (uint32_t k = 0; k < SINE_SAMPLES; k++)
+    {
+        float x = DC_LEVEL + (SINE_AMPLITUDE * sinf(6.2831853f * freq * (float)k / SAMPLE_RATE_HZ));
+        uint16_t sample = (uint16_t)lrintf(x);
+        filter_process(&filter, &sample, &sample, 1, 1);
+        if (k >= (SINE_SAMPLES / 2))
+        {
+            low = fminf(low, (float)sample);
+            high = fmaxf(high, (float)sample);
+        }
+    }
+    return (high - low) / (2.0f * SINE_AMPLITUDE);
+}
+
+/**
+ * @brief  Low-pass kernels: unity DC gain, -3 dB (biquads) at the cut-off,
+ *         and attenuation towards Nyquist; the Q1.31 biquad follows the
+ *         floating-point one within a count.
+ * @retval None.
+ */
+static void test_lowpass(void)
+{
+    const FILTER_TYPE_t types[] = {FILTER_TYPE__BIQUAD_F32, FILTER_TYPE__BIQUAD_Q31, FILTER_TYPE__FIR_Q15};
+    const char *names[] = {"biquad f32", "biquad q31", "FIR q15"};
+
+    for (uint32_t t = 0; t < 3; t++)
+    {
+        FILTER_t filter;
+        uint16_t sample = 0;
+
+        TEST_CHECK(init_filter(&filter, types[t], false), "%s not initialised", names[t]);
+        for (uint32_t k = 0; k < 100; k++)
+        {
+            sample = DC_LEVEL;
+            filter_process(&filter, &sample, &sample, 1, 1);
+        }
+        float cutoff = sine_gain(types[t], false, LOWPASS_HZ);
+        float stop = sine_gain(types[t], false, 20.0f);
+        printf("%s low-pass: DC %u, gain %.3f at %.0f Hz, %.3f at 20 Hz\n", names[t], (unsigned int)sample,
+               (double)cutoff, (double)LOWPASS_HZ, (double)stop);
+        TEST_CHECK(abs((int)sample - DC_LEVEL) <= 1, "%s DC output %u", names[t], (unsigned int)sample);
+        TEST_CHECK(stop < 0.1f, "%s gain %.3f at 20 Hz", names[t], (double)stop);
+        if (types[t] != FILTER_TYPE__FIR_Q15)
+        {
+            TEST_CHECK(fabsf(cutoff - 0.7071f) < 0.03f, "%s gain %.3f at the cut-off", names[t], (double)cutoff);
+        }
+    }
+
+    /* Fixed against floating-point on a noisy input. */
+    FILTER_t f32;
+    FILTER_t q31;
+    int32_t diff_max = 0;
+    init_filter(&f32, FILTER_TYPE__BIQUAD_F32, false);
+    init_filter(&q31, FILTER_TYPE__BIQUAD_Q31, false);
+    test_rand_seed(9);
+    for (uint32_t k = 0; k < 2000; k++)
+    {
+        uint16_t a = (uint16_t)(DC_LEVEL + (int32_t)(2000.0f * test_rand_gauss()));
+        uint16_t b = a;
+        filter_process(&f32, &a, &a, 1, 1);
+        filter_process(&q31, &b, &b, 1, 1);
+        diff_max = (abs((int32_t)a - (int32_t)b) > diff_max) ? abs((int32_t)a - (int32_t)b) : diff_max;
+    }
+    printf("biquad q31 against f32: max difference %ld counts\n", (long)diff_max);
+    TEST_CHECK(diff_max <= 1, "q31 against f32 differs by %ld counts", (long)diff_max);
+}
+
+/**
+ * @brief  Notch (both biquad kernels): the centre rejected, unity gain two
+ *         octaves below it.
+ * @retval None.
+ */
+static void test_notch(void)
+{
+    const FILTER_TYPE_t types[] = {FILTER_TYPE__BIQUAD_F32, FILTER_TYPE__BIQUAD_Q31};
+
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        float centre = sine_gain(types[t], true, NOTCH_HZ);
+        float below = sine_gain(types[t], true, NOTCH_HZ / 4.0f);
+        printf("notch %s: gain %.3f at %.0f Hz, %.3f at %.0f Hz\n", (t == 0) ? "f32" : "q31", (double)centre,
+               (double)NOTCH_HZ, (double)below, (double)(NOTCH_HZ / 4.0f));
+        TEST_CHECK(centre < 0.02f, "notch gain %.3f at the centre", (double)centre);
+        TEST_CHECK(fabsf(below - 1.0f) < 0.05f, "notch gain %.3f away from the centre", (double)below);
+    }
+}
+
+/**
+ * @brief  Block processing: FILTER_MAX_BLOCK_SIZE samples in one block equal
+ *         the same samples one per block, and one channel of an interleaved
+ *         block (stride NUM_CHANNELS) equals the contiguous channel.
+ * @retval None.
+ */
+static void test_blocks(void)
+{
+    const FILTER_TYPE_t types[] = {FILTER_TYPE__BIQUAD_F32, FILTER_TYPE__BIQUAD_Q31, FILTER_TYPE__FIR_Q15};
+    uint16_t input[4 * FILTER_MAX_BLOCK_SIZE];
+    uint32_t mismatches = 0;
+
+    test_rand_seed(5);
+    for (uint32_t k = 0; k < TEST_NUM_ELS(input); k++)
+    {
+        input[k] = (uint16_t)(test_rand_uniform() * FILTER_INPUT_MAX);
+    }
+
+    for (uint32_t t = 0; t < 3; t++)
+    {
+        FILTER_t single;
+        FILTER_t block;
+        FILTER_t strided;
+        uint16_t out_single[TEST_NUM_ELS(input)];
+        uint16_t out_block[TEST_NUM_ELS(input)];
+        uint16_t interleaved[TEST_NUM_ELS(input) * NUM_CHANNELS] = {0};
+
+        init_filter(&single, types[t], false);
+        init_filter(&block, types[t], false);
+        init_filter(&strided, types[t], false);
+        for (uint32_t k = 0; k < TEST_NUM_ELS(input); k++)
+        {
+            filter_process(&single, &input[k], &out_single[k], 1, 1);
+            interleaved[(k * NUM_CHANNELS) + 2] = input[k];
+        }
+        for (uint32_t k = 0; k < TEST_NUM_ELS(input); k += FILTER_MAX_BLOCK_SIZE)
+        {
+            filter_process(&block, &input[k], &out_block[k], 1, FILTER_MAX_BLOCK_SIZE);
+            filter_process(&strided, &interleaved[(k * NUM_CHANNELS) + 2], &interleaved[(k * NUM_CHANNELS) + 2],
+                           NUM_CHANNELS, FILTER_MAX_BLOCK_SIZE);
+        }
+        for (uint32_t k = 0; k < TEST_NUM_ELS(input); k++)
+        {
+            mismatches += (out_block[k] != out_single[k]);
+            mismatches += (interleaved[(k * NUM_CHANNELS) + 2] != out_single[k]);
+            mismatches += (interleaved[(k * NUM_CHANNELS) + 1] != 0) || (interleaved[(k * NUM_CHANNELS) + 3] != 0);
+        }
+    }
+    TEST_CHECK(mismatches == 0, "block/strided processing differs from single samples at %lu samples",
+               (unsigned long)mismatches);
+}
+
+/**
+ * @brief  Settling: not settled until the kernel's settle samples after
+ *         initialisation and after a reset; a pass-through always settled.
+ * @retval None.
+ */
+static void test_settling(void)
+{
+    FILTER_t filter;
+    uint16_t sample = DC_LEVEL;
+    uint32_t settled_at = 0;
+
+    filter_init_none(&filter);
+    TEST_CHECK(filter_is_settled(&filter), "pass-through not settled");
+
+    init_filter(&filter, FILTER_TYPE__BIQUAD_F32, false);
+    for (uint32_t pass = 0; pass < 2; pass++)
+    {
+        settled_at = 0;
+        for (uint32_t k = 1; (k <= 100) && (settled_at == 0); k++)
+        {
+            filter_process(&filter, &sample, &sample, 1, 1);
+            settled_at = filter_is_settled(&filter) ? k : 0;
+        }
+        TEST_CHECK(settled_at == FILTER_BIQUAD_SETTLE_SAMPLES_PER_STAGE, "settled after %lu samples (pass %lu)",
+                   (unsigned long)settled_at, (unsigned long)pass);
+        filter_reset(&filter);
+        TEST_CHECK(filter_is_settled(&filter) == false, "settled after a reset");
+    }
+}
+
+/**
+ * @brief  Benchmark: host cycles per filter_process block and per sample,
+ *         each kernel, block sizes 1..FILTER_MAX_BLOCK_SIZE (powers of two).
+ * @retval None.
+ */
+static void bench_blocks(void)
+{
+    const FILTER_TYPE_t types[] = {FILTER_TYPE__NONE, FILTER_TYPE__BIQUAD_F32, FILTER_TYPE__BIQUAD_Q31,
+                                   FILTER_TYPE__FIR_Q15};
+    const char *names[] = {"none", "biquad f32", "biquad q31", "FIR q15"};
+    static uint16_t samples[BENCH_SAMPLES * NUM_CHANNELS];
+
+    test_rand_seed(7);
+    for (uint32_t k = 0; k < TEST_NUM_ELS(samples); k++)
+    {
+        samples[k] = (uint16_t)(test_rand_uniform() * FILTER_INPUT_MAX);
+    }
+
+    printf("bench: host cycles per block (per sample), interleaved channel:\n");
+    for (uint32_t t = 0; t < 4; t++)
+    {
+        printf("    %-10s", names[t]);
+        for (uint32_t size = 1; size <= FILTER_MAX_BLOCK_SIZE; size *= 2)
+        {
+            FILTER_t filter;
+            init_filter(&filter, types[t], false);
+
+            uint64_t start = test_cycles();
+            for (uint32_t k = 0; k < BENCH_SAMPLES; k += size)
+            {
+                filter_process(&filter, &samples[k * NUM_CHANNELS], &samples[k * NUM_CHANNELS], NUM_CHANNELS, size);
+            }
+            uint64_t cycles = test_cycles() - start;
+            double per_block = (double)cycles / (double)(BENCH_SAMPLES / size);
+            printf("  %2lu: %6.1f (%5.1f)", (unsigned long)size, per_block, per_block / size);
+        }
+        printf("\n");
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
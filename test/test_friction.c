@@ -0,0 +1,399 @@
+/*******************************************************************************
+ * @file   test_friction.c
+ * @brief  Friction compensation host test: the firmware's PID loop (see
+ *         test_pid.c, with the Kalman estimator) and the friction
+ *         compensation under it (see friction_step in servo_ctrl.c) on the
+ *         plant model at 1 kHz, the servo with a deadband, Coulomb friction
+ *         and stiction, and noisy feedback.
+ *             - Hold position limit cycle: without compensation the
+ *               controller's integrator winds up breakaways that overshoot,
+ *               and the servo hunts about a held position; with the
+ *               compensation (the plant's parameters) the limit cycle is
+ *               gone, over several positions and noise seeds.
+ *             - Identification: the open-loop sweep's parameters against
+ *               the plant's, and the limit cycle gone with them.
+ *             - Cycles per compensation update and per observer step
+ *               (benchmark).
+ ******************************************************************************/
+
+#include "estimator.h"
+#include "friction.h"
+#include "pid.h"
+#include "plant.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000.0f
+#define FRAME_RATE_HZ           50.0f
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define PID_OUTPUT_MAX          30.0f
+#define MODEL_WN_HZ             6.0f
+#define MODEL_ZETA              0.8f
+
+/* The servo's friction (see plant.h). */
+#define DEADBAND_DEG            0.5f
+#define STICTION_DEG            1.0f
+#define COULOMB_DEG             0.6f
+#define NOISE_DEG               0.03f
+
+#define START_DEG               90.0f
+#define HOLD_S                  20.0f
+#define MEASURE_FROM_S          10.0f   /* Hold measured from here, after the step has settled. */
+#define NUM_SEEDS               3
+#define LIMIT_CYCLE_PP_DEG      0.2f    /* Hunting: position peak-to-peak beyond this whilst held. */
+#define BENCH_UPDATES           100000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct LOOP_t {
+    PID_t pid;
+    ESTIMATOR_t est;
+    FRICTION_t friction;
+    PLANT_t plant;
+    bool compensate;
+    float latched;              /* Command latched at the last frame boundary. */
+} LOOP_t;
+
+typedef struct HOLD_RESULT_t {
+    float pp;                   /* Position peak-to-peak (degrees). */
+    uint32_t breakaways;        /* Starts from standstill. */
+    float error;                /* Mean absolute error (degrees). */
+} HOLD_RESULT_t;
+
+static const float _setpoints[] = {97.3f, 100.0f, 103.7f, 110.2f};
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, const FRICTION_PARAMS_t *params);
+static void loop_step(LOOP_t *loop, float setpoint);
+static HOLD_RESULT_t run_hold(const FRICTION_PARAMS_t *params, float setpoint, uint32_t seed);
+static void hold_all(const char *name, const FRICTION_PARAMS_t *params, HOLD_RESULT_t *best, HOLD_RESULT_t *worst);
+static void test_limit_cycle(void);
+static void test_identify(void);
+static void bench_friction(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_limit_cycle();
+    test_identify();
+    bench_friction();
+    return test_result("test_friction");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise the loop at START_DEG on the servo with friction.
+ * @param  loop:   Loop.
+ * @param  params: Friction parameters compensated; NULL for none.
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, const FRICTION_PARAMS_t *params)
+{
+    const PID_CONFIG_t pid_config = {
+        .kp = 0.5f,
+        .ki = 5.0f,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__RATE,
+    };
+    const ESTIMATOR_CONFIG_t est_config = {
+        .type = ESTIMATOR_TYPE__KALMAN,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .meas_period_s = 1.0f / FRAME_RATE_HZ,
+        .alpha = 0.5f,
+        .beta = 0.17f,
+        .gamma = 0.03f,
+        .process_noise = 1.0e5f,
+        .meas_noise = 0.25f,
+        .init_var_vel = 1.0e4f,
+        .init_var_acc = 1.0e6f,
+    };
+    const FRICTION_CONFIG_t friction_config = {
+        .period_s = 1.0f / FRAME_RATE_HZ,
+        .wn = 6.2831853f * MODEL_WN_HZ,
+        .zeta = MODEL_ZETA,
+        .l_pos = 0.3f,
+        .l_vel = 0.0f,
+        .l_dist = 0.05f,
+        .dist_max = 10.0f,
+        .slope = 3.0f,
+        .lead_s = 0.02f,
+        .still_speed = 2.0f,
+        .hold_band = 0.3f,
+    };
+    PLANT_CONFIG_t plant_config = PLANT_CONFIG_DEFAULT;
+
+    plant_config.deadband_deg = DEADBAND_DEG;
+    plant_config.stiction_deg = STICTION_DEG;
+    plant_config.coulomb_deg = COULOMB_DEG;
+    plant_config.noise_deg = NOISE_DEG;
+    pid_init(&loop->pid, &pid_config);
+    estimator_init(&loop->est, &est_config);
+    (void)friction_init(&loop->friction, &friction_config);
+    loop->compensate = (params != NULL) && friction_set_params(&loop->friction, params);
+    plant_init(&loop->plant, &plant_config, START_DEG);
+    loop->latched = loop->plant.command;
+}
+
+/**
+ * @brief  Run one loop iteration as the firmware: the estimator, the
+ *         friction compensation's observer stepped with each feedback sample
+ *         (with the latched command) and its offset added to the command,
+ *         the controller given no error whilst holding, and the command
+ *         limited to the servo's range and the slew limit about the latched
+ *         command.
+ * @param  loop:     Loop.
+ * @param  setpoint: Setpoint (degrees; held).
+ * @retval None.
+ */
+static void loop_step(LOOP_t *loop, float setpoint)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    float feedback = loop->plant.feedback;
+
+    estimator_predict(&loop->est);
+    if (loop->plant.feedback_new || (estimator_is_valid(&loop->est) == false))
+    {
+        estimator_correct(&loop->est, feedback);
+    }
+    float velocity = estimator_get_velocity(&loop->est);
+
+    float command = setpoint;
+    float target = setpoint;
+    if (loop->compensate)
+    {
+        if (loop->plant.feedback_new)
+        {
+            friction_observe(&loop->friction, loop->latched, feedback);
+        }
+        command += friction_update(&loop->friction, setpoint - feedback, 0.0f, velocity);
+        target = friction_is_holding(&loop->friction) ? feedback : setpoint;
+    }
+    float command_min = fmaxf(0.0f, loop->latched - slew_step);
+    float command_max = fminf(ANGLE_MAX, loop->latched + slew_step);
+    pid_set_actuator_limits(&loop->pid, command_min - command, command_max - command);
+    command += pid_update_rate(&loop->pid, target, feedback, velocity);
+    command = fmaxf(command_min, fminf(command_max, command));
+    if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+    {
+        loop->latched = command;
+    }
+    plant_step(&loop->plant, command);
+}
+
+/**
+ * @brief  Step to a setpoint and hold it: the position's peak-to-peak, the
+ *         breakaways and the error once settled.
+ * @param  params:   Friction parameters compensated; NULL for none.
+ * @param  setpoint: Setpoint (degrees).
+ * @param  seed:     Feedback noise seed.
+ * @retval Result.
+ */
+static HOLD_RESULT_t run_hold(const FRICTION_PARAMS_t *params, float setpoint, uint32_t seed)
+{
+    HOLD_RESULT_t result = {0};
+    LOOP_t loop;
+    float position_min = 1e9f;
+    float position_max = -1e9f;
+    double error_sum = 0.0;
+    uint32_t n = 0;
+
+    test_rand_seed(seed);
+    loop_init(&loop, params);
+    for (uint32_t k = 0; k < (uint32_t)(HOLD_S * LOOP_RATE_HZ); k++)
+    {
+        bool still = (loop.plant.velocity == 0.0f);
+        loop_step(&loop, setpoint);
+        if (k >= (uint32_t)(MEASURE_FROM_S * LOOP_RATE_HZ))
+        {
+            position_min = fminf(position_min, loop.plant.position);
+            position_max = fmaxf(position_max, loop.plant.position);
+            result.breakaways += (still && (loop.plant.velocity != 0.0f)) ? 1U : 0U;
+            error_sum += (double)fabsf(setpoint - loop.plant.position);
+            n++;
+        }
+    }
+    result.pp = position_max - position_min;
+    result.error = (float)(error_sum / (double)n);
+    return result;
+}
+
+/**
+ * @brief  Hold each setpoint (for each seed): the best and worst
+ *         peak-to-peak, breakaways and error.
+ * @param  name:   Case name.
+ * @param  params: Friction parameters compensated; NULL for none.
+ * @param  best:   Best result. Passed by reference.
+ * @param  worst:  Worst result. Passed by reference.
+ * @retval None.
+ */
+static void hold_all(const char *name, const FRICTION_PARAMS_t *params, HOLD_RESULT_t *best, HOLD_RESULT_t *worst)
+{
+    *best = (HOLD_RESULT_t){.pp = 1e9f, .breakaways = UINT32_MAX, .error = 1e9f};
+    *worst = (HOLD_RESULT_t){0};
+    for (uint32_t i = 0; i < TEST_NUM_ELS(_setpoints); i++)
+    {
+        for (uint32_t seed = 1; seed <= NUM_SEEDS; seed++)
+        {
+            HOLD_RESULT_t result = run_hold(params, _setpoints[i], seed);
+            worst->pp = fmaxf(worst->pp, result.pp);
+            worst->breakaways = (result.breakaways > worst->breakaways) ? result.breakaways : worst->breakaways;
+            worst->error = fmaxf(worst->error, result.error);
+            best->pp = fminf(best->pp, result.pp);
+            best->breakaways = (result.breakaways < best->breakaways) ? result.breakaways : best->breakaways;
+            best->error = fminf(best->error, result.error);
+        }
+    }
+    printf("%s: hold %.0f..%.0f s, position peak-to-peak %.3f..%.3f deg, breakaways %lu..%lu, error %.3f..%.3f "
+           "deg\n",
+           name, (double)MEASURE_FROM_S, (double)HOLD_S, (double)best->pp, (double)worst->pp,
+           (unsigned long)best->breakaways, (unsigned long)worst->breakaways, (double)best->error,
+           (double)worst->error);
+}
+
+/**
+ * @brief  The hold position limit cycle: present without compensation (at
+ *         every setpoint and seed), gone with the plant's parameters
+ *         compensated.
+ * @retval None.
+ */
+static void test_limit_cycle(void)
+{
+    /* The deadband is not distinguishable from friction by the command: both offset it. */
+    const FRICTION_PARAMS_t params = {
+        .coulomb = COULOMB_DEG + DEADBAND_DEG,
+        .breakaway = STICTION_DEG + DEADBAND_DEG,
+        .viscous = 0.0f,
+    };
+    HOLD_RESULT_t best;
+    HOLD_RESULT_t worst;
+
+    hold_all("no compensation", NULL, &best, &worst);
+    TEST_CHECK(best.pp > LIMIT_CYCLE_PP_DEG, "no limit cycle without compensation (%.3f deg peak-to-peak)",
+               (double)best.pp);
+    TEST_CHECK(best.breakaways >= 2, "no limit cycle without compensation (%lu breakaways)",
+               (unsigned long)best.breakaways);
+
+    hold_all("compensated", &params, &best, &worst);
+    TEST_CHECK(worst.pp < (0.25f * LIMIT_CYCLE_PP_DEG), "compensated: %.3f deg peak-to-peak", (double)worst.pp);
+    TEST_CHECK(worst.breakaways <= 1, "compensated: %lu breakaways", (unsigned long)worst.breakaways);
+    TEST_CHECK(worst.error < 0.3f, "compensated: error %.3f deg", (double)worst.error);
+}
+
+/**
+ * @brief  Identify the parameters with the open-loop sweep (as the
+ *         firmware: the excitation about the start position, stepped with
+ *         each feedback sample), for each noise seed: the Coulomb offset and
+ *         the breakaway against the plant's friction plus deadband, and the
+ *         limit cycle gone with them compensated. The breakaway is over-
+ *         estimated by up to the travel the sweep detects it by (and a
+ *         frame's command travel): a single slip may follow, but no cycle.
+ * @retval None.
+ */
+static void test_identify(void)
+{
+    const FRICTION_ID_CONFIG_t config = {
+        .period_s = 1.0f / FRAME_RATE_HZ,
+        .amplitude = 10.0f,
+        .speed_min = 5.0f,
+        .speed_max = 60.0f,
+        .settle_s = 0.3f,
+        .still_speed = 2.0f,
+        .breakaway_travel = 0.1f,
+        .model_slope = (2.0f * MODEL_ZETA) / (6.2831853f * MODEL_WN_HZ),
+    };
+
+    for (uint32_t seed = 1; seed <= NUM_SEEDS; seed++)
+    {
+        FRICTION_ID_t id;
+        FRICTION_PARAMS_t params = {0};
+        LOOP_t loop;
+        float excitation = 0.0f;
+        float seconds = 0.0f;
+
+        test_rand_seed(seed);
+        loop_init(&loop, NULL);
+        (void)friction_id_start(&id, &config);
+        for (uint32_t k = 0; (k < (uint32_t)(120.0f * LOOP_RATE_HZ)) &&
+                             (friction_id_get_state(&id, NULL) == FRICTION_ID_STATE__RUNNING);
+             k++)
+        {
+            estimator_predict(&loop.est);
+            if (loop.plant.feedback_new || (estimator_is_valid(&loop.est) == false))
+            {
+                estimator_correct(&loop.est, loop.plant.feedback);
+            }
+            if (loop.plant.feedback_new)
+            {
+                excitation = friction_id_update(&id, loop.plant.command, loop.plant.feedback,
+                                                estimator_get_velocity(&loop.est));
+            }
+            plant_step(&loop.plant, START_DEG + excitation);
+            seconds = (float)k / LOOP_RATE_HZ;
+        }
+        FRICTION_ID_STATE_t state = friction_id_get_state(&id, &params);
+        printf("seed %lu identified in %.1f s: Coulomb %.3f deg (plant %.3f), breakaway %.3f deg (plant %.3f), "
+               "viscous %.5f deg/(deg/s)\n",
+               (unsigned long)seed, (double)seconds, (double)params.coulomb, (double)(COULOMB_DEG + DEADBAND_DEG),
+               (double)params.breakaway, (double)(STICTION_DEG + DEADBAND_DEG), (double)params.viscous);
+        TEST_CHECK(state == FRICTION_ID_STATE__DONE, "seed %lu identification state %d", (unsigned long)seed,
+                   (int)state);
+        TEST_CHECK(fabsf(params.coulomb - (COULOMB_DEG + DEADBAND_DEG)) < 0.2f, "seed %lu identified Coulomb %.3f deg",
+                   (unsigned long)seed, (double)params.coulomb);
+        TEST_CHECK(fabsf(params.breakaway - (STICTION_DEG + DEADBAND_DEG)) < 0.3f,
+                   "seed %lu identified breakaway %.3f deg", (unsigned long)seed, (double)params.breakaway);
+
+        HOLD_RESULT_t best;
+        HOLD_RESULT_t worst;
+        hold_all("  identified, compensated", &params, &best, &worst);
+        TEST_CHECK(worst.pp < LIMIT_CYCLE_PP_DEG, "seed %lu identified: %.3f deg peak-to-peak",
+                   (unsigned long)seed, (double)worst.pp);
+        TEST_CHECK(worst.breakaways <= 1, "seed %lu identified: %lu breakaways", (unsigned long)seed,
+                   (unsigned long)worst.breakaways);
+    }
+}
+
+/**
+ * @brief  Cycles per compensation update and per observer step.
+ * @retval None.
+ */
+static void bench_friction(void)
+{
+    const FRICTION_PARAMS_t params = {.coulomb = 1.1f, .breakaway = 1.5f, .viscous = 0.001f};
+    LOOP_t loop;
+    volatile float sink = 0.0f;
+
+    loop_init(&loop, &params);
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_UPDATES; k++)
+    {
+        sink += friction_update(&loop.friction, 0.01f * (float)((int32_t)(k % 200) - 100), 0.0f, 1.0f);
+    }
+    uint64_t update_cycles = test_cycles() - start;
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_UPDATES; k++)
+    {
+        friction_observe(&loop.friction, 90.0f + (0.01f * (float)(k % 100)), 90.0f);
+    }
+    uint64_t observe_cycles = test_cycles() - start;
+    sink += friction_get_disturbance(&loop.friction);
+    (void)sink;
+    printf("friction: %.1f cycles per update, %.1f cycles per observer step\n",
+           (double)update_cycles / (double)BENCH_UPDATES, (double)observe_cycles / (double)BENCH_UPDATES);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,601 @@
+/*******************************************************************************
+ * @file   test_gain_sched.c
+ * @brief  Gain scheduling table host test.
+ *             - Lookup: bilinear interpolation over the position x load grid
+ *               against a double-precision reference on random tables and
+ *               axes, breakpoints returned as loaded, and a bilinear
+ *               function reproduced.
+ *             - Edge clamping: positions and loads beyond the axes (and NaN,
+ *               infinities) held at the edge values.
+ *             - Loading: invalid breakpoints and axes rejected, leaving the
+ *               active table as it was.
+ *             - Glitch-free switching: a lookup between any two of the
+ *               loader's steps sees the old table until the commit and the
+ *               new one after it; lookups from a timer signal pre-empting a
+ *               loader loading tables back to back (as the control loop's
+ *               interrupt does the COM port task) only ever see a whole
+ *               table.
+ *             - Cycles per lookup (benchmark).
+ ******************************************************************************/
+
+#include "gain_sched.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.c). */
+#define POS_MIN                 0.0f
+#define POS_MAX                 180.0f
+#define LOAD_MAX                10.0f
+
+#define LOOKUPS                 100000
+#define LOOKUP_TOL              1.0e-5
+#define PROBES                  7
+#define TIMER_US                50
+#define ISR_LOOKUPS             2000    /* Pre-empting lookups to see whilst loading. */
+#define LOADS_MAX               10000000
+#define BENCH_LOOKUPS           1000000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct TABLE_t {
+    float pos_min;
+    float pos_max;
+    float load_max;
+    float scale[GAIN_SCHED_LOAD_POINTS][GAIN_SCHED_POS_POINTS][GAIN_SCHED_PARAM__NUM];
+} TABLE_t;
+
+/*===== Private Variables ====================================================*/
+
+static GAIN_SCHED_t _sched;
+static float _probes[PROBES][2];                                /* Position, load. */
+static float _expected[2][PROBES][GAIN_SCHED_PARAM__NUM];       /* Per table, per probe. */
+static volatile bool _loading;                                  /* Loader between begin and commit. */
+static volatile uint32_t _isr_lookups;
+static volatile uint32_t _isr_loading_lookups;
+static volatile uint32_t _isr_mismatches;
+
+/*===== Private Function Prototypes ==========================================*/
+static void random_table(TABLE_t *table, float pos_min, float pos_max, float load_max);
+static bool load(GAIN_SCHED_t *sched, const TABLE_t *table);
+static void reference(const TABLE_t *table, float pos, float load, double *scale);
+static uint32_t probe_mismatches(const GAIN_SCHED_t *sched, uint32_t table);
+static void expect_probes(const TABLE_t *tables);
+static void isr_lookup(int signal);
+static void test_lookup(void);
+static void test_bilinear(void);
+static void test_clamp(void);
+static void test_invalid(void);
+static void test_switch_steps(void);
+static void test_switch_preempted(void);
+static void bench_lookup(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_rand_seed(1);
+    test_lookup();
+    test_bilinear();
+    test_clamp();
+    test_invalid();
+    test_switch_steps();
+    test_switch_preempted();
+    bench_lookup();
+    return test_result("test_gain_sched");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Generate a table of random scale factors (0.5..1.5).
+ * @param  table:    Table. Passed by reference.
+ * @param  pos_min:  Position axis minimum.
+ * @param  pos_max:  Position axis maximum.
+ * @param  load_max: Load axis maximum.
+ * @retval None.
+ */
+static void random_table(TABLE_t *table, float pos_min, float pos_max, float load_max)
+{
+    table->pos_min = pos_min;
+    table->pos_max = pos_max;
+    table->load_max = load_max;
+    for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+    {
+        for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+        {
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                table->scale[j][i][p] = 0.5f + test_rand_uniform();
+            }
+        }
+    }
+}
+
+/**
+ * @brief  Load a table as the firmware's loader: begin, axes, every
+ *         breakpoint, commit.
+ * @param  sched: Schedule.
+ * @param  table: Table.
+ * @retval Boolean indicating whether every step succeeded.
+ */
+static bool load(GAIN_SCHED_t *sched, const TABLE_t *table)
+{
+    bool ok = true;
+
+    gain_sched_begin(sched);
+    gain_sched_set_axes(sched, table->pos_min, table->pos_max, table->load_max);
+    for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+    {
+        for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+        {
+            ok &= gain_sched_set_point(sched, j, i, table->scale[j][i]);
+        }
+    }
+    return gain_sched_commit(sched) && ok;
+}
+
+/**
+ * @brief  Double-precision bilinear interpolation with the edges held.
+ * @param  table: Table.
+ * @param  pos:   Position.
+ * @param  load:  Load term.
+ * @param  scale: Scale factors, GAIN_SCHED_PARAM__NUM. Passed by reference.
+ * @retval None.
+ */
+static void reference(const TABLE_t *table, float pos, float load, double *scale)
+{
+    double u = ((double)pos - table->pos_min) / ((double)table->pos_max - table->pos_min) * (GAIN_SCHED_POS_POINTS - 1);
+    double v = (double)load / table->load_max * (GAIN_SCHED_LOAD_POINTS - 1);
+    u = fmin(fmax(u, 0.0), GAIN_SCHED_POS_POINTS - 1);
+    v = fmin(fmax(v, 0.0), GAIN_SCHED_LOAD_POINTS - 1);
+    uint32_t i = (u >= (GAIN_SCHED_POS_POINTS - 1)) ? (GAIN_SCHED_POS_POINTS - 2) : (uint32_t)u;
+    uint32_t j = (v >= (GAIN_SCHED_LOAD_POINTS - 1)) ? (GAIN_SCHED_LOAD_POINTS - 2) : (uint32_t)v;
+    double fx = u - i;
+    double fy = v - j;
+
+    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+    {
+        scale[p] = ((1.0 - fx) * (1.0 - fy) * table->scale[j][i][p]) + (fx * (1.0 - fy) * table->scale[j][i + 1][p]) +
+                   ((1.0 - fx) * fy * table->scale[j + 1][i][p]) + (fx * fy * table->scale[j + 1][i + 1][p]);
+    }
+}
+
+/**
+ * @brief  Look up the probes and compare them with a table's expected scale
+ *         factors (exactly: the same lookup of the same table).
+ * @param  sched: Schedule.
+ * @param  table: Index of the expected table (see expect_probes).
+ * @retval Probes differing.
+ */
+static uint32_t probe_mismatches(const GAIN_SCHED_t *sched, uint32_t table)
+{
+    uint32_t mismatches = 0;
+
+    for (uint32_t k = 0; k < PROBES; k++)
+    {
+        float scale[GAIN_SCHED_PARAM__NUM];
+        gain_sched_lookup(sched, _probes[k][0], _probes[k][1], scale);
+        for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+        {
+            if (scale[p] != _expected[table][k][p])
+            {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * @brief  Set random probes (inside and beyond the axes) and their expected
+ *         scale factors from each of two tables, each loaded alone.
+ * @param  tables: Tables, 2.
+ * @retval None.
+ */
+static void expect_probes(const TABLE_t *tables)
+{
+    GAIN_SCHED_t sched;
+
+    for (uint32_t k = 0; k < PROBES; k++)
+    {
+        _probes[k][0] = -20.0f + (220.0f * test_rand_uniform());
+        _probes[k][1] = -1.0f + (12.0f * test_rand_uniform());
+    }
+    for (uint32_t t = 0; t < 2; t++)
+    {
+        gain_sched_init(&sched, POS_MIN, POS_MAX, LOAD_MAX);
+        TEST_CHECK(load(&sched, &tables[t]), "table %u not loaded", (unsigned)t);
+        for (uint32_t k = 0; k < PROBES; k++)
+        {
+            gain_sched_lookup(&sched, _probes[k][0], _probes[k][1], _expected[t][k]);
+        }
+    }
+}
+
+/**
+ * @brief  Timer signal handler: a lookup of the next probe, which must match
+ *         either table's.
+ * @param  signal: Signal number.
+ * @retval None.
+ */
+static void isr_lookup(int signal)
+{
+    float scale[GAIN_SCHED_PARAM__NUM];
+    uint32_t k = _isr_lookups % PROBES;
+    bool match[2] = {true, true};
+
+    (void)signal;
+    gain_sched_lookup(&_sched, _probes[k][0], _probes[k][1], scale);
+    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+    {
+        match[0] &= (scale[p] == _expected[0][k][p]);
+        match[1] &= (scale[p] == _expected[1][k][p]);
+    }
+    _isr_mismatches += !(match[0] || match[1]);
+    _isr_loading_lookups += _loading;
+    _isr_lookups++;
+}
+
+/**
+ * @brief  Random tables and axes, looked up at random points over and beyond
+ *         the axes, against the double-precision reference; the breakpoints
+ *         as loaded.
+ * @retval None.
+ */
+static void test_lookup(void)
+{
+    GAIN_SCHED_t sched;
+    TABLE_t table;
+    double error_max = 0.0;
+    double breakpoint_error_max = 0.0;
+    uint32_t failed_loads = 0;
+
+    gain_sched_init(&sched, POS_MIN, POS_MAX, LOAD_MAX);
+    for (uint32_t n = 0; n < LOOKUPS; n++)
+    {
+        if ((n % 1000) == 0)
+        {
+            float pos_min = -90.0f + (90.0f * test_rand_uniform());
+            random_table(&table, pos_min, pos_min + 30.0f + (150.0f * test_rand_uniform()),
+                         1.0f + (20.0f * test_rand_uniform()));
+            failed_loads += !load(&sched, &table);
+
+            for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+            {
+                for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+                {
+                    float pos = table.pos_min + ((table.pos_max - table.pos_min) * (float)i /
+                                                 (float)(GAIN_SCHED_POS_POINTS - 1));
+                    float load_term = table.load_max * (float)j / (float)(GAIN_SCHED_LOAD_POINTS - 1);
+                    float scale[GAIN_SCHED_PARAM__NUM];
+                    gain_sched_lookup(&sched, pos, load_term, scale);
+                    for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+                    {
+                        double error = fabs((double)scale[p] - table.scale[j][i][p]);
+                        breakpoint_error_max = fmax(breakpoint_error_max, error);
+                    }
+                }
+            }
+        }
+
+        float span = table.pos_max - table.pos_min;
+        float pos = table.pos_min - (0.2f * span) + (1.4f * span * test_rand_uniform());
+        float load_term = table.load_max * (-0.2f + (1.4f * test_rand_uniform()));
+        float scale[GAIN_SCHED_PARAM__NUM];
+        double ref[GAIN_SCHED_PARAM__NUM];
+        gain_sched_lookup(&sched, pos, load_term, scale);
+        reference(&table, pos, load_term, ref);
+        for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+        {
+            error_max = fmax(error_max, fabs((double)scale[p] - ref[p]));
+        }
+    }
+    printf("lookup: error max %.2e against the double-precision reference, %.2e at the breakpoints (%u lookups)\n",
+           error_max, breakpoint_error_max, (unsigned)LOOKUPS);
+    TEST_CHECK(failed_loads == 0, "lookup: %u tables not loaded", (unsigned)failed_loads);
+    TEST_CHECK(error_max < LOOKUP_TOL, "lookup: error %.2e", error_max);
+    TEST_CHECK(breakpoint_error_max < LOOKUP_TOL, "lookup: breakpoint error %.2e", breakpoint_error_max);
+}
+
+/**
+ * @brief  A table sampled from a bilinear function of position and load (a
+ *         different one per parameter) reproduces the function over the
+ *         grid.
+ * @retval None.
+ */
+static void test_bilinear(void)
+{
+    static const float coeffs[GAIN_SCHED_PARAM__NUM][4] = {
+        {1.0f, 0.004f, 0.05f, -0.0002f},
+        {0.5f, -0.002f, 0.1f, 0.0005f},
+        {2.0f, 0.0f, -0.1f, 0.0f},
+        {1.0f, 0.001f, 0.0f, 0.0001f},
+    };
+    GAIN_SCHED_t sched;
+    TABLE_t table = {.pos_min = POS_MIN, .pos_max = POS_MAX, .load_max = LOAD_MAX};
+    double error_max = 0.0;
+
+    for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+    {
+        for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+        {
+            float pos = POS_MIN + ((POS_MAX - POS_MIN) * (float)i / (float)(GAIN_SCHED_POS_POINTS - 1));
+            float load_term = LOAD_MAX * (float)j / (float)(GAIN_SCHED_LOAD_POINTS - 1);
+            for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+            {
+                const float *c = coeffs[p];
+                table.scale[j][i][p] = c[0] + (c[1] * pos) + (c[2] * load_term) + (c[3] * pos * load_term);
+            }
+        }
+    }
+    gain_sched_init(&sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(load(&sched, &table), "bilinear: table not loaded");
+
+    for (uint32_t n = 0; n < LOOKUPS; n++)
+    {
+        float pos = POS_MIN + ((POS_MAX - POS_MIN) * test_rand_uniform());
+        float load_term = LOAD_MAX * test_rand_uniform();
+        float scale[GAIN_SCHED_PARAM__NUM];
+        gain_sched_lookup(&sched, pos, load_term, scale);
+        for (uint32_t p = 0; p < GAIN_SCHED_PARAM__NUM; p++)
+        {
+            const float *c = coeffs[p];
+            double f = c[0] + ((double)c[1] * pos) + ((double)c[2] * load_term) + ((double)c[3] * pos * load_term);
+            error_max = fmax(error_max, fabs((double)scale[p] - f));
+        }
+    }
+    printf("bilinear function: error max %.2e\n", error_max);
+    TEST_CHECK(error_max < LOOKUP_TOL, "bilinear: error %.2e", error_max);
+}
+
+/**
+ * @brief  Points beyond the axes (and NaN, infinities) look up exactly as the
+ *         nearest edge or corner.
+ * @retval None.
+ */
+static void test_clamp(void)
+{
+    const float beyond[] = {-1.0e-3f, -1.0f, -1000.0f, -INFINITY};
+    GAIN_SCHED_t sched;
+    TABLE_t table;
+    uint32_t mismatches = 0;
+    uint32_t lookups = 0;
+
+    random_table(&table, 30.0f, 150.0f, LOAD_MAX);
+    gain_sched_init(&sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(load(&sched, &table), "clamp: table not loaded");
+
+    for (uint32_t n = 0; n < 1000; n++)
+    {
+        float inside_pos = table.pos_min + ((table.pos_max - table.pos_min) * test_rand_uniform());
+        float inside_load = table.load_max * test_rand_uniform();
+        for (uint32_t b = 0; b < TEST_NUM_ELS(beyond); b++)
+        {
+            float below = table.pos_min + beyond[b];
+            float above = table.pos_max - beyond[b];
+            float load_below = beyond[b];
+            float load_above = table.load_max - beyond[b];
+            /* Position, load beyond; their clamped equivalents. */
+            const float cases[][4] = {
+                {below, inside_load, table.pos_min, inside_load},
+                {above, inside_load, table.pos_max, inside_load},
+                {inside_pos, load_below, inside_pos, 0.0f},
+                {inside_pos, load_above, inside_pos, table.load_max},
+                {below, load_below, table.pos_min, 0.0f},
+                {above, load_above, table.pos_max, table.load_max},
+                {below, load_above, table.pos_min, table.load_max},
+                {above, load_below, table.pos_max, 0.0f},
+            };
+            for (uint32_t c = 0; c < TEST_NUM_ELS(cases); c++)
+            {
+                float scale[GAIN_SCHED_PARAM__NUM];
+                float edge[GAIN_SCHED_PARAM__NUM];
+                gain_sched_lookup(&sched, cases[c][0], cases[c][1], scale);
+                gain_sched_lookup(&sched, cases[c][2], cases[c][3], edge);
+                mismatches += (memcmp(scale, edge, sizeof(scale)) != 0);
+                lookups++;
+            }
+        }
+
+        /* NaN is held at the low edge. */
+        const float nans[][4] = {
+            {NAN, inside_load, table.pos_min, inside_load},
+            {inside_pos, NAN, inside_pos, 0.0f},
+        };
+        for (uint32_t c = 0; c < TEST_NUM_ELS(nans); c++)
+        {
+            float scale[GAIN_SCHED_PARAM__NUM];
+            float edge[GAIN_SCHED_PARAM__NUM];
+            gain_sched_lookup(&sched, nans[c][0], nans[c][1], scale);
+            gain_sched_lookup(&sched, nans[c][2], nans[c][3], edge);
+            mismatches += (memcmp(scale, edge, sizeof(scale)) != 0);
+            lookups++;
+        }
+    }
+    printf("clamp: %u/%u lookups beyond the axes differing from the edge's\n", (unsigned)mismatches,
+           (unsigned)lookups);
+    TEST_CHECK(mismatches == 0, "clamp: %u lookups differ from the edge's", (unsigned)mismatches);
+}
+
+/**
+ * @brief  Invalid breakpoints (indices, negative or NaN scale factors) and
+ *         axes rejected; a rejected commit leaves the active table as it was.
+ * @retval None.
+ */
+static void test_invalid(void)
+{
+    const float valid[GAIN_SCHED_PARAM__NUM] = {1.0f, 1.0f, 1.0f, 1.0f};
+    const float negative[GAIN_SCHED_PARAM__NUM] = {1.0f, -0.1f, 1.0f, 1.0f};
+    const float nan[GAIN_SCHED_PARAM__NUM] = {1.0f, 1.0f, NAN, 1.0f};
+    /* Position minimum, maximum, load maximum. */
+    const float axes[][3] = {
+        {POS_MAX, POS_MIN, LOAD_MAX},
+        {POS_MIN, POS_MIN, LOAD_MAX},
+        {POS_MIN, POS_MAX, 0.0f},
+        {POS_MIN, POS_MAX, -LOAD_MAX},
+        {POS_MIN, NAN, LOAD_MAX},
+        {POS_MIN, POS_MAX, NAN},
+    };
+    TABLE_t tables[2];
+    uint32_t accepted = 0;
+    uint32_t mismatches = 0;
+
+    random_table(&tables[0], POS_MIN, POS_MAX, LOAD_MAX);
+    random_table(&tables[1], POS_MIN, POS_MAX, LOAD_MAX);
+    expect_probes(tables);
+    gain_sched_init(&_sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(load(&_sched, &tables[0]), "invalid: table not loaded");
+
+    gain_sched_begin(&_sched);
+    accepted += gain_sched_set_point(&_sched, GAIN_SCHED_LOAD_POINTS, 0, valid);
+    accepted += gain_sched_set_point(&_sched, 0, GAIN_SCHED_POS_POINTS, valid);
+    accepted += gain_sched_set_point(&_sched, 0, 0, negative);
+    accepted += gain_sched_set_point(&_sched, 0, 0, nan);
+    for (uint32_t a = 0; a < TEST_NUM_ELS(axes); a++)
+    {
+        uint32_t swaps = _sched.swap_count;
+        gain_sched_set_axes(&_sched, axes[a][0], axes[a][1], axes[a][2]);
+        accepted += gain_sched_commit(&_sched);
+        mismatches += (_sched.swap_count != swaps) + probe_mismatches(&_sched, 0);
+    }
+    /* The staging table's rejected breakpoints were not written. */
+    gain_sched_set_axes(&_sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(gain_sched_commit(&_sched), "invalid: valid axes not committed");
+    mismatches += probe_mismatches(&_sched, 0);
+
+    TEST_CHECK(accepted == 0, "invalid: %u invalid steps accepted", (unsigned)accepted);
+    TEST_CHECK(mismatches == 0, "invalid: active table changed %u times", (unsigned)mismatches);
+}
+
+/**
+ * @brief  Look up between every two steps of loading a table: the old table
+ *         until the commit, the new one from it.
+ * @retval None.
+ */
+static void test_switch_steps(void)
+{
+    TABLE_t tables[2];
+    uint32_t before = 0;
+    uint32_t after;
+
+    random_table(&tables[0], POS_MIN, POS_MAX, LOAD_MAX);
+    random_table(&tables[1], 20.0f, 160.0f, 0.5f * LOAD_MAX);
+    expect_probes(tables);
+    gain_sched_init(&_sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(load(&_sched, &tables[0]) && (probe_mismatches(&_sched, 0) == 0), "steps: old table not loaded");
+    uint32_t swaps = _sched.swap_count;
+
+    gain_sched_begin(&_sched);
+    before += probe_mismatches(&_sched, 0);
+    gain_sched_set_axes(&_sched, tables[1].pos_min, tables[1].pos_max, tables[1].load_max);
+    before += probe_mismatches(&_sched, 0);
+    for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+    {
+        for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+        {
+            (void)gain_sched_set_point(&_sched, j, i, tables[1].scale[j][i]);
+            before += probe_mismatches(&_sched, 0);
+        }
+    }
+    TEST_CHECK(gain_sched_commit(&_sched), "steps: new table not committed");
+    after = probe_mismatches(&_sched, 1);
+
+    TEST_CHECK(before == 0, "steps: %u lookups before the commit not of the old table", (unsigned)before);
+    TEST_CHECK(after == 0, "steps: %u lookups after the commit not of the new table", (unsigned)after);
+    TEST_CHECK(_sched.swap_count == (swaps + 1), "steps: %u swaps", (unsigned)(_sched.swap_count - swaps));
+}
+
+/**
+ * @brief  Load two tables alternately, back to back, whilst a timer signal
+ *         pre-empts the loader to look up: every lookup sees one table or
+ *         the other, never a mix.
+ * @retval None.
+ */
+static void test_switch_preempted(void)
+{
+    TABLE_t tables[2];
+    struct sigaction action = {.sa_handler = isr_lookup, .sa_flags = SA_RESTART};
+    const struct itimerval timer = {.it_interval = {.tv_usec = TIMER_US}, .it_value = {.tv_usec = TIMER_US}};
+    const struct itimerval stop = {0};
+    uint32_t loads = 0;
+    uint32_t failed_loads = 0;
+
+    random_table(&tables[0], POS_MIN, POS_MAX, LOAD_MAX);
+    random_table(&tables[1], 20.0f, 160.0f, 0.5f * LOAD_MAX);
+    expect_probes(tables);
+    gain_sched_init(&_sched, POS_MIN, POS_MAX, LOAD_MAX);
+    TEST_CHECK(load(&_sched, &tables[0]), "pre-empted: table not loaded");
+    _isr_lookups = 0;
+    _isr_loading_lookups = 0;
+    _isr_mismatches = 0;
+
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGALRM, &action, NULL);
+    setitimer(ITIMER_REAL, &timer, NULL);
+    while ((_isr_loading_lookups < ISR_LOOKUPS) && (loads < LOADS_MAX))
+    {
+        const TABLE_t *table = &tables[(loads + 1) % 2];
+        gain_sched_begin(&_sched);
+        _loading = true;
+        gain_sched_set_axes(&_sched, table->pos_min, table->pos_max, table->load_max);
+        for (uint32_t j = 0; j < GAIN_SCHED_LOAD_POINTS; j++)
+        {
+            for (uint32_t i = 0; i < GAIN_SCHED_POS_POINTS; i++)
+            {
+                failed_loads += !gain_sched_set_point(&_sched, j, i, table->scale[j][i]);
+            }
+        }
+        failed_loads += !gain_sched_commit(&_sched);
+        _loading = false;
+        loads++;
+    }
+    setitimer(ITIMER_REAL, &stop, NULL);
+    action.sa_handler = SIG_DFL;
+    sigaction(SIGALRM, &action, NULL);
+
+    printf("pre-empted loading: %u loads, %u lookups (%u whilst loading), %u of neither table\n", (unsigned)loads,
+           (unsigned)_isr_lookups, (unsigned)_isr_loading_lookups, (unsigned)_isr_mismatches);
+    TEST_CHECK(failed_loads == 0, "pre-empted: %u loads failed", (unsigned)failed_loads);
+    TEST_CHECK(_isr_loading_lookups >= ISR_LOOKUPS, "pre-empted: %u lookups whilst loading",
+               (unsigned)_isr_loading_lookups);
+    TEST_CHECK(_isr_mismatches == 0, "pre-empted: %u lookups of neither table", (unsigned)_isr_mismatches);
+}
+
+/**
+ * @brief  Cycles per lookup.
+ * @retval None.
+ */
+static void bench_lookup(void)
+{
+    GAIN_SCHED_t sched;
+    TABLE_t table;
+    float scale[GAIN_SCHED_PARAM__NUM];
+    volatile float sink = 0.0f;
+
+    random_table(&table, POS_MIN, POS_MAX, LOAD_MAX);
+    gain_sched_init(&sched, POS_MIN, POS_MAX, LOAD_MAX);
+    (void)load(&sched, &table);
+    uint64_t start = test_cycles();
+    for (uint32_t n = 0; n < BENCH_LOOKUPS; n++)
+    {
+        gain_sched_lookup(&sched, (float)(n % 200U) - 10.0f, (float)(n % 12U), scale);
+        sink += scale[GAIN_SCHED_PARAM__KP];
+    }
+    uint64_t cycles = test_cycles() - start;
+    (void)sink;
+    printf("bench: %.1f host cycles per lookup\n", (double)cycles / BENCH_LOOKUPS);
+}
+
+/*============================================================================*/
\ No newline at end of file
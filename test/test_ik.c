@@ -0,0 +1,468 @@
+/*******************************************************************************
+ * @file   test_ik.c
+ * @brief  Inverse kinematics host test: the fixed-point solver of each arm
+ *         (see IK_ARM_t) and elbow configuration against a double-precision
+ *         closed-form reference of the same conventions, over the workspace
+ *         of an arm of unequal links (an inner boundary).
+ *             - Workspace: random postures' targets (forward kinematics,
+ *               quantised to Q16.16); the joint angles within
+ *               JOINT_ERROR_MAX_DEG of the reference's away from the
+ *               singular boundaries, the end point (forward kinematics of
+ *               the solved joints) within TIP_ERROR_MAX of the target
+ *               everywhere, and reachability as the reference's.
+ *             - Out of reach: reported, and the nearest posture (the arm
+ *               stretched or folded towards the target).
+ *             - arm_sin_cos_q31 error budget: within SIN_COS_ERROR_MAX over
+ *               the angles evaluated (0..180 degrees; the planar 3-link
+ *               arm's |phi|), and the planar 3-link arm's solutions about
+ *               phi = -90 degrees (the kernel's inaccurate range, not
+ *               evaluated).
+ *             - Cycles per solve against the double-precision reference
+ *               (benchmark).
+ ******************************************************************************/
+
+#include "ik.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+#define PI_D                    3.14159265358979323846
+#define DEG_TO_RAD              (PI_D / 180.0)
+#define Q16(v)                  ((int32_t)lrint((v) * 65536.0))
+#define FROM_Q16(v)             ((double)(v) / 65536.0)
+
+#define LENGTH_1                120.0   /* Link lengths (units, e.g. mm). */
+#define LENGTH_2                95.0
+#define LENGTH_3                40.0
+#define NUM_SAMPLES             100000  /* Postures per arm and elbow configuration. */
+#define EDGE_RAD                0.05    /* Elbow within this of 0 or 180 degrees: near a singular boundary. */
+#define JOINT_ERROR_MAX_DEG     0.005
+#define TIP_ERROR_MAX           0.01    /* Units. */
+#define SIN_COS_STEP            (1L << 10)
+#define SIN_COS_ERROR_MAX       1.0e-8  /* x LENGTH_3: below the Q16.16 resolution. */
+#define BENCH_SOLVES            1000000
+
+/*===== Private Function Prototypes ==========================================*/
+static bool init_ik(IK_t *ik, IK_ARM_t arm, bool elbow_up);
+static bool ref_2link(double x, double y, bool elbow_up, double *shoulder, double *elbow);
+static bool ref_solve(IK_ARM_t arm, bool elbow_up, const int32_t target[IK_MAX_JOINTS], double joints[IK_MAX_JOINTS]);
+static void forward(IK_ARM_t arm, const double joints[IK_MAX_JOINTS], double point[IK_MAX_JOINTS]);
+static double wrap(double angle);
+static double rand_range(double min, double max);
+static void test_workspace(IK_ARM_t arm, bool elbow_up, bool edge);
+static void test_out_of_reach(IK_ARM_t arm, bool elbow_up);
+static void test_sin_cos(void);
+static void bench_ik(IK_ARM_t arm);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_rand_seed(1);
+    for (uint32_t arm = 0; arm < IK_ARM__NUM; arm++)
+    {
+        for (uint32_t up = 0; up < 2; up++)
+        {
+            test_workspace((IK_ARM_t)arm, up != 0, false);
+            test_workspace((IK_ARM_t)arm, up != 0, true);
+            test_out_of_reach((IK_ARM_t)arm, up != 0);
+        }
+    }
+    test_sin_cos();
+    for (uint32_t arm = 0; arm < IK_ARM__NUM; arm++)
+    {
+        bench_ik((IK_ARM_t)arm);
+    }
+    return test_result("test_ik");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a solver of the test's link lengths.
+ * @param  ik:       Solver.
+ * @param  arm:      Arm.
+ * @param  elbow_up: Elbow configuration.
+ * @retval Boolean indicating whether initialised.
+ */
+static bool init_ik(IK_t *ik, IK_ARM_t arm, bool elbow_up)
+{
+    const IK_CONFIG_t config = {
+        .arm = arm,
+        .lengths = {Q16(LENGTH_1), Q16(LENGTH_2), Q16(LENGTH_3)},
+        .elbow_up = elbow_up,
+    };
+    return ik_init(ik, &config);
+}
+
+/**
+ * @brief  Double-precision 2-link arm (law of cosines); the elbow's cosine
+ *         limited for a target out of reach.
+ * @param  x:        Target x, or horizontal radius.
+ * @param  y:        Target y, or z.
+ * @param  elbow_up: Elbow configuration (elbow angle negative).
+ * @param  shoulder: Shoulder angle (radians). Passed by reference.
+ * @param  elbow:    Elbow angle (radians). Passed by reference.
+ * @retval Boolean indicating whether the target is reachable.
+ */
+static bool ref_2link(double x, double y, bool elbow_up, double *shoulder, double *elbow)
+{
+    double c = ((x * x) + (y * y) - (LENGTH_1 * LENGTH_1) - (LENGTH_2 * LENGTH_2)) / (2.0 * LENGTH_1 * LENGTH_2);
+    bool reachable = (c >= -1.0) && (c <= 1.0);
+    c = fmax(-1.0, fmin(1.0, c));
+    double s = sqrt(1.0 - (c * c)) * (elbow_up ? -1.0 : 1.0);
+
+    *elbow = atan2(s, c);
+    *shoulder = atan2(y, x) - atan2(LENGTH_2 * s, LENGTH_1 + (LENGTH_2 * c));
+    return reachable;
+}
+
+/**
+ * @brief  Double-precision inverse kinematics of a (quantised) target.
+ * @param  arm:      Arm.
+ * @param  elbow_up: Elbow configuration.
+ * @param  target:   Target (Q16.16; as ik_solve).
+ * @param  joints:   Joint angles (radians). Passed by reference.
+ * @retval Boolean indicating whether the target is reachable.
+ */
+static bool ref_solve(IK_ARM_t arm, bool elbow_up, const int32_t target[IK_MAX_JOINTS], double joints[IK_MAX_JOINTS])
+{
+    double x = FROM_Q16(target[0]);
+    double y = FROM_Q16(target[1]);
+    double z = FROM_Q16(target[2]);
+
+    switch (arm)
+    {
+        case IK_ARM__PLANAR_2:
+            return ref_2link(x, y, elbow_up, &joints[0], &joints[1]);
+
+        case IK_ARM__PLANAR_3:
+        {
+            double phi = z * DEG_TO_RAD;
+            bool reachable = ref_2link(x - (LENGTH_3 * cos(phi)), y - (LENGTH_3 * sin(phi)), elbow_up, &joints[0],
+                                       &joints[1]);
+            joints[2] = phi - joints[0] - joints[1];
+            return reachable;
+        }
+
+        default:
+            joints[0] = atan2(y, x);
+            return ref_2link(hypot(x, y), z, elbow_up, &joints[1], &joints[2]);
+    }
+}
+
+/**
+ * @brief  Double-precision forward kinematics.
+ * @param  arm:    Arm.
+ * @param  joints: Joint angles (radians).
+ * @param  point:  End point: x, y and the planar 3-link arm's phi (degrees)
+ *                 or the spatial arm's z. Passed by reference.
+ * @retval None.
+ */
+static void forward(IK_ARM_t arm, const double joints[IK_MAX_JOINTS], double point[IK_MAX_JOINTS])
+{
+    switch (arm)
+    {
+        case IK_ARM__PLANAR_2:
+        case IK_ARM__PLANAR_3:
+        {
+            double a1 = joints[0];
+            double a2 = joints[0] + joints[1];
+            point[0] = (LENGTH_1 * cos(a1)) + (LENGTH_2 * cos(a2));
+            point[1] = (LENGTH_1 * sin(a1)) + (LENGTH_2 * sin(a2));
+            point[2] = 0.0;
+            if (arm == IK_ARM__PLANAR_3)
+            {
+                double phi = a2 + joints[2];
+                point[0] += LENGTH_3 * cos(phi);
+                point[1] += LENGTH_3 * sin(phi);
+                point[2] = wrap(phi) / DEG_TO_RAD;
+            }
+            break;
+        }
+
+        default:
+        {
+            double radius = (LENGTH_1 * cos(joints[1])) + (LENGTH_2 * cos(joints[1] + joints[2]));
+            point[0] = radius * cos(joints[0]);
+            point[1] = radius * sin(joints[0]);
+            point[2] = (LENGTH_1 * sin(joints[1])) + (LENGTH_2 * sin(joints[1] + joints[2]));
+            break;
+        }
+    }
+}
+
+/**
+ * @brief  Wrap an angle to (-pi, pi].
+ * @param  angle: Angle (radians).
+ * @retval Wrapped angle (radians).
+ */
+static double wrap(double angle)
+{
+    return angle - (2.0 * PI_D * ceil((angle - PI_D) / (2.0 * PI_D)));
+}
+
+/**
+ * @brief  Retrieve a uniformly distributed pseudo-random number in a range.
+ * @param  min: Minimum.
+ * @param  max: Maximum.
+ * @retval Number in [min, max).
+ */
+static double rand_range(double min, double max)
+{
+    return min + ((max - min) * (double)test_rand_uniform());
+}
+
+/**
+ * @brief  Workspace sweep: NUM_SAMPLES random postures of the elbow
+ *         configuration, their targets quantised to Q16.16 and solved by
+ *         both. The joint angles are within JOINT_ERROR_MAX_DEG of the
+ *         reference's away from the singular boundaries (the elbow beyond
+ *         EDGE_RAD of 0 and 180 degrees); near them the joint angles are
+ *         ill-conditioned (and the reachability of a target on the boundary
+ *         within the quantisation), such that only the end point is checked.
+ *         The end point is within TIP_ERROR_MAX of the target (and the
+ *         planar 3-link arm's orientation within JOINT_ERROR_MAX_DEG).
+ * @param  arm:      Arm.
+ * @param  elbow_up: Elbow configuration.
+ * @param  edge:     Postures near the singular boundaries (else away).
+ * @retval None.
+ */
+static void test_workspace(IK_ARM_t arm, bool elbow_up, bool edge)
+{
+    IK_t ik;
+    uint32_t num_joints;
+    uint32_t mismatches = 0;
+    double joint_max = 0.0;
+    double joint_sum = 0.0;
+    double tip_max = 0.0;
+    double phi_max = 0.0;
+
+    TEST_CHECK(init_ik(&ik, arm, elbow_up), "arm %u: initialised", (unsigned)arm);
+    num_joints = ik_get_num_joints(&ik);
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++)
+    {
+        /* A posture: the elbow angle of the configuration's sign, the spatial arm's shoulder above the plane. */
+        double elbow = edge ? (((i & 1U) != 0) ? rand_range(1e-4, EDGE_RAD) : rand_range(PI_D - EDGE_RAD, PI_D - 1e-4))
+                            : rand_range(EDGE_RAD, PI_D - EDGE_RAD);
+        double posture[IK_MAX_JOINTS] = {rand_range(-PI_D, PI_D), elbow * (elbow_up ? -1.0 : 1.0),
+                                         rand_range(-PI_D, PI_D)};
+        if (arm == IK_ARM__SPATIAL_3)
+        {
+            posture[2] = posture[1];
+            posture[1] = rand_range(-0.5 * PI_D, 0.5 * PI_D);
+        }
+        double point[IK_MAX_JOINTS];
+        forward(arm, posture, point);
+        if ((arm == IK_ARM__SPATIAL_3) && (hypot(point[0], point[1]) < 1.0))
+        {
+            i--; /* The yaw undefined on the z axis. */
+            continue;
+        }
+
+        int32_t target[IK_MAX_JOINTS] = {Q16(point[0]), Q16(point[1]), Q16(point[2])};
+        int32_t joints[IK_MAX_JOINTS];
+        double ref[IK_MAX_JOINTS];
+        double solved[IK_MAX_JOINTS];
+        bool ref_reachable = ref_solve(arm, elbow_up, target, ref);
+        bool reachable = ik_solve(&ik, target, joints);
+        mismatches += (reachable != ref_reachable) ? 1U : 0U;
+        for (uint32_t j = 0; j < num_joints; j++)
+        {
+            solved[j] = FROM_Q16(joints[j]) * DEG_TO_RAD;
+            double error = fabs(wrap(solved[j] - ref[j])) / DEG_TO_RAD;
+            joint_max = fmax(joint_max, error);
+            joint_sum += error;
+        }
+
+        double tip[IK_MAX_JOINTS];
+        forward(arm, solved, tip);
+        tip_max = fmax(tip_max, hypot(hypot(tip[0] - FROM_Q16(target[0]), tip[1] - FROM_Q16(target[1])),
+                                      (arm == IK_ARM__SPATIAL_3) ? (tip[2] - FROM_Q16(target[2])) : 0.0));
+        if (arm == IK_ARM__PLANAR_3)
+        {
+            phi_max = fmax(phi_max, fabs(wrap((tip[2] - FROM_Q16(target[2])) * DEG_TO_RAD)) / DEG_TO_RAD);
+        }
+    }
+
+    printf("IK arm %u, elbow %s, %s: joint error max %.5f mean %.6f deg, end point error max %.5f units, "
+           "%lu reachability mismatches\n",
+           (unsigned)arm, elbow_up ? "up" : "down", edge ? "near the boundaries" : "interior", joint_max,
+           joint_sum / (double)(NUM_SAMPLES * num_joints), tip_max, (unsigned long)mismatches);
+    if (edge == false)
+    {
+        TEST_CHECK(joint_max < JOINT_ERROR_MAX_DEG, "arm %u, elbow up %d: joint error %.5f deg", (unsigned)arm,
+                   elbow_up, joint_max);
+        TEST_CHECK(mismatches == 0, "arm %u, elbow up %d: %lu reachability mismatches", (unsigned)arm, elbow_up,
+                   (unsigned long)mismatches);
+    }
+    TEST_CHECK(tip_max < TIP_ERROR_MAX, "arm %u, elbow up %d, edge %d: end point error %.5f units", (unsigned)arm,
+               elbow_up, edge, tip_max);
+    TEST_CHECK(phi_max < JOINT_ERROR_MAX_DEG, "arm %u, elbow up %d, edge %d: orientation error %.5f deg",
+               (unsigned)arm, elbow_up, edge, phi_max);
+}
+
+/**
+ * @brief  Targets out of reach (beyond the reach, and for the 2-link arms
+ *         within the links' difference): reported, and the joint angles
+ *         within JOINT_ERROR_MAX_DEG of the reference's nearest posture
+ *         (the planar 3-link arm's wrist point beyond the reach is only
+ *         checked reported).
+ * @param  arm:      Arm.
+ * @param  elbow_up: Elbow configuration.
+ * @retval None.
+ */
+static void test_out_of_reach(IK_ARM_t arm, bool elbow_up)
+{
+    IK_t ik;
+    uint32_t reported = 0;
+    double joint_max = 0.0;
+    const uint32_t samples = NUM_SAMPLES / 10;
+
+    (void)init_ik(&ik, arm, elbow_up);
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        double angle = rand_range(-PI_D, PI_D);
+        bool inner = ((i & 1U) != 0) && (arm != IK_ARM__PLANAR_3);
+        double radius = inner ? rand_range(0.5, LENGTH_1 - LENGTH_2 - 0.5)
+                              : rand_range(LENGTH_1 + LENGTH_2 + LENGTH_3 + 0.5, 500.0);
+        int32_t target[IK_MAX_JOINTS] = {Q16(radius * cos(angle)), Q16(radius * sin(angle)), 0};
+        if (arm == IK_ARM__PLANAR_3)
+        {
+            target[2] = Q16(rand_range(-180.0, 180.0));
+        }
+        else if (arm == IK_ARM__SPATIAL_3)
+        {
+            /* In the vertical plane of a yaw. */
+            double yaw = rand_range(-PI_D, PI_D);
+            double horizontal = radius * cos(0.5 * angle);
+            target[0] = Q16(horizontal * cos(yaw));
+            target[1] = Q16(horizontal * sin(yaw));
+            target[2] = Q16(radius * sin(0.5 * angle));
+        }
+
+        int32_t joints[IK_MAX_JOINTS];
+        double ref[IK_MAX_JOINTS];
+        (void)ref_solve(arm, elbow_up, target, ref);
+        reported += ik_solve(&ik, target, joints) ? 0U : 1U;
+        for (uint32_t j = 0; (arm != IK_ARM__PLANAR_3) && (j < ik_get_num_joints(&ik)); j++)
+        {
+            joint_max = fmax(joint_max, fabs(wrap((FROM_Q16(joints[j]) * DEG_TO_RAD) - ref[j])) / DEG_TO_RAD);
+        }
+    }
+
+    printf("IK arm %u, elbow %s, out of reach: %lu/%lu reported, nearest posture error max %.5f deg\n", (unsigned)arm,
+           elbow_up ? "up" : "down", (unsigned long)reported, (unsigned long)samples, joint_max);
+    TEST_CHECK(reported == samples, "arm %u, elbow up %d: %lu/%lu out of reach reported", (unsigned)arm, elbow_up,
+               (unsigned long)reported, (unsigned long)samples);
+    TEST_CHECK(joint_max < JOINT_ERROR_MAX_DEG, "arm %u, elbow up %d: nearest posture error %.5f deg", (unsigned)arm,
+               elbow_up, joint_max);
+}
+
+/**
+ * @brief  arm_sin_cos_q31 error budget: over 0..180 degrees (binary angles
+ *         in steps of SIN_COS_STEP) within SIN_COS_ERROR_MAX, i.e. the end
+ *         effector link's contribution to the wrist point within
+ *         LENGTH_3 x SIN_COS_ERROR_MAX units (below the targets' Q16.16
+ *         resolution). Its error below -89 degrees
+ *         (not evaluated: the solver takes |phi|) is reported, and the
+ *         planar 3-link arm's orientations there checked solved.
+ * @retval None.
+ */
+static void test_sin_cos(void)
+{
+    double error_max = 0.0;
+    double error_max_neg = 0.0;
+    double error_at = 0.0;
+
+    for (int64_t i = -(1LL << 31); i < (1LL << 31); i += SIN_COS_STEP)
+    {
+        q31_t sin_q31;
+        q31_t cos_q31;
+        double angle = (double)i / 2147483648.0 * PI_D;
+        arm_sin_cos_q31((q31_t)i, &sin_q31, &cos_q31);
+        double error = fmax(fabs(((double)sin_q31 / 2147483648.0) - sin(angle)),
+                            fabs(((double)cos_q31 / 2147483648.0) - cos(angle)));
+        if ((i >= 0) && (error > error_max))
+        {
+            error_max = error;
+            error_at = angle / DEG_TO_RAD;
+        }
+        error_max_neg = (i < 0) ? fmax(error_max_neg, error) : error_max_neg;
+    }
+    printf("arm_sin_cos_q31: error max %.3g (at %.3f degrees) over 0..180 degrees, %.3g over -180..0 degrees\n",
+           error_max, error_at, error_max_neg);
+    TEST_CHECK(error_max < SIN_COS_ERROR_MAX, "arm_sin_cos_q31 error %.3g over 0..180 degrees", error_max);
+
+    /* The planar 3-link arm about phi = -90 degrees. */
+    IK_t ik;
+    double joint_max = 0.0;
+    (void)init_ik(&ik, IK_ARM__PLANAR_3, false);
+    for (uint32_t i = 0; i < (NUM_SAMPLES / 10); i++)
+    {
+        double phi = rand_range(-91.0, -89.0);
+        double x = rand_range(20.0, 150.0);
+        double y = rand_range(-150.0, 150.0);
+        int32_t target[IK_MAX_JOINTS] = {Q16(x), Q16(y), Q16(phi)};
+        int32_t joints[IK_MAX_JOINTS];
+        double ref[IK_MAX_JOINTS];
+        if (ref_solve(IK_ARM__PLANAR_3, false, target, ref) && ik_solve(&ik, target, joints))
+        {
+            for (uint32_t j = 0; j < IK_MAX_JOINTS; j++)
+            {
+                joint_max = fmax(joint_max, fabs(wrap((FROM_Q16(joints[j]) * DEG_TO_RAD) - ref[j])) / DEG_TO_RAD);
+            }
+        }
+    }
+    printf("IK arm %u, phi -91..-89 degrees: joint error max %.5f deg\n", (unsigned)IK_ARM__PLANAR_3, joint_max);
+    TEST_CHECK(joint_max < JOINT_ERROR_MAX_DEG, "phi about -90 degrees: joint error %.5f deg", joint_max);
+}
+
+/**
+ * @brief  Benchmark the solves of an arm against the double-precision
+ *         reference, on a moving target.
+ * @param  arm: Arm.
+ * @retval None.
+ */
+static void bench_ik(IK_ARM_t arm)
+{
+    IK_t ik;
+    int32_t target[IK_MAX_JOINTS] = {Q16(100.0), Q16(80.0), Q16(20.0)};
+    int32_t joints[IK_MAX_JOINTS];
+    double ref[IK_MAX_JOINTS];
+    volatile int32_t sink = 0;
+    volatile double sink_ref = 0.0;
+
+    (void)init_ik(&ik, arm, false);
+    uint64_t start = test_cycles();
+    for (uint32_t i = 0; i < BENCH_SOLVES; i++)
+    {
+        target[0] ^= (int32_t)(i & 0xFFU);
+        (void)ik_solve(&ik, target, joints);
+        sink += joints[0];
+    }
+    uint64_t fixed_cycles = test_cycles() - start;
+
+    start = test_cycles();
+    for (uint32_t i = 0; i < BENCH_SOLVES; i++)
+    {
+        target[0] ^= (int32_t)(i & 0xFFU);
+        (void)ref_solve(arm, false, target, ref);
+        sink_ref += ref[0];
+    }
+    uint64_t ref_cycles = test_cycles() - start;
+    (void)sink;
+    (void)sink_ref;
+    printf("bench: IK arm %u: %.1f host cycles per solve, double-precision reference %.1f (in hardware on the host, "
+           "emulated on the Cortex-M4F)\n",
+           (unsigned)arm, (double)fixed_cycles / BENCH_SOLVES, (double)ref_cycles / BENCH_SOLVES);
+}
+
+/*============================================================================*/
\ No newline at end of file
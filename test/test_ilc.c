@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * @file   test_ilc.c
+ * @brief  Iterative learning control host test: the firmware's PID loop (see
+ *         test_pid.c) with the learnt feedforward (see ilc_step in
+ *         servo_ctrl.c) on the plant model at 1 kHz, tracking a repeated
+ *         motion cycle of two S-curve moves (10 -> 170 -> 10 degrees), one
+ *         table sample per PWM frame and the learning called once per frame
+ *         as from the learning task.
+ *             - Learning: the tracking error (RMS per cycle) falls over the
+ *               iterations, without and with feedback noise and a load, and
+ *               does not grow back once converged.
+ *             - A cycle of a different length is not learnt from.
+ *             - Stop: the correction is removed.
+ *             - Cycles per update and per learning (benchmark).
+ ******************************************************************************/
+
+#include "ilc.h"
+#include "pid.h"
+#include "plant.h"
+#include "profile.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define LOOPS_PER_FRAME         20
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define PID_OUTPUT_MAX          30.0f
+#define ILC_GAIN                0.5f
+#define ILC_LEAD                2
+#define ILC_FORGET              0.98f
+#define ILC_RANGE_DEG           32.0f
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define MOVE_LOOPS              1500    /* A move started every 1.5 s: a cycle of 150 frames. */
+#define MOVES_PER_CYCLE         2
+#define LEARN_LOOP              10      /* Loop within the frame at which the learning runs. */
+#define NUM_CYCLES              60
+#define LEARNING_CYCLES         40      /* Cycles over which each iteration reduces the error. */
+#define LEARNT_ERROR_RATIO      0.15f
+#define BENCH_CYCLES            200
+
+/*===== Typedefs =============================================================*/
+
+typedef struct LOOP_t {
+    PID_t pid;
+    PLANT_t plant;
+    PROFILE_GEN_t gen;
+    ILC_t ilc;
+    float latched;              /* Latched command (degrees). */
+    uint32_t moves_ref;         /* Moves started at the last cycle boundary. */
+    bool up;                    /* Next move's direction. */
+} LOOP_t;
+
+static const PROFILE_LIMITS_t _limits = {
+    .velocity = 180.0f,
+    .acceleration = 1000.0f,
+    .jerk = 20000.0f,
+};
+
+static ILC_TABLES_t _tables;
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config);
+static float loop_run_cycle(LOOP_t *loop, uint32_t move_loops);
+static void test_learning(const char *name, const PLANT_CONFIG_t *plant_config, uint32_t seed);
+static void test_length(void);
+static void test_stop(void);
+static void bench_ilc(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+
+    test_learning("nominal", &config, 1);
+    config.noise_deg = 0.1f;
+    config.load_deg = 3.0f;
+    test_learning("noise 0.1 deg, 3 deg load", &config, 2);
+    test_length();
+    test_stop();
+    bench_ilc();
+    return test_result("test_ilc");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise the loop at 10 degrees with the ILC started (from the
+ *         first cycle boundary).
+ * @param  loop:         Loop.
+ * @param  plant_config: Plant configuration.
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config)
+{
+    const PID_CONFIG_t pid_config = {
+        .kp = 0.5f,
+        .ki = 5.0f,
+        .kd = 0.0f,
+        .period_s = 1.0f / (float)LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const ILC_CONFIG_t ilc_config = {
+        .decimation = LOOPS_PER_FRAME,
+        .range = ILC_RANGE_DEG,
+        .gain = ILC_GAIN,
+        .lead = ILC_LEAD,
+        .forget = ILC_FORGET,
+    };
+
+    pid_init(&loop->pid, &pid_config);
+    plant_init(&loop->plant, plant_config, 10.0f);
+    profile_init(&loop->gen, LOOP_RATE_HZ, Q16(10.0f));
+    (void)ilc_init(&loop->ilc, &ilc_config, &_tables);
+    ilc_start(&loop->ilc);
+    loop->latched = loop->plant.command;
+    loop->moves_ref = profile_get_moves_started(&loop->gen) - MOVES_PER_CYCLE + 1U; /* As servo_ctrl_ilc_process. */
+    loop->up = true;
+}
+
+/**
+ * @brief  Run one motion cycle as the firmware: a move queued every
+ *         @param move_loops, the cycle boundary marked as its first move
+ *         starts, the learnt correction and the PID controller's output
+ *         added to the setpoint, limited to the servo's range and the slew
+ *         limit about the latched command.
+ * @param  loop:       Loop.
+ * @param  move_loops: Loops per move.
+ * @retval RMS tracking error of the cycle (degrees).
+ */
+static float loop_run_cycle(LOOP_t *loop, uint32_t move_loops)
+{
+    const float slew_step = SLEW_DEG_S * (float)LOOPS_PER_FRAME / (float)LOOP_RATE_HZ;
+    double sum_sq = 0.0;
+
+    for (uint32_t k = 0; k < (MOVES_PER_CYCLE * move_loops); k++)
+    {
+        if ((k % move_loops) == 0)
+        {
+            (void)profile_plan(&loop->gen, PROFILE_TYPE__S_CURVE, loop->up ? Q16(170.0f) : Q16(10.0f), &_limits,
+                               false);
+            profile_commit(&loop->gen);
+            loop->up = !loop->up;
+        }
+        float setpoint = (float)profile_next(&loop->gen) / 65536.0f;
+        if ((profile_get_moves_started(&loop->gen) - loop->moves_ref) >= MOVES_PER_CYCLE)
+        {
+            loop->moves_ref += MOVES_PER_CYCLE;
+            ilc_cycle_start(&loop->ilc);
+        }
+        float command = setpoint + ilc_update(&loop->ilc, setpoint - loop->plant.feedback);
+        float command_min = fmaxf(0.0f, loop->latched - slew_step);
+        float command_max = fminf(ANGLE_MAX, loop->latched + slew_step);
+        pid_set_actuator_limits(&loop->pid, command_min - command, command_max - command);
+        command += pid_update(&loop->pid, setpoint, loop->plant.feedback);
+        command = fmaxf(command_min, fminf(command_max, command));
+        if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+        {
+            loop->latched = command;
+        }
+        plant_step(&loop->plant, command);
+        sum_sq += (double)((setpoint - loop->plant.position) * (setpoint - loop->plant.position));
+
+        /* The learning task, once per frame. */
+        if (loop->plant.loop == LEARN_LOOP)
+        {
+            (void)ilc_learn(&loop->ilc);
+        }
+    }
+    return (float)sqrt(sum_sq / (double)(MOVES_PER_CYCLE * move_loops));
+}
+
+/**
+ * @brief  Learning over NUM_CYCLES cycles (an iteration every other cycle):
+ *         the tracking error falls with each iteration until it converges,
+ *         to below LEARNT_ERROR_RATIO of the first cycle's (without a
+ *         correction), and does not grow back.
+ * @param  name:         Case name.
+ * @param  plant_config: Plant configuration.
+ * @param  seed:         Feedback noise seed.
+ * @retval None.
+ */
+static void test_learning(const char *name, const PLANT_CONFIG_t *plant_config, uint32_t seed)
+{
+    LOOP_t loop;
+    float rms[NUM_CYCLES];
+    float rms_min = 1e9f;
+    float late_max = 0.0f;
+    uint32_t rises = 0;
+
+    test_rand_seed(seed);
+    loop_init(&loop, plant_config);
+    for (uint32_t i = 0; i < NUM_CYCLES; i++)
+    {
+        rms[i] = loop_run_cycle(&loop, MOVE_LOOPS);
+        rms_min = fminf(rms_min, rms[i]);
+        if ((i >= 2) && (i < LEARNING_CYCLES) && (rms[i] >= rms[i - 2]))
+        {
+            rises++;
+        }
+        if (i >= (NUM_CYCLES - 10))
+        {
+            late_max = fmaxf(late_max, rms[i]);
+        }
+    }
+    printf("ILC, %s: tracking error rms %.3f -> %.3f -> %.3f -> %.3f deg (cycles 1, 11, 21, %u), min %.3f deg, "
+           "%lu iterations\n",
+           name, (double)rms[0], (double)rms[10], (double)rms[20], (double)rms[NUM_CYCLES - 1], NUM_CYCLES,
+           (double)rms_min, (unsigned long)loop.ilc.stats.iterations);
+    TEST_CHECK(loop.ilc.stats.iterations >= ((NUM_CYCLES / 2) - 2), "%s: %lu iterations", name,
+               (unsigned long)loop.ilc.stats.iterations);
+    TEST_CHECK((loop.ilc.stats.skipped == 0) && (loop.ilc.stats.overruns == 0), "%s: %lu skipped, %lu overruns",
+               name, (unsigned long)loop.ilc.stats.skipped, (unsigned long)loop.ilc.stats.overruns);
+    TEST_CHECK(rises == 0, "%s: error rms rose %lu times over the first %u cycles' iterations", name,
+               (unsigned long)rises, LEARNING_CYCLES);
+    TEST_CHECK(late_max < (LEARNT_ERROR_RATIO * rms[0]), "%s: error rms %.3f deg in the last cycles, %.3f deg without",
+               name, (double)late_max, (double)rms[0]);
+    TEST_CHECK(late_max < (2.0f * rms_min), "%s: error rms grew back to %.3f deg from %.3f deg", name,
+               (double)late_max, (double)rms_min);
+}
+
+/**
+ * @brief  A cycle of a different length after learning: skipped, and the
+ *         correction still applied to the next cycles of the original length.
+ * @retval None.
+ */
+static void test_length(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    LOOP_t loop;
+    float rms_before = 0.0f;
+
+    loop_init(&loop, &config);
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        rms_before = loop_run_cycle(&loop, MOVE_LOOPS);
+    }
+    uint32_t skipped = loop.ilc.stats.skipped;
+    uint32_t iterations = loop.ilc.stats.iterations;
+    (void)loop_run_cycle(&loop, MOVE_LOOPS + 200);
+    float rms_after = loop_run_cycle(&loop, MOVE_LOOPS);
+    rms_after = fmaxf(rms_after, loop_run_cycle(&loop, MOVE_LOOPS));
+    printf("ILC, longer cycle: %lu skipped, %lu iterations; error rms %.3f deg before, %.3f deg after\n",
+           (unsigned long)(loop.ilc.stats.skipped - skipped), (unsigned long)(loop.ilc.stats.iterations - iterations),
+           (double)rms_before, (double)rms_after);
+    TEST_CHECK(loop.ilc.stats.skipped > skipped, "longer cycle not skipped");
+    TEST_CHECK(loop.ilc.stats.length == ((MOVES_PER_CYCLE * MOVE_LOOPS) / LOOPS_PER_FRAME), "cycle length %lu",
+               (unsigned long)loop.ilc.stats.length);
+    TEST_CHECK(rms_after < (1.5f * rms_before), "error rms %.3f deg after the longer cycle, %.3f deg before",
+               (double)rms_after, (double)rms_before);
+}
+
+/**
+ * @brief  Stop after learning: idle and no correction.
+ * @retval None.
+ */
+static void test_stop(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    LOOP_t loop;
+
+    loop_init(&loop, &config);
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        (void)loop_run_cycle(&loop, MOVE_LOOPS);
+    }
+    ilc_stop(&loop.ilc);
+    float correction = 0.0f;
+    for (uint32_t k = 0; k < (MOVES_PER_CYCLE * MOVE_LOOPS); k++)
+    {
+        correction = fmaxf(correction, fabsf(ilc_update(&loop.ilc, 1.0f)));
+    }
+    TEST_CHECK(ilc_get_state(&loop.ilc) == ILC_STATE__IDLE, "state %d after stop", (int)ilc_get_state(&loop.ilc));
+    TEST_CHECK(correction == 0.0f, "correction %.3f deg after stop", (double)correction);
+}
+
+/**
+ * @brief  Cycles per update (a cycle's updates with a correction applied)
+ *         and per learning (a full table).
+ * @retval None.
+ */
+static void bench_ilc(void)
+{
+    const ILC_CONFIG_t config = {
+        .decimation = LOOPS_PER_FRAME,
+        .range = ILC_RANGE_DEG,
+        .gain = ILC_GAIN,
+        .lead = ILC_LEAD,
+        .forget = ILC_FORGET,
+    };
+    const uint32_t updates = ILC_MAX_SAMPLES * LOOPS_PER_FRAME;
+    ILC_t ilc;
+    uint64_t update_cycles = 0;
+    uint64_t learn_cycles = 0;
+    uint32_t learnt = 0;
+    volatile float sink = 0.0f;
+
+    (void)ilc_init(&ilc, &config, &_tables);
+    ilc_start(&ilc);
+    ilc_cycle_start(&ilc);
+    for (uint32_t i = 0; i < BENCH_CYCLES; i++)
+    {
+        uint64_t start = test_cycles();
+        for (uint32_t k = 0; k < updates; k++)
+        {
+            sink += ilc_update(&ilc, 0.01f * (float)(k % 100));
+        }
+        update_cycles += test_cycles() - start;
+        ilc_cycle_start(&ilc);
+
+        start = test_cycles();
+        learnt += ilc_learn(&ilc) ? 1U : 0U;
+        learn_cycles += test_cycles() - start;
+    }
+    (void)sink;
+    printf("ILC: %.1f cycles per update, %.0f cycles per learning (%u samples; %lu learnt)\n",
+           (double)update_cycles / ((double)BENCH_CYCLES * (double)updates),
+           (double)learn_cycles / (double)(learnt ? learnt : 1U), ILC_MAX_SAMPLES, (unsigned long)learnt);
+}
+
+/*============================================================================*/
\ No newline at end of file
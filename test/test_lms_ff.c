@@ -0,0 +1,384 @@
+/*******************************************************************************
+ * @file   test_lms_ff.c
+ * @brief  Adaptive feedforward host test: the firmware's PID loop (see
+ *         test_pid.c) with the adapted feedforward (see lms_step in
+ *         servo_ctrl.c) on the plant model at 1 kHz, tracking S-curve moves
+ *         (10 <-> 170 degrees), one update per PWM frame and the adaptation
+ *         called once per frame as from the learning task; with either
+ *         kernel (see LMS_FF_KERNEL_t).
+ *             - Adaptation: the tracking error (RMS per move pair) falls,
+ *               without and with feedback noise and a load, as much with
+ *               the Q31 kernel as the floating-point one, and no block is
+ *               dropped.
+ *             - Identification (open loop, the error that of a known filter
+ *               less the feedforward): both kernels adapt to its
+ *               coefficients.
+ *             - Configuration: a Q31 kernel without a range is rejected.
+ *             - Cycles per update and per block (benchmark).
+ ******************************************************************************/
+
+#include "estimator.h"
+#include "lms_ff.h"
+#include "pid.h"
+#include "plant.h"
+#include "profile.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define LOOPS_PER_FRAME         20
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define PID_OUTPUT_MAX          30.0f
+#define LMS_RANGE_DEG           16.0f
+#define LMS_MU                  0.05f
+#define LMS_ENERGY_MIN          0.1f
+#define LMS_LEAK                0.005f
+#define LMS_OUTPUT_MAX_DEG      20.0f
+#define LMS_LEAD                2
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define MOVE_LOOPS              1500    /* A move started every 1.5 s. */
+#define ADAPT_LOOP              10      /* Loop within the frame at which the adaptation runs. */
+#define NUM_PAIRS               40      /* Move pairs (3 s each) adapted over. */
+#define ADAPTED_ERROR_RATIO     0.65f
+#define KERNEL_ERROR_RATIO      1.1f    /* Q31 kernel's adapted error against the floating-point kernel's. */
+#define ID_BLOCKS               2000
+#define ID_TOLERANCE            0.01f
+#define BENCH_BLOCKS            10000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct LOOP_t {
+    PID_t pid;
+    ESTIMATOR_t est;
+    PLANT_t plant;
+    PROFILE_GEN_t gen;
+    LMS_FF_t ff;
+    float latched;              /* Latched command (degrees). */
+    float output;               /* Feedforward, held over the frame (degrees). */
+    bool up;                    /* Next move's direction. */
+} LOOP_t;
+
+static const PROFILE_LIMITS_t _limits = {
+    .velocity = 180.0f,
+    .acceleration = 1000.0f,
+    .jerk = 20000.0f,
+};
+
+static const char *const _kernel_names[LMS_FF_KERNEL__NUM] = {"f32", "q31"};
+
+/*===== Private Function Prototypes ==========================================*/
+static LMS_FF_CONFIG_t lms_config(LMS_FF_KERNEL_t kernel);
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config, LMS_FF_KERNEL_t kernel);
+static float loop_run_pair(LOOP_t *loop);
+static void test_adaptation(const char *name, const PLANT_CONFIG_t *plant_config, uint32_t seed);
+static void test_identification(void);
+static void test_config(void);
+static void bench_lms_ff(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+
+    test_adaptation("nominal", &config, 1);
+    config.noise_deg = 0.1f;
+    config.load_deg = 3.0f;
+    test_adaptation("noise 0.1 deg, 3 deg load", &config, 2);
+    test_identification();
+    test_config();
+    bench_lms_ff();
+    return test_result("test_lms_ff");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  The firmware's configuration (see servo_ctrl_init) with a kernel.
+ * @param  kernel: Adaptation kernel.
+ * @retval Configuration.
+ */
+static LMS_FF_CONFIG_t lms_config(LMS_FF_KERNEL_t kernel)
+{
+    const LMS_FF_CONFIG_t config = {
+        .kernel = kernel,
+        .range = LMS_RANGE_DEG,
+        .mu = LMS_MU,
+        .energy_min = LMS_ENERGY_MIN,
+        .leak = LMS_LEAK,
+        .output_max = LMS_OUTPUT_MAX_DEG,
+        .lead = LMS_LEAD,
+    };
+    return config;
+}
+
+/**
+ * @brief  Initialise the loop at 10 degrees with the feedforward cleared.
+ * @param  loop:         Loop.
+ * @param  plant_config: Plant configuration.
+ * @param  kernel:       Adaptation kernel.
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config, LMS_FF_KERNEL_t kernel)
+{
+    const PID_CONFIG_t pid_config = {
+        .kp = 0.5f,
+        .ki = 5.0f,
+        .kd = 0.0f,
+        .period_s = 1.0f / (float)LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const ESTIMATOR_CONFIG_t est_config = {
+        .type = ESTIMATOR_TYPE__KALMAN,
+        .period_s = 1.0f / (float)LOOP_RATE_HZ,
+        .meas_period_s = (float)LOOPS_PER_FRAME / (float)LOOP_RATE_HZ,
+        .alpha = 0.5f,
+        .beta = 0.17f,
+        .gamma = 0.03f,
+        .process_noise = 1.0e5f,
+        .meas_noise = 0.25f,
+        .init_var_vel = 1.0e4f,
+        .init_var_acc = 1.0e6f,
+    };
+    const LMS_FF_CONFIG_t config = lms_config(kernel);
+
+    pid_init(&loop->pid, &pid_config);
+    estimator_init(&loop->est, &est_config);
+    plant_init(&loop->plant, plant_config, 10.0f);
+    profile_init(&loop->gen, LOOP_RATE_HZ, Q16(10.0f));
+    TEST_CHECK(lms_ff_init(&loop->ff, &config), "%s: initialised", _kernel_names[kernel]);
+    loop->latched = loop->plant.command;
+    loop->output = 0.0f;
+    loop->up = true;
+}
+
+/**
+ * @brief  Run a pair of moves as the firmware: the feedforward updated and
+ *         the tracking error (of the estimated position) recorded in the
+ *         loop whose command is latched,
+ *         its output and the PID controller's added to the setpoint, limited
+ *         to the servo's range and the slew limit about the latched command.
+ * @param  loop: Loop.
+ * @retval RMS tracking error of the pair (degrees).
+ */
+static float loop_run_pair(LOOP_t *loop)
+{
+    const float slew_step = SLEW_DEG_S * (float)LOOPS_PER_FRAME / (float)LOOP_RATE_HZ;
+    double sum_sq = 0.0;
+
+    for (uint32_t k = 0; k < (2U * MOVE_LOOPS); k++)
+    {
+        if ((k % MOVE_LOOPS) == 0)
+        {
+            (void)profile_plan(&loop->gen, PROFILE_TYPE__S_CURVE, loop->up ? Q16(170.0f) : Q16(10.0f), &_limits,
+                               false);
+            profile_commit(&loop->gen);
+            loop->up = !loop->up;
+        }
+        float setpoint = (float)profile_next(&loop->gen) / 65536.0f;
+        estimator_predict(&loop->est);
+        if (loop->plant.feedback_new || (estimator_is_valid(&loop->est) == false))
+        {
+            estimator_correct(&loop->est, loop->plant.feedback);
+        }
+        bool frame_end = (loop->plant.loop == (loop->plant.config.loops_per_frame - 1));
+        if (frame_end)
+        {
+            loop->output = lms_ff_update(&loop->ff, setpoint);
+            lms_ff_record(&loop->ff, setpoint - estimator_get_position(&loop->est));
+        }
+        float command = setpoint + loop->output;
+        float command_min = fmaxf(0.0f, loop->latched - slew_step);
+        float command_max = fminf(ANGLE_MAX, loop->latched + slew_step);
+        pid_set_actuator_limits(&loop->pid, command_min - command, command_max - command);
+        command += pid_update(&loop->pid, setpoint, loop->plant.feedback);
+        command = fmaxf(command_min, fminf(command_max, command));
+        if (frame_end)
+        {
+            loop->latched = command;
+        }
+        plant_step(&loop->plant, command);
+        sum_sq += (double)((setpoint - loop->plant.position) * (setpoint - loop->plant.position));
+
+        /* The learning task, once per frame. */
+        if (loop->plant.loop == ADAPT_LOOP)
+        {
+            (void)lms_ff_adapt(&loop->ff);
+        }
+    }
+    return (float)sqrt(sum_sq / (double)(2U * MOVE_LOOPS));
+}
+
+/**
+ * @brief  Adaptation over NUM_PAIRS move pairs with each kernel: the
+ *         tracking error of the last pairs is below ADAPTED_ERROR_RATIO of
+ *         that without a feedforward (frozen from the start), the Q31
+ *         kernel's within KERNEL_ERROR_RATIO of the floating-point kernel's,
+ *         and no block is dropped.
+ * @param  name:         Case name.
+ * @param  plant_config: Plant configuration.
+ * @param  seed:         Feedback noise seed.
+ * @retval None.
+ */
+static void test_adaptation(const char *name, const PLANT_CONFIG_t *plant_config, uint32_t seed)
+{
+    float without = 0.0f;
+    float adapted[LMS_FF_KERNEL__NUM];
+
+    /* The first run without a feedforward. */
+    for (uint32_t run = 0; run <= LMS_FF_KERNEL__NUM; run++)
+    {
+        LMS_FF_KERNEL_t kernel = (run == 0) ? LMS_FF_KERNEL__F32 : (LMS_FF_KERNEL_t)(run - 1);
+        LOOP_t loop;
+        float first = 0.0f;
+        float late_max = 0.0f;
+
+        test_rand_seed(seed);
+        loop_init(&loop, plant_config, kernel);
+        lms_ff_freeze(&loop.ff, run == 0);
+        for (uint32_t i = 0; i < NUM_PAIRS; i++)
+        {
+            float rms = loop_run_pair(&loop);
+            first = (i == 0) ? rms : first;
+            if (i >= (NUM_PAIRS - 5))
+            {
+                late_max = fmaxf(late_max, rms);
+            }
+        }
+        if (run == 0)
+        {
+            without = late_max;
+            continue;
+        }
+        adapted[kernel] = late_max;
+        printf("LMS (%s), %s: tracking error rms %.3f -> %.3f deg, %.3f deg without, %lu blocks\n",
+               _kernel_names[kernel], name, (double)first, (double)late_max, (double)without,
+               (unsigned long)loop.ff.stats.blocks);
+        TEST_CHECK(late_max < (ADAPTED_ERROR_RATIO * without), "%s (%s): error rms %.3f deg adapted, %.3f deg without",
+                   name, _kernel_names[kernel], (double)late_max, (double)without);
+        TEST_CHECK(loop.ff.stats.dropped == 0, "%s (%s): %lu blocks dropped", name, _kernel_names[kernel],
+                   (unsigned long)loop.ff.stats.dropped);
+    }
+    TEST_CHECK(adapted[LMS_FF_KERNEL__Q31] < (KERNEL_ERROR_RATIO * adapted[LMS_FF_KERNEL__F32]),
+               "%s: error rms adapted %.3f deg (q31), %.3f deg (f32)", name, (double)adapted[LMS_FF_KERNEL__Q31],
+               (double)adapted[LMS_FF_KERNEL__F32]);
+}
+
+/**
+ * @brief  Identification with each kernel over ID_BLOCKS blocks (without
+ *         lead or leakage): white reference increments, and the error that
+ *         of a known filter less the feedforward applied. Both kernels'
+ *         coefficients converge to within ID_TOLERANCE of the filter's.
+ * @retval None.
+ */
+static void test_identification(void)
+{
+    const float target[LMS_FF_NUM_TAPS] = {0.2f, -0.6f, 1.5f, 2.5f};
+
+    for (uint32_t kernel = 0; kernel < LMS_FF_KERNEL__NUM; kernel++)
+    {
+        LMS_FF_CONFIG_t config = lms_config((LMS_FF_KERNEL_t)kernel);
+        LMS_FF_t ff;
+        float history[LMS_FF_NUM_TAPS] = {0.0f};
+        float reference = 90.0f;
+        float error_max = 0.0f;
+
+        config.leak = 0.0f;
+        config.lead = 0;
+        (void)lms_ff_init(&ff, &config);
+        test_rand_seed(3);
+        for (uint32_t i = 0; i < (ID_BLOCKS * LMS_FF_BLOCK_SIZE); i++)
+        {
+            float increment = test_rand_gauss();
+            reference += increment;
+            memmove(&history[0], &history[1], (LMS_FF_NUM_TAPS - 1) * sizeof(history[0]));
+            history[LMS_FF_NUM_TAPS - 1] = increment;
+
+            float output = lms_ff_update(&ff, reference);
+            for (uint32_t k = 0; k < LMS_FF_NUM_TAPS; k++)
+            {
+                output -= target[k] * history[k];
+            }
+            lms_ff_record(&ff, -output);
+            (void)lms_ff_adapt(&ff);
+        }
+        for (uint32_t k = 0; k < LMS_FF_NUM_TAPS; k++)
+        {
+            error_max = fmaxf(error_max, fabsf(ff.coeffs[ff.active][k] - target[k]));
+        }
+        printf("LMS (%s), identification: coefficients %.4f %.4f %.4f %.4f, error max %.5f\n", _kernel_names[kernel],
+               (double)ff.coeffs[ff.active][0], (double)ff.coeffs[ff.active][1], (double)ff.coeffs[ff.active][2],
+               (double)ff.coeffs[ff.active][3], (double)error_max);
+        TEST_CHECK(error_max < ID_TOLERANCE, "identification (%s): coefficient error %.4f", _kernel_names[kernel],
+                   (double)error_max);
+    }
+}
+
+/**
+ * @brief  A Q31 kernel without a range, and an unknown kernel: rejected.
+ * @retval None.
+ */
+static void test_config(void)
+{
+    LMS_FF_CONFIG_t config = lms_config(LMS_FF_KERNEL__Q31);
+    LMS_FF_t ff;
+
+    config.range = 0.0f;
+    TEST_CHECK(lms_ff_init(&ff, &config) == false, "Q31 kernel without a range accepted");
+    config = lms_config(LMS_FF_KERNEL__NUM);
+    TEST_CHECK(lms_ff_init(&ff, &config) == false, "unknown kernel accepted");
+}
+
+/**
+ * @brief  Benchmark the updates and the blocks' adaptation with each kernel.
+ * @retval None.
+ */
+static void bench_lms_ff(void)
+{
+    for (uint32_t kernel = 0; kernel < LMS_FF_KERNEL__NUM; kernel++)
+    {
+        const LMS_FF_CONFIG_t config = lms_config((LMS_FF_KERNEL_t)kernel);
+        LMS_FF_t ff;
+        uint64_t update_cycles = 0;
+        uint64_t adapt_cycles = 0;
+        uint32_t adapted = 0;
+        volatile float sink = 0.0f;
+
+        (void)lms_ff_init(&ff, &config);
+        for (uint32_t i = 0; i < BENCH_BLOCKS; i++)
+        {
+            uint64_t start = test_cycles();
+            for (uint32_t k = 0; k < LMS_FF_BLOCK_SIZE; k++)
+            {
+                float reference = 90.0f + (60.0f * sinf(0.01f * (float)((i * LMS_FF_BLOCK_SIZE) + k)));
+                sink += lms_ff_update(&ff, reference);
+                lms_ff_record(&ff, 0.1f * sinf(0.03f * (float)k));
+            }
+            update_cycles += test_cycles() - start;
+
+            start = test_cycles();
+            adapted += lms_ff_adapt(&ff) ? 1U : 0U;
+            adapt_cycles += test_cycles() - start;
+        }
+        (void)sink;
+        printf("LMS (%s): %.1f cycles per update and record, %.0f cycles per block (%u pairs; %lu adapted)\n",
+               _kernel_names[kernel], (double)update_cycles / ((double)BENCH_BLOCKS * LMS_FF_BLOCK_SIZE),
+               (double)adapt_cycles / (double)(adapted ? adapted : 1U), LMS_FF_BLOCK_SIZE, (unsigned long)adapted);
+    }
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,433 @@
+/*******************************************************************************
+ * @file   test_motor_health.c
+ * @brief  Motor health monitor host test: the firmware's monitor (see
+ *         servo_ctrl_loop_run) fed by the PID loop, the Kalman estimator and
+ *         the load term closed around the plant model at 1 kHz, with faults
+ *         injected into the plant and the feedback.
+ *             - Normal moves: trapezoidal and S-curve moves over the range
+ *               with a load and feedback noise, and the holds after them,
+ *               trip nothing.
+ *             - Stall: the servo blocked mid-move and at a hold.
+ *             - Overload: a load the controller holds the servo against.
+ *             - Feedback loss: no new samples, and samples out of range.
+ *             - Each injected fault detected as itself, the configured
+ *               number of periods after its condition's onset, with the onset
+ *               reported; a detected fault is latched until reset.
+ ******************************************************************************/
+
+#include "estimator.h"
+#include "motor_health.h"
+#include "pid.h"
+#include "plant.h"
+#include "profile.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define LOOPS_PER_FRAME         20
+#define FRAME_RATE_HZ           50.0f
+#define PID_KP                  0.5f
+#define PID_KI                  5.0f
+#define PID_OUTPUT_MAX          30.0f
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define VELOCITY_MAX            180.0f
+#define ACCELERATION_MAX        1000.0f
+#define JERK_MAX                20000.0f
+#define LOAD_TAU_S              0.1f
+#define STALL_ERROR_DEG         10.0f
+#define STALL_SPEED_DEG_S       5.0f
+#define STALL_TRAVEL_DEG        3.0f
+#define STALL_PERIODS           (LOOP_RATE_HZ / 4)
+#define OVERLOAD_DEG            20.0f
+#define OVERLOAD_PERIODS        (LOOP_RATE_HZ / 2)
+#define FB_LOSS_PERIODS         (3 * LOOPS_PER_FRAME)
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define NOISE_DEG               0.5f    /* The estimator's measurement noise. */
+#define NORMAL_LOAD_DEG         3.0f
+#define OVERLOAD_LOAD_DEG       25.0f
+#define SETTLE_TICKS            (2 * LOOP_RATE_HZ)  /* Before a fault is injected. */
+#define RUN_TICKS               (3 * LOOP_RATE_HZ)  /* After a fault is injected. */
+#define ONSET_MAX_TICKS         (LOOP_RATE_HZ / 2)  /* Injection to the condition's onset. */
+
+/*===== Typedefs =============================================================*/
+
+typedef enum INJECT_t {
+    INJECT__NONE,
+    INJECT__BLOCK,              /* The servo stops and no longer moves. */
+    INJECT__LOAD,               /* The servo settles OVERLOAD_LOAD_DEG short of its command. */
+    INJECT__NO_SAMPLES,         /* No new feedback samples. */
+    INJECT__OUT_OF_RANGE,       /* Feedback samples invalid. */
+} INJECT_t;
+
+typedef struct LOOP_t {
+    PID_t pid;
+    ESTIMATOR_t est;
+    PROFILE_GEN_t profile;
+    MOTOR_HEALTH_t health;
+    PLANT_t plant;
+    float setpoint;
+    float latched;              /* Command latched at the last frame boundary (slew limit, health). */
+    float load;                 /* Load term (degrees). */
+    INJECT_t inject;
+    uint32_t tick;
+    uint32_t sampled;           /* Tick of the last new valid feedback sample. */
+} LOOP_t;
+
+typedef struct FAULT_RESULT_t {
+    MOTOR_FAULT_t fault;        /* Detected (NONE if not within the run). */
+    uint32_t detected;          /* Tick of the detection. */
+    uint32_t onset;             /* Onset reported. */
+    uint32_t latched_faults;    /* Faults reported after the detection (latched: none). */
+} FAULT_RESULT_t;
+
+/*===== Private Constants ====================================================*/
+
+static const PROFILE_LIMITS_t _limits = {
+    .velocity = VELOCITY_MAX,
+    .acceleration = ACCELERATION_MAX,
+    .jerk = JERK_MAX,
+};
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, float position, float load_deg, float noise_deg);
+static MOTOR_FAULT_t loop_step(LOOP_t *loop);
+static void move(LOOP_t *loop, PROFILE_TYPE_t type, float target);
+static FAULT_RESULT_t run_fault(LOOP_t *loop, INJECT_t inject, uint32_t *injected);
+static void test_normal(void);
+static void test_fault(INJECT_t inject, bool moving, MOTOR_FAULT_t expected, uint32_t periods, const char *name);
+static void test_reset(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_rand_seed(1);
+    test_normal();
+    test_fault(INJECT__BLOCK, true, MOTOR_FAULT__STALL, STALL_PERIODS, "stall mid-move");
+    test_fault(INJECT__BLOCK, false, MOTOR_FAULT__STALL, STALL_PERIODS, "stall at a hold");
+    test_fault(INJECT__LOAD, false, MOTOR_FAULT__OVERLOAD, OVERLOAD_PERIODS, "overload");
+    test_fault(INJECT__NO_SAMPLES, true, MOTOR_FAULT__FEEDBACK_LOSS, FB_LOSS_PERIODS, "no feedback samples");
+    test_fault(INJECT__OUT_OF_RANGE, false, MOTOR_FAULT__FEEDBACK_LOSS, FB_LOSS_PERIODS, "feedback out of range");
+    test_reset();
+    return test_result("test_motor_health");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a loop at rest.
+ * @param  loop:      Loop.
+ * @param  position:  Initial position (degrees).
+ * @param  load_deg:  Plant load (degrees).
+ * @param  noise_deg: Feedback noise (degrees).
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, float position, float load_deg, float noise_deg)
+{
+    const PID_CONFIG_t pid_config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const ESTIMATOR_CONFIG_t est_config = {
+        .type = ESTIMATOR_TYPE__KALMAN,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .meas_period_s = 1.0f / FRAME_RATE_HZ,
+        .process_noise = 1.0e5f,
+        .meas_noise = 0.25f,
+        .init_var_vel = 1.0e4f,
+        .init_var_acc = 1.0e6f,
+    };
+    const MOTOR_HEALTH_CONFIG_t health_config = {
+        .stall_error = STALL_ERROR_DEG,
+        .stall_speed = STALL_SPEED_DEG_S,
+        .stall_travel = STALL_TRAVEL_DEG,
+        .stall_periods = STALL_PERIODS,
+        .overload_load = OVERLOAD_DEG,
+        .overload_periods = OVERLOAD_PERIODS,
+        .fb_loss_periods = FB_LOSS_PERIODS,
+    };
+    PLANT_CONFIG_t plant_config = PLANT_CONFIG_DEFAULT;
+    plant_config.load_deg = load_deg;
+    plant_config.noise_deg = noise_deg;
+
+    pid_init(&loop->pid, &pid_config);
+    estimator_init(&loop->est, &est_config);
+    profile_init(&loop->profile, LOOP_RATE_HZ, Q16(position));
+    motor_health_init(&loop->health, &health_config);
+    plant_init(&loop->plant, &plant_config, position);
+    loop->setpoint = position;
+    loop->latched = loop->plant.command;
+    loop->load = 0.0f;
+    loop->inject = INJECT__NONE;
+    loop->tick = 0;
+    loop->sampled = 0;
+}
+
+/**
+ * @brief  Run one loop iteration as the firmware: the estimator, the PID
+ *         command (limited to the servo's range and the slew limit about the
+ *         latched command), the load term and the health monitor, with the
+ *         loop's injected fault applied to the plant and the feedback.
+ * @param  loop: Loop.
+ * @retval Fault detected by this iteration, else MOTOR_FAULT__NONE.
+ */
+static MOTOR_FAULT_t loop_step(LOOP_t *loop)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    bool fb_new = loop->plant.feedback_new && (loop->inject != INJECT__NO_SAMPLES);
+    bool fb_valid = (loop->inject != INJECT__OUT_OF_RANGE);
+
+    loop->setpoint = (float)profile_next(&loop->profile) / 65536.0f;
+    estimator_predict(&loop->est);
+    if (fb_valid && fb_new)
+    {
+        estimator_correct(&loop->est, loop->plant.feedback);
+        loop->sampled = loop->tick;
+    }
+
+    float command = loop->latched;
+    if (fb_valid)
+    {
+        float command_min = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched - slew_step));
+        float command_max = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched + slew_step));
+        pid_set_actuator_limits(&loop->pid, command_min - loop->setpoint, command_max - loop->setpoint);
+        command = loop->setpoint + pid_update(&loop->pid, loop->setpoint, loop->plant.feedback);
+        command = fmaxf(command_min, fminf(command_max, command));
+        loop->load += ((1.0f / LOOP_RATE_HZ) / (LOAD_TAU_S + (1.0f / LOOP_RATE_HZ))) *
+                      (fabsf(command - loop->setpoint) - loop->load);
+    }
+
+    const MOTOR_HEALTH_INPUT_t input = {
+        .timestamp = loop->tick,
+        .feedback_valid = fb_valid,
+        .feedback_new = fb_new,
+        .controlled = true,
+        .command = loop->latched,
+        .position = loop->plant.feedback,
+        .velocity = estimator_get_velocity(&loop->est),
+        .load = loop->load,
+    };
+    MOTOR_FAULT_t fault = motor_health_update(&loop->health, &input);
+
+    if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+    {
+        loop->latched = command;
+    }
+    plant_step(&loop->plant, command);
+    loop->tick++;
+    return fault;
+}
+
+/**
+ * @brief  Queue a move.
+ * @param  loop:   Loop.
+ * @param  type:   Profile type.
+ * @param  target: Target (degrees).
+ * @retval None.
+ */
+static void move(LOOP_t *loop, PROFILE_TYPE_t type, float target)
+{
+    TEST_CHECK(profile_plan(&loop->profile, type, Q16(target), &_limits, false), "move to %.1f deg not planned",
+               (double)target);
+    profile_commit(&loop->profile);
+}
+
+/**
+ * @brief  Inject a fault and run the loop until it is detected (or for
+ *         RUN_TICKS), then on for OVERLOAD_PERIODS: a blocked servo is held
+ *         by stiction from standstill, a load settles it short of its command.
+ * @param  loop:     Loop, with the fault's tick injected at @param injected.
+ * @param  inject:   Fault.
+ * @param  injected: Tick of the injection; of a feedback loss, the first
+ *                   without a sample (the tick after the last sample).
+ *                   Passed by reference.
+ * @retval Result.
+ */
+static FAULT_RESULT_t run_fault(LOOP_t *loop, INJECT_t inject, uint32_t *injected)
+{
+    FAULT_RESULT_t result = {.fault = MOTOR_FAULT__NONE};
+
+    *injected = loop->tick;
+    loop->inject = inject;
+    if (inject == INJECT__BLOCK)
+    {
+        loop->plant.config.stiction_deg = 1.0e6f;
+        loop->plant.velocity = 0.0f;
+    }
+    else if (inject == INJECT__LOAD)
+    {
+        loop->plant.config.load_deg = OVERLOAD_LOAD_DEG;
+    }
+    else if (inject != INJECT__NONE)
+    {
+        *injected = loop->sampled + 1;
+    }
+
+    for (uint32_t k = 0; k < RUN_TICKS; k++)
+    {
+        uint32_t tick = loop->tick;
+        MOTOR_FAULT_t fault = loop_step(loop);
+        if (result.fault != MOTOR_FAULT__NONE)
+        {
+            result.latched_faults += (fault != MOTOR_FAULT__NONE);
+            if ((tick - result.detected) >= OVERLOAD_PERIODS)
+            {
+                break;
+            }
+        }
+        else if (fault != MOTOR_FAULT__NONE)
+        {
+            result.fault = fault;
+            result.detected = tick;
+            result.onset = UINT32_MAX;
+            TEST_CHECK(motor_health_get_fault(&loop->health, &result.onset) == fault, "fault not latched");
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief  Moves back and forth over the range, trapezoidal and S-curve, with
+ *         a load and feedback noise, each followed by a hold: no fault, with
+ *         the margins of each condition reported.
+ * @retval None.
+ */
+static void test_normal(void)
+{
+    static const float targets[] = {150.0f, 20.0f, 160.0f, 90.0f, 100.0f, 10.0f};
+    LOOP_t loop;
+    uint32_t faults = 0;
+    float load_max = 0.0f;
+    float still_error_max = 0.0f; /* |command - position| - load whilst below the stall speed. */
+    uint32_t samples_gap_max = 0;
+    uint32_t last_sample = 0;
+
+    loop_init(&loop, 90.0f, NORMAL_LOAD_DEG, NOISE_DEG);
+    for (uint32_t m = 0; m < (2 * TEST_NUM_ELS(targets)); m++)
+    {
+        PROFILE_TYPE_t type = (m < TEST_NUM_ELS(targets)) ? PROFILE_TYPE__TRAPEZOIDAL : PROFILE_TYPE__S_CURVE;
+        move(&loop, type, targets[m % TEST_NUM_ELS(targets)]);
+        for (uint32_t k = 0; k < SETTLE_TICKS; k++)
+        {
+            if (loop.plant.feedback_new)
+            {
+                uint32_t gap = loop.tick - last_sample;
+                samples_gap_max = (gap > samples_gap_max) ? gap : samples_gap_max;
+                last_sample = loop.tick;
+            }
+            faults += (loop_step(&loop) != MOTOR_FAULT__NONE);
+            load_max = fmaxf(load_max, loop.load);
+            if (fabsf(estimator_get_velocity(&loop.est)) < STALL_SPEED_DEG_S)
+            {
+                still_error_max = fmaxf(still_error_max, fabsf(loop.latched - loop.plant.feedback) - loop.load);
+            }
+        }
+    }
+    printf("normal moves: load term max %.2f deg (overload %.1f), still error max %.2f deg (stall %.1f), samples "
+           "every %u ticks (loss %u)\n",
+           (double)load_max, (double)OVERLOAD_DEG, (double)still_error_max, (double)STALL_ERROR_DEG,
+           (unsigned)samples_gap_max, (unsigned)FB_LOSS_PERIODS);
+    TEST_CHECK(faults == 0, "normal moves: %u faults", (unsigned)faults);
+    TEST_CHECK(motor_health_get_fault(&loop.health, NULL) == MOTOR_FAULT__NONE, "normal moves: fault latched");
+}
+
+/**
+ * @brief  Inject a fault, mid-move (a move of 150 degrees under way for
+ *         0.2 s) or at a hold, and check its detection.
+ * @param  inject:   Fault.
+ * @param  moving:   Whether mid-move, else at a hold.
+ * @param  expected: Fault to be detected.
+ * @param  periods:  Configured periods of the fault.
+ * @param  name:     Name to print.
+ * @retval None.
+ */
+static void test_fault(INJECT_t inject, bool moving, MOTOR_FAULT_t expected, uint32_t periods, const char *name)
+{
+    LOOP_t loop;
+    uint32_t faults = 0;
+    uint32_t injected;
+
+    loop_init(&loop, 15.0f, NORMAL_LOAD_DEG, NOISE_DEG);
+    for (uint32_t k = 0; k < SETTLE_TICKS; k++)
+    {
+        faults += (loop_step(&loop) != MOTOR_FAULT__NONE);
+    }
+    if (moving)
+    {
+        move(&loop, PROFILE_TYPE__S_CURVE, 165.0f);
+        for (uint32_t k = 0; k < (LOOP_RATE_HZ / 5); k++)
+        {
+            faults += (loop_step(&loop) != MOTOR_FAULT__NONE);
+        }
+    }
+    else if (inject == INJECT__BLOCK)
+    {
+        /* Blocked at the hold, then commanded away. */
+        move(&loop, PROFILE_TYPE__S_CURVE, 45.0f);
+    }
+
+    FAULT_RESULT_t result = run_fault(&loop, inject, &injected);
+    printf("%s: detected %u ticks after the injection, onset +%u ticks, %u ticks after the onset (%u "
+           "periods)\n",
+           name, (unsigned)(result.detected - injected), (unsigned)(result.onset - injected),
+           (unsigned)(result.detected - result.onset + 1), (unsigned)periods);
+    TEST_CHECK(faults == 0, "%s: %u faults before the injection", name, (unsigned)faults);
+    TEST_CHECK(result.fault == expected, "%s: fault %d detected, expected %d", name, (int)result.fault, (int)expected);
+    TEST_CHECK((result.onset >= injected) && ((result.onset - injected) <= ONSET_MAX_TICKS),
+               "%s: onset %u ticks after the injection", name, (unsigned)(result.onset - injected));
+    TEST_CHECK((result.detected - result.onset + 1) == periods, "%s: detected %u periods after the onset", name,
+               (unsigned)(result.detected - result.onset + 1));
+    TEST_CHECK(result.latched_faults == 0, "%s: %u faults whilst latched", name, (unsigned)result.latched_faults);
+}
+
+/**
+ * @brief  A latched fault cleared by a reset: the monitor re-arms on the next
+ *         valid sample and detects the fault again, as at its first onset.
+ * @retval None.
+ */
+static void test_reset(void)
+{
+    LOOP_t loop;
+    uint32_t injected;
+    uint32_t faults = 0;
+
+    loop_init(&loop, 90.0f, 0.0f, 0.0f);
+    for (uint32_t k = 0; k < SETTLE_TICKS; k++)
+    {
+        faults += (loop_step(&loop) != MOTOR_FAULT__NONE);
+    }
+    FAULT_RESULT_t first = run_fault(&loop, INJECT__NO_SAMPLES, &injected);
+
+    /* Restored and reset: no fault, then lost again. */
+    loop.inject = INJECT__NONE;
+    motor_health_reset(&loop.health);
+    for (uint32_t k = 0; k < SETTLE_TICKS; k++)
+    {
+        faults += (loop_step(&loop) != MOTOR_FAULT__NONE);
+    }
+    FAULT_RESULT_t second = run_fault(&loop, INJECT__NO_SAMPLES, &injected);
+
+    TEST_CHECK((first.fault == MOTOR_FAULT__FEEDBACK_LOSS) && (second.fault == MOTOR_FAULT__FEEDBACK_LOSS),
+               "reset: faults %d, %d", (int)first.fault, (int)second.fault);
+    TEST_CHECK(faults == 0, "reset: %u faults with feedback", (unsigned)faults);
+    TEST_CHECK((second.detected - second.onset + 1) == FB_LOSS_PERIODS, "reset: detected %u periods after the onset",
+               (unsigned)(second.detected - second.onset + 1));
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,436 @@
+/*******************************************************************************
+ * @file   test_mpc.c
+ * @brief  Model predictive controller host test: the firmware's MPC loop (see
+ *         servo_ctrl_loop_run, mpc_update) closed around the plant model at
+ *         1 kHz, solved once per PWM frame, against the firmware's PID loop.
+ *             - Step response and load rejection (the observer's
+ *               disturbance, offset-free), tracking error against the PID.
+ *             - Saturating reference (beyond the servo's limit, by the
+ *               command or by the position alone): the inputs within the
+ *               input constraints and the position within the position
+ *               constraint.
+ *             - Slew-limited reference (a step larger than the move
+ *               constraint over several frames): the moves within the move
+ *               constraint, and Hildreth's iterations bounded.
+ *             - Cycles per frame, one servo: the MPC's solve (unconstrained,
+ *               constrained and at the iteration bound) against the PID's
+ *               updates (benchmark).
+ ******************************************************************************/
+
+#include "mpc.h"
+#include "pid.h"
+#include "plant.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000.0f
+#define FRAME_RATE_HZ           50.0f
+#define PID_KP                  0.5f
+#define PID_KI                  5.0f
+#define PID_OUTPUT_MAX          30.0f
+#define SLEW_DEG_S              600.0f
+#define ANGLE_MAX               180.0f
+#define MPC_WN_HZ               6.0f
+#define MPC_ZETA                0.8f
+#define MPC_Q                   1.0f
+#define MPC_R                   0.01f
+#define MPC_S                   1.0f
+#define MPC_L_POS               0.3f
+#define MPC_L_VEL               0.0f
+#define MPC_L_DIST              0.1f
+#define MPC_SLEW_DEG_S          450.0f
+#define MPC_SOLVE_LOOP          14      /* Servo 0 of 6: loop (LOOPS_PER_FRAME - SERVO_NUM_SERVOS) of the frame. */
+
+#define MOVE_TOLERANCE          0.05f   /* Move constraint violation by the bounded iterations (degrees). */
+#define POSITION_TOLERANCE      0.3f    /* Position constraint violation, model mismatch and noise (degrees). */
+#define BENCH_FRAMES            100000
+
+/*===== Typedefs =============================================================*/
+
+typedef enum LOOP_TYPE_t {
+    LOOP_TYPE__PID = 0,
+    LOOP_TYPE__MPC
+} LOOP_TYPE_t;
+
+typedef struct LOOP_t {
+    LOOP_TYPE_t type;
+    PID_t pid;
+    MPC_STATE_t mpc_state;
+    float mpc_command;          /* Held between solves. */
+    MPC_LIMITS_t limits;        /* The servo's limits (MPC constraints). */
+    PLANT_t plant;
+    float latched;              /* Command latched at the last frame boundary (slew limit). */
+    /* Constraint monitoring (MPC). */
+    uint32_t solves;
+    uint32_t constrained;
+    uint32_t iterations_max;
+    float u_excess;             /* Largest input beyond its constraints. */
+    float du_excess;            /* Largest move beyond the move constraint. */
+} LOOP_t;
+
+/*===== Private Variables ====================================================*/
+static MPC_t _mpc;
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, LOOP_TYPE_t type, const PLANT_CONFIG_t *plant_config, float position,
+                      float limit_max);
+static void loop_step(LOOP_t *loop, float setpoint);
+static void test_step(void);
+static void test_saturating(void);
+static void test_slew(void);
+static void bench_frame(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    const MPC_CONFIG_t config = {
+        .period_s = 1.0f / FRAME_RATE_HZ,
+        .wn = 2.0f * PI * MPC_WN_HZ,
+        .zeta = MPC_ZETA,
+        .q = MPC_Q,
+        .r = MPC_R,
+        .s = MPC_S,
+        .l_pos = MPC_L_POS,
+        .l_vel = MPC_L_VEL,
+        .l_dist = MPC_L_DIST,
+    };
+
+    if (TEST_CHECK(mpc_init(&_mpc, &config), "MPC initialisation failed"))
+    {
+        test_step();
+        test_saturating();
+        test_slew();
+        bench_frame();
+    }
+    return test_result("test_mpc");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a loop at rest.
+ * @param  loop:         Loop.
+ * @param  type:         Controller.
+ * @param  plant_config: Plant configuration.
+ * @param  position:     Initial position (degrees).
+ * @param  limit_max:    Servo's maximum limit (degrees).
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, LOOP_TYPE_t type, const PLANT_CONFIG_t *plant_config, float position,
+                      float limit_max)
+{
+    const PID_CONFIG_t config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+
+    memset(loop, 0, sizeof(*loop));
+    loop->type = type;
+    pid_init(&loop->pid, &config);
+    plant_init(&loop->plant, plant_config, position);
+    mpc_state_reset(&loop->mpc_state, loop->plant.feedback);
+    loop->mpc_command = position;
+    loop->limits = (MPC_LIMITS_t){
+        .u_min = 0.0f,
+        .u_max = limit_max,
+        .du_max = MPC_SLEW_DEG_S / FRAME_RATE_HZ,
+        .y_min = 0.0f,
+        .y_max = limit_max,
+    };
+    loop->latched = loop->plant.command;
+}
+
+/**
+ * @brief  Run one loop iteration as the firmware: the setpoint plus the PID
+ *         correction, or the MPC's command (solved in the servo's loop of the
+ *         frame and held), limited to the servo's limits and the slew limit
+ *         about the latched command. The MPC's inputs are checked against its
+ *         constraints before the limiting.
+ * @param  loop:     Loop.
+ * @param  setpoint: Setpoint (degrees).
+ * @retval None.
+ */
+static void loop_step(LOOP_t *loop, float setpoint)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    float command_min = fmaxf(loop->limits.u_min, loop->latched - slew_step);
+    float command_max = fminf(loop->limits.u_max, loop->latched + slew_step);
+    float command;
+
+    if (loop->type == LOOP_TYPE__MPC)
+    {
+        if (loop->plant.loop == MPC_SOLVE_LOOP)
+        {
+            uint32_t iterations;
+            float u_prev = loop->mpc_command;
+
+            mpc_observe(&_mpc, &loop->mpc_state, loop->mpc_command, loop->plant.feedback);
+            loop->mpc_command = mpc_step(&_mpc, &loop->mpc_state, setpoint, u_prev, &loop->limits, &iterations);
+            loop->solves++;
+            loop->constrained += (iterations > 0);
+            loop->iterations_max = (iterations > loop->iterations_max) ? iterations : loop->iterations_max;
+            loop->u_excess = fmaxf(loop->u_excess, fmaxf(loop->mpc_command - loop->limits.u_max,
+                                                         loop->limits.u_min - loop->mpc_command));
+            loop->du_excess = fmaxf(loop->du_excess, fabsf(loop->mpc_command - u_prev) - loop->limits.du_max);
+        }
+        command = loop->mpc_command;
+    }
+    else
+    {
+        pid_set_actuator_limits(&loop->pid, command_min - setpoint, command_max - setpoint);
+        command = setpoint + pid_update(&loop->pid, setpoint, loop->plant.feedback);
+    }
+    command = fmaxf(command_min, fminf(command_max, command));
+
+    if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+    {
+        loop->latched = command;
+    }
+    plant_step(&loop->plant, command);
+}
+
+/**
+ * @brief  Step 90 -> 130 degrees with feedback noise, and with a 3 degree
+ *         load: the MPC settles within 0.5 degrees without a steady-state
+ *         error (the observed disturbance), with less tracking error than
+ *         the PID.
+ * @retval None.
+ */
+static void test_step(void)
+{
+    const float loads[] = {0.0f, 3.0f};
+    const char *const names[] = {"PID", "MPC"};
+
+    for (uint32_t l = 0; l < TEST_NUM_ELS(loads); l++)
+    {
+        float rms[2];
+
+        for (uint32_t t = LOOP_TYPE__PID; t <= LOOP_TYPE__MPC; t++)
+        {
+            PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+            LOOP_t loop;
+            float peak = 0.0f;
+            float settled_s = -1.0f;
+            float late_error = 0.0f;
+            double sum = 0.0;
+            uint32_t k;
+
+            config.load_deg = loads[l];
+            config.noise_deg = 0.1f;
+            test_rand_seed(1);
+            loop_init(&loop, (LOOP_TYPE_t)t, &config, 90.0f, ANGLE_MAX);
+            for (k = 0; k < (uint32_t)(3.0f * LOOP_RATE_HZ); k++)
+            {
+                loop_step(&loop, 130.0f);
+                float error = loop.plant.position - 130.0f;
+                peak = fmaxf(peak, loop.plant.position);
+                sum += (double)(error * error);
+                if (fabsf(error) > 0.5f)
+                {
+                    settled_s = -1.0f;
+                }
+                else if (settled_s < 0.0f)
+                {
+                    settled_s = (float)k / LOOP_RATE_HZ;
+                }
+                if (k >= (uint32_t)(2.5f * LOOP_RATE_HZ))
+                {
+                    late_error = fmaxf(late_error, fabsf(error));
+                }
+            }
+            rms[t] = (float)sqrt(sum / k);
+            printf("%s, %.0f deg load: step 90 -> 130 peak %.2f deg, settled %.3f s, error rms %.2f deg, "
+                   "%.3f deg after 2.5 s\n",
+                   names[t], (double)loads[l], (double)peak, (double)settled_s, (double)rms[t],
+                   (double)late_error);
+            if (t == LOOP_TYPE__MPC)
+            {
+                TEST_CHECK((settled_s >= 0.0f) && (settled_s < 1.0f), "MPC settled %.3f s", (double)settled_s);
+                TEST_CHECK(peak < 135.0f, "MPC step peak %.2f deg", (double)peak);
+                TEST_CHECK(late_error < 0.5f, "MPC error %.3f deg after 2.5 s", (double)late_error);
+            }
+        }
+        TEST_CHECK(rms[LOOP_TYPE__MPC] < rms[LOOP_TYPE__PID], "%.0f deg load: MPC error rms %.2f deg, PID %.2f deg",
+                   (double)loads[l], (double)rms[LOOP_TYPE__MPC], (double)rms[LOOP_TYPE__PID]);
+    }
+}
+
+/**
+ * @brief  Steps 90 -> 178 degrees to a servo limited to 170 degrees, by the
+ *         command (the firmware's constraints: input and position) and by
+ *         the position alone (the command's range the full 180 degrees): the
+ *         inputs are within the input constraints, the moves within the move
+ *         constraint and the position within the position constraint.
+ * @retval None.
+ */
+static void test_saturating(void)
+{
+    const float limit = 170.0f;
+    const float u_max[] = {limit, ANGLE_MAX};
+    const char *const names[] = {"command", "position"};
+
+    for (uint32_t c = 0; c < TEST_NUM_ELS(u_max); c++)
+    {
+        const PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+        LOOP_t loop;
+        float peak = 0.0f;
+
+        loop_init(&loop, LOOP_TYPE__MPC, &config, 90.0f, limit);
+        loop.limits.u_max = u_max[c];
+        for (uint32_t k = 0; k < (uint32_t)(2.0f * LOOP_RATE_HZ); k++)
+        {
+            loop_step(&loop, 178.0f);
+            peak = fmaxf(peak, loop.plant.position);
+        }
+        printf("saturating, %s limited to %.0f deg: peak %.2f deg, %lu/%lu solves constrained, iterations max %lu, "
+               "input excess %.4f deg, move excess %.4f deg\n",
+               names[c], (double)limit, (double)peak, (unsigned long)loop.constrained, (unsigned long)loop.solves,
+               (unsigned long)loop.iterations_max, (double)loop.u_excess, (double)loop.du_excess);
+        TEST_CHECK(loop.constrained > 0, "%s limited: no constrained solve", names[c]);
+        TEST_CHECK(loop.iterations_max <= MPC_MAX_ITERATIONS, "%s limited: iterations %lu", names[c],
+                   (unsigned long)loop.iterations_max);
+        TEST_CHECK(loop.u_excess <= 0.0f, "%s limited: input %.4f deg beyond its constraints", names[c],
+                   (double)loop.u_excess);
+        TEST_CHECK(loop.du_excess <= MOVE_TOLERANCE, "%s limited: move %.4f deg beyond its constraint", names[c],
+                   (double)loop.du_excess);
+        TEST_CHECK(peak <= (limit + POSITION_TOLERANCE), "%s limited: position %.2f deg beyond %.0f deg", names[c],
+                   (double)peak, (double)limit);
+    }
+}
+
+/**
+ * @brief  Steps 30 -> 150 -> 30 degrees (many times the move constraint):
+ *         the MPC's moves are within the move constraint (the servo's speed
+ *         limit), with the iterations bounded, and the servo settles.
+ * @retval None.
+ */
+static void test_slew(void)
+{
+    const PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    LOOP_t loop;
+    float peak = 0.0f;
+    float late_error = 0.0f;
+
+    loop_init(&loop, LOOP_TYPE__MPC, &config, 30.0f, ANGLE_MAX);
+    for (uint32_t k = 0; k < (uint32_t)(4.0f * LOOP_RATE_HZ); k++)
+    {
+        float setpoint = (k < (uint32_t)(2.0f * LOOP_RATE_HZ)) ? 150.0f : 30.0f;
+        loop_step(&loop, setpoint);
+        if (k < (uint32_t)(2.0f * LOOP_RATE_HZ))
+        {
+            peak = fmaxf(peak, loop.plant.position);
+        }
+        if ((k % (uint32_t)(2.0f * LOOP_RATE_HZ)) >= (uint32_t)(1.5f * LOOP_RATE_HZ))
+        {
+            late_error = fmaxf(late_error, fabsf(loop.plant.position - setpoint));
+        }
+    }
+    printf("slew-limited, 120 deg steps: %lu/%lu solves constrained, iterations max %lu, move excess %.4f deg, "
+           "peak %.2f deg, error %.3f deg after 1.5 s\n",
+           (unsigned long)loop.constrained, (unsigned long)loop.solves, (unsigned long)loop.iterations_max,
+           (double)loop.du_excess, (double)peak, (double)late_error);
+    TEST_CHECK(loop.constrained > 0, "no constrained solve");
+    TEST_CHECK(loop.iterations_max <= MPC_MAX_ITERATIONS, "iterations %lu", (unsigned long)loop.iterations_max);
+    TEST_CHECK(loop.du_excess <= MOVE_TOLERANCE, "move %.4f deg beyond its constraint", (double)loop.du_excess);
+    TEST_CHECK(peak < 152.0f, "slew-limited step peak %.2f deg", (double)peak);
+    TEST_CHECK(late_error < 0.5f, "slew-limited step error %.3f deg after 1.5 s", (double)late_error);
+}
+
+/**
+ * @brief  Benchmark: host cycles per PWM frame for one servo, the PID's
+ *         updates (one per loop iteration) against the MPC's observer and
+ *         solve: unconstrained, constrained (a few iterations) and at the
+ *         iteration bound (infeasible position constraint).
+ * @retval None.
+ */
+static void bench_frame(void)
+{
+    const PID_CONFIG_t pid_config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const MPC_LIMITS_t limits = {.u_min = 0.0f, .u_max = ANGLE_MAX, .du_max = MPC_SLEW_DEG_S / FRAME_RATE_HZ,
+                                 .y_min = 0.0f, .y_max = ANGLE_MAX};
+    const MPC_LIMITS_t limits_tight = {.u_min = 0.0f, .u_max = ANGLE_MAX, .du_max = MPC_SLEW_DEG_S / FRAME_RATE_HZ,
+                                       .y_min = 0.0f, .y_max = 171.0f};
+    const MPC_LIMITS_t limits_infeasible = {.u_min = 0.0f, .u_max = ANGLE_MAX,
+                                            .du_max = MPC_SLEW_DEG_S / FRAME_RATE_HZ, .y_min = 100.0f,
+                                            .y_max = 101.0f};
+    const uint32_t loops_per_frame = (uint32_t)(LOOP_RATE_HZ / FRAME_RATE_HZ);
+    volatile float sink = 0.0f;
+    uint32_t iterations[3] = {0};
+    uint64_t cycles[4];
+    PID_t pid;
+    MPC_STATE_t state;
+
+    pid_init(&pid, &pid_config);
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < (BENCH_FRAMES * loops_per_frame); k++)
+    {
+        sink = pid_update(&pid, 120.0f, 90.0f + (float)(k & 7U));
+    }
+    cycles[0] = test_cycles() - start;
+
+    mpc_state_reset(&state, 90.0f);
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_FRAMES; k++)
+    {
+        mpc_observe(&_mpc, &state, 120.0f, 120.0f + (float)(k & 7U));
+        sink = mpc_step(&_mpc, &state, 120.0f, 120.0f, &limits, &iterations[0]);
+    }
+    cycles[1] = test_cycles() - start;
+
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_FRAMES; k++)
+    {
+        state.x[0] = 160.0f + (float)(k & 3U);
+        state.x[1] = 300.0f;
+        state.disturbance = 0.0f;
+        mpc_observe(&_mpc, &state, 160.0f, state.x[0]);
+        sink = mpc_step(&_mpc, &state, 175.0f, 160.0f, &limits_tight, &iterations[1]);
+    }
+    cycles[2] = test_cycles() - start;
+
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_FRAMES; k++)
+    {
+        state.x[0] = 150.0f;
+        state.x[1] = -400.0f;
+        state.disturbance = 0.0f;
+        mpc_observe(&_mpc, &state, 160.0f, state.x[0]);
+        sink = mpc_step(&_mpc, &state, 175.0f, 160.0f, &limits_infeasible, &iterations[2]);
+    }
+    cycles[3] = test_cycles() - start;
+    (void)sink;
+
+    printf("bench: host cycles per frame, one servo: PID %.1f (%lu updates), MPC %.1f unconstrained, "
+           "%.1f constrained (%lu iterations), %.1f at the iteration bound (%lu iterations)\n",
+           (double)cycles[0] / BENCH_FRAMES, (unsigned long)loops_per_frame, (double)cycles[1] / BENCH_FRAMES,
+           (double)cycles[2] / BENCH_FRAMES, (unsigned long)iterations[1], (double)cycles[3] / BENCH_FRAMES,
+           (unsigned long)iterations[2]);
+    TEST_CHECK(iterations[0] == 0, "unconstrained benchmark constrained");
+    TEST_CHECK(iterations[2] == MPC_MAX_ITERATIONS, "iteration bound benchmark ran %lu iterations",
+               (unsigned long)iterations[2]);
+}
+
+/*============================================================================*/
\ No newline at end of file
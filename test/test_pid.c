@@ -0,0 +1,380 @@
+/*******************************************************************************
+ * @file   test_pid.c
+ * @brief  PID position controller host test: the firmware's PID loop (see
+ *         servo_ctrl_loop_run) closed around the plant model at 1 kHz.
+ *             - Step response: settling and overshoot.
+ *             - Load: the servo's own loop settles short of its command; the
+ *               controller removes the error.
+ *             - Anti-windup: a setpoint beyond the servo's reach saturates
+ *               the command without winding up the integrator.
+ *             - Recovery: stepping back from a saturated command settles as
+ *               fast as the same step from rest (recovery time).
+ *             - Slew limit: the latched command moves no more than the slew
+ *               limit per frame period.
+ *             - Ramp tracking error and cycles per update (benchmark).
+ ******************************************************************************/
+
+#include "pid.h"
+#include "plant.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000.0f
+#define PID_KP                  0.5f
+#define PID_KI                  5.0f
+#define PID_OUTPUT_MAX          30.0f
+#define SLEW_DEG_S              600.0f
+#define FRAME_RATE_HZ           50.0f
+#define ANGLE_MAX               180.0f
+
+#define SETTLE_DEG              0.5f
+
+#define BENCH_UPDATES           1000000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct LOOP_t {
+    PID_t pid;
+    PLANT_t plant;
+    float latched;              /* Command latched at the last frame boundary (slew limit). */
+} LOOP_t;
+
+/*===== Private Function Prototypes ==========================================*/
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config, float position);
+static float loop_step(LOOP_t *loop, float setpoint);
+static void test_step(void);
+static void test_load(void);
+static void test_windup(void);
+static void test_recovery(void);
+static void test_slew(void);
+static void test_ramp(void);
+static void bench_update(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_step();
+    test_load();
+    test_windup();
+    test_recovery();
+    test_slew();
+    test_ramp();
+    bench_update();
+    return test_result("test_pid");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Initialise a loop at rest.
+ * @param  loop:         Loop.
+ * @param  plant_config: Plant configuration.
+ * @param  position:     Initial position (degrees).
+ * @retval None.
+ */
+static void loop_init(LOOP_t *loop, const PLANT_CONFIG_t *plant_config, float position)
+{
+    const PID_CONFIG_t config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+
+    pid_init(&loop->pid, &config);
+    plant_init(&loop->plant, plant_config, position);
+    loop->latched = loop->plant.command;
+}
+
+/**
+ * @brief  Run one loop iteration as the firmware: the command is the setpoint
+ *         plus the PID correction, limited to the servo's range and the slew
+ *         limit about the latched command.
+ * @param  loop:     Loop.
+ * @param  setpoint: Setpoint (degrees).
+ * @retval Command (degrees).
+ */
+static float loop_step(LOOP_t *loop, float setpoint)
+{
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    float command_min = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched - slew_step));
+    float command_max = fmaxf(0.0f, fminf(ANGLE_MAX, loop->latched + slew_step));
+
+    pid_set_actuator_limits(&loop->pid, command_min - setpoint, command_max - setpoint);
+    float command = setpoint + pid_update(&loop->pid, setpoint, loop->plant.feedback);
+    command = fmaxf(command_min, fminf(command_max, command));
+
+    if (loop->plant.loop == (loop->plant.config.loops_per_frame - 1))
+    {
+        loop->latched = command;
+    }
+    plant_step(&loop->plant, command);
+    return command;
+}
+
+/**
+ * @brief  Step 90 -> 130 degrees: settled within 0.5 degrees in 1.5 s, with
+ *         limited overshoot.
+ * @retval None.
+ */
+static void test_step(void)
+{
+    const PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    LOOP_t loop;
+    float peak = 0.0f;
+    float settled_s = -1.0f;
+
+    loop_init(&loop, &config, 90.0f);
+    for (uint32_t k = 0; k < (uint32_t)(3.0f * LOOP_RATE_HZ); k++)
+    {
+        loop_step(&loop, 130.0f);
+        peak = fmaxf(peak, loop.plant.position);
+        if (fabsf(loop.plant.position - 130.0f) > 0.5f)
+        {
+            settled_s = -1.0f;
+        }
+        else if (settled_s < 0.0f)
+        {
+            settled_s = (float)k / LOOP_RATE_HZ;
+        }
+    }
+    printf("step 90 -> 130: peak %.2f deg, settled (0.5 deg) in %.3f s\n", (double)peak, (double)settled_s);
+    TEST_CHECK((settled_s >= 0.0f) && (settled_s < 1.5f), "step settled in %.3f s", (double)settled_s);
+    TEST_CHECK(peak < 140.0f, "step overshoot to %.2f deg", (double)peak);
+}
+
+/**
+ * @brief  A 3 degree load: the open-loop error is the load, the closed-loop
+ *         error is removed by the integrator.
+ * @retval None.
+ */
+static void test_load(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.load_deg = 3.0f;
+    PLANT_t open;
+    LOOP_t loop;
+    float open_error = 0.0f;
+    float closed_error = 0.0f;
+
+    plant_init(&open, &config, 90.0f);
+    loop_init(&loop, &config, 90.0f);
+    for (uint32_t k = 0; k < (uint32_t)(4.0f * LOOP_RATE_HZ); k++)
+    {
+        plant_step(&open, 100.0f);
+        loop_step(&loop, 100.0f);
+        if (k >= (uint32_t)(3.0f * LOOP_RATE_HZ))
+        {
+            open_error = fmaxf(open_error, fabsf(100.0f - open.position));
+            closed_error = fmaxf(closed_error, fabsf(100.0f - loop.plant.position));
+        }
+    }
+    printf("3 deg load: steady-state error open loop %.3f deg, closed loop %.3f deg\n", (double)open_error,
+           (double)closed_error);
+    TEST_CHECK(fabsf(open_error - 3.0f) < 0.05f, "open-loop error %.3f deg", (double)open_error);
+    TEST_CHECK(closed_error < 0.05f, "closed-loop error %.3f deg", (double)closed_error);
+}
+
+/**
+ * @brief  Setpoint 178 degrees with a 5 degree load (the servo reaches 175 at
+ *         the 180 degree command) for 2 s, then 120: the command saturates,
+ *         and the step down overshoots no more than a step from rest does.
+ * @retval None.
+ */
+static void test_windup(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.load_deg = 5.0f;
+    LOOP_t loop;
+    LOOP_t reference;
+    bool saturated = false;
+    float command_max = 0.0f;
+    float low = ANGLE_MAX;
+    float reference_low = ANGLE_MAX;
+
+    loop_init(&loop, &config, 170.0f);
+    for (uint32_t k = 0; k < (uint32_t)(2.0f * LOOP_RATE_HZ); k++)
+    {
+        command_max = fmaxf(command_max, loop_step(&loop, 178.0f));
+        saturated |= pid_is_saturated(&loop.pid);
+    }
+
+    /* The same step from rest at the saturated position. */
+    loop_init(&reference, &config, loop.plant.position);
+    for (uint32_t k = 0; k < (uint32_t)(2.0f * LOOP_RATE_HZ); k++)
+    {
+        loop_step(&loop, 120.0f);
+        loop_step(&reference, 120.0f);
+        low = fminf(low, loop.plant.position);
+        reference_low = fminf(reference_low, reference.plant.position);
+    }
+    printf("windup: command max %.2f deg, step to 120 undershoots to %.2f deg (from rest %.2f deg)\n",
+           (double)command_max, (double)low, (double)reference_low);
+    TEST_CHECK(saturated, "command not saturated");
+    TEST_CHECK(command_max <= ANGLE_MAX, "command %.2f deg beyond the servo's range", (double)command_max);
+    TEST_CHECK(low > (reference_low - 1.0f), "undershoot to %.2f deg, from rest %.2f deg", (double)low,
+               (double)reference_low);
+}
+
+/**
+ * @brief  Setpoint 178 degrees with a 5 degree load for 2 s (the command
+ *         saturated at 180), then back to 170: the back-calculation releases
+ *         the command within a frame, and the step settles within 0.5 degrees
+ *         no more than a frame later than the same step from rest.
+ * @retval None.
+ */
+static void test_recovery(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.load_deg = 5.0f;
+    LOOP_t loop;
+    LOOP_t reference;
+    float released_s = -1.0f;
+    float settled_s = -1.0f;
+    float reference_settled_s = -1.0f;
+
+    loop_init(&loop, &config, 170.0f);
+    for (uint32_t k = 0; k < (uint32_t)(2.0f * LOOP_RATE_HZ); k++)
+    {
+        loop_step(&loop, 178.0f);
+    }
+
+    loop_init(&reference, &config, loop.plant.position);
+    for (uint32_t k = 0; k < (uint32_t)(3.0f * LOOP_RATE_HZ); k++)
+    {
+        const float t_s = (float)k / LOOP_RATE_HZ;
+        const float command = loop_step(&loop, 170.0f);
+        loop_step(&reference, 170.0f);
+        if ((released_s < 0.0f) && (command < ANGLE_MAX))
+        {
+            released_s = t_s;
+        }
+        if (fabsf(loop.plant.position - 170.0f) > SETTLE_DEG)
+        {
+            settled_s = -1.0f;
+        }
+        else if (settled_s < 0.0f)
+        {
+            settled_s = t_s;
+        }
+        if (fabsf(reference.plant.position - 170.0f) > SETTLE_DEG)
+        {
+            reference_settled_s = -1.0f;
+        }
+        else if (reference_settled_s < 0.0f)
+        {
+            reference_settled_s = t_s;
+        }
+    }
+    printf("recovery 180 (saturated) -> 170: released in %.3f s, settled in %.3f s (from rest %.3f s)\n",
+           (double)released_s, (double)settled_s, (double)reference_settled_s);
+    TEST_CHECK((released_s >= 0.0f) && (released_s < (1.0f / FRAME_RATE_HZ)), "command released in %.3f s",
+               (double)released_s);
+    TEST_CHECK((settled_s >= 0.0f) && (reference_settled_s >= 0.0f) &&
+                   (settled_s <= (reference_settled_s + (1.0f / FRAME_RATE_HZ))),
+               "recovery settled in %.3f s, from rest %.3f s", (double)settled_s, (double)reference_settled_s);
+}
+
+/**
+ * @brief  Steps 30 -> 150 -> 30 degrees with a 3 degree load and feedback
+ *         noise: the latched command moves by no more than the slew limit per
+ *         frame period (and reaches it), and every command lies within the
+ *         slew limit of the last latched command.
+ * @retval None.
+ */
+static void test_slew(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.load_deg = 3.0f;
+    config.noise_deg = 0.3f;
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    const float tolerance = 1e-4f * ANGLE_MAX;
+    LOOP_t loop;
+    float delta_max = 0.0f;
+    float excess_max = 0.0f;
+
+    test_rand_seed(1);
+    loop_init(&loop, &config, 30.0f);
+    for (uint32_t k = 0; k < (uint32_t)(4.0f * LOOP_RATE_HZ); k++)
+    {
+        const float setpoint = (k < (uint32_t)(2.0f * LOOP_RATE_HZ)) ? 150.0f : 30.0f;
+        const float latched = loop.latched;
+        const float command = loop_step(&loop, setpoint);
+        excess_max = fmaxf(excess_max, fabsf(command - latched) - slew_step);
+        delta_max = fmaxf(delta_max, fabsf(loop.latched - latched));
+    }
+    printf("slew limit %.1f deg/frame: latched command delta max %.3f deg, excess %.2e deg\n", (double)slew_step,
+           (double)delta_max, (double)fmaxf(excess_max, 0.0f));
+    TEST_CHECK(excess_max <= tolerance, "command %.3f deg beyond the slew limit", (double)excess_max);
+    TEST_CHECK(fabsf(delta_max - slew_step) <= tolerance, "latched command delta max %.3f deg", (double)delta_max);
+}
+
+/**
+ * @brief  Ramp 30 -> 150 degrees at 60 degrees/s with feedback noise: the
+ *         tracking error whilst moving is bounded.
+ * @retval None.
+ */
+static void test_ramp(void)
+{
+    PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    config.noise_deg = 0.3f;
+    LOOP_t loop;
+    double sum_sq = 0.0;
+    float error_max = 0.0f;
+    uint32_t samples = 0;
+
+    test_rand_seed(1);
+    loop_init(&loop, &config, 30.0f);
+    for (uint32_t k = 0; k < (uint32_t)(2.0f * LOOP_RATE_HZ); k++)
+    {
+        float setpoint = 30.0f + (60.0f * (float)k / LOOP_RATE_HZ);
+        loop_step(&loop, setpoint);
+        if (k >= (uint32_t)(0.5f * LOOP_RATE_HZ))
+        {
+            float error = setpoint - loop.plant.position;
+            sum_sq += (double)(error * error);
+            error_max = fmaxf(error_max, fabsf(error));
+            samples++;
+        }
+    }
+    float rms = (float)sqrt(sum_sq / samples);
+    printf("ramp 60 deg/s: tracking error rms %.2f deg, max %.2f deg\n", (double)rms, (double)error_max);
+    TEST_CHECK(rms < 1.0f, "ramp tracking error rms %.2f deg", (double)rms);
+    TEST_CHECK(error_max < 2.5f, "ramp tracking error max %.2f deg", (double)error_max);
+}
+
+/**
+ * @brief  Benchmark: host cycles per pid_update.
+ * @retval None.
+ */
+static void bench_update(void)
+{
+    const PLANT_CONFIG_t config = PLANT_CONFIG_DEFAULT;
+    LOOP_t loop;
+    volatile float sink = 0.0f;
+
+    loop_init(&loop, &config, 90.0f);
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_UPDATES; k++)
+    {
+        sink = pid_update(&loop.pid, 90.0f + (float)(k & 7), 90.0f);
+    }
+    uint64_t cycles = test_cycles() - start;
+    (void)sink;
+    printf("bench: pid_update %.1f host cycles\n", (double)cycles / BENCH_UPDATES);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,284 @@
+/*******************************************************************************
+ * @file   test_profile.c
+ * @brief  Motion profile generator host test, at the 1 kHz control loop rate.
+ *             - Trapezoidal and S-curve moves: end exactly at the target,
+ *               monotonic, within the velocity/acceleration (and jerk)
+ *               limits, and the reported velocity the position's rate
+ *               (within half a tick's acceleration).
+ *             - Blending: a blended move starts whilst the previous one
+ *               decelerates and the sequence ends sooner, at its target.
+ *             - Timed moves: moves of different distances built to one
+ *               timing finish on the same tick.
+ *             - Cycles per tick, i.e. the Horner evaluation of the segment
+ *               cubics in fixed-point, against evaluating the same cubics
+ *               in powers of the tick in double precision (benchmark).
+ ******************************************************************************/
+
+#include "profile.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define RATE_HZ                 1000
+#define VELOCITY_MAX            180.0f
+#define ACCELERATION_MAX        1000.0f
+#define JERK_MAX                20000.0f
+
+#define Q16(deg)                ((int32_t)((deg) * 65536.0f))
+#define Q16_TO_DEG(q16)         ((float)(q16) / 65536.0f)
+#define MAX_TICKS               10000
+#define BENCH_MOVES             2000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct RUN_RESULT_t {
+    uint32_t ticks;             /* Ticks until idle. */
+    int32_t end;                /* Final position (Q16.16). */
+    bool monotonic;
+    float velocity_max;         /* Reported (degrees/s). */
+    float acceleration_max;     /* Reported (degrees/s^2). */
+    float jerk_max;             /* Of the reported acceleration (degrees/s^3). */
+    float rate_error_max;       /* Reported velocity against the position's rate (degrees/s). */
+} RUN_RESULT_t;
+
+static const PROFILE_LIMITS_t _limits = {
+    .velocity = VELOCITY_MAX,
+    .acceleration = ACCELERATION_MAX,
+    .jerk = JERK_MAX,
+};
+
+/*===== Private Function Prototypes ==========================================*/
+static RUN_RESULT_t run(PROFILE_GEN_t *gen, int32_t start);
+static void test_move(PROFILE_TYPE_t type, const char *name);
+static void test_blend(void);
+static void test_timed(void);
+static void bench_next(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_move(PROFILE_TYPE__TRAPEZOIDAL, "trapezoidal");
+    test_move(PROFILE_TYPE__S_CURVE, "S-curve");
+    test_blend();
+    test_timed();
+    bench_next();
+    return test_result("test_profile");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Run a generator's committed moves to completion.
+ * @param  gen:   Generator.
+ * @param  start: Position before the first move (Q16.16).
+ * @retval Result.
+ */
+static RUN_RESULT_t run(PROFILE_GEN_t *gen, int32_t start)
+{
+    RUN_RESULT_t result = {.end = start, .monotonic = true};
+    int32_t direction = 0;
+    float acceleration_prev = 0.0f;
+
+    while (profile_is_busy(gen) && (result.ticks < MAX_TICKS))
+    {
+        int32_t position = profile_next(gen);
+        float velocity = profile_get_velocity(gen);
+        float acceleration = profile_get_acceleration(gen);
+        float rate = Q16_TO_DEG(position - result.end) * RATE_HZ;
+
+        if ((position != result.end) && (direction == 0))
+        {
+            direction = (position > result.end) ? 1 : -1;
+        }
+        result.monotonic &= ((position - result.end) * direction >= 0);
+        result.velocity_max = fmaxf(result.velocity_max, fabsf(velocity));
+        result.acceleration_max = fmaxf(result.acceleration_max, fabsf(acceleration));
+        result.jerk_max = fmaxf(result.jerk_max, fabsf(acceleration - acceleration_prev) * RATE_HZ);
+        /* The position's rate over the tick lags the velocity at its end by up to half a tick's acceleration. */
+        result.rate_error_max = fmaxf(result.rate_error_max, fabsf(rate - velocity));
+        acceleration_prev = acceleration;
+        result.end = position;
+        result.ticks++;
+    }
+    return result;
+}
+
+/**
+ * @brief  Moves of several distances, both directions: the target reached
+ *         exactly, monotonic and within the limits.
+ * @param  type: Profile type.
+ * @param  name: Profile type name.
+ * @retval None.
+ */
+static void test_move(PROFILE_TYPE_t type, const char *name)
+{
+    const float distances[] = {0.01f, 0.5f, 5.0f, 30.0f, -60.0f, 170.0f};
+    PROFILE_GEN_t gen;
+    float velocity_max = 0.0f;
+    float acceleration_max = 0.0f;
+    float jerk_max = 0.0f;
+    float rate_error_max = 0.0f;
+
+    for (uint32_t k = 0; k < TEST_NUM_ELS(distances); k++)
+    {
+        int32_t start = (distances[k] < 0.0f) ? Q16(170.0f) : Q16(5.0f);
+        int32_t target = start + Q16(distances[k]);
+
+        profile_init(&gen, RATE_HZ, start);
+        TEST_CHECK(profile_plan(&gen, type, target, &_limits, false), "%s %.2f deg not planned", name,
+                   (double)distances[k]);
+        profile_commit(&gen);
+        RUN_RESULT_t result = run(&gen, start);
+
+        TEST_CHECK(result.end == target, "%s %.2f deg ended %ld counts from the target", name, (double)distances[k],
+                   (long)(result.end - target));
+        TEST_CHECK(result.monotonic, "%s %.2f deg not monotonic", name, (double)distances[k]);
+        TEST_CHECK(profile_get_velocity(&gen) == 0.0f, "%s %.2f deg not at rest", name, (double)distances[k]);
+        velocity_max = fmaxf(velocity_max, result.velocity_max);
+        acceleration_max = fmaxf(acceleration_max, result.acceleration_max);
+        jerk_max = fmaxf(jerk_max, result.jerk_max);
+        rate_error_max = fmaxf(rate_error_max, result.rate_error_max);
+    }
+
+    printf("%s: velocity max %.1f deg/s, acceleration max %.1f deg/s^2, jerk max %.0f deg/s^3, "
+           "velocity against position rate %.3f deg/s\n",
+           name, (double)velocity_max, (double)acceleration_max, (double)jerk_max, (double)rate_error_max);
+    TEST_CHECK(velocity_max <= (VELOCITY_MAX * 1.001f), "%s velocity %.2f deg/s", name, (double)velocity_max);
+    TEST_CHECK(acceleration_max <= (ACCELERATION_MAX * 1.001f), "%s acceleration %.2f deg/s^2", name,
+               (double)acceleration_max);
+    if (type == PROFILE_TYPE__S_CURVE)
+    {
+        TEST_CHECK(jerk_max <= (JERK_MAX * 1.01f), "%s jerk %.0f deg/s^3", name, (double)jerk_max);
+    }
+    TEST_CHECK(rate_error_max < ((ACCELERATION_MAX / (2.0f * RATE_HZ)) + 0.05f),
+               "%s velocity against position rate %.3f deg/s", name, (double)rate_error_max);
+}
+
+/**
+ * @brief  Three 30 degree moves, blended against queued back to back.
+ * @retval None.
+ */
+static void test_blend(void)
+{
+    PROFILE_GEN_t blended;
+    PROFILE_GEN_t queued;
+    int32_t start = Q16(30.0f);
+
+    profile_init(&blended, RATE_HZ, start);
+    profile_init(&queued, RATE_HZ, start);
+    for (uint32_t k = 1; k <= 3; k++)
+    {
+        TEST_CHECK(profile_plan(&blended, PROFILE_TYPE__S_CURVE, start + Q16(30.0f * k), &_limits, true),
+                   "blended move %lu not planned", (unsigned long)k);
+        profile_commit(&blended);
+        TEST_CHECK(profile_plan(&queued, PROFILE_TYPE__S_CURVE, start + Q16(30.0f * k), &_limits, false),
+                   "queued move %lu not planned", (unsigned long)k);
+        profile_commit(&queued);
+    }
+    RUN_RESULT_t blended_result = run(&blended, start);
+    RUN_RESULT_t queued_result = run(&queued, start);
+
+    printf("blend: 3 x 30 deg in %lu ticks blended, %lu queued\n", (unsigned long)blended_result.ticks,
+           (unsigned long)queued_result.ticks);
+    TEST_CHECK(blended_result.end == (start + Q16(90.0f)), "blended sequence ended %ld counts from the target",
+               (long)(blended_result.end - (start + Q16(90.0f))));
+    TEST_CHECK(blended_result.monotonic, "blended sequence not monotonic");
+    TEST_CHECK(blended_result.ticks < queued_result.ticks, "blending did not shorten the sequence");
+    TEST_CHECK(profile_get_moves_started(&blended) == 3, "%lu blended moves started",
+               (unsigned long)profile_get_moves_started(&blended));
+}
+
+/**
+ * @brief  A timing planned for the longest of three moves: all three (one of
+ *         zero distance) finish on its last tick at their targets.
+ * @retval None.
+ */
+static void test_timed(void)
+{
+    const float distances[] = {80.0f, -25.0f, 0.0f};
+    PROFILE_TIMING_t timing;
+    uint32_t mismatches = 0;
+
+    TEST_CHECK(profile_plan_timing(PROFILE_TYPE__S_CURVE, 80.0f, &_limits, RATE_HZ, &timing), "timing not planned");
+    for (uint32_t k = 0; k < TEST_NUM_ELS(distances); k++)
+    {
+        PROFILE_GEN_t gen;
+        int32_t start = Q16(90.0f);
+
+        profile_init(&gen, RATE_HZ, start);
+        TEST_CHECK(profile_plan_timed(&gen, start + Q16(distances[k]), &timing, false), "timed move not planned");
+        profile_commit(&gen);
+        RUN_RESULT_t result = run(&gen, start);
+        mismatches += (result.ticks != profile_timing_get_ticks(&timing)) || (result.end != (start + Q16(distances[k])));
+        TEST_CHECK(result.velocity_max <= (VELOCITY_MAX * 1.001f), "timed %.0f deg velocity %.2f deg/s",
+                   (double)distances[k], (double)result.velocity_max);
+    }
+    printf("timed: %lu ticks\n", (unsigned long)profile_timing_get_ticks(&timing));
+    TEST_CHECK(mismatches == 0, "%lu timed moves off their timing/target", (unsigned long)mismatches);
+}
+
+/**
+ * @brief  Benchmark: host cycles per profile_next over S-curve moves, and per
+ *         tick evaluating the same segments' cubics as
+ *         p0 + c1*t + c2*t^2 + c3*t^3 in double precision.
+ * @retval None.
+ */
+static void bench_next(void)
+{
+    PROFILE_GEN_t gen;
+    uint64_t ticks = 0;
+    uint64_t cycles = 0;
+    volatile int32_t sink = 0;
+    volatile double sink_double = 0.0;
+
+    profile_init(&gen, RATE_HZ, Q16(10.0f));
+    for (uint32_t k = 0; k < BENCH_MOVES; k++)
+    {
+        profile_plan(&gen, PROFILE_TYPE__S_CURVE, ((k % 2) == 0) ? Q16(170.0f) : Q16(10.0f), &_limits, false);
+        profile_commit(&gen);
+        uint64_t start = test_cycles();
+        while (profile_is_busy(&gen))
+        {
+            sink = profile_next(&gen);
+            ticks++;
+        }
+        cycles += test_cycles() - start;
+    }
+
+    /* The last move's segments (Q24.40) in powers of the tick. */
+    const PROFILE_MOVE_t *move = &gen.queue[(gen.tail + PROFILE_QUEUE_LEN - 1) % PROFILE_QUEUE_LEN];
+    const double one = ldexp(1.0, PROFILE_FRAC_BITS);
+    uint64_t power_ticks = 0;
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_MOVES; k++)
+    {
+        for (uint32_t s = 0; s < move->num_segments; s++)
+        {
+            const PROFILE_SEGMENT_t *seg = &move->segment[s];
+            for (uint32_t t = 1; t <= seg->ticks; t++)
+            {
+                double td = (double)t;
+                sink_double = ((double)seg->p0 + ((double)seg->c1 * td) + ((double)seg->c2 * pow(td, 2.0)) +
+                               ((double)seg->c3 * pow(td, 3.0))) / one;
+                power_ticks++;
+            }
+        }
+    }
+    uint64_t power_cycles = test_cycles() - start;
+    (void)sink;
+    (void)sink_double;
+
+    printf("bench: profile_next %.1f host cycles per tick (Horner, Q24.40); double powers %.1f per tick\n",
+           (double)cycles / (double)ticks, (double)power_cycles / (double)power_ticks);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,211 @@
+/*******************************************************************************
+ * @file   test_servo_lut.c
+ * @brief  Angle to PWM pulse lookup table host test.
+ *             - The compile-time LUTs (both PWM timer resolutions) against the
+ *               replaced floating-point macro over 0..180 degrees.
+ *             - A LUT built from calibration points against the compile-time
+ *               LUT, and a multi-point calibration's breakpoints.
+ *             - Range limiting.
+ *             - Cycles per conversion, LUT against the macro (benchmark).
+ ******************************************************************************/
+
+#include "servo_lut.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <stdlib.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's nominal pulse-widths and timer resolutions (see servo.c, timer.h). */
+#define PERIOD_NS               20000000
+#define NS_NEG_90               500000
+#define NS_0                    1500000
+#define NS_POS_90               2500000
+#define TIM2_COUNTER            1600000 /* High-resolution mode. */
+#define TIM15_16_COUNTER        64000
+
+/* The replaced conversion (baseline servo.c), for a timer resolution of counter counts per frame. */
+#define PERIOD_MS               20
+#define NEG_90_MS               0.5
+#define POS_90_MS               2.5
+#define PULSE_MIN(counter)      (((NEG_90_MS / PERIOD_MS) * (counter)) - 1)
+#define PULSE_MAX(counter)      (((POS_90_MS / PERIOD_MS) * (counter)) - 1)
+#define ANGLE_TO_PULSE(a, counter) \
+    ((((PULSE_MAX(counter) - PULSE_MIN(counter)) / 180) * (float)(a)) + PULSE_MIN(counter))
+
+#define ANGLE_STEPS             (180 * 64) /* 1/64 degree. */
+#define BENCH_CONVERSIONS       1000000
+
+/* The firmware's default LUTs (see servo.c). */
+static const SERVO_LUT_t _lut_tim2 = SERVO_LUT_INITIALISER(NS_NEG_90, NS_0, NS_POS_90, PERIOD_NS, TIM2_COUNTER);
+static const SERVO_LUT_t _lut_tim15_16 = SERVO_LUT_INITIALISER(NS_NEG_90, NS_0, NS_POS_90, PERIOD_NS,
+                                                               TIM15_16_COUNTER);
+
+/*===== Private Function Prototypes ==========================================*/
+static void test_against_macro(const SERVO_LUT_t *lut, uint32_t counter, const char *name);
+static void test_build(void);
+static void test_calibration(void);
+static void test_limits(void);
+static void bench_conversion(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_against_macro(&_lut_tim2, TIM2_COUNTER, "TIM2");
+    test_against_macro(&_lut_tim15_16, TIM15_16_COUNTER, "TIM15/16");
+    test_build();
+    test_calibration();
+    test_limits();
+    bench_conversion();
+    return test_result("test_servo_lut");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  A compile-time LUT against the floating-point macro (evaluated in
+ *         double precision): within two counts, the truncation of the LUT
+ *         points and of the interpolation (25 ns at the TIM2 resolution).
+ * @param  lut:     LUT.
+ * @param  counter: Timer counts per frame.
+ * @param  name:    Timer name.
+ * @retval None.
+ */
+static void test_against_macro(const SERVO_LUT_t *lut, uint32_t counter, const char *name)
+{
+    double error_max = 0.0;
+
+    for (int32_t i = 0; i <= ANGLE_STEPS; i++)
+    {
+        double angle = (double)i / 64.0;
+        double expected = (((PULSE_MAX(counter) - PULSE_MIN(counter)) / 180) * angle) + PULSE_MIN(counter);
+        double pulse = (double)servo_lut_angle_to_pulse(lut, (int32_t)(angle * 65536.0));
+        error_max = fmax(error_max, fabs(pulse - expected));
+    }
+    printf("%s LUT against the float macro: error max %.3f counts\n", name, error_max);
+    TEST_CHECK(error_max < 2.0, "%s LUT error %.3f counts", name, error_max);
+}
+
+/**
+ * @brief  A LUT built at run-time from the nominal calibration points equals
+ *         the compile-time LUT.
+ * @retval None.
+ */
+static void test_build(void)
+{
+    const SERVO_CAL_POINT_t points[] = {
+        {.angle_q16 = 0, .pulse_ns = NS_NEG_90},
+        {.angle_q16 = 90 << 16, .pulse_ns = NS_0},
+        {.angle_q16 = 180 << 16, .pulse_ns = NS_POS_90},
+    };
+    const SERVO_CAL_POINT_t unsorted[] = {
+        {.angle_q16 = 90 << 16, .pulse_ns = NS_0},
+        {.angle_q16 = 0, .pulse_ns = NS_NEG_90},
+    };
+    SERVO_LUT_t lut;
+    uint32_t mismatches = 0;
+
+    TEST_CHECK(servo_lut_build(&lut, points, 3, PERIOD_NS, TIM2_COUNTER), "nominal points rejected");
+    for (uint32_t i = 0; i < SERVO_LUT_NUM_POINTS; i++)
+    {
+        mismatches += (lut.pulse[i] != _lut_tim2.pulse[i]);
+    }
+    TEST_CHECK(mismatches == 0, "built LUT differs from the compile-time LUT at %lu points",
+               (unsigned long)mismatches);
+    TEST_CHECK(servo_lut_build(&lut, points, 1, PERIOD_NS, TIM2_COUNTER) == false, "single point accepted");
+    TEST_CHECK(servo_lut_build(&lut, unsorted, 2, PERIOD_NS, TIM2_COUNTER) == false, "unsorted points accepted");
+}
+
+/**
+ * @brief  A five point calibration (non-linear servo): exact at breakpoints on
+ *         the grid, linear between them, and monotonic.
+ * @retval None.
+ */
+static void test_calibration(void)
+{
+    const SERVO_CAL_POINT_t points[] = {
+        {.angle_q16 = 0, .pulse_ns = 560000},
+        {.angle_q16 = 48 << 16, .pulse_ns = 1050000},
+        {.angle_q16 = 96 << 16, .pulse_ns = 1580000},
+        {.angle_q16 = 144 << 16, .pulse_ns = 2020000},
+        {.angle_q16 = 180 << 16, .pulse_ns = 2430000},
+    };
+    SERVO_LUT_t lut;
+    bool monotonic = true;
+    double error_max = 0.0;
+
+    TEST_CHECK(servo_lut_build(&lut, points, 5, PERIOD_NS, TIM2_COUNTER), "calibration points rejected");
+    for (uint32_t k = 0; k < 5; k++)
+    {
+        double expected = (((double)points[k].pulse_ns * TIM2_COUNTER) / PERIOD_NS) - 1.0;
+        double pulse = (double)servo_lut_angle_to_pulse(&lut, points[k].angle_q16);
+        error_max = fmax(error_max, fabs(pulse - expected));
+    }
+    uint32_t prev = 0;
+    for (int32_t angle = 0; angle <= (180 << 16); angle += (1 << 10))
+    {
+        uint32_t pulse = servo_lut_angle_to_pulse(&lut, angle);
+        monotonic &= (pulse >= prev);
+        prev = pulse;
+    }
+    TEST_CHECK(error_max <= 1.0, "calibration breakpoint error %.3f counts", error_max);
+    TEST_CHECK(monotonic, "calibrated LUT not monotonic");
+}
+
+/**
+ * @brief  Angles beyond 0..180 degrees are limited.
+ * @retval None.
+ */
+static void test_limits(void)
+{
+    TEST_CHECK(servo_lut_angle_to_pulse(&_lut_tim2, -(10 << 16)) == servo_lut_angle_to_pulse(&_lut_tim2, 0),
+               "angle below 0 not limited");
+    TEST_CHECK(servo_lut_angle_to_pulse(&_lut_tim2, 200 << 16) == servo_lut_angle_to_pulse(&_lut_tim2, 180 << 16),
+               "angle above 180 not limited");
+}
+
+/**
+ * @brief  Benchmark: host cycles per conversion, LUT against the macro (as
+ *         servo_set_position used it: a float angle and double constants).
+ * @retval None.
+ */
+static void bench_conversion(void)
+{
+    int32_t *angles = malloc(BENCH_CONVERSIONS * sizeof(int32_t));
+    volatile uint32_t sink = 0;
+
+    test_rand_seed(3);
+    for (uint32_t k = 0; k < BENCH_CONVERSIONS; k++)
+    {
+        angles[k] = (int32_t)(test_rand_uniform() * (180 << 16));
+    }
+
+    uint64_t start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_CONVERSIONS; k++)
+    {
+        sink = servo_lut_angle_to_pulse(&_lut_tim2, angles[k]);
+    }
+    uint64_t lut_cycles = test_cycles() - start;
+
+    start = test_cycles();
+    for (uint32_t k = 0; k < BENCH_CONVERSIONS; k++)
+    {
+        sink = (uint32_t)ANGLE_TO_PULSE((float)angles[k] / 65536.0f, TIM2_COUNTER);
+    }
+    uint64_t macro_cycles = test_cycles() - start;
+    (void)sink;
+    free(angles);
+
+    printf("bench: LUT %.1f host cycles per conversion, float macro %.1f (double precision in hardware on the host, "
+           "emulated on the Cortex-M4F)\n",
+           (double)lut_cycles / BENCH_CONVERSIONS, (double)macro_cycles / BENCH_CONVERSIONS);
+}
+
+/*============================================================================*/
\ No newline at end of file
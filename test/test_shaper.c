@@ -0,0 +1,289 @@
+/*******************************************************************************
+ * @file   test_shaper.c
+ * @brief  Input shaper host test: a move's setpoints shaped as in the firmware
+ *         (see servo_ctrl_loop_run) ahead of the PID loop, closed around the
+ *         plant model at 1 kHz, with a lightly damped linkage mode excited by
+ *         the servo's acceleration.
+ *             - Designs: unity sum, the impulses at multiples of half the
+ *               damped period.
+ *             - Residual vibration of the linkage after the move for ZV, ZVD
+ *               and EI against no shaper, at the design frequency and with
+ *               the mode's frequency 20% off the design (insensitivity), and
+ *               the delay each adds.
+ *             - Cycles per update of each shaper (benchmark).
+ ******************************************************************************/
+
+#include "pid.h"
+#include "plant.h"
+#include "shaper.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000.0f
+#define PID_KP                  0.5f
+#define PID_KI                  5.0f
+#define PID_OUTPUT_MAX          30.0f
+#define SLEW_DEG_S              600.0f
+#define FRAME_RATE_HZ           50.0f
+#define ANGLE_MAX               180.0f
+#define SHAPER_FREQ_HZ          5.0f
+#define SHAPER_ZETA             0.05f
+#define SHAPER_MAX_DELAY        400
+
+/* The move (a raised cosine, 60 degrees in 200 ms: up to the servo's speed limit) and the linkage's mode. */
+#define MOVE_START_DEG          60.0f
+#define MOVE_END_DEG            120.0f
+#define MOVE_MS                 200
+#define MODE_ZETA               SHAPER_ZETA
+#define RESIDUAL_START_MS       1000    /* After the move, the longest shaper and the servo's settling. */
+#define RESIDUAL_END_MS         3000
+
+#define BENCH_UPDATES           1000000
+
+/*===== Typedefs =============================================================*/
+
+typedef struct LINKAGE_t {
+    float wn;                   /* Mode natural frequency (rad/s). */
+    float deflection;           /* Relative to the servo's position (degrees). */
+    float rate;                 /* Deflection rate (degrees/s). */
+} LINKAGE_t;
+
+/*===== Private Variables ====================================================*/
+static float _state[SHAPER_MAX_DELAY + 1];
+static const char *const _names[] = {"none", "ZV", "ZVD", "EI"};
+
+/*===== Private Function Prototypes ==========================================*/
+static bool design(SHAPER_TYPE_t type, SHAPER_DESIGN_t *designed);
+static float run_move(SHAPER_TYPE_t type, float mode_hz);
+static void test_designs(void);
+static void test_residual(void);
+static void bench_update(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_designs();
+    test_residual();
+    bench_update();
+    return test_result("test_shaper");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Design a shaper of a type for the firmware's default mode.
+ * @param  type:     Shaper type.
+ * @param  designed: Design. Passed by reference.
+ * @retval Boolean indicating whether the design is valid.
+ */
+static bool design(SHAPER_TYPE_t type, SHAPER_DESIGN_t *designed)
+{
+    const SHAPER_CONFIG_t config = {
+        .type = type,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .freq_hz = SHAPER_FREQ_HZ,
+        .zeta = SHAPER_ZETA,
+    };
+
+    return shaper_design(&config, designed);
+}
+
+/**
+ * @brief  Run the move through a shaper and the PID loop (see test_pid.c),
+ *         the linkage mode driven by the servo's acceleration, and measure
+ *         its residual vibration.
+ * @param  type:    Shaper type.
+ * @param  mode_hz: Linkage mode's natural frequency (Hz).
+ * @retval Residual vibration: peak deflection after the move (degrees).
+ */
+static float run_move(SHAPER_TYPE_t type, float mode_hz)
+{
+    const PLANT_CONFIG_t plant_config = PLANT_CONFIG_DEFAULT;
+    const PID_CONFIG_t pid_config = {
+        .kp = PID_KP,
+        .ki = PID_KI,
+        .kd = 0.0f,
+        .period_s = 1.0f / LOOP_RATE_HZ,
+        .output_min = -PID_OUTPUT_MAX,
+        .output_max = PID_OUTPUT_MAX,
+        .derivative = PID_DERIVATIVE__ERROR,
+    };
+    const float slew_step = SLEW_DEG_S / FRAME_RATE_HZ;
+    const float dt = 1.0f / LOOP_RATE_HZ;
+    SHAPER_DESIGN_t designed;
+    SHAPER_t shaper;
+    PID_t pid;
+    PLANT_t plant;
+    LINKAGE_t linkage = {.wn = 2.0f * PI * mode_hz};
+    float residual = 0.0f;
+
+    shaper_init(&shaper, _state, SHAPER_MAX_DELAY, MOVE_START_DEG);
+    if ((type != SHAPER_TYPE__NONE) && (!design(type, &designed) || !shaper_set_design(&shaper, &designed)))
+    {
+        TEST_CHECK(false, "%s design not applied", _names[type]);
+        return 0.0f;
+    }
+    pid_init(&pid, &pid_config);
+    plant_init(&plant, &plant_config, MOVE_START_DEG);
+    float latched = plant.command;
+    for (uint32_t k = 0; k < (uint32_t)RESIDUAL_END_MS; k++)
+    {
+        float move = (k < MOVE_MS) ? (0.5f - (0.5f * cosf((PI * (float)k) / MOVE_MS))) : 1.0f;
+        float setpoint = shaper_update(&shaper, MOVE_START_DEG + ((MOVE_END_DEG - MOVE_START_DEG) * move));
+
+        float command_min = fmaxf(0.0f, latched - slew_step);
+        float command_max = fminf(ANGLE_MAX, latched + slew_step);
+        pid_set_actuator_limits(&pid, command_min - setpoint, command_max - setpoint);
+        float command = setpoint + pid_update(&pid, setpoint, plant.feedback);
+        command = fmaxf(command_min, fminf(command_max, command));
+        if (plant.loop == (plant.config.loops_per_frame - 1))
+        {
+            latched = command;
+        }
+        plant_step(&plant, command);
+
+        /* The linkage (a lightly damped mode on the servo's output) is excited by its acceleration. */
+        float acceleration = -(linkage.wn * linkage.wn * linkage.deflection) -
+                             (2.0f * MODE_ZETA * linkage.wn * linkage.rate) - plant.acceleration;
+        linkage.rate += acceleration * dt;
+        linkage.deflection += linkage.rate * dt;
+        if (k >= RESIDUAL_START_MS)
+        {
+            residual = fmaxf(residual, fabsf(linkage.deflection));
+        }
+    }
+    TEST_CHECK(fabsf(plant.position - MOVE_END_DEG) < 0.1f, "%s move ends at %.3f deg", _names[type],
+               (double)plant.position);
+    return residual;
+}
+
+/**
+ * @brief  Each design's impulses sum to unity, start at zero delay and are
+ *         spaced half the damped period apart (within a sample).
+ * @retval None.
+ */
+static void test_designs(void)
+{
+    const float half_period = LOOP_RATE_HZ / (2.0f * SHAPER_FREQ_HZ * sqrtf(1.0f - (SHAPER_ZETA * SHAPER_ZETA)));
+
+    for (uint32_t t = SHAPER_TYPE__ZV; t < SHAPER_TYPE__NUM; t++)
+    {
+        SHAPER_DESIGN_t designed;
+        float sum = 0.0f;
+        float spacing_error = 0.0f;
+
+        TEST_CHECK(design((SHAPER_TYPE_t)t, &designed), "%s design rejected", _names[t]);
+        for (uint32_t i = 0; i < designed.num_impulses; i++)
+        {
+            sum += designed.amplitudes[i];
+            spacing_error = fmaxf(spacing_error, fabsf((float)designed.delays[i] - (half_period * (float)i)));
+        }
+        TEST_CHECK(fabsf(sum - 1.0f) < 1e-6f, "%s impulses sum to %.7f", _names[t], (double)sum);
+        TEST_CHECK(spacing_error <= 1.0f, "%s impulses %.2f samples from the half damped periods", _names[t],
+                   (double)spacing_error);
+    }
+}
+
+/**
+ * @brief  Residual vibration of each shaper relative to no shaper: at the
+ *         design frequency ZV and ZVD cancel it (the linkage's excitation
+ *         is not exactly the shaped setpoint: the servo's loop, slew limit
+ *         and frame latch lie between) and EI bounds it to its design
+ *         vibration; with the mode's frequency 20% off, ZVD and EI are less
+ *         sensitive than ZV.
+ * @retval None.
+ */
+static void test_residual(void)
+{
+    const float mode_hz[] = {SHAPER_FREQ_HZ, 0.8f * SHAPER_FREQ_HZ, 1.2f * SHAPER_FREQ_HZ};
+    float residual[TEST_NUM_ELS(mode_hz)][SHAPER_TYPE__NUM];
+
+    for (uint32_t m = 0; m < TEST_NUM_ELS(mode_hz); m++)
+    {
+        for (uint32_t t = SHAPER_TYPE__NONE; t < SHAPER_TYPE__NUM; t++)
+        {
+            residual[m][t] = run_move((SHAPER_TYPE_t)t, mode_hz[m]);
+        }
+        printf("mode %.1f Hz (design %.1f Hz): residual vibration none %.3f deg, ZV %.3f (%.1f%%), "
+               "ZVD %.3f (%.1f%%), EI %.3f (%.1f%%)\n",
+               (double)mode_hz[m], (double)SHAPER_FREQ_HZ, (double)residual[m][SHAPER_TYPE__NONE],
+               (double)residual[m][SHAPER_TYPE__ZV],
+               (double)(100.0f * residual[m][SHAPER_TYPE__ZV] / residual[m][SHAPER_TYPE__NONE]),
+               (double)residual[m][SHAPER_TYPE__ZVD],
+               (double)(100.0f * residual[m][SHAPER_TYPE__ZVD] / residual[m][SHAPER_TYPE__NONE]),
+               (double)residual[m][SHAPER_TYPE__EI],
+               (double)(100.0f * residual[m][SHAPER_TYPE__EI] / residual[m][SHAPER_TYPE__NONE]));
+    }
+    for (uint32_t t = SHAPER_TYPE__ZV; t < SHAPER_TYPE__NUM; t++)
+    {
+        SHAPER_DESIGN_t designed;
+        (void)design((SHAPER_TYPE_t)t, &designed);
+        printf("%s: delay %ld ms\n", _names[t],
+               (long)((1000.0f * (float)designed.delays[designed.num_impulses - 1]) / LOOP_RATE_HZ));
+    }
+
+    const float *nominal = residual[0];
+    TEST_CHECK(nominal[SHAPER_TYPE__ZV] < (0.05f * nominal[SHAPER_TYPE__NONE]), "ZV residual %.3f deg",
+               (double)nominal[SHAPER_TYPE__ZV]);
+    TEST_CHECK(nominal[SHAPER_TYPE__ZVD] < (0.05f * nominal[SHAPER_TYPE__NONE]), "ZVD residual %.3f deg",
+               (double)nominal[SHAPER_TYPE__ZVD]);
+    TEST_CHECK(nominal[SHAPER_TYPE__EI] < (2.0f * SHAPER_EI_VIBRATION * nominal[SHAPER_TYPE__NONE]),
+               "EI residual %.3f deg", (double)nominal[SHAPER_TYPE__EI]);
+    for (uint32_t m = 1; m < TEST_NUM_ELS(mode_hz); m++)
+    {
+        for (uint32_t t = SHAPER_TYPE__ZV; t < SHAPER_TYPE__NUM; t++)
+        {
+            TEST_CHECK(residual[m][t] < residual[m][SHAPER_TYPE__NONE], "mode %.1f Hz: %s residual %.3f deg",
+                       (double)mode_hz[m], _names[t], (double)residual[m][t]);
+        }
+        TEST_CHECK(residual[m][SHAPER_TYPE__ZVD] < residual[m][SHAPER_TYPE__ZV],
+                   "mode %.1f Hz: ZVD residual %.3f deg, ZV %.3f deg", (double)mode_hz[m],
+                   (double)residual[m][SHAPER_TYPE__ZVD], (double)residual[m][SHAPER_TYPE__ZV]);
+        TEST_CHECK(residual[m][SHAPER_TYPE__EI] < residual[m][SHAPER_TYPE__ZV],
+                   "mode %.1f Hz: EI residual %.3f deg, ZV %.3f deg", (double)mode_hz[m],
+                   (double)residual[m][SHAPER_TYPE__EI], (double)residual[m][SHAPER_TYPE__ZV]);
+    }
+}
+
+/**
+ * @brief  Benchmark: host cycles per update of each shaper (one
+ *         multiply-accumulate per impulse).
+ * @retval None.
+ */
+static void bench_update(void)
+{
+    volatile float sink = 0.0f;
+
+    printf("bench: host cycles per update:");
+    for (uint32_t t = SHAPER_TYPE__NONE; t < SHAPER_TYPE__NUM; t++)
+    {
+        SHAPER_DESIGN_t designed;
+        SHAPER_t shaper;
+
+        shaper_init(&shaper, _state, SHAPER_MAX_DELAY, 0.0f);
+        if ((t != SHAPER_TYPE__NONE) && design((SHAPER_TYPE_t)t, &designed))
+        {
+            (void)shaper_set_design(&shaper, &designed);
+        }
+        uint64_t start = test_cycles();
+        for (uint32_t k = 0; k < BENCH_UPDATES; k++)
+        {
+            sink = shaper_update(&shaper, (float)(k & 63U));
+        }
+        uint64_t cycles = test_cycles() - start;
+        printf(" %s %.1f%s", _names[t], (double)cycles / BENCH_UPDATES, (t < (SHAPER_TYPE__NUM - 1)) ? "," : "\n");
+    }
+    (void)sink;
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,415 @@
+/*******************************************************************************
+ * @file   test_stream.c
+ * @brief  Setpoint stream host test: waypoints at the host's 50 Hz played at
+ *         the 1 kHz control loop rate (see servo_ctrl.c).
+ *             - Ring: full and overrun counting, and many laps of the ring
+ *               (free-running indices) and a wrap of the timestamps.
+ *             - Prefill: idle until STREAM_PREFILL waypoints are buffered,
+ *               then playback from the first.
+ *             - Underrun: the reached waypoint is held, and playback resumes
+ *               from it (STARVED to ACTIVE) when waypoints arrive; the
+ *               stream ends after STREAM_TIMEOUT_US.
+ *             - Interpolation: linear and cubic (Catmull-Rom) against an
+ *               analytic trajectory (exact on a ramp; the cubic's error on a
+ *               sine far below the linear's).
+ *             - Discards: a waypoint not later than its predecessor is
+ *               discarded (its predecessor copied over it) and playback
+ *               continues; a gap starts a new stream.
+ ******************************************************************************/
+
+#include "stream.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+#include <string.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define LOOP_RATE_HZ            1000
+#define NUM_AXES                6       /* Servos. */
+
+#define WAYPOINT_US             20000   /* 50 Hz host waypoints. */
+#define TICK_US                 (1000000 / LOOP_RATE_HZ)
+#define TICKS_PER_WAYPOINT      (WAYPOINT_US / TICK_US)
+#define Q16(deg)                ((int32_t)lround((deg) * 65536.0))
+
+#define SINE_AMPLITUDE_DEG      45.0
+#define SINE_CENTRE_DEG         90.0
+#define SINE_HZ                 1.0
+#define RAMP_DEG_S              30.0
+#define PLAY_WAYPOINTS          200
+
+/*===== Typedefs =============================================================*/
+
+typedef double (*TRAJECTORY_t)(double t_s, uint32_t axis);
+
+/*===== Private Function Prototypes ==========================================*/
+static double sine(double t_s, uint32_t axis);
+static double ramp(double t_s, uint32_t axis);
+static void waypoint(STREAM_WAYPOINT_t *wp, uint32_t timestamp_us, TRAJECTORY_t trajectory, double t_s);
+static double play(STREAM_INTERP_t interp, TRAJECTORY_t trajectory, uint32_t t0_us, uint32_t *underruns);
+static void test_ring(void);
+static void test_prefill(void);
+static void test_underrun(void);
+static void test_interpolation(void);
+static void test_discard(void);
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_ring();
+    test_prefill();
+    test_underrun();
+    test_interpolation();
+    test_discard();
+    return test_result("test_stream");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  Trajectory: a sine per axis (phase shifted by axis).
+ * @param  t_s:  Time (s).
+ * @param  axis: Axis.
+ * @retval Position (degrees).
+ */
+static double sine(double t_s, uint32_t axis)
+{
+    return SINE_CENTRE_DEG + (SINE_AMPLITUDE_DEG * sin((2.0 * M_PI * SINE_HZ * t_s) + (0.5 * axis)));
+}
+
+/**
+ * @brief  Trajectory: a ramp per axis (rising or falling by axis).
+ * @param  t_s:  Time (s).
+ * @param  axis: Axis.
+ * @retval Position (degrees).
+ */
+static double ramp(double t_s, uint32_t axis)
+{
+    return SINE_CENTRE_DEG + (((axis & 1) ? -RAMP_DEG_S : RAMP_DEG_S) * t_s);
+}
+
+/**
+ * @brief  Construct a waypoint of a trajectory.
+ * @param  wp:           Waypoint. Passed by reference.
+ * @param  timestamp_us: Timestamp (host time base).
+ * @param  trajectory:   Trajectory.
+ * @param  t_s:          Trajectory time (s).
+ * @retval None.
+ */
+static void waypoint(STREAM_WAYPOINT_t *wp, uint32_t timestamp_us, TRAJECTORY_t trajectory, double t_s)
+{
+    memset(wp, 0, sizeof(*wp));
+    wp->timestamp_us = timestamp_us;
+    for (uint32_t i = 0; i < NUM_AXES; i++)
+    {
+        wp->position[i] = Q16(trajectory(t_s, i));
+    }
+}
+
+/**
+ * @brief  Play PLAY_WAYPOINTS waypoints of a trajectory (up to the last), the
+ *         host keeping STREAM_PREFILL waypoints ahead of playback, and
+ *         measure the output's error to the trajectory away from the start
+ *         and end (the cubic starts and ends at rest).
+ * @param  interp:     Interpolation.
+ * @param  trajectory: Trajectory.
+ * @param  t0_us:      First waypoint's timestamp.
+ * @param  underruns:  Underruns. Passed by reference.
+ * @retval Maximum error (degrees).
+ */
+static double play(STREAM_INTERP_t interp, TRAJECTORY_t trajectory, uint32_t t0_us, uint32_t *underruns)
+{
+    STREAM_t stream;
+    STREAM_WAYPOINT_t wp;
+    STREAM_STATS_t stats;
+    int32_t position[NUM_AXES];
+    uint32_t pushed = 0;
+    uint32_t idle_ticks = 0;
+    double error_max = 0.0;
+
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, interp);
+    for (uint32_t tick = 0; tick < ((PLAY_WAYPOINTS - 1) * TICKS_PER_WAYPOINT); tick++)
+    {
+        /* The host sends each waypoint STREAM_PREFILL periods ahead of its playback. */
+        uint32_t ahead = tick + (STREAM_PREFILL * TICKS_PER_WAYPOINT);
+        while ((pushed < PLAY_WAYPOINTS) && ((pushed * TICKS_PER_WAYPOINT) <= ahead))
+        {
+            waypoint(&wp, t0_us + (pushed * WAYPOINT_US), trajectory, (pushed * WAYPOINT_US) * 1e-6);
+            stream_push(&stream, &wp);
+            pushed++;
+        }
+        idle_ticks += (stream_next(&stream, position) == false);
+
+        /* Playback time is the first waypoint's plus a tick per call. */
+        uint32_t waypoint_index = tick / TICKS_PER_WAYPOINT;
+        if ((waypoint_index >= 2) && (waypoint_index < (PLAY_WAYPOINTS - 2)))
+        {
+            for (uint32_t i = 0; i < NUM_AXES; i++)
+            {
+                double expected = trajectory((tick * TICK_US) * 1e-6, i);
+                error_max = fmax(error_max, fabs((position[i] / 65536.0) - expected));
+            }
+        }
+    }
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK((idle_ticks == 0) && (stats.overrun_count == 0), "playback: %lu idle ticks, %lu overruns",
+               (unsigned long)idle_ticks, (unsigned long)stats.overrun_count);
+    *underruns = stats.underrun_count;
+
+    return error_max;
+}
+
+/**
+ * @brief  The ring holds STREAM_QUEUE_LEN waypoints and counts the pushes to
+ *         a full ring; playback over many laps of the ring and across the
+ *         wrap of the (32-bit) timestamps is seamless.
+ * @retval None.
+ */
+static void test_ring(void)
+{
+    STREAM_t stream;
+    STREAM_WAYPOINT_t wp;
+    STREAM_STATS_t stats;
+    uint32_t underruns;
+
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, STREAM_INTERP__LINEAR);
+    for (uint32_t k = 0; k < STREAM_QUEUE_LEN; k++)
+    {
+        waypoint(&wp, k * WAYPOINT_US, ramp, (k * WAYPOINT_US) * 1e-6);
+        TEST_CHECK(stream_push(&stream, &wp), "waypoint %lu of an empty ring rejected", (unsigned long)k);
+    }
+    TEST_CHECK(stream_push(&stream, &wp) == false, "push to a full ring accepted");
+    TEST_CHECK(stream_push(&stream, &wp) == false, "push to a full ring accepted");
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK((stats.fill == STREAM_QUEUE_LEN) && (stats.overrun_count == 2), "full ring: fill %lu, overruns %lu",
+               (unsigned long)stats.fill, (unsigned long)stats.overrun_count);
+
+    /* Playback frees a slot once its segment is complete. */
+    int32_t position[NUM_AXES];
+    for (uint32_t tick = 0; tick <= TICKS_PER_WAYPOINT; tick++)
+    {
+        stream_next(&stream, position);
+    }
+    waypoint(&wp, STREAM_QUEUE_LEN * WAYPOINT_US, ramp, (STREAM_QUEUE_LEN * WAYPOINT_US) * 1e-6);
+    TEST_CHECK(stream_push(&stream, &wp), "push after a segment completed rejected");
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK(stats.overrun_count == 2, "overruns %lu", (unsigned long)stats.overrun_count);
+
+    /* PLAY_WAYPOINTS: over 12 laps of the ring; the timestamps wrap after the first second. */
+    uint32_t underruns_wrap;
+    double error_max = play(STREAM_INTERP__LINEAR, ramp, 0, &underruns);
+    double error_wrap_max = play(STREAM_INTERP__LINEAR, ramp, UINT32_MAX - 999999, &underruns_wrap);
+    printf("Ring laps: ramp error max %.6f deg, across the timestamp wrap %.6f deg\n", error_max, error_wrap_max);
+    TEST_CHECK((underruns == 0) && (underruns_wrap == 0), "underruns %lu, across the timestamp wrap %lu",
+               (unsigned long)underruns, (unsigned long)underruns_wrap);
+    TEST_CHECK(error_max < 0.001, "ramp error %.6f deg", error_max);
+    TEST_CHECK(error_wrap_max <= error_max, "timestamp wrap: error %.6f deg against %.6f deg", error_wrap_max,
+               error_max);
+}
+
+/**
+ * @brief  Playback starts once STREAM_PREFILL waypoints are buffered, from
+ *         the first waypoint.
+ * @retval None.
+ */
+static void test_prefill(void)
+{
+    STREAM_t stream;
+    STREAM_WAYPOINT_t wp;
+    int32_t position[NUM_AXES];
+
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, STREAM_INTERP__CUBIC);
+    for (uint32_t k = 0; k < STREAM_PREFILL; k++)
+    {
+        TEST_CHECK((stream_next(&stream, position) == false) && (stream_is_active(&stream) == false),
+                   "playing with %lu waypoints buffered", (unsigned long)k);
+        waypoint(&wp, 1000000 + (k * WAYPOINT_US), sine, (k * WAYPOINT_US) * 1e-6);
+        stream_push(&stream, &wp);
+    }
+    TEST_CHECK(stream_next(&stream, position) && stream_is_active(&stream), "idle with %d waypoints buffered",
+               STREAM_PREFILL);
+    TEST_CHECK(position[0] == Q16(sine(0.0, 0)), "playback started at %.3f deg, not the first waypoint %.3f deg",
+               position[0] / 65536.0, sine(0.0, 0));
+}
+
+/**
+ * @brief  Starved of waypoints, the stream holds the reached waypoint and
+ *         counts the underrun; it resumes from the held waypoint when
+ *         waypoints arrive, and ends after STREAM_TIMEOUT_US.
+ * @retval None.
+ */
+static void test_underrun(void)
+{
+    STREAM_t stream;
+    STREAM_WAYPOINT_t wp;
+    STREAM_STATS_t stats;
+    int32_t position[NUM_AXES];
+    uint32_t k;
+
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, STREAM_INTERP__CUBIC);
+    for (k = 0; k < 4; k++)
+    {
+        waypoint(&wp, k * WAYPOINT_US, sine, (k * WAYPOINT_US) * 1e-6);
+        stream_push(&stream, &wp);
+    }
+    int32_t last = wp.position[0];
+
+    /* Play to the last waypoint and beyond: held. */
+    uint32_t idle_ticks = 0;
+    for (uint32_t tick = 0; tick < (5 * TICKS_PER_WAYPOINT); tick++)
+    {
+        idle_ticks += (stream_next(&stream, position) == false);
+    }
+    TEST_CHECK(idle_ticks == 0, "%lu idle ticks before the timeout", (unsigned long)idle_ticks);
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK((stats.state == STREAM_STATE__STARVED) && (stats.underrun_count == 1),
+               "starved: state %d, underruns %lu", (int)stats.state, (unsigned long)stats.underrun_count);
+    TEST_CHECK(position[0] == last, "held %.3f deg, not the last waypoint %.3f deg", position[0] / 65536.0,
+               last / 65536.0);
+
+    /* Waypoints resume (the host's time base ran on): playback resumes from the held waypoint. */
+    for (k = 10; k < 13; k++)
+    {
+        waypoint(&wp, k * WAYPOINT_US, sine, (k * WAYPOINT_US) * 1e-6);
+        stream_push(&stream, &wp);
+    }
+    TEST_CHECK(stream_next(&stream, position) && (position[0] == last), "resumed at %.3f deg, not the held %.3f deg",
+               position[0] / 65536.0, last / 65536.0);
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK(stats.state == STREAM_STATE__ACTIVE, "not resumed: state %d", (int)stats.state);
+    double step_max = 0.0;
+    int32_t prev = position[0];
+    for (uint32_t tick = 0; tick < (2 * TICKS_PER_WAYPOINT); tick++)
+    {
+        stream_next(&stream, position);
+        step_max = fmax(step_max, fabs((position[0] - prev) / 65536.0));
+        prev = position[0];
+    }
+    TEST_CHECK(step_max < 1.0, "step of %.3f deg per tick after resuming", step_max);
+
+    /* Starved for STREAM_TIMEOUT_US: the stream ends. */
+    while (stream.state != STREAM_STATE__STARVED)
+    {
+        stream_next(&stream, position);
+    }
+    uint32_t ticks = 0;
+    while (stream_next(&stream, position) && (ticks < (2 * STREAM_TIMEOUT_US / TICK_US)))
+    {
+        ticks++;
+    }
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK((stats.state == STREAM_STATE__IDLE) && (stats.fill == 0), "not ended: state %d, fill %lu",
+               (int)stats.state, (unsigned long)stats.fill);
+    TEST_CHECK(((ticks + 1) * TICK_US) == STREAM_TIMEOUT_US, "ended after %lu ms starved",
+               (unsigned long)((ticks + 1) * TICK_US / 1000));
+    TEST_CHECK(stats.underrun_count == 2, "underruns %lu", (unsigned long)stats.underrun_count);
+}
+
+/**
+ * @brief  Linear and cubic interpolation against the trajectories: both
+ *         exact on a ramp (within the float evaluation), the cubic on a sine
+ *         well within the linear's error.
+ * @retval None.
+ */
+static void test_interpolation(void)
+{
+    uint32_t underruns;
+    double linear_ramp = play(STREAM_INTERP__LINEAR, ramp, 0, &underruns);
+    double cubic_ramp = play(STREAM_INTERP__CUBIC, ramp, 0, &underruns);
+    double linear_sine = play(STREAM_INTERP__LINEAR, sine, 0, &underruns);
+    double cubic_sine = play(STREAM_INTERP__CUBIC, sine, 0, &underruns);
+
+    /* Linear between samples of a sine: at most A (w T)^2 / 8. */
+    double linear_bound = SINE_AMPLITUDE_DEG * pow(2.0 * M_PI * SINE_HZ * WAYPOINT_US * 1e-6, 2.0) / 8.0;
+
+    printf("Ramp error max: linear %.6f deg, cubic %.6f deg\n", linear_ramp, cubic_ramp);
+    printf("Sine error max: linear %.4f deg (bound %.4f), cubic %.4f deg\n", linear_sine, linear_bound, cubic_sine);
+    TEST_CHECK(linear_ramp < 0.001, "linear ramp error %.6f deg", linear_ramp);
+    TEST_CHECK(cubic_ramp < 0.001, "cubic ramp error %.6f deg", cubic_ramp);
+    TEST_CHECK(linear_sine <= (linear_bound * 1.01), "linear sine error %.4f deg, bound %.4f deg", linear_sine,
+               linear_bound);
+    TEST_CHECK(cubic_sine < (linear_sine / 4.0), "cubic sine error %.4f deg against linear %.4f deg", cubic_sine,
+               linear_sine);
+    TEST_CHECK(underruns == 0, "underruns %lu", (unsigned long)underruns);
+}
+
+/**
+ * @brief  A waypoint not later than its predecessor is discarded: its slot
+ *         takes the predecessor (p0 copied over p1) and playback runs from
+ *         the predecessor to the next later waypoint; a timestamp step larger
+ *         than STREAM_MAX_GAP_US starts a new stream (buffering).
+ * @retval None.
+ */
+static void test_discard(void)
+{
+    static const struct {
+        uint32_t timestamp_us;
+        double position_deg;
+    } waypoints[] = {
+        {0, 10.0},
+        {WAYPOINT_US, 20.0},
+        {WAYPOINT_US, 99.0},        /* Repeated timestamp: discarded. */
+        {WAYPOINT_US - 5000, 99.0}, /* Earlier: discarded. */
+        {2 * WAYPOINT_US, 30.0},
+        {3 * WAYPOINT_US, 40.0},
+    };
+    STREAM_t stream;
+    STREAM_WAYPOINT_t wp;
+    STREAM_STATS_t stats;
+    int32_t position[NUM_AXES];
+    double error_max = 0.0;
+
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, STREAM_INTERP__LINEAR);
+    for (uint32_t k = 0; k < TEST_NUM_ELS(waypoints); k++)
+    {
+        memset(&wp, 0, sizeof(wp));
+        wp.timestamp_us = waypoints[k].timestamp_us;
+        wp.position[0] = Q16(waypoints[k].position_deg);
+        stream_push(&stream, &wp);
+    }
+
+    /* 10 -> 20 -> 30 -> 40 degrees at 10 degrees per waypoint period. */
+    uint32_t idle_ticks = 0;
+    for (uint32_t tick = 0; tick <= (3 * TICKS_PER_WAYPOINT); tick++)
+    {
+        idle_ticks += (stream_next(&stream, position) == false);
+        double expected = 10.0 + ((10.0 * tick) / TICKS_PER_WAYPOINT);
+        error_max = fmax(error_max, fabs((position[0] / 65536.0) - expected));
+    }
+    stream_get_stats(&stream, &stats);
+    printf("Discards: %lu, playback error max %.6f deg\n", (unsigned long)stats.discard_count, error_max);
+    TEST_CHECK(idle_ticks == 0, "%lu idle ticks", (unsigned long)idle_ticks);
+    TEST_CHECK(stats.discard_count == 2, "discards %lu", (unsigned long)stats.discard_count);
+    TEST_CHECK(error_max < 0.001, "playback with discards: error %.6f deg", error_max);
+
+    /* A gap: the stream ends at the last waypoint and buffers the new one. */
+    stream_init(&stream, LOOP_RATE_HZ, NUM_AXES, STREAM_INTERP__LINEAR);
+    for (uint32_t k = 0; k < STREAM_PREFILL; k++)
+    {
+        memset(&wp, 0, sizeof(wp));
+        wp.timestamp_us = k * WAYPOINT_US;
+        stream_push(&stream, &wp);
+    }
+    wp.timestamp_us += STREAM_MAX_GAP_US + 1;
+    stream_push(&stream, &wp);
+    uint32_t ticks = 0;
+    while (stream_next(&stream, position))
+    {
+        ticks++;
+    }
+    stream_get_stats(&stream, &stats);
+    TEST_CHECK((ticks == ((STREAM_PREFILL - 1) * TICKS_PER_WAYPOINT)) && (stats.state == STREAM_STATE__IDLE) &&
+                   (stats.fill == 1),
+               "gap: played %lu ticks, state %d, fill %lu", (unsigned long)ticks, (int)stats.state,
+               (unsigned long)stats.fill);
+}
+
+/*============================================================================*/
\ No newline at end of file
@@ -0,0 +1,380 @@
+/*******************************************************************************
+ * @file   test_sysid.c
+ * @brief  System identification host test: frequency responses identified
+ *         from simulated plants of known gain and bandwidth, at the 50 Hz
+ *         feedback sample rate.
+ *             - Run: the fixed run time (settling and averaged periods), no
+ *               excitation once captured, abort, and the result only from a
+ *               complete capture; the bins above the chirp's range not
+ *               excited.
+ *             - A first-order plant (gain 2, i.e. 6 dB, 2 Hz bandwidth)
+ *               stepped at the sample rate: the chirp and PRBS responses
+ *               against its exact discrete-time frequency response, and its
+ *               gain and bandwidth read off them.
+ *             - The servo plant model (6 Hz, zeta 0.8) excited open-loop as
+ *               the firmware does (the excitation held between feedback
+ *               samples, the PWM frame command latch, feedback noise) with
+ *               the firmware's defaults: unity gain and the 2nd order
+ *               system's bandwidth read off the chirp and PRBS responses.
+ *             - Cycles per update and per compute (benchmark).
+ ******************************************************************************/
+
+#include "plant.h"
+#include "sysid.h"
+#include "test.h"
+
+/*===== C Standard Library =====*/
+#include <math.h>
+
+/*===== Defines ==============================================================*/
+
+/* The firmware's defaults (see servo_ctrl.h). */
+#define SAMPLE_RATE_HZ          50.0f
+#define LOOPS_PER_SAMPLE        20
+#define AMPLITUDE_DEG           5.0f
+#define F_MIN_HZ                0.2f
+#define F_MAX_HZ                12.0f
+#define PRBS_HOLD               1
+#define SETTLE_PERIODS          1
+#define PERIODS                 4
+
+#define CENTRE_DEG              90.0f
+#define FIRST_ORDER_GAIN        2.0f
+#define FIRST_ORDER_BW_HZ       2.0f
+#define SERVO_WN_HZ             6.0f
+#define SERVO_ZETA              0.8f
+#define NOISE_DEG               0.5f
+#define SERVO_FLAT_HZ           1.0f    /* Flat to within 0.1 dB. */
+#define SMOOTH_BINS             5
+#define BENCH_RUNS              100
+
+/*===== Typedefs =============================================================*/
+
+typedef struct FRF_RESULT_t {
+    uint32_t bins;              /* Excited bins. */
+    float gain_db;              /* Over the flat band. */
+    float bandwidth_hz;         /* Gain - 3 dB, interpolated between bins; 0 if not crossed. */
+} FRF_RESULT_t;
+
+/*===== Private Function Prototypes ==========================================*/
+static void config_init(SYSID_CONFIG_t *config, SYSID_SIGNAL_t signal);
+static FRF_RESULT_t analyse(const SYSID_t *sysid, float flat_hz);
+static void run_first_order(SYSID_t *sysid, SYSID_SIGNAL_t signal);
+static void run_servo(SYSID_t *sysid, SYSID_SIGNAL_t signal);
+static float servo_bandwidth_hz(void);
+static void test_run(void);
+static void test_first_order(SYSID_SIGNAL_t signal, const char *name);
+static void test_servo(SYSID_SIGNAL_t signal, const char *name);
+static void bench_sysid(void);
+
+/*===== Private Variables ====================================================*/
+
+static SYSID_t _sysid; /* Large: not on the stack. */
+
+/*============================================================================*/
+/*===== Public Functions =====================================================*/
+/*============================================================================*/
+
+int main(void)
+{
+    test_rand_seed(1);
+    test_run();
+    test_first_order(SYSID_SIGNAL__CHIRP, "chirp");
+    test_first_order(SYSID_SIGNAL__PRBS, "PRBS");
+    test_servo(SYSID_SIGNAL__CHIRP, "chirp");
+    test_servo(SYSID_SIGNAL__PRBS, "PRBS");
+    bench_sysid();
+    return test_result("test_sysid");
+}
+
+/*============================================================================*/
+/*===== Private Functions ====================================================*/
+/*============================================================================*/
+
+/**
+ * @brief  The firmware's configuration.
+ * @param  config: Configuration. Passed by reference.
+ * @param  signal: Excitation signal.
+ * @retval None.
+ */
+static void config_init(SYSID_CONFIG_t *config, SYSID_SIGNAL_t signal)
+{
+    config->signal = signal;
+    config->period_s = 1.0f / SAMPLE_RATE_HZ;
+    config->amplitude = AMPLITUDE_DEG;
+    config->f_min_hz = F_MIN_HZ;
+    config->f_max_hz = F_MAX_HZ;
+    config->prbs_hold = PRBS_HOLD;
+    config->settle_periods = SETTLE_PERIODS;
+    config->periods = PERIODS;
+}
+
+/**
+ * @brief  Read the gain and bandwidth off a computed frequency response: the
+ *         gain averaged over the excited bins up to @param flat_hz (at least
+ *         the lowest), the bandwidth where the magnitude, smoothed over
+ *         SMOOTH_BINS excited bins against the feedback noise, falls 3 dB
+ *         below it.
+ * @param  sysid:   Identifier (result computed).
+ * @param  flat_hz: Upper frequency of the flat band (Hz).
+ * @retval Result.
+ */
+static FRF_RESULT_t analyse(const SYSID_t *sysid, float flat_hz)
+{
+    FRF_RESULT_t result = {0};
+    float freq[SYSID_NUM_BINS];
+    float mag[SYSID_NUM_BINS];
+    uint32_t flat = 0;
+
+    for (uint32_t k = 1; k < SYSID_NUM_BINS; k++)
+    {
+        SYSID_BIN_t bin;
+        if (sysid_get_bin(sysid, k, &bin))
+        {
+            freq[result.bins] = bin.freq_hz;
+            mag[result.bins] = bin.mag_db;
+            if ((result.bins == 0) || (bin.freq_hz <= flat_hz))
+            {
+                result.gain_db += bin.mag_db;
+                flat++;
+            }
+            result.bins++;
+        }
+    }
+    result.gain_db /= (float)flat;
+
+    float smoothed_prev = result.gain_db;
+    for (uint32_t i = 1; i < result.bins; i++)
+    {
+        uint32_t first = (i < (SMOOTH_BINS / 2)) ? 0 : (i - (SMOOTH_BINS / 2));
+        uint32_t last = ((i + (SMOOTH_BINS / 2)) >= result.bins) ? (result.bins - 1) : (i + (SMOOTH_BINS / 2));
+        float smoothed = 0.0f;
+        for (uint32_t j = first; j <= last; j++)
+        {
+            smoothed += mag[j] / (float)((last - first) + 1);
+        }
+        if (smoothed < (result.gain_db - 3.0f))
+        {
+            float frac = (smoothed_prev - (result.gain_db - 3.0f)) / (smoothed_prev - smoothed);
+            result.bandwidth_hz = freq[i - 1] + (frac * (freq[i] - freq[i - 1]));
+            break;
+        }
+        smoothed_prev = smoothed;
+    }
+    return result;
+}
+
+/**
+ * @brief  Identify the first-order plant y[n] = a y[n - 1] + K (1 - a) u,
+ *         a = exp(-2 pi fc T), stepped once per update with the excitation
+ *         since the previous one, and compute the result.
+ * @param  sysid:  Identifier.
+ * @param  signal: Excitation signal.
+ * @retval None.
+ */
+static void run_first_order(SYSID_t *sysid, SYSID_SIGNAL_t signal)
+{
+    SYSID_CONFIG_t config;
+    const float a = expf(-2.0f * PI * FIRST_ORDER_BW_HZ / SAMPLE_RATE_HZ);
+    float y = 0.0f;
+    float u = 0.0f;
+
+    config_init(&config, signal);
+    sysid_start(sysid, &config, CENTRE_DEG);
+    while (sysid_get_state(sysid) == SYSID_STATE__RUNNING)
+    {
+        u = sysid_update(sysid, CENTRE_DEG + y);
+        y = (a * y) + (FIRST_ORDER_GAIN * (1.0f - a) * u);
+    }
+    (void)sysid_compute(sysid);
+}
+
+/**
+ * @brief  Identify the servo plant model as the firmware: the excitation
+ *         held between feedback samples is added to the centre command every
+ *         control loop, and the identifier updated with each new sample;
+ *         then compute the result.
+ * @param  sysid:  Identifier.
+ * @param  signal: Excitation signal.
+ * @retval None.
+ */
+static void run_servo(SYSID_t *sysid, SYSID_SIGNAL_t signal)
+{
+    SYSID_CONFIG_t config;
+    PLANT_CONFIG_t plant_config = PLANT_CONFIG_DEFAULT;
+    PLANT_t plant;
+    float excitation = 0.0f;
+
+    plant_config.wn_hz = SERVO_WN_HZ;
+    plant_config.zeta = SERVO_ZETA;
+    plant_config.noise_deg = NOISE_DEG;
+    plant_init(&plant, &plant_config, CENTRE_DEG);
+    config_init(&config, signal);
+    sysid_start(sysid, &config, CENTRE_DEG);
+    while (sysid_get_state(sysid) == SYSID_STATE__RUNNING)
+    {
+        if (plant.feedback_new)
+        {
+            excitation = sysid_update(sysid, plant.feedback);
+        }
+        plant_step(&plant, CENTRE_DEG + excitation);
+    }
+    (void)sysid_compute(sysid);
+}
+
+/**
+ * @brief  The -3 dB bandwidth of the servo's 2nd order system:
+ *         wn sqrt(1 - 2 zeta^2 + sqrt(4 zeta^4 - 4 zeta^2 + 2)).
+ * @retval Bandwidth (Hz).
+ */
+static float servo_bandwidth_hz(void)
+{
+    const double z2 = (double)SERVO_ZETA * SERVO_ZETA;
+    return (float)(SERVO_WN_HZ * sqrt(1.0 - (2.0 * z2) + sqrt((4.0 * z2 * z2) - (4.0 * z2) + 2.0)));
+}
+
+/**
+ * @brief  The run: (settle + averaged) x SYSID_LEN updates to the capture, no
+ *         excitation after it; compute only from a complete capture; abort;
+ *         bins beyond the chirp's range and out of range not valid.
+ * @retval None.
+ */
+static void test_run(void)
+{
+    SYSID_CONFIG_t config;
+    SYSID_BIN_t bin;
+    uint32_t updates = 0;
+    uint32_t failures = 0;
+
+    config_init(&config, SYSID_SIGNAL__CHIRP);
+    sysid_start(&_sysid, &config, CENTRE_DEG);
+    failures += sysid_compute(&_sysid) || sysid_get_bin(&_sysid, 1, &bin);
+    while ((sysid_get_state(&_sysid) == SYSID_STATE__RUNNING) && (updates <= (10 * SYSID_LEN)))
+    {
+        (void)sysid_update(&_sysid, CENTRE_DEG);
+        updates++;
+    }
+    failures += (sysid_get_state(&_sysid) != SYSID_STATE__CAPTURED);
+    failures += (sysid_update(&_sysid, CENTRE_DEG) != 0.0f);
+    failures += !sysid_compute(&_sysid) || (sysid_get_state(&_sysid) != SYSID_STATE__DONE);
+    failures += sysid_compute(&_sysid); /* Once. */
+
+    /* Bins beyond the chirp's range (with a margin for its spectral spread), and out of range. */
+    uint32_t beyond = (uint32_t)(1.5f * F_MAX_HZ * SYSID_LEN / SAMPLE_RATE_HZ);
+    for (uint32_t k = beyond; k < SYSID_NUM_BINS; k++)
+    {
+        failures += sysid_get_bin(&_sysid, k, &bin);
+    }
+    failures += sysid_get_bin(&_sysid, 0, &bin) || sysid_get_bin(&_sysid, SYSID_NUM_BINS, &bin);
+
+    sysid_start(&_sysid, &config, CENTRE_DEG);
+    (void)sysid_update(&_sysid, CENTRE_DEG);
+    sysid_abort(&_sysid);
+    failures += (sysid_get_state(&_sysid) != SYSID_STATE__FAILED) || (sysid_update(&_sysid, CENTRE_DEG) != 0.0f) ||
+                sysid_compute(&_sysid);
+
+    TEST_CHECK(updates == ((SETTLE_PERIODS + PERIODS) * SYSID_LEN), "run: captured after %u updates",
+               (unsigned)updates);
+    TEST_CHECK(failures == 0, "run: %u failures", (unsigned)failures);
+}
+
+/**
+ * @brief  The first-order plant: every excited bin against the exact
+ *         discrete-time response K (1 - a) / (1 - a e^(-j w T)), and the gain
+ *         and bandwidth read off.
+ * @param  signal: Excitation signal.
+ * @param  name:   Name to print.
+ * @retval None.
+ */
+static void test_first_order(SYSID_SIGNAL_t signal, const char *name)
+{
+    const double a = exp(-2.0 * M_PI * FIRST_ORDER_BW_HZ / SAMPLE_RATE_HZ);
+    double mag_error_max = 0.0;
+    double phase_error_max = 0.0;
+
+    run_first_order(&_sysid, signal);
+    FRF_RESULT_t result = analyse(&_sysid, 0.0f);
+    for (uint32_t k = 1; k < SYSID_NUM_BINS; k++)
+    {
+        SYSID_BIN_t bin;
+        if (sysid_get_bin(&_sysid, k, &bin) == false)
+        {
+            continue;
+        }
+        double w = 2.0 * M_PI * bin.freq_hz / SAMPLE_RATE_HZ;
+        double re = 1.0 - (a * cos(w));
+        double im = a * sin(w);
+        double scale = FIRST_ORDER_GAIN * (1.0 - a) / ((re * re) + (im * im));
+        double mag_db = 20.0 * log10(scale * sqrt((re * re) + (im * im)));
+        double phase_deg = atan2(-scale * im, scale * re) * 180.0 / M_PI;
+        mag_error_max = fmax(mag_error_max, fabs(bin.mag_db - mag_db));
+        phase_error_max = fmax(phase_error_max, fabs(bin.phase_deg - phase_deg));
+    }
+    float gain_db = 20.0f * log10f(FIRST_ORDER_GAIN);
+
+    printf("first order, %s: %u bins, error max %.3f dB, %.3f deg; gain %.2f dB (%.2f), bandwidth %.2f Hz (%.2f)\n",
+           name, (unsigned)result.bins, mag_error_max, phase_error_max, (double)result.gain_db, (double)gain_db,
+           (double)result.bandwidth_hz, (double)FIRST_ORDER_BW_HZ);
+    TEST_CHECK(result.bins >= (SYSID_NUM_BINS / 8), "first order, %s: %u bins excited", name, (unsigned)result.bins);
+    TEST_CHECK((mag_error_max < 0.05) && (phase_error_max < 0.5), "first order, %s: error %.3f dB, %.3f deg", name,
+               mag_error_max, phase_error_max);
+    TEST_CHECK(fabsf(result.gain_db - gain_db) < 0.1f, "first order, %s: gain %.2f dB", name,
+               (double)result.gain_db);
+    TEST_CHECK(fabsf(result.bandwidth_hz - FIRST_ORDER_BW_HZ) < (0.05f * FIRST_ORDER_BW_HZ),
+               "first order, %s: bandwidth %.2f Hz", name, (double)result.bandwidth_hz);
+}
+
+/**
+ * @brief  The servo plant model with the firmware's defaults: unity gain and
+ *         the 2nd order system's bandwidth.
+ * @param  signal: Excitation signal.
+ * @param  name:   Name to print.
+ * @retval None.
+ */
+static void test_servo(SYSID_SIGNAL_t signal, const char *name)
+{
+    const float bandwidth_hz = servo_bandwidth_hz();
+
+    run_servo(&_sysid, signal);
+    FRF_RESULT_t result = analyse(&_sysid, SERVO_FLAT_HZ);
+
+    printf("servo, %s: %u bins, gain %.2f dB (0), bandwidth %.2f Hz (%.2f)\n", name, (unsigned)result.bins,
+           (double)result.gain_db, (double)result.bandwidth_hz, (double)bandwidth_hz);
+    TEST_CHECK(fabsf(result.gain_db) < 0.5f, "servo, %s: gain %.2f dB", name, (double)result.gain_db);
+    TEST_CHECK(fabsf(result.bandwidth_hz - bandwidth_hz) < (0.15f * bandwidth_hz), "servo, %s: bandwidth %.2f Hz",
+               name, (double)result.bandwidth_hz);
+}
+
+/**
+ * @brief  Cycles per update and per compute.
+ * @retval None.
+ */
+static void bench_sysid(void)
+{
+    SYSID_CONFIG_t config;
+    uint64_t update_cycles = 0;
+    uint64_t compute_cycles = 0;
+    uint32_t updates = 0;
+    volatile float sink = 0.0f;
+
+    config_init(&config, SYSID_SIGNAL__CHIRP);
+    for (uint32_t r = 0; r < BENCH_RUNS; r++)
+    {
+        sysid_start(&_sysid, &config, CENTRE_DEG);
+        uint64_t start = test_cycles();
+        while (sysid_get_state(&_sysid) == SYSID_STATE__RUNNING)
+        {
+            sink += sysid_update(&_sysid, CENTRE_DEG + (float)(updates & 0x7U));
+            updates++;
+        }
+        update_cycles += test_cycles() - start;
+        start = test_cycles();
+        (void)sysid_compute(&_sysid);
+        compute_cycles += test_cycles() - start;
+    }
+    (void)sink;
+    printf("bench: %.1f host cycles per update, %.0f per compute\n", (double)update_cycles / updates,
+           (double)compute_cycles / BENCH_RUNS);
+}
+
+/*============================================================================*/
\ No newline at end of file